@@ -0,0 +1,109 @@
+/**
+ * \file            elemq.h
+ * \brief           Fixed-size element queue
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef ELEMQ_HDR_H
+#define ELEMQ_HDR_H
+
+#include "ringbuff/ringbuff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        ELEMQ Element queue
+ * \brief           Queue of fixed-size elements, for struct messages
+ * \{
+ *
+ * Capacity and pointers are counted in elements, there is no length bookkeeping.
+ * Element size is multiple of `4` bytes and capacity is power of `2`,
+ * every element lies contiguous at aligned slot and never straddles end of data array.
+ *
+ * Push and pop are one element copy and one pointer update.
+ * Write pointer is published after whole element was copied, consumer never sees partial element.
+ *
+ * Same as \ref RINGBUFF, it is safe for single producer and single consumer
+ * on different cores, with only \ref elemq_shared_t placed in shared memory.
+ * Data array must not be cached by any core.
+ */
+
+/**
+ * \brief           Queue pointers structure, placed in memory shared between cores.
+ *                  Pointers are free-running element counters
+ */
+typedef struct {
+    size_t w RINGBUFF_CACHE_ALIGN;              /*!< Next element to write, written by producer only */
+    size_t r RINGBUFF_CACHE_ALIGN;              /*!< Next element to read, written by consumer only */
+} elemq_shared_t;
+
+/**
+ * \brief           Queue structure, placed in core-local memory
+ */
+typedef struct {
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic1;                            /*!< Magic 1 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    uint8_t* buff;                              /*!< Pointer to element slots */
+    size_t elem_size;                           /*!< Element size in units of bytes */
+    size_t capacity;                            /*!< Number of element slots, power of `2` */
+    RINGBUFF_VOLATILE elemq_shared_t* shared;   /*!< Pointer to shared pointers or to `local` member */
+    size_t w;                                   /*!< Shadow copy of write pointer, consumer side */
+    size_t r;                                   /*!< Shadow copy of read pointer, producer side */
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic2;                            /*!< Magic 2 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    elemq_shared_t local;                       /*!< Pointers for queue not shared between cores */
+} elemq_t;
+
+uint8_t     elemq_init(RINGBUFF_VOLATILE elemq_t* q, void* buffdata, size_t elem_size, size_t capacity);
+uint8_t     elemq_init_shared(RINGBUFF_VOLATILE elemq_t* q, RINGBUFF_VOLATILE elemq_shared_t* shared, void* buffdata, size_t elem_size, size_t capacity);
+uint8_t     elemq_attach(RINGBUFF_VOLATILE elemq_t* q, RINGBUFF_VOLATILE elemq_shared_t* shared, void* buffdata, size_t elem_size, size_t capacity);
+
+/* Write functions */
+uint8_t     elemq_push(RINGBUFF_VOLATILE elemq_t* q, const void* elem);
+size_t      elemq_get_free(RINGBUFF_VOLATILE elemq_t* q);
+
+/* Read functions */
+uint8_t     elemq_pop(RINGBUFF_VOLATILE elemq_t* q, void* elem);
+const void *elemq_front(RINGBUFF_VOLATILE elemq_t* q);
+size_t      elemq_get_count(RINGBUFF_VOLATILE elemq_t* q);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ELEMQ_HDR_H */
@@ -37,6 +37,13 @@
 #include <string.h>
 #include <stdint.h>
 
+/* Optional application configuration, overrides defaults below */
+#if defined(__has_include)
+#if __has_include("ringbuff_opts.h")
+#include "ringbuff_opts.h"
+#endif /* __has_include("ringbuff_opts.h") */
+#endif /* defined(__has_include) */
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -59,6 +66,322 @@ extern "C" {
  */
 #define RINGBUFF_USE_MAGIC                      1
 
+/**
+ * \brief           Validates magic words in every function call.
+ *
+ * Set to `0` to remove magic word checks from hot path,
+ * when memory corruption is detected by periodic check with \ref ringbuff_is_ready instead.
+ * \ref ringbuff_is_ready always validates magic words
+ */
+#ifndef RINGBUFF_USE_MAGIC_CHECK
+#define RINGBUFF_USE_MAGIC_CHECK                1
+#endif /* RINGBUFF_USE_MAGIC_CHECK */
+
+/**
+ * \brief           Enables single-producer single-consumer mode,
+ *                  safe for buffers shared between 2 CPU cores.
+ *
+ * Producer writes data first and publishes write pointer after memory barrier (release),
+ * consumer reads write pointer first and accesses data after memory barrier (acquire).
+ * Same applies in opposite direction for read pointer.
+ *
+ * Each side modifies only its own pointer, producer modifies `w` and consumer modifies `r`,
+ * and pointer is always written with single store of final value.
+ *
+ * \note            `volatile` keyword alone does not guarantee ordering
+ *                  of data and pointer accesses between cores, as seen by bus matrix
+ */
+#ifndef RINGBUFF_USE_SPSC
+#define RINGBUFF_USE_SPSC                       1
+#endif
+
+/**
+ * \brief           Data memory barrier used by \ref RINGBUFF_USE_SPSC mode
+ *
+ * On Cortex-M it must translate to `DMB` instruction, equivalent to CMSIS `__DMB()`
+ */
+#ifndef RINGBUFF_MEMORY_BARRIER
+#if defined(__GNUC__)
+#define RINGBUFF_MEMORY_BARRIER()               __sync_synchronize()
+#else
+#define RINGBUFF_MEMORY_BARRIER()               __DMB()
+#endif
+#endif
+
+/**
+ * \brief           Access shared read and write pointers with `__atomic` builtins,
+ *                  load with acquire and store with release ordering
+ *
+ * Intended for host builds checked with ThreadSanitizer,
+ * which does not model stand-alone barriers of \ref RINGBUFF_USE_SPSC mode.
+ * Ordering is the same as with barriers, target builds keep it disabled
+ */
+#ifndef RINGBUFF_USE_ATOMIC_PTR
+#define RINGBUFF_USE_ATOMIC_PTR                 0
+#endif
+
+/**
+ * \brief           Load and store of pointer in \ref ringbuff_shared_t, see \ref RINGBUFF_USE_ATOMIC_PTR
+ */
+#if RINGBUFF_USE_ATOMIC_PTR
+#define RINGBUFF_PTR_LOAD(p)                    __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define RINGBUFF_PTR_STORE(p, v)                __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#else
+#define RINGBUFF_PTR_LOAD(p)                    (p)
+#define RINGBUFF_PTR_STORE(p, v)                ((p) = (v))
+#endif
+
+/**
+ * \brief           Enables power-of-2 buffer size mode
+ *
+ * Read and write pointers are free-running counters, wrapped to buffer size with mask.
+ * Number of bytes in buffer is calculated with single subtraction
+ * and full `size` bytes of buffer data array can be used.
+ *
+ * \note            When enabled, \ref ringbuff_init fails if size is not power of `2`.
+ *                  Disabled by default, enable it in `ringbuff_opts.h`
+ *                  once all buffer sizes are power of `2`
+ */
+#ifndef RINGBUFF_USE_POW2
+#define RINGBUFF_USE_POW2                       0
+#endif
+
+/**
+ * \brief           Cache line size in units of bytes, used to separate
+ *                  producer and consumer owned fields of buffer structure.
+ *
+ * Read-only geometry, producer owned write pointer and consumer owned
+ * read pointer are each placed to its own cache line,
+ * so that pointer update by one core does not touch line other core is polling.
+ *
+ * Set to `0` to disable separation and keep structure packed
+ */
+#ifndef RINGBUFF_CACHE_LINE_SIZE
+#define RINGBUFF_CACHE_LINE_SIZE                32
+#endif
+
+/**
+ * \brief           Align structure member to \ref RINGBUFF_CACHE_LINE_SIZE
+ */
+#ifndef RINGBUFF_CACHE_ALIGN
+#if RINGBUFF_CACHE_LINE_SIZE > 0
+#define RINGBUFF_CACHE_ALIGN                    __attribute__((aligned(RINGBUFF_CACHE_LINE_SIZE)))
+#else
+#define RINGBUFF_CACHE_ALIGN
+#endif
+#endif
+
+/**
+ * \brief           Memory copy function used for buffer data transfers
+ *
+ * Defaults to \ref ringbuff_memcpy, word-aligned copy kernel tuned for Cortex-M.
+ * Set to `memcpy` to use C library implementation,
+ * or to any function with `memcpy` compatible signature
+ */
+#ifndef RINGBUFF_MEMCPY
+#define RINGBUFF_MEMCPY                         ringbuff_memcpy
+#endif
+
+/**
+ * \brief           Enables 64-bit transfers in \ref ringbuff_memcpy
+ *
+ * Cortex-M7 issues `LDRD/STRD` on its 64-bit AXI bus in single cycle,
+ * Cortex-M4 with 32-bit AHB bus gains nothing over `LDM/STM` bursts
+ */
+#ifndef RINGBUFF_MEMCPY_DWORD
+#if defined(CORE_CM7)
+#define RINGBUFF_MEMCPY_DWORD                   1
+#else
+#define RINGBUFF_MEMCPY_DWORD                   0
+#endif
+#endif
+
+/**
+ * \brief           Enables unaligned word loads in \ref ringbuff_memcpy,
+ *                  when source and destination have different alignment.
+ *
+ * Cortex-M4/M7 support unaligned single `LDR` to normal memory.
+ * Set to `0` when buffer data are mapped as device or strongly-ordered memory,
+ * or when `UNALIGN_TRP` is enabled
+ */
+#ifndef RINGBUFF_MEMCPY_UNALIGNED
+#define RINGBUFF_MEMCPY_UNALIGNED               1
+#endif
+
+/**
+ * \brief           Section attribute for hot path functions (write, read, acquire, release, message functions)
+ *
+ * Defaults place them to RAM, copied from flash by startup code, so polling loop
+ * never waits on flash wait states or flash bank erase of other core:
+ * `.itcm_text` in ITCM on Cortex-M7 and `.ramfunc` in D2 SRAM on Cortex-M4.
+ * Set to empty to keep functions in flash
+ */
+#ifndef RINGBUFF_HOT
+#if defined(CORE_CM7)
+#define RINGBUFF_HOT                            __attribute__((section(".itcm_text")))
+#elif defined(CORE_CM4)
+#define RINGBUFF_HOT                            __attribute__((section(".ramfunc")))
+#else
+#define RINGBUFF_HOT
+#endif
+#endif
+
+/**
+ * \brief           Enables D-cache maintenance of buffer data array,
+ *                  for data array placed in cacheable shared memory
+ *
+ * Maintenance is enabled per handle with \ref ringbuff_set_cache_maint.
+ * Producer cleans cache lines it wrote (write, advance, commit functions),
+ * consumer invalidates cache lines before it accesses data
+ * (read, peek, read acquire and linear block read length functions).
+ * Only lines covering affected data are maintained.
+ *
+ * Invalidation is done before data are read and not at \ref ringbuff_skip,
+ * as core may speculatively fill lines again at any time after invalidation.
+ *
+ * \note            Pointers (\ref ringbuff_shared_t) must be placed in non-cacheable memory.
+ *                  Data array must be aligned to \ref RINGBUFF_CACHE_LINE_SIZE and its size multiple of it
+ */
+#ifndef RINGBUFF_USE_CACHE_MAINT
+#if defined(CORE_CM7)
+#define RINGBUFF_USE_CACHE_MAINT                1
+#else
+#define RINGBUFF_USE_CACHE_MAINT                0
+#endif
+#endif
+
+/**
+ * \brief           Cache maintenance functions for \ref RINGBUFF_USE_CACHE_MAINT,
+ *                  address and length are aligned to cache line.
+ *                  Default to CMSIS functions, header \ref RINGBUFF_CACHE_HDR must declare them
+ */
+#ifndef RINGBUFF_CACHE_CLEAN
+#define RINGBUFF_CACHE_CLEAN(addr, len)         SCB_CleanDCache_by_Addr((void *)(addr), (int32_t)(len))
+#endif
+#ifndef RINGBUFF_CACHE_INVALIDATE
+#define RINGBUFF_CACHE_INVALIDATE(addr, len)    SCB_InvalidateDCache_by_Addr((void *)(addr), (int32_t)(len))
+#endif
+#ifndef RINGBUFF_CACHE_HDR
+#define RINGBUFF_CACHE_HDR                      "stm32h7xx.h"
+#endif
+
+/**
+ * \brief           Enables runtime statistics of buffer, see \ref ringbuff_stats_t
+ *
+ * Producer counters are kept in producer owned cache line of \ref ringbuff_shared_t
+ * and consumer counters in consumer owned line, each side writes only its own line.
+ * Statistics are in shared memory, readable from both cores
+ * with \ref ringbuff_get_stats and by debugger.
+ *
+ * Counters are updated by regular and fast API functions
+ */
+#ifndef RINGBUFF_USE_STATS
+#define RINGBUFF_USE_STATS                      0
+#endif
+
+/**
+ * \brief           Time source for \ref RINGBUFF_USE_STATS, free-running 32-bit counter of producer core.
+ *                  Defaults to DWT cycle counter, which must be enabled by application.
+ *                  Header \ref RINGBUFF_STATS_HDR must declare it
+ */
+#ifndef RINGBUFF_STATS_TIME
+#define RINGBUFF_STATS_TIME()                   (DWT->CYCCNT)
+#endif
+#ifndef RINGBUFF_STATS_HDR
+#define RINGBUFF_STATS_HDR                      "stm32h7xx.h"
+#endif
+
+/**
+ * \brief           Enables token-bucket rate limit of producer, see \ref ringbuff_set_rate
+ *
+ * Producer publishes up to burst bytes at once and rate bytes per second on average.
+ * Write functions see free memory reduced to available tokens: writes are shortened,
+ * all-or-nothing writes, reservations and messages are refused until bucket is refilled.
+ * Caller defers or drops data as for full buffer, refused operations are counted
+ * as `rate_limited` instead of `short_writes` with \ref RINGBUFF_USE_STATS.
+ *
+ * Limit is applied by regular API functions, fast API functions are not limited
+ */
+#ifndef RINGBUFF_USE_RATE
+#define RINGBUFF_USE_RATE                       0
+#endif
+
+/**
+ * \brief           Time source for \ref RINGBUFF_USE_RATE, free-running 32-bit counter of producer core
+ *                  and its frequency in Hz. Defaults to DWT cycle counter, which must be enabled by application.
+ *                  Header \ref RINGBUFF_RATE_HDR must declare both
+ */
+#ifndef RINGBUFF_RATE_TIME
+#define RINGBUFF_RATE_TIME()                    (DWT->CYCCNT)
+#endif
+#ifndef RINGBUFF_RATE_TIME_HZ
+#define RINGBUFF_RATE_TIME_HZ()                 (SystemCoreClock)
+#endif
+#ifndef RINGBUFF_RATE_HDR
+#define RINGBUFF_RATE_HDR                       "stm32h7xx.h"
+#endif
+
+/**
+ * \brief           Enables sequence number in header of every message, see \ref ringbuff_msg_hdr_t
+ *
+ * Producer numbers published messages, consumer counts gaps of sequence
+ * in consumer owned line of \ref ringbuff_shared_t. Messages lost by overwrite, reset or
+ * discarded data are reported with \ref ringbuff_msg_get_gaps without scanning payloads.
+ * Both sequence counters are kept in shared pointers and survive re-attach of either side
+ */
+#ifndef RINGBUFF_USE_MSG_SEQ
+#define RINGBUFF_USE_MSG_SEQ                    0
+#endif
+
+/**
+ * \brief           Enables CRC of payload in header of every message, see \ref ringbuff_msg_hdr_t
+ *
+ * Producer computes CRC when message is published, consumer verifies it
+ * when it receives or acquires message, in the same pass as data are read.
+ * Corrupted message is released and dropped, consumer gets next message instead.
+ * Corrupted messages are counted in consumer owned line of \ref ringbuff_shared_t,
+ * see \ref ringbuff_msg_get_crc_errors
+ */
+#ifndef RINGBUFF_USE_MSG_CRC
+#define RINGBUFF_USE_MSG_CRC                    0
+#endif
+
+/**
+ * \brief           CRC function for \ref RINGBUFF_USE_MSG_CRC, called with 2 payload fragments,
+ *                  second one may be `NULL` with `0` length. Returns 32-bit CRC of both fragments.
+ *                  Header \ref RINGBUFF_MSG_CRC_HDR must declare it
+ */
+#ifndef RINGBUFF_MSG_CRC
+#define RINGBUFF_MSG_CRC(d1, l1, d2, l2)        ringbuff_crc((d1), (l1), (d2), (l2))
+#endif
+#ifndef RINGBUFF_MSG_CRC_HDR
+#define RINGBUFF_MSG_CRC_HDR                    "ringbuff_crc.h"
+#endif
+
+/**
+ * \brief           Enables trace hook \ref RINGBUFF_TRACE of buffer operations
+ *
+ * Hook is called after every write, read and reset event, from regular and fast API functions,
+ * independent of event callback set with \ref ringbuff_set_evt_fn.
+ * Buffer is identified by trace ID, see \ref ringbuff_set_trace_id
+ */
+#ifndef RINGBUFF_USE_TRACE
+#define RINGBUFF_USE_TRACE                      0
+#endif
+
+/**
+ * \brief           Trace hook for \ref RINGBUFF_USE_TRACE, called with buffer handle,
+ *                  \ref ringbuff_evt_type_t event and number of bytes.
+ *                  Hook runs in caller context on hot path and must not block.
+ *                  Header \ref RINGBUFF_TRACE_HDR must declare it
+ */
+#ifndef RINGBUFF_TRACE
+#define RINGBUFF_TRACE(buff, evt, len)          ringbuff_trace((buff), (evt), (len))
+#endif
+#ifndef RINGBUFF_TRACE_HDR
+#define RINGBUFF_TRACE_HDR                      "ringbuff_trace.h"
+#endif
+
 /**
  * \brief           Event type for buffer operations
  */
@@ -81,8 +404,63 @@ struct ringbuff;
  */
 typedef void (*ringbuff_evt_fn)(RINGBUFF_VOLATILE struct ringbuff* buff, ringbuff_evt_type_t evt, size_t bp);
 
+/**
+ * \brief           Buffer pointers structure, the only part of buffer
+ *                  which has to be placed in memory shared between cores
+ *
+ * Each pointer starts at new cache line:
+ *  - Write pointer, written by producer only
+ *  - Read pointer, written by consumer only
+ *
+ * Structure holds only indexes and counters, no addresses or function pointers,
+ * as code and data addresses of one core are not valid on the other core
+ */
+typedef struct {
+    /* Producer owned cache line */
+    size_t w RINGBUFF_CACHE_ALIGN;              /*!< Next write pointer. Buffer is considered empty when `r == w` and full when `w == r - 1`.
+                                                    With \ref RINGBUFF_USE_POW2, it is free-running counter and buffer is full when `w - r == size` */
+#if RINGBUFF_USE_STATS
+    uint32_t bytes_in;                          /*!< Number of bytes written */
+    uint32_t writes;                            /*!< Number of write operations that published data, messages with message functions */
+    uint32_t short_writes;                      /*!< Number of write operations shortened or refused for lack of free memory */
+    uint32_t max_full;                          /*!< Maximum number of bytes in buffer, seen by producer after write */
+    uint32_t full_time;                         /*!< Time buffer was full, from first short write until next complete write,
+                                                    in units of \ref RINGBUFF_STATS_TIME */
+#if RINGBUFF_USE_RATE
+    uint32_t rate_limited;                      /*!< Number of write operations shortened or refused for lack of tokens */
+#endif /* RINGBUFF_USE_RATE */
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_MSG_SEQ
+    uint32_t msg_seq;                           /*!< Sequence number of next published message */
+#endif /* RINGBUFF_USE_MSG_SEQ */
+
+    /* Consumer owned cache line */
+    size_t r RINGBUFF_CACHE_ALIGN;              /*!< Next read pointer. Buffer is considered empty when `r == w` and full when `w == r - 1`.
+                                                    With \ref RINGBUFF_USE_POW2, it is free-running counter and buffer is full when `w - r == size` */
+#if RINGBUFF_USE_STATS
+    uint32_t bytes_out;                         /*!< Number of bytes read or skipped */
+    uint32_t reads;                             /*!< Number of read operations that released data, messages with message functions */
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_MSG_SEQ
+    uint32_t msg_seq_next;                      /*!< Sequence number expected in next released message */
+    uint32_t msg_gaps;                          /*!< Number of sequence gaps seen by consumer */
+    uint32_t msg_lost;                          /*!< Number of messages missing in gaps */
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+    uint32_t msg_crc_errors;                    /*!< Number of messages dropped on CRC mismatch */
+#endif /* RINGBUFF_USE_MSG_CRC */
+} ringbuff_shared_t;
+
 /**
  * \brief           Buffer structure
+ *
+ * Buffer handle is meant to be placed in core-local memory (DTCM or core SRAM).
+ * It holds immutable buffer geometry, callbacks and local copy of pointers,
+ * while only \ref ringbuff_shared_t is accessed in shared memory.
+ *
+ * When buffer is shared between cores, each core has its own handle,
+ * attached to the same shared pointers and data array.
+ * Handle may only be used by single producer and/or single consumer.
  */
 typedef struct ringbuff {
 #if RINGBUFF_USE_MAGIC
@@ -90,25 +468,148 @@ typedef struct ringbuff {
 #endif /* RINGBUFF_USE_MAGIC */
     uint8_t* buff;                              /*!< Pointer to buffer data.
                                                     Buffer is considered initialized when `buff != NULL` and `size > 0` */
-    size_t size;                                /*!< Size of buffer data. Size of actual buffer is `1` byte less than value holds */
-    size_t r;                                   /*!< Next read pointer. Buffer is considered empty when `r == w` and full when `w == r - 1` */
-    size_t w;                                   /*!< Next write pointer. Buffer is considered empty when `r == w` and full when `w == r - 1` */
+    size_t size;                                /*!< Size of buffer data. Size of actual buffer is `1` byte less than value holds,
+                                                    unless \ref RINGBUFF_USE_POW2 is enabled */
     ringbuff_evt_fn evt_fn;                     /*!< Pointer to event callback function */
+#if RINGBUFF_USE_CACHE_MAINT
+    uint8_t cache_maint;                        /*!< Set to `1` when data array is cacheable, see \ref ringbuff_set_cache_maint */
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+    void* arg;                                  /*!< User argument, see \ref ringbuff_set_arg */
+    RINGBUFF_VOLATILE ringbuff_shared_t* shared;/*!< Pointer to read and write pointers,
+                                                    either in shared memory or to `local` member */
+    size_t w;                                   /*!< Local copy of write pointer. Exact value for producer,
+                                                    shadow copy for consumer, re-read from shared memory only when
+                                                    it does not indicate enough data */
+    size_t r;                                   /*!< Local copy of read pointer. Exact value for consumer,
+                                                    shadow copy for producer, re-read from shared memory only when
+                                                    it does not indicate enough free memory */
+#if RINGBUFF_USE_STATS
+    uint32_t full_start;                        /*!< Time of first short write, when `full` is set */
+    uint8_t full;                               /*!< Set to `1` after short write, until next complete write */
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+    uint8_t trace_id;                           /*!< Buffer ID in trace events, see \ref ringbuff_set_trace_id */
+#endif /* RINGBUFF_USE_TRACE */
+#if RINGBUFF_USE_RATE
+    uint32_t rate_tpb;                          /*!< Time ticks per byte of rate limit, `0` when not limited */
+    uint32_t rate_burst;                        /*!< Bucket depth in units of bytes */
+    uint32_t rate_tokens;                       /*!< Bytes producer may publish now */
+    uint32_t rate_time;                         /*!< Time bucket was refilled up to */
+    uint8_t rate_short;                         /*!< Set to `1` when last free memory check was cut by tokens */
+#endif /* RINGBUFF_USE_RATE */
+#if RINGBUFF_USE_MSG_CRC
+    uint32_t msg_crc_bad;                       /*!< Bit `i` is set when message `i` from read pointer failed CRC
+                                                    in \ref ringbuff_msg_recv_batch, error is counted on release */
+#endif /* RINGBUFF_USE_MSG_CRC */
 #if RINGBUFF_USE_MAGIC
     uint32_t magic2;                            /*!< Magic 2 word */
 #endif /* RINGBUFF_USE_MAGIC */
+    ringbuff_shared_t local;                    /*!< Pointers for buffer not shared between cores, see \ref ringbuff_init */
 } ringbuff_t;
 
+/**
+ * \brief           Result of \ref ringbuff_write_all when buffer has not enough free memory,
+ *                  nothing was written and caller may retry once consumer freed memory
+ */
+#define RINGBUFF_WOULD_BLOCK                    ((size_t)-1)
+
+/**
+ * \brief           Data fragment descriptor for \ref ringbuff_writev
+ */
+typedef struct {
+    const void* data;                           /*!< Pointer to fragment data */
+    size_t len;                                 /*!< Fragment length in units of bytes */
+} ringbuff_iovec_t;
+
+/**
+ * \brief           Snapshot of buffer statistics, see \ref RINGBUFF_USE_STATS.
+ *                  Counters are 32-bit and wrap around
+ */
+typedef struct {
+    uint32_t bytes_in;                          /*!< Number of bytes written */
+    uint32_t bytes_out;                         /*!< Number of bytes read */
+    uint32_t writes;                            /*!< Number of write operations */
+    uint32_t reads;                             /*!< Number of read operations */
+    uint32_t short_writes;                      /*!< Number of write operations shortened or refused for lack of free memory */
+    uint32_t max_full;                          /*!< High-water mark, maximum number of bytes in buffer */
+    uint32_t full_time;                         /*!< Time buffer was full, in units of \ref RINGBUFF_STATS_TIME */
+#if RINGBUFF_USE_RATE
+    uint32_t rate_limited;                      /*!< Number of write operations shortened or refused by rate limit, see \ref RINGBUFF_USE_RATE */
+#endif /* RINGBUFF_USE_RATE */
+#if RINGBUFF_USE_MSG_SEQ
+    uint32_t msg_gaps;                          /*!< Number of message sequence gaps, see \ref RINGBUFF_USE_MSG_SEQ */
+    uint32_t msg_lost;                          /*!< Number of messages missing in sequence gaps */
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+    uint32_t msg_crc_errors;                    /*!< Number of messages dropped on CRC mismatch, see \ref RINGBUFF_USE_MSG_CRC */
+#endif /* RINGBUFF_USE_MSG_CRC */
+} ringbuff_stats_t;
+
+/**
+ * \brief           Message header, written in front of every message
+ *                  by message functions (`ringbuff_msg_*`)
+ */
+typedef struct {
+    uint32_t len;                               /*!< Message payload length in units of bytes */
+#if RINGBUFF_USE_MSG_SEQ
+    uint32_t seq;                               /*!< Sequence number of message, per buffer */
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+    uint32_t crc;                               /*!< CRC of message payload, \ref RINGBUFF_MSG_CRC */
+#endif /* RINGBUFF_USE_MSG_CRC */
+} ringbuff_msg_hdr_t;
+
+/**
+ * \brief           Message payload in buffer, returned by \ref ringbuff_msg_recv_batch.
+ *                  Payload is split in 2 blocks when it wraps at end of buffer
+ */
+typedef struct {
+    void* ptr1;                                 /*!< First block of payload, `NULL` for dropped message */
+    size_t len1;                                /*!< First block length in units of bytes */
+    void* ptr2;                                 /*!< Second block of payload at start of buffer, `NULL` when not used */
+    size_t len2;                                /*!< Second block length in units of bytes, `0` when not used */
+} ringbuff_msg_span_t;
+
 uint8_t     ringbuff_init(RINGBUFF_VOLATILE ringbuff_t* buff, void* buffdata, size_t size);
+uint8_t     ringbuff_init_shared(RINGBUFF_VOLATILE ringbuff_t* buff, RINGBUFF_VOLATILE ringbuff_shared_t* shared, void* buffdata, size_t size);
+uint8_t     ringbuff_attach(RINGBUFF_VOLATILE ringbuff_t* buff, RINGBUFF_VOLATILE ringbuff_shared_t* shared, void* buffdata, size_t size);
 uint8_t     ringbuff_is_ready(RINGBUFF_VOLATILE ringbuff_t* buff);
 void        ringbuff_free(RINGBUFF_VOLATILE ringbuff_t* buff);
 void        ringbuff_reset(RINGBUFF_VOLATILE ringbuff_t* buff);
 void        ringbuff_set_evt_fn(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_evt_fn fn);
+void        ringbuff_set_arg(RINGBUFF_VOLATILE ringbuff_t* buff, void* arg);
+void *      ringbuff_get_arg(RINGBUFF_VOLATILE ringbuff_t* buff);
+#if RINGBUFF_USE_CACHE_MAINT
+uint8_t     ringbuff_set_cache_maint(RINGBUFF_VOLATILE ringbuff_t* buff, uint8_t en);
+void        ringbuff_cache_clean(RINGBUFF_VOLATILE ringbuff_t* buff, size_t ptr, size_t len);
+void        ringbuff_cache_invalidate(RINGBUFF_VOLATILE ringbuff_t* buff, size_t ptr, size_t len);
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+#if RINGBUFF_USE_STATS
+void        ringbuff_get_stats(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_stats_t* stats);
+void        ringbuff_stats_write(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
+void        ringbuff_stats_short(RINGBUFF_VOLATILE ringbuff_t* buff);
+void        ringbuff_stats_read(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
+void        ringbuff_stats_read_n(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len, size_t count);
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+void        ringbuff_set_trace_id(RINGBUFF_VOLATILE ringbuff_t* buff, uint8_t id);
+#endif /* RINGBUFF_USE_TRACE */
+#if RINGBUFF_USE_RATE
+uint8_t     ringbuff_set_rate(RINGBUFF_VOLATILE ringbuff_t* buff, uint32_t rate, uint32_t burst);
+uint32_t    ringbuff_get_tokens(RINGBUFF_VOLATILE ringbuff_t* buff);
+#endif /* RINGBUFF_USE_RATE */
+
+/* Copy kernel */
+void *      ringbuff_memcpy(void* dst, const void* src, size_t len);
 
 /* Read/Write functions */
 size_t      ringbuff_write(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw);
+size_t      ringbuff_write_all(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw);
+size_t      ringbuff_writev(RINGBUFF_VOLATILE ringbuff_t* buff, const ringbuff_iovec_t* iov, size_t iovcnt);
 size_t      ringbuff_read(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t btr);
 size_t      ringbuff_peek(RINGBUFF_VOLATILE ringbuff_t* buff, size_t skip_count, void* data, size_t btp);
+size_t      ringbuff_splice(RINGBUFF_VOLATILE ringbuff_t* dst, RINGBUFF_VOLATILE ringbuff_t* src, size_t len);
+uint8_t     ringbuff_find(RINGBUFF_VOLATILE ringbuff_t* buff, const void* bts, size_t len, size_t start_offset, size_t* found_idx);
 
 /* Buffer size information */
 size_t      ringbuff_get_free(RINGBUFF_VOLATILE ringbuff_t* buff);
@@ -118,12 +619,35 @@ size_t      ringbuff_get_full(RINGBUFF_VOLATILE ringbuff_t* buff);
 void *      ringbuff_get_linear_block_read_address(RINGBUFF_VOLATILE ringbuff_t* buff);
 size_t      ringbuff_get_linear_block_read_length(RINGBUFF_VOLATILE ringbuff_t* buff);
 size_t      ringbuff_skip(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
+size_t      ringbuff_read_acquire(RINGBUFF_VOLATILE ringbuff_t* buff, void** ptr1, size_t* len1, void** ptr2, size_t* len2);
+size_t      ringbuff_read_release(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
 
 /* Write data block management */
 void *      ringbuff_get_linear_block_write_address(RINGBUFF_VOLATILE ringbuff_t* buff);
 size_t      ringbuff_get_linear_block_write_length(RINGBUFF_VOLATILE ringbuff_t* buff);
 size_t      ringbuff_advance(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
 
+/* Zero-copy write management */
+void *      ringbuff_write_reserve(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
+size_t      ringbuff_write_commit(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
+
+/* Message functions */
+size_t      ringbuff_msg_send(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t len);
+size_t      ringbuff_msg_recv(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t size);
+size_t      ringbuff_msg_peek_len(RINGBUFF_VOLATILE ringbuff_t* buff);
+void *      ringbuff_msg_send_reserve(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
+size_t      ringbuff_msg_send_commit(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len);
+size_t      ringbuff_msg_recv_acquire(RINGBUFF_VOLATILE ringbuff_t* buff, void** ptr1, size_t* len1, void** ptr2, size_t* len2);
+size_t      ringbuff_msg_recv_release(RINGBUFF_VOLATILE ringbuff_t* buff);
+size_t      ringbuff_msg_recv_batch(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_msg_span_t* spans, size_t max);
+size_t      ringbuff_msg_recv_batch_release(RINGBUFF_VOLATILE ringbuff_t* buff, size_t count);
+#if RINGBUFF_USE_MSG_SEQ
+uint32_t    ringbuff_msg_get_gaps(RINGBUFF_VOLATILE ringbuff_t* buff, uint32_t* lost);
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+uint32_t    ringbuff_msg_get_crc_errors(RINGBUFF_VOLATILE ringbuff_t* buff);
+#endif /* RINGBUFF_USE_MSG_CRC */
+
 /**
  * \}
  */
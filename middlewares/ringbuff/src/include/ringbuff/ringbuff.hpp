@@ -0,0 +1,271 @@
+/**
+ * \file            ringbuff.hpp
+ * \brief           Typed ring buffer template for C++
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_HPP_HDR_H
+#define RINGBUFF_HPP_HDR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "ringbuff/ringbuff.h"
+
+#if !RINGBUFF_USE_POW2
+#error "ringbuff.hpp requires RINGBUFF_USE_POW2"
+#endif /* !RINGBUFF_USE_POW2 */
+
+#if RINGBUFF_USE_CACHE_MAINT
+#include RINGBUFF_CACHE_HDR
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+/**
+ * \defgroup        RINGBUFF_CPP Typed ring buffer template
+ * \brief           Header-only C++ ring buffer of elements, with compile-time capacity
+ * \{
+ *
+ * Template uses the same \ref ringbuff_shared_t pointers and data array layout as \ref RINGBUFF,
+ * pointers are free-running byte counters. Each element is stored in slot of
+ * \ref ringbuff_cpp::ringbuff::stride bytes, `sizeof(T)` rounded up to power of `2`,
+ * with padding after element. C handle attached to the same pointers
+ * with data size \ref ringbuff_cpp::ringbuff::data_size interoperates with template, for example C producer
+ * writes whole slots with \ref ringbuff_write and C++ consumer pops them with \ref ringbuff_cpp::ringbuff::pop.
+ *
+ * Slot size and capacity are powers of `2`, masks are compile-time constants,
+ * elements never straddle end of data array and every element is copied with single assignment.
+ * C side must write and read whole slots only.
+ *
+ * Same as \ref RINGBUFF, it is safe for single producer and single consumer on different cores.
+ * Statistics (\ref RINGBUFF_USE_STATS), events and trace are not updated by template.
+ * Pointers must be in non-cacheable memory, cacheable data array is maintained when enabled with constructor
+ */
+
+namespace ringbuff_cpp {
+
+/**
+ * \brief           Round value up to power of `2`
+ * \param[in]       v: Value to round, greater than `0`
+ * \param[in]       p: Power of `2` to start with
+ * \return          Smallest power of `2` not less than `v`
+ */
+constexpr size_t
+pow2_ceil(size_t v, size_t p = 1) {
+    return p >= v ? p : pow2_ceil(v, p * 2);
+}
+
+/**
+ * \brief           Ring buffer of `N` elements of type `T`
+ * \tparam          T: Trivially copyable element type
+ * \tparam          N: Capacity in units of elements, power of `2`
+ */
+template <typename T, size_t N>
+class ringbuff {
+  public:
+    static_assert(std::is_trivially_copyable<T>::value, "Element type must be trivially copyable");
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Capacity must be power of 2");
+
+    static constexpr size_t capacity = N;                   /*!< Capacity in units of elements */
+    static constexpr size_t stride = pow2_ceil(sizeof(T));  /*!< Slot size in units of bytes */
+    static constexpr size_t data_size = N * stride;         /*!< Data array size in units of bytes */
+
+    /**
+     * \brief           Storage of one element, padded to \ref stride bytes
+     */
+    struct slot_type {
+        alignas(T) unsigned char bytes[stride];             /*!< Element, followed by padding */
+    };
+
+    /**
+     * \brief           Attach to pointers and data array
+     * \param[in]       shared: Pointers structure, in shared memory
+     * \param[in]       data: Data array of \ref capacity slots
+     * \param[in]       reset: Set to `true` to reset pointers to empty buffer,
+     *                      by core that owns shared memory, before other core attaches
+     * \param[in]       cache_maint: Set to `true` when data array is cacheable for this core,
+     *                      see \ref RINGBUFF_USE_CACHE_MAINT
+     */
+    ringbuff(RINGBUFF_VOLATILE ringbuff_shared_t* shared, slot_type* data, bool reset = false, bool cache_maint = false)
+        : shared_(shared), data_(data), cache_maint_(cache_maint) {
+        if (reset) {
+            RINGBUFF_PTR_STORE(shared_->w, 0);
+            RINGBUFF_PTR_STORE(shared_->r, 0);
+        }
+        w_ = RINGBUFF_PTR_LOAD(shared_->w);
+        r_ = RINGBUFF_PTR_LOAD(shared_->r);
+    }
+
+    /**
+     * \brief           Write element, producer side
+     * \param[in]       e: Element to write
+     * \return          `true` on success, `false` if buffer is full
+     */
+    bool push(const T& e) {
+        size_t w = RINGBUFF_PTR_LOAD(shared_->w);
+
+        if (w - r_ >= data_size) {
+            r_ = RINGBUFF_PTR_LOAD(shared_->r);  /* Shadow copy is stale, re-read */
+            if (w - r_ >= data_size) {
+                return false;
+            }
+            RINGBUFF_MEMORY_BARRIER();          /* Read pointer before data */
+        }
+        T* slot = prv_slot(w);
+        *slot = e;
+        prv_clean(slot);
+        RINGBUFF_MEMORY_BARRIER();              /* Data before write pointer */
+        RINGBUFF_PTR_STORE(shared_->w, w + stride);
+        return true;
+    }
+
+    /**
+     * \brief           Get oldest element in place, consumer side.
+     *                  Element stays valid until \ref pop
+     * \return          Pointer to element, `nullptr` if buffer is empty
+     */
+    const T* front() {
+        size_t r = RINGBUFF_PTR_LOAD(shared_->r);
+
+        if (w_ == r) {
+            w_ = RINGBUFF_PTR_LOAD(shared_->w);
+            if (w_ == r) {
+                return nullptr;
+            }
+        }
+        RINGBUFF_MEMORY_BARRIER();              /* Write pointer before data */
+        const T* slot = prv_slot(r);
+        prv_invalidate(slot);
+        return slot;
+    }
+
+    /**
+     * \brief           Release oldest element, consumer side
+     * \return          `true` on success, `false` if buffer is empty
+     */
+    bool pop() {
+        size_t r = RINGBUFF_PTR_LOAD(shared_->r);
+
+        if (w_ == r && (w_ = RINGBUFF_PTR_LOAD(shared_->w)) == r) {
+            return false;
+        }
+        RINGBUFF_MEMORY_BARRIER();              /* Data before read pointer */
+        RINGBUFF_PTR_STORE(shared_->r, r + stride);
+        return true;
+    }
+
+    /**
+     * \brief           Read and release oldest element, consumer side
+     * \param[out]      e: Element to copy to
+     * \return          `true` on success, `false` if buffer is empty
+     */
+    bool pop(T& e) {
+        const T* slot = front();
+
+        if (slot == nullptr) {
+            return false;
+        }
+        e = *slot;
+        RINGBUFF_MEMORY_BARRIER();              /* Data before read pointer */
+        RINGBUFF_PTR_STORE(shared_->r, RINGBUFF_PTR_LOAD(shared_->r) + stride);
+        return true;
+    }
+
+    /**
+     * \brief           Get number of elements in buffer, snapshot of both pointers
+     * \return          Number of elements
+     */
+    size_t size() const {
+        return (RINGBUFF_PTR_LOAD(shared_->w) - RINGBUFF_PTR_LOAD(shared_->r)) / stride;
+    }
+
+    /**
+     * \brief           Check if buffer is empty, snapshot of both pointers
+     * \return          `true` if empty, `false` otherwise
+     */
+    bool empty() const {
+        return RINGBUFF_PTR_LOAD(shared_->w) == RINGBUFF_PTR_LOAD(shared_->r);
+    }
+
+  private:
+    static constexpr size_t mask = data_size - 1;
+
+    /**
+     * \brief           Get element in slot at pointer
+     * \param[in]       p: Free-running pointer, multiple of \ref stride
+     * \return          Element
+     */
+    T* prv_slot(size_t p) const {
+        return reinterpret_cast<T*>(data_[(p & mask) / stride].bytes);
+    }
+
+    /**
+     * \brief           Clean cache lines of written element
+     * \param[in]       slot: Element
+     */
+    void prv_clean(const T* slot) const {
+#if RINGBUFF_USE_CACHE_MAINT
+        if (cache_maint_) {
+            uintptr_t a = reinterpret_cast<uintptr_t>(slot) & ~(uintptr_t)(RINGBUFF_CACHE_LINE_SIZE - 1);
+            RINGBUFF_CACHE_CLEAN(a, reinterpret_cast<uintptr_t>(slot) + sizeof(T) - a);
+        }
+#else
+        (void)slot;
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+    }
+
+    /**
+     * \brief           Invalidate cache lines of element before it is read
+     * \param[in]       slot: Element
+     */
+    void prv_invalidate(const T* slot) const {
+#if RINGBUFF_USE_CACHE_MAINT
+        if (cache_maint_) {
+            uintptr_t a = reinterpret_cast<uintptr_t>(slot) & ~(uintptr_t)(RINGBUFF_CACHE_LINE_SIZE - 1);
+            RINGBUFF_CACHE_INVALIDATE(a, reinterpret_cast<uintptr_t>(slot) + sizeof(T) - a);
+        }
+#else
+        (void)slot;
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+    }
+
+    RINGBUFF_VOLATILE ringbuff_shared_t* shared_;           /*!< Pointers, shared with other core */
+    slot_type* data_;                                       /*!< Data array */
+    size_t w_;                                              /*!< Shadow copy of write pointer, consumer side */
+    size_t r_;                                              /*!< Shadow copy of read pointer, producer side */
+    bool cache_maint_;                                      /*!< Data array is cacheable for this core */
+};
+
+} /* namespace ringbuff_cpp */
+
+/**
+ * \}
+ */
+
+#endif /* RINGBUFF_HPP_HDR_H */
@@ -0,0 +1,106 @@
+/**
+ * \file            ringbuff_bip.h
+ * \brief           Bipartite ring buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_BIP_HDR_H
+#define RINGBUFF_BIP_HDR_H
+
+#include "ringbuff/ringbuff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        RINGBUFF_BIP Bipartite ring buffer
+ * \brief           Ring buffer with contiguous blocks only
+ * \{
+ *
+ * Writer wraps to the beginning of buffer early, when requested block
+ * does not fit until end of buffer. Every committed block is therefore
+ * contiguous in memory and can be handed over to DMA with single transfer.
+ *
+ * Same as \ref RINGBUFF, it is safe for single producer and single consumer
+ * on different cores, with only \ref ringbuff_bip_shared_t placed in shared memory.
+ */
+
+/**
+ * \brief           Bipartite buffer pointers structure, placed in memory shared between cores
+ */
+typedef struct {
+    /* Producer owned cache line */
+    size_t w RINGBUFF_CACHE_ALIGN;              /*!< Next write pointer */
+    size_t wm;                                  /*!< Watermark, end of valid data before writer wrapped to beginning */
+
+    /* Consumer owned cache line */
+    size_t r RINGBUFF_CACHE_ALIGN;              /*!< Next read pointer */
+} ringbuff_bip_shared_t;
+
+/**
+ * \brief           Bipartite buffer structure, placed in core-local memory
+ */
+typedef struct {
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic1;                            /*!< Magic 1 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    uint8_t* buff;                              /*!< Pointer to buffer data */
+    size_t size;                                /*!< Size of buffer data in units of bytes */
+    RINGBUFF_VOLATILE ringbuff_bip_shared_t* shared;/*!< Pointer to shared pointers or to `local` member */
+    size_t res_off;                             /*!< Offset of active write reservation */
+    size_t res_len;                             /*!< Length of active write reservation, `0` when none */
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic2;                            /*!< Magic 2 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    ringbuff_bip_shared_t local;                /*!< Pointers for buffer not shared between cores */
+} ringbuff_bip_t;
+
+uint8_t     ringbuff_bip_init(RINGBUFF_VOLATILE ringbuff_bip_t* buff, void* buffdata, size_t size);
+uint8_t     ringbuff_bip_init_shared(RINGBUFF_VOLATILE ringbuff_bip_t* buff, RINGBUFF_VOLATILE ringbuff_bip_shared_t* shared, void* buffdata, size_t size);
+uint8_t     ringbuff_bip_attach(RINGBUFF_VOLATILE ringbuff_bip_t* buff, RINGBUFF_VOLATILE ringbuff_bip_shared_t* shared, void* buffdata, size_t size);
+
+/* Write functions */
+void *      ringbuff_bip_write_reserve(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t len);
+size_t      ringbuff_bip_write_commit(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t len);
+
+/* Read functions */
+void *      ringbuff_bip_read_acquire(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t* len);
+size_t      ringbuff_bip_read_release(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t len);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RINGBUFF_BIP_HDR_H */
@@ -0,0 +1,108 @@
+/**
+ * \file            ringbuff_cpt.h
+ * \brief           Compact ring buffer descriptor
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_CPT_HDR_H
+#define RINGBUFF_CPT_HDR_H
+
+#include "ringbuff/ringbuff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        RINGBUFF_CPT Compact descriptor
+ * \brief           Ring buffer with `8` bytes descriptor, for many small channels
+ * \{
+ *
+ * Descriptor is placed in memory shared between cores and used directly by both of them,
+ * there is no core-local handle. It holds 16-bit free-running indices and offset of data array
+ * from common base address instead of pointer, so data arrays must be within `64 kB` from base,
+ * for example all in SRAM4. Size is power of `2`, `32 kB` at most.
+ *
+ * Producer writes only `w` and consumer writes only `r`, halfword stores are single-copy atomic.
+ * Both indices are in the same word, producer and consumer check peer index with single load.
+ * There are no magic words, event callback, statistics or trace.
+ *
+ * Same as \ref RINGBUFF, it is safe for single producer and single consumer on different cores.
+ * Descriptor and data array must not be cached by any core.
+ */
+
+/**
+ * \brief           Compact buffer descriptor, placed in memory shared between cores
+ */
+typedef struct {
+    uint16_t w;                                 /*!< Next write index, free-running. Written by producer */
+    uint16_t r;                                 /*!< Next read index, free-running. Written by consumer */
+    uint16_t off;                               /*!< Offset of data array from base address */
+    uint16_t mask;                              /*!< Size of data array minus `1` */
+} ringbuff_cpt_t;
+
+uint8_t     ringbuff_cpt_init(volatile ringbuff_cpt_t* buff, const void* base, void* buffdata, size_t size);
+
+/* Read/Write functions */
+size_t      ringbuff_cpt_write(volatile ringbuff_cpt_t* buff, void* base, const void* data, size_t btw);
+size_t      ringbuff_cpt_read(volatile ringbuff_cpt_t* buff, const void* base, void* data, size_t btr);
+size_t      ringbuff_cpt_skip(volatile ringbuff_cpt_t* buff, size_t len);
+
+/**
+ * \brief           Get number of bytes in buffer, both indices are loaded with single word access
+ * \param[in]       buff: Buffer descriptor
+ * \return          Number of bytes ready to be read
+ */
+static inline size_t
+ringbuff_cpt_get_full(volatile ringbuff_cpt_t* buff) {
+    uint32_t wr = *(volatile uint32_t *)buff;   /* Little-endian, `w` in lower half */
+
+    return (uint16_t)((uint16_t)wr - (uint16_t)(wr >> 16));
+}
+
+/**
+ * \brief           Get number of bytes buffer can accept
+ * \param[in]       buff: Buffer descriptor
+ * \return          Number of free bytes
+ */
+static inline size_t
+ringbuff_cpt_get_free(volatile ringbuff_cpt_t* buff) {
+    return (size_t)buff->mask + 1 - ringbuff_cpt_get_full(buff);
+}
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RINGBUFF_CPT_HDR_H */
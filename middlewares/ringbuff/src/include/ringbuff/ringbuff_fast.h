@@ -0,0 +1,327 @@
+/**
+ * \file            ringbuff_fast.h
+ * \brief           Unchecked inline ring buffer functions
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_FAST_HDR_H
+#define RINGBUFF_FAST_HDR_H
+
+#include "ringbuff/ringbuff.h"
+#if RINGBUFF_USE_TRACE
+#include RINGBUFF_TRACE_HDR
+#endif /* RINGBUFF_USE_TRACE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        RINGBUFF_FAST Fast path
+ * \brief           Inline functions without parameter validation
+ * \{
+ *
+ * Functions are meant for hot polling loops, on handle that was
+ * successfully initialized or attached and checked once with \ref ringbuff_is_ready.
+ * Magic words and buffer geometry are not verified, pointers must not be `NULL`.
+ *
+ * Producer and consumer roles are explicit: write functions use write pointer
+ * from local handle and consumer functions use read pointer from local handle,
+ * peer pointer is loaded from shared memory only when needed.
+ * They can be mixed with regular API on the same handle.
+ *
+ * \note            Event callback set with \ref ringbuff_set_evt_fn is not called,
+ *                  statistics (\ref RINGBUFF_USE_STATS) are updated and trace hook (\ref RINGBUFF_USE_TRACE) is called
+ */
+
+/**
+ * \brief           Get buffer offset for pointer
+ * \param[in]       buff: Buffer handle
+ * \param[in]       i: Pointer value
+ * \return          Offset in buffer data array
+ */
+static inline size_t
+ringbuff_fast_idx(RINGBUFF_VOLATILE ringbuff_t* buff, size_t i) {
+#if RINGBUFF_USE_POW2
+    return i & (buff->size - 1);
+#else
+    (void)buff;
+    return i;
+#endif /* RINGBUFF_USE_POW2 */
+}
+
+/**
+ * \brief           Advance pointer
+ * \param[in]       buff: Buffer handle
+ * \param[in]       i: Pointer value
+ * \param[in]       n: Number of bytes to advance, not greater than buffer size
+ * \return          New pointer value
+ */
+static inline size_t
+ringbuff_fast_add(RINGBUFF_VOLATILE ringbuff_t* buff, size_t i, size_t n) {
+#if RINGBUFF_USE_POW2
+    (void)buff;
+    return i + n;
+#else
+    return i + n >= buff->size ? i + n - buff->size : i + n;
+#endif /* RINGBUFF_USE_POW2 */
+}
+
+/**
+ * \brief           Get number of bytes between read and write pointers
+ * \param[in]       buff: Buffer handle
+ * \param[in]       w: Write pointer
+ * \param[in]       r: Read pointer
+ * \return          Number of bytes in buffer
+ */
+static inline size_t
+ringbuff_fast_count(RINGBUFF_VOLATILE ringbuff_t* buff, size_t w, size_t r) {
+#if RINGBUFF_USE_POW2
+    (void)buff;
+    return w - r;
+#else
+    return w >= r ? w - r : buff->size - (r - w);
+#endif /* RINGBUFF_USE_POW2 */
+}
+
+/**
+ * \brief           Get maximum number of bytes buffer can hold
+ * \param[in]       buff: Buffer handle
+ * \return          Buffer capacity
+ */
+static inline size_t
+ringbuff_fast_capacity(RINGBUFF_VOLATILE ringbuff_t* buff) {
+#if RINGBUFF_USE_POW2
+    return buff->size;
+#else
+    return buff->size - 1;
+#endif /* RINGBUFF_USE_POW2 */
+}
+
+/**
+ * \brief           Get number of bytes ready to read, consumer side
+ * \param[in]       buff: Buffer handle
+ * \return          Number of bytes ready to read
+ */
+static inline size_t
+ringbuff_fast_get_full(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    buff->w = RINGBUFF_PTR_LOAD(buff->shared->w);
+#if RINGBUFF_USE_SPSC
+    RINGBUFF_MEMORY_BARRIER();
+#endif /* RINGBUFF_USE_SPSC */
+    return ringbuff_fast_count(buff, buff->w, buff->r);
+}
+
+/**
+ * \brief           Get number of bytes free to write, producer side
+ * \param[in]       buff: Buffer handle
+ * \return          Number of bytes free to write
+ */
+static inline size_t
+ringbuff_fast_get_free(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    buff->r = RINGBUFF_PTR_LOAD(buff->shared->r);
+#if RINGBUFF_USE_SPSC
+    RINGBUFF_MEMORY_BARRIER();
+#endif /* RINGBUFF_USE_SPSC */
+    return ringbuff_fast_capacity(buff) - ringbuff_fast_count(buff, buff->w, buff->r);
+}
+
+/**
+ * \brief           Write data to buffer, producer side
+ * \param[in]       buff: Buffer handle
+ * \param[in]       data: Data to write
+ * \param[in]       btw: Number of bytes to write
+ * \return          Number of bytes written
+ */
+static inline size_t
+ringbuff_fast_write(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw) {
+    size_t free, off, tocopy;
+    const uint8_t* d = data;
+#if RINGBUFF_USE_STATS
+    size_t req = btw;
+#endif /* RINGBUFF_USE_STATS */
+
+    /* Shadow read pointer is refreshed only when it indicates too little space */
+    free = ringbuff_fast_capacity(buff) - ringbuff_fast_count(buff, buff->w, buff->r);
+    if (free < btw) {
+        free = ringbuff_fast_get_free(buff);
+        if (free < btw) {
+            btw = free;
+        }
+    }
+    if (btw == 0) {
+#if RINGBUFF_USE_STATS
+        ringbuff_stats_short(buff);
+#endif /* RINGBUFF_USE_STATS */
+        return 0;
+    }
+
+    off = ringbuff_fast_idx(buff, buff->w);
+    tocopy = buff->size - off < btw ? buff->size - off : btw;
+    RINGBUFF_MEMCPY(&buff->buff[off], d, tocopy);
+    if (btw > tocopy) {
+        RINGBUFF_MEMCPY(buff->buff, &d[tocopy], btw - tocopy);
+    }
+#if RINGBUFF_USE_CACHE_MAINT
+    if (buff->cache_maint) {
+        ringbuff_cache_clean(buff, buff->w, btw);
+    }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+#if RINGBUFF_USE_SPSC
+    RINGBUFF_MEMORY_BARRIER();
+#endif /* RINGBUFF_USE_SPSC */
+    buff->w = ringbuff_fast_add(buff, buff->w, btw);
+    RINGBUFF_PTR_STORE(buff->shared->w, buff->w);
+#if RINGBUFF_USE_STATS
+    ringbuff_stats_write(buff, btw);
+    if (btw < req) {
+        ringbuff_stats_short(buff);
+    }
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+    RINGBUFF_TRACE(buff, RINGBUFF_EVT_WRITE, btw);
+#endif /* RINGBUFF_USE_TRACE */
+    return btw;
+}
+
+/**
+ * \brief           Read data from buffer, consumer side
+ * \param[in]       buff: Buffer handle
+ * \param[out]      data: Memory to read data to
+ * \param[in]       btr: Number of bytes to read
+ * \return          Number of bytes read
+ */
+static inline size_t
+ringbuff_fast_read(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t btr) {
+    size_t full, off, tocopy;
+    uint8_t* d = data;
+
+    /* Shadow write pointer is refreshed only when it indicates too little data */
+    full = ringbuff_fast_count(buff, buff->w, buff->r);
+    if (full < btr) {
+        full = ringbuff_fast_get_full(buff);
+        if (full < btr) {
+            btr = full;
+        }
+    }
+    if (btr == 0) {
+        return 0;
+    }
+
+#if RINGBUFF_USE_CACHE_MAINT
+    if (buff->cache_maint) {
+        ringbuff_cache_invalidate(buff, buff->r, btr);
+    }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+    off = ringbuff_fast_idx(buff, buff->r);
+    tocopy = buff->size - off < btr ? buff->size - off : btr;
+    RINGBUFF_MEMCPY(d, &buff->buff[off], tocopy);
+    if (btr > tocopy) {
+        RINGBUFF_MEMCPY(&d[tocopy], buff->buff, btr - tocopy);
+    }
+
+#if RINGBUFF_USE_SPSC
+    RINGBUFF_MEMORY_BARRIER();
+#endif /* RINGBUFF_USE_SPSC */
+    buff->r = ringbuff_fast_add(buff, buff->r, btr);
+    RINGBUFF_PTR_STORE(buff->shared->r, buff->r);
+#if RINGBUFF_USE_STATS
+    ringbuff_stats_read(buff, btr);
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+    RINGBUFF_TRACE(buff, RINGBUFF_EVT_READ, btr);
+#endif /* RINGBUFF_USE_TRACE */
+    return btr;
+}
+
+/**
+ * \brief           Get up to 2 memory blocks with all data ready to read, consumer side.
+ *                  Same as \ref ringbuff_read_acquire
+ * \param[in]       buff: Buffer handle
+ * \param[out]      ptr1: Output variable to write first block address to
+ * \param[out]      len1: Output variable to write first block length to
+ * \param[out]      ptr2: Output variable to write second block address to, `NULL` when not used
+ * \param[out]      len2: Output variable to write second block length to, `0` when not used
+ * \return          Total number of bytes in both blocks
+ */
+static inline size_t
+ringbuff_fast_read_acquire(RINGBUFF_VOLATILE ringbuff_t* buff, void** ptr1, size_t* len1, void** ptr2, size_t* len2) {
+    size_t full, off, lin;
+
+    full = ringbuff_fast_get_full(buff);
+    off = ringbuff_fast_idx(buff, buff->r);
+    lin = buff->size - off < full ? buff->size - off : full;
+
+    *ptr1 = &buff->buff[off];
+    *len1 = lin;
+    *len2 = full - lin;
+    *ptr2 = full > lin ? buff->buff : NULL;
+#if RINGBUFF_USE_CACHE_MAINT
+    if (buff->cache_maint) {
+        ringbuff_cache_invalidate(buff, buff->r, full);
+    }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+    return full;
+}
+
+/**
+ * \brief           Release data acquired with \ref ringbuff_fast_read_acquire, consumer side
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes to release, must not exceed acquired length
+ */
+static inline void
+ringbuff_fast_read_release(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+#if RINGBUFF_USE_SPSC
+    RINGBUFF_MEMORY_BARRIER();
+#endif /* RINGBUFF_USE_SPSC */
+    buff->r = ringbuff_fast_add(buff, buff->r, len);
+    RINGBUFF_PTR_STORE(buff->shared->r, buff->r);
+#if RINGBUFF_USE_STATS
+    if (len > 0) {
+        ringbuff_stats_read(buff, len);
+    }
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+    if (len > 0) {
+        RINGBUFF_TRACE(buff, RINGBUFF_EVT_READ, len);
+    }
+#endif /* RINGBUFF_USE_TRACE */
+}
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RINGBUFF_FAST_HDR_H */
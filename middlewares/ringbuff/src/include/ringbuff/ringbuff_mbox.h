@@ -0,0 +1,111 @@
+/**
+ * \file            ringbuff_mbox.h
+ * \brief           Latest-value mailbox
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_MBOX_HDR_H
+#define RINGBUFF_MBOX_HDR_H
+
+#include "ringbuff/ringbuff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        RINGBUFF_MBOX Latest-value mailbox
+ * \brief           Sequence lock protected state snapshot, reader always gets newest value
+ * \{
+ *
+ * Mailbox holds one state structure of fixed size. Writer overwrites it in place,
+ * reader copies newest complete value, older values are not kept.
+ * Read takes same time regardless of number of writes since last read.
+ *
+ * Writer increments sequence counter before and after the update, counter is odd while update is in progress.
+ * Reader copies data between two reads of counter and retries when counter was odd or has changed,
+ * copy was then torn by concurrent write. Writer never waits for reader.
+ *
+ * It is safe for single writer and any number of readers on different cores,
+ * with only \ref ringbuff_mbox_shared_t placed in shared memory.
+ * Data array must not be cached by any core.
+ */
+
+/**
+ * \brief           Number of counter checks of \ref ringbuff_mbox_read before it gives up,
+ *                  when writer kept updating state during every attempt
+ */
+#ifndef RINGBUFF_MBOX_RETRIES
+#define RINGBUFF_MBOX_RETRIES                   64
+#endif
+
+/**
+ * \brief           Mailbox sequence counter, placed in memory shared between cores
+ */
+typedef struct {
+    uint32_t seq RINGBUFF_CACHE_ALIGN;          /*!< Twice the number of completed writes, odd during write */
+} ringbuff_mbox_shared_t;
+
+/**
+ * \brief           Mailbox structure, placed in core-local memory
+ */
+typedef struct {
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic1;                            /*!< Magic 1 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    uint8_t* buff;                              /*!< Pointer to state data */
+    size_t size;                                /*!< Size of state data in units of bytes */
+    RINGBUFF_VOLATILE ringbuff_mbox_shared_t* shared;   /*!< Pointer to shared counter or to `local` member */
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic2;                            /*!< Magic 2 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    ringbuff_mbox_shared_t local;               /*!< Counter for mailbox not shared between cores */
+} ringbuff_mbox_t;
+
+uint8_t     ringbuff_mbox_init(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, void* buffdata, size_t size);
+uint8_t     ringbuff_mbox_init_shared(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, RINGBUFF_VOLATILE ringbuff_mbox_shared_t* shared, void* buffdata, size_t size);
+uint8_t     ringbuff_mbox_attach(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, RINGBUFF_VOLATILE ringbuff_mbox_shared_t* shared, void* buffdata, size_t size);
+
+/* Write functions */
+uint8_t     ringbuff_mbox_write(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, const void* data);
+
+/* Read functions */
+uint8_t     ringbuff_mbox_read(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, void* data, uint32_t* version);
+uint32_t    ringbuff_mbox_get_version(RINGBUFF_VOLATILE ringbuff_mbox_t* buff);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RINGBUFF_MBOX_HDR_H */
@@ -0,0 +1,119 @@
+/**
+ * \file            ringbuff_ovr.h
+ * \brief           Overwrite-oldest record buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_OVR_HDR_H
+#define RINGBUFF_OVR_HDR_H
+
+#include "ringbuff/ringbuff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        RINGBUFF_OVR Overwrite-oldest record buffer
+ * \brief           Lossy record buffer, producer never waits for consumer
+ * \{
+ *
+ * Producer writes whole records and, when new record does not fit,
+ * drops oldest records to make room. Read pointer is never checked, producer never fails on full buffer.
+ * Every record carries sequence number, consumer detects dropped records as gap in sequence.
+ *
+ * Producer advances `tail`, start of oldest valid record, before it overwrites record memory.
+ * Consumer copies record and checks `tail` afterwards, record overwritten during copy is discarded
+ * and consumer continues with oldest valid record.
+ *
+ * Same as \ref RINGBUFF, it is safe for single producer and single consumer
+ * on different cores, with only \ref ringbuff_ovr_shared_t placed in shared memory.
+ * Data array must not be cached by any core.
+ */
+
+/**
+ * \brief           Record header, in front of every record
+ */
+typedef struct {
+    uint32_t seq;                               /*!< Record sequence number, incremented by `1` for each record */
+    uint32_t len;                               /*!< Record payload length in units of bytes */
+} ringbuff_ovr_hdr_t;
+
+/**
+ * \brief           Overwrite buffer pointers structure, placed in memory shared between cores.
+ *                  Pointers are free-running byte counters
+ */
+typedef struct {
+    /* Producer owned cache line */
+    size_t w RINGBUFF_CACHE_ALIGN;              /*!< End of newest record */
+    size_t tail;                                /*!< Start of oldest record not overwritten */
+    uint32_t wseq;                              /*!< Sequence number of next written record */
+
+    /* Consumer owned cache line */
+    size_t r RINGBUFF_CACHE_ALIGN;              /*!< Start of next record to read */
+    uint32_t rseq;                              /*!< Sequence number of next expected record */
+} ringbuff_ovr_shared_t;
+
+/**
+ * \brief           Overwrite buffer structure, placed in core-local memory
+ */
+typedef struct {
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic1;                            /*!< Magic 1 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    uint8_t* buff;                              /*!< Pointer to buffer data */
+    size_t size;                                /*!< Size of buffer data in units of bytes, power of `2` */
+    RINGBUFF_VOLATILE ringbuff_ovr_shared_t* shared;/*!< Pointer to shared pointers or to `local` member */
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic2;                            /*!< Magic 2 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    ringbuff_ovr_shared_t local;                /*!< Pointers for buffer not shared between cores */
+} ringbuff_ovr_t;
+
+uint8_t     ringbuff_ovr_init(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, void* buffdata, size_t size);
+uint8_t     ringbuff_ovr_init_shared(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, RINGBUFF_VOLATILE ringbuff_ovr_shared_t* shared, void* buffdata, size_t size);
+uint8_t     ringbuff_ovr_attach(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, RINGBUFF_VOLATILE ringbuff_ovr_shared_t* shared, void* buffdata, size_t size);
+
+/* Write functions */
+size_t      ringbuff_ovr_write(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, const void* data, size_t len);
+
+/* Read functions */
+size_t      ringbuff_ovr_read(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, void* data, size_t size, uint32_t* lost);
+size_t      ringbuff_ovr_peek_len(RINGBUFF_VOLATILE ringbuff_ovr_t* buff);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RINGBUFF_OVR_HDR_H */
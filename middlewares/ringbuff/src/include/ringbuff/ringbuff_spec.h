@@ -0,0 +1,420 @@
+/**
+ * \file            ringbuff_spec.h
+ * \brief           Ring buffer functions specialized per instance
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_SPEC_HDR_H
+#define RINGBUFF_SPEC_HDR_H
+
+#include "ringbuff/ringbuff.h"
+#if RINGBUFF_USE_TRACE
+#include RINGBUFF_TRACE_HDR
+#endif /* RINGBUFF_USE_TRACE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        RINGBUFF_SPEC Specialized instances
+ * \brief           Inline functions generated per buffer with compile-time option set
+ * \{
+ *
+ * \ref RINGBUFF_VOLATILE and \ref RINGBUFF_USE_MAGIC apply to every buffer of application,
+ * and regular API checks event callback on every call.
+ * \ref RINGBUFF_SPEC_DEFINE generates typed inline functions for one buffer
+ * with only the features selected in its option mask,
+ * remaining checks are removed by compiler as options are constants.
+ *
+ * Core-local scratch buffer defined with \ref RINGBUFF_SPEC_LOCAL compiles to plain indexed copy,
+ * while buffers shared between cores keep their safety features with \ref RINGBUFF_SPEC_FULL.
+ *
+ * Functions operate on regular handle, initialized with \ref ringbuff_init, \ref ringbuff_init_shared
+ * or \ref ringbuff_attach, and can be mixed with regular API on the same handle.
+ * Local copy of pointers and shared pointers are kept in sync the same way as in regular API.
+ *
+ * \note            Rate limit (\ref RINGBUFF_USE_RATE) is not applied, same as in \ref RINGBUFF_FAST functions
+ */
+
+#define RINGBUFF_SPEC_VOLATILE                  0x01    /*!< Local and shared pointers accessed as `volatile` */
+#define RINGBUFF_SPEC_SHARED                    0x02    /*!< Peer pointer is in memory shared between cores,
+                                                            accessed with \ref RINGBUFF_PTR_LOAD, \ref RINGBUFF_PTR_STORE
+                                                            and \ref RINGBUFF_MEMORY_BARRIER, cache maintenance is done when enabled on handle */
+#define RINGBUFF_SPEC_MAGIC                     0x04    /*!< Handle and parameters validated on every call, see \ref ringbuff_is_ready */
+#define RINGBUFF_SPEC_EVT                       0x08    /*!< Event callback called, see \ref ringbuff_set_evt_fn */
+#define RINGBUFF_SPEC_STATS                     0x10    /*!< Statistics updated and trace hook called,
+                                                            when \ref RINGBUFF_USE_STATS and \ref RINGBUFF_USE_TRACE are enabled */
+
+/**
+ * \brief           Option set of buffer used by single core only, no checks and no sharing
+ */
+#define RINGBUFF_SPEC_LOCAL                     0x00
+
+/**
+ * \brief           Option set with all features, same guarantees as regular API
+ */
+#define RINGBUFF_SPEC_FULL                      (RINGBUFF_SPEC_VOLATILE | RINGBUFF_SPEC_SHARED | RINGBUFF_SPEC_MAGIC | RINGBUFF_SPEC_EVT | RINGBUFF_SPEC_STATS)
+
+/**
+ * \brief           Function attribute of generic implementation,
+ *                  forced inline so that every instance is specialized for its options
+ */
+#ifndef RINGBUFF_SPEC_INLINE
+#define RINGBUFF_SPEC_INLINE                    static inline __attribute__((always_inline))
+#endif /* RINGBUFF_SPEC_INLINE */
+
+/**
+ * \brief           Generate specialized functions for buffer
+ *
+ * Defines `static inline` functions `name_write`, `name_read`, `name_get_full` and `name_get_free`,
+ * with the same parameters and return values as \ref ringbuff_write, \ref ringbuff_read,
+ * \ref ringbuff_get_full and \ref ringbuff_get_free
+ *
+ * \param[in]       name: Prefix of generated function names
+ * \param[in]       opts: Compile-time option mask, bitwise OR of `RINGBUFF_SPEC_*` options
+ */
+#define RINGBUFF_SPEC_DEFINE(name, opts)                                                    \
+    static inline size_t                                                                    \
+    name##_write(ringbuff_t* buff, const void* data, size_t btw) {                          \
+        return ringbuff_spec_write(buff, data, btw, (opts));                                \
+    }                                                                                       \
+    static inline size_t                                                                    \
+    name##_read(ringbuff_t* buff, void* data, size_t btr) {                                 \
+        return ringbuff_spec_read(buff, data, btr, (opts));                                 \
+    }                                                                                       \
+    static inline size_t                                                                    \
+    name##_get_full(ringbuff_t* buff) {                                                     \
+        return ringbuff_spec_get_full(buff, (opts));                                        \
+    }                                                                                       \
+    static inline size_t                                                                    \
+    name##_get_free(ringbuff_t* buff) {                                                     \
+        return ringbuff_spec_get_free(buff, (opts));                                        \
+    }
+
+/**
+ * \brief           Load pointer value
+ * \param[in]       p: Pointer to pointer value
+ * \param[in]       opts: Option mask
+ * \return          Pointer value
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_ld(const size_t* p, const uint32_t opts) {
+    if (opts & RINGBUFF_SPEC_SHARED) {
+        return RINGBUFF_PTR_LOAD(*(const volatile size_t *)p);
+    } else if (opts & RINGBUFF_SPEC_VOLATILE) {
+        return *(const volatile size_t *)p;
+    }
+    return *p;
+}
+
+/**
+ * \brief           Store pointer value
+ * \param[out]      p: Pointer to pointer value
+ * \param[in]       v: New pointer value
+ * \param[in]       opts: Option mask
+ */
+RINGBUFF_SPEC_INLINE void
+ringbuff_spec_st(size_t* p, size_t v, const uint32_t opts) {
+    if (opts & RINGBUFF_SPEC_SHARED) {
+        RINGBUFF_PTR_STORE(*(volatile size_t *)p, v);
+    } else if (opts & RINGBUFF_SPEC_VOLATILE) {
+        *(volatile size_t *)p = v;
+    } else {
+        *p = v;
+    }
+}
+
+/**
+ * \brief           Order data accesses against pointer publication of peer core
+ * \param[in]       opts: Option mask
+ */
+RINGBUFF_SPEC_INLINE void
+ringbuff_spec_barrier(const uint32_t opts) {
+#if RINGBUFF_USE_SPSC
+    if (opts & RINGBUFF_SPEC_SHARED) {
+        RINGBUFF_MEMORY_BARRIER();
+    }
+#else
+    (void)opts;
+#endif /* RINGBUFF_USE_SPSC */
+}
+
+/**
+ * \brief           Get number of bytes between write and read pointers
+ * \param[in]       buff: Buffer handle
+ * \param[in]       w: Write pointer
+ * \param[in]       r: Read pointer
+ * \return          Number of bytes in buffer
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_count(const ringbuff_t* buff, size_t w, size_t r) {
+#if RINGBUFF_USE_POW2
+    (void)buff;
+    return w - r;
+#else
+    return w >= r ? w - r : buff->size - (r - w);
+#endif /* RINGBUFF_USE_POW2 */
+}
+
+/**
+ * \brief           Get maximum number of bytes buffer can hold
+ * \param[in]       buff: Buffer handle
+ * \return          Buffer capacity
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_capacity(const ringbuff_t* buff) {
+#if RINGBUFF_USE_POW2
+    return buff->size;
+#else
+    return buff->size - 1;
+#endif /* RINGBUFF_USE_POW2 */
+}
+
+/**
+ * \brief           Copy data to or from buffer array, split at end of array
+ * \param[in]       buff: Buffer handle
+ * \param[in]       ptr: Pointer value of first byte
+ * \param[in]       mem: Application memory
+ * \param[in]       len: Number of bytes to copy
+ * \param[in]       to_buff: Set to `1` to copy from `mem` to buffer array, `0` for opposite direction
+ */
+RINGBUFF_SPEC_INLINE void
+ringbuff_spec_copy(const ringbuff_t* buff, size_t ptr, uint8_t* mem, size_t len, const uint8_t to_buff) {
+    size_t off, tocopy;
+
+#if RINGBUFF_USE_POW2
+    off = ptr & (buff->size - 1);
+#else
+    off = ptr;
+#endif /* RINGBUFF_USE_POW2 */
+    tocopy = buff->size - off < len ? buff->size - off : len;
+    if (to_buff) {
+        RINGBUFF_MEMCPY(&buff->buff[off], mem, tocopy);
+        if (len > tocopy) {
+            RINGBUFF_MEMCPY(buff->buff, &mem[tocopy], len - tocopy);
+        }
+    } else {
+        RINGBUFF_MEMCPY(mem, &buff->buff[off], tocopy);
+        if (len > tocopy) {
+            RINGBUFF_MEMCPY(&mem[tocopy], buff->buff, len - tocopy);
+        }
+    }
+}
+
+/**
+ * \brief           Advance pointer
+ * \param[in]       buff: Buffer handle
+ * \param[in]       i: Pointer value
+ * \param[in]       n: Number of bytes to advance, not greater than buffer size
+ * \return          New pointer value
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_add(const ringbuff_t* buff, size_t i, size_t n) {
+#if RINGBUFF_USE_POW2
+    (void)buff;
+    return i + n;
+#else
+    return i + n >= buff->size ? i + n - buff->size : i + n;
+#endif /* RINGBUFF_USE_POW2 */
+}
+
+/**
+ * \brief           Get number of bytes ready to read, consumer side
+ * \param[in]       buff: Buffer handle
+ * \param[in]       opts: Option mask
+ * \return          Number of bytes ready to read
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_get_full(ringbuff_t* buff, const uint32_t opts) {
+    size_t w;
+
+    if ((opts & RINGBUFF_SPEC_MAGIC) && !ringbuff_is_ready(buff)) {
+        return 0;
+    }
+    w = ringbuff_spec_ld((const size_t *)&buff->shared->w, opts);
+    ringbuff_spec_barrier(opts);
+    ringbuff_spec_st(&buff->w, w, opts & ~RINGBUFF_SPEC_SHARED);
+    return ringbuff_spec_count(buff, w, ringbuff_spec_ld(&buff->r, opts & ~RINGBUFF_SPEC_SHARED));
+}
+
+/**
+ * \brief           Get number of bytes free to write, producer side
+ * \param[in]       buff: Buffer handle
+ * \param[in]       opts: Option mask
+ * \return          Number of bytes free to write
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_get_free(ringbuff_t* buff, const uint32_t opts) {
+    size_t r;
+
+    if ((opts & RINGBUFF_SPEC_MAGIC) && !ringbuff_is_ready(buff)) {
+        return 0;
+    }
+    r = ringbuff_spec_ld((const size_t *)&buff->shared->r, opts);
+    ringbuff_spec_barrier(opts);
+    ringbuff_spec_st(&buff->r, r, opts & ~RINGBUFF_SPEC_SHARED);
+    return ringbuff_spec_capacity(buff) - ringbuff_spec_count(buff, ringbuff_spec_ld(&buff->w, opts & ~RINGBUFF_SPEC_SHARED), r);
+}
+
+/**
+ * \brief           Write data to buffer, producer side
+ * \param[in]       buff: Buffer handle
+ * \param[in]       data: Data to write
+ * \param[in]       btw: Number of bytes to write
+ * \param[in]       opts: Option mask
+ * \return          Number of bytes written
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_write(ringbuff_t* buff, const void* data, size_t btw, const uint32_t opts) {
+    const uint32_t lopts = opts & ~RINGBUFF_SPEC_SHARED;
+    size_t w, free;
+#if RINGBUFF_USE_STATS
+    size_t req = btw;
+#endif /* RINGBUFF_USE_STATS */
+
+    if ((opts & RINGBUFF_SPEC_MAGIC) && (!ringbuff_is_ready(buff) || data == NULL || btw == 0)) {
+        return 0;
+    }
+
+    /* Shadow read pointer is refreshed only when it indicates too little space */
+    w = ringbuff_spec_ld(&buff->w, lopts);
+    free = ringbuff_spec_capacity(buff) - ringbuff_spec_count(buff, w, ringbuff_spec_ld(&buff->r, lopts));
+    if (free < btw) {
+        free = ringbuff_spec_get_free(buff, opts & ~RINGBUFF_SPEC_MAGIC);
+        if (free < btw) {
+            btw = free;
+        }
+    }
+    if (btw == 0) {
+#if RINGBUFF_USE_STATS
+        if (opts & RINGBUFF_SPEC_STATS) {
+            ringbuff_stats_short(buff);
+        }
+#endif /* RINGBUFF_USE_STATS */
+        return 0;
+    }
+
+    ringbuff_spec_copy(buff, w, (uint8_t *)data, btw, 1);
+#if RINGBUFF_USE_CACHE_MAINT
+    if ((opts & RINGBUFF_SPEC_SHARED) && buff->cache_maint) {
+        ringbuff_cache_clean(buff, w, btw);
+    }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+    ringbuff_spec_barrier(opts);
+    w = ringbuff_spec_add(buff, w, btw);
+    ringbuff_spec_st(&buff->w, w, lopts);
+    ringbuff_spec_st((size_t *)&buff->shared->w, w, opts);
+#if RINGBUFF_USE_STATS
+    if (opts & RINGBUFF_SPEC_STATS) {
+        ringbuff_stats_write(buff, btw);
+        if (btw < req) {
+            ringbuff_stats_short(buff);
+        }
+    }
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+    if (opts & RINGBUFF_SPEC_STATS) {
+        RINGBUFF_TRACE(buff, RINGBUFF_EVT_WRITE, btw);
+    }
+#endif /* RINGBUFF_USE_TRACE */
+    if ((opts & RINGBUFF_SPEC_EVT) && buff->evt_fn != NULL) {
+        buff->evt_fn(buff, RINGBUFF_EVT_WRITE, btw);
+    }
+    return btw;
+}
+
+/**
+ * \brief           Read data from buffer, consumer side
+ * \param[in]       buff: Buffer handle
+ * \param[out]      data: Memory to read data to
+ * \param[in]       btr: Number of bytes to read
+ * \param[in]       opts: Option mask
+ * \return          Number of bytes read
+ */
+RINGBUFF_SPEC_INLINE size_t
+ringbuff_spec_read(ringbuff_t* buff, void* data, size_t btr, const uint32_t opts) {
+    const uint32_t lopts = opts & ~RINGBUFF_SPEC_SHARED;
+    size_t r, full;
+
+    if ((opts & RINGBUFF_SPEC_MAGIC) && (!ringbuff_is_ready(buff) || data == NULL || btr == 0)) {
+        return 0;
+    }
+
+    /* Shadow write pointer is refreshed only when it indicates too little data */
+    r = ringbuff_spec_ld(&buff->r, lopts);
+    full = ringbuff_spec_count(buff, ringbuff_spec_ld(&buff->w, lopts), r);
+    if (full < btr) {
+        full = ringbuff_spec_get_full(buff, opts & ~RINGBUFF_SPEC_MAGIC);
+        if (full < btr) {
+            btr = full;
+        }
+    }
+    if (btr == 0) {
+        return 0;
+    }
+
+#if RINGBUFF_USE_CACHE_MAINT
+    if ((opts & RINGBUFF_SPEC_SHARED) && buff->cache_maint) {
+        ringbuff_cache_invalidate(buff, r, btr);
+    }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+    ringbuff_spec_copy(buff, r, data, btr, 0);
+
+    ringbuff_spec_barrier(opts);
+    r = ringbuff_spec_add(buff, r, btr);
+    ringbuff_spec_st(&buff->r, r, lopts);
+    ringbuff_spec_st((size_t *)&buff->shared->r, r, opts);
+#if RINGBUFF_USE_STATS
+    if (opts & RINGBUFF_SPEC_STATS) {
+        ringbuff_stats_read(buff, btr);
+    }
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+    if (opts & RINGBUFF_SPEC_STATS) {
+        RINGBUFF_TRACE(buff, RINGBUFF_EVT_READ, btr);
+    }
+#endif /* RINGBUFF_USE_TRACE */
+    if ((opts & RINGBUFF_SPEC_EVT) && buff->evt_fn != NULL) {
+        buff->evt_fn(buff, RINGBUFF_EVT_READ, btr);
+    }
+    return btr;
+}
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RINGBUFF_SPEC_HDR_H */
@@ -0,0 +1,114 @@
+/**
+ * \file            ringbuff_tri.h
+ * \brief           Triple buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#ifndef RINGBUFF_TRI_HDR_H
+#define RINGBUFF_TRI_HDR_H
+
+#include "ringbuff/ringbuff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \defgroup        RINGBUFF_TRI Triple buffer
+ * \brief           Frame exchange between producer and consumer running at different rates
+ * \{
+ *
+ * Three frames of fixed size, writer fills one in place while reader uses another one,
+ * third holds newest completed frame. Neither side ever waits, frames are not copied,
+ * reader always gets most recently completed frame and older frames are skipped.
+ *
+ * Each shared index has single writer, no atomic exchange between cores is needed:
+ *
+ * - Writer publishes completed frame in `latest` and picks next frame, neither `latest` nor `reading`
+ * - Reader announces frame from `latest` in `reading` and re-checks `latest` afterwards,
+ *      frame is valid when `latest` did not change meanwhile
+ *
+ * It is safe for single writer and single reader on different cores,
+ * with only \ref ringbuff_tri_shared_t placed in shared memory.
+ * Frame data must not be cached by any core.
+ */
+
+/* Value of `reading` index when reader holds no frame */
+#define RINGBUFF_TRI_NONE                       3
+
+/**
+ * \brief           Triple buffer indexes, placed in memory shared between cores
+ */
+typedef struct {
+    /* Writer owned cache line */
+    uint32_t latest RINGBUFF_CACHE_ALIGN;       /*!< Newest completed frame, `version << 2 | index`, version `0` before first frame */
+    uint32_t wr;                                /*!< Index of frame being written */
+
+    /* Reader owned cache line */
+    uint32_t reading RINGBUFF_CACHE_ALIGN;      /*!< Index of frame used by reader, \ref RINGBUFF_TRI_NONE when none */
+} ringbuff_tri_shared_t;
+
+/**
+ * \brief           Triple buffer structure, placed in core-local memory
+ */
+typedef struct {
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic1;                            /*!< Magic 1 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    uint8_t* buff;                              /*!< Pointer to data of `3` frames */
+    size_t size;                                /*!< Size of one frame in units of bytes */
+    RINGBUFF_VOLATILE ringbuff_tri_shared_t* shared;/*!< Pointer to shared indexes or to `local` member */
+#if RINGBUFF_USE_MAGIC
+    uint32_t magic2;                            /*!< Magic 2 word */
+#endif /* RINGBUFF_USE_MAGIC */
+    ringbuff_tri_shared_t local;                /*!< Indexes for buffer not shared between cores */
+} ringbuff_tri_t;
+
+uint8_t     ringbuff_tri_init(RINGBUFF_VOLATILE ringbuff_tri_t* buff, void* buffdata, size_t size);
+uint8_t     ringbuff_tri_init_shared(RINGBUFF_VOLATILE ringbuff_tri_t* buff, RINGBUFF_VOLATILE ringbuff_tri_shared_t* shared, void* buffdata, size_t size);
+uint8_t     ringbuff_tri_attach(RINGBUFF_VOLATILE ringbuff_tri_t* buff, RINGBUFF_VOLATILE ringbuff_tri_shared_t* shared, void* buffdata, size_t size);
+
+/* Write functions */
+void *      ringbuff_tri_write_acquire(RINGBUFF_VOLATILE ringbuff_tri_t* buff);
+uint8_t     ringbuff_tri_write_commit(RINGBUFF_VOLATILE ringbuff_tri_t* buff);
+
+/* Read functions */
+const void *ringbuff_tri_read_acquire(RINGBUFF_VOLATILE ringbuff_tri_t* buff, uint32_t* version);
+void        ringbuff_tri_read_release(RINGBUFF_VOLATILE ringbuff_tri_t* buff);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RINGBUFF_TRI_HDR_H */
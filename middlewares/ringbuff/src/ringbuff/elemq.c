@@ -0,0 +1,255 @@
+/**
+ * \file            elemq.c
+ * \brief           Fixed-size element queue
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#include <stddef.h>
+#include "ringbuff/elemq.h"
+
+/* Memory set and copy functions */
+#define BUF_MEMSET                      memset
+#define BUF_MEMCPY                      RINGBUFF_MEMCPY
+
+#if RINGBUFF_USE_MAGIC
+#define BUF_IS_VALID(q)                 ((q) != NULL && (q)->magic1 == 0xDEADBEEF && (q)->magic2 == ~0xDEADBEEF && (q)->buff != NULL && (q)->capacity > 0)
+#else
+#define BUF_IS_VALID(q)                 ((q) != NULL && (q)->buff != NULL && (q)->capacity > 0)
+#endif /* RINGBUFF_USE_MAGIC */
+
+/* Barrier between peer pointer read and data access, see ringbuff.c */
+#if RINGBUFF_USE_SPSC
+#define BUF_BARRIER()                   RINGBUFF_MEMORY_BARRIER()
+#else
+#define BUF_BARRIER()                   do {} while (0)
+#endif /* RINGBUFF_USE_SPSC */
+
+/* Slot of free-running element pointer */
+#define BUF_SLOT(q, i)                  (&(q)->buff[((i) & ((q)->capacity - 1)) * (q)->elem_size])
+
+/**
+ * \brief           Setup queue handle and attach it to pointers
+ * \param[in]       q: Queue handle
+ * \param[in]       shared: Pointers structure. Set to `NULL` to use handle local pointers
+ * \param[in]       buffdata: Pointer to memory of `capacity` slots, word aligned
+ * \param[in]       elem_size: Element size in units of bytes, multiple of `4`
+ * \param[in]       capacity: Number of slots, power of `2`
+ * \param[in]       reset: Set to `1` to reset pointers to empty queue, `0` to keep their current value
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_init(RINGBUFF_VOLATILE elemq_t* q, RINGBUFF_VOLATILE elemq_shared_t* shared,
+            void* buffdata, size_t elem_size, size_t capacity, uint8_t reset) {
+    if (q == NULL || buffdata == NULL || ((uintptr_t)buffdata & 0x03) != 0
+        || elem_size == 0 || (elem_size & 0x03) != 0
+        || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return 0;
+    }
+
+    BUF_MEMSET((void *)q, 0x00, sizeof(*q));
+
+    q->buff = buffdata;
+    q->elem_size = elem_size;
+    q->capacity = capacity;
+    q->shared = shared != NULL ? shared : &q->local;
+    if (reset) {
+        q->shared->w = 0;
+        q->shared->r = 0;
+    }
+    q->w = q->shared->w;
+    q->r = q->shared->r;
+
+#if RINGBUFF_USE_MAGIC
+    q->magic1 = 0xDEADBEEF;
+    q->magic2 = ~0xDEADBEEF;
+#endif /* RINGBUFF_USE_MAGIC */
+
+    return 1;
+}
+
+/**
+ * \brief           Initialize queue handle with pointers stored in handle itself
+ * \param[in]       q: Queue handle
+ * \param[in]       buffdata: Pointer to memory of `capacity * elem_size` bytes, word aligned
+ * \param[in]       elem_size: Element size in units of bytes, multiple of `4`
+ * \param[in]       capacity: Capacity in units of elements, power of `2`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+elemq_init(RINGBUFF_VOLATILE elemq_t* q, void* buffdata, size_t elem_size, size_t capacity) {
+    return prv_init(q, NULL, buffdata, elem_size, capacity, 1);
+}
+
+/**
+ * \brief           Initialize core-local queue handle with pointers in shared memory
+ *                  and reset pointers to empty queue.
+ *
+ * Called once by core that owns shared memory, before other core attaches with \ref elemq_attach
+ *
+ * \param[in]       q: Core-local queue handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory of element slots, see \ref elemq_init
+ * \param[in]       elem_size: Element size in units of bytes
+ * \param[in]       capacity: Capacity in units of elements
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+elemq_init_shared(RINGBUFF_VOLATILE elemq_t* q, RINGBUFF_VOLATILE elemq_shared_t* shared, void* buffdata, size_t elem_size, size_t capacity) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(q, shared, buffdata, elem_size, capacity, 1);
+}
+
+/**
+ * \brief           Initialize core-local queue handle with pointers in shared memory,
+ *                  previously initialized by other core with \ref elemq_init_shared
+ * \param[in]       q: Core-local queue handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory of element slots
+ * \param[in]       elem_size: Element size in units of bytes
+ * \param[in]       capacity: Capacity in units of elements
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+elemq_attach(RINGBUFF_VOLATILE elemq_t* q, RINGBUFF_VOLATILE elemq_shared_t* shared, void* buffdata, size_t elem_size, size_t capacity) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(q, shared, buffdata, elem_size, capacity, 0);
+}
+
+/**
+ * \brief           Push element to queue
+ * \note            Only producer may call this function
+ * \param[in]       q: Queue handle
+ * \param[in]       elem: Element to copy, element size bytes
+ * \return          `1` on success, `0` if queue is full
+ */
+RINGBUFF_HOT uint8_t
+elemq_push(RINGBUFF_VOLATILE elemq_t* q, const void* elem) {
+    size_t w;
+
+    if (!BUF_IS_VALID(q) || elem == NULL) {
+        return 0;
+    }
+
+    w = q->shared->w;
+    if (w - q->r >= q->capacity) {
+        q->r = q->shared->r;                    /* Shadow copy is stale, re-read */
+        if (w - q->r >= q->capacity) {
+            return 0;
+        }
+        BUF_BARRIER();                          /* Read pointer before slot is overwritten */
+    }
+    BUF_MEMCPY(BUF_SLOT(q, w), elem, q->elem_size);
+    BUF_BARRIER();                              /* Element before write pointer */
+    q->shared->w = w + 1;
+    return 1;
+}
+
+/**
+ * \brief           Get number of free slots
+ * \note            Only producer may call this function
+ * \param[in]       q: Queue handle
+ * \return          Number of elements that can be pushed
+ */
+size_t
+elemq_get_free(RINGBUFF_VOLATILE elemq_t* q) {
+    if (!BUF_IS_VALID(q)) {
+        return 0;
+    }
+    q->r = q->shared->r;
+    return q->capacity - (q->shared->w - q->r);
+}
+
+/**
+ * \brief           Get oldest element in place, without copy.
+ *                  Element stays valid until it is released with \ref elemq_pop
+ * \note            Only consumer may call this function
+ * \param[in]       q: Queue handle
+ * \return          Pointer to element, `NULL` if queue is empty
+ */
+RINGBUFF_HOT const void *
+elemq_front(RINGBUFF_VOLATILE elemq_t* q) {
+    size_t r;
+
+    if (!BUF_IS_VALID(q)) {
+        return NULL;
+    }
+
+    r = q->shared->r;
+    if (q->w == r) {
+        q->w = q->shared->w;                    /* Shadow copy is stale, re-read */
+        if (q->w == r) {
+            return NULL;
+        }
+    }
+    BUF_BARRIER();                              /* Write pointer before element */
+    return BUF_SLOT(q, r);
+}
+
+/**
+ * \brief           Pop oldest element from queue
+ * \note            Only consumer may call this function
+ * \param[in]       q: Queue handle
+ * \param[out]      elem: Memory to copy element to, element size bytes.
+ *                      Set to `NULL` to release element from \ref elemq_front without copy
+ * \return          `1` on success, `0` if queue is empty
+ */
+RINGBUFF_HOT uint8_t
+elemq_pop(RINGBUFF_VOLATILE elemq_t* q, void* elem) {
+    const void* slot = elemq_front(q);
+
+    if (slot == NULL) {
+        return 0;
+    }
+    if (elem != NULL) {
+        BUF_MEMCPY(elem, slot, q->elem_size);
+    }
+    BUF_BARRIER();                              /* Element before read pointer */
+    q->shared->r = q->shared->r + 1;
+    return 1;
+}
+
+/**
+ * \brief           Get number of elements in queue
+ * \note            Only consumer may call this function
+ * \param[in]       q: Queue handle
+ * \return          Number of elements that can be popped
+ */
+size_t
+elemq_get_count(RINGBUFF_VOLATILE elemq_t* q) {
+    if (!BUF_IS_VALID(q)) {
+        return 0;
+    }
+    q->w = q->shared->w;
+    return q->w - q->shared->r;
+}
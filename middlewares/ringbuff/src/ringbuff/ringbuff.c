@@ -32,431 +32,1890 @@
  * Version:         v1.3.1
  */
 #include "ringbuff/ringbuff.h"
+#if RINGBUFF_USE_CACHE_MAINT
+#include RINGBUFF_CACHE_HDR
+#if RINGBUFF_CACHE_LINE_SIZE == 0
+#error "RINGBUFF_USE_CACHE_MAINT requires RINGBUFF_CACHE_LINE_SIZE"
+#endif
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+#if RINGBUFF_USE_STATS
+#include RINGBUFF_STATS_HDR
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_TRACE
+#include RINGBUFF_TRACE_HDR
+#endif /* RINGBUFF_USE_TRACE */
+#if RINGBUFF_USE_RATE
+#include RINGBUFF_RATE_HDR
+#endif /* RINGBUFF_USE_RATE */
+#if RINGBUFF_USE_MSG_CRC
+#include RINGBUFF_MSG_CRC_HDR
+#endif /* RINGBUFF_USE_MSG_CRC */
 
 /* Memory set and copy functions */
 #define BUF_MEMSET                      memset
-#define BUF_MEMCPY                      memcpy
+#define BUF_MEMCPY                      RINGBUFF_MEMCPY
 
 #if RINGBUFF_USE_MAGIC
-#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->magic1 == 0xDEADBEEF && (b)->magic2 == ~0xDEADBEEF && (b)->buff != NULL && (b)->size > 0)
+#define BUF_IS_INTACT(b)                ((b) != NULL && (b)->magic1 == 0xDEADBEEF && (b)->magic2 == ~0xDEADBEEF && (b)->buff != NULL && (b)->size > 0)
 #else
-#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->buff != NULL && (b)->size > 0)
+#define BUF_IS_INTACT(b)                ((b) != NULL && (b)->buff != NULL && (b)->size > 0)
 #endif /* RINGBUFF_USE_MAGIC */
+#if RINGBUFF_USE_MAGIC_CHECK
+#define BUF_IS_VALID(b)                 BUF_IS_INTACT(b)
+#else
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->buff != NULL && (b)->size > 0)
+#endif /* RINGBUFF_USE_MAGIC_CHECK */
 #define BUF_MIN(x, y)                   ((x) < (y) ? (x) : (y))
 #define BUF_MAX(x, y)                   ((x) > (y) ? (x) : (y))
+#if RINGBUFF_USE_TRACE
+#define BUF_SEND_EVT(b, type, bp)       do { RINGBUFF_TRACE((b), (type), (bp)); if ((b)->evt_fn != NULL) { (b)->evt_fn((b), (type), (bp)); } } while (0)
+#else
 #define BUF_SEND_EVT(b, type, bp)       do { if ((b)->evt_fn != NULL) { (b)->evt_fn((b), (type), (bp)); } } while (0)
+#endif /* RINGBUFF_USE_TRACE */
+
+/* Cache maintenance of data written or about to be read */
+#if RINGBUFF_USE_CACHE_MAINT
+#define BUF_CACHE_CLEAN(b, p, l)        do { if ((b)->cache_maint) { ringbuff_cache_clean((b), (p), (l)); } } while (0)
+#define BUF_CACHE_INVALIDATE(b, p, l)   do { if ((b)->cache_maint) { ringbuff_cache_invalidate((b), (p), (l)); } } while (0)
+#else
+#define BUF_CACHE_CLEAN(b, p, l)        do {} while (0)
+#define BUF_CACHE_INVALIDATE(b, p, l)   do {} while (0)
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+/*
+ * Statistics, see RINGBUFF_USE_STATS
+ *
+ * - BUF_STATS_WRITE: Data were published by producer
+ * - BUF_STATS_SHORT: Write was shortened or refused, after BUF_STATS_WRITE of the same operation
+ * - BUF_STATS_READ: Data were released by consumer
+ * - BUF_STATS_READ_N: Data of multiple read operations were released by consumer at once
+ */
+#if RINGBUFF_USE_STATS
+#define BUF_STATS_WRITE(b, l)           ringbuff_stats_write((b), (l))
+#define BUF_STATS_SHORT(b)              ringbuff_stats_short((b))
+#define BUF_STATS_READ(b, l)            ringbuff_stats_read((b), (l))
+#define BUF_STATS_READ_N(b, l, n)       ringbuff_stats_read_n((b), (l), (n))
+#else
+#define BUF_STATS_WRITE(b, l)           do {} while (0)
+#define BUF_STATS_SHORT(b)              do {} while (0)
+#define BUF_STATS_READ(b, l)            do {} while (0)
+#define BUF_STATS_READ_N(b, l, n)       do {} while (0)
+#endif /* RINGBUFF_USE_STATS */
+
+/*
+ * Barrier between peer pointer read and data access (acquire)
+ * and between data access and own pointer write (release)
+ */
+#if RINGBUFF_USE_SPSC
+#define BUF_BARRIER()                   RINGBUFF_MEMORY_BARRIER()
+#else
+#define BUF_BARRIER()                   do {} while (0)
+#endif /* RINGBUFF_USE_SPSC */
+
+/*
+ * Pointer arithmetic
+ *
+ * - BUF_IDX: Convert pointer to offset in buffer data array
+ * - BUF_FULL: Number of bytes ready to read for pointers `w` and `r`
+ * - BUF_FREE: Number of bytes free to write for pointers `w` and `r`
+ * - BUF_ADD: Advance pointer for `n` bytes, `n` must not be greater than buffer size
+ */
+#if RINGBUFF_USE_POW2
+#define BUF_IDX(b, i)                   ((i) & ((b)->size - 1))
+#define BUF_FULL(b, w, r)               ((size_t)((w) - (r)))
+#define BUF_FREE(b, w, r)               ((b)->size - BUF_FULL((b), (w), (r)))
+#define BUF_ADD(b, i, n)                ((size_t)((i) + (n)))
+#else
+#define BUF_IDX(b, i)                   (i)
+#define BUF_FULL(b, w, r)               ((w) >= (r) ? (w) - (r) : (b)->size - ((r) - (w)))
+#define BUF_FREE(b, w, r)               ((b)->size - BUF_FULL((b), (w), (r)) - 1)
+#define BUF_ADD(b, i, n)                ((i) + (n) >= (b)->size ? (i) + (n) - (b)->size : (i) + (n))
+#endif /* RINGBUFF_USE_POW2 */
+
+/* Unaligned word access for copy kernel */
+typedef struct {
+    uint32_t v;
+} __attribute__((packed)) prv_uword_t;
 
 /**
- * \brief           Initialize buffer handle to default values with size and buffer data array
+ * \brief           Copy memory, optimized for Cortex-M4 and Cortex-M7 cores
+ *
+ * Destination is first aligned to word boundary with byte copies.
+ * When source has same alignment, bulk of data is copied in `32` bytes bursts,
+ * compiled to `LDM/STM` pairs, or to `LDRD/STRD` when \ref RINGBUFF_MEMCPY_DWORD is enabled.
+ * When alignment differs, source is read with unaligned word loads,
+ * see \ref RINGBUFF_MEMCPY_UNALIGNED
+ *
+ * \param[out]      dst: Destination memory
+ * \param[in]       src: Source memory
+ * \param[in]       len: Number of bytes to copy
+ * \return          `dst` pointer, same as `memcpy`
+ */
+RINGBUFF_HOT void *
+ringbuff_memcpy(void* dst, const void* src, size_t len) {
+    uint8_t* d = dst;
+    const uint8_t* s = src;
+
+    /* Align destination to word */
+    while (len > 0 && ((uintptr_t)d & 0x03) != 0) {
+        *d++ = *s++;
+        --len;
+    }
+
+    if (((uintptr_t)s & 0x03) == 0) {
+#if RINGBUFF_MEMCPY_DWORD
+        uint64_t* d64 = (uint64_t *)d;
+        const uint64_t* s64 = (const uint64_t *)s;
+
+        /* LDRD/STRD only require word alignment */
+        for (; len >= 32; len -= 32, d64 += 4, s64 += 4) {
+            uint64_t a = s64[0], b = s64[1], c = s64[2], e = s64[3];
+            d64[0] = a;
+            d64[1] = b;
+            d64[2] = c;
+            d64[3] = e;
+        }
+        d = (uint8_t *)d64;
+        s = (const uint8_t *)s64;
+#else /* RINGBUFF_MEMCPY_DWORD */
+        uint32_t* d32 = (uint32_t *)d;
+        const uint32_t* s32 = (const uint32_t *)s;
+
+        /* Load all registers before storing to get single LDM/STM pair */
+        for (; len >= 32; len -= 32, d32 += 8, s32 += 8) {
+            uint32_t a = s32[0], b = s32[1], c = s32[2], e = s32[3];
+            uint32_t f = s32[4], g = s32[5], h = s32[6], i = s32[7];
+            d32[0] = a;
+            d32[1] = b;
+            d32[2] = c;
+            d32[3] = e;
+            d32[4] = f;
+            d32[5] = g;
+            d32[6] = h;
+            d32[7] = i;
+        }
+        d = (uint8_t *)d32;
+        s = (const uint8_t *)s32;
+#endif /* !RINGBUFF_MEMCPY_DWORD */
+        for (; len >= 4; len -= 4, d += 4, s += 4) {
+            *(uint32_t *)d = *(const uint32_t *)s;
+        }
+#if RINGBUFF_MEMCPY_UNALIGNED
+    } else {
+        for (; len >= 16; len -= 16, d += 16, s += 16) {
+            uint32_t a = ((const prv_uword_t *)s)[0].v, b = ((const prv_uword_t *)s)[1].v;
+            uint32_t c = ((const prv_uword_t *)s)[2].v, e = ((const prv_uword_t *)s)[3].v;
+            ((uint32_t *)d)[0] = a;
+            ((uint32_t *)d)[1] = b;
+            ((uint32_t *)d)[2] = c;
+            ((uint32_t *)d)[3] = e;
+        }
+        for (; len >= 4; len -= 4, d += 4, s += 4) {
+            *(uint32_t *)d = ((const prv_uword_t *)s)->v;
+        }
+#endif /* RINGBUFF_MEMCPY_UNALIGNED */
+    }
+
+    /* Remaining bytes */
+    while (len > 0) {
+        *d++ = *s++;
+        --len;
+    }
+    return dst;
+}
+
+/**
+ * \brief           Get number of bytes ready to read, using local copy of write pointer.
+ *                  Write pointer is read from shared memory only when local copy
+ *                  does not indicate enough data
+ * \param[in]       buff: Buffer handle
+ * \param[in]       need: Number of bytes caller needs
+ * \return          Number of bytes ready to read
+ */
+static RINGBUFF_HOT size_t
+prv_get_full(RINGBUFF_VOLATILE ringbuff_t* buff, size_t need) {
+    size_t full;
+
+    full = BUF_FULL(buff, buff->w, buff->r);
+    if (full < need) {
+        buff->w = RINGBUFF_PTR_LOAD(buff->shared->w);
+        BUF_BARRIER();
+        full = BUF_FULL(buff, buff->w, buff->r);
+    }
+    return full;
+}
+
+#if RINGBUFF_USE_RATE
+
+/**
+ * \brief           Refill token bucket for time elapsed since last refill.
+ *                  Bucket time advances by whole bytes only, remainder is kept for next refill
+ * \param[in]       buff: Buffer handle, rate limit must be set
+ * \return          Number of tokens, bytes producer may publish now
+ */
+static RINGBUFF_HOT uint32_t
+prv_rate_refill(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    uint32_t now, n;
+
+    now = RINGBUFF_RATE_TIME();
+    n = (now - buff->rate_time) / buff->rate_tpb;
+    if (n >= buff->rate_burst - buff->rate_tokens) {
+        buff->rate_tokens = buff->rate_burst;
+        buff->rate_time = now;
+    } else {
+        buff->rate_tokens += n;
+        buff->rate_time += n * buff->rate_tpb;
+    }
+    return buff->rate_tokens;
+}
+
+#endif /* RINGBUFF_USE_RATE */
+
+/**
+ * \brief           Get number of bytes free to write, using local copy of read pointer.
+ *                  Read pointer is read from shared memory only when local copy
+ *                  does not indicate enough free memory.
+ *                  With \ref RINGBUFF_USE_RATE, free memory is limited to available tokens
+ * \param[in]       buff: Buffer handle
+ * \param[in]       need: Number of bytes caller needs
+ * \return          Number of bytes free to write
+ */
+static RINGBUFF_HOT size_t
+prv_get_free(RINGBUFF_VOLATILE ringbuff_t* buff, size_t need) {
+    size_t free;
+
+    free = BUF_FREE(buff, buff->w, buff->r);
+    if (free < need) {
+        buff->r = RINGBUFF_PTR_LOAD(buff->shared->r);
+        BUF_BARRIER();
+        free = BUF_FREE(buff, buff->w, buff->r);
+    }
+#if RINGBUFF_USE_RATE
+    buff->rate_short = 0;
+    if (buff->rate_tpb > 0 && free > buff->rate_tokens && free > prv_rate_refill(buff)) {
+        buff->rate_short = buff->rate_tokens < need;
+        free = buff->rate_tokens;
+    }
+#endif /* RINGBUFF_USE_RATE */
+    return free;
+}
+
+/**
+ * \brief           Publish new write pointer, once all data before it are written
+ * \param[in]       buff: Buffer handle
+ * \param[in]       w: New write pointer value
+ */
+static RINGBUFF_HOT void
+prv_publish_w(RINGBUFF_VOLATILE ringbuff_t* buff, size_t w) {
+#if RINGBUFF_USE_RATE
+    if (buff->rate_tpb > 0) {
+        size_t len = BUF_FULL(buff, w, buff->w);
+
+        /* Limit may be changed between free memory check and publish */
+        buff->rate_tokens = len < buff->rate_tokens ? buff->rate_tokens - (uint32_t)len : 0;
+    }
+#endif /* RINGBUFF_USE_RATE */
+    BUF_BARRIER();
+    buff->w = w;
+    RINGBUFF_PTR_STORE(buff->shared->w, w);
+}
+
+/**
+ * \brief           Publish new read pointer, once all data before it are read
+ * \param[in]       buff: Buffer handle
+ * \param[in]       r: New read pointer value
+ */
+static RINGBUFF_HOT void
+prv_publish_r(RINGBUFF_VOLATILE ringbuff_t* buff, size_t r) {
+    BUF_BARRIER();
+    buff->r = r;
+    RINGBUFF_PTR_STORE(buff->shared->r, r);
+}
+
+/**
+ * \brief           Copy data to buffer data array, starting at pointer position
+ * \param[in]       buff: Buffer handle
+ * \param[in]       w: Pointer position to start writing at
+ * \param[in]       data: Data to copy
+ * \param[in]       len: Number of bytes to copy, must not exceed free memory
+ */
+static RINGBUFF_HOT void
+prv_copy_to(RINGBUFF_VOLATILE ringbuff_t* buff, size_t w, const void* data, size_t len) {
+    size_t tocopy, off;
+    const uint8_t* d = data;
+
+    /* Step 1: Write data to linear part of buffer */
+    off = BUF_IDX(buff, w);
+    tocopy = BUF_MIN(buff->size - off, len);
+    BUF_MEMCPY(&buff->buff[off], d, tocopy);
+
+    /* Step 2: Write data to beginning of buffer (overflow part) */
+    if (len > tocopy) {
+        BUF_MEMCPY(buff->buff, &d[tocopy], len - tocopy);
+    }
+    BUF_CACHE_CLEAN(buff, w, len);
+}
+
+/**
+ * \brief           Copy data from buffer data array, starting at pointer position
+ * \param[in]       buff: Buffer handle
+ * \param[in]       r: Pointer position to start reading at
+ * \param[out]      data: Output memory to copy data to
+ * \param[in]       len: Number of bytes to copy, must not exceed data in buffer
+ */
+static RINGBUFF_HOT void
+prv_copy_from(RINGBUFF_VOLATILE ringbuff_t* buff, size_t r, void* data, size_t len) {
+    size_t tocopy, off;
+    uint8_t* d = data;
+
+    BUF_CACHE_INVALIDATE(buff, r, len);
+
+    /* Step 1: Read data from linear part of buffer */
+    off = BUF_IDX(buff, r);
+    tocopy = BUF_MIN(buff->size - off, len);
+    BUF_MEMCPY(d, &buff->buff[off], tocopy);
+
+    /* Step 2: Read data from beginning of buffer (overflow part) */
+    if (len > tocopy) {
+        BUF_MEMCPY(&d[tocopy], buff->buff, len - tocopy);
+    }
+}
+
+/**
+ * \brief           Setup buffer handle and attach it to pointers
  * \param[in]       buff: Buffer handle
+ * \param[in]       shared: Pointers structure. Set to `NULL` to use handle local pointers
  * \param[in]       buffdata: Pointer to memory to use as buffer data
  * \param[in]       size: Size of `buffdata` in units of bytes
- *                      Maximum number of bytes buffer can hold is `size - 1`
+ * \param[in]       reset: Set to `1` to reset pointers, `0` to keep their current value
  * \return          `1` on success, `0` otherwise
  */
-uint8_t
-ringbuff_init(RINGBUFF_VOLATILE ringbuff_t* buff, void* buffdata, size_t size) {
+static uint8_t
+prv_init(RINGBUFF_VOLATILE ringbuff_t* buff, RINGBUFF_VOLATILE ringbuff_shared_t* shared,
+            void* buffdata, size_t size, uint8_t reset) {
     if (buff == NULL || buffdata == NULL || size == 0) {
         return 0;
     }
+#if RINGBUFF_USE_POW2
+    if ((size & (size - 1)) != 0) {
+        return 0;
+    }
+#endif /* RINGBUFF_USE_POW2 */
 
     BUF_MEMSET((void *)buff, 0x00, sizeof(*buff));
 
     buff->size = size;
     buff->buff = buffdata;
+    buff->shared = shared != NULL ? shared : &buff->local;
+
+    /* Reset shared pointers or copy current state to local handle */
+    if (reset) {
+        buff->shared->w = 0;
+        buff->shared->r = 0;
+#if RINGBUFF_USE_STATS
+        buff->shared->bytes_in = 0;
+        buff->shared->writes = 0;
+        buff->shared->short_writes = 0;
+        buff->shared->max_full = 0;
+        buff->shared->full_time = 0;
+#if RINGBUFF_USE_RATE
+        buff->shared->rate_limited = 0;
+#endif /* RINGBUFF_USE_RATE */
+        buff->shared->bytes_out = 0;
+        buff->shared->reads = 0;
+#endif /* RINGBUFF_USE_STATS */
+#if RINGBUFF_USE_MSG_SEQ
+        buff->shared->msg_seq = 0;
+        buff->shared->msg_seq_next = 0;
+        buff->shared->msg_gaps = 0;
+        buff->shared->msg_lost = 0;
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+        buff->shared->msg_crc_errors = 0;
+#endif /* RINGBUFF_USE_MSG_CRC */
+    }
+    buff->w = buff->shared->w;
+    buff->r = buff->shared->r;
 
 #if RINGBUFF_USE_MAGIC
     buff->magic1 = 0xDEADBEEF;
     buff->magic2 = ~0xDEADBEEF;
 #endif /* RINGBUFF_USE_MAGIC */
 
-    return 1;
+    return 1;
+}
+
+/**
+ * \brief           Initialize buffer handle to default values with size and buffer data array
+ *
+ * Read and write pointers are stored in handle itself,
+ * use \ref ringbuff_init_shared for buffer shared between cores
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes
+ *                      Maximum number of bytes buffer can hold is `size - 1`,
+ *                      or `size` when \ref RINGBUFF_USE_POW2 is enabled.
+ *                      Size must be power of `2` when \ref RINGBUFF_USE_POW2 is enabled
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_init(RINGBUFF_VOLATILE ringbuff_t* buff, void* buffdata, size_t size) {
+    return prv_init(buff, NULL, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local buffer handle with pointers in shared memory
+ *                  and reset pointers to empty buffer.
+ *
+ * Called once by core that owns shared memory, before other core attaches with \ref ringbuff_attach
+ *
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes, see \ref ringbuff_init
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_init_shared(RINGBUFF_VOLATILE ringbuff_t* buff, RINGBUFF_VOLATILE ringbuff_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local buffer handle with pointers in shared memory,
+ *                  previously initialized by other core with \ref ringbuff_init_shared
+ *
+ * Pointers are not modified, their current values are copied to local handle
+ *
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes, see \ref ringbuff_init
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_attach(RINGBUFF_VOLATILE ringbuff_t* buff, RINGBUFF_VOLATILE ringbuff_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 0);
+}
+
+/**
+ * \brief           Check if ringbuff is initialized and ready to use.
+ *                  Magic words are validated also when \ref RINGBUFF_USE_MAGIC_CHECK is disabled
+ * \param[in]       buff: Buffer handle
+ * \return          `1` if ready, `0` otherwise
+ */
+uint8_t
+ringbuff_is_ready(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    return BUF_IS_INTACT(buff);
+}
+
+/**
+ * \brief           Free buffer memory
+ * \note            Since implementation does not use dynamic allocation,
+ *                  it just sets buffer handle to `NULL`
+ * \param[in]       buff: Buffer handle
+ */
+void
+ringbuff_free(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    if (BUF_IS_VALID(buff)) {
+        buff->buff = NULL;
+    }
+}
+
+/**
+ * \brief           Set event function callback for different buffer operations
+ *
+ * Callback is kept in core-local handle and called only for operations
+ * done through this handle, by the core that owns it.
+ * Handle of other core attached to the same buffer has its own callback, or none,
+ * and operations of other core are not reported here.
+ * Shared memory holds no function pointers, see \ref ringbuff_shared_t.
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       evt_fn: Callback function, in address space of current core
+ */
+void
+ringbuff_set_evt_fn(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_evt_fn evt_fn) {
+    if (BUF_IS_VALID(buff)) {
+        buff->evt_fn = evt_fn;
+    }
+}
+
+/**
+ * \brief           Set custom user argument, for example to access
+ *                  application context from event callback
+ * \param[in]       buff: Buffer handle
+ * \param[in]       arg: User argument
+ */
+void
+ringbuff_set_arg(RINGBUFF_VOLATILE ringbuff_t* buff, void* arg) {
+    if (BUF_IS_VALID(buff)) {
+        buff->arg = arg;
+    }
+}
+
+#if RINGBUFF_USE_TRACE
+
+/**
+ * \brief           Set buffer ID reported with trace events, see \ref RINGBUFF_USE_TRACE.
+ *                  Handles of both cores attached to the same buffer should use the same ID
+ * \param[in]       buff: Buffer handle
+ * \param[in]       id: Trace ID, `0` after init
+ */
+void
+ringbuff_set_trace_id(RINGBUFF_VOLATILE ringbuff_t* buff, uint8_t id) {
+    if (BUF_IS_VALID(buff)) {
+        buff->trace_id = id;
+    }
+}
+
+#endif /* RINGBUFF_USE_TRACE */
+
+#if RINGBUFF_USE_RATE
+
+/**
+ * \brief           Set token-bucket rate limit of producer, see \ref RINGBUFF_USE_RATE.
+ *                  Bucket starts full. Set on producer handle, limit is not shared with other core
+ * \param[in]       buff: Buffer handle
+ * \param[in]       rate: Average rate in units of bytes per second, `0` to disable limit.
+ *                      Resolution is one tick of \ref RINGBUFF_RATE_TIME per byte
+ * \param[in]       burst: Maximum number of bytes published at once, at least length of largest message
+ *                      including its header, otherwise message is never sent
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_set_rate(RINGBUFF_VOLATILE ringbuff_t* buff, uint32_t rate, uint32_t burst) {
+    if (!BUF_IS_VALID(buff) || (rate > 0 && burst == 0)) {
+        return 0;
+    }
+    buff->rate_tpb = 0;
+    if (rate > 0) {
+        buff->rate_burst = burst;
+        buff->rate_tokens = burst;
+        buff->rate_time = RINGBUFF_RATE_TIME();
+        buff->rate_tpb = BUF_MAX(RINGBUFF_RATE_TIME_HZ() / rate, 1);
+    }
+    buff->rate_short = 0;
+    return 1;
+}
+
+/**
+ * \brief           Get number of bytes producer may publish now under rate limit
+ * \param[in]       buff: Buffer handle
+ * \return          Number of tokens, `UINT32_MAX` when not limited
+ */
+uint32_t
+ringbuff_get_tokens(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
+    }
+    return buff->rate_tpb > 0 ? prv_rate_refill(buff) : UINT32_MAX;
+}
+
+#endif /* RINGBUFF_USE_RATE */
+
+/**
+ * \brief           Get custom user argument, previously set with \ref ringbuff_set_arg
+ * \param[in]       buff: Buffer handle
+ * \return          User argument, `NULL` if not set or buffer is not valid
+ */
+void *
+ringbuff_get_arg(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    return BUF_IS_VALID(buff) ? buff->arg : NULL;
+}
+
+#if RINGBUFF_USE_CACHE_MAINT
+
+/**
+ * \brief           Clean or invalidate cache lines covering linear memory block
+ * \param[in]       addr: Block start address
+ * \param[in]       len: Block length in units of bytes
+ * \param[in]       clean: Set to `1` to clean, `0` to invalidate
+ */
+static RINGBUFF_HOT void
+prv_cache_lines(const uint8_t* addr, size_t len, uint8_t clean) {
+    uintptr_t start, end;
+
+    start = (uintptr_t)addr & ~(uintptr_t)(RINGBUFF_CACHE_LINE_SIZE - 1);
+    end = ((uintptr_t)addr + len + RINGBUFF_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(RINGBUFF_CACHE_LINE_SIZE - 1);
+    if (clean) {
+        RINGBUFF_CACHE_CLEAN(start, end - start);
+    } else {
+        RINGBUFF_CACHE_INVALIDATE(start, end - start);
+    }
+}
+
+/**
+ * \brief           Clean or invalidate cache lines covering data, starting at pointer position
+ * \param[in]       buff: Buffer handle
+ * \param[in]       ptr: Pointer position of first byte
+ * \param[in]       len: Number of bytes, not greater than buffer size
+ * \param[in]       clean: Set to `1` to clean, `0` to invalidate
+ */
+static RINGBUFF_HOT void
+prv_cache_maint(RINGBUFF_VOLATILE ringbuff_t* buff, size_t ptr, size_t len, uint8_t clean) {
+    size_t off, lin;
+
+    if (len == 0) {
+        return;
+    }
+    off = BUF_IDX(buff, ptr);
+    lin = BUF_MIN(buff->size - off, len);
+    prv_cache_lines(&buff->buff[off], lin, clean);
+    if (len > lin) {
+        prv_cache_lines(buff->buff, len - lin, clean);
+    }
+}
+
+/**
+ * \brief           Enable or disable D-cache maintenance of data array
+ *
+ * Enable on both producer and consumer handle of core,
+ * where data array is mapped as cacheable memory
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       en: Set to `1` to enable, `0` to disable
+ * \return          `1` on success, `0` if data array is not aligned to cache lines
+ */
+uint8_t
+ringbuff_set_cache_maint(RINGBUFF_VOLATILE ringbuff_t* buff, uint8_t en) {
+    if (!BUF_IS_VALID(buff)
+        || (en && (((uintptr_t)buff->buff | buff->size) & (RINGBUFF_CACHE_LINE_SIZE - 1)) != 0)) {
+        return 0;
+    }
+    buff->cache_maint = en ? 1 : 0;
+    return 1;
+}
+
+/**
+ * \brief           Clean cache lines of data written by producer, before write pointer is published.
+ *                  Used by functions that write data, call only when maintenance is enabled
+ * \param[in]       buff: Buffer handle
+ * \param[in]       ptr: Pointer position of first written byte
+ * \param[in]       len: Number of written bytes
+ */
+RINGBUFF_HOT void
+ringbuff_cache_clean(RINGBUFF_VOLATILE ringbuff_t* buff, size_t ptr, size_t len) {
+    prv_cache_maint(buff, ptr, len, 1);
+}
+
+/**
+ * \brief           Invalidate cache lines of data, before consumer reads them.
+ *                  Used by functions that read data, call only when maintenance is enabled
+ * \param[in]       buff: Buffer handle
+ * \param[in]       ptr: Pointer position of first byte to read
+ * \param[in]       len: Number of bytes to read
+ */
+RINGBUFF_HOT void
+ringbuff_cache_invalidate(RINGBUFF_VOLATILE ringbuff_t* buff, size_t ptr, size_t len) {
+    prv_cache_maint(buff, ptr, len, 0);
+}
+
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+#if RINGBUFF_USE_STATS
+
+/**
+ * \brief           Get statistics snapshot.
+ *                  Can be called by producer, consumer, or any other core with handle attached to same pointers
+ * \param[in]       buff: Buffer handle
+ * \param[out]      stats: Output statistics.
+ *                      Producer and consumer counters are updated independently,
+ *                      `bytes_in` and `bytes_out` may differ by data in transit
+ */
+void
+ringbuff_get_stats(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_stats_t* stats) {
+    RINGBUFF_VOLATILE ringbuff_shared_t* shared;
+
+    if (!BUF_IS_VALID(buff) || stats == NULL) {
+        return;
+    }
+    shared = buff->shared;
+    stats->bytes_in = shared->bytes_in;
+    stats->bytes_out = shared->bytes_out;
+    stats->writes = shared->writes;
+    stats->reads = shared->reads;
+    stats->short_writes = shared->short_writes;
+    stats->max_full = shared->max_full;
+    stats->full_time = shared->full_time;
+#if RINGBUFF_USE_RATE
+    stats->rate_limited = shared->rate_limited;
+#endif /* RINGBUFF_USE_RATE */
+#if RINGBUFF_USE_MSG_SEQ
+    stats->msg_gaps = shared->msg_gaps;
+    stats->msg_lost = shared->msg_lost;
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+    stats->msg_crc_errors = shared->msg_crc_errors;
+#endif /* RINGBUFF_USE_MSG_CRC */
+}
+
+/**
+ * \brief           Update producer statistics after data were published.
+ *                  Used by functions that write data.
+ *                  Ends period of full buffer, started by \ref ringbuff_stats_short
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes published
+ */
+RINGBUFF_HOT void
+ringbuff_stats_write(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    RINGBUFF_VOLATILE ringbuff_shared_t* shared = buff->shared;
+    size_t full;
+
+    shared->bytes_in += (uint32_t)len;
+    ++shared->writes;
+
+    /* Fill level against actual read pointer, shadow copy may be old */
+    full = BUF_FULL(buff, buff->w, shared->r);
+    if (full > shared->max_full) {
+        shared->max_full = (uint32_t)full;
+    }
+    if (buff->full) {
+        buff->full = 0;
+        shared->full_time += (uint32_t)(RINGBUFF_STATS_TIME() - buff->full_start);
+    }
+}
+
+/**
+ * \brief           Update producer statistics after write was shortened or refused for lack of free memory.
+ *                  Used by functions that write data, after \ref ringbuff_stats_write of the same operation.
+ *                  Starts period of full buffer, unless already started.
+ *                  Write limited by tokens of \ref RINGBUFF_USE_RATE is counted as `rate_limited` only
+ * \param[in]       buff: Buffer handle
+ */
+RINGBUFF_HOT void
+ringbuff_stats_short(RINGBUFF_VOLATILE ringbuff_t* buff) {
+#if RINGBUFF_USE_RATE
+    if (buff->rate_short) {
+        buff->rate_short = 0;
+        ++buff->shared->rate_limited;
+        return;
+    }
+#endif /* RINGBUFF_USE_RATE */
+    ++buff->shared->short_writes;
+    if (!buff->full) {
+        buff->full = 1;
+        buff->full_start = RINGBUFF_STATS_TIME();
+    }
+}
+
+/**
+ * \brief           Update consumer statistics after read operation.
+ *                  Used by functions that read data
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes released
+ */
+RINGBUFF_HOT void
+ringbuff_stats_read(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    ringbuff_stats_read_n(buff, len, 1);
+}
+
+/**
+ * \brief           Update consumer statistics after multiple read operations, released at once
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes released
+ * \param[in]       count: Number of read operations, for example messages, released
+ */
+RINGBUFF_HOT void
+ringbuff_stats_read_n(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len, size_t count) {
+    buff->shared->bytes_out += (uint32_t)len;
+    buff->shared->reads += (uint32_t)count;
+}
+
+#endif /* RINGBUFF_USE_STATS */
+
+/**
+ * \brief           Write data to buffer.
+ * Copies data from `data` array to buffer and marks buffer as full for maximum `btw` number of bytes
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       data: Pointer to data to write into buffer
+ * \param[in]       btw: Number of bytes to write
+ * \return          Number of bytes written to buffer.
+ *                      When returned value is less than `btw`, there was no enough memory available
+ *                      to copy full data array
+ */
+RINGBUFF_HOT size_t
+ringbuff_write(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw) {
+    size_t free, len;
+
+    if (!BUF_IS_VALID(buff) || data == NULL || btw == 0) {
+        return 0;
+    }
+
+    /* Calculate maximum number of bytes available to write */
+    free = prv_get_free(buff, btw);
+    if (free == 0) {
+        BUF_STATS_SHORT(buff);
+        return 0;
+    }
+
+    /* Copy data, with possible overflow to beginning of buffer */
+    len = BUF_MIN(free, btw);
+    prv_copy_to(buff, buff->w, data, len);
+
+    /* Publish write pointer once data are written */
+    prv_publish_w(buff, BUF_ADD(buff, buff->w, len));
+    BUF_STATS_WRITE(buff, len);
+    if (len < btw) {
+        BUF_STATS_SHORT(buff);
+    }
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_WRITE, len);
+    return len;
+}
+
+/**
+ * \brief           Write data fragments as single block, all or nothing
+ * \param[in]       buff: Buffer handle
+ * \param[in]       iov: Array of data fragments
+ * \param[in]       iovcnt: Number of entries in `iov` array
+ * \param[in]       total: Total length of all fragments, greater than `0`
+ * \return          `total` when written, \ref RINGBUFF_WOULD_BLOCK if there is not enough memory for all fragments
+ */
+static RINGBUFF_HOT size_t
+prv_write_all(RINGBUFF_VOLATILE ringbuff_t* buff, const ringbuff_iovec_t* iov, size_t iovcnt, size_t total) {
+    size_t w;
+
+    if (prv_get_free(buff, total) < total) {
+        BUF_STATS_SHORT(buff);
+        return RINGBUFF_WOULD_BLOCK;
+    }
+
+    /* Copy all fragments, one after another */
+    w = buff->w;
+    for (size_t i = 0; i < iovcnt; ++i) {
+        if (iov[i].len > 0) {
+            prv_copy_to(buff, w, iov[i].data, iov[i].len);
+            w = BUF_ADD(buff, w, iov[i].len);
+        }
+    }
+
+    /* Publish write pointer once all data are written */
+    prv_publish_w(buff, w);
+    BUF_STATS_WRITE(buff, total);
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_WRITE, total);
+    return total;
+}
+
+/**
+ * \brief           Write all data to buffer or nothing.
+ *
+ * Unlike \ref ringbuff_write, data are never truncated to free memory,
+ * stream consumer never sees partial frame it would have to resynchronize on
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       data: Pointer to data to write into buffer
+ * \param[in]       btw: Number of bytes to write
+ * \return          `btw` when written, \ref RINGBUFF_WOULD_BLOCK if there is not enough free memory
+ *                      for all data, `0` on invalid parameters
+ */
+RINGBUFF_HOT size_t
+ringbuff_write_all(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw) {
+    ringbuff_iovec_t iov;
+
+    if (!BUF_IS_VALID(buff) || data == NULL || btw == 0) {
+        return 0;
+    }
+    iov.data = data;
+    iov.len = btw;
+    return prv_write_all(buff, &iov, 1, btw);
+}
+
+/**
+ * \brief           Write multiple data fragments to buffer as single block.
+ *
+ * Free memory is checked once for total length of all fragments
+ * and write pointer is published once, after all fragments are copied.
+ * Consumer sees either all fragments or none of them, same as \ref ringbuff_write_all.
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       iov: Array of data fragments
+ * \param[in]       iovcnt: Number of entries in `iov` array
+ * \return          Total number of bytes written, or `0` if there is not enough memory for all fragments
+ */
+RINGBUFF_HOT size_t
+ringbuff_writev(RINGBUFF_VOLATILE ringbuff_t* buff, const ringbuff_iovec_t* iov, size_t iovcnt) {
+    size_t total = 0;
+
+    if (!BUF_IS_VALID(buff) || iov == NULL || iovcnt == 0) {
+        return 0;
+    }
+
+    /* Calculate total length and check if all fragments fit */
+    for (size_t i = 0; i < iovcnt; ++i) {
+        total += iov[i].len;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    total = prv_write_all(buff, iov, iovcnt, total);
+    return total == RINGBUFF_WOULD_BLOCK ? 0 : total;
+}
+
+/**
+ * \brief           Read data from buffer.
+ * Copies data from buffer to `data` array and marks buffer as free for maximum `btr` number of bytes
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[out]      data: Pointer to output memory to copy buffer data to
+ * \param[in]       btr: Number of bytes to read
+ * \return          Number of bytes read and copied to data array
+ */
+RINGBUFF_HOT size_t
+ringbuff_read(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t btr) {
+    size_t full;
+
+    if (!BUF_IS_VALID(buff) || data == NULL || btr == 0) {
+        return 0;
+    }
+
+    /* Calculate maximum number of bytes available to read */
+    full = prv_get_full(buff, btr);
+    btr = BUF_MIN(full, btr);
+    if (btr == 0) {
+        return 0;
+    }
+
+    /* Copy data, with possible overflow from beginning of buffer */
+    prv_copy_from(buff, buff->r, data, btr);
+
+    /* Publish read pointer once data are read */
+    prv_publish_r(buff, BUF_ADD(buff, buff->r, btr));
+    BUF_STATS_READ(buff, btr);
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_READ, btr);
+    return btr;
+}
+
+/**
+ * \brief           Read from buffer without changing read pointer (peek only)
+ * \param[in]       buff: Buffer handle
+ * \param[in]       skip_count: Number of bytes to skip before reading data
+ * \param[out]      data: Pointer to output memory to copy buffer data to
+ * \param[in]       btp: Number of bytes to peek
+ * \return          Number of bytes peeked and written to output array
+ */
+RINGBUFF_HOT size_t
+ringbuff_peek(RINGBUFF_VOLATILE ringbuff_t* buff, size_t skip_count, void* data, size_t btp) {
+    size_t full;
+
+    if (!BUF_IS_VALID(buff) || data == NULL || btp == 0) {
+        return 0;
+    }
+
+    /* Calculate maximum number of bytes available to read */
+    full = prv_get_full(buff, skip_count + btp);
+
+    /* Skip beginning of buffer */
+    if (skip_count >= full) {
+        return 0;
+    }
+    full -= skip_count;
+
+    /* Check maximum number of bytes available to read after skip */
+    btp = BUF_MIN(full, btp);
+
+    /* Copy data, with possible overflow from beginning of buffer */
+    prv_copy_from(buff, BUF_ADD(buff, buff->r, skip_count), data, btp);
+    return btp;
+}
+
+/**
+ * \brief           Move data from one buffer to another, without intermediate buffer.
+ *
+ * Data are copied directly from read part of `src` to write part of `dst`,
+ * up to `2` segments on each side. `dst` write pointer is published once after copy,
+ * `src` read pointer is published once afterwards. Caller is consumer of `src` and producer of `dst`
+ *
+ * \param[in]       dst: Destination buffer handle
+ * \param[in]       src: Source buffer handle
+ * \param[in]       len: Maximum number of bytes to move
+ * \return          Number of bytes moved, minimum of `len`, data in `src` and free memory in `dst`.
+ *                      It can be less than `len` and less than data in `src`,
+ *                      bytes not moved stay in `src` for next call.
+ *                      Transfer shortened by free memory in `dst` is counted as short write of `dst`
+ */
+RINGBUFF_HOT size_t
+ringbuff_splice(RINGBUFF_VOLATILE ringbuff_t* dst, RINGBUFF_VOLATILE ringbuff_t* src, size_t len) {
+    size_t done, s_off, d_off, tocopy, free;
+    uint8_t short_write;
+
+    if (!BUF_IS_VALID(dst) || !BUF_IS_VALID(src) || dst == src || len == 0) {
+        return 0;
+    }
+
+    len = BUF_MIN(len, prv_get_full(src, len));
+    if (len == 0) {
+        return 0;
+    }
+    free = prv_get_free(dst, len);
+    if (free == 0) {
+        BUF_STATS_SHORT(dst);
+        return 0;
+    }
+    short_write = free < len;
+    len = BUF_MIN(len, free);
+
+    /* Copy in linear pieces, each ends at end of source or destination data array */
+    BUF_CACHE_INVALIDATE(src, src->r, len);
+    for (done = 0; done < len; done += tocopy) {
+        s_off = BUF_IDX(src, BUF_ADD(src, src->r, done));
+        d_off = BUF_IDX(dst, BUF_ADD(dst, dst->w, done));
+        tocopy = BUF_MIN(len - done, BUF_MIN(src->size - s_off, dst->size - d_off));
+        BUF_MEMCPY(&dst->buff[d_off], &src->buff[s_off], tocopy);
+    }
+    BUF_CACHE_CLEAN(dst, dst->w, len);
+
+    /* Data become visible in destination before they are released in source */
+    prv_publish_w(dst, BUF_ADD(dst, dst->w, len));
+    BUF_STATS_WRITE(dst, len);
+    if (short_write) {
+        BUF_STATS_SHORT(dst);
+    }
+    BUF_SEND_EVT(dst, RINGBUFF_EVT_WRITE, len);
+    prv_publish_r(src, BUF_ADD(src, src->r, len));
+    BUF_STATS_READ(src, len);
+    BUF_SEND_EVT(src, RINGBUFF_EVT_READ, len);
+    return len;
+}
+
+/**
+ * \brief           Find first occurrence of byte in linear memory, one word at a time
+ * \param[in]       p: Memory to search
+ * \param[in]       c: Byte to find
+ * \param[in]       len: Number of bytes to search
+ * \return          Index of first occurrence, `len` if not found
+ */
+static RINGBUFF_HOT size_t
+prv_find_byte(const uint8_t* p, uint8_t c, size_t len) {
+    const uint32_t pat = 0x01010101UL * c;
+    size_t i = 0;
+    uint32_t v;
+
+    /* Head, until word aligned */
+    for (; i < len && ((uintptr_t)&p[i] & 0x03) != 0; ++i) {
+        if (p[i] == c) {
+            return i;
+        }
+    }
+
+    /* Word contains `c` when XOR with pattern has zero byte */
+    for (; i + 4 <= len; i += 4) {
+        v = *(const uint32_t *)&p[i] ^ pat;
+        if (((v - 0x01010101UL) & ~v & 0x80808080UL) != 0) {
+            break;                              /* Exact byte is found below */
+        }
+    }
+
+    /* Tail and matching word */
+    for (; i < len; ++i) {
+        if (p[i] == c) {
+            return i;
+        }
+    }
+    return len;
+}
+
+/**
+ * \brief           Find byte sequence in buffer, without reading it out.
+ *
+ * Search covers both parts of data, at end and at beginning of data array.
+ * First byte of sequence is searched one word at a time, candidates are then compared in full
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       bts: Byte sequence to find, for example delimiter `"\r\n"`
+ * \param[in]       len: Length of sequence in units of bytes
+ * \param[in]       start_offset: Offset from read pointer to start search at,
+ *                      for example number of bytes searched before minus `len - 1`
+ * \param[out]      found_idx: Offset of first byte of sequence from read pointer, set when found
+ * \return          `1` if found, `0` otherwise
+ */
+RINGBUFF_HOT uint8_t
+ringbuff_find(RINGBUFF_VOLATILE ringbuff_t* buff, const void* bts, size_t len, size_t start_offset, size_t* found_idx) {
+    const uint8_t* b = bts;
+    size_t full, off, idx, lin, n, i, k;
+
+    if (!BUF_IS_VALID(buff) || bts == NULL || len == 0 || found_idx == NULL) {
+        return 0;
+    }
+
+    full = prv_get_full(buff, buff->size);      /* Always refresh, whole content is searched */
+    if (full < len || start_offset > full - len) {
+        return 0;
+    }
+    BUF_CACHE_INVALIDATE(buff, BUF_ADD(buff, buff->r, start_offset), full - start_offset);
+
+    for (off = start_offset; off <= full - len; ) {
+        /* Candidates for first byte in linear part */
+        idx = BUF_IDX(buff, BUF_ADD(buff, buff->r, off));
+        lin = BUF_MIN(buff->size - idx, full - len + 1 - off);
+        n = prv_find_byte(&buff->buff[idx], b[0], lin);
+        off += n;
+        if (n == lin) {
+            continue;
+        }
+
+        /* Compare rest of sequence, it may continue at beginning of data array */
+        for (i = 1, k = idx + n + 1; i < len; ++i, ++k) {
+            if (k == buff->size) {
+                k = 0;
+            }
+            if (buff->buff[k] != b[i]) {
+                break;
+            }
+        }
+        if (i == len) {
+            *found_idx = off;
+            return 1;
+        }
+        ++off;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Get available size in buffer for write operation
+ * \param[in]       buff: Buffer handle
+ * \return          Number of free bytes in memory
+ */
+RINGBUFF_HOT size_t
+ringbuff_get_free(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    size_t w, r;
+
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
+    }
+
+    /*
+     * Use temporary values in case they are changed during operations.
+     * Both are read from shared memory, so that function may be used by either side
+     */
+    w = RINGBUFF_PTR_LOAD(buff->shared->w);
+    r = RINGBUFF_PTR_LOAD(buff->shared->r);
+    BUF_BARRIER();
+    return BUF_FREE(buff, w, r);
+}
+
+/**
+ * \brief           Get number of bytes currently available in buffer
+ * \param[in]       buff: Buffer handle
+ * \return          Number of bytes ready to be read
+ */
+RINGBUFF_HOT size_t
+ringbuff_get_full(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    size_t w, r;
+
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
+    }
+
+    /*
+     * Use temporary values in case they are changed during operations.
+     * Both are read from shared memory, so that function may be used by either side
+     */
+    w = RINGBUFF_PTR_LOAD(buff->shared->w);
+    r = RINGBUFF_PTR_LOAD(buff->shared->r);
+    BUF_BARRIER();
+    return BUF_FULL(buff, w, r);
+}
+
+/**
+ * \brief           Resets buffer to default values. Buffer size is not modified
+ * \note            Function modifies read and write pointers,
+ *                  it shall not be called while peer core is using the buffer
+ * \param[in]       buff: Buffer handle
+ */
+void
+ringbuff_reset(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    if (BUF_IS_VALID(buff)) {
+        buff->w = 0;
+        buff->r = 0;
+        buff->shared->w = 0;
+        buff->shared->r = 0;
+        BUF_SEND_EVT(buff, RINGBUFF_EVT_RESET, 0);
+    }
+}
+
+/**
+ * \brief           Get linear address for buffer for fast read
+ * \param[in]       buff: Buffer handle
+ * \return          Linear buffer start address
+ */
+RINGBUFF_HOT void *
+ringbuff_get_linear_block_read_address(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    if (!BUF_IS_VALID(buff)) {
+        return NULL;
+    }
+    return &buff->buff[BUF_IDX(buff, buff->r)];
+}
+
+/**
+ * \brief           Get length of linear block address before it overflows for read operation
+ * \param[in]       buff: Buffer handle
+ * \return          Linear buffer size in units of bytes for read operation
+ */
+RINGBUFF_HOT size_t
+ringbuff_get_linear_block_read_length(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    size_t full;
+
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
+    }
+
+    /* Data are linear up to write pointer or until end of buffer */
+    full = prv_get_full(buff, 1);
+    full = BUF_MIN(full, buff->size - BUF_IDX(buff, buff->r));
+    BUF_CACHE_INVALIDATE(buff, buff->r, full);
+    return full;
+}
+
+/**
+ * \brief           Skip (ignore; advance read pointer) buffer data
+ * Marks data as read in the buffer and increases free memory for up to `len` bytes
+ *
+ * \note            Useful at the end of streaming transfer such as DMA
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes to skip and mark as read
+ * \return          Number of bytes skipped
+ */
+RINGBUFF_HOT size_t
+ringbuff_skip(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    if (!BUF_IS_VALID(buff) || len == 0) {
+        return 0;
+    }
+
+    len = BUF_MIN(len, prv_get_full(buff, len));/* Calculate max skip */
+    if (len == 0) {
+        return 0;
+    }
+    prv_publish_r(buff, BUF_ADD(buff, buff->r, len));   /* Advance read pointer */
+    BUF_STATS_READ(buff, len);
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_READ, len);
+    return len;
+}
+
+/**
+ * \brief           Get all data ready to read as up to 2 linear blocks, from single pointers snapshot
+ *
+ * First block starts at read pointer, second block (when data overflow)
+ * starts at the beginning of buffer. Data remain in buffer
+ * until released with \ref ringbuff_read_release
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[out]      ptr1: Output pointer to first block address
+ * \param[out]      len1: Output pointer to first block length
+ * \param[out]      ptr2: Output pointer to second block address. Set to `NULL` when not used
+ * \param[out]      len2: Output pointer to second block length. Set to `0` when not used
+ * \return          Total number of bytes in both blocks
+ */
+RINGBUFF_HOT size_t
+ringbuff_read_acquire(RINGBUFF_VOLATILE ringbuff_t* buff, void** ptr1, size_t* len1, void** ptr2, size_t* len2) {
+    size_t full, off;
+
+    if (!BUF_IS_VALID(buff) || ptr1 == NULL || len1 == NULL || ptr2 == NULL || len2 == NULL) {
+        return 0;
+    }
+
+    /* Request full buffer to refresh write pointer, unless local copy already indicates full buffer */
+    full = prv_get_full(buff, buff->size);
+    off = BUF_IDX(buff, buff->r);
+
+    *ptr1 = &buff->buff[off];
+    *len1 = BUF_MIN(full, buff->size - off);
+    *len2 = full - *len1;
+    *ptr2 = *len2 > 0 ? buff->buff : NULL;
+    BUF_CACHE_INVALIDATE(buff, buff->r, full);
+    return full;
 }
 
 /**
- * \brief           Check if ringbuff is initialized and ready to use
+ * \brief           Release data, previously acquired with \ref ringbuff_read_acquire
  * \param[in]       buff: Buffer handle
- * \return          `1` if ready, `0` otherwise
+ * \param[in]       len: Number of bytes to release, up to value returned by acquire function
+ * \return          Number of bytes released
  */
-uint8_t
-ringbuff_is_ready(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    return BUF_IS_VALID(buff);
+RINGBUFF_HOT size_t
+ringbuff_read_release(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    return ringbuff_skip(buff, len);
 }
 
 /**
- * \brief           Free buffer memory
- * \note            Since implementation does not use dynamic allocation,
- *                  it just sets buffer handle to `NULL`
+ * \brief           Get linear address for buffer for fast read
  * \param[in]       buff: Buffer handle
+ * \return          Linear buffer start address
  */
-void
-ringbuff_free(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    if (BUF_IS_VALID(buff)) {
-        buff->buff = NULL;
+RINGBUFF_HOT void *
+ringbuff_get_linear_block_write_address(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    if (!BUF_IS_VALID(buff)) {
+        return NULL;
     }
+    return &buff->buff[BUF_IDX(buff, buff->w)];
 }
 
 /**
- * \brief           Set event function callback for different buffer operations
+ * \brief           Get length of linear block address before it overflows for write operation
  * \param[in]       buff: Buffer handle
- * \param[in]       evt_fn: Callback function
+ * \return          Linear buffer size in units of bytes for write operation
  */
-void
-ringbuff_set_evt_fn(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_evt_fn evt_fn) {
-    if (BUF_IS_VALID(buff)) {
-        buff->evt_fn = evt_fn;
+RINGBUFF_HOT size_t
+ringbuff_get_linear_block_write_length(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    size_t free;
+
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
     }
+
+    /*
+     * Free memory is linear up to read pointer or until end of buffer.
+     * When read pointer is at the beginning, free size already
+     * leaves one byte unused in non power-of-2 mode,
+     * otherwise buffer would be considered empty again (r == w)
+     */
+    free = prv_get_free(buff, 1);
+    return BUF_MIN(free, buff->size - BUF_IDX(buff, buff->w));
 }
 
 /**
- * \brief           Write data to buffer.
- * Copies data from `data` array to buffer and marks buffer as full for maximum `btw` number of bytes
+ * \brief           Advance write pointer in the buffer.
+ * Similar to skip function but modifies write pointer instead of read
  *
+ * \note            Useful when hardware is writing to buffer and application needs to increase number
+ *                      of bytes written to buffer by hardware
  * \param[in]       buff: Buffer handle
- * \param[in]       data: Pointer to data to write into buffer
- * \param[in]       btw: Number of bytes to write
- * \return          Number of bytes written to buffer.
- *                      When returned value is less than `btw`, there was no enough memory available
- *                      to copy full data array
+ * \param[in]       len: Number of bytes to advance
+ * \return          Number of bytes advanced for write operation
  */
-size_t
-ringbuff_write(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw) {
-    size_t tocopy, free;
-    const uint8_t* d = data;
-
-    if (!BUF_IS_VALID(buff) || data == NULL || btw == 0) {
+RINGBUFF_HOT size_t
+ringbuff_advance(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    if (!BUF_IS_VALID(buff) || len == 0) {
         return 0;
     }
 
-    /* Calculate maximum number of bytes available to write */
-    free = ringbuff_get_free(buff);
-    btw = BUF_MIN(free, btw);
-    if (btw == 0) {
+    len = BUF_MIN(len, prv_get_free(buff, len));/* Calculate max advance */
+    if (len == 0) {
         return 0;
     }
+    BUF_CACHE_CLEAN(buff, buff->w, len);        /* Data written by application */
+    prv_publish_w(buff, BUF_ADD(buff, buff->w, len));   /* Advance write pointer */
+    BUF_STATS_WRITE(buff, len);
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_WRITE, len);
+    return len;
+}
 
-    /* Step 1: Write data to linear part of buffer */
-    tocopy = BUF_MIN(buff->size - buff->w, btw);
-    BUF_MEMCPY(&buff->buff[buff->w], d, tocopy);
-    buff->w += tocopy;
-    btw -= tocopy;
+/**
+ * \brief           Reserve contiguous block of memory for zero-copy write operation
+ *
+ * Application writes data directly to returned memory
+ * and publishes them with \ref ringbuff_write_commit afterwards.
+ *
+ * \note            Reservation is not split between end and beginning of buffer.
+ *                  When there is not enough linear memory until end of buffer,
+ *                  function fails even if total free memory is sufficient
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes to reserve
+ * \return          Pointer to linear memory of at least `len` bytes, or `NULL` if not available
+ */
+RINGBUFF_HOT void *
+ringbuff_write_reserve(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    size_t off;
 
-    /* Step 2: Write data to beginning of buffer (overflow part) */
-    if (btw > 0) {
-        BUF_MEMCPY(buff->buff, &d[tocopy], btw);
-        buff->w = btw;
+    if (!BUF_IS_VALID(buff) || len == 0) {
+        return NULL;
     }
 
-    /* Step 3: Check end of buffer */
-    if (buff->w >= buff->size) {
-        buff->w = 0;
+    off = BUF_IDX(buff, buff->w);
+    if (buff->size - off < len || prv_get_free(buff, len) < len) {
+        BUF_STATS_SHORT(buff);
+        return NULL;
     }
-    BUF_SEND_EVT(buff, RINGBUFF_EVT_WRITE, tocopy + btw);
-    return tocopy + btw;
+    return &buff->buff[off];
 }
 
 /**
- * \brief           Read data from buffer.
- * Copies data from buffer to `data` array and marks buffer as free for maximum `btr` number of bytes
- *
+ * \brief           Commit data written to memory reserved with \ref ringbuff_write_reserve
  * \param[in]       buff: Buffer handle
- * \param[out]      data: Pointer to output memory to copy buffer data to
- * \param[in]       btr: Number of bytes to read
- * \return          Number of bytes read and copied to data array
+ * \param[in]       len: Number of bytes written, may be less than reserved length
+ * \return          Number of bytes committed
  */
-size_t
-ringbuff_read(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t btr) {
-    size_t tocopy, full;
-    uint8_t *d = data;
+RINGBUFF_HOT size_t
+ringbuff_write_commit(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    return ringbuff_advance(buff, len);
+}
 
-    if (!BUF_IS_VALID(buff) || data == NULL || btr == 0) {
-        return 0;
-    }
+/**
+ * \brief           Read header of next message in buffer
+ * \param[in]       buff: Buffer handle
+ * \param[out]      hdr: Output header
+ * \return          `1` if complete message is available, `0` otherwise
+ */
+static RINGBUFF_HOT uint8_t
+prv_msg_get_hdr(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_msg_hdr_t* hdr) {
+    size_t full;
 
-    /* Calculate maximum number of bytes available to read */
-    full = ringbuff_get_full(buff);
-    btr = BUF_MIN(full, btr);
-    if (btr == 0) {
+    full = prv_get_full(buff, sizeof(*hdr));
+    if (full < sizeof(*hdr)) {
         return 0;
     }
+    prv_copy_from(buff, buff->r, hdr, sizeof(*hdr));
 
-    /* Step 1: Read data from linear part of buffer */
-    tocopy = BUF_MIN(buff->size - buff->r, btr);
-    BUF_MEMCPY(d, &buff->buff[buff->r], tocopy);
-    buff->r += tocopy;
-    btr -= tocopy;
+    /* Message is always published as a whole, shorter data indicate corrupted header */
+    return hdr->len > 0 && hdr->len <= full - sizeof(*hdr);
+}
 
-    /* Step 2: Read data from beginning of buffer (overflow part) */
-    if (btr > 0) {
-        BUF_MEMCPY(&d[tocopy], buff->buff, btr);
-        buff->r = btr;
-    }
+#if RINGBUFF_USE_MSG_SEQ
+/**
+ * \brief           Check sequence number of message released by consumer
+ *
+ * Number ahead of expected one is a gap. Number behind expected one means
+ * producer side was re-initialized, it counts as gap without known number of lost messages
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       hdr: Header of released message
+ */
+static RINGBUFF_HOT void
+prv_msg_seq_check(RINGBUFF_VOLATILE ringbuff_t* buff, const ringbuff_msg_hdr_t* hdr) {
+    RINGBUFF_VOLATILE ringbuff_shared_t* shared = buff->shared;
+    uint32_t diff = hdr->seq - shared->msg_seq_next;
 
-    /* Step 3: Check end of buffer */
-    if (buff->r >= buff->size) {
-        buff->r = 0;
+    if (diff != 0) {
+        ++shared->msg_gaps;
+        if ((int32_t)diff > 0) {
+            shared->msg_lost += diff;
+        }
     }
-    BUF_SEND_EVT(buff, RINGBUFF_EVT_READ, tocopy + btr);
-    return tocopy + btr;
+    shared->msg_seq_next = hdr->seq + 1;
 }
+#define BUF_MSG_SEQ_CHECK(b, h)         prv_msg_seq_check((b), (h))
+#else
+#define BUF_MSG_SEQ_CHECK(b, h)         do {} while (0)
+#endif /* RINGBUFF_USE_MSG_SEQ */
 
+#if RINGBUFF_USE_MSG_CRC
 /**
- * \brief           Read from buffer without changing read pointer (peek only)
+ * \brief           Verify CRC of message payload, count mismatch.
+ *                  Used by receive functions which release corrupted message immediately
  * \param[in]       buff: Buffer handle
- * \param[in]       skip_count: Number of bytes to skip before reading data
- * \param[out]      data: Pointer to output memory to copy buffer data to
- * \param[in]       btp: Number of bytes to peek
- * \return          Number of bytes peeked and written to output array
+ * \param[in]       hdr: Header of message
+ * \param[in]       d1: First payload fragment
+ * \param[in]       l1: First fragment length in units of bytes
+ * \param[in]       d2: Second payload fragment, `NULL` when not used
+ * \param[in]       l2: Second fragment length in units of bytes
+ * \return          `1` when payload is intact, `0` otherwise
  */
-size_t
-ringbuff_peek(RINGBUFF_VOLATILE ringbuff_t* buff, size_t skip_count, void* data, size_t btp) {
-    size_t full, tocopy, r;
-    uint8_t *d = data;
-
-    if (!BUF_IS_VALID(buff) || data == NULL || btp == 0) {
-        return 0;
+static RINGBUFF_HOT uint8_t
+prv_msg_crc_check(RINGBUFF_VOLATILE ringbuff_t* buff, const ringbuff_msg_hdr_t* hdr,
+                    const void* d1, size_t l1, const void* d2, size_t l2) {
+    if (RINGBUFF_MSG_CRC(d1, l1, d2, l2) == hdr->crc) {
+        return 1;
     }
+    ++buff->shared->msg_crc_errors;
+    return 0;
+}
 
-    r = buff->r;
+/* Number of messages with CRC result kept in `msg_crc_bad` between batch scan and release */
+#define BUF_MSG_CRC_BAD_BITS            32
+#endif /* RINGBUFF_USE_MSG_CRC */
 
-    /* Calculate maximum number of bytes available to read */
-    full = ringbuff_get_full(buff);
+/**
+ * \brief           Release message at read pointer
+ * \param[in]       buff: Buffer handle
+ * \param[in]       hdr: Header of message
+ */
+static RINGBUFF_HOT void
+prv_msg_release(RINGBUFF_VOLATILE ringbuff_t* buff, const ringbuff_msg_hdr_t* hdr) {
+    BUF_MSG_SEQ_CHECK(buff, hdr);
+#if RINGBUFF_USE_MSG_CRC
+    buff->msg_crc_bad >>= 1;                    /* Batch scan result moves with read pointer */
+#endif /* RINGBUFF_USE_MSG_CRC */
+    prv_publish_r(buff, BUF_ADD(buff, buff->r, sizeof(*hdr) + hdr->len));
+    BUF_STATS_READ(buff, sizeof(*hdr) + hdr->len);
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_READ, sizeof(*hdr) + hdr->len);
+}
 
-    /* Skip beginning of buffer */
-    if (skip_count >= full) {
-        return 0;
-    }
-    r += skip_count;
-    full -= skip_count;
-    if (r >= buff->size) {
-        r -= buff->size;
-    }
+/**
+ * \brief           Send message to buffer.
+ *
+ * Message is written with header and published at once,
+ * consumer always receives it as a whole with \ref ringbuff_msg_recv
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       data: Message data
+ * \param[in]       len: Message length in units of bytes
+ * \return          `len` on success, `0` if there is not enough memory for complete message
+ */
+RINGBUFF_HOT size_t
+ringbuff_msg_send(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t len) {
+    ringbuff_msg_hdr_t hdr = {0};
+    ringbuff_iovec_t iov[2];
 
-    /* Check maximum number of bytes available to read after skip */
-    btp = BUF_MIN(full, btp);
-    if (btp == 0) {
+    if (!BUF_IS_VALID(buff) || data == NULL || len == 0) {
         return 0;
     }
 
-    /* Step 1: Read data from linear part of buffer */
-    tocopy = BUF_MIN(buff->size - r, btp);
-    BUF_MEMCPY(d, &buff->buff[r], tocopy);
-    btp -= tocopy;
-
-    /* Step 2: Read data from beginning of buffer (overflow part) */
-    if (btp > 0) {
-        BUF_MEMCPY(&d[tocopy], buff->buff, btp);
+    hdr.len = (uint32_t)len;
+#if RINGBUFF_USE_MSG_SEQ
+    hdr.seq = buff->shared->msg_seq;
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+    hdr.crc = RINGBUFF_MSG_CRC(data, len, NULL, 0);
+#endif /* RINGBUFF_USE_MSG_CRC */
+    iov[0].data = &hdr;
+    iov[0].len = sizeof(hdr);
+    iov[1].data = data;
+    iov[1].len = len;
+    if (ringbuff_writev(buff, iov, 2) == 0) {
+        return 0;
     }
-    return tocopy + btp;
+#if RINGBUFF_USE_MSG_SEQ
+    buff->shared->msg_seq = hdr.seq + 1;
+#endif /* RINGBUFF_USE_MSG_SEQ */
+    return len;
 }
 
 /**
- * \brief           Get available size in buffer for write operation
+ * \brief           Get length of next message in buffer
  * \param[in]       buff: Buffer handle
- * \return          Number of free bytes in memory
+ * \return          Message length in units of bytes, `0` if there is no message
  */
-size_t
-ringbuff_get_free(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    size_t size, w, r;
+RINGBUFF_HOT size_t
+ringbuff_msg_peek_len(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    ringbuff_msg_hdr_t hdr;
 
-    if (!BUF_IS_VALID(buff)) {
+    if (!BUF_IS_VALID(buff) || !prv_msg_get_hdr(buff, &hdr)) {
         return 0;
     }
-
-    /* Use temporary values in case they are changed during operations */
-    w = buff->w;
-    r = buff->r;
-    if (w == r) {
-        size = buff->size;
-    } else if (r > w) {
-        size = r - w;
-    } else {
-        size = buff->size - (w - r);
-    }
-
-    /* Buffer free size is always 1 less than actual size */
-    return size - 1;
+    return hdr.len;
 }
 
 /**
- * \brief           Get number of bytes currently available in buffer
+ * \brief           Receive next message from buffer
  * \param[in]       buff: Buffer handle
- * \return          Number of bytes ready to be read
+ * \param[out]      data: Output memory to copy message to
+ * \param[in]       size: Size of `data` array in units of bytes
+ * \return          Message length in units of bytes, `0` if there is no message
+ *                      or when it does not fit to `data` array. Message then stays in buffer,
+ *                      use \ref ringbuff_msg_peek_len to get its length
  */
-size_t
-ringbuff_get_full(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    size_t w, r, size;
+RINGBUFF_HOT size_t
+ringbuff_msg_recv(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t size) {
+    ringbuff_msg_hdr_t hdr;
 
-    if (!BUF_IS_VALID(buff)) {
+    if (!BUF_IS_VALID(buff) || data == NULL) {
         return 0;
     }
 
-    /* Use temporary values in case they are changed during operations */
-    w = buff->w;
-    r = buff->r;
-    if (w == r) {
-        size = 0;
-    } else if (w > r) {
-        size = w - r;
-    } else {
-        size = buff->size - (r - w);
+    while (prv_msg_get_hdr(buff, &hdr) && hdr.len <= size) {
+        prv_copy_from(buff, BUF_ADD(buff, buff->r, sizeof(hdr)), data, hdr.len);
+#if RINGBUFF_USE_MSG_CRC
+        /* Verify copy, corrupted message is dropped */
+        if (!prv_msg_crc_check(buff, &hdr, data, hdr.len, NULL, 0)) {
+            prv_msg_release(buff, &hdr);
+            continue;
+        }
+#endif /* RINGBUFF_USE_MSG_CRC */
+        prv_msg_release(buff, &hdr);
+        return hdr.len;
     }
-    return size;
+    return 0;
 }
 
 /**
- * \brief           Resets buffer to default values. Buffer size is not modified
+ * \brief           Reserve linear memory for zero-copy message send
+ *
+ * Message is published with \ref ringbuff_msg_send_commit.
+ * Function fails when message payload cannot be placed in linear memory
+ *
  * \param[in]       buff: Buffer handle
+ * \param[in]       len: Maximum message length in units of bytes
+ * \return          Pointer to memory for message payload, `NULL` if not available
  */
-void
-ringbuff_reset(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    if (BUF_IS_VALID(buff)) {
-        buff->w = 0;
-        buff->r = 0;
-        BUF_SEND_EVT(buff, RINGBUFF_EVT_RESET, 0);
+RINGBUFF_HOT void *
+ringbuff_msg_send_reserve(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    size_t off;
+
+    if (!BUF_IS_VALID(buff) || len == 0) {
+        return NULL;
+    }
+
+    off = BUF_IDX(buff, BUF_ADD(buff, buff->w, sizeof(ringbuff_msg_hdr_t)));
+    if (buff->size - off < len || prv_get_free(buff, sizeof(ringbuff_msg_hdr_t) + len) < sizeof(ringbuff_msg_hdr_t) + len) {
+        BUF_STATS_SHORT(buff);
+        return NULL;
     }
+    return &buff->buff[off];
 }
 
 /**
- * \brief           Get linear address for buffer for fast read
+ * \brief           Publish message, written to memory reserved with \ref ringbuff_msg_send_reserve
  * \param[in]       buff: Buffer handle
- * \return          Linear buffer start address
+ * \param[in]       len: Message length in units of bytes, up to reserved length
+ * \return          `len` on success, `0` otherwise
  */
-void *
-ringbuff_get_linear_block_read_address(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    if (!BUF_IS_VALID(buff)) {
-        return NULL;
+RINGBUFF_HOT size_t
+ringbuff_msg_send_commit(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
+    ringbuff_msg_hdr_t hdr = {0};
+
+    if (!BUF_IS_VALID(buff) || len == 0) {
+        return 0;
+    }
+    if (prv_get_free(buff, sizeof(hdr) + len) < sizeof(hdr) + len) {
+        BUF_STATS_SHORT(buff);
+        return 0;
     }
-    return &buff->buff[buff->r];
+
+    hdr.len = (uint32_t)len;
+#if RINGBUFF_USE_MSG_SEQ
+    hdr.seq = buff->shared->msg_seq;
+#endif /* RINGBUFF_USE_MSG_SEQ */
+#if RINGBUFF_USE_MSG_CRC
+    hdr.crc = RINGBUFF_MSG_CRC(&buff->buff[BUF_IDX(buff, BUF_ADD(buff, buff->w, sizeof(hdr)))], len, NULL, 0);
+#endif /* RINGBUFF_USE_MSG_CRC */
+    BUF_CACHE_CLEAN(buff, BUF_ADD(buff, buff->w, sizeof(hdr)), len);   /* Payload written by application */
+    prv_copy_to(buff, buff->w, &hdr, sizeof(hdr));
+    prv_publish_w(buff, BUF_ADD(buff, buff->w, sizeof(hdr) + len));
+#if RINGBUFF_USE_MSG_SEQ
+    buff->shared->msg_seq = hdr.seq + 1;
+#endif /* RINGBUFF_USE_MSG_SEQ */
+    BUF_STATS_WRITE(buff, sizeof(hdr) + len);
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_WRITE, sizeof(hdr) + len);
+    return len;
 }
 
 /**
- * \brief           Get length of linear block address before it overflows for read operation
+ * \brief           Get next message for zero-copy receive, as up to 2 linear blocks
+ *
+ * Message stays in buffer until released with \ref ringbuff_msg_recv_release.
+ * With \ref RINGBUFF_USE_MSG_CRC, corrupted messages are released and skipped
+ *
  * \param[in]       buff: Buffer handle
- * \return          Linear buffer size in units of bytes for read operation
+ * \param[out]      ptr1: Output pointer to first block address
+ * \param[out]      len1: Output pointer to first block length
+ * \param[out]      ptr2: Output pointer to second block address. Set to `NULL` when not used
+ * \param[out]      len2: Output pointer to second block length. Set to `0` when not used
+ * \return          Message length in units of bytes, `0` if there is no message
  */
-size_t
-ringbuff_get_linear_block_read_length(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    size_t w, r, len;
+RINGBUFF_HOT size_t
+ringbuff_msg_recv_acquire(RINGBUFF_VOLATILE ringbuff_t* buff, void** ptr1, size_t* len1, void** ptr2, size_t* len2) {
+    ringbuff_msg_hdr_t hdr;
+    size_t off;
 
-    if (!BUF_IS_VALID(buff)) {
+    if (!BUF_IS_VALID(buff) || ptr1 == NULL || len1 == NULL || ptr2 == NULL || len2 == NULL) {
         return 0;
     }
 
-    /* Use temporary values in case they are changed during operations */
-    w = buff->w;
-    r = buff->r;
-    if (w > r) {
-        len = w - r;
-    } else if (r > w) {
-        len = buff->size - r;
-    } else {
-        len = 0;
+    while (prv_msg_get_hdr(buff, &hdr)) {
+        off = BUF_IDX(buff, BUF_ADD(buff, buff->r, sizeof(hdr)));
+        *ptr1 = &buff->buff[off];
+        *len1 = BUF_MIN(hdr.len, buff->size - off);
+        *len2 = hdr.len - *len1;
+        *ptr2 = *len2 > 0 ? buff->buff : NULL;
+        BUF_CACHE_INVALIDATE(buff, BUF_ADD(buff, buff->r, sizeof(hdr)), hdr.len);
+#if RINGBUFF_USE_MSG_CRC
+        if (!prv_msg_crc_check(buff, &hdr, *ptr1, *len1, *ptr2, *len2)) {
+            prv_msg_release(buff, &hdr);
+            continue;
+        }
+#endif /* RINGBUFF_USE_MSG_CRC */
+        return hdr.len;
     }
-    return len;
+    return 0;
 }
 
 /**
- * \brief           Skip (ignore; advance read pointer) buffer data
- * Marks data as read in the buffer and increases free memory for up to `len` bytes
- *
- * \note            Useful at the end of streaming transfer such as DMA
+ * \brief           Release message, previously acquired with \ref ringbuff_msg_recv_acquire
  * \param[in]       buff: Buffer handle
- * \param[in]       len: Number of bytes to skip and mark as read
- * \return          Number of bytes skipped
+ * \return          Released message length in units of bytes, `0` if there is no message
  */
-size_t
-ringbuff_skip(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
-    size_t full;
+RINGBUFF_HOT size_t
+ringbuff_msg_recv_release(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    ringbuff_msg_hdr_t hdr;
 
-    if (!BUF_IS_VALID(buff) || len == 0) {
+    if (!BUF_IS_VALID(buff) || !prv_msg_get_hdr(buff, &hdr)) {
         return 0;
     }
+    prv_msg_release(buff, &hdr);
+    return hdr.len;
+}
 
-    full = ringbuff_get_full(buff);             /* Get buffer used length */
-    len = BUF_MIN(len, full);                   /* Calculate max skip */
-    buff->r += len;                             /* Advance read pointer */
-    if (buff->r >= buff->size) {                /* Subtract possible overflow */
-        buff->r -= buff->size;
+/**
+ * \brief           Read header of message at pointer, within data published by producer
+ * \param[in]       buff: Buffer handle
+ * \param[in]       r: Pointer of message header
+ * \param[in]       full: Number of bytes in buffer from `r`
+ * \param[out]      hdr: Output header
+ * \return          `1` if complete message is available, `0` otherwise
+ */
+static RINGBUFF_HOT uint8_t
+prv_msg_get_hdr_at(RINGBUFF_VOLATILE ringbuff_t* buff, size_t r, size_t full, ringbuff_msg_hdr_t* hdr) {
+    if (full < sizeof(*hdr)) {
+        return 0;
     }
-    BUF_SEND_EVT(buff, RINGBUFF_EVT_READ, len);
-    return len;
+    prv_copy_from(buff, r, hdr, sizeof(*hdr));
+    return hdr->len > 0 && hdr->len <= full - sizeof(*hdr);
 }
 
 /**
- * \brief           Get linear address for buffer for fast read
+ * \brief           Get payload of message at pointer as up to 2 linear blocks
  * \param[in]       buff: Buffer handle
- * \return          Linear buffer start address
+ * \param[in]       r: Pointer of message header
+ * \param[in]       hdr: Header of message
+ * \param[out]      span: Output payload blocks
  */
-void *
-ringbuff_get_linear_block_write_address(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    if (!BUF_IS_VALID(buff)) {
-        return NULL;
+static RINGBUFF_HOT void
+prv_msg_span_at(RINGBUFF_VOLATILE ringbuff_t* buff, size_t r, const ringbuff_msg_hdr_t* hdr, ringbuff_msg_span_t* span) {
+    size_t off = BUF_IDX(buff, BUF_ADD(buff, r, sizeof(*hdr)));
+
+    span->ptr1 = &buff->buff[off];
+    span->len1 = BUF_MIN(hdr->len, buff->size - off);
+    span->len2 = hdr->len - span->len1;
+    span->ptr2 = span->len2 > 0 ? buff->buff : NULL;
+}
+
+/**
+ * \brief           Get burst of messages for zero-copy receive, with single load of write pointer
+ *
+ * Write pointer is loaded from shared memory once, messages published up to it
+ * are returned in order, each as up to 2 linear blocks.
+ * Messages stay in buffer until released together with \ref ringbuff_msg_recv_batch_release.
+ * With \ref RINGBUFF_USE_MSG_CRC, corrupted message is returned with `ptr1 == NULL` and zero length,
+ * it is released with the others. CRC error is counted on release,
+ * so scanning the same messages again before release does not count it twice
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[out]      spans: Output array of message payloads
+ * \param[in]       max: Maximum number of messages, length of `spans` array
+ * \return          Number of messages in `spans`, `0` if there is no message
+ */
+RINGBUFF_HOT size_t
+ringbuff_msg_recv_batch(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_msg_span_t* spans, size_t max) {
+    ringbuff_msg_hdr_t hdr;
+    size_t r, full, n = 0;
+
+    if (!BUF_IS_VALID(buff) || spans == NULL || max == 0) {
+        return 0;
+    }
+
+    buff->w = RINGBUFF_PTR_LOAD(buff->shared->w);
+    BUF_BARRIER();
+    r = buff->r;
+    full = BUF_FULL(buff, buff->w, r);
+#if RINGBUFF_USE_MSG_CRC
+    buff->msg_crc_bad = 0;
+#endif /* RINGBUFF_USE_MSG_CRC */
+    while (n < max && prv_msg_get_hdr_at(buff, r, full, &hdr)) {
+        prv_msg_span_at(buff, r, &hdr, &spans[n]);
+        BUF_CACHE_INVALIDATE(buff, BUF_ADD(buff, r, sizeof(hdr)), hdr.len);
+#if RINGBUFF_USE_MSG_CRC
+        if (RINGBUFF_MSG_CRC(spans[n].ptr1, spans[n].len1, spans[n].ptr2, spans[n].len2) != hdr.crc) {
+            if (n < BUF_MSG_CRC_BAD_BITS) {
+                buff->msg_crc_bad |= 1UL << n;
+            }
+            spans[n].ptr1 = spans[n].ptr2 = NULL;
+            spans[n].len1 = spans[n].len2 = 0;
+        }
+#endif /* RINGBUFF_USE_MSG_CRC */
+        r = BUF_ADD(buff, r, sizeof(hdr) + hdr.len);
+        full -= sizeof(hdr) + hdr.len;
+        ++n;
     }
-    return &buff->buff[buff->w];
+    return n;
 }
 
 /**
- * \brief           Get length of linear block address before it overflows for write operation
+ * \brief           Release messages acquired with \ref ringbuff_msg_recv_batch,
+ *                  read pointer is published once for all of them
  * \param[in]       buff: Buffer handle
- * \return          Linear buffer size in units of bytes for write operation
+ * \param[in]       count: Number of messages to release, up to number returned by \ref ringbuff_msg_recv_batch
+ * \return          Number of released messages
  */
-size_t
-ringbuff_get_linear_block_write_length(RINGBUFF_VOLATILE ringbuff_t* buff) {
-    size_t w, r, len;
+RINGBUFF_HOT size_t
+ringbuff_msg_recv_batch_release(RINGBUFF_VOLATILE ringbuff_t* buff, size_t count) {
+    ringbuff_msg_hdr_t hdr;
+    size_t r, full, total = 0, n = 0;
+#if RINGBUFF_USE_MSG_CRC
+    ringbuff_msg_span_t span;
+    uint8_t bad;
+#endif /* RINGBUFF_USE_MSG_CRC */
 
     if (!BUF_IS_VALID(buff)) {
         return 0;
     }
 
-    /* Use temporary values in case they are changed during operations */
-    w = buff->w;
     r = buff->r;
-    if (w >= r) {
-        len = buff->size - w;
-        /*
-         * When read pointer is 0,
-         * maximal length is one less as if too many bytes
-         * are written, buffer would be considered empty again (r == w)
-         */
-        if (r == 0) {
-            /*
-             * Cannot overflow:
-             * - If r is not 0, statement does not get called
-             * - buff->size cannot be 0 and if r is 0, len is greater 0
-             */
-            --len;
+    full = BUF_FULL(buff, buff->w, r);
+    while (n < count && prv_msg_get_hdr_at(buff, r, full, &hdr)) {
+        BUF_MSG_SEQ_CHECK(buff, &hdr);
+#if RINGBUFF_USE_MSG_CRC
+        /* Result of scan is kept for first messages only, others are verified again */
+        if (n < BUF_MSG_CRC_BAD_BITS) {
+            bad = (buff->msg_crc_bad >> n) & 0x01;
+        } else {
+            prv_msg_span_at(buff, r, &hdr, &span);
+            bad = RINGBUFF_MSG_CRC(span.ptr1, span.len1, span.ptr2, span.len2) != hdr.crc;
         }
-    } else {
-        len = r - w - 1;
+        if (bad) {
+            ++buff->shared->msg_crc_errors;
+        }
+#endif /* RINGBUFF_USE_MSG_CRC */
+        r = BUF_ADD(buff, r, sizeof(hdr) + hdr.len);
+        full -= sizeof(hdr) + hdr.len;
+        total += sizeof(hdr) + hdr.len;
+        ++n;
     }
-    return len;
+    if (n == 0) {
+        return 0;
+    }
+#if RINGBUFF_USE_MSG_CRC
+    /* Keep scan result of messages not released yet */
+    buff->msg_crc_bad = n < BUF_MSG_CRC_BAD_BITS ? buff->msg_crc_bad >> n : 0;
+#endif /* RINGBUFF_USE_MSG_CRC */
+    prv_publish_r(buff, r);
+    BUF_STATS_READ_N(buff, total, n);
+    BUF_SEND_EVT(buff, RINGBUFF_EVT_READ, total);
+    return n;
 }
 
+#if RINGBUFF_USE_MSG_SEQ
+
 /**
- * \brief           Advance write pointer in the buffer.
- * Similar to skip function but modifies write pointer instead of read
- *
- * \note            Useful when hardware is writing to buffer and application needs to increase number
- *                      of bytes written to buffer by hardware
+ * \brief           Get message sequence gaps seen by consumer.
+ *                  Can be called by producer, consumer, or any other core with handle attached to same pointers
  * \param[in]       buff: Buffer handle
- * \param[in]       len: Number of bytes to advance
- * \return          Number of bytes advanced for write operation
+ * \param[out]      lost: Output variable to write number of messages missing in gaps to, can be `NULL`
+ * \return          Number of gaps
  */
-size_t
-ringbuff_advance(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len) {
-    size_t free;
-
-    if (!BUF_IS_VALID(buff) || len == 0) {
+uint32_t
+ringbuff_msg_get_gaps(RINGBUFF_VOLATILE ringbuff_t* buff, uint32_t* lost) {
+    if (!BUF_IS_VALID(buff)) {
         return 0;
     }
+    if (lost != NULL) {
+        *lost = buff->shared->msg_lost;
+    }
+    return buff->shared->msg_gaps;
+}
+
+#endif /* RINGBUFF_USE_MSG_SEQ */
+
+#if RINGBUFF_USE_MSG_CRC
 
-    free = ringbuff_get_free(buff);             /* Get buffer free length */
-    len = BUF_MIN(len, free);                   /* Calculate max advance */
-    buff->w += len;                             /* Advance write pointer */
-    if (buff->w >= buff->size) {                /* Subtract possible overflow */
-        buff->w -= buff->size;
+/**
+ * \brief           Get number of messages consumer dropped on CRC mismatch.
+ *                  Can be called by producer, consumer, or any other core with handle attached to same pointers
+ * \param[in]       buff: Buffer handle
+ * \return          Number of corrupted messages
+ */
+uint32_t
+ringbuff_msg_get_crc_errors(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
     }
-    BUF_SEND_EVT(buff, RINGBUFF_EVT_WRITE, len);
-    return len;
+    return buff->shared->msg_crc_errors;
 }
+
+#endif /* RINGBUFF_USE_MSG_CRC */
@@ -0,0 +1,293 @@
+/**
+ * \file            ringbuff_bip.c
+ * \brief           Bipartite ring buffer manager
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#include "ringbuff/ringbuff_bip.h"
+
+/* Memory set function */
+#define BUF_MEMSET                      memset
+
+#if RINGBUFF_USE_MAGIC
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->magic1 == 0xDEADBEEF && (b)->magic2 == ~0xDEADBEEF && (b)->buff != NULL && (b)->size > 0)
+#else
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->buff != NULL && (b)->size > 0)
+#endif /* RINGBUFF_USE_MAGIC */
+
+/* Barrier between peer pointer read and data access, see ringbuff.c */
+#if RINGBUFF_USE_SPSC
+#define BUF_BARRIER()                   RINGBUFF_MEMORY_BARRIER()
+#else
+#define BUF_BARRIER()                   do {} while (0)
+#endif /* RINGBUFF_USE_SPSC */
+
+/*
+ * Pointers are plain offsets in range `0..size`, state is one of:
+ *
+ * - `w >= r`: Data are in `[r, w)`, writer may write until end of buffer
+ * - `w < r`: Writer wrapped, data are in `[r, wm)` followed by `[0, w)`
+ *
+ * Writer keeps `w != r` after every wrap, otherwise buffer would look empty.
+ * Watermark is published before write pointer is wrapped,
+ * reader only uses it once it observes `w < r`.
+ */
+
+/**
+ * \brief           Setup buffer handle and attach it to pointers
+ * \param[in]       buff: Buffer handle
+ * \param[in]       shared: Pointers structure. Set to `NULL` to use handle local pointers
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes
+ * \param[in]       reset: Set to `1` to reset pointers, `0` to keep their current value
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_init(RINGBUFF_VOLATILE ringbuff_bip_t* buff, RINGBUFF_VOLATILE ringbuff_bip_shared_t* shared,
+            void* buffdata, size_t size, uint8_t reset) {
+    if (buff == NULL || buffdata == NULL || size == 0) {
+        return 0;
+    }
+
+    BUF_MEMSET((void *)buff, 0x00, sizeof(*buff));
+
+    buff->size = size;
+    buff->buff = buffdata;
+    buff->shared = shared != NULL ? shared : &buff->local;
+    if (reset) {
+        buff->shared->w = 0;
+        buff->shared->wm = size;
+        buff->shared->r = 0;
+    }
+
+#if RINGBUFF_USE_MAGIC
+    buff->magic1 = 0xDEADBEEF;
+    buff->magic2 = ~0xDEADBEEF;
+#endif /* RINGBUFF_USE_MAGIC */
+
+    return 1;
+}
+
+/**
+ * \brief           Initialize bipartite buffer handle with pointers stored in handle itself
+ * \param[in]       buff: Buffer handle
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes.
+ *                      Any size is allowed, power of `2` is not required
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_bip_init(RINGBUFF_VOLATILE ringbuff_bip_t* buff, void* buffdata, size_t size) {
+    return prv_init(buff, NULL, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local bipartite buffer handle with pointers in shared memory
+ *                  and reset pointers to empty buffer.
+ *
+ * Called once by core that owns shared memory, before other core attaches with \ref ringbuff_bip_attach
+ *
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_bip_init_shared(RINGBUFF_VOLATILE ringbuff_bip_t* buff, RINGBUFF_VOLATILE ringbuff_bip_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local bipartite buffer handle with pointers in shared memory,
+ *                  previously initialized by other core with \ref ringbuff_bip_init_shared
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_bip_attach(RINGBUFF_VOLATILE ringbuff_bip_t* buff, RINGBUFF_VOLATILE ringbuff_bip_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 0);
+}
+
+/**
+ * \brief           Reserve contiguous block of memory for writing
+ *
+ * Block is never split at end of buffer. When it does not fit until end,
+ * writer wraps to beginning and bytes at the end are skipped by reader.
+ * Data are not visible to reader until \ref ringbuff_bip_write_commit is called
+ *
+ * \note            Only producer may call this function
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes to reserve
+ * \return          Pointer to `len` contiguous bytes, `NULL` if there is no space
+ */
+RINGBUFF_HOT void *
+ringbuff_bip_write_reserve(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t len) {
+    size_t w, r;
+
+    if (!BUF_IS_VALID(buff) || len == 0) {
+        return NULL;
+    }
+
+    w = buff->shared->w;
+    r = buff->shared->r;
+    BUF_BARRIER();
+
+    if (w >= r) {
+        if (buff->size - w >= len) {
+            buff->res_off = w;
+        } else if (r > len) {
+            buff->res_off = 0;                  /* Wrap, keep w < r */
+        } else {
+            return NULL;
+        }
+    } else if (r - w > len) {
+        buff->res_off = w;
+    } else {
+        return NULL;
+    }
+    buff->res_len = len;
+    return &buff->buff[buff->res_off];
+}
+
+/**
+ * \brief           Commit data written to block reserved with \ref ringbuff_bip_write_reserve
+ * \note            Only producer may call this function
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes written, may be less than reserved length
+ * \return          Number of bytes committed
+ */
+RINGBUFF_HOT size_t
+ringbuff_bip_write_commit(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t len) {
+    size_t w;
+
+    if (!BUF_IS_VALID(buff) || buff->res_len == 0) {
+        return 0;
+    }
+    if (len > buff->res_len) {
+        len = buff->res_len;
+    }
+    buff->res_len = 0;
+    if (len == 0) {
+        return 0;
+    }
+
+    w = buff->shared->w;
+    BUF_BARRIER();                              /* Data written before pointers */
+    if (buff->res_off != w) {
+        buff->shared->wm = w;                   /* Wrapped, end of data before beginning */
+        BUF_BARRIER();
+    }
+    buff->shared->w = buff->res_off + len;
+    return len;
+}
+
+/**
+ * \brief           Get contiguous block of data ready to read
+ *
+ * Returned block may contain more committed blocks, but never data
+ * from before and after wrap point
+ *
+ * \note            Only consumer may call this function
+ * \param[in]       buff: Buffer handle
+ * \param[out]      len: Output variable to write block length to
+ * \return          Pointer to first byte of block, `NULL` if buffer is empty
+ */
+RINGBUFF_HOT void *
+ringbuff_bip_read_acquire(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t* len) {
+    size_t w, r, wm;
+
+    if (len != NULL) {
+        *len = 0;
+    }
+    if (!BUF_IS_VALID(buff) || len == NULL) {
+        return NULL;
+    }
+
+    r = buff->shared->r;
+    w = buff->shared->w;
+    BUF_BARRIER();
+    if (w < r) {
+        wm = buff->shared->wm;
+        BUF_BARRIER();
+        if (r >= wm) {
+            /* Everything until watermark is read, follow writer to beginning */
+            r = 0;
+            buff->shared->r = r;
+        } else {
+            *len = wm - r;
+            return &buff->buff[r];
+        }
+    }
+    if (w == r) {
+        return NULL;
+    }
+    *len = w - r;
+    return &buff->buff[r];
+}
+
+/**
+ * \brief           Release data acquired with \ref ringbuff_bip_read_acquire
+ * \note            Only consumer may call this function
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Number of bytes to release, not greater than acquired length
+ * \return          Number of bytes released
+ */
+RINGBUFF_HOT size_t
+ringbuff_bip_read_release(RINGBUFF_VOLATILE ringbuff_bip_t* buff, size_t len) {
+    size_t w, r, end;
+
+    if (!BUF_IS_VALID(buff) || len == 0) {
+        return 0;
+    }
+
+    r = buff->shared->r;
+    w = buff->shared->w;
+    BUF_BARRIER();
+    end = w;
+    if (w < r) {
+        end = buff->shared->wm;
+    }
+    if (len > end - r) {
+        len = end - r;
+    }
+    BUF_BARRIER();                              /* Data read before pointer */
+    buff->shared->r = r + len;
+    return len;
+}
@@ -0,0 +1,180 @@
+/**
+ * \file            ringbuff_cpt.c
+ * \brief           Compact ring buffer descriptor manager
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#include <stddef.h>
+#include "ringbuff/ringbuff_cpt.h"
+
+/* Memory copy function */
+#define BUF_MEMCPY                      RINGBUFF_MEMCPY
+#define BUF_MIN(x, y)                   ((x) < (y) ? (x) : (y))
+
+/* Barrier between peer index read and data access, see ringbuff.c */
+#if RINGBUFF_USE_SPSC
+#define BUF_BARRIER()                   RINGBUFF_MEMORY_BARRIER()
+#else
+#define BUF_BARRIER()                   do {} while (0)
+#endif /* RINGBUFF_USE_SPSC */
+
+/* Data array of descriptor */
+#define BUF_DATA(b, base)               ((uint8_t *)(base) + (b)->off)
+
+_Static_assert(sizeof(ringbuff_cpt_t) == 8, "Compact descriptor must be 8 bytes");
+_Static_assert(offsetof(ringbuff_cpt_t, w) == 0 && offsetof(ringbuff_cpt_t, r) == 2,
+                "Indices must share first word, see ringbuff_cpt_get_full");
+
+/**
+ * \brief           Initialize descriptor, both indices are reset.
+ *                  Called once, before any core uses buffer
+ * \param[in]       buff: Buffer descriptor
+ * \param[in]       base: Base address, the same for all descriptors and both cores
+ * \param[in]       buffdata: Pointer to memory to use as buffer data, at most `64 kB` above `base`
+ * \param[in]       size: Size of `buffdata` in units of bytes, power of `2` from `2` to `32 kB`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_cpt_init(volatile ringbuff_cpt_t* buff, const void* base, void* buffdata, size_t size) {
+    size_t off;
+
+    if (buff == NULL || base == NULL || buffdata == NULL
+        || size < 2 || size > 0x8000 || (size & (size - 1)) != 0
+        || (const uint8_t *)buffdata < (const uint8_t *)base) {
+        return 0;
+    }
+    off = (size_t)((const uint8_t *)buffdata - (const uint8_t *)base);
+    if (off > 0xFFFF) {
+        return 0;
+    }
+
+    buff->off = (uint16_t)off;
+    buff->mask = (uint16_t)(size - 1);
+    buff->w = 0;
+    buff->r = 0;
+    return 1;
+}
+
+/**
+ * \brief           Write data to buffer, producer side.
+ *                  Copies as many bytes as possible
+ * \param[in]       buff: Buffer descriptor
+ * \param[in]       base: Base address used with \ref ringbuff_cpt_init
+ * \param[in]       data: Pointer to data to write into buffer
+ * \param[in]       btw: Number of bytes to write
+ * \return          Number of bytes written to buffer
+ */
+size_t
+ringbuff_cpt_write(volatile ringbuff_cpt_t* buff, void* base, const void* data, size_t btw) {
+    const uint8_t* d = data;
+    uint8_t* arr;
+    uint16_t w;
+    size_t idx, tocopy;
+
+    if (buff == NULL || base == NULL || data == NULL) {
+        return 0;
+    }
+    btw = BUF_MIN(btw, ringbuff_cpt_get_free(buff));
+    if (btw == 0) {
+        return 0;
+    }
+    BUF_BARRIER();                              /* Read index before data */
+
+    w = buff->w;
+    arr = BUF_DATA(buff, base);
+    idx = w & buff->mask;
+    tocopy = BUF_MIN((size_t)buff->mask + 1 - idx, btw);
+    BUF_MEMCPY(&arr[idx], d, tocopy);
+    if (btw > tocopy) {
+        BUF_MEMCPY(arr, &d[tocopy], btw - tocopy);
+    }
+
+    BUF_BARRIER();                              /* Data before write index */
+    RINGBUFF_PTR_STORE(buff->w, (uint16_t)(w + btw));
+    return btw;
+}
+
+/**
+ * \brief           Read data from buffer, consumer side.
+ *                  Copies as many bytes as possible
+ * \param[in]       buff: Buffer descriptor
+ * \param[in]       base: Base address used with \ref ringbuff_cpt_init
+ * \param[out]      data: Pointer to output memory to copy buffer data to
+ * \param[in]       btr: Number of bytes to read
+ * \return          Number of bytes read and copied to data array
+ */
+size_t
+ringbuff_cpt_read(volatile ringbuff_cpt_t* buff, const void* base, void* data, size_t btr) {
+    const uint8_t* arr;
+    uint8_t* d = data;
+    uint16_t r;
+    size_t idx, tocopy;
+
+    if (buff == NULL || base == NULL || data == NULL) {
+        return 0;
+    }
+    btr = BUF_MIN(btr, ringbuff_cpt_get_full(buff));
+    if (btr == 0) {
+        return 0;
+    }
+    BUF_BARRIER();                              /* Write index before data */
+
+    r = buff->r;
+    arr = BUF_DATA(buff, base);
+    idx = r & buff->mask;
+    tocopy = BUF_MIN((size_t)buff->mask + 1 - idx, btr);
+    BUF_MEMCPY(d, &arr[idx], tocopy);
+    if (btr > tocopy) {
+        BUF_MEMCPY(&d[tocopy], arr, btr - tocopy);
+    }
+
+    BUF_BARRIER();                              /* Data before read index */
+    RINGBUFF_PTR_STORE(buff->r, (uint16_t)(r + btr));
+    return btr;
+}
+
+/**
+ * \brief           Skip data in buffer, consumer side
+ * \param[in]       buff: Buffer descriptor
+ * \param[in]       len: Number of bytes to skip
+ * \return          Number of bytes skipped
+ */
+size_t
+ringbuff_cpt_skip(volatile ringbuff_cpt_t* buff, size_t len) {
+    if (buff == NULL) {
+        return 0;
+    }
+    len = BUF_MIN(len, ringbuff_cpt_get_full(buff));
+    if (len > 0) {
+        BUF_BARRIER();                          /* Data before read index */
+        RINGBUFF_PTR_STORE(buff->r, (uint16_t)(buff->r + len));
+    }
+    return len;
+}
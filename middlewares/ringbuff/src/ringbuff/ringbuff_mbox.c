@@ -0,0 +1,211 @@
+/**
+ * \file            ringbuff_mbox.c
+ * \brief           Latest-value mailbox
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#include <stddef.h>
+#include "ringbuff/ringbuff_mbox.h"
+
+/* Memory set and copy functions */
+#define BUF_MEMSET                      memset
+#define BUF_MEMCPY                      RINGBUFF_MEMCPY
+
+#if RINGBUFF_USE_MAGIC
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->magic1 == 0xDEADBEEF && (b)->magic2 == ~0xDEADBEEF && (b)->buff != NULL && (b)->size > 0)
+#else
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->buff != NULL && (b)->size > 0)
+#endif /* RINGBUFF_USE_MAGIC */
+
+/* Barrier between counter and data access, see ringbuff.c */
+#if RINGBUFF_USE_SPSC
+#define BUF_BARRIER()                   RINGBUFF_MEMORY_BARRIER()
+#else
+#define BUF_BARRIER()                   do {} while (0)
+#endif /* RINGBUFF_USE_SPSC */
+
+/**
+ * \brief           Setup mailbox handle and attach it to counter
+ * \param[in]       buff: Mailbox handle
+ * \param[in]       shared: Counter structure. Set to `NULL` to use handle local counter
+ * \param[in]       buffdata: Pointer to memory to use as state data
+ * \param[in]       size: Size of `buffdata` in units of bytes
+ * \param[in]       reset: Set to `1` to reset counter to empty mailbox, `0` to keep its current value
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_init(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, RINGBUFF_VOLATILE ringbuff_mbox_shared_t* shared,
+            void* buffdata, size_t size, uint8_t reset) {
+    if (buff == NULL || buffdata == NULL || size == 0) {
+        return 0;
+    }
+
+    BUF_MEMSET((void *)buff, 0x00, sizeof(*buff));
+
+    buff->size = size;
+    buff->buff = buffdata;
+    buff->shared = shared != NULL ? shared : &buff->local;
+    if (reset) {
+        buff->shared->seq = 0;
+    }
+
+#if RINGBUFF_USE_MAGIC
+    buff->magic1 = 0xDEADBEEF;
+    buff->magic2 = ~0xDEADBEEF;
+#endif /* RINGBUFF_USE_MAGIC */
+
+    return 1;
+}
+
+/**
+ * \brief           Initialize mailbox handle with counter stored in handle itself
+ * \param[in]       buff: Mailbox handle
+ * \param[in]       buffdata: Pointer to memory to use as state data
+ * \param[in]       size: Size of state structure in units of bytes
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_mbox_init(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, void* buffdata, size_t size) {
+    return prv_init(buff, NULL, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local mailbox handle with counter in shared memory
+ *                  and reset it to mailbox without value.
+ *
+ * Called once by core that owns shared memory, before other core attaches with \ref ringbuff_mbox_attach
+ *
+ * \param[in]       buff: Core-local mailbox handle
+ * \param[in]       shared: Counter structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as state data
+ * \param[in]       size: Size of state structure in units of bytes
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_mbox_init_shared(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, RINGBUFF_VOLATILE ringbuff_mbox_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local mailbox handle with counter in shared memory,
+ *                  previously initialized by other core with \ref ringbuff_mbox_init_shared
+ * \param[in]       buff: Core-local mailbox handle
+ * \param[in]       shared: Counter structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as state data
+ * \param[in]       size: Size of state structure in units of bytes
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_mbox_attach(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, RINGBUFF_VOLATILE ringbuff_mbox_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 0);
+}
+
+/**
+ * \brief           Write new state, previous state is overwritten.
+ *                  Function never waits for readers
+ * \note            Only single writer may call this function
+ * \param[in]       buff: Mailbox handle
+ * \param[in]       data: State structure, mailbox size bytes
+ * \return          `1` on success, `0` otherwise
+ */
+RINGBUFF_HOT uint8_t
+ringbuff_mbox_write(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, const void* data) {
+    uint32_t seq;
+
+    if (!BUF_IS_VALID(buff) || data == NULL) {
+        return 0;
+    }
+
+    seq = buff->shared->seq & ~(uint32_t)1;
+    buff->shared->seq = seq + 1;                /* Odd, update in progress */
+    BUF_BARRIER();                              /* Counter before data */
+    BUF_MEMCPY(buff->buff, data, buff->size);
+    BUF_BARRIER();                              /* Data before counter */
+    buff->shared->seq = seq + 2;
+    return 1;
+}
+
+/**
+ * \brief           Copy newest complete state.
+ *                  Copy is repeated when it was torn by concurrent write,
+ *                  at most \ref RINGBUFF_MBOX_RETRIES times
+ * \param[in]       buff: Mailbox handle
+ * \param[out]      data: Memory to copy state to, mailbox size bytes
+ * \param[out]      version: Output variable to write number of writes until copied state to.
+ *                      Compare with previous value to detect new state. Can be set to `NULL`
+ * \return          `1` on success, `0` if mailbox was never written or every copy was torn
+ */
+RINGBUFF_HOT uint8_t
+ringbuff_mbox_read(RINGBUFF_VOLATILE ringbuff_mbox_t* buff, void* data, uint32_t* version) {
+    uint32_t seq;
+
+    if (!BUF_IS_VALID(buff) || data == NULL) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < RINGBUFF_MBOX_RETRIES; ++i) {
+        seq = buff->shared->seq;
+        if (seq == 0) {
+            return 0;                           /* No state written yet */
+        }
+        if (seq & 1) {
+            continue;                           /* Write in progress */
+        }
+        BUF_BARRIER();                          /* Counter before data */
+        BUF_MEMCPY(data, buff->buff, buff->size);
+        BUF_BARRIER();                          /* Data before counter check */
+        if (buff->shared->seq == seq) {
+            if (version != NULL) {
+                *version = seq >> 1;
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Get number of completed writes, without copying state
+ * \param[in]       buff: Mailbox handle
+ * \return          Number of completed writes, `0` if mailbox was never written
+ */
+uint32_t
+ringbuff_mbox_get_version(RINGBUFF_VOLATILE ringbuff_mbox_t* buff) {
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
+    }
+    return buff->shared->seq >> 1;
+}
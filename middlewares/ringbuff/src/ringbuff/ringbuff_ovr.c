@@ -0,0 +1,347 @@
+/**
+ * \file            ringbuff_ovr.c
+ * \brief           Overwrite-oldest record buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#include <stddef.h>
+#include "ringbuff/ringbuff_ovr.h"
+
+/* Memory set and copy functions */
+#define BUF_MEMSET                      memset
+#define BUF_MEMCPY                      RINGBUFF_MEMCPY
+#define BUF_MIN(x, y)                   ((x) < (y) ? (x) : (y))
+
+#if RINGBUFF_USE_MAGIC
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->magic1 == 0xDEADBEEF && (b)->magic2 == ~0xDEADBEEF && (b)->buff != NULL && (b)->size > 0)
+#else
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->buff != NULL && (b)->size > 0)
+#endif /* RINGBUFF_USE_MAGIC */
+
+/* Barrier between peer pointer read and data access, see ringbuff.c */
+#if RINGBUFF_USE_SPSC
+#define BUF_BARRIER()                   RINGBUFF_MEMORY_BARRIER()
+#else
+#define BUF_BARRIER()                   do {} while (0)
+#endif /* RINGBUFF_USE_SPSC */
+
+/* Offset in data array of free-running pointer */
+#define BUF_IDX(b, i)                   ((i) & ((b)->size - 1))
+
+/* Records start on word boundary */
+#define BUF_REC_LEN(len)                ((sizeof(ringbuff_ovr_hdr_t) + (len) + 3) & ~(size_t)3)
+
+/* Free-running pointer `a` is before `b` */
+#define BUF_BEFORE(a, b)                ((ptrdiff_t)((a) - (b)) < 0)
+
+/*
+ * Pointers are free-running, `tail <= r <= w` while consumer keeps up
+ * and `w - tail <= size` at all times.
+ *
+ * Producer publishes `tail` before it overwrites memory of oldest records,
+ * consumer that finds `r` before `tail` lost records and continues at `tail`.
+ */
+
+/**
+ * \brief           Setup buffer handle and attach it to pointers
+ * \param[in]       buff: Buffer handle
+ * \param[in]       shared: Pointers structure. Set to `NULL` to use handle local pointers
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes, power of `2`
+ * \param[in]       reset: Set to `1` to reset pointers, `0` to keep their current value
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_init(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, RINGBUFF_VOLATILE ringbuff_ovr_shared_t* shared,
+            void* buffdata, size_t size, uint8_t reset) {
+    if (buff == NULL || buffdata == NULL || size < 2 * sizeof(ringbuff_ovr_hdr_t)
+        || (size & (size - 1)) != 0) {
+        return 0;
+    }
+
+    BUF_MEMSET((void *)buff, 0x00, sizeof(*buff));
+
+    buff->size = size;
+    buff->buff = buffdata;
+    buff->shared = shared != NULL ? shared : &buff->local;
+    if (reset) {
+        buff->shared->w = 0;
+        buff->shared->tail = 0;
+        buff->shared->wseq = 0;
+        buff->shared->r = 0;
+        buff->shared->rseq = 0;
+    }
+
+#if RINGBUFF_USE_MAGIC
+    buff->magic1 = 0xDEADBEEF;
+    buff->magic2 = ~0xDEADBEEF;
+#endif /* RINGBUFF_USE_MAGIC */
+
+    return 1;
+}
+
+/**
+ * \brief           Copy data to buffer at free-running pointer, wraps at end of buffer
+ * \param[in]       buff: Buffer handle
+ * \param[in]       ptr: Free-running pointer of first byte
+ * \param[in]       data: Data to copy
+ * \param[in]       len: Number of bytes to copy
+ */
+static void
+prv_copy_to(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, size_t ptr, const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t off = BUF_IDX(buff, ptr), tocopy;
+
+    tocopy = BUF_MIN(buff->size - off, len);
+    BUF_MEMCPY(&buff->buff[off], d, tocopy);
+    if (len > tocopy) {
+        BUF_MEMCPY(buff->buff, &d[tocopy], len - tocopy);
+    }
+}
+
+/**
+ * \brief           Copy data from buffer at free-running pointer, wraps at end of buffer
+ * \param[in]       buff: Buffer handle
+ * \param[in]       ptr: Free-running pointer of first byte
+ * \param[out]      data: Memory to copy data to
+ * \param[in]       len: Number of bytes to copy
+ */
+static void
+prv_copy_from(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, size_t ptr, void* data, size_t len) {
+    uint8_t* d = data;
+    size_t off = BUF_IDX(buff, ptr), tocopy;
+
+    tocopy = BUF_MIN(buff->size - off, len);
+    BUF_MEMCPY(d, &buff->buff[off], tocopy);
+    if (len > tocopy) {
+        BUF_MEMCPY(&d[tocopy], buff->buff, len - tocopy);
+    }
+}
+
+/**
+ * \brief           Get next valid record, consumer side
+ *
+ * Record header and, when `data` is not `NULL` and record fits, its payload are copied.
+ * Copy is valid only when record was not overwritten until copy completed,
+ * otherwise search restarts at oldest valid record
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in,out]   rp: Read pointer, moved to oldest valid record when records were dropped
+ * \param[out]      hdr: Record header
+ * \param[out]      data: Memory to copy payload to, `NULL` for header only
+ * \param[in]       size: Size of `data` array in units of bytes
+ * \return          `1` if record was found, `0` if buffer is empty
+ */
+static uint8_t
+prv_get_record(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, size_t* rp, ringbuff_ovr_hdr_t* hdr, void* data, size_t size) {
+    size_t r = *rp, w, tail;
+    uint8_t complete;
+
+    while (1) {
+        w = buff->shared->w;
+        tail = buff->shared->tail;
+        BUF_BARRIER();                          /* Pointers before data */
+        if (BUF_BEFORE(r, tail)) {
+            r = tail;                           /* Records were dropped */
+        }
+        if (r == w) {
+            *rp = r;
+            return 0;
+        }
+
+        prv_copy_from(buff, r, hdr, sizeof(*hdr));
+        complete = hdr->len <= buff->size && BUF_REC_LEN(hdr->len) <= w - r;
+        if (complete && data != NULL && hdr->len <= size) {
+            prv_copy_from(buff, r + sizeof(*hdr), data, hdr->len);
+        }
+
+        BUF_BARRIER();                          /* Data before tail check */
+        tail = buff->shared->tail;
+        if (BUF_BEFORE(r, tail)) {
+            r = tail;                           /* Overwritten during copy, copy is not valid */
+            continue;
+        }
+        if (!complete) {
+            r = w;                              /* Inconsistent header, skip to newest data */
+            continue;
+        }
+        *rp = r;
+        return 1;
+    }
+}
+
+/**
+ * \brief           Initialize overwrite buffer handle with pointers stored in handle itself
+ * \param[in]       buff: Buffer handle
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes, power of `2`,
+ *                      at least `2` record headers
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_ovr_init(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, void* buffdata, size_t size) {
+    return prv_init(buff, NULL, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local overwrite buffer handle with pointers in shared memory
+ *                  and reset pointers to empty buffer.
+ *
+ * Called once by core that owns shared memory, before other core attaches with \ref ringbuff_ovr_attach
+ *
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes, see \ref ringbuff_ovr_init
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_ovr_init_shared(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, RINGBUFF_VOLATILE ringbuff_ovr_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local overwrite buffer handle with pointers in shared memory,
+ *                  previously initialized by other core with \ref ringbuff_ovr_init_shared
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Pointers structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as buffer data
+ * \param[in]       size: Size of `buffdata` in units of bytes
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_ovr_attach(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, RINGBUFF_VOLATILE ringbuff_ovr_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 0);
+}
+
+/**
+ * \brief           Write record to buffer, oldest records are dropped when it does not fit.
+ *                  Function never waits for consumer and does not read its pointer
+ * \note            Only producer may call this function
+ * \param[in]       buff: Buffer handle
+ * \param[in]       data: Record payload
+ * \param[in]       len: Payload length in units of bytes, record with header must fit to buffer
+ * \return          `len` on success, `0` when record is longer than buffer
+ */
+RINGBUFF_HOT size_t
+ringbuff_ovr_write(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, const void* data, size_t len) {
+    ringbuff_ovr_hdr_t hdr;
+    size_t w, tail, total;
+
+    if (!BUF_IS_VALID(buff) || data == NULL || len == 0) {
+        return 0;
+    }
+    total = BUF_REC_LEN(len);
+    if (total > buff->size) {
+        return 0;
+    }
+
+    w = buff->shared->w;
+    tail = buff->shared->tail;
+    if (w + total - tail > buff->size) {
+        /* Drop oldest records, producer reads only headers it wrote itself */
+        do {
+            prv_copy_from(buff, tail, &hdr, sizeof(hdr));
+            tail += BUF_REC_LEN(hdr.len);
+        } while (w + total - tail > buff->size);
+        buff->shared->tail = tail;
+        BUF_BARRIER();                          /* Tail before record memory is overwritten */
+    }
+
+    hdr.seq = buff->shared->wseq;
+    hdr.len = (uint32_t)len;
+    prv_copy_to(buff, w, &hdr, sizeof(hdr));
+    prv_copy_to(buff, w + sizeof(hdr), data, len);
+    BUF_BARRIER();                              /* Data before pointer */
+    buff->shared->wseq = hdr.seq + 1;
+    buff->shared->w = w + total;
+    return len;
+}
+
+/**
+ * \brief           Read oldest valid record from buffer
+ * \note            Only consumer may call this function
+ * \param[in]       buff: Buffer handle
+ * \param[out]      data: Memory to copy record payload to
+ * \param[in]       size: Size of `data` array in units of bytes
+ * \param[out]      lost: Output variable to write number of records dropped
+ *                      before this record to. Can be set to `NULL`
+ * \return          Payload length in units of bytes, `0` if buffer is empty
+ *                      or when record does not fit to `data` array. Record then stays in buffer,
+ *                      use \ref ringbuff_ovr_peek_len to get its length
+ */
+RINGBUFF_HOT size_t
+ringbuff_ovr_read(RINGBUFF_VOLATILE ringbuff_ovr_t* buff, void* data, size_t size, uint32_t* lost) {
+    ringbuff_ovr_hdr_t hdr;
+    size_t r;
+
+    if (lost != NULL) {
+        *lost = 0;
+    }
+    if (!BUF_IS_VALID(buff) || data == NULL) {
+        return 0;
+    }
+
+    r = buff->shared->r;
+    if (!prv_get_record(buff, &r, &hdr, data, size) || hdr.len > size) {
+        buff->shared->r = r;                    /* Keep position of oldest valid record */
+        return 0;
+    }
+    if (lost != NULL) {
+        *lost = hdr.seq - buff->shared->rseq;
+    }
+    buff->shared->rseq = hdr.seq + 1;
+    buff->shared->r = r + BUF_REC_LEN(hdr.len);
+    return hdr.len;
+}
+
+/**
+ * \brief           Get payload length of oldest valid record
+ * \note            Only consumer may call this function
+ * \param[in]       buff: Buffer handle
+ * \return          Payload length in units of bytes, `0` if buffer is empty
+ */
+size_t
+ringbuff_ovr_peek_len(RINGBUFF_VOLATILE ringbuff_ovr_t* buff) {
+    ringbuff_ovr_hdr_t hdr;
+    size_t r;
+
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
+    }
+    r = buff->shared->r;
+    return prv_get_record(buff, &r, &hdr, NULL, 0) ? hdr.len : 0;
+}
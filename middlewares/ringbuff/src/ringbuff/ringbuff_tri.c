@@ -0,0 +1,244 @@
+/**
+ * \file            ringbuff_tri.c
+ * \brief           Triple buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         v1.3.1
+ */
+#include <stddef.h>
+#include "ringbuff/ringbuff_tri.h"
+
+/* Memory set function */
+#define BUF_MEMSET                      memset
+
+#if RINGBUFF_USE_MAGIC
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->magic1 == 0xDEADBEEF && (b)->magic2 == ~0xDEADBEEF && (b)->buff != NULL && (b)->size > 0)
+#else
+#define BUF_IS_VALID(b)                 ((b) != NULL && (b)->buff != NULL && (b)->size > 0)
+#endif /* RINGBUFF_USE_MAGIC */
+
+/* Barrier between index and frame access, see ringbuff.c */
+#if RINGBUFF_USE_SPSC
+#define BUF_BARRIER()                   RINGBUFF_MEMORY_BARRIER()
+#else
+#define BUF_BARRIER()                   do {} while (0)
+#endif /* RINGBUFF_USE_SPSC */
+
+/* Fields of `latest` index */
+#define BUF_LATEST_IDX(l)               ((l) & 0x03)
+#define BUF_LATEST_VER(l)               ((l) >> 2)
+
+/* Frame data of index */
+#define BUF_FRAME(b, i)                 (&(b)->buff[(size_t)(i) * (b)->size])
+
+/*
+ * Reader announces frame and re-checks `latest` only after announcement is visible.
+ * When writer picked announced frame before it saw announcement,
+ * frame was not completed yet, so `latest` held other frame and reader retries.
+ * When writer picks next frame after announcement, announced frame is skipped
+ */
+
+/**
+ * \brief           Setup buffer handle and attach it to indexes
+ * \param[in]       buff: Buffer handle
+ * \param[in]       shared: Indexes structure. Set to `NULL` to use handle local indexes
+ * \param[in]       buffdata: Pointer to memory to use as data of `3` frames
+ * \param[in]       size: Size of one frame in units of bytes
+ * \param[in]       reset: Set to `1` to reset indexes to buffer without frame, `0` to keep their current value
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_init(RINGBUFF_VOLATILE ringbuff_tri_t* buff, RINGBUFF_VOLATILE ringbuff_tri_shared_t* shared,
+            void* buffdata, size_t size, uint8_t reset) {
+    if (buff == NULL || buffdata == NULL || size == 0) {
+        return 0;
+    }
+
+    BUF_MEMSET((void *)buff, 0x00, sizeof(*buff));
+
+    buff->size = size;
+    buff->buff = buffdata;
+    buff->shared = shared != NULL ? shared : &buff->local;
+    if (reset) {
+        buff->shared->latest = 0;
+        buff->shared->wr = 1;
+        buff->shared->reading = RINGBUFF_TRI_NONE;
+    }
+
+#if RINGBUFF_USE_MAGIC
+    buff->magic1 = 0xDEADBEEF;
+    buff->magic2 = ~0xDEADBEEF;
+#endif /* RINGBUFF_USE_MAGIC */
+
+    return 1;
+}
+
+/**
+ * \brief           Initialize triple buffer handle with indexes stored in handle itself
+ * \param[in]       buff: Buffer handle
+ * \param[in]       buffdata: Pointer to memory to use as data of `3` frames, `3 * size` bytes
+ * \param[in]       size: Size of one frame in units of bytes.
+ *                      Use multiple of `4` to keep every frame aligned as `buffdata`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_tri_init(RINGBUFF_VOLATILE ringbuff_tri_t* buff, void* buffdata, size_t size) {
+    return prv_init(buff, NULL, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local triple buffer handle with indexes in shared memory
+ *                  and reset indexes to buffer without frame.
+ *
+ * Called once by core that owns shared memory, before other core attaches with \ref ringbuff_tri_attach
+ *
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Indexes structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as data of `3` frames
+ * \param[in]       size: Size of one frame in units of bytes, see \ref ringbuff_tri_init
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_tri_init_shared(RINGBUFF_VOLATILE ringbuff_tri_t* buff, RINGBUFF_VOLATILE ringbuff_tri_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 1);
+}
+
+/**
+ * \brief           Initialize core-local triple buffer handle with indexes in shared memory,
+ *                  previously initialized by other core with \ref ringbuff_tri_init_shared
+ * \param[in]       buff: Core-local buffer handle
+ * \param[in]       shared: Indexes structure in shared memory
+ * \param[in]       buffdata: Pointer to memory to use as data of `3` frames
+ * \param[in]       size: Size of one frame in units of bytes
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_tri_attach(RINGBUFF_VOLATILE ringbuff_tri_t* buff, RINGBUFF_VOLATILE ringbuff_tri_shared_t* shared, void* buffdata, size_t size) {
+    if (shared == NULL) {
+        return 0;
+    }
+    return prv_init(buff, shared, buffdata, size, 0);
+}
+
+/**
+ * \brief           Get frame to write next, neither newest completed frame nor frame used by reader.
+ *                  Frame is filled in place and published with \ref ringbuff_tri_write_commit
+ * \note            Only writer may call this function
+ * \param[in]       buff: Buffer handle
+ * \return          Frame data of buffer frame size, `NULL` on invalid handle
+ */
+RINGBUFF_HOT void *
+ringbuff_tri_write_acquire(RINGBUFF_VOLATILE ringbuff_tri_t* buff) {
+    uint32_t latest, reading, wr;
+
+    if (!BUF_IS_VALID(buff)) {
+        return NULL;
+    }
+
+    latest = BUF_LATEST_IDX(buff->shared->latest);
+    BUF_BARRIER();                              /* Previous commit before reader index check */
+    reading = buff->shared->reading;
+    for (wr = 0; wr == latest || wr == reading; ++wr) {}
+    buff->shared->wr = wr;
+    BUF_BARRIER();                              /* Reader index before frame is written */
+    return BUF_FRAME(buff, wr);
+}
+
+/**
+ * \brief           Publish frame from \ref ringbuff_tri_write_acquire as newest completed frame
+ * \note            Only writer may call this function
+ * \param[in]       buff: Buffer handle
+ * \return          `1` on success, `0` otherwise
+ */
+RINGBUFF_HOT uint8_t
+ringbuff_tri_write_commit(RINGBUFF_VOLATILE ringbuff_tri_t* buff) {
+    uint32_t ver;
+
+    if (!BUF_IS_VALID(buff)) {
+        return 0;
+    }
+
+    ver = BUF_LATEST_VER(buff->shared->latest) + 1;
+    if (BUF_LATEST_VER(ver << 2) == 0) {
+        ver = 1;                                /* Version `0` means no frame */
+    }
+    BUF_BARRIER();                              /* Frame data before index */
+    buff->shared->latest = (ver << 2) | buff->shared->wr;
+    return 1;
+}
+
+/**
+ * \brief           Get newest completed frame, it stays valid until next call
+ *                  or \ref ringbuff_tri_read_release
+ * \note            Only reader may call this function
+ * \param[in]       buff: Buffer handle
+ * \param[out]      version: Output variable to write frame version to, incremented with every commit.
+ *                      Compare with previous value to detect new frame. Can be set to `NULL`
+ * \return          Frame data, `NULL` if no frame was committed yet
+ */
+RINGBUFF_HOT const void *
+ringbuff_tri_read_acquire(RINGBUFF_VOLATILE ringbuff_tri_t* buff, uint32_t* version) {
+    uint32_t latest;
+
+    if (!BUF_IS_VALID(buff)) {
+        return NULL;
+    }
+
+    do {
+        latest = buff->shared->latest;
+        if (BUF_LATEST_VER(latest) == 0) {
+            return NULL;
+        }
+        buff->shared->reading = BUF_LATEST_IDX(latest);
+        BUF_BARRIER();                          /* Announcement before index check */
+    } while (buff->shared->latest != latest);   /* Writer committed meanwhile, retry with newer frame */
+
+    if (version != NULL) {
+        *version = BUF_LATEST_VER(latest);
+    }
+    return BUF_FRAME(buff, BUF_LATEST_IDX(latest));
+}
+
+/**
+ * \brief           Release frame from \ref ringbuff_tri_read_acquire,
+ *                  writer may reuse it afterwards
+ * \note            Only reader may call this function
+ * \param[in]       buff: Buffer handle
+ */
+void
+ringbuff_tri_read_release(RINGBUFF_VOLATILE ringbuff_tri_t* buff) {
+    if (!BUF_IS_VALID(buff)) {
+        return;
+    }
+    BUF_BARRIER();                              /* Frame reads before release */
+    buff->shared->reading = RINGBUFF_TRI_NONE;
+}
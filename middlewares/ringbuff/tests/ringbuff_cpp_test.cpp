@@ -0,0 +1,213 @@
+/**
+ * \file            ringbuff_cpp_test.cpp
+ * \brief           C producer and C++ template consumer interoperability test, host build
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "ringbuff/ringbuff.h"
+#include "ringbuff/ringbuff.hpp"
+
+/*
+ * C handle and template are attached to the same pointers and data array.
+ * C producer writes whole slots with ringbuff_write, template consumer pops elements.
+ * Element is 12-byte record, stored in slots of 16 bytes.
+ *
+ * First pass fills and drains buffer in steps, so pointers wrap at end of data array
+ * and at every position of slot. Second pass runs producer and consumer in 2 threads,
+ * build with RINGBUFF_TSAN to check ordering of data and pointer accesses
+ */
+
+/* Capacity in units of elements, power of 2 */
+#define CPP_TEST_CAPACITY                   64
+
+/* Default number of elements of threaded pass */
+#define CPP_TEST_DEFAULT_COUNT              0x00100000
+
+/**
+ * \brief           Record with size not power of 2
+ */
+struct record {
+    uint32_t seq;                               /*!< Sequence number */
+    uint32_t val;                               /*!< Value derived from sequence number */
+    uint16_t id;                                /*!< Low bits of sequence number */
+    uint16_t chk;                               /*!< Check word of other fields */
+};
+
+typedef ringbuff_cpp::ringbuff<record, CPP_TEST_CAPACITY> record_rb_t;
+
+static_assert(sizeof(record) == 12, "Record must be 12 bytes");
+static_assert(record_rb_t::stride == 16, "Slot must be 16 bytes");
+
+static ringbuff_shared_t shared;
+static record_rb_t::slot_type data[CPP_TEST_CAPACITY];
+static ringbuff_t rb_tx;
+
+/**
+ * \brief           Build record for sequence number
+ * \param[in]       seq: Sequence number
+ * \return          Record
+ */
+static record
+prv_record(uint32_t seq) {
+    record rec;
+
+    rec.seq = seq;
+    rec.val = seq * 2654435761UL;
+    rec.id = (uint16_t)seq;
+    rec.chk = (uint16_t)(rec.val ^ (rec.val >> 16) ^ rec.id);
+    return rec;
+}
+
+/**
+ * \brief           Write record as one slot with \ref ringbuff_write
+ * \param[in]       seq: Sequence number
+ * \return          `1` on success, `0` if buffer is full
+ */
+static uint8_t
+prv_write(uint32_t seq) {
+    uint8_t slot[record_rb_t::stride] = {0};
+    record rec = prv_record(seq);
+
+    memcpy(slot, &rec, sizeof(rec));
+    return ringbuff_write(&rb_tx, slot, sizeof(slot)) == sizeof(slot);
+}
+
+/**
+ * \brief           Check popped record
+ * \param[in]       rec: Record
+ * \param[in]       seq: Expected sequence number
+ * \return          `1` when record is intact, `0` otherwise
+ */
+static uint8_t
+prv_check(const record& rec, uint32_t seq) {
+    record exp = prv_record(seq);
+
+    return memcmp(&rec, &exp, sizeof(rec)) == 0;
+}
+
+/**
+ * \brief           Fill and drain buffer in steps, check full, empty and wrap-around
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_run_steps(record_rb_t& rb) {
+    uint32_t wseq = 0, rseq = 0;
+    record rec;
+
+    for (size_t step = 1; step <= CPP_TEST_CAPACITY; ++step) {
+        /* Fill to capacity, next write must fail */
+        while (prv_write(wseq)) {
+            ++wseq;
+        }
+        if (rb.size() != CPP_TEST_CAPACITY || wseq - rseq != CPP_TEST_CAPACITY) {
+            printf("step %zu: buffer not full, %zu elements\r\n", step, rb.size());
+            return 0;
+        }
+
+        /* Drain `step` elements, data array wraps at different slots */
+        for (size_t i = 0; i < step; ++i, ++rseq) {
+            if (!rb.pop(rec) || !prv_check(rec, rseq)) {
+                printf("step %zu: wrong element %u\r\n", step, (unsigned)rseq);
+                return 0;
+            }
+        }
+    }
+
+    /* Empty buffer completely */
+    while (rb.pop(rec)) {
+        if (!prv_check(rec, rseq++)) {
+            printf("drain: wrong element %u\r\n", (unsigned)(rseq - 1));
+            return 0;
+        }
+    }
+    return rseq == wseq && rb.empty() && ringbuff_get_full(&rb_tx) == 0;
+}
+
+/**
+ * \brief           Run C producer and template consumer in 2 threads
+ * \param[in]       rb: Template consumer
+ * \param[in]       count: Number of elements
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_run_threads(record_rb_t& rb, uint32_t count) {
+    size_t errors = 0;
+    std::thread tx([count]() {
+        for (uint32_t seq = 0; seq < count;) {
+            if (prv_write(seq)) {
+                ++seq;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    record rec;
+
+    for (uint32_t seq = 0; seq < count;) {
+        if (!rb.pop(rec)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!prv_check(rec, seq) && errors++ == 0) {
+            printf("threads: wrong element %u\r\n", (unsigned)seq);
+        }
+        ++seq;
+    }
+    tx.join();
+    return errors == 0 && rb.empty();
+}
+
+/**
+ * \brief           Run test
+ * \param[in]       argc: Number of arguments
+ * \param[in]       argv: Optional number of elements of threaded pass
+ * \return          `0` on success, `1` on error
+ */
+int
+main(int argc, char** argv) {
+    uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : CPP_TEST_DEFAULT_COUNT;
+    uint8_t ok;
+
+    if (!ringbuff_init_shared(&rb_tx, &shared, data, sizeof(data))) {
+        return 1;
+    }
+    record_rb_t rb(&shared, data);
+
+    ok = prv_run_steps(rb);
+    printf("%-32s %s\r\n", "write/pop steps", ok ? "OK" : "FAIL");
+    if (ok) {
+        ok = prv_run_threads(rb, count);
+        printf("%-32s %s\r\n", "write/pop threads", ok ? "OK" : "FAIL");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,372 @@
+/**
+ * \file            ringbuff_stress.c
+ * \brief           Two-thread stress and throughput test, host build
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ring buffer library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ringbuff/ringbuff.h"
+#include "ringbuff/ringbuff_fast.h"
+
+/*
+ * Producer thread emulates CPU2 and consumer thread emulates CPU1.
+ * Each thread has its own handle, attached to the same pointers and data array,
+ * same as handles of both cores are attached to shared RAM.
+ *
+ * Producer writes byte stream with known pattern in chunks of varying length,
+ * consumer checks every byte. Each API variant is run in turn and its throughput is reported.
+ * Build with RINGBUFF_TSAN to check ordering of data and pointer accesses
+ */
+
+/* Buffer size, power of 2 */
+#define STRESS_BUFF_SIZE                    0x00001000
+
+/* Maximum chunk length of single write */
+#define STRESS_CHUNK_MAX                    0x00000180
+
+/* Default number of bytes per API variant */
+#define STRESS_DEFAULT_LEN                  0x01000000
+
+/* Pattern byte at stream offset */
+#define STRESS_PATTERN(n)                   ((uint8_t)((n) ^ ((n) >> 8) ^ ((n) >> 16)))
+
+static ringbuff_shared_t shared;
+static uint8_t data[STRESS_BUFF_SIZE];
+static ringbuff_t rb_tx, rb_rx;
+
+/**
+ * \brief           API variant under test
+ */
+typedef struct {
+    const char* name;                           /*!< Variant name in report */
+    size_t (*tx)(ringbuff_t* rb, const uint8_t* d, size_t len);     /*!< Write up to `len` bytes, returns number written */
+    size_t (*rx)(ringbuff_t* rb, uint8_t* d, size_t len);           /*!< Read up to `len` bytes, returns number read */
+    uint8_t msg;                                /*!< Set to `1` when each write is one message, read returns whole message */
+} stress_variant_t;
+
+static const stress_variant_t* variant;
+static size_t total_len;
+static size_t errors, tx_errors;
+
+/**
+ * \brief           Write with \ref ringbuff_write
+ */
+static size_t
+tx_write(ringbuff_t* rb, const uint8_t* d, size_t len) {
+    return ringbuff_write(rb, d, len);
+}
+
+/**
+ * \brief           Read with \ref ringbuff_read
+ */
+static size_t
+rx_read(ringbuff_t* rb, uint8_t* d, size_t len) {
+    return ringbuff_read(rb, d, len);
+}
+
+/**
+ * \brief           Write with \ref ringbuff_writev, chunk in 3 fragments, all or nothing
+ */
+static size_t
+tx_writev(ringbuff_t* rb, const uint8_t* d, size_t len) {
+    ringbuff_iovec_t iov[3] = {
+        { d, len / 4 },
+        { &d[len / 4], len / 2 - len / 4 },
+        { &d[len / 2], len - len / 2 },
+    };
+
+    if (ringbuff_get_free(rb) < len) {
+        return 0;
+    }
+    return ringbuff_writev(rb, iov, 3);
+}
+
+/**
+ * \brief           Read with \ref ringbuff_peek and \ref ringbuff_skip
+ */
+static size_t
+rx_peek_skip(ringbuff_t* rb, uint8_t* d, size_t len) {
+    len = ringbuff_peek(rb, 0, d, len);
+    return ringbuff_skip(rb, len);
+}
+
+/**
+ * \brief           Write with \ref ringbuff_write_reserve and \ref ringbuff_write_commit,
+ *                  shortened to linear free memory
+ */
+static size_t
+tx_reserve(ringbuff_t* rb, const uint8_t* d, size_t len) {
+    size_t lin = ringbuff_get_linear_block_write_length(rb);
+    void* ptr;
+
+    len = len < lin ? len : lin;
+    if (len == 0 || (ptr = ringbuff_write_reserve(rb, len)) == NULL) {
+        return 0;
+    }
+    memcpy(ptr, d, len);
+    return ringbuff_write_commit(rb, len);
+}
+
+/**
+ * \brief           Read with \ref ringbuff_read_acquire and \ref ringbuff_read_release
+ */
+static size_t
+rx_acquire(ringbuff_t* rb, uint8_t* d, size_t len) {
+    void *ptr1, *ptr2;
+    size_t len1, len2, n;
+
+    if (ringbuff_read_acquire(rb, &ptr1, &len1, &ptr2, &len2) == 0) {
+        return 0;
+    }
+    n = len1 < len ? len1 : len;
+    memcpy(d, ptr1, n);
+    if (n < len && len2 > 0) {
+        len2 = len2 < len - n ? len2 : len - n;
+        memcpy(&d[n], ptr2, len2);
+        n += len2;
+    }
+    return ringbuff_read_release(rb, n);
+}
+
+/**
+ * \brief           Write with linear block address and \ref ringbuff_advance
+ */
+static size_t
+tx_advance(ringbuff_t* rb, const uint8_t* d, size_t len) {
+    size_t lin = ringbuff_get_linear_block_write_length(rb);
+
+    len = len < lin ? len : lin;
+    if (len == 0) {
+        return 0;
+    }
+    memcpy(ringbuff_get_linear_block_write_address(rb), d, len);
+    return ringbuff_advance(rb, len);
+}
+
+/**
+ * \brief           Read with linear block address and \ref ringbuff_skip
+ */
+static size_t
+rx_linear(ringbuff_t* rb, uint8_t* d, size_t len) {
+    size_t lin = ringbuff_get_linear_block_read_length(rb);
+
+    len = len < lin ? len : lin;
+    if (len == 0) {
+        return 0;
+    }
+    memcpy(d, ringbuff_get_linear_block_read_address(rb), len);
+    return ringbuff_skip(rb, len);
+}
+
+/**
+ * \brief           Write with \ref ringbuff_fast_write
+ */
+static size_t
+tx_fast(ringbuff_t* rb, const uint8_t* d, size_t len) {
+    return ringbuff_fast_write(rb, d, len);
+}
+
+/**
+ * \brief           Read with \ref ringbuff_fast_read
+ */
+static size_t
+rx_fast(ringbuff_t* rb, uint8_t* d, size_t len) {
+    return ringbuff_fast_read(rb, d, len);
+}
+
+/**
+ * \brief           Send chunk as message with \ref ringbuff_msg_send
+ */
+static size_t
+tx_msg(ringbuff_t* rb, const uint8_t* d, size_t len) {
+    return ringbuff_msg_send(rb, d, len) > 0 ? len : 0;
+}
+
+/**
+ * \brief           Receive message with \ref ringbuff_msg_recv
+ */
+static size_t
+rx_msg(ringbuff_t* rb, uint8_t* d, size_t len) {
+    return ringbuff_msg_recv(rb, d, len);
+}
+
+/**
+ * \brief           Receive burst of messages with \ref ringbuff_msg_recv_batch,
+ *                  copy payloads that fit to `d` and release them together
+ */
+static size_t
+rx_msg_batch(ringbuff_t* rb, uint8_t* d, size_t len) {
+    ringbuff_msg_span_t spans[4];
+    size_t n, i, out = 0;
+
+    n = ringbuff_msg_recv_batch(rb, spans, sizeof(spans) / sizeof(spans[0]));
+    for (i = 0; i < n && out + spans[i].len1 + spans[i].len2 <= len; ++i) {
+        memcpy(&d[out], spans[i].ptr1, spans[i].len1);
+        out += spans[i].len1;
+        if (spans[i].len2 > 0) {
+            memcpy(&d[out], spans[i].ptr2, spans[i].len2);
+            out += spans[i].len2;
+        }
+    }
+    if (i > 0 && ringbuff_msg_recv_batch_release(rb, i) != i) {
+        return 0;
+    }
+    return out;
+}
+
+static const stress_variant_t variants[] = {
+    { "write/read", tx_write, rx_read, 0 },
+    { "writev/peek+skip", tx_writev, rx_peek_skip, 0 },
+    { "reserve+commit/acquire+release", tx_reserve, rx_acquire, 0 },
+    { "advance/linear+skip", tx_advance, rx_linear, 0 },
+    { "fast_write/fast_read", tx_fast, rx_fast, 0 },
+    { "msg_send/msg_recv", tx_msg, rx_msg, 1 },
+    { "msg_send/msg_recv_batch", tx_msg, rx_msg_batch, 1 },
+};
+
+/**
+ * \brief           Producer thread, emulates CPU2
+ * \param[in]       arg: Unused
+ * \return          `NULL`
+ */
+static void*
+prv_producer(void* arg) {
+    uint8_t chunk[STRESS_CHUNK_MAX];
+    size_t off = 0, len, written;
+    uint32_t seed = 1;
+
+    (void)arg;
+    while (off < total_len) {
+        seed = seed * 1103515245 + 12345;
+        len = 1 + (seed >> 16) % STRESS_CHUNK_MAX;
+        if (len > total_len - off) {
+            len = total_len - off;
+        }
+        for (size_t i = 0; i < len; ++i) {
+            chunk[i] = STRESS_PATTERN(off + i);
+        }
+
+        /* Message is written in full, byte stream may be written in parts */
+        for (size_t done = 0; done < len; done += written) {
+            written = variant->tx(&rb_tx, &chunk[done], len - done);
+            if (written == 0) {
+                sched_yield();                  /* Let consumer run on single CPU */
+            } else if (variant->msg && written != len) {
+                ++tx_errors;
+            }
+        }
+        off += len;
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Consumer thread, emulates CPU1
+ * \param[in]       arg: Unused
+ * \return          `NULL`
+ */
+static void*
+prv_consumer(void* arg) {
+    uint8_t chunk[STRESS_CHUNK_MAX];
+    size_t off = 0, len;
+
+    (void)arg;
+    while (off < total_len) {
+        len = variant->rx(&rb_rx, chunk, sizeof(chunk));
+        if (len == 0) {
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < len; ++i) {
+            if (chunk[i] != STRESS_PATTERN(off + i)) {
+                if (errors++ == 0) {
+                    fprintf(stderr, "%s: mismatch at offset %zu\r\n", variant->name, off + i);
+                }
+                break;
+            }
+        }
+        off += len;
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Run one API variant
+ * \param[in]       v: Variant
+ * \return          `1` when all data were received intact, `0` otherwise
+ */
+static uint8_t
+prv_run(const stress_variant_t* v) {
+    struct timespec start, stop;
+    pthread_t tx, rx;
+    double sec;
+
+    variant = v;
+    errors = tx_errors = 0;
+    if (!ringbuff_init_shared(&rb_tx, &shared, data, sizeof(data))
+        || !ringbuff_attach(&rb_rx, &shared, data, sizeof(data))) {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&rx, NULL, prv_consumer, NULL);
+    pthread_create(&tx, NULL, prv_producer, NULL);
+    pthread_join(tx, NULL);
+    pthread_join(rx, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    errors += tx_errors;
+    sec = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%-32s %8.2f MB/s %s\r\n", v->name, sec > 0 ? (double)total_len / sec / 1e6 : 0.0,
+            errors == 0 && ringbuff_get_full(&rb_rx) == 0 ? "OK" : "FAIL");
+    return errors == 0 && ringbuff_get_full(&rb_rx) == 0;
+}
+
+/**
+ * \brief           Run all API variants
+ * \param[in]       argc: Number of arguments
+ * \param[in]       argv: Optional number of bytes per variant
+ * \return          `0` on success, `1` on data error
+ */
+int
+main(int argc, char** argv) {
+    uint8_t ok = 1;
+
+    total_len = argc > 1 ? strtoul(argv[1], NULL, 0) : STRESS_DEFAULT_LEN;
+    printf("Buffer %u bytes, %zu bytes per variant\r\n", (unsigned)STRESS_BUFF_SIZE, total_len);
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); ++i) {
+        ok &= prv_run(&variants[i]);
+    }
+    return ok ? 0 : 1;
+}
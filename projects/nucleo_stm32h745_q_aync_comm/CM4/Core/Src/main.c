@@ -5,13 +5,190 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
 #include "main.h"
 #include "common.h"
+#include "ringbuff/ringbuff_fast.h"
+#include "copy_bench.h"
+#include "mem_bench.h"
+#include "ipc_bench.h"
+#include "ipc_blog.h"
+#include "ipc_lat.h"
+#include "ipc_notify.h"
+#include "ipc_chan.h"
+#include "ipc_boot.h"
+#include "ipc_clk.h"
+#include "ipc_hb.h"
+#include "ipc_idle.h"
+#include "ipc_job.h"
+#include "ipc_rpmsg.h"
+#include "ipc_fwu.h"
+#include "ipc_scan.h"
+#include "ipc_mon.h"
+#include "ipc_load.h"
+#include "ipc_frec.h"
+#include "ipc_sched.h"
+#include "ipc_lane.h"
+#include "ipc_rpc.h"
+#include "ipc_pubsub.h"
+#include "ipc_pool.h"
+#include "ipc_pingpong.h"
+#include "ipc_mpmc.h"
+#include "ipc_steal.h"
+#include "ipc_signal.h"
+#include "ipc_soak.h"
+#include "ipc_time.h"
+#include "ipc_wait.h"
+#include "ringbuff_blocking.h"
+#include "ringbuff_printf.h"
+#include "ringbuff_trace.h"
+#include "ringbuff_crc.h"
+#include "ringbuff_i2c.h"
 
-/* Ringbuffer variables */
-volatile ringbuff_t* rb_cm4_to_cm7 = (void *)BUFF_CM4_TO_CM7_ADDR;
-volatile ringbuff_t* rb_cm7_to_cm4 = (void *)BUFF_CM7_TO_CM4_ADDR;
+/* Ringbuffer variables, handles are core-local, pointers and data are in shared memory */
+ringbuff_t rb_cm4_to_cm7;
+ringbuff_t rb_cm7_to_cm4;
+ringbuff_t rb_ctrl_cm4_to_cm7;
+ringbuff_t rb_ctrl_cm7_to_cm4;
+
+/* Control and bulk lane from CPU1, control messages are served first */
+static ipc_lane_rx_t lane_rx;
+
+/* Control lane to CPU1 */
+ipc_lane_tx_t ctrl_tx;
+
+/* RPC server, requests on rb_ctrl_cm7_to_cm4 and responses on rb_ctrl_cm4_to_cm7 */
+static ipc_rpc_server_t rpc_srv;
+static int32_t rpc_echo(const void* args, size_t len, void* res, size_t* res_len);
+static int32_t rpc_led(const void* args, size_t len, void* res, size_t* res_len);
+static const ipc_rpc_method_t rpc_methods[] = {
+    { IPC_RPC_METHOD_ECHO, rpc_echo },
+    { IPC_RPC_METHOD_LED, rpc_led },
+#if IPC_DVFS
+    { IPC_RPC_METHOD_CLK_PAUSE, ipc_clk_rpc_pause },
+#endif /* IPC_DVFS */
+#if IPC_HB
+    { IPC_RPC_METHOD_HEARTBEAT, ipc_hb_rpc_beat },
+#endif /* IPC_HB */
+};
+
+#if IPC_POOL
+ringbuff_t rb_pool_cm4_to_cm7;
+ringbuff_t rb_pool_ret_cm7_to_cm4;
+
+/* Allocator of pool blocks, frames are written in place and only descriptors are sent to CPU1 */
+static ipc_pool_tx_t pool_tx;
+#endif /* IPC_POOL */
+
+#if IPC_BLOG
+ringbuff_t rb_blog_cm4_to_cm7;
+#endif /* IPC_BLOG */
+
+#if IPC_JOB
+ringbuff_t rb_job_cm7_to_cm4;
+ringbuff_t rb_job_ret_cm4_to_cm7;
+
+/* Executor of jobs offloaded by CPU1 */
+static ipc_job_worker_t job_worker;
+static int32_t job_crc32(const void* args, size_t len, void* res, size_t* res_len);
+static const ipc_job_entry_t job_fns[] = {
+    { IPC_JOB_FN_CRC32, job_crc32 },
+};
+#endif /* IPC_JOB */
+
+#if IPC_RPMSG
+ringbuff_t rb_rpmsg_cm7_to_cm4;
+ringbuff_t rb_rpmsg_cm4_to_cm7;
+
+/* RPMsg device of CPU2 with echo endpoint, bound by name to CPU1 endpoint */
+static struct rpmsg_device rpmsg_dev;
+static struct rpmsg_endpoint rpmsg_echo;
+static int rpmsg_echo_cb(struct rpmsg_endpoint* ept, void* data, size_t len, uint32_t src, void* priv);
+#endif /* IPC_RPMSG */
+
+#if IPC_FWU
+/* New image chunks from CPU1, programmed to bank 2 */
+ringbuff_t rb_fwu_cm7_to_cm4;
+#endif /* IPC_FWU */
+
+#if IPC_ACQ
+ringbuff_t rb_acq_cm4_to_cm7;
+I2C_HandleTypeDef hi2c1;
+DMA_HandleTypeDef hdma_i2c1_rx;
+
+/* Sensor register blocks on Arduino header I2C, read once per IPC_ACQ_PERIOD_MS */
+static const ringbuff_i2c_sensor_t acq_sensors[] = {
+    { 0x48, 0x00, I2C_MEMADD_SIZE_8BIT, 2 },    /* Temperature sensor, temperature register */
+    { 0x68, 0x3B, I2C_MEMADD_SIZE_8BIT, 14 },   /* Inertial sensor, accelerometer, temperature and gyroscope */
+};
+
+/* DMA reads sensors directly to ACQ_CM4_TO_CM7 channel memory */
+static ringbuff_i2c_acq_t acq;
+static void acq_done(ringbuff_i2c_acq_t* a, size_t records);
+#endif /* IPC_ACQ */
+
+#if IPC_PUBSUB
+/* Publisher of sensor samples, each CPU1 subscriber reads them from single copy in shared RAM */
+static ipc_topic_pub_t sensor_pub;
+#endif /* IPC_PUBSUB */
+
+#if IPC_PP
+/* Producer of sample blocks, CPU1 processes them in place */
+static ipc_pp_t dsp_tx;
+#endif /* IPC_PP */
+
+#if IPC_MPMC
+/* Work items shared with CPU1, pushed and executed by both cores */
+static ipc_mpmc_t work_q;
+#endif /* IPC_MPMC */
+
+#if IPC_STEAL
+/* Job deque of CPU2, CPU1 steals from it when it runs out of own jobs */
+static ipc_steal_t steal_w;
+static void steal_spin(const void* args, size_t len);
+static const ipc_steal_entry_t steal_fns[] = {
+    { IPC_STEAL_FN_SPIN, steal_spin },
+};
+#endif /* IPC_STEAL */
+
+/* Set from HSEM interrupt when CPU1 wrote data to rb_cm7_to_cm4, rb_ctrl_cm7_to_cm4, jobs or work items */
+static volatile uint8_t rb_cm7_to_cm4_pending = 1;
+
+#if IPC_SCHED
+/* LED blink, timer task */
+static ipc_sched_task_t led_tsk;
+#endif /* IPC_SCHED */
+
+#if IPC_SCAN
+/* Set by integrity scan alarm, LED stays on instead of blinking */
+static volatile uint8_t scan_fault;
+#endif /* IPC_SCAN */
+
+/* Doorbell coalescing for writes to rb_cm4_to_cm7 */
+static ipc_notify_coalesce_t rb_cm4_to_cm7_coalesce;
 static void led_init(void);
+static void led_task(void* arg);
+#if IPC_ACQ
+static void MX_DMA_Init(void);
+static void MX_I2C1_Init(void);
+#endif /* IPC_ACQ */
+#if IPC_SCAN
+static void scan_alarm(uint32_t id, ipc_scan_err_t err);
+#endif /* IPC_SCAN */
+#if IPC_DVFS
+static void clk_evt(ipc_clk_evt_t evt);
+#endif /* IPC_DVFS */
+static void rb_cm7_to_cm4_notify(uint32_t sem_id, void* arg);
+#if COPY_BENCH || MEM_BENCH
+static void bench_out(const char* str, size_t len);
+#endif /* COPY_BENCH || MEM_BENCH */
+#if IPC_LAT
+static void lat_out(const char* str, size_t len);
+#endif /* IPC_LAT */
+#if IPC_LOAD
+static void load_report(void);
+#endif /* IPC_LOAD */
 
 /**
  * \brief           The application entry point
@@ -19,15 +196,20 @@ static void led_init(void);
 int
 main(void) {
     uint32_t i = 0, time, t1, t2;
+#if IPC_LAT
+    uint32_t t3;
+#endif /* IPC_LAT */
+#if IPC_ACQ
+    uint32_t t4;
+#endif /* IPC_ACQ */
+
+#if IPC_FREC
+    /* Keep events of previous boots and record this boot, before any IPC event */
+    ipc_frec_init();
+#endif /* IPC_FREC */
 
-    /* CPU2 goes to STOP mode and waits CPU1 to initialize all the steps first */
-    /* CPU1 will wakeup CPU2 with semaphore take and release events */
-    /* HW semaphore Clock enable */
-    __HAL_RCC_HSEM_CLK_ENABLE();
-    HAL_HSEM_ActivateNotification(HSEM_WAKEUP_CPU2_MASK);
-    HAL_PWREx_ClearPendingEvent();
-    HAL_PWREx_EnterSTOPMode(PWR_MAINREGULATOR_ON, PWR_STOPENTRY_WFE, PWR_D2_DOMAIN);
-    __HAL_HSEM_CLEAR_FLAG(HSEM_WAKEUP_CPU2_MASK);
+    /* Tell CPU1 we are alive, local init runs in parallel with CPU1 */
+    ipc_boot_start();
 
     /* MCU Configuration--------------------------------------------------------*/
 
@@ -37,58 +219,744 @@ main(void) {
     /* Init LED3 */
     led_init();
 
+    /* Sleep until CPU1 configured clocks and published channel directory */
+    if (!ipc_boot_wait(IPC_BOOT_CPU1, IPC_BOOT_STAGE_CHANNELS, IPC_BOOT_TIMEOUT_US)) {
+        Error_Handler();
+    }
+
+    /* Take clocks published by CPU1, before SysTick and cycle counter are used */
+    ipc_clk_sync();
+#if IPC_DVFS
+    ipc_clk_set_evt_fn(clk_evt);
+#endif /* IPC_DVFS */
+
+#if RINGBUFF_USE_STATS || RINGBUFF_USE_RATE
+    /* Time base of buffer statistics and rate limits */
+    CYCCNT_INIT();
+#endif /* RINGBUFF_USE_STATS || RINGBUFF_USE_RATE */
+
+#if RINGBUFF_USE_TRACE
+    /* Trace buffer events to SWO, before channels are created */
+    ringbuff_trace_init();
+#endif /* RINGBUFF_USE_TRACE */
+#if RINGBUFF_USE_MSG_CRC
+    /* CRC unit of message integrity, before messages are sent or received */
+    ringbuff_crc_init();
+#endif /* RINGBUFF_USE_MSG_CRC */
+#if IPC_LOAD
+    /* Account load with clocks of CPU1, own entry of control part is cleared */
+    ipc_load_init();
+#endif /* IPC_LOAD */
+#if IPC_ACQ
+    /* Sensor bus, I2C kernel clock is independent of clock profile */
+    MX_DMA_Init();
+    MX_I2C1_Init();
+#endif /* IPC_ACQ */
+
+#if IPC_LAT
+    /* Start latency timebase, shared with CPU1 */
+    ipc_lat_timebase_init();
+#endif /* IPC_LAT */
+
     /*
-     * Wait for buffers to be ready by CPU1
-     *
-     * This should not wait and should go straight through
+     * Attach to channels found in directory,
+     * published by CPU1 before boot stage reached channels
      */
-    while (!ringbuff_is_ready(rb_cm4_to_cm7) || !ringbuff_is_ready(rb_cm7_to_cm4)) {}
+    if (!ipc_chan_open(IPC_CHAN_CM4_TO_CM7, &rb_cm4_to_cm7)
+        || !ipc_chan_open(IPC_CHAN_CM7_TO_CM4, &rb_cm7_to_cm4)
+        || !ipc_chan_open(IPC_CHAN_CTRL_CM4_TO_CM7, &rb_ctrl_cm4_to_cm7)
+        || !ipc_chan_open(IPC_CHAN_CTRL_CM7_TO_CM4, &rb_ctrl_cm7_to_cm4)) {
+        Error_Handler();
+    }
+#if IPC_POOL
+    if (!ipc_chan_open(IPC_CHAN_POOL_CM4_TO_CM7, &rb_pool_cm4_to_cm7)
+        || !ipc_chan_open(IPC_CHAN_POOL_RET_CM7_TO_CM4, &rb_pool_ret_cm7_to_cm4)
+        || !ipc_pool_tx_init(&pool_tx, &rb_pool_cm4_to_cm7, &rb_pool_ret_cm7_to_cm4, HSEM_POOL_CM4_TO_CM7)) {
+        Error_Handler();
+    }
+#endif /* IPC_POOL */
+#if IPC_BLOG
+    if (!ipc_chan_open(IPC_CHAN_BLOG_CM4_TO_CM7, &rb_blog_cm4_to_cm7)
+        || !ipc_blog_init(&rb_blog_cm4_to_cm7)) {
+        Error_Handler();
+    }
+#endif /* IPC_BLOG */
+#if IPC_JOB
+    if (!ipc_chan_open(IPC_CHAN_JOB_CM7_TO_CM4, &rb_job_cm7_to_cm4)
+        || !ipc_chan_open(IPC_CHAN_JOB_RET_CM4_TO_CM7, &rb_job_ret_cm4_to_cm7)
+        || !ipc_job_worker_init(&job_worker, &rb_job_cm7_to_cm4, &rb_job_ret_cm4_to_cm7, HSEM_JOB_RET_CM4_TO_CM7,
+                                job_fns, sizeof(job_fns) / sizeof(job_fns[0]))) {
+        Error_Handler();
+    }
+#endif /* IPC_JOB */
+#if IPC_RPMSG
+    if (!ipc_chan_open(IPC_CHAN_RPMSG_CM7_TO_CM4, &rb_rpmsg_cm7_to_cm4)
+        || !ipc_chan_open(IPC_CHAN_RPMSG_CM4_TO_CM7, &rb_rpmsg_cm4_to_cm7)
+        || !ipc_rpmsg_init(&rpmsg_dev, &rb_rpmsg_cm4_to_cm7, &rb_rpmsg_cm7_to_cm4, HSEM_RPMSG_CM4_TO_CM7, NULL)
+        || rpmsg_create_ept(&rpmsg_echo, &rpmsg_dev, IPC_RPMSG_ECHO_NAME, RPMSG_ADDR_ANY, RPMSG_ADDR_ANY,
+                            rpmsg_echo_cb, NULL) != RPMSG_SUCCESS) {
+        Error_Handler();
+    }
+#endif /* IPC_RPMSG */
+#if IPC_FWU
+    if (!ipc_chan_open(IPC_CHAN_FWU_CM7_TO_CM4, &rb_fwu_cm7_to_cm4)) {
+        Error_Handler();
+    }
+#endif /* IPC_FWU */
+#if IPC_ACQ
+    if (!ipc_chan_open(IPC_CHAN_ACQ_CM4_TO_CM7, &rb_acq_cm4_to_cm7)
+        || !ringbuff_i2c_init(&acq, &hi2c1, &rb_acq_cm4_to_cm7, acq_sensors,
+                              sizeof(acq_sensors) / sizeof(acq_sensors[0]), acq_done)) {
+        Error_Handler();
+    }
+#endif /* IPC_ACQ */
+#if IPC_SCAN
+    ipc_scan_init(scan_alarm);
+#endif /* IPC_SCAN */
+    ipc_lane_rx_init(&lane_rx, &rb_ctrl_cm7_to_cm4, &rb_cm7_to_cm4, IPC_LANE_BULK_EVERY);
+    ipc_lane_tx_init(&ctrl_tx, &rb_ctrl_cm4_to_cm7, HSEM_CTRL_CM4_TO_CM7);
+    ipc_rpc_server_init(&rpc_srv, &rb_ctrl_cm4_to_cm7, HSEM_CTRL_CM4_TO_CM7,
+        rpc_methods, sizeof(rpc_methods) / sizeof(rpc_methods[0]));
+#if IPC_MON
+    ipc_mon_attach();
+#endif /* IPC_MON */
+    ipc_boot_advance(IPC_BOOT_STAGE_ATTACHED);
+
+#if IPC_BENCH
+    /* Serve CPU1 pipe benchmark, returns when CPU1 finished */
+    ipc_bench_serve(&rb_cm7_to_cm4, &rb_cm4_to_cm7);
+#endif /* IPC_BENCH */
+#if IPC_SOAK
+    /* Stream verified data with CPU1 at full rate, never returns */
+    ipc_soak_run(&rb_cm4_to_cm7, &rb_cm7_to_cm4, NULL);
+#endif /* IPC_SOAK */
+    ipc_notify_listen(HSEM_CM7_TO_CM4, rb_cm7_to_cm4_notify, NULL);
+    ipc_notify_listen(HSEM_CTRL_CM7_TO_CM4, rb_cm7_to_cm4_notify, NULL);
+#if IPC_JOB
+    ipc_notify_listen(HSEM_JOB_CM7_TO_CM4, rb_cm7_to_cm4_notify, NULL);
+#endif /* IPC_JOB */
+#if IPC_RPMSG
+    ipc_notify_listen(HSEM_RPMSG_CM7_TO_CM4, rb_cm7_to_cm4_notify, NULL);
+#endif /* IPC_RPMSG */
+#if IPC_FWU
+    ipc_notify_listen(HSEM_FWU_CM7_TO_CM4, rb_cm7_to_cm4_notify, NULL);
+#endif /* IPC_FWU */
+    ipc_notify_coalesce_init(&rb_cm4_to_cm7_coalesce, &rb_cm4_to_cm7, HSEM_CM4_TO_CM7,
+        IPC_CM4_TO_CM7_NOTIFY_LEVEL, IPC_CM4_TO_CM7_NOTIFY_COUNT, IPC_CM4_TO_CM7_NOTIFY_TIMEOUT_US);
+
+#if IPC_PUBSUB
+    /* Slow subscriber skips samples, publisher never waits for CPU1 */
+    ipc_topic_pub_init(&sensor_pub, IPC_TOPIC_SENSOR, IPC_TOPIC_DROP);
+#endif /* IPC_PUBSUB */
+#if IPC_PP
+    ipc_pp_init(&dsp_tx, IPC_PP_DSP);
+#endif /* IPC_PP */
+#if IPC_MPMC
+    ipc_mpmc_init(&work_q, IPC_MPMC_WORK);
+    ipc_notify_listen(HSEM_MPMC(IPC_MPMC_WORK), rb_cm7_to_cm4_notify, NULL);
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+    ipc_steal_init(&steal_w, steal_fns, sizeof(steal_fns) / sizeof(steal_fns[0]));
+    ipc_notify_listen(HSEM_STEAL(0), rb_cm7_to_cm4_notify, NULL);
+#endif /* IPC_STEAL */
+
+    /* Write message to buffer, CPU1 doorbell is rung by coalescing policy */
+    ringbuff_printf(&rb_cm4_to_cm7, "[CM4] Core ready, %u MHz\r\n", (unsigned)(SystemCoreClock / 1000000));
+#if IPC_LAT
+    ipc_lat_stamp(IPC_CHAN_CM4_TO_CM7);
+#endif /* IPC_LAT */
+
+#if COPY_BENCH
+    /* Measure copy kernels, report is forwarded to UART by CPU1 */
+    copy_bench_run(bench_out);
+#endif /* COPY_BENCH */
 
-    /* Write message to buffer */
-    ringbuff_write(rb_cm4_to_cm7, "[CM4] Core ready\r\n", 18);
+#if MEM_BENCH
+    /* Measure bus matrix paths to all placement regions, report is forwarded to UART by CPU1 */
+    mem_bench_run(bench_out);
+#endif /* MEM_BENCH */
+
+#if IPC_SCHED
+    ipc_sched_task_init(&led_tsk, led_task, NULL);
+    ipc_sched_timer_start(&led_tsk, 500, 500);
+#endif /* IPC_SCHED */
 
     /* Set default time */
     time = t1 = t2 = HAL_GetTick();
+#if IPC_LAT
+    t3 = time;
+#endif /* IPC_LAT */
+#if IPC_ACQ
+    t4 = time;
+#endif /* IPC_ACQ */
     while (1) {
-        size_t len;
-        void* addr;
+        size_t len, len1, len2;
+        void *addr1, *addr2;
 
+#if IPC_DVFS
+        /* CPU1 changes clocks, wait with SysTick stopped until they are published */
+        if (ipc_clk_poll()) {
+            continue;
+        }
+#endif /* IPC_DVFS */
         time = HAL_GetTick();
+#if IPC_RESIZE
+        /* Channels are re-carved by CPU1, no access until handles are attached again */
+        if (ipc_chan_resize_poll()) {
+            continue;
+        }
+#endif /* IPC_RESIZE */
 
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_SEND);
+#endif /* IPC_LOAD */
         /* Send data to CPU1 */
         if (time - t1 >= 1000) {
             t1 = time;
             char c = '0' + (++i % 10);
+            ringbuff_iovec_t iov[] = {
+                { "[CM4] Number: ", 14 },
+                { &c, 1 },
+                { "\r\n", 2 },
+            };
+
+            /* Write to buffer from CPU2 to CPU1, whole line at once */
+            ringbuff_writev(&rb_cm4_to_cm7, iov, sizeof(iov) / sizeof(iov[0]));
+#if IPC_LAT
+            ipc_lat_stamp(IPC_CHAN_CM4_TO_CM7);
+#endif /* IPC_LAT */
+#if IPC_BLOG
+            /* Record with 2 arguments is 20 bytes, CPU1 renders text */
+            IPC_LOG("[CM4] Number: %u, tick: %u\r\n", i, time);
+#endif /* IPC_BLOG */
+#if IPC_POOL
+            {
+                /* Fill frame in pool block, CPU1 reads it in place */
+                uint8_t* frame = ipc_pool_alloc(&pool_tx);
+
+                if (frame != NULL) {
+                    memset(frame, (uint8_t)i, IPC_POOL_DATA_LEN);
+                    ipc_pool_send(&pool_tx, frame, IPC_POOL_DATA_LEN);
+
+                    /* Log frame here, hold extra reference with ipc_pool_retain while it is used later */
+                    ipc_pool_put(&pool_tx, frame);  /* Block is free once CPU1 released it */
+                }
+            }
+#endif /* IPC_POOL */
+#if IPC_PUBSUB
+            {
+                /* Publish sample once, for all subscribers */
+                uint32_t sample[2] = { time, i };
+
+                ipc_topic_publish(&sensor_pub, sample, sizeof(sample));
+            }
+#endif /* IPC_PUBSUB */
+#if IPC_PP
+            {
+                /* Fill next block with samples, skipped when CPU1 still processes it */
+                int16_t* block = ipc_pp_tx_acquire(&dsp_tx);
+
+                if (block != NULL) {
+                    for (size_t k = 0; k < dsp_tx.block_len / sizeof(*block); ++k) {
+                        block[k] = (int16_t)(i * k);
+                    }
+                    ipc_pp_tx_commit(&dsp_tx);
+                }
+            }
+#endif /* IPC_PP */
+#if IPC_STEAL
+            {
+                /* Burst of jobs to own deque, CPU1 steals two thirds of it when idle */
+                uint32_t iters = 10000;
+
+                for (size_t k = 0; k < 6; ++k) {
+                    ipc_steal_submit(&steal_w, IPC_STEAL_FN_SPIN, &iters, sizeof(iters));
+                }
+                ipc_steal_flush(&steal_w);
+            }
+#endif /* IPC_STEAL */
+        }
 
-            /* Write to buffer from CPU2 to CPU1 */
-            ringbuff_write(rb_cm4_to_cm7, "[CM4] Number: ", 14);
-            ringbuff_write(rb_cm4_to_cm7, &c, 1);
-            ringbuff_write(rb_cm4_to_cm7, "\r\n", 2);
+#if IPC_ACQ
+        /* Read all sensors, records reach CPU1 without copy by CPU2 */
+        if (time - t4 >= IPC_ACQ_PERIOD_MS) {
+            t4 = time;
+            ringbuff_i2c_start(&acq);
         }
+#endif /* IPC_ACQ */
 
+#if IPC_LAT
+        /* Report latency of both directions, forwarded to UART by CPU1 */
+        if (time - t3 >= IPC_LAT_REPORT_MS) {
+            t3 = time;
+            ipc_lat_report(lat_out);
+#if IPC_IDLE_STOP
+            {
+                /* Wake-to-first-byte latency of stop mode */
+                ipc_idle_stats_t st;
+                char str[80];
+                int n;
+
+                ipc_idle_get_stats(&st);
+                n = sprintf(str, "[IDLE] stops:%u wakes:%u avg:%u max:%u ns\r\n", (unsigned)st.stops,
+                            (unsigned)st.wakes, (unsigned)st.wake_avg_ns, (unsigned)st.wake_max_ns);
+                lat_out(str, n);
+            }
+#endif /* IPC_IDLE_STOP */
+#if IPC_HB
+            {
+                /* Heartbeat round trip measured by CPU1 */
+                ipc_hb_shared_t hb;
+                char str[80];
+                int n;
+
+                ipc_hb_get_stats(&hb);
+                n = sprintf(str, "[HB] acked:%u lost:%u rtt last:%u avg:%u max:%u ns\r\n", (unsigned)hb.acked,
+                            (unsigned)hb.lost, (unsigned)hb.rtt_last_ns, (unsigned)hb.rtt_avg_ns, (unsigned)hb.rtt_max_ns);
+                lat_out(str, n);
+            }
+#endif /* IPC_HB */
+#if IPC_TIME
+            {
+                /* Shared time and cost of reading it on CPU2 */
+                uint64_t now;
+                uint32_t c1, c2;
+                char str[64];
+                int n;
+
+                c1 = CYCCNT_GET();
+                now = ipc_now_ns();
+                c2 = CYCCNT_GET();
+                n = sprintf(str, "[TIME] now:%u us cost:%u cycles\r\n", (unsigned)(now / 1000), (unsigned)(c2 - c1));
+                lat_out(str, n);
+            }
+#endif /* IPC_TIME */
+#if IPC_STEAL
+            for (uint32_t core = 0; core < 2; ++core) {
+                /* Load balance of work-stealing deques */
+                ipc_steal_stats_t st;
+                char str[96];
+                int n;
+
+                ipc_steal_get_stats(core, &st);
+                n = sprintf(str, "[STEAL] CPU%u run:%u stolen:%u steals:%u full:%u lat avg:%u max:%u us\r\n",
+                            (unsigned)core + 1, (unsigned)st.executed, (unsigned)st.stolen, (unsigned)st.steals,
+                            (unsigned)st.full, (unsigned)st.lat_avg_us, (unsigned)st.lat_max_us);
+                lat_out(str, n);
+            }
+#endif /* IPC_STEAL */
+        }
+#endif /* IPC_LAT */
+
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_APP);
+        if (ipc_load_poll(time)) {
+            load_report();
+        }
+#endif /* IPC_LOAD */
+#if IPC_SCHED
+        /* Run tasks posted by timers and interrupts */
+        ipc_sched_run();
+#else
         /* Toggle LED */
         if (time - t2 >= 500) {
             t2 = time;
-            HAL_GPIO_TogglePin(LD3_GPIO_PORT, LD3_GPIO_PIN);
+            led_task(NULL);
+        }
+#endif /* IPC_SCHED */
+
+        /* Ring CPU1 doorbell for writes pending longer than timeout */
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_SEND);
+#endif /* IPC_LOAD */
+        ipc_notify_coalesce_poll(&rb_cm4_to_cm7_coalesce);
+
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_RECV);
+#endif /* IPC_LOAD */
+
+        /*
+         * Drain data CPU1 sent to CPU2 core, once notified.
+         * Control messages are served before bulk data, bulk block is served
+         * at least once every IPC_LANE_BULK_EVERY control messages.
+         * Handles were validated at initialization
+         */
+        if (rb_cm7_to_cm4_pending) {
+            ipc_lane_t lane;
+
+            rb_cm7_to_cm4_pending = 0;
+            while ((lane = ipc_lane_next(&lane_rx)) != IPC_LANE_NONE) {
+                if (lane == IPC_LANE_CTRL) {
+                    uint8_t cmd[sizeof(ipc_rpc_hdr_t) + IPC_RPC_MAX_LEN];
+                    size_t cmd_len;
+
+                    /* Control messages from CPU1 are RPC requests */
+                    if ((cmd_len = ipc_lane_ctrl_recv(&rb_ctrl_cm7_to_cm4, cmd, sizeof(cmd))) <= sizeof(cmd)) {
+                        ipc_rpc_serve(&rpc_srv, cmd, cmd_len);
+                    }
+                    continue;
+                }
+                if ((len = ringbuff_fast_read_acquire(&rb_cm7_to_cm4, &addr1, &len1, &addr2, &len2)) > 0) {
+                    /*
+                     * `addr1` holds pointer to beginning of data array
+                     * which can be used directly in linear form.
+                     *
+                     * Its length is `len1` bytes. When data overflow end of buffer,
+                     * rest of data are available at `addr2` with `len2` bytes
+                     */
+                    /* Process data here */
+
+                    /* Mark buffer as read to allow other writes from CPU1 */
+                    ringbuff_fast_read_release(&rb_cm7_to_cm4, len);
+                }
+            }
+        }
+
+#if IPC_JOB
+        /*
+         * Execute jobs offloaded by CPU1, one completion doorbell per batch.
+         * Polled on every wakeup, jobs stay queued while completion channel is full
+         */
+        ipc_job_worker_poll(&job_worker);
+#endif /* IPC_JOB */
+#if IPC_RPMSG
+        /* Deliver CPU1 RPMsg messages to endpoints */
+        ipc_rpmsg_poll(&rpmsg_dev);
+#endif /* IPC_RPMSG */
+#if IPC_FWU
+        /* Take update of CPU1, does not return once header is received */
+        ipc_fwu_poll(&rb_fwu_cm7_to_cm4);
+#endif /* IPC_FWU */
+#if IPC_MPMC
+        {
+            /* Execute work items, CPU1 takes from the same ring when it is free first */
+            uint8_t item[IPC_MPMC_LEN_WORK];
+
+            while (ipc_mpmc_pop(&work_q, item)) {
+                /* Execute work item here */
+            }
+        }
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+        /* Run own jobs newest first, then steal share of CPU1 jobs until both deques are empty */
+        ipc_steal_poll(&steal_w);
+#endif /* IPC_STEAL */
+
+        /* Sleep until doorbell or systick */
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_IDLE);
+#endif /* IPC_LOAD */
+        __disable_irq();
+        if (!rb_cm7_to_cm4_pending
+            /* Cycle counter of coalescing timeout stops in sleep */
+            && rb_cm4_to_cm7_coalesce.pending == 0
+#if IPC_SCHED
+            && ipc_sched_is_idle()
+#endif /* IPC_SCHED */
+            ) {
+#if IPC_IDLE_STOP
+            /* Stop core until doorbell when nothing is due, pipe data stay retained in D3 domain */
+            if (ipc_sched_timers_armed() == 0
+                && ringbuff_get_full(&rb_cm7_to_cm4) == 0 && ringbuff_get_full(&rb_ctrl_cm7_to_cm4) == 0
+#if IPC_JOB
+                && ringbuff_get_full(&rb_job_cm7_to_cm4) == 0
+#endif /* IPC_JOB */
+#if IPC_RPMSG
+                && ringbuff_get_full(&rb_rpmsg_cm7_to_cm4) == 0
+#endif /* IPC_RPMSG */
+#if IPC_FWU
+                && ringbuff_get_full(&rb_fwu_cm7_to_cm4) == 0
+#endif /* IPC_FWU */
+                ) {
+                ipc_notify_coalesce_flush(&rb_cm4_to_cm7_coalesce);
+                ipc_idle_stop();
+            } else {
+                __WFI();
+            }
+#else
+            __WFI();
+#endif /* IPC_IDLE_STOP */
+        }
+        __enable_irq();
+    }
+}
+
+#if IPC_SCAN
+/**
+ * \brief           Shared channel corruption found, called from integrity scan in periodic task
+ * \param[in]       id: Channel ID or \ref IPC_SCAN_ID_DIR
+ * \param[in]       err: Check result
+ */
+static void
+scan_alarm(uint32_t id, ipc_scan_err_t err) {
+    (void)id;
+    (void)err;
+    scan_fault = 1;
+}
+#endif /* IPC_SCAN */
+
+/**
+ * \brief           Toggle LED and raise sync signal, every 500 ms
+ * \param[in]       arg: User argument
+ */
+static void
+led_task(void* arg) {
+#if IPC_SCAN
+    /* Low priority integrity check of shared channels, part of all channels in each run */
+    ipc_scan_run(IPC_SCAN_STEPS);
+    if (scan_fault) {
+        HAL_GPIO_WritePin(LD3_GPIO_PORT, LD3_GPIO_PIN, GPIO_PIN_SET);
+    } else {
+        HAL_GPIO_TogglePin(LD3_GPIO_PORT, LD3_GPIO_PIN);
+    }
+#else
+    HAL_GPIO_TogglePin(LD3_GPIO_PORT, LD3_GPIO_PIN);
+#endif /* IPC_SCAN */
+    ipc_signal_raise(IPC_SIGNAL_SYNC);          /* CPU1 toggles LD2 in sync */
+}
+
+#if IPC_DVFS
+/**
+ * \brief           Clock change event, called from main loop
+ * \param[in]       evt: Event type
+ */
+static void
+clk_evt(ipc_clk_evt_t evt) {
+#if IPC_LAT
+    if (evt == IPC_CLK_EVT_RESUME) {
+        ipc_lat_timebase_init();                /* Timer clock follows APB1 */
+    }
+#endif /* IPC_LAT */
+}
+#endif /* IPC_DVFS */
+
+#if IPC_JOB
+/**
+ * \brief           CRC-32 job, polynomial `0x04C11DB7` reflected, as in Ethernet and zlib
+ * \param[in]       args: Data
+ * \param[in]       len: Data length in units of bytes
+ * \param[out]      res: CRC value, 4 bytes
+ * \param[in,out]   res_len: Result length
+ * \return          \ref IPC_JOB_OK
+ */
+static int32_t
+job_crc32(const void* args, size_t len, void* res, size_t* res_len) {
+    const uint8_t* d = args;
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= d[i];
+        for (size_t b = 0; b < 8; ++b) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
         }
+    }
+    crc = ~crc;
+    memcpy(res, &crc, sizeof(crc));
+    *res_len = sizeof(crc);
+    return IPC_JOB_OK;
+}
+#endif /* IPC_JOB */
+
+#if IPC_RPMSG
+/**
+ * \brief           Echo endpoint, payload is sent back to sender from channel memory
+ * \param[in]       ept: Endpoint
+ * \param[in]       data: Payload
+ * \param[in]       len: Payload length in units of bytes
+ * \param[in]       src: Address of sending endpoint
+ * \param[in]       priv: Private data
+ * \return          \ref RPMSG_SUCCESS
+ */
+static int
+rpmsg_echo_cb(struct rpmsg_endpoint* ept, void* data, size_t len, uint32_t src, void* priv) {
+    rpmsg_sendto(ept, data, (int)len, src);
+    return RPMSG_SUCCESS;
+}
+#endif /* IPC_RPMSG */
+
+#if IPC_STEAL
+/**
+ * \brief           Busy loop job of work-stealing deques, stands for real work
+ * \param[in]       args: Number of iterations, 4 bytes
+ * \param[in]       len: Length of arguments in units of bytes
+ */
+static void
+steal_spin(const void* args, size_t len) {
+    uint32_t n;
 
-        /* Check if CPU1 sent some data to CPU2 core */
-        while ((len = ringbuff_get_linear_block_read_length(rb_cm7_to_cm4)) > 0) {
-            addr = ringbuff_get_linear_block_read_address(rb_cm7_to_cm4);
+    if (len < sizeof(n)) {
+        return;
+    }
+    memcpy(&n, args, sizeof(n));
+    while (n-- > 0) {
+        __NOP();
+    }
+}
+#endif /* IPC_STEAL */
+
+#if IPC_ACQ
+/**
+ * \brief           Sensor scan finished, called from I2C interrupt
+ * \param[in]       a: Acquisition handle
+ * \param[in]       records: Number of records committed in scan
+ */
+static void
+acq_done(ringbuff_i2c_acq_t* a, size_t records) {
+    ipc_notify(HSEM_ACQ_CM4_TO_CM7);            /* Single doorbell per scan */
+}
+
+/**
+ * \brief           I2C memory read complete callback
+ * \param[in]       hi2c: I2C handle
+ */
+void
+HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c == &hi2c1) {
+        ringbuff_i2c_cplt(&acq);
+    }
+}
 
-            /*
-             * `addr` holds pointer to beginning of data array
-             * which can be used directly in linear form.
-             *
-             * Its length is `len` bytes
-             */
-            /* Process data here */
+/**
+ * \brief           I2C error callback, transfer was aborted
+ * \param[in]       hi2c: I2C handle
+ */
+void
+HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c == &hi2c1) {
+        ringbuff_i2c_error(&acq);
+    }
+}
 
-            /* Mark buffer as read to allow other writes from CPU1 */
-            ringbuff_skip(rb_cm7_to_cm4, len);
+/**
+ * \brief           Enable DMA controller clock and sensor DMA stream interrupt
+ */
+static void
+MX_DMA_Init(void) {
+    /* DMA controller clock enable */
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    /* DMA interrupt init */
+    /* DMA2_Stream0_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+
+/**
+ * \brief           I2C1 Initialization Function, standard mode
+ */
+static void
+MX_I2C1_Init(void) {
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.Timing = IPC_ACQ_I2C_TIMING;
+    hi2c1.Init.OwnAddress1 = 0;
+    hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+    hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+    hi2c1.Init.OwnAddress2 = 0;
+    hi2c1.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
+    hi2c1.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+    hi2c1.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+    if (HAL_I2C_Init(&hi2c1) != HAL_OK) {
+        Error_Handler();
+    }
+    if (HAL_I2CEx_ConfigAnalogFilter(&hi2c1, I2C_ANALOGFILTER_ENABLE) != HAL_OK) {
+        Error_Handler();
+    }
+    if (HAL_I2CEx_ConfigDigitalFilter(&hi2c1, 0) != HAL_OK) {
+        Error_Handler();
+    }
+}
+#endif /* IPC_ACQ */
+
+/**
+ * \brief           CPU1 doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+rb_cm7_to_cm4_notify(uint32_t sem_id, void* arg) {
+    rb_cm7_to_cm4_pending = 1;
+}
+
+/**
+ * \brief           RPC method \ref IPC_RPC_METHOD_ECHO, result is copy of arguments
+ */
+static int32_t
+rpc_echo(const void* args, size_t len, void* res, size_t* res_len) {
+    if (len > *res_len) {
+        return IPC_RPC_ERR_ARGS;
+    }
+    memcpy(res, args, len);
+    *res_len = len;
+    return IPC_RPC_OK;
+}
+
+/**
+ * \brief           RPC method \ref IPC_RPC_METHOD_LED, sets LD3 to first argument byte
+ */
+static int32_t
+rpc_led(const void* args, size_t len, void* res, size_t* res_len) {
+    *res_len = 0;
+    if (len < 1) {
+        return IPC_RPC_ERR_ARGS;
+    }
+    HAL_GPIO_WritePin(LD3_GPIO_PORT, LD3_GPIO_PIN, *(const uint8_t *)args ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    return IPC_RPC_OK;
+}
+
+#if COPY_BENCH || MEM_BENCH
+/**
+ * \brief           Output copy and bus matrix benchmark reports to CPU1
+ * \param[in]       str: Text to output
+ * \param[in]       len: Length of text in units of bytes
+ */
+static void
+bench_out(const char* str, size_t len) {
+    /*
+     * Full buffer is above coalescing level threshold,
+     * doorbell is already rung when writer has to wait for CPU1
+     */
+    ringbuff_write_blocking(&rb_cm4_to_cm7, str, len, IPC_WAIT_FOREVER);
+    ipc_notify_coalesce_flush(&rb_cm4_to_cm7_coalesce);
+}
+#endif /* COPY_BENCH || MEM_BENCH */
+
+#if IPC_LAT
+/**
+ * \brief           Output latency report to CPU1
+ * \param[in]       str: Text to output
+ * \param[in]       len: Length of text in units of bytes
+ */
+static void
+lat_out(const char* str, size_t len) {
+    if (ringbuff_write_all(&rb_cm4_to_cm7, str, len) == RINGBUFF_WOULD_BLOCK) {
+        return;
+    }
+    ipc_lat_stamp(IPC_CHAN_CM4_TO_CM7);
+}
+#endif /* IPC_LAT */
+
+#if IPC_LOAD
+/**
+ * \brief           Output load of both cores to CPU1, once CPU2 published its period
+ */
+static void
+load_report(void) {
+    static const char* const names[IPC_LOAD_COUNT] = { "app", "send", "recv", "fwd", "idle" };
+    ipc_load_shared_t st;
+    char str[160];
+    int n = 0;
+
+    for (uint32_t core = 0; core < 2; ++core) {
+        ipc_load_get_stats(core, &st);
+        n += sprintf(&str[n], "%sCPU%u", core ? " " : "[LOAD] ", (unsigned)core + 1);
+        for (size_t b = 0; b < IPC_LOAD_COUNT; ++b) {
+            n += sprintf(&str[n], " %s:%u.%u%%", names[b], (unsigned)(st.permille[b] / 10), (unsigned)(st.permille[b] % 10));
         }
     }
+    n += sprintf(&str[n], "\r\n");
+    ringbuff_write_all(&rb_cm4_to_cm7, str, n);
 }
+#endif /* IPC_LOAD */
 
 /**
  * \brief           Initialize LEDs controlled by core
@@ -111,5 +979,5 @@ led_init(void) {
  */
 void
 Error_Handler(void) {
-
+    while (1) {}
 }
@@ -30,6 +30,7 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include "ringbuff/ringbuff.h"
 
 
 /* Variables */
@@ -37,6 +38,7 @@
 extern int errno;
 extern int __io_putchar(int ch) __attribute__((weak));
 extern int __io_getchar(void) __attribute__((weak));
+extern ringbuff_t rb_cm4_to_cm7;
 
 register char * stack_ptr asm("sp");
 
@@ -78,13 +80,18 @@ __attribute__((weak)) int _read(int file, char *ptr, int len)
 return len;
 }
 
+/*
+ * CPU2 has no UART, standard output and error go to rb_cm4_to_cm7
+ * and CPU1 forwards them to UART. Output is written in full or dropped
+ * when buffer is full or not opened yet, caller never waits for CPU1.
+ * Use ringbuff_printf to format directly to the buffer, without stdio buffer
+ */
 __attribute__((weak)) int _write(int file, char *ptr, int len)
 {
-	int DataIdx;
-
-	for (DataIdx = 0; DataIdx < len; DataIdx++)
+	if ((file == 1 || file == 2) && len > 0)
 	{
-		__io_putchar(*ptr++);
+		/* Whole line or nothing, CPU1 never forwards a torn message */
+		ringbuff_write_all(&rb_cm4_to_cm7, ptr, len);
 	}
 	return len;
 }
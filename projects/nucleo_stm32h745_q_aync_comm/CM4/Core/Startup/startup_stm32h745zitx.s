@@ -77,6 +77,22 @@ LoopCopyDataInit:
   adds  r2, r0, r1
   cmp  r2, r3
   bcc  CopyDataInit
+/* Copy hot code from flash to RAM */
+  ldr  r0, =_sramfunc
+  ldr  r1, =_eramfunc
+  ldr  r2, =_siramfunc
+  b  LoopCopyHotCode
+
+CopyHotCode:
+  ldr  r3, [r2], #4
+  str  r3, [r0], #4
+
+LoopCopyHotCode:
+  cmp  r0, r1
+  bcc  CopyHotCode
+  dsb
+  isb
+
   ldr  r2, =_sbss
   b  LoopFillZerobss
 /* Zero fill the bss segment. */  
@@ -5,58 +5,435 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
 #include "main.h"
 #include "common.h"
+#include "copy_bench.h"
+#include "mem_bench.h"
+#include "ipc_bench.h"
+#include "ipc_blog.h"
+#include "ipc_lat.h"
+#include "ipc_notify.h"
+#include "ipc_chan.h"
+#include "ipc_boot.h"
+#include "ipc_hb.h"
+#include "ipc_peer.h"
+#include "ipc_time.h"
+#include "ipc_wait.h"
+#include "ipc_clk.h"
+#include "ipc_job.h"
+#include "ipc_rpmsg.h"
+#include "ipc_fwu.h"
+#include "ipc_scan.h"
+#include "ipc_mon.h"
+#include "ipc_load.h"
+#include "ipc_drain.h"
+#include "ipc_frec.h"
+#include "ipc_sched.h"
+#include "ipc_lane.h"
+#include "ipc_rpc.h"
+#include "ipc_pubsub.h"
+#include "ipc_pool.h"
+#include "ipc_pingpong.h"
+#include "ipc_mpmc.h"
+#include "ipc_steal.h"
+#include "ipc_signal.h"
+#include "ipc_soak.h"
+#include "ringbuff_uart.h"
+#include "ringbuff_i2c.h"
+#include "ipc_route.h"
+#include "ipc_lz_sink.h"
+#include "ipc_cobs_sink.h"
+#include "ringbuff_trace.h"
+#include "ringbuff_crc.h"
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart3;
+DMA_HandleTypeDef hdma_usart3_tx;
+DMA_HandleTypeDef hdma_usart3_rx;
 
-/* Ringbuffer variables */
-volatile ringbuff_t* rb_cm4_to_cm7 = (void *)BUFF_CM4_TO_CM7_ADDR;
-volatile ringbuff_t* rb_cm7_to_cm4 = (void *)BUFF_CM7_TO_CM4_ADDR;
+/* Forwarder of CPU2 data to UART, sends directly from rb_cm4_to_cm7 memory, or from UART sink queue with IPC_ROUTE */
+static ringbuff_uart_tx_t uart_tx;
+
+/* Forwarder of UART data to CPU2, receives directly to rb_cm7_to_cm4 memory, used by USART3 interrupt */
+ringbuff_uart_rx_t uart_rx;
+
+/* Ringbuffer variables, handles are core-local, pointers and data are in shared memory */
+ringbuff_t rb_cm4_to_cm7;
+ringbuff_t rb_cm7_to_cm4;
+ringbuff_t rb_ctrl_cm4_to_cm7;
+ringbuff_t rb_ctrl_cm7_to_cm4;
+
+/* Control lane to CPU2, control messages are served by CPU2 before bulk data of rb_cm7_to_cm4 */
+ipc_lane_tx_t ctrl_tx;
+
+/* RPC client of methods served by CPU2, requests on rb_ctrl_cm7_to_cm4 and responses on rb_ctrl_cm4_to_cm7 */
+ipc_rpc_client_t rpc_cli;
+
+/* Set from HSEM interrupt when CPU2 wrote data to rb_cm4_to_cm7 */
+static volatile uint8_t rb_cm4_to_cm7_pending = 1;
+
+/* Set from HSEM interrupt when CPU2 wrote control message to rb_ctrl_cm4_to_cm7 */
+static volatile uint8_t rb_ctrl_cm4_to_cm7_pending = 1;
+
+#if IPC_PUBSUB
+/* Subscriber of CPU2 sensor samples, other modules subscribe with their own index */
+static ipc_topic_sub_t sensor_sub;
+
+/* Set from HSEM interrupt when CPU2 published sensor sample */
+static volatile uint8_t sensor_pending = 1;
+#endif /* IPC_PUBSUB */
+
+#if IPC_POOL
+ringbuff_t rb_pool_cm4_to_cm7;
+ringbuff_t rb_pool_ret_cm7_to_cm4;
+
+/* Receiver of CPU2 pool blocks, frames are read in place in SRAM3 */
+static ipc_pool_rx_t pool_rx;
+
+/* Set from HSEM interrupt when CPU2 sent pool block */
+static volatile uint8_t pool_pending = 1;
+#endif /* IPC_POOL */
+
+#if IPC_BLOG
+/* CPU2 binary log, polled in main loop without doorbell */
+ringbuff_t rb_blog_cm4_to_cm7;
+#endif /* IPC_BLOG */
+
+#if IPC_JOB
+ringbuff_t rb_job_cm7_to_cm4;
+ringbuff_t rb_job_ret_cm4_to_cm7;
+
+/* Jobs offloaded to CPU2, queue depth and latency with ipc_job_get_stats */
+ipc_job_queue_t job_q;
+
+/* CRC jobs of one batch, submitted again when all completed */
+static ipc_job_future_t job_crc[4];
+
+/* Set from HSEM interrupt when CPU2 completed jobs */
+static volatile uint8_t job_pending = 1;
+#endif /* IPC_JOB */
+
+#if IPC_RPMSG
+ringbuff_t rb_rpmsg_cm7_to_cm4;
+ringbuff_t rb_rpmsg_cm4_to_cm7;
+
+/* RPMsg device of CPU1, OpenAMP endpoints are created on it */
+struct rpmsg_device rpmsg_dev;
+
+/* Set from HSEM interrupt when CPU2 sent RPMsg messages */
+static volatile uint8_t rpmsg_pending = 1;
+#endif /* IPC_RPMSG */
+
+#if IPC_FWU
+/* CPU2 image chunks, data in AXI SRAM */
+ringbuff_t rb_fwu_cm7_to_cm4;
+#endif /* IPC_FWU */
+
+#if IPC_ACQ
+/* CPU2 sensor records, register blocks written by CPU2 I2C DMA */
+ringbuff_t rb_acq_cm4_to_cm7;
+
+/* Records received from all sensors */
+static uint32_t acq_records;
+static void acq_rec(ipc_drain_t* d, const ringbuff_msg_span_t* span);
+
+#if IPC_DRAIN
+/* Records are consumed in doorbell interrupt, burst continues in PendSV */
+static ipc_drain_t acq_drain;
+#else
+/* Set from HSEM interrupt when CPU2 finished sensor scan */
+static volatile uint8_t acq_pending = 1;
+#endif /* IPC_DRAIN */
+#endif /* IPC_ACQ */
+
+#if IPC_PP
+/* Consumer of CPU2 sample blocks, blocks are processed in place in shared RAM */
+static ipc_pp_t dsp_rx;
+
+/* Set from HSEM interrupt when CPU2 committed sample block */
+static volatile uint8_t dsp_pending = 1;
+#endif /* IPC_PP */
+
+#if IPC_MPMC
+/* Work items shared with CPU2, pushed and executed by both cores */
+static ipc_mpmc_t work_q;
+
+/* Set from HSEM interrupt when work item was pushed by any core */
+static volatile uint8_t work_pending = 1;
+#endif /* IPC_MPMC */
+
+#if IPC_STEAL
+/* Job deque of CPU1, CPU2 steals from it when it runs out of own jobs */
+static ipc_steal_t steal_w;
+static void steal_spin(const void* args, size_t len);
+static const ipc_steal_entry_t steal_fns[] = {
+    { IPC_STEAL_FN_SPIN, steal_spin },
+};
+
+/* Set from HSEM interrupt when CPU2 queued jobs, and on own submits */
+static volatile uint8_t steal_pending = 1;
+#endif /* IPC_STEAL */
+
+#if IPC_SCHED
+/* LED blink and periodic work, timer task */
+static ipc_sched_task_t led_tsk;
+#endif /* IPC_SCHED */
+
+#if IPC_SCAN
+/* Set by integrity scan alarm, LED stays on instead of blinking */
+static volatile uint8_t scan_fault;
+#endif /* IPC_SCAN */
+
+#if IPC_DVFS
+/* Clock governor, fill level of CPU2 output selects clock profile */
+static ipc_clk_gov_t clk_gov;
+#endif /* IPC_DVFS */
+
+#if IPC_HB
+/* CPU2 health, UART data for CPU2 is received only while it answers heartbeats */
+static ipc_hb_t hb;
+static volatile uint8_t peer_alive = 1;
+#endif /* IPC_HB */
+
+#if IPC_ROUTE
+/* Queue of UART sink, in shared RAM for DMA, and in-RAM trace of CPU2 text, newest data are kept */
+ringbuff_t rb_route_uart;
+static ringbuff_t rb_route_trace;
+static uint8_t route_trace_data[IPC_ROUTE_TRACE_LEN];
+
+/* Router of CPU2 text output to UART and trace sinks */
+static ipc_router_t router;
+static ipc_sink_t sink_uart;
+static ipc_sink_t sink_trace;
+#endif /* IPC_ROUTE */
+
+#if IPC_LZ
+/* Compressing stage of UART sink, window in DTCM */
+static ipc_lz_sink_t lz_uart;
+#endif /* IPC_LZ */
+
+#if IPC_COBS
+/* Framing stage of UART sink, records are tagged with channel ID */
+static ipc_cobs_sink_t cobs_uart;
+#endif /* IPC_COBS */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
+static void MPU_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART3_UART_Init(void);
 static void led_init(void);
+static void led_task(void* arg);
+#if IPC_SCAN
+static void scan_alarm(uint32_t id, ipc_scan_err_t err);
+#endif /* IPC_SCAN */
+static void rb_cm4_to_cm7_notify(uint32_t sem_id, void* arg);
+static void rb_ctrl_cm4_to_cm7_notify(uint32_t sem_id, void* arg);
+#if IPC_PUBSUB
+static void sensor_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_PUBSUB */
+#if IPC_POOL
+static void pool_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_POOL */
+#if IPC_ACQ
+static void acq_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_ACQ */
+#if IPC_PP
+static void dsp_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_PP */
+#if IPC_MPMC
+static void work_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+static void steal_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_STEAL */
+#if IPC_JOB
+static void job_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_JOB */
+#if IPC_RPMSG
+static void rpmsg_notify(uint32_t sem_id, void* arg);
+#endif /* IPC_RPMSG */
+static void sync_signal(uint32_t id, void* arg);
+#if IPC_DVFS
+static void clk_evt(ipc_clk_evt_t evt);
+#endif /* IPC_DVFS */
+#if IPC_HB
+static void hb_evt(ipc_hb_evt_t evt);
+#endif /* IPC_HB */
+#if IPC_ROUTE
+static void sink_uart_kick(ipc_sink_t* sink);
+#endif /* IPC_ROUTE */
+static void uart_tx_done(ringbuff_uart_tx_t* tx, size_t len);
+static void uart_rx_done(ringbuff_uart_rx_t* rx, size_t len);
+#if COPY_BENCH || MEM_BENCH || IPC_BENCH || IPC_SOAK || IPC_FWU || IPC_FREC
+static void bench_out(const char* str, size_t len);
+#endif /* COPY_BENCH || MEM_BENCH || IPC_BENCH || IPC_SOAK || IPC_FWU || IPC_FREC */
 
 /**
  * \brief           The application entry point
  */
 int
 main(void) {
+#if !IPC_SCHED
     uint32_t time, t1;
+#endif /* !IPC_SCHED */
+#if IPC_LZ
+    uint8_t lz_pending = 0;
+#endif /* IPC_LZ */
+
+    /* Configure MPU before caches, shared RAM must never be cached as write-back */
+    MPU_Config();
+
+    /* Enable I-Cache and D-Cache */
+    SCB_EnableICache();
+    SCB_EnableDCache();
+
+#if IPC_FREC
+    /* Keep events of previous boots and record this boot, before any IPC event */
+    ipc_frec_init();
+#endif /* IPC_FREC */
 
     /*
+     * Write boot record to shared RAM, then start CPU2.
      * To be independent on CM4 boot option bytes config,
      * application will force second core to start by setting its relevant bit in RCC registers.
      *
-     * Application for second core will immediately enter to STOP mode.
-     * This is done in CPU2 main.c file
-     *
-     * 1. Start CPU2 core
-     * 2. Wait for CPU2 to enter low-power mode
+     * CPU2 initializes HAL in parallel and waits until channel directory stage, see ipc_boot.c
      */
+    ipc_boot_start();
     HAL_RCCEx_EnableBootCore(RCC_BOOT_C2);
-    WAIT_COND_WITH_TIMEOUT(__HAL_RCC_GET_FLAG(RCC_FLAG_D2CKRDY) != RESET, 0xFFFF);
 
     /* MCU Configuration--------------------------------------------------------*/
 
     /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
     HAL_Init();
 
+#if RINGBUFF_USE_STATS || RINGBUFF_USE_RATE
+    /* Time base of buffer statistics and rate limits */
+    CYCCNT_INIT();
+#endif /* RINGBUFF_USE_STATS || RINGBUFF_USE_RATE */
+
+#if RINGBUFF_USE_TRACE
+    /* Trace buffer events to SWO, before channels are created */
+    ringbuff_trace_init();
+#endif /* RINGBUFF_USE_TRACE */
+#if RINGBUFF_USE_MSG_CRC
+    /* CRC unit of message integrity, before messages are sent or received */
+    ringbuff_crc_init();
+#endif /* RINGBUFF_USE_MSG_CRC */
+
     /* Configure the system clock */
     SystemClock_Config();
+    ipc_boot_advance(IPC_BOOT_STAGE_CLOCKS);
+#if IPC_TIME
+    /* Shared timebase, readable by CPU2 once it attached */
+    ipc_time_init();
+#endif /* IPC_TIME */
 
-    /* Initialize buffers that are used as shared memory */
-    ringbuff_init(rb_cm7_to_cm4, (void *)BUFFDATA_CM7_TO_CM4_ADDR, BUFFDATA_CM7_TO_CM4_LEN);
-    ringbuff_init(rb_cm4_to_cm7, (void *)BUFFDATA_CM4_TO_CM7_ADDR, BUFFDATA_CM4_TO_CM7_LEN);
+    /* Create channels in shared memory and publish directory for CPU2 */
+    ipc_chan_dir_init();
+    if (!ipc_chan_create(IPC_CHAN_CM7_TO_CM4, &rb_cm7_to_cm4)
+        || !ipc_chan_create(IPC_CHAN_CM4_TO_CM7, &rb_cm4_to_cm7)
+        || !ipc_chan_create(IPC_CHAN_CTRL_CM7_TO_CM4, &rb_ctrl_cm7_to_cm4)
+        || !ipc_chan_create(IPC_CHAN_CTRL_CM4_TO_CM7, &rb_ctrl_cm4_to_cm7)) {
+        Error_Handler();
+    }
+#if IPC_POOL
+    if (!ipc_chan_create(IPC_CHAN_POOL_CM4_TO_CM7, &rb_pool_cm4_to_cm7)
+        || !ipc_chan_create(IPC_CHAN_POOL_RET_CM7_TO_CM4, &rb_pool_ret_cm7_to_cm4)
+        || !ipc_pool_rx_init(&pool_rx, &rb_pool_cm4_to_cm7, &rb_pool_ret_cm7_to_cm4, HSEM_POOL_RET_CM7_TO_CM4)) {
+        Error_Handler();
+    }
+#endif /* IPC_POOL */
+#if IPC_BLOG
+    if (!ipc_chan_create(IPC_CHAN_BLOG_CM4_TO_CM7, &rb_blog_cm4_to_cm7)) {
+        Error_Handler();
+    }
+#endif /* IPC_BLOG */
+#if IPC_JOB
+    if (!ipc_chan_create(IPC_CHAN_JOB_CM7_TO_CM4, &rb_job_cm7_to_cm4)
+        || !ipc_chan_create(IPC_CHAN_JOB_RET_CM4_TO_CM7, &rb_job_ret_cm4_to_cm7)
+        || !ipc_job_queue_init(&job_q, &rb_job_cm7_to_cm4, &rb_job_ret_cm4_to_cm7, HSEM_JOB_CM7_TO_CM4)) {
+        Error_Handler();
+    }
+#endif /* IPC_JOB */
+#if IPC_ROUTE
+    if (!ipc_chan_create(IPC_CHAN_ROUTE_UART, &rb_route_uart)) {
+        Error_Handler();
+    }
+#endif /* IPC_ROUTE */
+#if IPC_RPMSG
+    if (!ipc_chan_create(IPC_CHAN_RPMSG_CM7_TO_CM4, &rb_rpmsg_cm7_to_cm4)
+        || !ipc_chan_create(IPC_CHAN_RPMSG_CM4_TO_CM7, &rb_rpmsg_cm4_to_cm7)
+        || !ipc_rpmsg_init(&rpmsg_dev, &rb_rpmsg_cm7_to_cm4, &rb_rpmsg_cm4_to_cm7, HSEM_RPMSG_CM7_TO_CM4, NULL)) {
+        Error_Handler();
+    }
+#endif /* IPC_RPMSG */
+#if IPC_FWU
+    if (!ipc_chan_create(IPC_CHAN_FWU_CM7_TO_CM4, &rb_fwu_cm7_to_cm4)) {
+        Error_Handler();
+    }
+#endif /* IPC_FWU */
+#if IPC_ACQ
+    if (!ipc_chan_create(IPC_CHAN_ACQ_CM4_TO_CM7, &rb_acq_cm4_to_cm7)) {
+        Error_Handler();
+    }
+#endif /* IPC_ACQ */
+    ipc_chan_dir_publish();
+#if IPC_SCAN
+    ipc_scan_init(scan_alarm);
+#endif /* IPC_SCAN */
+#if IPC_MON
+    ipc_mon_init();
+#endif /* IPC_MON */
+    ipc_lane_tx_init(&ctrl_tx, &rb_ctrl_cm7_to_cm4, HSEM_CTRL_CM7_TO_CM4);
+    ipc_rpc_client_init(&rpc_cli, &rb_ctrl_cm7_to_cm4, &rb_ctrl_cm4_to_cm7, HSEM_CTRL_CM7_TO_CM4);
+#if IPC_DVFS
+    ipc_clk_gov_init(&clk_gov, &rb_cm4_to_cm7, rb_cm4_to_cm7.size * IPC_DVFS_UP_PERCENT / 100, IPC_DVFS_IDLE_MS);
+    ipc_clk_set_evt_fn(clk_evt);
+#endif /* IPC_DVFS */
 
-    /* Wakeup CPU2 */
+    /* Listen for CPU2 doorbell, before CPU2 starts writing */
     __HAL_RCC_HSEM_CLK_ENABLE();
-    HSEM_TAKE_RELEASE(HSEM_WAKEUP_CPU2);
-    WAIT_COND_WITH_TIMEOUT(__HAL_RCC_GET_FLAG(RCC_FLAG_D2CKRDY) == RESET, 0xFFFF);
+    ipc_notify_listen(HSEM_CM4_TO_CM7, rb_cm4_to_cm7_notify, NULL);
+    ipc_notify_listen(HSEM_CTRL_CM4_TO_CM7, rb_ctrl_cm4_to_cm7_notify, NULL);
+#if IPC_POOL
+    ipc_notify_listen(HSEM_POOL_CM4_TO_CM7, pool_notify, NULL);
+#endif /* IPC_POOL */
+#if IPC_JOB
+    ipc_notify_listen(HSEM_JOB_RET_CM4_TO_CM7, job_notify, NULL);
+#endif /* IPC_JOB */
+#if IPC_RPMSG
+    ipc_notify_listen(HSEM_RPMSG_CM4_TO_CM7, rpmsg_notify, NULL);
+#endif /* IPC_RPMSG */
+#if IPC_ACQ
+#if IPC_DRAIN
+    ipc_drain_init(&acq_drain, &rb_acq_cm4_to_cm7, IPC_DRAIN_MSGS, IPC_DRAIN_BUDGET_ACQ, acq_rec, NULL);
+#endif /* IPC_DRAIN */
+    ipc_notify_listen(HSEM_ACQ_CM4_TO_CM7, acq_notify, NULL);
+#endif /* IPC_ACQ */
+#if IPC_PUBSUB
+    ipc_topic_subscribe(&sensor_sub, IPC_TOPIC_SENSOR, 0);
+    ipc_notify_listen(HSEM_TOPIC(IPC_TOPIC_SENSOR), sensor_notify, NULL);
+#endif /* IPC_PUBSUB */
+#if IPC_PP
+    ipc_pp_init(&dsp_rx, IPC_PP_DSP);
+    ipc_notify_listen(HSEM_PP(IPC_PP_DSP), dsp_notify, NULL);
+#endif /* IPC_PP */
+#if IPC_MPMC
+    ipc_mpmc_init(&work_q, IPC_MPMC_WORK);
+    ipc_notify_listen(HSEM_MPMC(IPC_MPMC_WORK), work_notify, NULL);
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+    ipc_steal_init(&steal_w, steal_fns, sizeof(steal_fns) / sizeof(steal_fns[0]));
+    ipc_notify_listen(HSEM_STEAL(1), steal_notify, NULL);
+#endif /* IPC_STEAL */
+
+    /* Let CPU2 attach to channels, D2 domain runs once CPU2 started */
+    ipc_boot_advance(IPC_BOOT_STAGE_CHANNELS);
+    WAIT_COND_WITH_TIMEOUT_US(__HAL_RCC_GET_FLAG(RCC_FLAG_D2CKRDY) == RESET, IPC_BOOT_TIMEOUT_US);
 
     /*
      * Initialize other things, not being important for second core
@@ -66,50 +443,786 @@ main(void) {
      * and any attempt will result to undefined write/read
      */
 
-    /* Init LED1 */
+    /* Init LED1 and LED2 */
     led_init();
 
+    /* CPU2 sync pulse, delivered by semaphore interrupt without ring buffer */
+    ipc_signal_listen(IPC_SIGNAL_SYNC, sync_signal, NULL);
+
+#if IPC_POOL
+    /* Buffer pool in SRAM3, D2 domain is running */
+    __HAL_RCC_D2SRAM3_CLK_ENABLE();
+#endif /* IPC_POOL */
+
+    /* Channel data placed to D2 region, SRAM2 */
+    __HAL_RCC_D2SRAM2_CLK_ENABLE();
+
+#if IPC_LAT
+    /* Latency timebase, counter started by CPU2 */
+    ipc_lat_timebase_init();
+#endif /* IPC_LAT */
+
     /* Initialize all configured peripherals */
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_USART3_UART_Init();
+#if IPC_LOAD
+    /* Account load from first UART transmit on, benchmark reports included */
+    ipc_load_init();
+#endif /* IPC_LOAD */
 
     /* Send test message */
     HAL_UART_Transmit(&huart3, (void *)"[CM7] Core ready\r\n", 18, 100);
 
+    /* CPU2 initialized in parallel, wait until it attached to channels */
+    if (!ipc_boot_wait(IPC_BOOT_CPU2, IPC_BOOT_STAGE_ATTACHED, IPC_BOOT_TIMEOUT_US)) {
+        Error_Handler();
+    }
+
+#if IPC_FREC
+    /* Last events before warm reset, CPU2 recorded its boot before it attached */
+    ipc_frec_dump(IPC_FREC_CPU1, IPC_FREC_DUMP_LAST, bench_out);
+    ipc_frec_dump(IPC_FREC_CPU2, IPC_FREC_DUMP_LAST, bench_out);
+#endif /* IPC_FREC */
+
+#if IPC_BENCH
+    /* Measure pipes with CPU2, before any application data are exchanged */
+    ipc_bench_run(&rb_cm7_to_cm4, &rb_cm4_to_cm7, bench_out);
+
+    /* Measure RPC round trip, CPU2 serves calls from its application loop */
+    ipc_bench_rpc(&rpc_cli, bench_out);
+#if IPC_RPMSG
+
+    /* Measure RPMsg endpoint round trip, CPU2 echoes from its application loop */
+    ipc_bench_rpmsg(&rpmsg_dev, bench_out);
+#endif /* IPC_RPMSG */
+#endif /* IPC_BENCH */
+
+#if IPC_FWU
+    /* Stream new CPU2 image from staging slot, CPU2 takes it in application loop. Reset system to boot it */
+    if (ipc_fwu_slot_update(&rb_fwu_cm7_to_cm4, bench_out)) {
+        NVIC_SystemReset();
+    }
+#endif /* IPC_FWU */
+
+#if COPY_BENCH
+    /* Measure copy kernels, before CPU2 data are forwarded */
+    copy_bench_run(bench_out);
+#endif /* COPY_BENCH */
+
+#if MEM_BENCH
+    /* Measure bus matrix paths to all placement regions, D2 SRAM2 clock is enabled */
+    mem_bench_run(bench_out);
+#endif /* MEM_BENCH */
+
+#if IPC_SOAK
+    /* Stream verified data with CPU2 at full rate and report to UART, never returns */
+    ipc_soak_run(&rb_cm7_to_cm4, &rb_cm4_to_cm7, bench_out);
+#endif /* IPC_SOAK */
+
+    /* Forward CPU2 data to UART with DMA, blocking UART functions may not be used afterwards */
+#if IPC_ROUTE
+    /* UART sends from its sink queue, router copies CPU2 text to every sink */
+    if (!ringbuff_uart_tx_init(&uart_tx, &huart3, &rb_route_uart, uart_tx_done)
+        || !ringbuff_init(&rb_route_trace, route_trace_data, sizeof(route_trace_data))
+        || !ipc_sink_init(&sink_uart, &rb_route_uart, IPC_SINK_DROP, sink_uart_kick, &uart_tx)
+        || !ipc_sink_init(&sink_trace, &rb_route_trace, IPC_SINK_OVERWRITE, NULL, NULL)) {
+        Error_Handler();
+    }
+#if IPC_LZ
+    if (!ipc_lz_sink_init(&lz_uart, &sink_uart, IPC_LZ_FLUSH_US)) {
+        Error_Handler();
+    }
+#endif /* IPC_LZ */
+#if IPC_COBS
+    if (!ipc_cobs_sink_init(&cobs_uart, &sink_uart)) {
+        Error_Handler();
+    }
+#endif /* IPC_COBS */
+    ipc_router_init(&router);
+    if (!ipc_router_add_src(&router, IPC_CHAN_CM4_TO_CM7, &rb_cm4_to_cm7,
+            ipc_router_add_sink(&router, &sink_uart) | ipc_router_add_sink(&router, &sink_trace))) {
+        Error_Handler();
+    }
+#else
+    if (!ringbuff_uart_tx_init(&uart_tx, &huart3, &rb_cm4_to_cm7, uart_tx_done)) {
+        Error_Handler();
+    }
+#endif /* IPC_ROUTE */
+#if UART_FWD_BATCH
+    ringbuff_uart_tx_set_batch(&uart_tx, UART_FWD_BATCH_LEN, UART_FWD_BATCH_DEADLINE_US, UART_FWD_BATCH_IDLE_US);
+#endif /* UART_FWD_BATCH */
+
+    /* Forward UART data to CPU2 with DMA, received bytes are committed on idle line */
+    if (!ringbuff_uart_rx_init(&uart_rx, &huart3, &rb_cm7_to_cm4, uart_rx_done)) {
+        Error_Handler();
+    }
+    ringbuff_uart_rx_start(&uart_rx);
+
+#if IPC_SCHED
+    /* Periodic work runs as timer task, core sleeps between ticks without polling time */
+    ipc_sched_task_init(&led_tsk, led_task, NULL);
+    ipc_sched_timer_start(&led_tsk, 500, 500);
+#else
     /* Set default time */
     time = t1 = HAL_GetTick();
+#endif /* IPC_SCHED */
+#if IPC_HB
+    /* First window starts with application loop, after benchmarks */
+    ipc_hb_init(&hb, &rpc_cli, IPC_HB_PERIOD_MS, IPC_HB_WINDOW_MS, hb_evt);
+#endif /* IPC_HB */
     while (1) {
-        size_t len;
-        void* addr;
-
+#if !IPC_SCHED
         time = HAL_GetTick();
+#endif /* !IPC_SCHED */
+#if IPC_RESIZE
+        /*
+         * Resize requested with ipc_chan_resize_request completes here.
+         * Application stopped UART reception and other producers before request
+         */
+        if (ipc_chan_resize_poll()) {
+            continue;
+        }
+#endif /* IPC_RESIZE */
+
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_RECV);
+#endif /* IPC_LOAD */
+        /*
+         * Serve CPU2 control messages first, they never wait for UART forwarder.
+         * Control messages from CPU2 are RPC responses, completed calls invoke callbacks.
+         * Calls without response expire at least on every systick
+         */
+        rb_ctrl_cm4_to_cm7_pending = 0;
+        ipc_rpc_client_poll(&rpc_cli);
+#if IPC_HB
+        ipc_hb_poll(&hb, HAL_GetTick());
+#if IPC_PEER_RESET
+        if (!peer_alive) {
+            /* Restart lost CPU2 only, data it did not read yet are kept */
+            if (ipc_peer_reset(IPC_PEER_KEEP, IPC_BOOT_TIMEOUT_US)) {
+                ipc_hb_init(&hb, &rpc_cli, IPC_HB_PERIOD_MS, IPC_HB_WINDOW_MS, hb_evt);
+                peer_alive = 1;
+            }
+        }
+#endif /* IPC_PEER_RESET */
+#endif /* IPC_HB */
+
+#if IPC_DVFS
+        {
+            /* Ramp clocks up with backlog of CPU2 output, CPU2 is paused during change */
+            uint32_t profile = ipc_clk_gov_poll(&clk_gov, HAL_GetTick());
+
+            if (profile != ipc_clk_get_profile()) {
+                ipc_clk_change(&rpc_cli, profile);
+            }
+        }
+#endif /* IPC_DVFS */
+#if IPC_TIME
+        ipc_time_poll();
+#endif /* IPC_TIME */
+
+#if IPC_PUBSUB
+        /* Read sensor samples published by CPU2 */
+        if (sensor_pending) {
+            uint32_t sample[2];
+
+            sensor_pending = 0;
+            while (ipc_topic_read(&sensor_sub, sample, sizeof(sample)) > 0) {
+                /* Process sample here */
+            }
+        }
+#endif /* IPC_PUBSUB */
+
+#if IPC_ACQ && !IPC_DRAIN
+        /* Read CPU2 sensor records in place, whole scan is released at once */
+        if (acq_pending) {
+            ringbuff_msg_span_t spans[4];
+            size_t cnt;
+
+            acq_pending = 0;
+            while ((cnt = ringbuff_msg_recv_batch(&rb_acq_cm4_to_cm7, spans, sizeof(spans) / sizeof(spans[0]))) > 0) {
+                for (size_t k = 0; k < cnt; ++k) {
+                    acq_rec(NULL, &spans[k]);
+                }
+                ringbuff_msg_recv_batch_release(&rb_acq_cm4_to_cm7, cnt);
+            }
+        }
+#endif /* IPC_ACQ && !IPC_DRAIN */
+
+#if IPC_POOL
+        /* Read CPU2 frames in place and return blocks to CPU2 */
+        if (pool_pending) {
+            void* frame;
+            size_t frame_len;
+
+            pool_pending = 0;
+            while ((frame = ipc_pool_recv(&pool_rx, &frame_len)) != NULL) {
+                /*
+                 * Process frame here. Pass it to more consumers with ipc_pool_retain,
+                 * each consumer calls ipc_pool_release when done.
+                 * Block returns to CPU2 after last release
+                 */
+                ipc_pool_release(&pool_rx, frame);
+            }
+        }
+#endif /* IPC_POOL */
+
+#if IPC_BLOG
+        /*
+         * Render CPU2 log records and print them to SWV console, ITM stimulus port 0.
+         * Log is not latency critical, it is drained at least on every systick
+         */
+        {
+            ipc_blog_rec_t rec;
+            char line[128];
+            size_t len;
+
+            while (ipc_blog_read(&rb_blog_cm4_to_cm7, &rec)) {
+                len = ipc_blog_render(&rec, line, sizeof(line));
+                for (size_t k = 0; k < len; ++k) {
+                    ITM_SendChar(line[k]);
+                }
+            }
+        }
+#endif /* IPC_BLOG */
+
+#if IPC_JOB
+        /* Resolve futures of jobs completed by CPU2 */
+        if (job_pending) {
+            job_pending = 0;
+            ipc_job_poll(&job_q);
+        }
+#endif /* IPC_JOB */
 
-        /* Check if CPU2 sent some data to CPU1 core */
-        while ((len = ringbuff_get_linear_block_read_length(rb_cm4_to_cm7)) > 0) {
-            addr = ringbuff_get_linear_block_read_address(rb_cm4_to_cm7);
+#if IPC_RPMSG
+        /* Deliver CPU2 RPMsg messages to endpoints */
+        if (rpmsg_pending) {
+            rpmsg_pending = 0;
+            ipc_rpmsg_poll(&rpmsg_dev);
+        }
+#endif /* IPC_RPMSG */
+
+#if IPC_PP
+        /* Process CPU2 sample blocks in place and return them to CPU2 */
+        if (dsp_pending) {
+            int16_t* block;
+
+            dsp_pending = 0;
+            while ((block = ipc_pp_rx_acquire(&dsp_rx)) != NULL) {
+                /*
+                 * Run DSP kernels on contiguous, cache line aligned block here,
+                 * for example arm_fir_q15 with block as source and destination
+                 */
+                ipc_pp_rx_release(&dsp_rx);
+            }
+        }
+#endif /* IPC_PP */
+
+#if IPC_MPMC
+        /* Execute work items, CPU2 takes from the same ring when it is free first */
+        if (work_pending) {
+            uint8_t item[IPC_MPMC_LEN_WORK];
 
-            /* Transmit data */
-            HAL_UART_Transmit(&huart3, addr, len, 1000);
+            work_pending = 0;
+            while (ipc_mpmc_pop(&work_q, item)) {
+                /* Execute work item here */
+            }
+        }
+#endif /* IPC_MPMC */
+
+#if IPC_STEAL
+        /* Run own jobs newest first, then steal share of CPU2 jobs until both deques are empty */
+        if (steal_pending) {
+            steal_pending = 0;
+            ipc_steal_poll(&steal_w);
+        }
+#endif /* IPC_STEAL */
+
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_FWD);
+#endif /* IPC_LOAD */
+        /*
+         * Forward data CPU2 sent to CPU1 core, once notified.
+         * Flag is cleared first, doorbell rung during start is not lost.
+         * Active transfer chains next block itself from its complete interrupt
+         */
+        if (rb_cm4_to_cm7_pending) {
+            rb_cm4_to_cm7_pending = 0;
+#if IPC_ROUTE
+            /* Channel is drained by router, wake CPU2 if it waits in blocking write */
+            if (ipc_router_poll(&router) > 0) {
+                ipc_notify(HSEM_CM7_TO_CM4);
+            }
+#else
+            ringbuff_uart_tx_start(&uart_tx);
+#endif /* IPC_ROUTE */
+        }
+#if IPC_LZ
+        /* Send partial frame once text stopped coming */
+        lz_pending = ipc_lz_sink_poll(&sink_uart);
+#endif /* IPC_LZ */
+#if UART_FWD_BATCH
+        /* Send batch once its deadline or idle time elapsed, no doorbell comes for it */
+        ringbuff_uart_tx_poll(&uart_tx);
+#endif /* UART_FWD_BATCH */
 
-            /* Mark buffer as read */
-            ringbuff_skip(rb_cm4_to_cm7, len);
+        /*
+         * Resume reception paused on full rb_cm7_to_cm4,
+         * CPU2 does not notify reads, retry is done at least on every systick
+         */
+#if IPC_HB
+        if (peer_alive) {
+            ringbuff_uart_rx_start(&uart_rx);
         }
+#else
+        ringbuff_uart_rx_start(&uart_rx);
+#endif /* IPC_HB */
 
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_APP);
+        ipc_load_poll(HAL_GetTick());
+#endif /* IPC_LOAD */
+#if IPC_SCHED
+        /* Run tasks posted by timers and interrupts */
+        ipc_sched_run();
+#else
         /* Toggle LED */
         if (time - t1 >= 500) {
             t1 = time;
-            HAL_GPIO_TogglePin(LD1_GPIO_PORT, LD1_GPIO_PIN);
+            led_task(NULL);
         }
+#endif /* IPC_SCHED */
 
         /*
-         * If CPU1 wants to send data to CPU2,
-         * it uses second buffer pipe, rb_cm7_to_cm4
-         * is written by CPU1 and read by CPU2.
+         * Second buffer pipe, rb_cm7_to_cm4, is written by UART receiver DMA
+         * and read by CPU2. CPU1 must not write it with ringbuff_write in parallel,
+         * buffer has single producer
          */
-        //ringbuff_write(rb_cm7_to_cm4, "my_data", 7);
+
+        /* Sleep until doorbell or systick, interrupt pending after check still wakes up core */
+#if IPC_LOAD
+        ipc_load_switch(IPC_LOAD_IDLE);
+#endif /* IPC_LOAD */
+        __disable_irq();
+        if (!rb_cm4_to_cm7_pending && !rb_ctrl_cm4_to_cm7_pending
+#if IPC_PUBSUB
+            && !sensor_pending
+#endif /* IPC_PUBSUB */
+#if IPC_POOL
+            && !pool_pending
+#endif /* IPC_POOL */
+#if IPC_ACQ && !IPC_DRAIN
+            && !acq_pending
+#endif /* IPC_ACQ && !IPC_DRAIN */
+#if IPC_PP
+            && !dsp_pending
+#endif /* IPC_PP */
+#if IPC_MPMC
+            && !work_pending
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+            && !steal_pending
+#endif /* IPC_STEAL */
+#if IPC_JOB
+            && !job_pending
+#endif /* IPC_JOB */
+#if IPC_RPMSG
+            && !rpmsg_pending
+#endif /* IPC_RPMSG */
+#if IPC_SCHED
+            && ipc_sched_is_idle()
+#endif /* IPC_SCHED */
+#if UART_FWD_BATCH
+            /* Cycle counter of batch timeouts stops in sleep */
+            && uart_tx.batch_pending == 0
+#endif /* UART_FWD_BATCH */
+#if IPC_LZ
+            && !lz_pending
+#endif /* IPC_LZ */
+            ) {
+            __WFI();
+        }
+        __enable_irq();
     }
 }
 
+/**
+ * \brief           CPU2 doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+rb_cm4_to_cm7_notify(uint32_t sem_id, void* arg) {
+    rb_cm4_to_cm7_pending = 1;
+}
+
+/**
+ * \brief           CPU2 control doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+rb_ctrl_cm4_to_cm7_notify(uint32_t sem_id, void* arg) {
+    rb_ctrl_cm4_to_cm7_pending = 1;
+}
+
+#if IPC_PUBSUB
+/**
+ * \brief           CPU2 sensor topic doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+sensor_notify(uint32_t sem_id, void* arg) {
+    sensor_pending = 1;
+}
+#endif /* IPC_PUBSUB */
+
+#if IPC_ACQ
+/**
+ * \brief           CPU2 sensor scan doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+acq_notify(uint32_t sem_id, void* arg) {
+#if IPC_DRAIN
+    ipc_drain_irq(&acq_drain);                  /* Budget of records, rest continues in PendSV */
+#else
+    acq_pending = 1;
+#endif /* IPC_DRAIN */
+}
+
+/**
+ * \brief           Process CPU2 sensor record in place, called from main loop or from drain interrupt
+ * \param[in]       d: Drain handle, `NULL` from main loop
+ * \param[in]       span: Record in channel memory
+ */
+static void
+acq_rec(ipc_drain_t* d, const ringbuff_msg_span_t* span) {
+    ringbuff_i2c_rec_t rec;
+
+    /* Record header never wraps, CPU2 reserves linear memory or copies whole record */
+    if (span->len1 < sizeof(rec)) {
+        return;
+    }
+    memcpy(&rec, span->ptr1, sizeof(rec));
+
+    /* Process register block of sensor rec.id here, it follows record header */
+    ++acq_records;
+}
+#endif /* IPC_ACQ */
+
+#if IPC_POOL
+/**
+ * \brief           CPU2 pool descriptor doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+pool_notify(uint32_t sem_id, void* arg) {
+    pool_pending = 1;
+}
+#endif /* IPC_POOL */
+
+#if IPC_DVFS
+/**
+ * \brief           Clock change event, USART3 kernel clock is HSI and its DMA continues
+ * \param[in]       evt: Event type
+ */
+static void
+clk_evt(ipc_clk_evt_t evt) {
+#if IPC_TIME
+    ipc_time_rebase();                          /* Close epoch at old and open at new timer clock */
+#endif /* IPC_TIME */
+#if IPC_LAT
+    if (evt == IPC_CLK_EVT_RESUME) {
+        ipc_lat_timebase_init();                /* Timer clock follows APB1 */
+    }
+#endif /* IPC_LAT */
+}
+#endif /* IPC_DVFS */
+
+#if IPC_HB
+/**
+ * \brief           CPU2 health changed, called from main loop
+ * \param[in]       evt: Event type
+ */
+static void
+hb_evt(ipc_hb_evt_t evt) {
+    /* Reception stays paused once pipe is full, instead of filling it for lost CPU2 */
+    peer_alive = evt == IPC_HB_EVT_RECOVERED;
+}
+#endif /* IPC_HB */
+
+#if IPC_SCAN
+/**
+ * \brief           Shared channel corruption found, called from integrity scan in periodic task
+ * \param[in]       id: Channel ID or \ref IPC_SCAN_ID_DIR
+ * \param[in]       err: Check result
+ */
+static void
+scan_alarm(uint32_t id, ipc_scan_err_t err) {
+    (void)id;
+    (void)err;
+    scan_fault = 1;
+}
+#endif /* IPC_SCAN */
+
+/**
+ * \brief           Toggle LED and do periodic work, every 500 ms
+ * \param[in]       arg: User argument
+ */
+static void
+led_task(void* arg) {
+#if IPC_SCAN
+    /* Low priority integrity check of shared channels, part of all channels in each run */
+    ipc_scan_run(IPC_SCAN_STEPS);
+    if (scan_fault) {
+        HAL_GPIO_WritePin(LD1_GPIO_PORT, LD1_GPIO_PIN, GPIO_PIN_SET);
+    } else {
+        HAL_GPIO_TogglePin(LD1_GPIO_PORT, LD1_GPIO_PIN);
+    }
+#else
+    HAL_GPIO_TogglePin(LD1_GPIO_PORT, LD1_GPIO_PIN);
+#endif /* IPC_SCAN */
+#if IPC_JOB
+    /*
+     * Offload batch of CRC jobs to CPU2, with single doorbell.
+     * Results are read from futures, here next batch starts when previous one completed
+     */
+    {
+        uint32_t time = HAL_GetTick();
+        uint8_t idle = 1;
+
+        for (size_t k = 0; k < sizeof(job_crc) / sizeof(job_crc[0]); ++k) {
+            idle = idle && job_crc[k].status != IPC_JOB_PENDING;
+        }
+        if (idle) {
+            for (size_t k = 0; k < sizeof(job_crc) / sizeof(job_crc[0]); ++k) {
+                ipc_job_submit(&job_q, IPC_JOB_FN_CRC32, &time, sizeof(time), &job_crc[k]);
+            }
+            ipc_job_flush(&job_q);
+        }
+    }
+#endif /* IPC_JOB */
+#if IPC_MPMC
+    {
+        /* Push batch of work items, each is executed once by either core */
+        uint32_t item[2] = { HAL_GetTick(), 0 };
+
+        for (size_t k = 0; k < 4; ++k, ++item[1]) {
+            ipc_mpmc_push(&work_q, item, sizeof(item));
+        }
+    }
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+    {
+        /* Burst of jobs to own deque, idle CPU2 steals part of it after doorbell */
+        uint32_t iters = 10000;
+
+        for (size_t k = 0; k < 8; ++k) {
+            ipc_steal_submit(&steal_w, IPC_STEAL_FN_SPIN, &iters, sizeof(iters));
+        }
+        ipc_steal_flush(&steal_w);
+        steal_pending = 1;
+    }
+#endif /* IPC_STEAL */
+}
+
+#if IPC_JOB
+/**
+ * \brief           CPU2 job completion doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+job_notify(uint32_t sem_id, void* arg) {
+    job_pending = 1;
+}
+#endif /* IPC_JOB */
+
+#if IPC_RPMSG
+/**
+ * \brief           CPU2 RPMsg doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+rpmsg_notify(uint32_t sem_id, void* arg) {
+    rpmsg_pending = 1;
+}
+#endif /* IPC_RPMSG */
+
+#if IPC_STEAL
+/**
+ * \brief           CPU2 deque doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+steal_notify(uint32_t sem_id, void* arg) {
+    steal_pending = 1;
+}
+
+/**
+ * \brief           Busy loop job of work-stealing deques, stands for real work
+ * \param[in]       args: Number of iterations, 4 bytes
+ * \param[in]       len: Length of arguments in units of bytes
+ */
+static void
+steal_spin(const void* args, size_t len) {
+    uint32_t n;
+
+    if (len < sizeof(n)) {
+        return;
+    }
+    memcpy(&n, args, sizeof(n));
+    while (n-- > 0) {
+        __NOP();
+    }
+}
+#endif /* IPC_STEAL */
+
+#if IPC_MPMC
+/**
+ * \brief           Work item doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+work_notify(uint32_t sem_id, void* arg) {
+    work_pending = 1;
+}
+#endif /* IPC_MPMC */
+
+#if IPC_PP
+/**
+ * \brief           CPU2 sample block doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+dsp_notify(uint32_t sem_id, void* arg) {
+    dsp_pending = 1;
+}
+#endif /* IPC_PP */
+
+/**
+ * \brief           CPU2 sync signal callback, called from HSEM interrupt
+ * \param[in]       id: Signal ID
+ * \param[in]       arg: User argument
+ */
+static void
+sync_signal(uint32_t id, void* arg) {
+    HAL_GPIO_TogglePin(LD2_GPIO_PORT, LD2_GPIO_PIN);
+}
+
+/**
+ * \brief           UART forwarder sent data, called from UART interrupt
+ * \param[in]       tx: UART transmitter handle
+ * \param[in]       len: Number of bytes released from buffer
+ */
+static void
+uart_tx_done(ringbuff_uart_tx_t* tx, size_t len) {
+#if !IPC_ROUTE
+    /* Memory was freed, wake CPU2 if it waits in blocking write */
+    ipc_notify(HSEM_CM7_TO_CM4);
+#endif /* !IPC_ROUTE */
+}
+
+#if IPC_ROUTE
+/**
+ * \brief           Start UART transfer from sink queue, called from router
+ * \param[in]       sink: UART sink
+ */
+static void
+sink_uart_kick(ipc_sink_t* sink) {
+    ringbuff_uart_tx_start(sink->arg);
+}
+#endif /* IPC_ROUTE */
+
+/**
+ * \brief           UART forwarder received data, called from UART or DMA interrupt
+ * \param[in]       rx: UART receiver handle
+ * \param[in]       len: Number of bytes committed to buffer
+ */
+static void
+uart_rx_done(ringbuff_uart_rx_t* rx, size_t len) {
+    /* New data for CPU2 */
+#if IPC_LAT
+    ipc_lat_stamp(IPC_CHAN_CM7_TO_CM4);
+#endif /* IPC_LAT */
+    ipc_notify(HSEM_CM7_TO_CM4);
+}
+
+/**
+ * \brief           UART transmit complete callback
+ * \param[in]       huart: UART handle
+ */
+void
+HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    if (huart == &huart3) {
+        ringbuff_uart_tx_cplt(&uart_tx);
+    }
+}
+
+/**
+ * \brief           UART receive half complete callback
+ * \param[in]       huart: UART handle
+ */
+void
+HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef* huart) {
+    if (huart == &huart3) {
+        ringbuff_uart_rx_half_cplt(&uart_rx);
+    }
+}
+
+/**
+ * \brief           UART receive complete callback
+ * \param[in]       huart: UART handle
+ */
+void
+HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart) {
+    if (huart == &huart3) {
+        ringbuff_uart_rx_cplt(&uart_rx);
+    }
+}
+
+/**
+ * \brief           UART error callback, transmitter or receiver was stopped
+ * \param[in]       huart: UART handle
+ */
+void
+HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
+    if (huart == &huart3) {
+        ringbuff_uart_tx_error(&uart_tx);
+        ringbuff_uart_rx_error(&uart_rx);
+    }
+}
+
+#if COPY_BENCH || MEM_BENCH || IPC_BENCH || IPC_SOAK || IPC_FWU || IPC_FREC
+/**
+ * \brief           Output benchmark report to UART
+ * \param[in]       str: Text to output
+ * \param[in]       len: Length of text in units of bytes
+ */
+static void
+bench_out(const char* str, size_t len) {
+#if IPC_LOAD
+    /* Blocking transmit is forwarding time, published also while application loop does not run */
+    ipc_load_bucket_t prev = ipc_load_switch(IPC_LOAD_FWD);
+
+    HAL_UART_Transmit(&huart3, (void *)str, len, 1000);
+    ipc_load_switch(prev);
+    ipc_load_poll(HAL_GetTick());
+#else
+    HAL_UART_Transmit(&huart3, (void *)str, len, 1000);
+#endif /* IPC_LOAD */
+}
+#endif /* COPY_BENCH || MEM_BENCH || IPC_BENCH || IPC_SOAK || IPC_FWU || IPC_FREC */
+
 /**
  * \brief           Initialize LEDs controlled by core
  */
@@ -124,6 +1237,102 @@ led_init(void) {
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     HAL_GPIO_Init(LD1_GPIO_PORT, &GPIO_InitStruct);
+
+    /* LD2 follows CPU2 sync signal */
+    LD2_GPIO_CLK_EN();
+    GPIO_InitStruct.Pin = LD2_GPIO_PIN;
+    HAL_GPIO_Init(LD2_GPIO_PORT, &GPIO_InitStruct);
+}
+
+/**
+ * \brief           MPU configuration for shared RAM
+ *
+ * SRAM4 is normal memory, non-cacheable and shareable (TEX=1, C=0, B=0).
+ * Writes are still buffered by CPU write buffer, memory barriers order them.
+ * It must not be device memory (B=1 with TEX=0), as ring buffer copies use unaligned accesses.
+ *
+ * With \ref SHD_RAM_DATA_CACHE set to cacheable mode, whole SRAM4 is write-through (TEX=0, C=1, B=0)
+ * or write-back write-allocate (TEX=1, C=1, B=1) cacheable and non-shareable,
+ * and higher-priority region keeps control part at the beginning non-cacheable.
+ * Cortex-M7 does not cache shareable memory, hence data region is non-shareable.
+ * Ring buffers on cacheable data do cache maintenance, see \ref ipc_chan_create
+ */
+static void
+MPU_Config(void) {
+    MPU_Region_InitTypeDef MPU_InitStruct = {0};
+
+    /* Disables the MPU */
+    HAL_MPU_Disable();
+
+    /* Initializes and configures the region for shared RAM */
+    MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+    MPU_InitStruct.Number = MPU_REGION_NUMBER0;
+    MPU_InitStruct.BaseAddress = SHD_RAM_START_ADDR;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_64KB;
+    MPU_InitStruct.SubRegionDisable = 0x0;
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+#if SHD_RAM_DATA_CACHE == SHD_RAM_DATA_WT
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL0;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_CACHEABLE;
+#elif SHD_RAM_DATA_CACHE == SHD_RAM_DATA_WB
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_BUFFERABLE;
+#else /* SHD_RAM_DATA_CACHE == SHD_RAM_DATA_NC */
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+#endif /* SHD_RAM_DATA_CACHE */
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    /* Channel data placed to AXI SRAM and D2 SRAM2, same attributes as SRAM4 data */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER3;
+    MPU_InitStruct.BaseAddress = SHD_AXI_START_ADDR;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_64KB;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+    MPU_InitStruct.Number = MPU_REGION_NUMBER4;
+    MPU_InitStruct.BaseAddress = SHD_D2_START_ADDR;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_32KB;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+    MPU_InitStruct.BaseAddress = SHD_RAM_START_ADDR;
+
+#if SHD_RAM_DATA_CACHE != SHD_RAM_DATA_NC
+    /* Control part, directory and pointers, and shared heap stay non-cacheable */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER1;
+    MPU_InitStruct.Size = IPC_SHM_NC_MPU_SIZE;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+#if IPC_FREC
+
+    /* Flight recorder at end of SRAM4, no event may stay in D-cache over reset */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER5;
+    MPU_InitStruct.BaseAddress = IPC_FREC_ADDR;
+    MPU_InitStruct.Size = IPC_FREC_MPU_SIZE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+#endif /* IPC_FREC */
+#endif /* SHD_RAM_DATA_CACHE != SHD_RAM_DATA_NC */
+
+#if IPC_POOL
+    /* Buffer pool, blocks are passed between cores without cache maintenance */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER2;
+    MPU_InitStruct.BaseAddress = POOL_RAM_START_ADDR;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_32KB;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+#endif /* IPC_POOL */
+
+    /* Enables the MPU */
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
 }
 
 /**
@@ -131,55 +1340,59 @@ led_init(void) {
  */
 void
 SystemClock_Config(void) {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
     RCC_PeriphCLKInitTypeDef PeriphClkInitStruct = {0};
 
-    /* Supply configuration update enable */
-    HAL_PWREx_ConfigSupply(PWR_DIRECT_SMPS_SUPPLY);
-
-    /* Configure the main internal regulator output voltage */
-    __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE3);
-    while (!__HAL_PWR_GET_FLAG(PWR_FLAG_VOSRDY)) {}
-
-    /** Initializes the CPU, AHB and APB busses clocks */
-    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState = RCC_HSI_DIV1;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
-    if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK) {
-        Error_Handler();
-    }
+    /* Supply configuration update enable, supply can be set once after reset */
+    HAL_PWREx_ConfigSupply(IPC_CLK_SUPPLY);
 
-    /* Initializes the CPU, AHB and APB busses clocks */
-    RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
-                                  | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2
-                                  | RCC_CLOCKTYPE_D3PCLK1 | RCC_CLOCKTYPE_D1PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
-    RCC_ClkInitStruct.SYSCLKDivider = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.AHBCLKDivider = RCC_HCLK_DIV1;
-    RCC_ClkInitStruct.APB3CLKDivider = RCC_APB3_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_APB1_DIV1;
-    RCC_ClkInitStruct.APB2CLKDivider = RCC_APB2_DIV1;
-    RCC_ClkInitStruct.APB4CLKDivider = RCC_APB4_DIV1;
-    if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK) {
+    /* Configure PLL1, voltage scale, flash wait states and bus dividers, publish clocks for CPU2 */
+    if (!ipc_clk_set(IPC_CLK_PROFILE)) {
         Error_Handler();
     }
 
     PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_USART3;
+#if UART_FWD_PROFILE == UART_FWD_PROFILE_FAST
+    PeriphClkInitStruct.Usart234578ClockSelection = RCC_USART234578CLKSOURCE_HSI;
+#else
     PeriphClkInitStruct.Usart234578ClockSelection = RCC_USART234578CLKSOURCE_D2PCLK1;
+#endif /* UART_FWD_PROFILE == UART_FWD_PROFILE_FAST */
     if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInitStruct) != HAL_OK) {
         Error_Handler();
     }
 }
 
 /**
- * \brief           USART3 Initialization Function
+ * \brief           Enable DMA controller clock and interrupts
+ */
+static void
+MX_DMA_Init(void) {
+    /* DMA controller clock enable */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    /* DMA interrupt init */
+    /* DMA1_Stream0_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA1_Stream0_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream0_IRQn);
+    /* DMA1_Stream1_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+}
+
+/**
+ * \brief           USART3 Initialization Function, for \ref UART_FWD_PROFILE
+ *
+ * Fast profile enables FIFO. DMA requests are generated while TX FIFO is not full
+ * and RX FIFO is not empty, FIFO holds bytes while receiver DMA is restarted on next block.
+ * Thresholds apply to FIFO interrupts only
  */
 static void
 MX_USART3_UART_Init(void) {
     huart3.Instance = USART3;
+#if UART_FWD_PROFILE == UART_FWD_PROFILE_FAST
+    huart3.Init.BaudRate = UART_FWD_FAST_BAUDRATE;
+#else
     huart3.Init.BaudRate = 115200;
+#endif /* UART_FWD_PROFILE == UART_FWD_PROFILE_FAST */
     huart3.Init.WordLength = UART_WORDLENGTH_8B;
     huart3.Init.StopBits = UART_STOPBITS_1;
     huart3.Init.Parity = UART_PARITY_NONE;
@@ -198,9 +1411,15 @@ MX_USART3_UART_Init(void) {
     if (HAL_UARTEx_SetRxFifoThreshold(&huart3, UART_RXFIFO_THRESHOLD_1_8) != HAL_OK) {
         Error_Handler();
     }
+#if UART_FWD_PROFILE == UART_FWD_PROFILE_FAST
+    if (HAL_UARTEx_EnableFifoMode(&huart3) != HAL_OK) {
+        Error_Handler();
+    }
+#else
     if (HAL_UARTEx_DisableFifoMode(&huart3) != HAL_OK) {
         Error_Handler();
     }
+#endif /* UART_FWD_PROFILE == UART_FWD_PROFILE_FAST */
 }
 
 /**
@@ -23,6 +23,10 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "common.h"
+#include "ipc_sched.h"
+#include "ringbuff_uart.h"
+#include "ipc_drain.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -56,8 +60,12 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
+extern DMA_HandleTypeDef hdma_usart3_tx;
+extern DMA_HandleTypeDef hdma_usart3_rx;
+extern UART_HandleTypeDef huart3;
 
 /* USER CODE BEGIN EV */
+extern ringbuff_uart_rx_t uart_rx;
 
 /* USER CODE END EV */
 
@@ -169,7 +177,10 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+#if IPC_DRAIN && !IPC_RTOS
+  /* Continue channel drains deferred by doorbell interrupt */
+  ipc_drain_resume();
+#endif /* IPC_DRAIN && !IPC_RTOS */
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
 
@@ -186,6 +197,9 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+#if IPC_SCHED
+  ipc_sched_tick();
+#endif /* IPC_SCHED */
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -211,7 +225,60 @@ void HSEM1_IRQHandler(void)
   /* USER CODE END HSEM1_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 stream0 global interrupt.
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream0_IRQn 0 */
+
+  /* USER CODE END DMA1_Stream0_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart3_tx);
+  /* USER CODE BEGIN DMA1_Stream0_IRQn 1 */
+
+  /* USER CODE END DMA1_Stream0_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA1 stream1 global interrupt.
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream1_IRQn 0 */
+
+  /* USER CODE END DMA1_Stream1_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart3_rx);
+  /* USER CODE BEGIN DMA1_Stream1_IRQn 1 */
+
+  /* USER CODE END DMA1_Stream1_IRQn 1 */
+}
+
+/**
+  * @brief This function handles USART3 global interrupt.
+  */
+void USART3_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART3_IRQn 0 */
+  /* Idle line is not handled by HAL, commit received bytes to buffer */
+  ringbuff_uart_rx_irq(&uart_rx);
+
+  /* USER CODE END USART3_IRQn 0 */
+  HAL_UART_IRQHandler(&huart3);
+  /* USER CODE BEGIN USART3_IRQn 1 */
+
+  /* USER CODE END USART3_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
+#if IPC_DRAIN && IPC_RTOS
+/**
+  * @brief This function handles CEC global interrupt, software continuation of channel drains.
+  */
+void CEC_IRQHandler(void)
+{
+  ipc_drain_resume();
+}
+#endif /* IPC_DRAIN && IPC_RTOS */
 
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -37,39 +37,653 @@
 /* Align X to 4 bytes */
 #define MEM_ALIGN(x)                        (((x) + 0x00000003) & ~0x00000003)
 
-/* Shared RAM between 2 cores is SRAM4 in D3 domain */
+/* Align X to 32-bytes, Cortex-M7 D-cache line size */
+#define MEM_CACHE_LINE_SIZE                 0x00000020
+#define MEM_ALIGN_CACHE(x)                  (((x) + (MEM_CACHE_LINE_SIZE - 1)) & ~(MEM_CACHE_LINE_SIZE - 1))
+
+/* Largest power of 2 not greater than X, for X up to 128kB */
+#define MEM_POW2_FLOOR(x)                   ((x) >= 0x00020000 ? 0x00020000 : (x) >= 0x00010000 ? 0x00010000 : \
+                                            (x) >= 0x00008000 ? 0x00008000 : (x) >= 0x00004000 ? 0x00004000 : \
+                                            (x) >= 0x00002000 ? 0x00002000 : (x) >= 0x00001000 ? 0x00001000 : \
+                                            (x) >= 0x00000800 ? 0x00000800 : (x) >= 0x00000400 ? 0x00000400 : \
+                                            (x) >= 0x00000200 ? 0x00000200 : (x) >= 0x00000100 ? 0x00000100 : \
+                                            (x) >= 0x00000080 ? 0x00000080 : (x) >= 0x00000040 ? 0x00000040 : \
+                                            (x) >= 0x00000020 ? 0x00000020 : 0)
+
+/* Shared RAM between 2 cores is SRAM4 in D3 domain, 64kB, SHD_RAM region in linker scripts */
 #define SHD_RAM_START_ADDR                  0x38000000
-#define SHD_RAM_LEN                         0x0000FFFF
+#define SHD_RAM_LEN                         0x00010000
+
+/*
+ * CPU1 memory attributes for channel data in shared RAM, configured by MPU in CPU1 main.c.
+ * Control part (directory and pointers) is always non-cacheable
+ *
+ * - SHD_RAM_DATA_NC: Non-cacheable and shareable, no cache maintenance
+ * - SHD_RAM_DATA_WT: Write-through cacheable. CPU1 writes go straight to memory,
+ *      CPU1 invalidates cache lines before it reads data written by CPU2
+ * - SHD_RAM_DATA_WB: Write-back cacheable, ring buffer cleans lines after write
+ *      and invalidates lines before read (RINGBUFF_USE_CACHE_MAINT)
+ */
+#define SHD_RAM_DATA_NC                     0
+#define SHD_RAM_DATA_WT                     1
+#define SHD_RAM_DATA_WB                     2
+#ifndef SHD_RAM_DATA_CACHE
+#define SHD_RAM_DATA_CACHE                  SHD_RAM_DATA_NC
+#endif
+
+/*
+ * Placement of channel data, last column of channel table. Control part of all channels
+ * (directory, pointers) stays in SRAM4, only data arrays move. Compare regions with MEM_BENCH
+ *
+ * - SRAM4: D3 SRAM4, SHD_RAM region. Shared RAM left after fixed parts is distributed by weight
+ * - AXI: Last 64kB of D1 AXI SRAM, SHD_AXI region. On CPU1 64-bit AXI bus matrix,
+ *      CPU2 reaches it through D2-to-D1 interconnect. For channels mostly accessed by CPU1
+ * - D2: Last 32kB of D2 SRAM2, SHD_D2 region. On CPU2 AHB bus matrix,
+ *      CPU1 reaches it through D1-to-D2 interconnect. For channels mostly accessed by CPU2
+ *
+ * Channels outside SRAM4 get their minimum length, weight must be `0`. Not with IPC_RESIZE.
+ * CPU1 applies SHD_RAM_DATA_CACHE attributes to all regions and reaches D2 only after CPU2 started D2 domain
+ */
+#define SHD_REGION_SRAM4                    0
+#define SHD_REGION_AXI                      1
+#define SHD_REGION_D2                       2
+#define SHD_AXI_START_ADDR                  0x24070000
+#define SHD_AXI_LEN                         0x00010000
+#define SHD_D2_START_ADDR                   0x30038000
+#define SHD_D2_LEN                          0x00008000
+
+/* Buffer pool between cores is SRAM3 in D2 domain, 32kB, POOL_RAM region in linker scripts */
+#define POOL_RAM_START_ADDR                 0x30040000
+#define POOL_RAM_LEN                        0x00008000
+
+/*
+ * Buffer pool with descriptor passing, see ipc_pool.c. CPU2 allocates fixed blocks in POOL_RAM,
+ * descriptors go to CPU1 through POOL_CM4_TO_CM7 channel and released blocks return through POOL_RET_CM7_TO_CM4
+ */
+#ifndef IPC_POOL
+#define IPC_POOL                            0
+#endif
+#define IPC_POOL_BLOCK_LEN                  0x00002000
+#define IPC_POOL_BLOCKS                     (POOL_RAM_LEN / IPC_POOL_BLOCK_LEN)
+#if IPC_POOL
+#define IPC_CHAN_TABLE_POOL(X)                                                              \
+    X(POOL_CM4_TO_CM7, 0x00000100, 0, SRAM4) /* CPU2 pool block descriptors */              \
+    X(POOL_RET_CM7_TO_CM4, 0x00000100, 0, SRAM4) /* Pool blocks released by CPU1 */
+#else
+#define IPC_CHAN_TABLE_POOL(X)
+#endif /* IPC_POOL */
+
+/*
+ * Deferred binary log, see ipc_blog.c. CPU2 sends format string addresses and raw arguments
+ * through BLOG_CM4_TO_CM7 channel, CPU1 renders text
+ */
+#ifndef IPC_BLOG
+#define IPC_BLOG                            0
+#endif
+#if IPC_BLOG
+#define IPC_CHAN_TABLE_BLOG(X)                                                              \
+    X(BLOG_CM4_TO_CM7, 0x00000400, 0, SRAM4) /* CPU2 binary log records */
+#else
+#define IPC_CHAN_TABLE_BLOG(X)
+#endif /* IPC_BLOG */
+
+/*
+ * Job offload, see ipc_job.c. CPU1 submits job descriptors through JOB_CM7_TO_CM4 channel,
+ * CPU2 executes them and returns completions through JOB_RET_CM4_TO_CM7
+ */
+#ifndef IPC_JOB
+#define IPC_JOB                             0
+#endif
+#if IPC_JOB
+#define IPC_CHAN_TABLE_JOB(X)                                                               \
+    X(JOB_CM7_TO_CM4, 0x00000400, 0, SRAM4) /* CPU1 job descriptors */                      \
+    X(JOB_RET_CM4_TO_CM7, 0x00000400, 0, SRAM4) /* CPU2 job completions */
+#else
+#define IPC_CHAN_TABLE_JOB(X)
+#endif /* IPC_JOB */
+
+/*
+ * Output router of CPU1, see ipc_route.c. CPU2 text output is copied to queues of UART and in-RAM trace sinks,
+ * slow sink drops data instead of holding back channel. UART sink queue is CPU1 local ROUTE_UART channel,
+ * carved from shared RAM as it is read by DMA
+ */
+#ifndef IPC_ROUTE
+#define IPC_ROUTE                           0
+#endif
+#if IPC_ROUTE
+#define IPC_CHAN_TABLE_ROUTE(X)                                                             \
+    X(ROUTE_UART, 0x00000400, 0, SRAM4) /* CPU1 local queue of UART sink */
+#else
+#define IPC_CHAN_TABLE_ROUTE(X)
+#endif /* IPC_ROUTE */
+#define IPC_ROUTE_TRACE_LEN                 0x00000800
+
+/*
+ * RPMsg endpoint API, see ipc_rpmsg.c. OpenAMP endpoint code runs on both cores
+ * with messages through RPMSG_CM7_TO_CM4 and RPMSG_CM4_TO_CM7 channels instead of virtio rings
+ */
+#ifndef IPC_RPMSG
+#define IPC_RPMSG                           0
+#endif
+#if IPC_RPMSG
+#define IPC_CHAN_TABLE_RPMSG(X)                                                             \
+    X(RPMSG_CM7_TO_CM4, 0x00000800, 0, SRAM4) /* CPU1 RPMsg messages */                     \
+    X(RPMSG_CM4_TO_CM7, 0x00000800, 0, SRAM4) /* CPU2 RPMsg messages */
+#else
+#define IPC_CHAN_TABLE_RPMSG(X)
+#endif /* IPC_RPMSG */
+#define IPC_RPMSG_SEND_TIMEOUT_US           15000   /* Send waits for channel memory */
+#define IPC_RPMSG_ECHO_NAME                 "rpmsg-echo"    /* CPU2 echo endpoint, measured by IPC_BENCH */
+
+/*
+ * CPU2 firmware update, see ipc_fwu.c. CPU1 streams image from staging slot in flash bank 1
+ * through FWU_CM7_TO_CM4 channel in AXI SRAM, CPU2 programs flash bank 2 from RAM. Excludes IPC_RESIZE
+ */
+#ifndef IPC_FWU
+#define IPC_FWU                             0
+#endif
+#if IPC_FWU
+#define IPC_CHAN_TABLE_FWU(X)                                                               \
+    X(FWU_CM7_TO_CM4, 0x00008000, 0, AXI) /* CPU1 image chunks for bank 2 */
+#else
+#define IPC_CHAN_TABLE_FWU(X)
+#endif /* IPC_FWU */
+#define IPC_FWU_CHUNK_LEN                   0x00001000      /* Image chunk per message, multiple of flash word */
+#define IPC_FWU_SLOT_ADDR                   0x08080000      /* Staging slot, header followed by image */
+#define IPC_FWU_SLOT_LEN                    0x00080000
+#define IPC_FWU_START_TIMEOUT_US            500000          /* CPU2 takes update from its application loop */
+#define IPC_FWU_TIMEOUT_US                  5000000         /* Maximum time update waits for CPU2, sector erase included */
+
+/*
+ * Sensor acquisition of CPU2, see ringbuff_i2c.c. I2C1 DMA reads sensor registers directly
+ * to messages reserved in ACQ_CM4_TO_CM7 channel, CPU1 reads records in place
+ */
+#ifndef IPC_ACQ
+#define IPC_ACQ                             0
+#endif
+#if IPC_ACQ
+#define IPC_CHAN_TABLE_ACQ(X)                                                               \
+    X(ACQ_CM4_TO_CM7, 0x00000400, 0, SRAM4) /* CPU2 sensor records */
+#else
+#define IPC_CHAN_TABLE_ACQ(X)
+#endif /* IPC_ACQ */
+#define IPC_ACQ_PERIOD_MS                   10              /* Scan of all sensors */
+#define IPC_ACQ_I2C_TIMING                  0x10707DBC      /* 100 kHz with 64 MHz HSI kernel clock */
+
+/*
+ * Compression of UART sink, see ipc_lz_sink.c. CPU2 text is sent to USART3 as LZ frames,
+ * decoded on host with tools/ipc_lz_tool. Needs IPC_ROUTE
+ */
+#ifndef IPC_LZ
+#define IPC_LZ                              0
+#endif
+#define IPC_LZ_FLUSH_US                     2000    /* Maximum time text waits for frame to fill */
+
+/*
+ * COBS framing of UART sink, see ipc_cobs_sink.c. Routed data are sent as records tagged
+ * with channel ID, demultiplexed on host with tools/ipc_cobs_tool. Needs IPC_ROUTE, excludes IPC_LZ
+ */
+#ifndef IPC_COBS
+#define IPC_COBS                            0
+#endif
+
+/*
+ * Channel table, one line per channel: X(name, min_len, weight, region)
+ *
+ * - name: Channel ID is IPC_CHAN_<name>, data length is IPC_CHAN_LEN_<name>
+ * - min_len: Minimum data length in units of bytes
+ * - weight: Shared RAM left after all fixed parts and minimum lengths
+ *      is distributed to channels proportionally to weight.
+ *      Data length is rounded down to power of 2 (RINGBUFF_USE_POW2)
+ * - region: Placement of data, SHD_REGION_<region>: SRAM4, AXI or D2
+ *
+ * Layout is generated and checked at compile time, see ipc_chan.h.
+ * Each channel has its own doorbell semaphore, HSEM_CHAN(id)
+ */
+#define IPC_CHAN_TABLE(X)                                                                   \
+    X(CM4_TO_CM7,   0x00000400, 2, SRAM4) /* CPU2 text output, forwarded to UART by CPU1 */ \
+    X(CM7_TO_CM4,   0x00000400, 1, SRAM4) /* CPU1 data to CPU2 */                           \
+    X(CTRL_CM4_TO_CM7, 0x00000100, 0, SRAM4) /* CPU2 control messages, served before CM4_TO_CM7 */ \
+    X(CTRL_CM7_TO_CM4, 0x00000100, 0, SRAM4) /* CPU1 control messages, served before CM7_TO_CM4 */ \
+    IPC_CHAN_TABLE_POOL(X)                                                                  \
+    IPC_CHAN_TABLE_BLOG(X)                                                                  \
+    IPC_CHAN_TABLE_JOB(X)                                                                   \
+    IPC_CHAN_TABLE_ROUTE(X)                                                                 \
+    IPC_CHAN_TABLE_RPMSG(X)                                                                 \
+    IPC_CHAN_TABLE_FWU(X)                                                                   \
+    IPC_CHAN_TABLE_ACQ(X)
+
+/*
+ * Producer rate limits, see RINGBUFF_USE_RATE. Rate table, one line per limited channel: X(name, rate, burst)
+ *
+ * - rate: Average rate in units of bytes per second
+ * - burst: Bytes producer may write at once, not less than largest message or write of channel
+ *
+ * Token bucket of producer handle caps free memory seen by send functions, so single stream
+ * cannot take whole UART forwarder bandwidth and starve the rest. Limits are set when channel
+ * is created or opened, ticks per byte follow SystemCoreClock at that time
+ */
+#if IPC_BLOG
+#define IPC_RATE_TABLE_BLOG(X)                                                              \
+    X(BLOG_CM4_TO_CM7, 0x00010000, 0x00000400) /* CPU2 binary logs, 64 kB/s */
+#else
+#define IPC_RATE_TABLE_BLOG(X)
+#endif /* IPC_BLOG */
+#define IPC_RATE_TABLE(X)                                                                   \
+    X(CM4_TO_CM7,   0x00040000, 0x00000400) /* CPU2 text output, 256 kB/s of 400 kB/s UART */ \
+    IPC_RATE_TABLE_BLOG(X)
+
+/* Channel IDs, index in channel directory */
+#define IPC_CHAN_X_ID(name, min_len, weight, region)    IPC_CHAN_##name,
+typedef enum {
+    IPC_CHAN_TABLE(IPC_CHAN_X_ID)
+    IPC_CHAN_COUNT
+} ipc_chan_id_t;
+
+/*
+ * Clock profile, set by CPU1 in SystemClock_Config and published to CPU2, see ipc_clk.c
+ *
+ * - IPC_CLK_PROFILE_LOW: HSI 64MHz for both cores and all buses, VOS3
+ * - IPC_CLK_PROFILE_BALANCED: PLL1 400MHz CPU1, 200MHz CPU2 and AXI, 100MHz APB, VOS1
+ * - IPC_CLK_PROFILE_MAX: PLL1 480MHz CPU1, 240MHz CPU2 and AXI, 120MHz APB, VOS0.
+ *      Needs IPC_CLK_SUPPLY set to PWR_LDO_SUPPLY, Nucleo board is supplied from SMPS by default
+ */
+#define IPC_CLK_PROFILE_LOW                 0
+#define IPC_CLK_PROFILE_BALANCED            1
+#define IPC_CLK_PROFILE_MAX                 2
+#define IPC_CLK_PROFILE_COUNT               3
+#ifndef IPC_CLK_PROFILE
+#define IPC_CLK_PROFILE                     IPC_CLK_PROFILE_LOW
+#endif
+#ifndef IPC_CLK_SUPPLY
+#define IPC_CLK_SUPPLY                      PWR_DIRECT_SMPS_SUPPLY
+#endif
+
+/*
+ * USART3 profile of CPU1 forwarder, ST-LINK virtual COM port, configured in CPU1 main.c
+ *
+ * - UART_FWD_PROFILE_CONSOLE: 115200 baud, kernel clock from D2PCLK1, FIFO disabled
+ * - UART_FWD_PROFILE_FAST: UART_FWD_FAST_BAUDRATE with HSI kernel clock, independent of bus prescalers,
+ *      16-byte TX and RX FIFOs enabled, DMA and receiver restart latency is absorbed by FIFO
+ */
+#define UART_FWD_PROFILE_CONSOLE            0
+#define UART_FWD_PROFILE_FAST               1
+#ifndef UART_FWD_PROFILE
+#define UART_FWD_PROFILE                    UART_FWD_PROFILE_FAST
+#endif
+#ifndef UART_FWD_FAST_BAUDRATE
+#define UART_FWD_FAST_BAUDRATE              4000000 /* HSI 64MHz / 16, exact with 16x oversampling */
+#endif
+
+/*
+ * Batching of CPU1 forwarder, see ringbuff_uart_tx_set_batch. Small CPU2 writes are aggregated
+ * into one USART3 DMA transfer until length, deadline or idle time of CM4_TO_CM7 pipe is reached
+ */
+#ifndef UART_FWD_BATCH
+#define UART_FWD_BATCH                      0
+#endif
+#define UART_FWD_BATCH_LEN                  256
+#define UART_FWD_BATCH_DEADLINE_US          1000
+#define UART_FWD_BATCH_IDLE_US              50
+
+/* Copy benchmark, scratch memory in shared RAM is reserved in layout when enabled, see copy_bench.c */
+#ifndef COPY_BENCH
+#define COPY_BENCH                          0
+#endif
+#define COPY_BENCH_LEN                      0x00000400
+
+/*
+ * Bus matrix benchmark, read and write throughput and load latency of both cores
+ * to core-local RAM and each placement region, see mem_bench.c. Scratch memory is reserved in all regions when enabled
+ */
+#ifndef MEM_BENCH
+#define MEM_BENCH                           0
+#endif
+#define MEM_BENCH_LEN                       0x00001000
+
+/* Pipe benchmark on both cores at boot, before application starts, see ipc_bench.c */
+#ifndef IPC_BENCH
+#define IPC_BENCH                           0
+#endif
+
+/*
+ * Runtime resize of channels, see ipc_chan_resize_request. CPU1 re-carves memory of channel data
+ * while neither core accesses channels
+ */
+#ifndef IPC_RESIZE
+#define IPC_RESIZE                          0
+#endif
+
+/*
+ * Cooperative scheduler, see ipc_sched.c. Timer wheel advanced by SysTick
+ * and ready queue fed by timers and interrupts, periodic work of both main loops runs as tasks
+ */
+#ifndef IPC_SCHED
+#define IPC_SCHED                           0
+#endif
+
+/*
+ * Completion callbacks of ring buffers, see ringbuff_async.c. Pending reads and writes
+ * are evaluated from HSEM interrupt after doorbell listeners, or by ringbuff_async_poll
+ */
+#ifndef IPC_ASYNC
+#define IPC_ASYNC                           0
+#endif
 
-/* Buffer from CM4 to CM7 */
-#define BUFF_CM4_TO_CM7_ADDR                MEM_ALIGN(SHD_RAM_START_ADDR)
-#define BUFF_CM4_TO_CM7_LEN                 MEM_ALIGN(sizeof(ringbuff_t))
-#define BUFFDATA_CM4_TO_CM7_ADDR            MEM_ALIGN(BUFF_CM4_TO_CM7_ADDR + BUFF_CM4_TO_CM7_LEN)
-#define BUFFDATA_CM4_TO_CM7_LEN             MEM_ALIGN(0x00000400)
+/*
+ * Runtime clock changes, see ipc_clk_change. CPU1 pauses CPU2 over control lane before it switches clocks,
+ * fill level of CM4_TO_CM7 pipe ramps clocks up and IPC_DVFS_IDLE_MS without load drops them.
+ * USART3 forwarder must have HSI kernel clock, UART_FWD_PROFILE_FAST
+ */
+#ifndef IPC_DVFS
+#define IPC_DVFS                            0
+#endif
+#define IPC_DVFS_PROFILE_HIGH               IPC_CLK_PROFILE_BALANCED
+#define IPC_DVFS_PROFILE_LOW                IPC_CLK_PROFILE_LOW
+#define IPC_DVFS_UP_PERCENT                 50  /* Fill level of monitored pipe, in percent of its size, which ramps up */
+#define IPC_DVFS_IDLE_MS                    1000
+#define IPC_DVFS_TIMEOUT_US                 10000   /* Maximum time for CPU2 to pause */
+
+/*
+ * CPU2 stop mode when idle, see ipc_idle.c. CPU2 stops until doorbell when no scheduler timer runs
+ * and channels from CPU1 are empty, instead of WFI. Needs IPC_SCHED
+ */
+#ifndef IPC_IDLE_STOP
+#define IPC_IDLE_STOP                       0
+#endif
+
+/*
+ * Peer heartbeat, see ipc_hb.c. CPU1 sends RPC heartbeat every IPC_HB_PERIOD_MS,
+ * CPU2 is lost when its main loop does not answer within IPC_HB_WINDOW_MS
+ */
+#ifndef IPC_HB
+#define IPC_HB                              0
+#endif
+#define IPC_HB_PERIOD_MS                    100
+#define IPC_HB_WINDOW_MS                    500
+
+/*
+ * CPU load accounting, see ipc_load.c. Cycles of each core are charged to application, send, receive,
+ * forwarding and idle buckets, load of both cores is published every IPC_LOAD_PERIOD_MS
+ * and reported by CPU2. Period must stay below wrap of cycle counter
+ */
+#ifndef IPC_LOAD
+#define IPC_LOAD                            0
+#endif
+#define IPC_LOAD_PERIOD_MS                  1000
+
+/*
+ * CPU2 recovery without system reset, see ipc_peer.c. CPU1 resets CPU2 with WWDG2
+ * and replays boot handshake, with IPC_HB lost CPU2 is reset automatically
+ */
+#ifndef IPC_PEER_RESET
+#define IPC_PEER_RESET                      0
+#endif
+
+/*
+ * Background integrity scan of shared channels, see ipc_scan.c. Periodic task of each core checks
+ * directory, layout hash, handle magic words and pointer ranges, so hot path can be built
+ * without magic checks, with RINGBUFF_USE_MAGIC_CHECK=0
+ */
+#ifndef IPC_SCAN
+#define IPC_SCAN                            0
+#endif
+#define IPC_SCAN_STEPS                      4       /* Items checked in each run of periodic task */
+
+/*
+ * Introspection block for host monitoring over SWD, see ipc_mon.c. Header at IPC_MON_ADDR
+ * points to descriptor of channel directory and statistics, host tool reads live state from memory
+ */
+#ifndef IPC_MON
+#define IPC_MON                             0
+#endif
+
+/*
+ * FreeRTOS port layer, see ringbuff_rtos.c. Tasks block on task notification,
+ * given by HSEM interrupt. HSEM interrupt priority must allow FreeRTOS API calls,
+ * numerically not lower than configMAX_SYSCALL_INTERRUPT_PRIORITY
+ */
+#ifndef IPC_RTOS
+#define IPC_RTOS                            0
+#endif
+#ifndef IPC_HSEM_IRQ_PRIO
+#if IPC_RTOS
+#define IPC_HSEM_IRQ_PRIO                   5
+#else
+#define IPC_HSEM_IRQ_PRIO                   0
+#endif /* IPC_RTOS */
+#endif
+
+/*
+ * Interrupt-side drain of CPU1, see ipc_drain.c. ACQ_CM4_TO_CM7 records are consumed in doorbell interrupt,
+ * at most IPC_DRAIN_BUDGET_ACQ messages per interrupt, rest continues in IPC_DRAIN_IRQn. Needs IPC_ACQ
+ */
+#ifndef IPC_DRAIN
+#define IPC_DRAIN                           0
+#endif
+#define IPC_DRAIN_BUDGET_ACQ                4
+#if IPC_RTOS
+#define IPC_DRAIN_IRQn                      CEC_IRQn        /* PendSV is used by FreeRTOS, CEC is not used */
+#else
+#define IPC_DRAIN_IRQn                      PendSV_IRQn
+#endif /* IPC_RTOS */
 
-/* Buffer from CM7 to CM4 */
-#define BUFF_CM7_TO_CM4_ADDR                MEM_ALIGN(BUFFDATA_CM4_TO_CM7_ADDR + BUFFDATA_CM4_TO_CM7_LEN)
-#define BUFF_CM7_TO_CM4_LEN                 MEM_ALIGN(sizeof(ringbuff_t))
-#define BUFFDATA_CM7_TO_CM4_ADDR            MEM_ALIGN(BUFF_CM7_TO_CM4_ADDR + BUFF_CM7_TO_CM4_LEN)
-#define BUFFDATA_CM7_TO_CM4_LEN             MEM_ALIGN(0x00000400)
+/*
+ * Flight recorder of IPC events, see ipc_frec.c. Each core appends doorbells, drops, boots and,
+ * with RINGBUFF_USE_TRACE, buffer events to its ring at end of SRAM4, rings survive warm reset.
+ * CPU1 reports last IPC_FREC_DUMP_LAST events of previous boots of both cores
+ */
+#ifndef IPC_FREC
+#define IPC_FREC                            0
+#endif
+#define IPC_FREC_DUMP_LAST                  32
+
+/*
+ * Soak test instead of application, see ipc_soak.c. Both cores stream verified data
+ * through CM4_TO_CM7 and CM7_TO_CM4 pipes at full rate, CPU1 reports every second
+ */
+#ifndef IPC_SOAK
+#define IPC_SOAK                            0
+#endif
+
+/*
+ * Latency instrumentation, see ipc_lat.c. Producer stamps writes with shared timebase,
+ * consumer bins latency to histogram from doorbell interrupt. CPU2 reports all channels
+ * every IPC_LAT_REPORT_MS through UART forwarder
+ */
+#ifndef IPC_LAT
+#define IPC_LAT                             0
+#endif
+#define IPC_LAT_REPORT_MS                   5000
+
+/*
+ * Cross-core timestamps, see ipc_time.c. CPU1 runs TIM5 as shared 32-bit counter
+ * and publishes epoch, both cores get the same time with ipc_now_ns
+ */
+#ifndef IPC_TIME
+#define IPC_TIME                            0
+#endif
+
+/*
+ * Priority lanes, see ipc_lane.c. Consumer serves waiting bulk data once
+ * after IPC_LANE_BULK_EVERY consecutive control messages, `0` for strict priority
+ */
+#define IPC_LANE_BULK_EVERY                 8
+
+/*
+ * Credit-based flow control of logical streams sharing one channel, see ipc_credit.c.
+ * Grants of consumer are reserved in shared RAM control part when enabled
+ */
+#ifndef IPC_CREDIT
+#define IPC_CREDIT                          0
+#endif
+
+/*
+ * Publish/subscribe topics, see ipc_pubsub.c. Topic state and data are reserved in shared RAM when enabled.
+ * Topic table, one line per topic: X(name, len), topic ID is IPC_TOPIC_<name>,
+ * `len` is data length in units of bytes, power of 2
+ */
+#ifndef IPC_PUBSUB
+#define IPC_PUBSUB                          0
+#endif
+#define IPC_TOPIC_TABLE(X)                                                                  \
+    X(SENSOR,       0x00000400)         /* CPU2 sensor samples */
+
+/* Topic IDs */
+#define IPC_TOPIC_X_ID(name, len)           IPC_TOPIC_##name,
+typedef enum {
+    IPC_TOPIC_TABLE(IPC_TOPIC_X_ID)
+    IPC_TOPIC_COUNT
+} ipc_topic_id_t;
+
+/*
+ * Variable-size shared heap, see ipc_heap.c. Heap follows control part in shared RAM,
+ * both together are IPC_HEAP_NC_LEN bytes, power of 2, non-cacheable for CPU1.
+ * Heap is used by both cores, protected by HSEM_HEAP
+ */
+#ifndef IPC_HEAP
+#define IPC_HEAP                            0
+#endif
+#define IPC_HEAP_NC_LEN                     0x00004000
+#define IPC_HEAP_NC_MPU_SIZE                MPU_REGION_SIZE_16KB
+
+/*
+ * Ping-pong block channels, see ipc_pingpong.c. Block ownership flags and blocks are reserved in shared RAM when enabled.
+ * Channel table, one line per channel: X(name, blocks, block_len), channel ID is IPC_PP_<name>,
+ * `blocks` is `2` to IPC_PP_MAX_BLOCKS, `block_len` is multiple of cache line
+ */
+#ifndef IPC_PP
+#define IPC_PP                              0
+#endif
+#define IPC_PP_TABLE(X)                                                                     \
+    X(DSP,          2, 0x00000200)      /* CPU2 blocks of 256 q15 samples */
+
+/* Ping-pong channel IDs */
+#define IPC_PP_X_ID(name, blocks, block_len)    IPC_PP_##name,
+typedef enum {
+    IPC_PP_TABLE(IPC_PP_X_ID)
+    IPC_PP_COUNT
+} ipc_pp_id_t;
+
+/*
+ * Multi-producer multi-consumer rings of fixed items, see ipc_mpmc.c. Both cores push and pop every ring,
+ * slots are reserved in shared RAM when enabled. Ring table, one line per ring: X(name, slots, slot_len),
+ * ring ID is IPC_MPMC_<name>, `slots` is power of 2 up to IPC_MPMC_MAX_SLOTS, `slot_len` is multiple of cache line
+ */
+#ifndef IPC_MPMC
+#define IPC_MPMC                            0
+#endif
+#define IPC_MPMC_TABLE(X)                                                               \
+    X(WORK,         16, 0x00000020)     /* Work items, executed by core that is free first */
+
+/* MPMC ring IDs */
+#define IPC_MPMC_X_ID(name, slots, slot_len)    IPC_MPMC_##name,
+typedef enum {
+    IPC_MPMC_TABLE(IPC_MPMC_X_ID)
+    IPC_MPMC_COUNT
+} ipc_mpmc_id_t;
+
+/* MPMC ring slot lengths, IPC_MPMC_LEN_<name> */
+#define IPC_MPMC_X_LEN(name, slots, slot_len)   IPC_MPMC_LEN_##name = (slot_len),
+enum {
+    IPC_MPMC_TABLE(IPC_MPMC_X_LEN)
+};
+
+/*
+ * Work-stealing job deques, see ipc_steal.c. Each core runs jobs of its own deque first
+ * and steals batches of up to IPC_STEAL_BATCH jobs from deque of other core once its own is empty.
+ * Deques of IPC_STEAL_SLOTS jobs, power of 2, are reserved in shared RAM when enabled
+ */
+#ifndef IPC_STEAL
+#define IPC_STEAL                           0
+#endif
+#define IPC_STEAL_SLOTS                     16
+#define IPC_STEAL_BATCH                     8
+
+/*
+ * Signals without payload, see ipc_signal.c. Signal table, one line per signal: X(name),
+ * signal ID is IPC_SIGNAL_<name>, each signal owns hardware semaphore HSEM_SIGNAL(id)
+ */
+#define IPC_SIGNAL_TABLE(X)                                                                 \
+    X(ESTOP)                            /* Emergency stop */                                \
+    X(SYNC)                             /* Synchronization pulse */                         \
+    X(FRAME_READY)                      /* Frame completed by other core */
+
+/* Signal IDs */
+#define IPC_SIGNAL_X_ID(name)               IPC_SIGNAL_##name,
+typedef enum {
+    IPC_SIGNAL_TABLE(IPC_SIGNAL_X_ID)
+    IPC_SIGNAL_COUNT
+} ipc_signal_id_t;
+
+/*
+ * RPC methods served by CPU2, see ipc_rpc.c. CPU1 calls them over control lanes
+ */
+#define IPC_RPC_METHOD_ECHO                 0   /* Result is copy of arguments */
+#define IPC_RPC_METHOD_LED                  1   /* Set LD3 to state in first argument byte */
+#define IPC_RPC_METHOD_CLK_PAUSE            2   /* Pause until clock generation in first argument word is published */
+#define IPC_RPC_METHOD_HEARTBEAT            3   /* Result is echoed sequence word and CPU2 tick */
+
+/* Job functions executed by CPU2, see ipc_job.c */
+#define IPC_JOB_FN_CRC32                    0   /* Result is CRC-32 of arguments, 4 bytes */
+
+/* Job functions of work-stealing deques, executed by either core, see ipc_steal.c */
+#define IPC_STEAL_FN_SPIN                   0   /* Busy loop of iterations in first argument word */
 
 /* Define semaphores */
 #define HSEM_TAKE_RELEASE(_id_)             do { HAL_HSEM_FastTake((_id_)); HAL_HSEM_Release((_id_), 0); } while (0)
-#define HSEM_WAKEUP_CPU2                    0
-#define HSEM_WAKEUP_CPU2_MASK               __HAL_HSEM_SEMID_TO_MASK(HSEM_WAKEUP_CPU2)
-#define HSEM_CM4_TO_CM7                     1
+#define HSEM_BOOT_CPU1                      0   /* CPU1 advanced boot stage, see ipc_boot.c */
+#define HSEM_CHAN(id)                       (1 + (id))
+#define HSEM_CM4_TO_CM7                     HSEM_CHAN(IPC_CHAN_CM4_TO_CM7)
 #define HSEM_CM4_TO_CM7_MASK                __HAL_HSEM_SEMID_TO_MASK(HSEM_CM4_TO_CM7)
-#define HSEM_CM7_TO_CM4                     2
+#define HSEM_CM7_TO_CM4                     HSEM_CHAN(IPC_CHAN_CM7_TO_CM4)
 #define HSEM_CM7_TO_CM4_MASK                __HAL_HSEM_SEMID_TO_MASK(HSEM_CM7_TO_CM4)
+#define HSEM_CTRL_CM4_TO_CM7                HSEM_CHAN(IPC_CHAN_CTRL_CM4_TO_CM7)
+#define HSEM_CTRL_CM7_TO_CM4                HSEM_CHAN(IPC_CHAN_CTRL_CM7_TO_CM4)
+#define HSEM_POOL_CM4_TO_CM7                HSEM_CHAN(IPC_CHAN_POOL_CM4_TO_CM7)
+#define HSEM_POOL_RET_CM7_TO_CM4            HSEM_CHAN(IPC_CHAN_POOL_RET_CM7_TO_CM4)
+#define HSEM_JOB_CM7_TO_CM4                 HSEM_CHAN(IPC_CHAN_JOB_CM7_TO_CM4)
+#define HSEM_JOB_RET_CM4_TO_CM7             HSEM_CHAN(IPC_CHAN_JOB_RET_CM4_TO_CM7)
+#define HSEM_RPMSG_CM7_TO_CM4               HSEM_CHAN(IPC_CHAN_RPMSG_CM7_TO_CM4)
+#define HSEM_RPMSG_CM4_TO_CM7               HSEM_CHAN(IPC_CHAN_RPMSG_CM4_TO_CM7)
+#define HSEM_FWU_CM7_TO_CM4                 HSEM_CHAN(IPC_CHAN_FWU_CM7_TO_CM4)
+#define HSEM_ACQ_CM4_TO_CM7                 HSEM_CHAN(IPC_CHAN_ACQ_CM4_TO_CM7)
+#define HSEM_TOPIC(id)                      (1 + IPC_CHAN_COUNT + (id))
+#define HSEM_HEAP                           (1 + IPC_CHAN_COUNT + IPC_TOPIC_COUNT)
+#define HSEM_PP(id)                         (2 + IPC_CHAN_COUNT + IPC_TOPIC_COUNT + (id))
+#define HSEM_SIGNAL(id)                     (2 + IPC_CHAN_COUNT + IPC_TOPIC_COUNT + IPC_PP_COUNT + (id))
+#define HSEM_BOOT_CPU2                      HSEM_SIGNAL(IPC_SIGNAL_COUNT)   /* Taken while CPU2 is alive, released once it attached */
+#define HSEM_CRC                            (HSEM_BOOT_CPU2 + 1)    /* CRC unit, see ringbuff_crc.c */
 
-/* Flags management */
-#define WAIT_COND_WITH_TIMEOUT(c, t)        do {        \
-    int32_t timeout = (int32_t)(t);                     \
-    while ((c) && timeout-- > 0) {}                     \
-    if (timeout < 0) {                                  \
-        Error_Handler();                                \
-    }                                                   \
+#define HSEM_MPMC(id)                       (HSEM_CRC + 1 + 2 * (id))   /* Ring doorbell, see ipc_mpmc.c */
+#define HSEM_MPMC_LOCK(id)                  (HSEM_MPMC(id) + 1)         /* Ring slot claims */
+#define HSEM_STEAL(core)                    (HSEM_MPMC(IPC_MPMC_COUNT) + 2 * (core))    /* Jobs queued to deque of core, see ipc_steal.c */
+#define HSEM_STEAL_LOCK(core)               (HSEM_STEAL(core) + 1)      /* Deque of core */
+
+/* Failed takes of ipc_lock before it waits for semaphore free interrupt, see ipc_lock.c */
+#define IPC_LOCK_SPIN                       32
+
+/* Maximum time of each boot handshake wait in units of microseconds, see ipc_boot.c */
+#define IPC_BOOT_TIMEOUT_US                 1000000
+
+/* DWT cycle counter, time base for measurements and timeouts on both cores */
+#if defined(CORE_CM7)
+#define CYCCNT_UNLOCK()                     do { DWT->LAR = 0xC5ACCE55; } while (0)
+#else
+#define CYCCNT_UNLOCK()                     do {} while (0)
+#endif
+#define CYCCNT_INIT()                       do {        \
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;     \
+    CYCCNT_UNLOCK();                                    \
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;                \
 } while (0)
+#define CYCCNT_GET()                        (DWT->CYCCNT)
+#define CYCCNT_PER_US()                     (SystemCoreClock / 1000000)
+
+/* Doorbell coalescing for CM4 to CM7 pipe, see ipc_notify_coalesce_init */
+#define IPC_CM4_TO_CM7_NOTIFY_LEVEL         (IPC_CHAN_LEN_CM4_TO_CM7 / 4)
+#define IPC_CM4_TO_CM7_NOTIFY_COUNT         8
+#define IPC_CM4_TO_CM7_NOTIFY_TIMEOUT_US    500
 
 /* LEDs */
 #define LD1_GPIO_CLK_EN                     __HAL_RCC_GPIOB_CLK_ENABLE
@@ -0,0 +1,54 @@
+/**
+ * \file            ipc_bench.h
+ * \brief           Inter-core pipe benchmark
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_BENCH_HDR_H
+#define IPC_BENCH_HDR_H
+
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+#include "ipc_rpc.h"
+#include "ipc_rpmsg.h"
+
+/**
+ * \brief           Output function for benchmark report lines
+ * \param[in]       str: Text to output, not `NULL` terminated
+ * \param[in]       len: Length of text in units of bytes
+ */
+typedef void (*ipc_bench_out_fn)(const char* str, size_t len);
+
+/* CPU1, measures and reports */
+void    ipc_bench_run(ringbuff_t* tx, ringbuff_t* rx, ipc_bench_out_fn out_fn);
+void    ipc_bench_rpc(ipc_rpc_client_t* cli, ipc_bench_out_fn out_fn);
+void    ipc_bench_rpmsg(struct rpmsg_device* rdev, ipc_bench_out_fn out_fn);
+
+/* CPU2, consumes and echoes data until CPU1 finishes */
+void    ipc_bench_serve(ringbuff_t* rx, ringbuff_t* tx);
+
+#endif /* IPC_BENCH_HDR_H */
@@ -0,0 +1,85 @@
+/**
+ * \file            ipc_blog.h
+ * \brief           Deferred binary log
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_BLOG_HDR_H
+#define IPC_BLOG_HDR_H
+
+#include <stdint.h>
+#include "main.h"
+#include "common.h"
+#include "ringbuff/ringbuff.h"
+
+/* Maximum number of arguments of one record */
+#define IPC_BLOG_MAX_ARGS                   8
+
+/* Synchronization byte in bits `31:24` of record header */
+#define IPC_BLOG_SYNC                       0xB1
+
+/**
+ * \brief           Binary log record, as written to buffer in units of 32-bit words
+ *
+ * - `hdr`: Bits `31:24` are \ref IPC_BLOG_SYNC, bits `7:0` are number of arguments
+ * - `fmt`: Address of format string in CPU2 flash, decoder looks it up in CPU2 image
+ * - `stamp`: CPU2 tick in units of milliseconds
+ * - `args`: Raw 32-bit arguments, `%s` arguments are addresses of strings in CPU2 flash
+ */
+typedef struct {
+    uint32_t hdr;                               /*!< Record header */
+    uint32_t fmt;                               /*!< Format string address */
+    uint32_t stamp;                             /*!< Timestamp */
+    uint32_t args[IPC_BLOG_MAX_ARGS];           /*!< Arguments, only `hdr & 0xFF` entries are written */
+} ipc_blog_rec_t;
+
+/* Producer, CPU2 */
+uint8_t     ipc_blog_init(RINGBUFF_VOLATILE ringbuff_t* rb);
+size_t      ipc_blog_write(const char* fmt, const uint32_t* args, size_t nargs);
+uint32_t    ipc_blog_get_dropped(void);
+
+/**
+ * \brief           Log record with format string and up to \ref IPC_BLOG_MAX_ARGS integer arguments.
+ *
+ * Format string is placed in flash and only its address is sent,
+ * arguments are converted to `uint32_t` and not formatted by caller.
+ * Strings for `%s` must be constants in flash, cast to `uint32_t`
+ *
+ * \param[in]       fmt: String literal with `printf` format
+ */
+#define IPC_LOG(fmt, ...)                   do {            \
+    static const char ipc_blog_fmt[] = fmt;                 \
+    const uint32_t ipc_blog_args[] = { 0, ##__VA_ARGS__ };  \
+    _Static_assert(sizeof(ipc_blog_args) / sizeof(uint32_t) - 1 <= IPC_BLOG_MAX_ARGS, "Too many arguments"); \
+    ipc_blog_write(ipc_blog_fmt, &ipc_blog_args[1], sizeof(ipc_blog_args) / sizeof(uint32_t) - 1); \
+} while (0)
+
+/* Decoder, CPU1 */
+uint8_t     ipc_blog_read(RINGBUFF_VOLATILE ringbuff_t* rb, ipc_blog_rec_t* rec);
+size_t      ipc_blog_render(const ipc_blog_rec_t* rec, char* str, size_t len);
+
+#endif /* IPC_BLOG_HDR_H */
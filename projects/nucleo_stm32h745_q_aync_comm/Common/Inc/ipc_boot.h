@@ -0,0 +1,72 @@
+/**
+ * \file            ipc_boot.h
+ * \brief           Boot handshake of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_BOOT_HDR_H
+#define IPC_BOOT_HDR_H
+
+#include <stdint.h>
+
+/* Boot record is valid when magic has this value */
+#define IPC_BOOT_MAGIC                      0x424F4F54
+
+/* Version of shared RAM protocol, increase on incompatible change of control part */
+#define IPC_BOOT_ABI                        1
+
+/* Core index in boot record */
+#define IPC_BOOT_CPU1                       0
+#define IPC_BOOT_CPU2                       1
+
+/**
+ * \brief           Boot stage of core, stages only increase
+ */
+typedef enum {
+    IPC_BOOT_STAGE_NONE,                        /*!< Core did not start handshake */
+    IPC_BOOT_STAGE_STARTED,                     /*!< CPU1 wrote boot record, CPU2 listens for CPU1 stages */
+    IPC_BOOT_STAGE_CLOCKS,                      /*!< CPU1 configured and published clocks */
+    IPC_BOOT_STAGE_CHANNELS,                    /*!< CPU1 published channel directory */
+    IPC_BOOT_STAGE_ATTACHED,                    /*!< CPU2 attached to channels and listens for doorbells */
+} ipc_boot_stage_t;
+
+/**
+ * \brief           Boot record, first in control part of shared RAM.
+ *                  Written by CPU1 except stage of CPU2, each stage has single writer
+ */
+typedef struct {
+    uint32_t magic;                             /*!< \ref IPC_BOOT_MAGIC */
+    uint32_t abi;                               /*!< \ref IPC_BOOT_ABI of CPU1 image */
+    uint32_t layout_hash;                       /*!< Shared RAM layout hash of CPU1 image */
+    uint32_t stage[2];                          /*!< Stage of each core, \ref ipc_boot_stage_t */
+} ipc_boot_shared_t;
+
+void    ipc_boot_start(void);
+void    ipc_boot_advance(ipc_boot_stage_t stage);
+uint8_t ipc_boot_wait(uint32_t core, ipc_boot_stage_t stage, uint32_t timeout_us);
+
+#endif /* IPC_BOOT_HDR_H */
@@ -0,0 +1,387 @@
+/**
+ * \file            ipc_chan.h
+ * \brief           Channel directory in shared memory
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_CHAN_HDR_H
+#define IPC_CHAN_HDR_H
+
+#include <stdint.h>
+#include "common.h"
+#include "ringbuff/ringbuff.h"
+#include "ipc_lat.h"
+#include "ipc_credit.h"
+#include "ipc_pubsub.h"
+#include "ipc_pingpong.h"
+#include "ipc_mpmc.h"
+#include "ipc_steal.h"
+#include "ipc_soak.h"
+#include "ipc_clk.h"
+#include "ipc_boot.h"
+#include "ipc_time.h"
+#include "ipc_hb.h"
+#include "ipc_fwu.h"
+#include "ipc_scan.h"
+#include "ipc_mon.h"
+#include "ipc_load.h"
+#include "ipc_frec.h"
+
+/* Maximum number of channels in directory */
+#define IPC_CHAN_MAX                        16
+
+/* Directory is valid when magic has this value */
+#define IPC_CHAN_DIR_MAGIC                  0x43484E44
+
+/**
+ * \brief           Channel entry in directory, fixed-size fields for both cores
+ */
+typedef struct {
+    uint32_t shared_addr;                       /*!< Address of \ref ringbuff_shared_t, `0` for unused entry */
+    uint32_t data_addr;                         /*!< Address of data array */
+    uint32_t data_len;                          /*!< Length of data array in units of bytes */
+    uint32_t sem_id;                            /*!< Doorbell semaphore ID */
+} ipc_chan_entry_t;
+
+/**
+ * \brief           Channel directory, placed at the beginning of channel memory
+ */
+typedef struct {
+    uint32_t magic;                             /*!< Set to \ref IPC_CHAN_DIR_MAGIC once directory is published */
+    uint32_t layout_len;                        /*!< Size of \ref ipc_shm_t, both images must agree */
+    ipc_chan_entry_t entries[IPC_CHAN_MAX];     /*!< Channel entries, indexed by channel ID */
+} ipc_chan_dir_t;
+
+/**
+ * \brief           Channel resize handshake, generation counters have single writer each.
+ *
+ * Resize is pending while `req != done`, CPU2 does not access channels until it attached to generation `done`
+ */
+typedef struct {
+    uint32_t req;                               /*!< Requested generation, written by CPU1 */
+    uint32_t ack;                               /*!< Generation acknowledged by CPU2, it stopped accessing channels */
+    uint32_t done;                              /*!< Generation carved by CPU1, written after directory update */
+    uint32_t data_len[IPC_CHAN_MAX];            /*!< Requested data lengths, indexed by channel ID */
+} ipc_chan_resize_t;
+
+/*
+ * Shared RAM layout, generated from IPC_CHAN_TABLE:
+ *
+ * - Control part: channel directory, pointers, latency instrumentation and credits of all channels, topic state,
+ *      ping-pong block ownership,
+ *      IPC_SHM_CTRL_LEN bytes at start of shared RAM, power of 2 to be covered by single MPU region.
+ *      Latency instrumentation of all channels needs 8kB
+ * - Shared heap, when IPC_HEAP is enabled. Control part and heap are IPC_SHM_NC_LEN bytes,
+ *      covered by single non-cacheable MPU region
+ * - Data of each channel, in table order
+ * - Data of each topic, when IPC_PUBSUB is enabled
+ * - Blocks of each ping-pong channel, when IPC_PP is enabled
+ * - Slots of each MPMC ring, when IPC_MPMC is enabled
+ * - Job deques of both cores, when IPC_STEAL is enabled
+ * - Copy benchmark scratch memory, when COPY_BENCH is enabled
+ * - Bus matrix benchmark scratch memory of both cores, when MEM_BENCH is enabled
+ *
+ * Flight recorder, when IPC_FREC is enabled, is not part of layout. It takes last IPC_FREC_LEN bytes
+ * of SRAM4 at fixed address, layout and channels are shortened by its length
+ *
+ * Every part starts on its own cache line. Data of channels placed to AXI or D2 region
+ * are in separate layouts, ipc_shm_axi_t and ipc_shm_d2_t, each at start of its region
+ */
+#if IPC_LAT
+#define IPC_SHM_CTRL_LEN                    0x00002000
+#define IPC_SHM_CTRL_MPU_SIZE               MPU_REGION_SIZE_8KB
+#else
+#define IPC_SHM_CTRL_LEN                    0x00000800
+#define IPC_SHM_CTRL_MPU_SIZE               MPU_REGION_SIZE_2KB
+#endif /* IPC_LAT */
+
+/*
+ * Part of layout that stays non-cacheable for CPU1, control part and heap,
+ * power of 2 to be covered by single MPU region
+ */
+#if IPC_HEAP
+#define IPC_SHM_NC_LEN                      IPC_HEAP_NC_LEN
+#define IPC_SHM_NC_MPU_SIZE                 IPC_HEAP_NC_MPU_SIZE
+#define IPC_SHM_HEAP_LEN                    (IPC_HEAP_NC_LEN - IPC_SHM_CTRL_LEN)
+#else
+#define IPC_SHM_NC_LEN                      IPC_SHM_CTRL_LEN
+#define IPC_SHM_NC_MPU_SIZE                 IPC_SHM_CTRL_MPU_SIZE
+#define IPC_SHM_HEAP_LEN                    0
+#endif /* IPC_HEAP */
+
+#if COPY_BENCH
+#define IPC_SHM_BENCH_LEN                   MEM_ALIGN_CACHE(COPY_BENCH_LEN + 4)
+#else
+#define IPC_SHM_BENCH_LEN                   0
+#endif /* COPY_BENCH */
+
+#if IPC_PUBSUB
+#define IPC_TOPIC_X_LEN_SUM(name, len)      + MEM_ALIGN_CACHE(len)
+#define IPC_SHM_TOPIC_LEN                   (0 IPC_TOPIC_TABLE(IPC_TOPIC_X_LEN_SUM))
+#else
+#define IPC_SHM_TOPIC_LEN                   0
+#endif /* IPC_PUBSUB */
+
+#if IPC_PP
+#define IPC_PP_X_LEN_SUM(name, blocks, block_len)   + (blocks) * MEM_ALIGN_CACHE(block_len)
+#define IPC_SHM_PP_LEN                      (0 IPC_PP_TABLE(IPC_PP_X_LEN_SUM))
+#else
+#define IPC_SHM_PP_LEN                      0
+#endif /* IPC_PP */
+
+#if IPC_MPMC
+#define IPC_MPMC_X_LEN_SUM(name, slots, slot_len)   + (slots) * MEM_ALIGN_CACHE(slot_len)
+#define IPC_SHM_MPMC_LEN                    (0 IPC_MPMC_TABLE(IPC_MPMC_X_LEN_SUM))
+#else
+#define IPC_SHM_MPMC_LEN                    0
+#endif /* IPC_MPMC */
+
+#if IPC_STEAL
+#define IPC_SHM_STEAL_LEN                   (2 * IPC_STEAL_SLOTS * sizeof(ipc_steal_job_t))
+#else
+#define IPC_SHM_STEAL_LEN                   0
+#endif /* IPC_STEAL */
+
+#if MEM_BENCH
+#define IPC_SHM_MEM_BENCH_LEN               (2 * MEM_BENCH_LEN)
+#else
+#define IPC_SHM_MEM_BENCH_LEN               0
+#endif /* MEM_BENCH */
+
+#if IPC_FREC
+#define IPC_SHM_FREC_LEN                    IPC_FREC_LEN
+#else
+#define IPC_SHM_FREC_LEN                    0
+#endif /* IPC_FREC */
+
+/* Fixed part of layout */
+#define IPC_SHM_FIXED_LEN                   (IPC_SHM_NC_LEN + 2 * IPC_SHM_BENCH_LEN + IPC_SHM_TOPIC_LEN + IPC_SHM_PP_LEN \
+                                                + IPC_SHM_MPMC_LEN + IPC_SHM_STEAL_LEN + IPC_SHM_MEM_BENCH_LEN + IPC_SHM_FREC_LEN)
+
+/* Round channel length down to size supported by ring buffer */
+#if RINGBUFF_USE_POW2
+#define IPC_CHAN_FIT_LEN(x)                 MEM_POW2_FLOOR(x)
+#else
+#define IPC_CHAN_FIT_LEN(x)                 ((x) & ~(MEM_CACHE_LINE_SIZE - 1))
+#endif /* RINGBUFF_USE_POW2 */
+
+/* Region index of placement token, SHD_REGION_<region> */
+#define IPC_SHM_REGION(region)              SHD_REGION_##region
+
+/*
+ * Expand to X only for channels placed to TARGET region, IPC_SHM_IN_<region>_<target>(x).
+ * Selects data arrays of each region layout
+ */
+#define IPC_SHM_IN_SRAM4_SRAM4(x)           x
+#define IPC_SHM_IN_SRAM4_AXI(x)
+#define IPC_SHM_IN_SRAM4_D2(x)
+#define IPC_SHM_IN_AXI_SRAM4(x)
+#define IPC_SHM_IN_AXI_AXI(x)               x
+#define IPC_SHM_IN_AXI_D2(x)
+#define IPC_SHM_IN_D2_SRAM4(x)
+#define IPC_SHM_IN_D2_AXI(x)
+#define IPC_SHM_IN_D2_D2(x)                 x
+
+/*
+ * Sums over channel table and channel data lengths, IPC_CHAN_LEN_<name>.
+ * Minimum lengths are summed over SRAM4 channels only, other regions have their own layouts.
+ * Sums are enumerators, not macros, as they are used inside IPC_CHAN_TABLE expansion
+ */
+#define IPC_CHAN_X_MIN_SUM(name, min_len, weight, region)       + (IPC_SHM_REGION(region) == SHD_REGION_SRAM4 ? (min_len) : 0)
+#define IPC_CHAN_X_WEIGHT_SUM(name, min_len, weight, region)    + (weight)
+#define IPC_CHAN_X_AWAY_SUM(name, min_len, weight, region)      + (IPC_SHM_REGION(region) != SHD_REGION_SRAM4)
+#define IPC_CHAN_X_LEN(name, min_len, weight, region)                                   \
+    IPC_CHAN_LEN_##name = IPC_CHAN_FIT_LEN((min_len) + IPC_SHM_SPARE_LEN / IPC_CHAN_WEIGHT_SUM * (weight)),
+enum {
+    IPC_CHAN_AWAY_COUNT = 0 IPC_CHAN_TABLE(IPC_CHAN_X_AWAY_SUM),     /* Channels with data outside SRAM4 */
+    IPC_CHAN_MIN_SUM = 0 IPC_CHAN_TABLE(IPC_CHAN_X_MIN_SUM),
+    IPC_CHAN_WEIGHT_SUM = 0 IPC_CHAN_TABLE(IPC_CHAN_X_WEIGHT_SUM),
+    IPC_SHM_SPARE_LEN = SHD_RAM_LEN - IPC_SHM_FIXED_LEN - IPC_CHAN_MIN_SUM, /* Shared RAM left for distribution to channels */
+    IPC_CHAN_TABLE(IPC_CHAN_X_LEN)
+};
+
+/* Channel pointers, shared_<name>, and data, data_<name> */
+#define IPC_CHAN_X_SHARED(name, min_len, weight, region)                                \
+    ringbuff_shared_t shared_##name __ALIGNED(MEM_CACHE_LINE_SIZE);
+#define IPC_CHAN_X_DATA_IN(target, name, region)                                        \
+    IPC_SHM_IN_##region##_##target(uint8_t data_##name[IPC_CHAN_LEN_##name] __ALIGNED(MEM_CACHE_LINE_SIZE);)
+#define IPC_CHAN_X_DATA(name, min_len, weight, region)      IPC_CHAN_X_DATA_IN(SRAM4, name, region)
+#define IPC_CHAN_X_DATA_AXI(name, min_len, weight, region)  IPC_CHAN_X_DATA_IN(AXI, name, region)
+#define IPC_CHAN_X_DATA_D2(name, min_len, weight, region)   IPC_CHAN_X_DATA_IN(D2, name, region)
+
+/* Topic data, topic_<name> */
+#define IPC_TOPIC_X_DATA(name, len)                                                     \
+    uint8_t topic_##name[len] __ALIGNED(MEM_CACHE_LINE_SIZE);
+
+/* Ping-pong channel blocks, pp_<name> */
+#define IPC_PP_X_DATA(name, blocks, block_len)                                          \
+    uint8_t pp_##name[(blocks) * (block_len)] __ALIGNED(MEM_CACHE_LINE_SIZE);
+
+/* MPMC ring slots, mpmc_<name> */
+#define IPC_MPMC_X_DATA(name, slots, slot_len)                                          \
+    uint8_t mpmc_##name[(slots) * (slot_len)] __ALIGNED(MEM_CACHE_LINE_SIZE);
+
+/**
+ * \brief           Control part of shared RAM layout
+ */
+typedef struct {
+    ipc_boot_shared_t boot __ALIGNED(MEM_CACHE_LINE_SIZE);  /*!< Boot record, at fixed offset for all layouts */
+#if IPC_MON
+    ipc_mon_hdr_t mon __ALIGNED(MEM_CACHE_LINE_SIZE);   /*!< Introspection header, at fixed offset for all layouts */
+#endif /* IPC_MON */
+    ipc_chan_dir_t dir __ALIGNED(MEM_CACHE_LINE_SIZE);  /*!< Channel directory */
+    IPC_CHAN_TABLE(IPC_CHAN_X_SHARED)                   /* Channel pointers */
+    ipc_clk_shared_t clk;                               /*!< Active clock configuration */
+#if IPC_TIME
+    ipc_time_shared_t time;                             /*!< Timebase epoch */
+#endif /* IPC_TIME */
+#if IPC_HB
+    ipc_hb_shared_t hb;                                 /*!< Peer health */
+#endif /* IPC_HB */
+#if IPC_RESIZE
+    ipc_chan_resize_t resize;                           /*!< Channel resize handshake */
+#endif /* IPC_RESIZE */
+#if IPC_LAT
+    ipc_lat_shared_t lat[IPC_CHAN_COUNT];               /*!< Latency instrumentation, indexed by channel ID */
+#endif /* IPC_LAT */
+#if IPC_CREDIT
+    ipc_credit_shared_t credit[IPC_CHAN_COUNT];         /*!< Stream credits, indexed by channel ID */
+#endif /* IPC_CREDIT */
+#if IPC_PUBSUB
+    ipc_topic_shared_t topic[IPC_TOPIC_COUNT];          /*!< Topic state, indexed by topic ID */
+#endif /* IPC_PUBSUB */
+#if IPC_PP
+    ipc_pp_shared_t pp[IPC_PP_COUNT];                   /*!< Ping-pong block ownership, indexed by channel ID */
+#endif /* IPC_PP */
+#if IPC_MPMC
+    ipc_mpmc_shared_t mpmc[IPC_MPMC_COUNT];             /*!< MPMC ring positions and slot sequences, indexed by ring ID */
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+    ipc_steal_shared_t steal[2];                        /*!< Job deque state of CPU1 and CPU2 */
+#endif /* IPC_STEAL */
+#if IPC_SOAK
+    ipc_soak_stats_t soak[2];                           /*!< Soak test statistics, CPU1 and CPU2 */
+#endif /* IPC_SOAK */
+#if IPC_FWU
+    ipc_fwu_shared_t fwu;                               /*!< CPU2 firmware update progress */
+#endif /* IPC_FWU */
+#if IPC_LOAD
+    ipc_load_shared_t load[2];                          /*!< Load of CPU1 and CPU2 */
+#endif /* IPC_LOAD */
+} ipc_shm_ctrl_t;
+
+/**
+ * \brief           Shared RAM layout
+ */
+typedef struct {
+    union {
+        ipc_shm_ctrl_t ctrl;                            /*!< Directory and pointers */
+        uint8_t ctrl_mem[IPC_SHM_CTRL_LEN];             /*!< Control part size */
+    } __ALIGNED(MEM_CACHE_LINE_SIZE);
+#if IPC_HEAP
+    uint8_t heap[IPC_SHM_HEAP_LEN] __ALIGNED(MEM_CACHE_LINE_SIZE);  /*!< Shared heap, see ipc_heap.c */
+#endif /* IPC_HEAP */
+    IPC_CHAN_TABLE(IPC_CHAN_X_DATA)                     /* Channel data */
+#if IPC_PUBSUB
+    IPC_TOPIC_TABLE(IPC_TOPIC_X_DATA)                   /* Topic data */
+#endif /* IPC_PUBSUB */
+#if IPC_PP
+    IPC_PP_TABLE(IPC_PP_X_DATA)                         /* Ping-pong channel blocks */
+#endif /* IPC_PP */
+#if IPC_MPMC
+    IPC_MPMC_TABLE(IPC_MPMC_X_DATA)                     /* MPMC ring slots */
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+    ipc_steal_job_t steal[2][IPC_STEAL_SLOTS] __ALIGNED(MEM_CACHE_LINE_SIZE);  /*!< Job deques of CPU1 and CPU2 */
+#endif /* IPC_STEAL */
+#if COPY_BENCH
+    uint8_t bench_cm7[IPC_SHM_BENCH_LEN] __ALIGNED(MEM_CACHE_LINE_SIZE);/*!< CPU1 copy benchmark scratch memory */
+    uint8_t bench_cm4[IPC_SHM_BENCH_LEN] __ALIGNED(MEM_CACHE_LINE_SIZE);/*!< CPU2 copy benchmark scratch memory */
+#endif /* COPY_BENCH */
+#if MEM_BENCH
+    uint8_t mem_bench[2][MEM_BENCH_LEN] __ALIGNED(MEM_CACHE_LINE_SIZE);  /*!< Bus matrix benchmark scratch memory of CPU1 and CPU2 */
+#endif /* MEM_BENCH */
+} ipc_shm_t;
+
+/**
+ * \brief           AXI SRAM layout, data of channels placed to AXI region
+ */
+typedef struct {
+    IPC_CHAN_TABLE(IPC_CHAN_X_DATA_AXI)                 /* Channel data */
+#if MEM_BENCH
+    uint8_t mem_bench[2][MEM_BENCH_LEN] __ALIGNED(MEM_CACHE_LINE_SIZE);  /*!< Bus matrix benchmark scratch memory of CPU1 and CPU2 */
+#endif /* MEM_BENCH */
+} ipc_shm_axi_t;
+
+/**
+ * \brief           D2 SRAM2 layout, data of channels placed to D2 region
+ */
+typedef struct {
+    IPC_CHAN_TABLE(IPC_CHAN_X_DATA_D2)                  /* Channel data */
+#if MEM_BENCH
+    uint8_t mem_bench[2][MEM_BENCH_LEN] __ALIGNED(MEM_CACHE_LINE_SIZE);  /*!< Bus matrix benchmark scratch memory of CPU1 and CPU2 */
+#endif /* MEM_BENCH */
+} ipc_shm_d2_t;
+
+/* Channel data are cacheable for this core, see SHD_RAM_DATA_CACHE, data array maintenance is enabled */
+#if defined(CORE_CM7) && SHD_RAM_DATA_CACHE != SHD_RAM_DATA_NC
+#define IPC_CHAN_CACHE_MAINT                1
+#else
+#define IPC_CHAN_CACHE_MAINT                0
+#endif
+
+/* Shared RAM instance, placed to `.shared_ram` linker section at SHD_RAM_START_ADDR */
+extern ipc_shm_t ipc_shm;
+#define IPC_SHM                             ((volatile ipc_shm_t *)&ipc_shm)
+
+/* Layouts of other placement regions, `.shared_axi` at SHD_AXI_START_ADDR and `.shared_d2` at SHD_D2_START_ADDR */
+extern ipc_shm_axi_t ipc_shm_axi;
+extern ipc_shm_d2_t ipc_shm_d2;
+#define IPC_SHM_AXI                         ((volatile ipc_shm_axi_t *)&ipc_shm_axi)
+#define IPC_SHM_D2                          ((volatile ipc_shm_d2_t *)&ipc_shm_d2)
+
+/* Owner core, CPU1 */
+void        ipc_chan_dir_init(void);
+uint8_t     ipc_chan_create(uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb);
+void        ipc_chan_dir_publish(void);
+#if IPC_RESIZE
+uint8_t     ipc_chan_resize_request(const uint32_t* data_len);
+#endif /* IPC_RESIZE */
+
+/* Both cores */
+uint8_t     ipc_chan_dir_is_ready(void);
+uint8_t     ipc_chan_open(uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb);
+uint32_t    ipc_chan_get_sem(uint32_t id);
+uint32_t    ipc_chan_layout_hash(void);
+#if IPC_SCAN
+ipc_scan_err_t  ipc_chan_check(uint32_t id);
+#endif /* IPC_SCAN */
+#if IPC_RESIZE
+uint8_t     ipc_chan_resize_poll(void);
+#endif /* IPC_RESIZE */
+
+#endif /* IPC_CHAN_HDR_H */
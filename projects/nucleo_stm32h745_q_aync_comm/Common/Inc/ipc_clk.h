@@ -0,0 +1,90 @@
+/**
+ * \file            ipc_clk.h
+ * \brief           Clock profiles of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_CLK_HDR_H
+#define IPC_CLK_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+#include "ipc_rpc.h"
+
+/**
+ * \brief           Active clock configuration, in control part of shared RAM.
+ *                  Written by CPU1 only, `gen` is written last
+ */
+typedef struct {
+    uint32_t profile;                           /*!< Active profile, `IPC_CLK_PROFILE_*` */
+    uint32_t sysclk_hz;                         /*!< CPU1 core clock in units of Hz */
+    uint32_t hclk_hz;                           /*!< CPU2 core, AXI and AHB clock in units of Hz */
+    uint32_t pclk_hz;                           /*!< APB clock of all domains in units of Hz */
+    uint32_t gen;                               /*!< Incremented after each clock change */
+} ipc_clk_shared_t;
+
+/**
+ * \brief           Clock change event
+ */
+typedef enum {
+    IPC_CLK_EVT_PAUSE,                          /*!< Clocks are about to change, stop timers and DMA of bus clocks */
+    IPC_CLK_EVT_RESUME,                         /*!< Clocks changed, `SystemCoreClock` is updated, restart and re-derive timings */
+} ipc_clk_evt_t;
+
+/**
+ * \brief           Clock change event callback, runs on each core in thread mode
+ * \param[in]       evt: Event type
+ */
+typedef void (*ipc_clk_evt_fn)(ipc_clk_evt_t evt);
+
+/**
+ * \brief           Clock governor of CPU1, fill level of monitored buffer selects profile
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* buff;         /*!< Monitored buffer, consumed by CPU1 */
+    size_t up_level;                            /*!< Fill level in units of bytes which selects high profile */
+    uint32_t idle_ms;                           /*!< Time below `up_level` after which low profile is selected */
+    uint32_t busy_time;                         /*!< Tick when fill level was last at `up_level` or above */
+} ipc_clk_gov_t;
+
+/* CPU1 */
+uint8_t     ipc_clk_set(uint32_t profile);
+int32_t     ipc_clk_change(ipc_rpc_client_t* cli, uint32_t profile);
+void        ipc_clk_gov_init(ipc_clk_gov_t* gov, RINGBUFF_VOLATILE ringbuff_t* buff, size_t up_level, uint32_t idle_ms);
+uint32_t    ipc_clk_gov_poll(ipc_clk_gov_t* gov, uint32_t now);
+
+/* CPU2 */
+uint8_t     ipc_clk_sync(void);
+int32_t     ipc_clk_rpc_pause(const void* args, size_t len, void* res, size_t* res_len);
+uint8_t     ipc_clk_poll(void);
+
+/* Both */
+void        ipc_clk_set_evt_fn(ipc_clk_evt_fn fn);
+uint32_t    ipc_clk_get_profile(void);
+
+#endif /* IPC_CLK_HDR_H */
@@ -0,0 +1,65 @@
+/**
+ * \file            ipc_cobs.h
+ * \brief           COBS framing
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_COBS_HDR_H
+#define IPC_COBS_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Frame on link: COBS encoded record followed by single 0x00 delimiter.
+ * Record is channel ID byte followed by channel data.
+ * Receiver resynchronizes on next delimiter after any error
+ */
+#define IPC_COBS_DELIM                      0x00
+#define IPC_COBS_DATA_MAX                   1024    /* Maximum channel data of one record */
+
+/* Maximum encoded length of `n` bytes, including delimiter */
+#define IPC_COBS_ENC_MAX(n)                 ((n) + (n) / 254 + 2)
+
+/* Maximum frame length of record with IPC_COBS_DATA_MAX data */
+#define IPC_COBS_FRAME_MAX                  IPC_COBS_ENC_MAX(1 + IPC_COBS_DATA_MAX)
+
+/**
+ * \brief           Streaming encoder of one frame, input is added in fragments
+ */
+typedef struct {
+    uint8_t* out;                               /*!< Output memory, at least \ref IPC_COBS_ENC_MAX of input */
+    size_t len;                                 /*!< Output length */
+    size_t code;                                /*!< Position of current code byte */
+} ipc_cobs_enc_t;
+
+void        ipc_cobs_enc_begin(ipc_cobs_enc_t* enc, uint8_t* out);
+void        ipc_cobs_enc_put(ipc_cobs_enc_t* enc, const void* data, size_t len);
+size_t      ipc_cobs_enc_end(ipc_cobs_enc_t* enc);
+int32_t     ipc_cobs_decode(const uint8_t* in, size_t len, uint8_t* out, size_t size);
+
+#endif /* IPC_COBS_HDR_H */
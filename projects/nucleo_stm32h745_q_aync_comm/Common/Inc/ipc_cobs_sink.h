@@ -0,0 +1,48 @@
+/**
+ * \file            ipc_cobs_sink.h
+ * \brief           COBS framing stage of router sink
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_COBS_SINK_HDR_H
+#define IPC_COBS_SINK_HDR_H
+
+#include <stdint.h>
+#include "ipc_cobs.h"
+#include "ipc_route.h"
+
+/**
+ * \brief           COBS framing stage of sink, core-local
+ */
+typedef struct {
+    uint8_t frame[IPC_COBS_FRAME_MAX];          /*!< Frame memory when queue has no linear memory for it */
+    uint32_t frames;                            /*!< Number of frames queued */
+} ipc_cobs_sink_t;
+
+uint8_t     ipc_cobs_sink_init(ipc_cobs_sink_t* cs, ipc_sink_t* sink);
+
+#endif /* IPC_COBS_SINK_HDR_H */
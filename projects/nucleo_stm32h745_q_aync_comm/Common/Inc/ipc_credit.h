@@ -0,0 +1,90 @@
+/**
+ * \file            ipc_credit.h
+ * \brief           Credit-based flow control of channel streams
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_CREDIT_HDR_H
+#define IPC_CREDIT_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Number of logical streams per channel */
+#define IPC_CREDIT_STREAMS                  4
+
+/**
+ * \brief           Credits of single channel, in shared RAM control part.
+ *                  Written by consumer only, read by producer
+ */
+typedef struct {
+    uint32_t granted[IPC_CREDIT_STREAMS] __attribute__((aligned(32))); /*!< Bytes granted per stream since reset, free-running */
+} ipc_credit_shared_t;
+
+/**
+ * \brief           Record header, in front of every stream record in channel
+ */
+typedef struct {
+    uint16_t stream;                            /*!< Stream index */
+    uint16_t len;                               /*!< Payload length in units of bytes */
+} ipc_credit_hdr_t;
+
+/**
+ * \brief           Producer side of channel, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Channel buffer handle, producer side */
+    volatile ipc_credit_shared_t* shared;       /*!< Credits of channel */
+    uint32_t sent[IPC_CREDIT_STREAMS];          /*!< Bytes sent per stream, including headers */
+    uint32_t granted[IPC_CREDIT_STREAMS];       /*!< Shadow copy of granted bytes, re-read only when credit is short */
+} ipc_credit_tx_t;
+
+/**
+ * \brief           Consumer side of channel, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Channel buffer handle, consumer side */
+    volatile ipc_credit_shared_t* shared;       /*!< Credits of channel */
+    uint32_t batch;                             /*!< Number of released bytes per stream that are granted back at once */
+    uint32_t released[IPC_CREDIT_STREAMS];      /*!< Bytes read per stream, not granted back yet */
+} ipc_credit_rx_t;
+
+/* Owner core, CPU1, after channel is created */
+uint8_t     ipc_credit_init(uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb, const uint32_t* windows, size_t count);
+
+/* Producer */
+uint8_t     ipc_credit_tx_init(ipc_credit_tx_t* tx, uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb);
+size_t      ipc_credit_send(ipc_credit_tx_t* tx, uint32_t stream, const void* data, size_t len);
+uint32_t    ipc_credit_get(ipc_credit_tx_t* tx, uint32_t stream);
+
+/* Consumer */
+uint8_t     ipc_credit_rx_init(ipc_credit_rx_t* rx, uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb, uint32_t batch);
+size_t      ipc_credit_recv(ipc_credit_rx_t* rx, uint32_t* stream, void* data, size_t size);
+void        ipc_credit_rx_flush(ipc_credit_rx_t* rx);
+
+#endif /* IPC_CREDIT_HDR_H */
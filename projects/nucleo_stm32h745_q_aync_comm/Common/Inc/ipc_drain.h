@@ -0,0 +1,80 @@
+/**
+ * \file            ipc_drain.h
+ * \brief           Interrupt-side channel drain with bounded budget
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_DRAIN_HDR_H
+#define IPC_DRAIN_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Messages received with single read pointer update */
+#define IPC_DRAIN_BATCH                     8
+
+/**
+ * \brief           Budget unit of drain
+ */
+typedef enum {
+    IPC_DRAIN_BYTES,                            /*!< Byte stream, budget in units of bytes */
+    IPC_DRAIN_MSGS,                             /*!< Message channel, budget in units of messages */
+} ipc_drain_mode_t;
+
+struct ipc_drain;
+
+/**
+ * \brief           Data callback, called from interrupt for each linear block or message.
+ *                  Data are released from channel after callback returns
+ * \param[in]       d: Drain handle
+ * \param[in]       span: Data, second segment is used when message wraps at end of channel
+ */
+typedef void (*ipc_drain_fn)(struct ipc_drain* d, const ringbuff_msg_span_t* span);
+
+/**
+ * \brief           Interrupt-side consumer of one channel, core-local
+ */
+typedef struct ipc_drain {
+    struct ipc_drain* next;                     /*!< Next registered drain */
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Buffer handle, consumer side */
+    ipc_drain_fn fn;                            /*!< Data callback */
+    void* arg;                                  /*!< User argument */
+    ipc_drain_mode_t mode;                      /*!< Budget unit */
+    size_t budget;                              /*!< Bytes or messages consumed per interrupt */
+    volatile uint8_t busy;                      /*!< Set to `1` while continuation drains channel */
+    volatile uint8_t deferred;                  /*!< Set to `1` while continuation is pending */
+    uint32_t runs;                              /*!< Number of drain runs, doorbell and continuation */
+    uint32_t defers;                            /*!< Number of runs which left data to continuation */
+} ipc_drain_t;
+
+void    ipc_drain_init(ipc_drain_t* d, RINGBUFF_VOLATILE ringbuff_t* rb, ipc_drain_mode_t mode, size_t budget,
+                       ipc_drain_fn fn, void* arg);
+void    ipc_drain_irq(ipc_drain_t* d);
+void    ipc_drain_resume(void);
+
+#endif /* IPC_DRAIN_HDR_H */
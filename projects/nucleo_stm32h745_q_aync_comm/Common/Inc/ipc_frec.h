@@ -0,0 +1,177 @@
+/**
+ * \file            ipc_frec.h
+ * \brief           Flight recorder of IPC events in retained SRAM4
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_FREC_HDR_H
+#define IPC_FREC_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Flight recorder, one event ring per core in last IPC_FREC_LEN bytes of SRAM4.
+ * Recorder is outside shared RAM layout at fixed address, memory is not initialized
+ * by startup code and ring survives warm reset. Content is checked at boot and cleared only
+ * when it is not valid, events of previous boots stay for post-mortem dump.
+ *
+ * Only fixed-width fields, header is included by host tool.
+ * Increase version on any change of ring layout or event word
+ */
+
+/* Ring is valid when magic has this value */
+#define IPC_FREC_MAGIC                      0x43455246
+#define IPC_FREC_VERSION                    1
+
+/* Recorder address and length, end of SRAM4, aligned to its length for single MPU region */
+#define IPC_FREC_ADDR                       0x3800C000
+#define IPC_FREC_LEN                        0x00004000
+
+/* Core index of ring */
+#define IPC_FREC_CPU1                       0
+#define IPC_FREC_CPU2                       1
+
+/*
+ * Event word, same layout as ringbuff_trace.h stimulus word:
+ *
+ * - Bits 31:24: ID, buffer trace ID, semaphore ID or source ID, by event
+ * - Bits 23:20: Event
+ * - Bits 19:0: Length, saturated
+ */
+#define IPC_FREC_LEN_MAX                    0x000FFFFF
+#define IPC_FREC_WORD(id, evt, len)         ((((uint32_t)(id) & 0xFF) << 24) | (((uint32_t)(evt) & 0x0F) << 20)   \
+                                                | ((len) > IPC_FREC_LEN_MAX ? IPC_FREC_LEN_MAX : (uint32_t)(len)))
+#define IPC_FREC_WORD_ID(w)                 ((w) >> 24)
+#define IPC_FREC_WORD_EVT(w)                (((w) >> 20) & 0x0F)
+#define IPC_FREC_WORD_LEN(w)                ((w) & IPC_FREC_LEN_MAX)
+
+/* Buffer events, values of ringbuff_evt_type_t, recorded from RINGBUFF_TRACE hook */
+#define IPC_FREC_EVT_READ                   0x00    /*!< Bytes read from buffer, ID is buffer trace ID */
+#define IPC_FREC_EVT_WRITE                  0x01    /*!< Bytes written to buffer, ID is buffer trace ID */
+#define IPC_FREC_EVT_RESET                  0x02    /*!< Buffer reset, ID is buffer trace ID */
+
+/* IPC events */
+#define IPC_FREC_EVT_NOTIFY                 0x08    /*!< Doorbell rung for other core, ID is semaphore */
+#define IPC_FREC_EVT_DOORBELL               0x09    /*!< Doorbell of other core delivered, ID is semaphore */
+#define IPC_FREC_EVT_DROP                   0x0A    /*!< Data dropped, ID is source, length is lost bytes */
+#define IPC_FREC_EVT_BOOT                   0x0B    /*!< Core booted, ID is boot counter, length is reset flags `RSR[31:16]` */
+
+/**
+ * \brief           Single event
+ */
+typedef struct {
+    uint32_t stamp;                             /*!< Cycle counter of core, restarts every boot */
+    uint32_t word;                              /*!< Event word, see \ref IPC_FREC_WORD */
+} ipc_frec_entry_t;
+
+/**
+ * \brief           Ring header, one cache line
+ */
+typedef struct {
+    uint32_t magic;                             /*!< \ref IPC_FREC_MAGIC when ring is valid */
+    uint32_t version;                           /*!< \ref IPC_FREC_VERSION */
+    uint32_t entries;                           /*!< Number of entries in ring, \ref IPC_FREC_ENTRIES */
+    uint32_t count;                             /*!< Number of appended events, wraps to `0` at \ref IPC_FREC_WRAP */
+    uint32_t mark;                              /*!< Value of `count` at start of current boot */
+    uint32_t boots;                             /*!< Warm boots since ring was cleared */
+    uint32_t rsr;                               /*!< Reset flags of core at start of current boot */
+    uint32_t reserved;
+} ipc_frec_hdr_t;
+
+/* Number of entries of each ring, each ring takes half of recorder */
+#define IPC_FREC_ENTRIES                    ((IPC_FREC_LEN / 2 - sizeof(ipc_frec_hdr_t)) / sizeof(ipc_frec_entry_t))
+
+/* Wrap value of event counter, multiple of ring length to keep entry index continuous */
+#define IPC_FREC_WRAP                       ((uint32_t)((0xFFFFFFFFUL / IPC_FREC_ENTRIES) * IPC_FREC_ENTRIES))
+
+/**
+ * \brief           Event ring of one core, written by its core only
+ */
+typedef struct {
+    ipc_frec_hdr_t hdr;                         /*!< Ring header */
+    ipc_frec_entry_t entry[IPC_FREC_ENTRIES];   /*!< Events, entry of event is `count % IPC_FREC_ENTRIES` */
+} ipc_frec_ring_t;
+
+/* Ring of core */
+#define IPC_FREC_RING(core)                 ((volatile ipc_frec_ring_t *)(IPC_FREC_ADDR + (core) * sizeof(ipc_frec_ring_t)))
+
+/* Target side, not used by host tool */
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include "common.h"
+
+#if IPC_FREC
+
+#if defined(CORE_CM7)
+#define IPC_FREC_CORE                       IPC_FREC_CPU1
+#else
+#define IPC_FREC_CORE                       IPC_FREC_CPU2
+#endif
+
+/* MPU region of recorder, see IPC_FREC_LEN */
+#define IPC_FREC_MPU_SIZE                   MPU_REGION_SIZE_16KB
+
+/**
+ * \brief           Dump output function
+ * \param[in]       str: Text to output
+ * \param[in]       len: Length of text in units of bytes
+ */
+typedef void (*ipc_frec_out_fn)(const char* str, size_t len);
+
+void    ipc_frec_init(void);
+size_t  ipc_frec_dump(uint32_t core, size_t last, ipc_frec_out_fn out_fn);
+
+/**
+ * \brief           Append event to ring of current core.
+ *                  Safe from thread and any interrupt, entry is claimed with exclusive access on counter
+ *
+ * Counter is written by this core only, exclusive access never competes with other core
+ * and no global exclusive monitor is needed. Interrupt between claim and entry write
+ * records its event to next entry, order of entries is order of claims
+ *
+ * \note            \ref ipc_frec_init must be called first
+ * \param[in]       word: Event word, see \ref IPC_FREC_WORD
+ */
+static inline void
+ipc_frec_add(uint32_t word) {
+    volatile ipc_frec_ring_t* ring = IPC_FREC_RING(IPC_FREC_CORE);
+    uint32_t idx, next;
+
+    do {
+        idx = __LDREXW(&ring->hdr.count);
+        next = idx + 1 == IPC_FREC_WRAP ? 0 : idx + 1;
+    } while (__STREXW(next, &ring->hdr.count) != 0);
+    idx %= IPC_FREC_ENTRIES;
+    ring->entry[idx].stamp = CYCCNT_GET();
+    ring->entry[idx].word = word;
+}
+
+#endif /* IPC_FREC */
+
+#endif /* defined(CORE_CM7) || defined(CORE_CM4) */
+
+#endif /* IPC_FREC_HDR_H */
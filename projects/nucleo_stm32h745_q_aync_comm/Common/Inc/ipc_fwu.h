@@ -0,0 +1,117 @@
+/**
+ * \file            ipc_fwu.h
+ * \brief           CPU2 firmware update through shared memory
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_FWU_HDR_H
+#define IPC_FWU_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Header of staging slot and first message of update, `IPC_FWU` in ASCII */
+#define IPC_FWU_MAGIC                       0x55574649UL
+
+/* Flash word, smallest programmable unit, 256 bits */
+#define IPC_FWU_WORD_LEN                    32
+
+/**
+ * \brief           Update state
+ */
+typedef enum {
+    IPC_FWU_STATE_IDLE,                         /*!< No update, set by CPU1 before header is sent */
+    IPC_FWU_STATE_ERASE,                        /*!< CPU2 erases sector of bank 2 */
+    IPC_FWU_STATE_PROGRAM,                      /*!< CPU2 programs flash words of bank 2 */
+    IPC_FWU_STATE_DONE,                         /*!< Whole image programmed, CPU2 waits for reset */
+    IPC_FWU_STATE_ERROR,                        /*!< Flash error, CPU2 waits for reset */
+} ipc_fwu_state_t;
+
+/**
+ * \brief           Update progress, in control part of shared RAM.
+ *                  Cleared by CPU1 before update, written by CPU2 during update
+ */
+typedef struct {
+    uint32_t state;                             /*!< Update state, \ref ipc_fwu_state_t */
+    uint32_t written;                           /*!< Number of image bytes programmed */
+    uint32_t flash_err;                         /*!< Error flags of bank 2 status register */
+    uint32_t erase_us;                          /*!< Time CPU2 waited for sector erase */
+    uint32_t prog_us;                           /*!< Time CPU2 waited for flash word programming */
+    uint32_t stall_us;                          /*!< Time CPU2 waited for image data, flash was idle */
+} ipc_fwu_shared_t;
+
+/**
+ * \brief           Header of staging slot and first message of update
+ */
+typedef struct {
+    uint32_t magic;                             /*!< \ref IPC_FWU_MAGIC */
+    uint32_t len;                               /*!< Image length in units of bytes */
+    uint32_t reserved[6];                       /*!< Image starts on flash word boundary */
+} ipc_fwu_hdr_t;
+
+/**
+ * \brief           Update result of CPU1
+ */
+typedef struct {
+    uint32_t len;                               /*!< Image length in units of bytes */
+    uint32_t total_ms;                          /*!< Time from header to verified image */
+    uint32_t erase_us;                          /*!< CPU2 sector erase time */
+    uint32_t prog_us;                           /*!< CPU2 flash word programming time */
+    uint32_t stall_us;                          /*!< CPU2 time without data */
+    uint32_t chunks;                            /*!< Number of chunks sent */
+    uint32_t copies;                            /*!< Chunks staged locally, reserved memory would wrap */
+    uint32_t flash_err;                         /*!< Error flags of bank 2 status register */
+} ipc_fwu_stats_t;
+
+/**
+ * \brief           Image source callback, writes part of image to channel memory
+ * \param[in]       arg: User argument
+ * \param[in]       off: Offset in image in units of bytes
+ * \param[out]      data: Output memory, reserved in channel
+ * \param[in]       len: Number of bytes to write
+ * \return          `1` on success, `0` otherwise
+ */
+typedef uint8_t (*ipc_fwu_read_fn)(void* arg, size_t off, void* data, size_t len);
+
+/**
+ * \brief           Output function for update report
+ * \param[in]       str: String to output
+ * \param[in]       len: String length
+ */
+typedef void (*ipc_fwu_out_fn)(const char* str, size_t len);
+
+/* CPU1 */
+uint8_t ipc_fwu_update(RINGBUFF_VOLATILE ringbuff_t* tx, size_t len, ipc_fwu_read_fn read_fn, void* arg, ipc_fwu_stats_t* stats);
+uint8_t ipc_fwu_slot_check(size_t* len);
+uint8_t ipc_fwu_slot_read(void* arg, size_t off, void* data, size_t len);
+uint8_t ipc_fwu_slot_update(RINGBUFF_VOLATILE ringbuff_t* tx, ipc_fwu_out_fn out_fn);
+
+/* CPU2 */
+void    ipc_fwu_poll(RINGBUFF_VOLATILE ringbuff_t* rx);
+
+#endif /* IPC_FWU_HDR_H */
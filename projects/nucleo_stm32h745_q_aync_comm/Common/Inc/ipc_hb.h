@@ -0,0 +1,94 @@
+/**
+ * \file            ipc_hb.h
+ * \brief           Peer heartbeat and health monitor
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_HB_HDR_H
+#define IPC_HB_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ipc_rpc.h"
+
+/**
+ * \brief           Peer health, in control part of shared RAM.
+ *                  Written by CPU1 only, readable by both cores and debugger
+ */
+typedef struct {
+    uint32_t alive;                             /*!< `1` while CPU2 answered within window */
+    uint32_t sent;                              /*!< Number of heartbeats sent */
+    uint32_t acked;                             /*!< Number of heartbeats answered */
+    uint32_t lost;                              /*!< Number of heartbeats not answered within window */
+    uint32_t losses;                            /*!< Number of alive to not alive transitions */
+    uint32_t peer_uptime_ms;                    /*!< CPU2 tick of last answer */
+    uint32_t rtt_last_ns;                       /*!< Round trip time of last answer */
+    uint32_t rtt_avg_ns;                        /*!< Moving average round trip time, `1/8` weight of new sample */
+    uint32_t rtt_max_ns;                        /*!< Maximum round trip time */
+} ipc_hb_shared_t;
+
+/**
+ * \brief           Peer health change event
+ */
+typedef enum {
+    IPC_HB_EVT_LOST,                            /*!< No answer within window */
+    IPC_HB_EVT_RECOVERED,                       /*!< Answer came after peer was lost */
+} ipc_hb_evt_t;
+
+/**
+ * \brief           Peer health change callback, runs on CPU1 from \ref ipc_hb_poll or RPC completion
+ * \param[in]       evt: Event type
+ */
+typedef void (*ipc_hb_evt_fn)(ipc_hb_evt_t evt);
+
+/**
+ * \brief           Heartbeat monitor of CPU1, core-local
+ */
+typedef struct {
+    ipc_rpc_client_t* cli;                      /*!< RPC client to CPU2 */
+    uint32_t period_ms;                         /*!< Heartbeat period */
+    uint32_t window_ms;                         /*!< Time without answer after which peer is lost */
+    ipc_hb_evt_fn evt_fn;                       /*!< Health change callback */
+    uint32_t seq;                               /*!< Sequence number of last heartbeat */
+    uint32_t send_time;                         /*!< Tick of last heartbeat */
+    uint32_t ack_time;                          /*!< Tick of last answer */
+    uint32_t start;                             /*!< Cycle counter at last heartbeat */
+    uint8_t in_flight;                          /*!< Set to `1` while heartbeat waits for answer */
+} ipc_hb_t;
+
+/* CPU1 */
+void    ipc_hb_init(ipc_hb_t* hb, ipc_rpc_client_t* cli, uint32_t period_ms, uint32_t window_ms, ipc_hb_evt_fn evt_fn);
+uint8_t ipc_hb_poll(ipc_hb_t* hb, uint32_t now);
+
+/* CPU2 */
+int32_t ipc_hb_rpc_beat(const void* args, size_t len, void* res, size_t* res_len);
+
+/* Any core */
+uint8_t ipc_hb_is_alive(void);
+void    ipc_hb_get_stats(ipc_hb_shared_t* stats);
+
+#endif /* IPC_HB_HDR_H */
@@ -0,0 +1,93 @@
+/**
+ * \file            ipc_heap.h
+ * \brief           Variable-size shared heap
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_HEAP_HDR_H
+#define IPC_HEAP_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ipc_lock.h"
+
+/* Allocation granularity and alignment of returned memory, in units of bytes */
+#define IPC_HEAP_ALIGN                      8
+
+/* Number of second-level lists per first-level size class, log2 */
+#define IPC_HEAP_SL_LOG2                    4
+#define IPC_HEAP_SL_COUNT                   (1 << IPC_HEAP_SL_LOG2)
+
+/* Blocks smaller than this size share first first-level class, lists are linear */
+#define IPC_HEAP_FL_SHIFT                   (IPC_HEAP_SL_LOG2 + 3)
+#define IPC_HEAP_SMALL_LEN                  (1 << IPC_HEAP_FL_SHIFT)
+
+/* Largest block size class, log2, heap up to `64kB` */
+#define IPC_HEAP_FL_MAX                     16
+#define IPC_HEAP_FL_COUNT                   (IPC_HEAP_FL_MAX - IPC_HEAP_FL_SHIFT + 1)
+
+/**
+ * \brief           Heap statistics
+ */
+typedef struct {
+    uint32_t total;                             /*!< Bytes available for blocks, including block headers */
+    uint32_t used;                              /*!< Bytes in allocated blocks, including block headers */
+    uint32_t peak;                              /*!< Maximum of `used` since initialization */
+    uint32_t largest_free;                      /*!< Largest free block, including block header */
+    uint32_t allocs;                            /*!< Number of successful allocations */
+    uint32_t fails;                             /*!< Number of failed allocations */
+    uint32_t frag;                              /*!< Fragmentation in permille, `1000 * (1 - largest_free / free)` */
+    ipc_lock_stats_t lock;                      /*!< Heap lock contention */
+} ipc_heap_stats_t;
+
+/**
+ * \brief           Heap control structure, at start of heap memory.
+ *                  Free lists use offsets from heap start, `0` for empty list
+ */
+typedef struct {
+    ipc_lock_t lock;                            /*!< Lock of both cores, HSEM_HEAP */
+    uint32_t fl_bitmap;                         /*!< First-level classes with non-empty lists */
+    uint32_t sl_bitmap[IPC_HEAP_FL_COUNT];      /*!< Non-empty second-level lists per first-level class */
+    uint32_t free[IPC_HEAP_FL_COUNT][IPC_HEAP_SL_COUNT];    /*!< Free list heads */
+    uint32_t total;                             /*!< Bytes available for blocks */
+    uint32_t used;                              /*!< Bytes in allocated blocks */
+    uint32_t peak;                              /*!< Maximum of `used` */
+    uint32_t allocs;                            /*!< Number of successful allocations */
+    uint32_t fails;                             /*!< Number of failed allocations */
+} ipc_heap_ctrl_t;
+
+/* Owner core, CPU1, before other core is started */
+void        ipc_heap_init(void);
+
+/* Both cores */
+void *      ipc_heap_alloc(size_t len);
+void        ipc_heap_free(void* ptr);
+uint32_t    ipc_heap_ptr_to_off(const void* ptr);
+void *      ipc_heap_off_to_ptr(uint32_t off);
+void        ipc_heap_get_stats(ipc_heap_stats_t* stats);
+
+#endif /* IPC_HEAP_HDR_H */
@@ -0,0 +1,50 @@
+/**
+ * \file            ipc_idle.h
+ * \brief           CPU2 idle with D2 domain stop
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_IDLE_HDR_H
+#define IPC_IDLE_HDR_H
+
+#include <stdint.h>
+
+/**
+ * \brief           Idle statistics of CPU2
+ */
+typedef struct {
+    uint32_t stops;                             /*!< Number of stop mode entries */
+    uint32_t wakes;                             /*!< Number of wake-ups by data written to `CM7_TO_CM4` during stop,
+                                                    measured with `IPC_LAT` timebase */
+    uint32_t wake_avg_ns;                       /*!< Average latency from last stamped write to CPU2 running */
+    uint32_t wake_max_ns;                       /*!< Maximum latency from last stamped write to CPU2 running */
+} ipc_idle_stats_t;
+
+void    ipc_idle_stop(void);
+void    ipc_idle_get_stats(ipc_idle_stats_t* stats);
+
+#endif /* IPC_IDLE_HDR_H */
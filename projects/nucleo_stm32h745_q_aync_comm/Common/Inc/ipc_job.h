@@ -0,0 +1,142 @@
+/**
+ * \file            ipc_job.h
+ * \brief           Job offload from CPU1 to CPU2
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_JOB_HDR_H
+#define IPC_JOB_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Maximum length of job arguments and of result, in units of bytes */
+#define IPC_JOB_MAX_LEN                     64
+
+/**
+ * \brief           Job status, negative values are errors
+ */
+typedef enum {
+    IPC_JOB_OK = 0,                             /*!< Job executed */
+    IPC_JOB_PENDING = 1,                        /*!< Job submitted, completion did not arrive yet */
+    IPC_JOB_ERR_FN = -1,                        /*!< Function ID is not known by worker */
+    IPC_JOB_ERR_ARGS = -2,                      /*!< Invalid arguments */
+} ipc_job_status_t;
+
+/**
+ * \brief           Header in front of every job descriptor and completion message
+ */
+typedef struct {
+    uint32_t tag;                               /*!< Future address on CPU1, echoed in completion */
+    uint32_t start;                             /*!< CPU1 cycle counter at submit, echoed in completion */
+    uint16_t fn;                                /*!< Function ID */
+    int16_t status;                             /*!< Completion status, \ref ipc_job_status_t. `0` in descriptor */
+} ipc_job_hdr_t;
+
+/**
+ * \brief           Job function, runs on CPU2
+ * \param[in]       args: Job arguments, not aligned
+ * \param[in]       len: Length of arguments in units of bytes
+ * \param[out]      res: Memory for result, in completion channel when possible, not aligned
+ * \param[in,out]   res_len: Size of `res` on input, \ref IPC_JOB_MAX_LEN, result length on output
+ * \return          Job status, \ref ipc_job_status_t or function specific value
+ */
+typedef int32_t (*ipc_job_fn)(const void* args, size_t len, void* res, size_t* res_len);
+
+/**
+ * \brief           Function table entry
+ */
+typedef struct {
+    uint16_t fn_id;                             /*!< Function ID */
+    ipc_job_fn fn;                              /*!< Function */
+} ipc_job_entry_t;
+
+/**
+ * \brief           Future of submitted job, owned by CPU1 application until completed
+ */
+typedef struct {
+    volatile int32_t status;                    /*!< \ref IPC_JOB_PENDING until completion, then job status */
+    uint32_t lat;                               /*!< Submit to completion latency, in units of CPU1 cycles */
+    size_t res_len;                             /*!< Result length in units of bytes */
+    uint8_t res[IPC_JOB_MAX_LEN];               /*!< Result */
+} ipc_job_future_t;
+
+/**
+ * \brief           Queue statistics
+ */
+typedef struct {
+    uint32_t submitted;                         /*!< Number of submitted jobs */
+    uint32_t completed;                         /*!< Number of completed jobs */
+    uint32_t depth;                             /*!< Jobs in flight, submitted and not completed */
+    uint32_t max_depth;                         /*!< Maximum number of jobs in flight */
+    uint32_t lat_min;                           /*!< Minimum latency, in units of CPU1 cycles */
+    uint32_t lat_max;                           /*!< Maximum latency, in units of CPU1 cycles */
+    uint32_t lat_avg;                           /*!< Average latency, in units of CPU1 cycles */
+} ipc_job_stats_t;
+
+/**
+ * \brief           Submitting side, on CPU1, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* tx;           /*!< Job channel, producer side */
+    RINGBUFF_VOLATILE ringbuff_t* rx;           /*!< Completion channel, consumer side */
+    uint32_t sem_id;                            /*!< Job channel doorbell */
+    uint32_t batch;                             /*!< Jobs submitted since last doorbell */
+    uint32_t submitted;                         /*!< Number of submitted jobs */
+    uint32_t completed;                         /*!< Number of completed jobs */
+    uint32_t max_depth;                         /*!< Maximum number of jobs in flight */
+    uint32_t lat_min;                           /*!< Minimum latency */
+    uint32_t lat_max;                           /*!< Maximum latency */
+    uint64_t lat_sum;                           /*!< Sum of latencies of completed jobs */
+} ipc_job_queue_t;
+
+/**
+ * \brief           Executing side, on CPU2, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* rx;           /*!< Job channel, consumer side */
+    RINGBUFF_VOLATILE ringbuff_t* tx;           /*!< Completion channel, producer side */
+    uint32_t sem_id;                            /*!< Completion channel doorbell */
+    const ipc_job_entry_t* fns;                 /*!< Function table */
+    size_t count;                               /*!< Number of entries in function table */
+    uint8_t stage[sizeof(ipc_job_hdr_t) + IPC_JOB_MAX_LEN]; /*!< Completion memory when channel cannot reserve linear memory */
+} ipc_job_worker_t;
+
+/* Submitting side, CPU1 */
+uint8_t     ipc_job_queue_init(ipc_job_queue_t* q, RINGBUFF_VOLATILE ringbuff_t* tx, RINGBUFF_VOLATILE ringbuff_t* rx, uint32_t sem_id);
+uint8_t     ipc_job_submit(ipc_job_queue_t* q, uint16_t fn_id, const void* args, size_t len, ipc_job_future_t* future);
+void        ipc_job_flush(ipc_job_queue_t* q);
+size_t      ipc_job_poll(ipc_job_queue_t* q);
+void        ipc_job_get_stats(ipc_job_queue_t* q, ipc_job_stats_t* stats);
+
+/* Executing side, CPU2 */
+uint8_t     ipc_job_worker_init(ipc_job_worker_t* w, RINGBUFF_VOLATILE ringbuff_t* rx, RINGBUFF_VOLATILE ringbuff_t* tx,
+                                uint32_t sem_id, const ipc_job_entry_t* fns, size_t count);
+size_t      ipc_job_worker_poll(ipc_job_worker_t* w);
+
+#endif /* IPC_JOB_HDR_H */
@@ -0,0 +1,74 @@
+/**
+ * \file            ipc_lane.h
+ * \brief           Priority lanes, control and bulk channel per direction
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_LANE_HDR_H
+#define IPC_LANE_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/**
+ * \brief           Lane to be served next by consumer
+ */
+typedef enum {
+    IPC_LANE_NONE,                              /*!< Both lanes are empty */
+    IPC_LANE_CTRL,                              /*!< Control lane, one message */
+    IPC_LANE_BULK,                              /*!< Bulk lane, one block of data */
+} ipc_lane_t;
+
+/**
+ * \brief           Producer side of control lane
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* ctrl;         /*!< Control channel buffer handle, producer side */
+    uint32_t sem_id;                            /*!< Control channel doorbell semaphore */
+} ipc_lane_tx_t;
+
+/**
+ * \brief           Consumer side of control and bulk lane
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* ctrl;         /*!< Control channel buffer handle, messages */
+    RINGBUFF_VOLATILE ringbuff_t* bulk;         /*!< Bulk channel buffer handle, byte stream */
+    uint32_t bulk_every;                        /*!< Number of consecutive control messages after which
+                                                    waiting bulk data are served once, `0` for strict priority */
+    uint32_t ctrl_run;                          /*!< Control messages served in a row while bulk data were waiting */
+} ipc_lane_rx_t;
+
+uint8_t     ipc_lane_tx_init(ipc_lane_tx_t* tx, RINGBUFF_VOLATILE ringbuff_t* ctrl, uint32_t sem_id);
+size_t      ipc_lane_ctrl_send(ipc_lane_tx_t* tx, const void* data, size_t len);
+
+uint8_t     ipc_lane_rx_init(ipc_lane_rx_t* rx, RINGBUFF_VOLATILE ringbuff_t* ctrl, RINGBUFF_VOLATILE ringbuff_t* bulk, uint32_t bulk_every);
+ipc_lane_t  ipc_lane_next(ipc_lane_rx_t* rx);
+size_t      ipc_lane_ctrl_recv(RINGBUFF_VOLATILE ringbuff_t* ctrl, void* data, size_t size);
+size_t      ipc_lane_read(ipc_lane_rx_t* rx, void* data, size_t size, ipc_lane_t* lane);
+
+#endif /* IPC_LANE_HDR_H */
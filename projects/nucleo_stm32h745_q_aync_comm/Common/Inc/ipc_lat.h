@@ -0,0 +1,98 @@
+/**
+ * \file            ipc_lat.h
+ * \brief           Inter-core message latency histogram
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_LAT_HDR_H
+#define IPC_LAT_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Number of stamps in flight per channel, older stamps are overwritten and counted as lost */
+#define IPC_LAT_STAMPS                      16
+
+/*
+ * Log-scale histogram bins, 4 linear sub-bins per power of 2 of timebase ticks.
+ * Values `0-3` have own bins, bin upper bound is at most 25% above its lower bound
+ */
+#define IPC_LAT_BINS                        124
+
+/**
+ * \brief           Latency instrumentation of single channel, in shared RAM control part
+ *
+ * Producer writes stamps, consumer bins latency when it is notified,
+ * each side writes only its own cache line(s)
+ */
+typedef struct {
+    /* Producer owned */
+    uint32_t head __attribute__((aligned(32))); /*!< Number of stamps written */
+    uint32_t stamps[IPC_LAT_STAMPS];            /*!< Timebase value at write, indexed by `head % IPC_LAT_STAMPS` */
+
+    /* Consumer owned */
+    uint32_t count __attribute__((aligned(32)));/*!< Number of binned samples */
+    uint32_t lost;                              /*!< Number of stamps overwritten before consumer was notified */
+    uint32_t max;                               /*!< Maximum latency in units of timebase ticks */
+    uint32_t bins[IPC_LAT_BINS];                /*!< Number of samples per bin */
+} ipc_lat_shared_t;
+
+/**
+ * \brief           Latency summary of channel
+ */
+typedef struct {
+    uint32_t count;                             /*!< Number of samples */
+    uint32_t lost;                              /*!< Number of lost stamps */
+    uint32_t p50_ns;                            /*!< Median latency, upper bound of its bin */
+    uint32_t p99_ns;                            /*!< 99th percentile latency, upper bound of its bin */
+    uint32_t max_ns;                            /*!< Maximum latency */
+} ipc_lat_summary_t;
+
+/**
+ * \brief           Output function for report lines
+ * \param[in]       str: Text to output, not `NULL` terminated
+ * \param[in]       len: Length of text in units of bytes
+ */
+typedef void (*ipc_lat_out_fn)(const char* str, size_t len);
+
+void        ipc_lat_timebase_init(void);
+uint32_t    ipc_lat_now(void);
+void        ipc_lat_reset(void);
+
+/* Producer */
+void        ipc_lat_stamp(uint32_t id);
+
+/* Consumer, called from doorbell interrupt */
+void        ipc_lat_delivered(uint32_t id);
+
+/* Any core */
+uint8_t     ipc_lat_get_summary(uint32_t id, ipc_lat_summary_t* sum);
+uint8_t     ipc_lat_last_stamp(uint32_t id, uint32_t* stamp);
+uint32_t    ipc_lat_to_ns(uint32_t ticks);
+void        ipc_lat_report(ipc_lat_out_fn out_fn);
+
+#endif /* IPC_LAT_HDR_H */
@@ -0,0 +1,64 @@
+/**
+ * \file            ipc_load.h
+ * \brief           Per-core CPU load accounting
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_LOAD_HDR_H
+#define IPC_LOAD_HDR_H
+
+#include <stdint.h>
+
+/**
+ * \brief           Time bucket, cycles of core are charged to active bucket
+ */
+typedef enum {
+    IPC_LOAD_APP,                               /*!< Application work, default bucket */
+    IPC_LOAD_SEND,                              /*!< Writes to channels, blocking writes included */
+    IPC_LOAD_RECV,                              /*!< Reading and draining channels */
+    IPC_LOAD_FWD,                               /*!< Forwarding to peripherals, blocking UART transmit included */
+    IPC_LOAD_IDLE,                              /*!< Sleep and idle checks */
+    IPC_LOAD_COUNT,
+} ipc_load_bucket_t;
+
+/**
+ * \brief           Load of one core over last period, in control part of shared RAM.
+ *                  Written by its core only, readable by both cores and debugger
+ */
+typedef struct {
+    uint32_t seq;                               /*!< Odd while update is in progress, incremented twice per period */
+    uint32_t period_cycles;                     /*!< Core cycles of period, from tick */
+    uint32_t cycles[IPC_LOAD_COUNT];            /*!< Cycles charged to each bucket */
+    uint32_t permille[IPC_LOAD_COUNT];          /*!< Share of each bucket in units of `0.1` percent */
+} ipc_load_shared_t;
+
+void                ipc_load_init(void);
+ipc_load_bucket_t   ipc_load_switch(ipc_load_bucket_t bucket);
+uint8_t             ipc_load_poll(uint32_t now);
+void                ipc_load_get_stats(uint32_t core, ipc_load_shared_t* stats);
+
+#endif /* IPC_LOAD_HDR_H */
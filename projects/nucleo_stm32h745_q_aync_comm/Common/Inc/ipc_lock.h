@@ -0,0 +1,76 @@
+/**
+ * \file            ipc_lock.h
+ * \brief           Cross-core lock over hardware semaphore
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_LOCK_HDR_H
+#define IPC_LOCK_HDR_H
+
+#include <stdint.h>
+
+/* Index of current core in per-core fields, CPU1 or CPU2 */
+#if defined(CORE_CM7)
+#define IPC_LOCK_CORE                       0
+#else
+#define IPC_LOCK_CORE                       1
+#endif
+
+/**
+ * \brief           Cross-core lock, placed in memory shared and non-cacheable by both cores.
+ *                  Counters are updated by lock owner only
+ */
+typedef struct {
+    uint32_t sem_id;                            /*!< Hardware semaphore ID */
+    volatile uint32_t acquisitions;             /*!< Number of successful takes */
+    volatile uint32_t contentions;              /*!< Number of takes that found lock taken */
+    volatile uint32_t sleeps;                   /*!< Number of waits for semaphore free interrupt */
+    volatile uint32_t max_hold[2];              /*!< Maximum hold time of CPU1 and CPU2, in cycles of holder core */
+    uint32_t taken_at;                          /*!< Cycle counter of owner core at take */
+} ipc_lock_t;
+
+/**
+ * \brief           Lock statistics
+ */
+typedef struct {
+    uint32_t acquisitions;                      /*!< Number of successful takes */
+    uint32_t contentions;                       /*!< Number of takes that found lock taken */
+    uint32_t sleeps;                            /*!< Number of waits for semaphore free interrupt */
+    uint32_t max_hold[2];                       /*!< Maximum hold time of CPU1 and CPU2, in cycles of holder core */
+} ipc_lock_stats_t;
+
+/* One core, before other core uses lock */
+void        ipc_lock_init(ipc_lock_t* lock, uint32_t sem_id);
+
+/* Both cores */
+uint8_t     ipc_lock_try(ipc_lock_t* lock, uint32_t* primask);
+uint32_t    ipc_lock_take(ipc_lock_t* lock);
+void        ipc_lock_release(ipc_lock_t* lock, uint32_t primask);
+void        ipc_lock_get_stats(const ipc_lock_t* lock, ipc_lock_stats_t* stats);
+void        ipc_lock_reset_stats(ipc_lock_t* lock);
+
+#endif /* IPC_LOCK_HDR_H */
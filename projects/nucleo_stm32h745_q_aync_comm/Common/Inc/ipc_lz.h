@@ -0,0 +1,105 @@
+/**
+ * \file            ipc_lz.h
+ * \brief           LZ stream codec with bounded window
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_LZ_HDR_H
+#define IPC_LZ_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Frame format, all fields little endian:
+ *
+ * - Byte 0: IPC_LZ_MAGIC
+ * - Byte 1: Flags, IPC_LZ_FLAG_KEY and IPC_LZ_FLAG_RAW
+ * - Bytes 2-3: Payload length in units of bytes
+ * - Bytes 4-5: Decoded length in units of bytes, up to IPC_LZ_FRAME_MAX
+ * - Payload: Raw data with IPC_LZ_FLAG_RAW, tokens otherwise
+ *
+ * Tokens are grouped by 8 behind control byte, bit `n` of control byte set for match token `n`.
+ * Literal token is single byte. Match token is 2 bytes, 11-bit distance minus 1 in bits 10:0
+ * and match length minus IPC_LZ_MIN_MATCH in bits 15:11
+ */
+#define IPC_LZ_MAGIC                        0x5A
+#define IPC_LZ_FLAG_KEY                     0x01    /* Window is reset, decoder synchronizes on this frame */
+#define IPC_LZ_FLAG_RAW                     0x02    /* Payload is stored, it did not compress */
+#define IPC_LZ_HDR_LEN                      6
+
+#define IPC_LZ_WINDOW                       2048    /* Maximum match distance, power of 2 */
+#define IPC_LZ_MIN_MATCH                    3
+#define IPC_LZ_MAX_MATCH                    (IPC_LZ_MIN_MATCH + 31)
+#define IPC_LZ_HASH_BITS                    10
+#define IPC_LZ_FRAME_MAX                    512     /* Maximum decoded length of one frame */
+#define IPC_LZ_OUT_MAX                      (IPC_LZ_HDR_LEN + IPC_LZ_FRAME_MAX) /* Maximum frame length */
+#define IPC_LZ_KEY_INTERVAL                 16      /* Every n-th frame is key frame */
+
+/**
+ * \brief           Encoder state, window and hash table of last positions
+ */
+typedef struct {
+    uint8_t hist[2 * IPC_LZ_WINDOW];            /*!< Encoded history followed by pending input */
+    uint16_t head[1 << IPC_LZ_HASH_BITS];       /*!< Last position of each hash plus 1, `0` when empty */
+    size_t hist_len;                            /*!< Length of encoded history */
+    size_t pending;                             /*!< Length of pending input, behind history */
+    uint32_t frames;                            /*!< Number of frames since last key frame */
+    uint8_t key;                                /*!< Set to `1` when next frame must be key frame */
+    uint32_t bytes_in;                          /*!< Number of encoded input bytes */
+    uint32_t bytes_out;                         /*!< Number of frame bytes produced */
+} ipc_lz_enc_t;
+
+/**
+ * \brief           Decoder state, circular window of decoded data
+ */
+typedef struct {
+    uint8_t win[IPC_LZ_WINDOW];                 /*!< Last decoded bytes */
+    size_t pos;                                 /*!< Number of bytes decoded since key frame */
+    uint8_t sync;                               /*!< Set to `1` after key frame, until error */
+} ipc_lz_dec_t;
+
+void        ipc_lz_enc_init(ipc_lz_enc_t* enc);
+void        ipc_lz_enc_reset(ipc_lz_enc_t* enc);
+size_t      ipc_lz_enc_write(ipc_lz_enc_t* enc, const void* data, size_t len);
+size_t      ipc_lz_enc_flush(ipc_lz_enc_t* enc, uint8_t* out);
+
+/**
+ * \brief           Get length of input waiting for next frame
+ * \param[in]       enc: Encoder handle
+ * \return          Pending length in units of bytes, up to \ref IPC_LZ_FRAME_MAX
+ */
+static inline size_t
+ipc_lz_enc_pending(const ipc_lz_enc_t* enc) {
+    return enc->pending;
+}
+
+void        ipc_lz_dec_init(ipc_lz_dec_t* dec);
+size_t      ipc_lz_frame_len(const uint8_t* hdr);
+int32_t     ipc_lz_dec_frame(ipc_lz_dec_t* dec, const uint8_t* frame, size_t len, uint8_t* out, size_t size);
+
+#endif /* IPC_LZ_HDR_H */
@@ -0,0 +1,52 @@
+/**
+ * \file            ipc_lz_sink.h
+ * \brief           Compressing stage of router sink
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_LZ_SINK_HDR_H
+#define IPC_LZ_SINK_HDR_H
+
+#include <stdint.h>
+#include "ipc_lz.h"
+#include "ipc_route.h"
+#include "ipc_wait.h"
+
+/**
+ * \brief           Compressing stage of sink, core-local
+ */
+typedef struct {
+    ipc_lz_enc_t enc;                           /*!< Encoder, window of sent data */
+    uint8_t frame[IPC_LZ_OUT_MAX];              /*!< Encoded frame before it is queued */
+    uint32_t flush_us;                          /*!< Maximum time input waits for frame to fill */
+    ipc_wait_t flush;                           /*!< Flush timeout of pending frame */
+} ipc_lz_sink_t;
+
+uint8_t     ipc_lz_sink_init(ipc_lz_sink_t* lzs, ipc_sink_t* sink, uint32_t flush_us);
+uint8_t     ipc_lz_sink_poll(ipc_sink_t* sink);
+
+#endif /* IPC_LZ_SINK_HDR_H */
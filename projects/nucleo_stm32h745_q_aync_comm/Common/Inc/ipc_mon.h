@@ -0,0 +1,115 @@
+/**
+ * \file            ipc_mon.h
+ * \brief           Introspection block for host monitoring over SWD
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_MON_HDR_H
+#define IPC_MON_HDR_H
+
+#include <stdint.h>
+
+/*
+ * Introspection block, read by host tool over SWD while both cores run.
+ * Header is in control part of shared RAM at fixed address for all layouts,
+ * it points to descriptor in CPU1 flash. Descriptor gives addresses and field offsets
+ * of channel directory, channel pointers and statistics, so host reads live state
+ * directly from memory and monitoring costs no target cycles.
+ *
+ * Only fixed-width fields, header is included by host tool.
+ * Increase version on any change of header or descriptor
+ */
+
+/* Header and descriptor are valid when magic has this value */
+#define IPC_MON_MAGIC                       0x4E4F4D49
+#define IPC_MON_VERSION                     1
+
+/* Header address, control part of shared RAM right after boot record */
+#define IPC_MON_ADDR                        0x38000020
+
+/* Field offset of feature not enabled in target build */
+#define IPC_MON_NONE                        0xFFFFFFFF
+
+/* Length of channel name, including terminating `NULL` */
+#define IPC_MON_NAME_LEN                    24
+
+/* Maximum number of channels in descriptor */
+#define IPC_MON_CHAN_MAX                    16
+
+/* Core index of build ID */
+#define IPC_MON_CPU1                        0
+#define IPC_MON_CPU2                        1
+
+/**
+ * \brief           Introspection header, at \ref IPC_MON_ADDR.
+ *                  Written once at boot, build ID of CPU2 by CPU2 after it attached
+ */
+typedef struct {
+    uint32_t magic;                             /*!< \ref IPC_MON_MAGIC, written last */
+    uint32_t version;                           /*!< \ref IPC_MON_VERSION */
+    uint32_t desc_addr;                         /*!< Address of \ref ipc_mon_desc_t */
+    uint32_t build_id[2];                       /*!< Build ID of CPU1 and CPU2 image, `0` before CPU2 attached */
+    uint32_t layout_hash;                       /*!< Shared RAM layout hash of CPU1 image */
+} ipc_mon_hdr_t;
+
+/**
+ * \brief           Descriptor, constant in CPU1 flash
+ */
+typedef struct {
+    uint32_t magic;                             /*!< \ref IPC_MON_MAGIC */
+    uint32_t version;                           /*!< \ref IPC_MON_VERSION */
+    uint32_t len;                               /*!< Descriptor length in units of bytes */
+    uint32_t pow2;                              /*!< `1` when pointers are free-running, capacity is full length */
+
+    /* Channel directory, entry starts with shared pointers address, data address and data length */
+    uint32_t dir_addr;                          /*!< Address of channel directory */
+    uint32_t dir_entries_off;                   /*!< Offset of first entry in directory */
+    uint32_t dir_entry_len;                     /*!< Length of entry */
+    uint32_t chan_count;                        /*!< Number of channels in channel table */
+
+    /* Offsets of fields in channel pointers structure, \ref IPC_MON_NONE without statistics */
+    uint32_t shared_len;                        /*!< Length of pointers structure */
+    uint32_t off_w;                             /*!< Write pointer */
+    uint32_t off_r;                             /*!< Read pointer */
+    uint32_t off_bytes_in;                      /*!< Number of bytes written */
+    uint32_t off_writes;                        /*!< Number of write operations */
+    uint32_t off_short_writes;                  /*!< Number of shortened or refused writes */
+    uint32_t off_max_full;                      /*!< Maximum fill level seen by producer */
+    uint32_t off_bytes_out;                     /*!< Number of bytes read */
+    uint32_t off_reads;                         /*!< Number of read operations */
+
+    /* Peer health, 9 words: alive, sent, acked, lost, losses, peer uptime ms, RTT last, average and maximum ns */
+    uint32_t hb_addr;                           /*!< Address of heartbeat statistics, `0` without heartbeat */
+
+    char names[IPC_MON_CHAN_MAX][IPC_MON_NAME_LEN]; /*!< Channel names, indexed by channel ID */
+} ipc_mon_desc_t;
+
+/* Target side, not used by host tool */
+void    ipc_mon_init(void);
+void    ipc_mon_attach(void);
+
+#endif /* IPC_MON_HDR_H */
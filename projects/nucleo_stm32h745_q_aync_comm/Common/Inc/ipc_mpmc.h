@@ -0,0 +1,72 @@
+/**
+ * \file            ipc_mpmc.h
+ * \brief           Multi-producer multi-consumer ring of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_MPMC_HDR_H
+#define IPC_MPMC_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ipc_lock.h"
+
+/* Maximum number of slots per MPMC ring */
+#define IPC_MPMC_MAX_SLOTS                  16
+
+/**
+ * \brief           MPMC ring state in shared RAM control part
+ */
+typedef struct {
+    ipc_lock_t lock;                            /*!< Claims of both positions, HSEM_MPMC_LOCK(id) */
+    uint32_t enq_pos;                           /*!< Free-running position of next push */
+    uint32_t deq_pos;                           /*!< Free-running position of next pop */
+    uint32_t full;                              /*!< Number of pushes to full ring */
+    uint32_t popped[2];                         /*!< Number of items popped by CPU1 and CPU2 */
+    volatile uint32_t seq[IPC_MPMC_MAX_SLOTS];  /*!< Sequence number per slot */
+} ipc_mpmc_shared_t;
+
+/**
+ * \brief           Handle of MPMC ring, core-local, any number per core
+ */
+typedef struct {
+    ipc_mpmc_shared_t* shared;                  /*!< Ring state */
+    uint8_t* data;                              /*!< Data of first slot, slots follow each other */
+    uint32_t slot_len;                          /*!< Slot length in units of bytes */
+    uint32_t slots;                             /*!< Number of slots */
+    uint32_t sem_id;                            /*!< Doorbell rung for each push, \ref HSEM_MPMC */
+} ipc_mpmc_t;
+
+/* Owner core, CPU1, before other core is started */
+void        ipc_mpmc_reset(void);
+
+/* Both cores */
+uint8_t     ipc_mpmc_init(ipc_mpmc_t* q, uint32_t id);
+uint8_t     ipc_mpmc_push(ipc_mpmc_t* q, const void* item, size_t len);
+uint8_t     ipc_mpmc_pop(ipc_mpmc_t* q, void* item);
+
+#endif /* IPC_MPMC_HDR_H */
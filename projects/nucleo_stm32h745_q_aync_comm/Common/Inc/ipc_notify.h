@@ -0,0 +1,72 @@
+/**
+ * \file            ipc_notify.h
+ * \brief           Inter-core doorbell notification
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_NOTIFY_HDR_H
+#define IPC_NOTIFY_HDR_H
+
+#include <stdint.h>
+#include "ringbuff/ringbuff.h"
+
+/* Number of hardware semaphores */
+#define IPC_NOTIFY_SEM_COUNT                32
+
+/**
+ * \brief           Notification callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID that was signaled
+ * \param[in]       arg: User argument
+ */
+typedef void (*ipc_notify_fn)(uint32_t sem_id, void* arg);
+
+/**
+ * \brief           Doorbell coalescing policy of single pipe, placed in producer core memory
+ *
+ * Doorbell is rung when any enabled threshold is reached,
+ * thresholds set to `0` are disabled. With all thresholds disabled,
+ * doorbell is rung after every write
+ */
+typedef struct {
+    uint32_t sem_id;                            /*!< Pipe semaphore ID */
+    size_t level;                               /*!< Ring when fill level reaches `level` bytes */
+    uint32_t count;                             /*!< Ring when `count` writes are not signaled */
+    uint32_t timeout_us;                        /*!< Ring when first not signaled write is older than `timeout_us` */
+    uint32_t pending;                           /*!< Number of writes not signaled yet */
+    uint32_t first_time;                        /*!< Cycle counter at first not signaled write */
+} ipc_notify_coalesce_t;
+
+uint8_t     ipc_notify_listen(uint32_t sem_id, ipc_notify_fn fn, void* arg);
+void        ipc_notify_unlisten(uint32_t sem_id);
+void        ipc_notify(uint32_t sem_id);
+
+uint8_t     ipc_notify_coalesce_init(ipc_notify_coalesce_t* c, RINGBUFF_VOLATILE ringbuff_t* rb, uint32_t sem_id,
+                                        size_t level, uint32_t count, uint32_t timeout_us);
+void        ipc_notify_coalesce_poll(ipc_notify_coalesce_t* c);
+void        ipc_notify_coalesce_flush(ipc_notify_coalesce_t* c);
+
+#endif /* IPC_NOTIFY_HDR_H */
@@ -0,0 +1,47 @@
+/**
+ * \file            ipc_peer.h
+ * \brief           CPU2 reset and channel resynchronization
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_PEER_HDR_H
+#define IPC_PEER_HDR_H
+
+#include <stdint.h>
+
+/**
+ * \brief           Data of CPU1 not yet read by CPU2 at reset
+ */
+typedef enum {
+    IPC_PEER_KEEP,                              /*!< Restarted CPU2 continues to read where it stopped */
+    IPC_PEER_DISCARD,                           /*!< Channels to CPU2 are emptied */
+} ipc_peer_data_t;
+
+/* CPU1 */
+uint8_t ipc_peer_reset(ipc_peer_data_t data, uint32_t timeout_us);
+
+#endif /* IPC_PEER_HDR_H */
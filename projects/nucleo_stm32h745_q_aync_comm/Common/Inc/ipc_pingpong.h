@@ -0,0 +1,77 @@
+/**
+ * \file            ipc_pingpong.h
+ * \brief           Ping-pong block channel
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_PINGPONG_HDR_H
+#define IPC_PINGPONG_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Maximum number of blocks per ping-pong channel */
+#define IPC_PP_MAX_BLOCKS                   8
+
+/* Owner of block, value of block ownership flag */
+#define IPC_PP_OWNER_PRODUCER               0
+#define IPC_PP_OWNER_CONSUMER               1
+
+/**
+ * \brief           Ping-pong channel state in shared RAM control part
+ */
+typedef struct {
+    uint32_t owner[IPC_PP_MAX_BLOCKS] __attribute__((aligned(32))); /*!< Ownership flag per block */
+} ipc_pp_shared_t;
+
+/**
+ * \brief           Producer or consumer side of ping-pong channel, core-local
+ */
+typedef struct {
+    volatile ipc_pp_shared_t* shared;           /*!< Channel state */
+    uint8_t* data;                              /*!< Data of first block, blocks follow each other */
+    uint32_t block_len;                         /*!< Block length in units of bytes */
+    uint32_t blocks;                            /*!< Number of blocks */
+    uint32_t idx;                               /*!< Index of next block of this side */
+    uint32_t sem_id;                            /*!< Doorbell rung for each committed block */
+} ipc_pp_t;
+
+/* Owner core, CPU1, before other core is started */
+void        ipc_pp_reset(void);
+
+/* Both sides */
+uint8_t     ipc_pp_init(ipc_pp_t* pp, uint32_t id);
+
+/* Producer */
+void *      ipc_pp_tx_acquire(ipc_pp_t* pp);
+uint8_t     ipc_pp_tx_commit(ipc_pp_t* pp);
+
+/* Consumer */
+void *      ipc_pp_rx_acquire(ipc_pp_t* pp);
+uint8_t     ipc_pp_rx_release(ipc_pp_t* pp);
+
+#endif /* IPC_PINGPONG_HDR_H */
@@ -0,0 +1,98 @@
+/**
+ * \file            ipc_pool.h
+ * \brief           Buffer pool with descriptor passing
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_POOL_HDR_H
+#define IPC_POOL_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Block header length, block data follow header */
+#define IPC_POOL_HDR_LEN                    0x00000020
+
+/* Data length of block, in units of bytes */
+#define IPC_POOL_DATA_LEN                   (IPC_POOL_BLOCK_LEN - IPC_POOL_HDR_LEN)
+
+/**
+ * \brief           Block header, in front of block data
+ *
+ * Reference count is split per core, each core modifies only its own counter
+ * with LDREX/STREX and both cores can read both counters.
+ * While block is at CPU1, CPU2 counter holds one reference for CPU1
+ */
+typedef struct {
+    uint32_t refs[2];                           /*!< References held by CPU1 and CPU2 */
+} ipc_pool_hdr_t;
+
+/**
+ * \brief           Block descriptor, sent as message instead of block data
+ */
+typedef struct {
+    uint32_t off;                               /*!< Block offset from start of pool */
+    uint32_t len;                               /*!< Number of valid bytes in block */
+} ipc_pool_desc_t;
+
+/**
+ * \brief           Allocating side of pool, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* desc;         /*!< Descriptor channel, producer side */
+    RINGBUFF_VOLATILE ringbuff_t* ret;          /*!< Return channel, consumer side */
+    uint32_t sem_id;                            /*!< Descriptor channel doorbell */
+    volatile uint32_t free;                     /*!< Bit mask of free blocks */
+    volatile uint32_t remote;                   /*!< Bit mask of blocks at receiving side */
+} ipc_pool_tx_t;
+
+/**
+ * \brief           Receiving side of pool, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* desc;         /*!< Descriptor channel, consumer side */
+    RINGBUFF_VOLATILE ringbuff_t* ret;          /*!< Return channel, producer side */
+    uint32_t sem_id;                            /*!< Return channel doorbell */
+} ipc_pool_rx_t;
+
+/* Allocating side */
+uint8_t     ipc_pool_tx_init(ipc_pool_tx_t* tx, RINGBUFF_VOLATILE ringbuff_t* desc, RINGBUFF_VOLATILE ringbuff_t* ret, uint32_t sem_id);
+void *      ipc_pool_alloc(ipc_pool_tx_t* tx);
+void        ipc_pool_put(ipc_pool_tx_t* tx, void* block);
+uint8_t     ipc_pool_send(ipc_pool_tx_t* tx, void* block, size_t len);
+
+/* Receiving side */
+uint8_t     ipc_pool_rx_init(ipc_pool_rx_t* rx, RINGBUFF_VOLATILE ringbuff_t* desc, RINGBUFF_VOLATILE ringbuff_t* ret, uint32_t sem_id);
+void *      ipc_pool_recv(ipc_pool_rx_t* rx, size_t* len);
+uint8_t     ipc_pool_release(ipc_pool_rx_t* rx, void* block);
+
+/* Both sides */
+uint8_t     ipc_pool_retain(void* block);
+uint32_t    ipc_pool_get_refs(const void* block, uint32_t core);
+
+#endif /* IPC_POOL_HDR_H */
@@ -0,0 +1,101 @@
+/**
+ * \file            ipc_pubsub.h
+ * \brief           Topic publish/subscribe between cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_PUBSUB_HDR_H
+#define IPC_PUBSUB_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Number of subscribers per topic */
+#define IPC_TOPIC_SUBS                      4
+
+/**
+ * \brief           Slow subscriber policy of topic
+ */
+typedef enum {
+    IPC_TOPIC_GATE,                             /*!< Publish fails until slowest subscriber read enough data */
+    IPC_TOPIC_DROP,                             /*!< Subscriber that blocks publish is evicted and skips to newest data */
+} ipc_topic_policy_t;
+
+/**
+ * \brief           Subscriber state in shared RAM, written by subscriber only
+ */
+typedef struct {
+    uint32_t r __attribute__((aligned(32)));    /*!< Read index, free-running */
+    uint32_t ack;                               /*!< Last eviction count seen by subscriber */
+    uint32_t active;                            /*!< Set to `1` while subscribed */
+} ipc_topic_sub_shared_t;
+
+/**
+ * \brief           Topic state in shared RAM control part
+ */
+typedef struct {
+    uint32_t w __attribute__((aligned(32)));    /*!< Write index, free-running, written by publisher only */
+    uint32_t evict[IPC_TOPIC_SUBS];             /*!< Eviction count per subscriber, written by publisher only */
+    ipc_topic_sub_shared_t sub[IPC_TOPIC_SUBS]; /*!< Subscribers, each in its own cache line */
+} ipc_topic_shared_t;
+
+/**
+ * \brief           Publisher, core-local
+ */
+typedef struct {
+    volatile ipc_topic_shared_t* shared;        /*!< Topic state */
+    uint8_t* data;                              /*!< Topic data */
+    uint32_t size;                              /*!< Topic data length, power of 2 */
+    uint32_t sem_id;                            /*!< Topic doorbell */
+    ipc_topic_policy_t policy;                  /*!< Slow subscriber policy */
+} ipc_topic_pub_t;
+
+/**
+ * \brief           Subscriber, core-local
+ */
+typedef struct {
+    volatile ipc_topic_shared_t* shared;        /*!< Topic state */
+    const uint8_t* data;                        /*!< Topic data */
+    uint32_t size;                              /*!< Topic data length, power of 2 */
+    uint32_t idx;                               /*!< Subscriber index */
+    uint32_t lost;                              /*!< Number of evictions, each skipped unread data */
+} ipc_topic_sub_t;
+
+/* Owner core, CPU1, before other core is started */
+void        ipc_topic_reset(void);
+
+/* Publisher */
+uint8_t     ipc_topic_pub_init(ipc_topic_pub_t* pub, uint32_t id, ipc_topic_policy_t policy);
+uint8_t     ipc_topic_publish(ipc_topic_pub_t* pub, const void* data, size_t len);
+
+/* Subscriber */
+uint8_t     ipc_topic_subscribe(ipc_topic_sub_t* sub, uint32_t id, uint32_t idx);
+void        ipc_topic_unsubscribe(ipc_topic_sub_t* sub);
+size_t      ipc_topic_read(ipc_topic_sub_t* sub, void* data, size_t size);
+uint32_t    ipc_topic_get_lost(const ipc_topic_sub_t* sub);
+
+#endif /* IPC_PUBSUB_HDR_H */
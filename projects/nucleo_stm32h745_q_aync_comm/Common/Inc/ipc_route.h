@@ -0,0 +1,110 @@
+/**
+ * \file            ipc_route.h
+ * \brief           Output router, channels to sinks
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_ROUTE_HDR_H
+#define IPC_ROUTE_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Maximum number of sinks and sources of one router */
+#define IPC_ROUTE_SINK_MAX                  4
+#define IPC_ROUTE_SRC_MAX                   8
+
+/**
+ * \brief           Sink queue policy when queue has not enough free memory
+ */
+typedef enum {
+    IPC_SINK_DROP,                              /*!< New data are dropped, for sinks drained by hardware */
+    IPC_SINK_OVERWRITE,                         /*!< Oldest data are discarded, for in-RAM trace buffers */
+} ipc_sink_policy_t;
+
+struct ipc_sink;
+
+/**
+ * \brief           Start draining sink queue, called from \ref ipc_router_poll after data were queued.
+ *                  Must not wait, for example starts DMA transfer from queue memory
+ * \param[in]       sink: Sink handle
+ */
+typedef void (*ipc_sink_kick_fn)(struct ipc_sink* sink);
+
+/**
+ * \brief           Queue data through encoding stage of sink, called from \ref ipc_router_poll.
+ *                  Stage counts accepted and dropped bytes of sink
+ * \param[in]       sink: Sink handle
+ * \param[in]       id: Channel ID of source, see \ref ipc_router_add_src
+ * \param[in]       data: Data to queue
+ * \param[in]       len: Data length in units of bytes
+ * \return          `1` if data were written to queue and sink must be kicked, `0` otherwise
+ */
+typedef uint8_t (*ipc_sink_put_fn)(struct ipc_sink* sink, uint32_t id, const uint8_t* data, size_t len);
+
+/**
+ * \brief           Output sink with its own queue, core-local
+ */
+typedef struct ipc_sink {
+    RINGBUFF_VOLATILE ringbuff_t* queue;        /*!< Sink queue, `NULL` discards data */
+    ipc_sink_policy_t policy;                   /*!< Policy on full queue */
+    ipc_sink_kick_fn kick_fn;                   /*!< Drain start callback. Can be set to `NULL` */
+    void* arg;                                  /*!< User argument */
+    ipc_sink_put_fn put_fn;                     /*!< Encoding stage, `NULL` copies data to queue */
+    void* stage;                                /*!< Encoding stage state */
+    uint32_t bytes;                             /*!< Number of bytes accepted */
+    uint32_t drops;                             /*!< Number of bytes dropped or overwritten */
+} ipc_sink_t;
+
+/**
+ * \brief           Router source, channel and mask of its sinks
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Channel handle, consumer side */
+    uint32_t id;                                /*!< Channel ID, passed to encoding stages */
+    uint32_t sinks;                             /*!< Mask of sinks, see \ref ipc_router_add_sink */
+} ipc_route_src_t;
+
+/**
+ * \brief           Output router, copies data of source channels to queues of their sinks
+ */
+typedef struct {
+    ipc_sink_t* sinks[IPC_ROUTE_SINK_MAX];      /*!< Sinks, indexed by sink bit */
+    size_t sink_count;                          /*!< Number of sinks */
+    ipc_route_src_t src[IPC_ROUTE_SRC_MAX];     /*!< Sources */
+    size_t src_count;                           /*!< Number of sources */
+} ipc_router_t;
+
+uint8_t     ipc_sink_init(ipc_sink_t* sink, RINGBUFF_VOLATILE ringbuff_t* queue, ipc_sink_policy_t policy, ipc_sink_kick_fn kick_fn, void* arg);
+
+void        ipc_router_init(ipc_router_t* r);
+uint32_t    ipc_router_add_sink(ipc_router_t* r, ipc_sink_t* sink);
+uint8_t     ipc_router_add_src(ipc_router_t* r, uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb, uint32_t sinks);
+size_t      ipc_router_poll(ipc_router_t* r);
+
+#endif /* IPC_ROUTE_HDR_H */
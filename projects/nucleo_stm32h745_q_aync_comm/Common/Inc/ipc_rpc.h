@@ -0,0 +1,142 @@
+/**
+ * \file            ipc_rpc.h
+ * \brief           Request and response calls over control lanes
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_RPC_HDR_H
+#define IPC_RPC_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Maximum length of call arguments and of result, in units of bytes */
+#define IPC_RPC_MAX_LEN                     64
+
+/* Number of calls in flight per client, sync and async together */
+#define IPC_RPC_PENDING                     4
+
+/**
+ * \brief           Call status, negative values are errors
+ */
+typedef enum {
+    IPC_RPC_OK = 0,                             /*!< Method executed */
+    IPC_RPC_ERR_METHOD = -1,                    /*!< Method ID is not known by server */
+    IPC_RPC_ERR_ARGS = -2,                      /*!< Invalid arguments */
+    IPC_RPC_ERR_TIMEOUT = -3,                   /*!< No response within timeout */
+    IPC_RPC_ERR_BUSY = -4,                      /*!< No free call slot or request channel is full */
+} ipc_rpc_status_t;
+
+/**
+ * \brief           Header in front of every request and response message
+ */
+typedef struct {
+    uint32_t corr;                              /*!< Correlation ID, set by client and echoed in response */
+    uint16_t method;                            /*!< Method ID */
+    int16_t status;                             /*!< Response status, \ref ipc_rpc_status_t. `0` in request */
+} ipc_rpc_hdr_t;
+
+/**
+ * \brief           Method handler, runs on server core
+ * \param[in]       args: Call arguments, not aligned
+ * \param[in]       len: Length of arguments in units of bytes
+ * \param[out]      res: Memory for result, in response channel when possible, not aligned
+ * \param[in,out]   res_len: Size of `res` on input, \ref IPC_RPC_MAX_LEN, result length on output
+ * \return          Call status, \ref ipc_rpc_status_t or method specific value
+ */
+typedef int32_t (*ipc_rpc_method_fn)(const void* args, size_t len, void* res, size_t* res_len);
+
+/**
+ * \brief           Call completion callback, runs on client core from \ref ipc_rpc_client_poll
+ * \param[in]       status: Call status
+ * \param[in]       res: Result, valid only during callback, `NULL` on timeout
+ * \param[in]       len: Result length in units of bytes
+ * \param[in]       arg: User argument of call
+ */
+typedef void (*ipc_rpc_done_fn)(int32_t status, const void* res, size_t len, void* arg);
+
+/**
+ * \brief           Method table entry
+ */
+typedef struct {
+    uint16_t method;                            /*!< Method ID */
+    ipc_rpc_method_fn fn;                       /*!< Handler */
+} ipc_rpc_method_t;
+
+/**
+ * \brief           Server, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* tx;           /*!< Response channel, producer side */
+    uint32_t sem_id;                            /*!< Response channel doorbell */
+    const ipc_rpc_method_t* methods;            /*!< Method table */
+    size_t count;                               /*!< Number of entries in method table */
+    uint8_t stage[sizeof(ipc_rpc_hdr_t) + IPC_RPC_MAX_LEN]; /*!< Response memory when channel cannot reserve linear memory */
+} ipc_rpc_server_t;
+
+/**
+ * \brief           Call in flight
+ */
+typedef struct {
+    uint32_t corr;                              /*!< Correlation ID, `0` for free slot */
+    ipc_rpc_done_fn fn;                         /*!< Completion callback */
+    void* arg;                                  /*!< User argument of callback */
+    uint32_t start;                             /*!< Cycle counter at request */
+    uint32_t timeout;                           /*!< Timeout in units of core cycles */
+} ipc_rpc_call_t;
+
+/**
+ * \brief           Client, core-local
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* tx;           /*!< Request channel, producer side */
+    RINGBUFF_VOLATILE ringbuff_t* rx;           /*!< Response channel, consumer side */
+    uint32_t sem_id;                            /*!< Request channel doorbell */
+    uint32_t next_corr;                         /*!< Next correlation ID */
+    ipc_rpc_call_t calls[IPC_RPC_PENDING];      /*!< Calls in flight */
+    uint8_t* req;                               /*!< Reserved request message, header first, `NULL` when none */
+    size_t req_len;                             /*!< Reserved length of request arguments */
+    uint8_t staged;                             /*!< Set to `1` when reserved request is in `stage` memory */
+    uint8_t stage[sizeof(ipc_rpc_hdr_t) + IPC_RPC_MAX_LEN]; /*!< Request memory when channel cannot reserve linear memory */
+} ipc_rpc_client_t;
+
+/* Server */
+uint8_t     ipc_rpc_server_init(ipc_rpc_server_t* srv, RINGBUFF_VOLATILE ringbuff_t* tx, uint32_t sem_id,
+                                const ipc_rpc_method_t* methods, size_t count);
+uint8_t     ipc_rpc_serve(ipc_rpc_server_t* srv, const void* msg, size_t len);
+
+/* Client */
+uint8_t     ipc_rpc_client_init(ipc_rpc_client_t* cli, RINGBUFF_VOLATILE ringbuff_t* tx, RINGBUFF_VOLATILE ringbuff_t* rx, uint32_t sem_id);
+void *      ipc_rpc_call_reserve(ipc_rpc_client_t* cli, uint16_t method, size_t len);
+uint32_t    ipc_rpc_call_commit(ipc_rpc_client_t* cli, size_t len, uint32_t timeout_us, ipc_rpc_done_fn fn, void* arg);
+int32_t     ipc_rpc_call(ipc_rpc_client_t* cli, uint16_t method, const void* args, size_t len,
+                            void* res, size_t size, size_t* res_len, uint32_t timeout_us);
+void        ipc_rpc_client_input(ipc_rpc_client_t* cli, const void* msg, size_t len);
+void        ipc_rpc_client_poll(ipc_rpc_client_t* cli);
+
+#endif /* IPC_RPC_HDR_H */
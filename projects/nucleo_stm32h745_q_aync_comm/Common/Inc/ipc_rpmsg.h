@@ -0,0 +1,243 @@
+/**
+ * \file            ipc_rpmsg.h
+ * \brief           RPMsg endpoint API on channels
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_RPMSG_HDR_H
+#define IPC_RPMSG_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/*
+ * Subset of OpenAMP `rpmsg.h` API, same names, types and return codes,
+ * so that endpoint code written for OpenAMP builds against this header.
+ * Transport is pair of message channels instead of virtio rings, see ipc_rpmsg.c
+ */
+
+/* Return codes */
+#define RPMSG_SUCCESS                       0
+#define RPMSG_ERROR_BASE                    -2000
+#define RPMSG_ERR_NO_MEM                    (RPMSG_ERROR_BASE - 1)
+#define RPMSG_ERR_NO_BUFF                   (RPMSG_ERROR_BASE - 2)
+#define RPMSG_ERR_PARAM                     (RPMSG_ERROR_BASE - 3)
+#define RPMSG_ERR_DEV_STATE                 (RPMSG_ERROR_BASE - 4)
+#define RPMSG_ERR_BUFF_SIZE                 (RPMSG_ERROR_BASE - 5)
+#define RPMSG_ERR_INIT                      (RPMSG_ERROR_BASE - 6)
+#define RPMSG_ERR_ADDR                      (RPMSG_ERROR_BASE - 7)
+
+/* Addresses, dynamic addresses start after reserved range */
+#define RPMSG_ADDR_ANY                      0xFFFFFFFFUL
+#define RPMSG_RESERVED_ADDRESSES            1024
+#define RPMSG_NS_EPT_ADDR                   0x35
+
+/* Endpoint name length, including `NULL` termination */
+#define RPMSG_NAME_SIZE                     32
+
+/* Maximum payload of one message, as with OpenAMP default of `512` byte buffers */
+#define RPMSG_BUFFER_PAYLOAD                (512 - 16)
+
+struct rpmsg_device;
+struct rpmsg_endpoint;
+
+/**
+ * \brief           Endpoint receive callback
+ * \param[in]       ept: Endpoint that received message
+ * \param[in]       data: Payload, in channel memory unless message wrapped at end of channel.
+ *                      Valid until callback returns, or until \ref rpmsg_release_rx_buffer when held
+ * \param[in]       len: Payload length in units of bytes
+ * \param[in]       src: Address of sending endpoint
+ * \param[in]       priv: Endpoint private data
+ * \return          \ref RPMSG_SUCCESS
+ */
+typedef int (*rpmsg_ept_cb)(struct rpmsg_endpoint* ept, void* data, size_t len, uint32_t src, void* priv);
+
+/**
+ * \brief           Remote endpoint was destroyed
+ * \param[in]       ept: Local endpoint bound to it
+ */
+typedef void (*rpmsg_ns_unbind_cb)(struct rpmsg_endpoint* ept);
+
+/**
+ * \brief           Remote endpoint was announced and no local endpoint has its name
+ * \param[in]       rdev: Device
+ * \param[in]       name: Name of remote endpoint
+ * \param[in]       dest: Address of remote endpoint
+ */
+typedef void (*rpmsg_ns_bind_cb)(struct rpmsg_device* rdev, const char* name, uint32_t dest);
+
+/**
+ * \brief           Endpoint, core-local, owned by application
+ */
+struct rpmsg_endpoint {
+    char name[RPMSG_NAME_SIZE];                 /*!< Name announced to other core, empty when not announced */
+    struct rpmsg_device* rdev;                  /*!< Device, `NULL` when endpoint is not created */
+    uint32_t addr;                              /*!< Local address */
+    uint32_t dest_addr;                         /*!< Remote address, \ref RPMSG_ADDR_ANY until bound */
+    rpmsg_ept_cb cb;                            /*!< Receive callback */
+    rpmsg_ns_unbind_cb ns_unbind_cb;            /*!< Remote endpoint destroyed callback */
+    void* priv;                                 /*!< Private data of application */
+    struct rpmsg_endpoint* next;                /*!< Next endpoint of device */
+};
+
+/**
+ * \brief           Device statistics
+ */
+typedef struct {
+    uint32_t sent;                              /*!< Messages sent */
+    uint32_t received;                          /*!< Messages delivered to endpoints */
+    uint32_t dropped;                           /*!< Messages without destination endpoint */
+    uint32_t tx_copies;                         /*!< Messages staged in core-local memory before send */
+    uint32_t rx_copies;                         /*!< Messages staged in core-local memory before delivery */
+} ipc_rpmsg_stats_t;
+
+/**
+ * \brief           Device, one per core, on pair of channels. Core-local
+ */
+struct rpmsg_device {
+    RINGBUFF_VOLATILE ringbuff_t* tx;           /*!< Channel to other core, producer side */
+    RINGBUFF_VOLATILE ringbuff_t* rx;           /*!< Channel from other core, consumer side */
+    uint32_t sem_id;                            /*!< Doorbell of channel to other core */
+    struct rpmsg_endpoint* epts;                /*!< Created endpoints */
+    uint32_t next_addr;                         /*!< Next dynamic address */
+    rpmsg_ns_bind_cb ns_bind_cb;                /*!< Announcement without local endpoint callback */
+    uint8_t* tx_buf;                            /*!< Payload buffer taken for zero-copy send, `NULL` if none */
+    uint8_t rx_held;                            /*!< Message at read pointer is held by application */
+    ipc_rpmsg_stats_t stats;                    /*!< Statistics */
+    uint32_t tx_stage[(8 + RPMSG_BUFFER_PAYLOAD + 3) / 4];  /*!< Message when channel cannot reserve linear memory */
+    uint32_t rx_stage[(8 + RPMSG_BUFFER_PAYLOAD + 3) / 4];  /*!< Message that wrapped at end of channel */
+};
+
+/* Device, both cores */
+uint8_t     ipc_rpmsg_init(struct rpmsg_device* rdev, RINGBUFF_VOLATILE ringbuff_t* tx, RINGBUFF_VOLATILE ringbuff_t* rx,
+                            uint32_t sem_id, rpmsg_ns_bind_cb ns_bind_cb);
+size_t      ipc_rpmsg_poll(struct rpmsg_device* rdev);
+void        ipc_rpmsg_get_stats(struct rpmsg_device* rdev, ipc_rpmsg_stats_t* stats);
+
+/* OpenAMP endpoint API */
+int         rpmsg_create_ept(struct rpmsg_endpoint* ept, struct rpmsg_device* rdev, const char* name,
+                                uint32_t src, uint32_t dest, rpmsg_ept_cb cb, rpmsg_ns_unbind_cb ns_unbind_cb);
+void        rpmsg_destroy_ept(struct rpmsg_endpoint* ept);
+int         rpmsg_send_offchannel_raw(struct rpmsg_endpoint* ept, uint32_t src, uint32_t dst,
+                                        const void* data, int len, int wait);
+int         rpmsg_get_tx_buffer_size(struct rpmsg_endpoint* ept);
+void *      rpmsg_get_tx_payload_buffer(struct rpmsg_endpoint* ept, uint32_t* len, int wait);
+int         rpmsg_send_offchannel_nocopy(struct rpmsg_endpoint* ept, uint32_t src, uint32_t dst, const void* data, int len);
+int         rpmsg_release_tx_buffer(struct rpmsg_endpoint* ept, void* txbuf);
+void        rpmsg_hold_rx_buffer(struct rpmsg_endpoint* ept, void* rxbuf);
+void        rpmsg_release_rx_buffer(struct rpmsg_endpoint* ept, void* rxbuf);
+
+/**
+ * \brief           Check if endpoint is bound to remote endpoint
+ * \param[in]       ept: Endpoint
+ * \return          `1` when messages can be sent with \ref rpmsg_send, `0` otherwise
+ */
+static inline unsigned int
+is_rpmsg_ept_ready(struct rpmsg_endpoint* ept) {
+    return ept != NULL && ept->rdev != NULL && ept->dest_addr != RPMSG_ADDR_ANY;
+}
+
+/**
+ * \brief           Send message to bound remote endpoint, wait for channel memory
+ * \param[in]       ept: Endpoint
+ * \param[in]       data: Payload
+ * \param[in]       len: Payload length, up to \ref RPMSG_BUFFER_PAYLOAD bytes
+ * \return          Number of sent bytes, negative error code otherwise
+ */
+static inline int
+rpmsg_send(struct rpmsg_endpoint* ept, const void* data, int len) {
+    if (ept == NULL) {
+        return RPMSG_ERR_PARAM;
+    }
+    return rpmsg_send_offchannel_raw(ept, ept->addr, ept->dest_addr, data, len, 1);
+}
+
+/**
+ * \brief           Send message to remote address, wait for channel memory
+ * \param[in]       ept: Endpoint
+ * \param[in]       data: Payload
+ * \param[in]       len: Payload length
+ * \param[in]       dst: Remote address
+ * \return          Number of sent bytes, negative error code otherwise
+ */
+static inline int
+rpmsg_sendto(struct rpmsg_endpoint* ept, const void* data, int len, uint32_t dst) {
+    if (ept == NULL) {
+        return RPMSG_ERR_PARAM;
+    }
+    return rpmsg_send_offchannel_raw(ept, ept->addr, dst, data, len, 1);
+}
+
+/**
+ * \brief           Send message to bound remote endpoint, fail when channel is full
+ * \param[in]       ept: Endpoint
+ * \param[in]       data: Payload
+ * \param[in]       len: Payload length
+ * \return          Number of sent bytes, \ref RPMSG_ERR_NO_BUFF when channel is full, other negative error code otherwise
+ */
+static inline int
+rpmsg_trysend(struct rpmsg_endpoint* ept, const void* data, int len) {
+    if (ept == NULL) {
+        return RPMSG_ERR_PARAM;
+    }
+    return rpmsg_send_offchannel_raw(ept, ept->addr, ept->dest_addr, data, len, 0);
+}
+
+/**
+ * \brief           Send payload buffer of \ref rpmsg_get_tx_payload_buffer to bound remote endpoint
+ * \param[in]       ept: Endpoint
+ * \param[in]       data: Payload buffer
+ * \param[in]       len: Payload length
+ * \return          Number of sent bytes, negative error code otherwise
+ */
+static inline int
+rpmsg_send_nocopy(struct rpmsg_endpoint* ept, const void* data, int len) {
+    if (ept == NULL) {
+        return RPMSG_ERR_PARAM;
+    }
+    return rpmsg_send_offchannel_nocopy(ept, ept->addr, ept->dest_addr, data, len);
+}
+
+/**
+ * \brief           Send payload buffer of \ref rpmsg_get_tx_payload_buffer to remote address
+ * \param[in]       ept: Endpoint
+ * \param[in]       data: Payload buffer
+ * \param[in]       len: Payload length
+ * \param[in]       dst: Remote address
+ * \return          Number of sent bytes, negative error code otherwise
+ */
+static inline int
+rpmsg_sendto_nocopy(struct rpmsg_endpoint* ept, const void* data, int len, uint32_t dst) {
+    if (ept == NULL) {
+        return RPMSG_ERR_PARAM;
+    }
+    return rpmsg_send_offchannel_nocopy(ept, ept->addr, dst, data, len);
+}
+
+#endif /* IPC_RPMSG_HDR_H */
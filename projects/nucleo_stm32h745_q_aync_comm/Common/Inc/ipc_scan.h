@@ -0,0 +1,77 @@
+/**
+ * \file            ipc_scan.h
+ * \brief           Background integrity scan of shared channels
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_SCAN_HDR_H
+#define IPC_SCAN_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \brief           Integrity check result
+ */
+typedef enum {
+    IPC_SCAN_OK = 0,                            /*!< No corruption found */
+    IPC_SCAN_ERR_DIR,                           /*!< Directory magic or layout length changed */
+    IPC_SCAN_ERR_LAYOUT,                        /*!< Layout hash differs from boot record of CPU1 */
+    IPC_SCAN_ERR_ENTRY,                         /*!< Directory entry does not match channel layout */
+    IPC_SCAN_ERR_MAGIC,                         /*!< Local handle magic words or geometry are corrupted */
+    IPC_SCAN_ERR_HANDLE,                        /*!< Local handle does not point to its channel */
+    IPC_SCAN_ERR_INDEX,                         /*!< Read or write pointer out of range */
+} ipc_scan_err_t;
+
+/**
+ * \brief           Corruption alarm callback, runs from \ref ipc_scan_run.
+ *                  Called once per item when it turns from good to corrupted
+ * \param[in]       id: Channel ID, \ref IPC_SCAN_ID_DIR for directory and layout hash
+ * \param[in]       err: Check result
+ */
+typedef void (*ipc_scan_alarm_fn)(uint32_t id, ipc_scan_err_t err);
+
+/* Item ID of directory and layout hash check */
+#define IPC_SCAN_ID_DIR                     0xFFFFFFFF
+
+/**
+ * \brief           Scan statistics, core-local
+ */
+typedef struct {
+    uint32_t passes;                            /*!< Number of completed passes over all items */
+    uint32_t checks;                            /*!< Number of checked items */
+    uint32_t errors;                            /*!< Number of checks that found corruption */
+    uint32_t alarms;                            /*!< Number of raised alarms */
+    uint32_t last_id;                           /*!< Item ID of last error */
+    ipc_scan_err_t last_err;                    /*!< Last error */
+} ipc_scan_stats_t;
+
+void    ipc_scan_init(ipc_scan_alarm_fn alarm_fn);
+size_t  ipc_scan_run(size_t steps);
+void    ipc_scan_get_stats(ipc_scan_stats_t* stats);
+
+#endif /* IPC_SCAN_HDR_H */
@@ -0,0 +1,69 @@
+/**
+ * \file            ipc_sched.h
+ * \brief           Cooperative scheduler with timer wheel
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_SCHED_HDR_H
+#define IPC_SCHED_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Number of timer wheel slots, power of 2. Slot is 1 SysTick period */
+#define IPC_SCHED_WHEEL_LEN                 32
+
+/**
+ * \brief           Task function, runs from \ref ipc_sched_run in thread mode
+ * \param[in]       arg: User argument
+ */
+typedef void (*ipc_sched_fn)(void* arg);
+
+/**
+ * \brief           Task, core-local. It is posted by interrupts or by its timer
+ */
+typedef struct ipc_sched_task {
+    struct ipc_sched_task* next_ready;          /*!< Next task in ready queue */
+    struct ipc_sched_task* next_timer;          /*!< Next timer in wheel slot */
+    ipc_sched_fn fn;                            /*!< Task function */
+    void* arg;                                  /*!< User argument */
+    uint32_t expires;                           /*!< Tick of next timer expiry */
+    uint32_t period;                            /*!< Timer period in ticks, `0` for one-shot */
+    volatile uint8_t ready;                     /*!< Set to `1` while task is in ready queue */
+    uint8_t armed;                              /*!< Set to `1` while timer is in wheel */
+} ipc_sched_task_t;
+
+void        ipc_sched_task_init(ipc_sched_task_t* t, ipc_sched_fn fn, void* arg);
+void        ipc_sched_post(ipc_sched_task_t* t);
+void        ipc_sched_timer_start(ipc_sched_task_t* t, uint32_t delay, uint32_t period);
+void        ipc_sched_timer_stop(ipc_sched_task_t* t);
+void        ipc_sched_tick(void);
+size_t      ipc_sched_run(void);
+uint8_t     ipc_sched_is_idle(void);
+size_t      ipc_sched_timers_armed(void);
+
+#endif /* IPC_SCHED_HDR_H */
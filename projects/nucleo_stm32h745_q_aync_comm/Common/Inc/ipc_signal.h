@@ -0,0 +1,63 @@
+/**
+ * \file            ipc_signal.h
+ * \brief           Payload-less cross-core signals
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_SIGNAL_HDR_H
+#define IPC_SIGNAL_HDR_H
+
+#include <stdint.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_notify.h"
+
+/**
+ * \brief           Signal callback, called from HSEM interrupt of receiving core
+ * \param[in]       id: Signal ID from \ref ipc_signal_id_t
+ * \param[in]       arg: User argument
+ */
+typedef void (*ipc_signal_fn)(uint32_t id, void* arg);
+
+uint8_t     ipc_signal_listen(uint32_t id, ipc_signal_fn fn, void* arg);
+void        ipc_signal_unlisten(uint32_t id);
+
+/**
+ * \brief           Raise signal on other core, fast path without function call.
+ *
+ * Semaphore of signal is taken in 1-step procedure and released at once,
+ * release interrupts core that listens on signal. Safe from any context of raising core
+ *
+ * \param[in]       id: Signal ID from \ref ipc_signal_id_t
+ */
+static inline void
+ipc_signal_raise(uint32_t id) {
+    (void)HSEM->RLR[HSEM_SIGNAL(id)];           /* Take, process ID 0 */
+    HSEM->R[HSEM_SIGNAL(id)] = HSEM_CR_COREID_CURRENT;  /* Release, notifies listener */
+}
+
+#endif /* IPC_SIGNAL_HDR_H */
@@ -0,0 +1,60 @@
+/**
+ * \file            ipc_soak.h
+ * \brief           Saturation soak test of both pipes
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_SOAK_HDR_H
+#define IPC_SOAK_HDR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ringbuff/ringbuff.h"
+
+/**
+ * \brief           Soak statistics of one core, in control part of shared RAM.
+ *                  Written by owning core only, CPU1 reports both
+ */
+typedef struct {
+    uint32_t bytes_tx;                          /*!< Number of bytes written to other core */
+    uint32_t bytes_rx;                          /*!< Number of bytes received and verified */
+    uint32_t errors;                            /*!< Number of received bytes different from expected stream */
+    uint32_t fill_min;                          /*!< Minimum fill level of receive buffer, seen before read */
+    uint32_t fill_max;                          /*!< Maximum fill level of receive buffer, seen before read */
+} ipc_soak_stats_t;
+
+/**
+ * \brief           Output function for soak report lines
+ * \param[in]       str: Text to output, not `NULL` terminated
+ * \param[in]       len: Length of text in units of bytes
+ */
+typedef void (*ipc_soak_out_fn)(const char* str, size_t len);
+
+void    ipc_soak_reset(void);
+void    ipc_soak_run(ringbuff_t* tx, ringbuff_t* rx, ipc_soak_out_fn out_fn);
+
+#endif /* IPC_SOAK_HDR_H */
@@ -0,0 +1,120 @@
+/**
+ * \file            ipc_steal.h
+ * \brief           Work-stealing job deques of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_STEAL_HDR_H
+#define IPC_STEAL_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ipc_lock.h"
+
+/* Maximum length of job arguments, job descriptor is one cache line */
+#define IPC_STEAL_ARGS_LEN                  24
+
+/**
+ * \brief           Job descriptor in deque slot
+ */
+typedef struct {
+    uint16_t fn_id;                             /*!< Function ID */
+    uint16_t len;                               /*!< Length of arguments in units of bytes */
+    uint32_t submit_us;                         /*!< Time of submit in units of microseconds */
+    uint8_t args[IPC_STEAL_ARGS_LEN];           /*!< Job arguments */
+} ipc_steal_job_t;
+
+/**
+ * \brief           Job function, runs on either core
+ * \param[in]       args: Job arguments
+ * \param[in]       len: Length of arguments in units of bytes
+ */
+typedef void (*ipc_steal_fn)(const void* args, size_t len);
+
+/**
+ * \brief           Function table entry, same function IDs on both cores
+ */
+typedef struct {
+    uint16_t fn_id;                             /*!< Function ID */
+    ipc_steal_fn fn;                            /*!< Function */
+} ipc_steal_entry_t;
+
+/**
+ * \brief           Deque state of one core in shared RAM control part.
+ *                  Positions are protected by deque lock, counters are written by owner core only
+ */
+typedef struct {
+    ipc_lock_t lock;                            /*!< Lock of `top` and `bottom`, HSEM_STEAL_LOCK(core) */
+    uint32_t top;                               /*!< Free-running position of oldest job, stolen first */
+    uint32_t bottom;                            /*!< Free-running position after newest job, run by owner first */
+    uint32_t mhz;                               /*!< Owner core clock in units of MHz */
+    uint32_t executed;                          /*!< Number of jobs executed by owner, own and stolen */
+    uint32_t stolen;                            /*!< Number of jobs stolen by owner from other core */
+    uint32_t steals;                            /*!< Number of successful steal operations of owner */
+    uint32_t full;                              /*!< Number of submits to full deque */
+    uint32_t lat_avg_us;                        /*!< Moving average of submit to completion latency, own jobs only without IPC_TIME */
+    uint32_t lat_max_us;                        /*!< Maximum submit to completion latency, own jobs only without IPC_TIME */
+} ipc_steal_shared_t;
+
+/**
+ * \brief           Worker statistics of one core
+ */
+typedef struct {
+    uint32_t depth;                             /*!< Jobs queued in deque of core */
+    uint32_t executed;                          /*!< Number of jobs executed by core, own and stolen */
+    uint32_t stolen;                            /*!< Number of jobs stolen by core from other core */
+    uint32_t steals;                            /*!< Number of successful steal operations */
+    uint32_t full;                              /*!< Number of submits to full deque */
+    uint32_t lat_avg_us;                        /*!< Moving average of submit to completion latency, own jobs only without IPC_TIME */
+    uint32_t lat_max_us;                        /*!< Maximum submit to completion latency, own jobs only without IPC_TIME */
+} ipc_steal_stats_t;
+
+/**
+ * \brief           Worker of current core, core-local
+ */
+typedef struct {
+    ipc_steal_shared_t* own;                    /*!< Deque of current core */
+    ipc_steal_shared_t* peer;                   /*!< Deque of other core */
+    ipc_steal_job_t* own_jobs;                  /*!< Slots of own deque */
+    ipc_steal_job_t* peer_jobs;                 /*!< Slots of other deque */
+    uint32_t sem_id;                            /*!< Doorbell of own deque, \ref HSEM_STEAL */
+    uint32_t batch;                             /*!< Jobs submitted since last doorbell */
+    const ipc_steal_entry_t* fns;               /*!< Function table */
+    size_t count;                               /*!< Number of entries in function table */
+} ipc_steal_t;
+
+/* Owner core, CPU1, before other core is started */
+void        ipc_steal_reset(void);
+
+/* Both cores */
+uint8_t     ipc_steal_init(ipc_steal_t* w, const ipc_steal_entry_t* fns, size_t count);
+uint8_t     ipc_steal_submit(ipc_steal_t* w, uint16_t fn_id, const void* args, size_t len);
+void        ipc_steal_flush(ipc_steal_t* w);
+size_t      ipc_steal_poll(ipc_steal_t* w);
+void        ipc_steal_get_stats(uint32_t core, ipc_steal_stats_t* stats);
+
+#endif /* IPC_STEAL_HDR_H */
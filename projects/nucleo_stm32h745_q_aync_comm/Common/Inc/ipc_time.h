@@ -0,0 +1,56 @@
+/**
+ * \file            ipc_time.h
+ * \brief           Cross-core timestamps
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_TIME_HDR_H
+#define IPC_TIME_HDR_H
+
+#include <stdint.h>
+
+/**
+ * \brief           Timebase epoch, in control part of shared RAM.
+ *                  Written by CPU1 only, `seq` is odd while fields are updated
+ */
+typedef struct {
+    uint32_t seq;                               /*!< Update sequence */
+    uint32_t base_cnt;                          /*!< Counter value at `base_ns` */
+    uint64_t base_ns;                           /*!< Time at `base_cnt` in units of nanoseconds */
+    uint32_t mult;                              /*!< Nanoseconds per tick, `8.24` fixed point */
+    uint32_t tick_hz;                           /*!< Counter frequency in units of Hz */
+} ipc_time_shared_t;
+
+/* CPU1 */
+void        ipc_time_init(void);
+void        ipc_time_rebase(void);
+void        ipc_time_poll(void);
+
+/* Any core */
+uint64_t    ipc_now_ns(void);
+
+#endif /* IPC_TIME_HDR_H */
@@ -0,0 +1,64 @@
+/**
+ * \file            ipc_wait.h
+ * \brief           Cycle-accurate timeouts
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef IPC_WAIT_HDR_H
+#define IPC_WAIT_HDR_H
+
+#include <stdint.h>
+
+/* Timeout value that never expires */
+#define IPC_WAIT_FOREVER                    0xFFFFFFFFUL
+
+/**
+ * \brief           Timeout measured with DWT cycle counter, or with tick for waits that sleep
+ */
+typedef struct {
+    uint32_t timeout_us;                        /*!< Timeout in units of microseconds */
+    uint32_t last;                              /*!< Cycle counter at previous check, start tick with `tick` set */
+    uint64_t elapsed;                           /*!< Cycles elapsed since start */
+    uint8_t tick;                               /*!< Set to `1` when timeout is measured with tick */
+} ipc_wait_t;
+
+void    ipc_wait_start(ipc_wait_t* w, uint32_t timeout_us);
+void    ipc_wait_start_tick(ipc_wait_t* w, uint32_t timeout_us);
+uint8_t ipc_wait_expired(ipc_wait_t* w);
+
+/* Wait while condition is true, call error handler when timeout in microseconds expires */
+#define WAIT_COND_WITH_TIMEOUT_US(c, t)     do {        \
+    ipc_wait_t wait;                                    \
+    ipc_wait_start(&wait, (t));                         \
+    while (c) {                                         \
+        if (ipc_wait_expired(&wait)) {                  \
+            Error_Handler();                            \
+        }                                               \
+    }                                                   \
+} while (0)
+
+#endif /* IPC_WAIT_HDR_H */
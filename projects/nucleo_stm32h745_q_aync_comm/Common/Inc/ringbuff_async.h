@@ -0,0 +1,54 @@
+/**
+ * \file            ringbuff_async.h
+ * \brief           Completion callbacks of ring buffer reads and writes
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_ASYNC_HDR_H
+#define RINGBUFF_ASYNC_HDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ringbuff/ringbuff.h"
+
+/* Number of callbacks pending at the same time, on each core */
+#define RINGBUFF_ASYNC_SLOTS                8
+
+/**
+ * \brief           Completion callback, called once when condition is met
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Bytes ready to be read or free bytes, at least requested number
+ * \param[in]       ctx: User context
+ */
+typedef void (*ringbuff_async_fn)(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len, void* ctx);
+
+uint8_t     ringbuff_read_async(RINGBUFF_VOLATILE ringbuff_t* buff, size_t n, ringbuff_async_fn cb, void* ctx);
+uint8_t     ringbuff_write_async(RINGBUFF_VOLATILE ringbuff_t* buff, size_t m, ringbuff_async_fn cb, void* ctx);
+void        ringbuff_async_cancel(RINGBUFF_VOLATILE ringbuff_t* buff);
+void        ringbuff_async_poll(void);
+
+#endif /* RINGBUFF_ASYNC_HDR_H */
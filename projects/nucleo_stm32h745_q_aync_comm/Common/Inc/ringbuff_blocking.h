@@ -0,0 +1,40 @@
+/**
+ * \file            ringbuff_blocking.h
+ * \brief           Blocking ring buffer write and read
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_BLOCKING_HDR_H
+#define RINGBUFF_BLOCKING_HDR_H
+
+#include <stdint.h>
+#include "ringbuff/ringbuff.h"
+
+size_t      ringbuff_write_blocking(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw, uint32_t timeout_us);
+size_t      ringbuff_read_blocking(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t btr, uint32_t timeout_us);
+
+#endif /* RINGBUFF_BLOCKING_HDR_H */
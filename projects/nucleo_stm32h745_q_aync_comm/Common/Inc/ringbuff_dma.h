@@ -0,0 +1,75 @@
+/**
+ * \file            ringbuff_dma.h
+ * \brief           Ring buffer transfers with MDMA
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_DMA_HDR_H
+#define RINGBUFF_DMA_HDR_H
+
+#include "stm32h7xx_hal.h"
+#include "ringbuff/ringbuff.h"
+
+/**
+ * \brief           Transfers shorter than threshold are copied by CPU,
+ *                  MDMA setup and interrupt cost more than copy itself
+ */
+#ifndef RINGBUFF_DMA_THRESHOLD
+#define RINGBUFF_DMA_THRESHOLD              64
+#endif
+
+struct ringbuff_dma;
+
+/**
+ * \brief           Transfer finished callback, called from MDMA interrupt
+ *                  or directly from caller context for CPU copy
+ * \param[in]       dma: DMA transfer handle
+ * \param[in]       len: Number of bytes transferred, `0` on transfer error
+ */
+typedef void (*ringbuff_dma_done_fn)(struct ringbuff_dma* dma, size_t len);
+
+/**
+ * \brief           DMA transfer handle, one per MDMA channel
+ */
+typedef struct ringbuff_dma {
+    MDMA_HandleTypeDef hmdma;                   /*!< MDMA channel handle, must be first member */
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Buffer handle */
+    ringbuff_dma_done_fn done_fn;               /*!< Transfer finished callback */
+    volatile uint8_t busy;                      /*!< Set to `1` while transfer is active */
+    uint8_t is_write;                           /*!< Set to `1` for write to buffer, `0` for read */
+    size_t len;                                 /*!< Total transfer length */
+    uint32_t src2;                              /*!< Second segment source address, after buffer wrap */
+    uint32_t dst2;                              /*!< Second segment destination address, after buffer wrap */
+    size_t len2;                                /*!< Second segment length, `0` when not used */
+} ringbuff_dma_t;
+
+uint8_t     ringbuff_dma_init(ringbuff_dma_t* dma, RINGBUFF_VOLATILE ringbuff_t* rb, MDMA_Channel_TypeDef* channel, ringbuff_dma_done_fn done_fn);
+size_t      ringbuff_write_dma(ringbuff_dma_t* dma, const void* data, size_t btw);
+size_t      ringbuff_read_dma(ringbuff_dma_t* dma, void* data, size_t btr);
+uint8_t     ringbuff_dma_is_busy(ringbuff_dma_t* dma);
+
+#endif /* RINGBUFF_DMA_HDR_H */
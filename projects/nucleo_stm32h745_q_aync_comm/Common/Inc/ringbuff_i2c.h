@@ -0,0 +1,98 @@
+/**
+ * \file            ringbuff_i2c.h
+ * \brief           Ring buffer I2C sensor acquisition with DMA
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_I2C_HDR_H
+#define RINGBUFF_I2C_HDR_H
+
+#include "stm32h7xx_hal.h"
+#include "ringbuff/ringbuff.h"
+
+#ifdef HAL_I2C_MODULE_ENABLED
+
+/* Maximum register block read from single sensor in units of bytes */
+#define RINGBUFF_I2C_MAX_LEN                32
+
+/**
+ * \brief           Sensor register block, read with single I2C memory read
+ */
+typedef struct {
+    uint16_t dev_addr;                          /*!< 7-bit device address */
+    uint16_t reg;                               /*!< First register address */
+    uint16_t reg_size;                          /*!< Register address size, `I2C_MEMADD_SIZE_8BIT` or `I2C_MEMADD_SIZE_16BIT` */
+    uint16_t len;                               /*!< Block length in units of bytes, up to \ref RINGBUFF_I2C_MAX_LEN */
+} ringbuff_i2c_sensor_t;
+
+/**
+ * \brief           Sample record, message payload starts with it and register block follows it
+ */
+typedef struct {
+    uint32_t time;                              /*!< Tick at transfer complete, in units of milliseconds */
+    uint16_t id;                                /*!< Sensor index in sensor table */
+    uint16_t reserved;                          /*!< Reserved, `0` */
+} ringbuff_i2c_rec_t;
+
+struct ringbuff_i2c_acq;
+
+/**
+ * \brief           Scan finished callback, called from I2C interrupt
+ *                  after last record of scan was committed to buffer
+ * \param[in]       acq: Acquisition handle
+ * \param[in]       records: Number of records committed in this scan
+ */
+typedef void (*ringbuff_i2c_done_fn)(struct ringbuff_i2c_acq* acq, size_t records);
+
+/**
+ * \brief           I2C acquisition, DMA reads sensor registers directly to reserved buffer memory
+ */
+typedef struct ringbuff_i2c_acq {
+    I2C_HandleTypeDef* hi2c;                    /*!< I2C handle, with RX DMA linked */
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Buffer handle, producer side */
+    const ringbuff_i2c_sensor_t* sensors;       /*!< Sensor table */
+    size_t count;                               /*!< Number of sensors */
+    ringbuff_i2c_done_fn done_fn;               /*!< Scan finished callback */
+    volatile size_t idx;                        /*!< Sensor of active transfer, `count` when idle */
+    uint8_t* dst;                               /*!< Record memory of active transfer, reserved in buffer or `stage` */
+    size_t scan_records;                        /*!< Records committed in active scan */
+    uint32_t records;                           /*!< Records committed */
+    uint32_t dropped;                           /*!< Samples dropped on full buffer */
+    uint32_t errors;                            /*!< Failed transfers */
+    uint8_t stage[sizeof(ringbuff_i2c_rec_t) + RINGBUFF_I2C_MAX_LEN] __ALIGNED(4);  /*!< Record memory when buffer cannot reserve linear memory */
+} ringbuff_i2c_acq_t;
+
+uint8_t     ringbuff_i2c_init(ringbuff_i2c_acq_t* acq, I2C_HandleTypeDef* hi2c, RINGBUFF_VOLATILE ringbuff_t* rb,
+                              const ringbuff_i2c_sensor_t* sensors, size_t count, ringbuff_i2c_done_fn done_fn);
+uint8_t     ringbuff_i2c_start(ringbuff_i2c_acq_t* acq);
+void        ringbuff_i2c_cplt(ringbuff_i2c_acq_t* acq);
+void        ringbuff_i2c_error(ringbuff_i2c_acq_t* acq);
+uint8_t     ringbuff_i2c_is_busy(ringbuff_i2c_acq_t* acq);
+
+#endif /* HAL_I2C_MODULE_ENABLED */
+
+#endif /* RINGBUFF_I2C_HDR_H */
@@ -0,0 +1,53 @@
+/**
+ * \file            ringbuff_mpsc.h
+ * \brief           Multi-producer ring buffer write
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_MPSC_HDR_H
+#define RINGBUFF_MPSC_HDR_H
+
+#include <stdint.h>
+#include "ringbuff/ringbuff.h"
+
+/**
+ * \brief           Multi-producer write handle, placed in core-local memory
+ *
+ * All producers (thread and interrupts) must run on the same core,
+ * single consumer may run on other core and uses regular read functions.
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Producer buffer handle, not used for writes by any other function */
+    volatile uint32_t state;                    /*!< Bits `31:24` are number of producers between claim and commit,
+                                                    bits `23:0` are reserve pointer, bits `23:0` of free-running write pointer
+                                                    including claimed but not committed data */
+} ringbuff_mpsc_t;
+
+uint8_t     ringbuff_mpsc_init(ringbuff_mpsc_t* mpsc, RINGBUFF_VOLATILE ringbuff_t* rb);
+size_t      ringbuff_mpsc_write(ringbuff_mpsc_t* mpsc, const void* data, size_t btw);
+
+#endif /* RINGBUFF_MPSC_HDR_H */
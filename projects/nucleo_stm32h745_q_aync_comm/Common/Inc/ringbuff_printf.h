@@ -0,0 +1,42 @@
+/**
+ * \file            ringbuff_printf.h
+ * \brief           Formatted output directly to ring buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_PRINTF_HDR_H
+#define RINGBUFF_PRINTF_HDR_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include "ringbuff/ringbuff.h"
+
+size_t      ringbuff_printf(RINGBUFF_VOLATILE ringbuff_t* rb, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+size_t      ringbuff_vprintf(RINGBUFF_VOLATILE ringbuff_t* rb, const char* fmt, va_list ap);
+uint32_t    ringbuff_printf_get_dropped(void);
+
+#endif /* RINGBUFF_PRINTF_HDR_H */
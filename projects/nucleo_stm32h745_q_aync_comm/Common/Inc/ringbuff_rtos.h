@@ -0,0 +1,66 @@
+/**
+ * \file            ringbuff_rtos.h
+ * \brief           FreeRTOS port layer for ring buffers between cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_RTOS_HDR_H
+#define RINGBUFF_RTOS_HDR_H
+
+#include <stdint.h>
+#include "common.h"
+#include "ringbuff/ringbuff.h"
+
+#if IPC_RTOS
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Semaphore ID for endpoint without peer doorbell */
+#define RINGBUFF_RTOS_NO_SEM                0xFFFFFFFF
+
+/**
+ * \brief           Blocking endpoint of channel, core-local
+ *
+ * Endpoint is either producer or consumer side of one channel.
+ * Task blocked in \ref ringbuff_rtos_send or \ref ringbuff_rtos_recv waits on its task notification,
+ * given from HSEM interrupt when peer rings doorbell `wait_sem`
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* buff;         /*!< Buffer handle */
+    uint32_t wait_sem;                          /*!< Doorbell rung by peer, data written or memory freed */
+    uint32_t ring_sem;                          /*!< Doorbell rung after own write or read */
+    TaskHandle_t volatile waiter;               /*!< Blocked task, `NULL` when none */
+} ringbuff_rtos_t;
+
+uint8_t     ringbuff_rtos_init(ringbuff_rtos_t* ep, RINGBUFF_VOLATILE ringbuff_t* buff, uint32_t wait_sem, uint32_t ring_sem);
+size_t      ringbuff_rtos_send(ringbuff_rtos_t* ep, const void* data, size_t btw, TickType_t timeout);
+size_t      ringbuff_rtos_recv(ringbuff_rtos_t* ep, void* data, size_t size, TickType_t timeout);
+
+#endif /* IPC_RTOS */
+
+#endif /* RINGBUFF_RTOS_HDR_H */
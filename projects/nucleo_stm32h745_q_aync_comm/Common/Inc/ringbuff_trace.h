@@ -0,0 +1,125 @@
+/**
+ * \file            ringbuff_trace.h
+ * \brief           Ring buffer event trace over ITM
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_TRACE_HDR_H
+#define RINGBUFF_TRACE_HDR_H
+
+#include <stdint.h>
+#include "stm32h7xx.h"
+#include "ringbuff/ringbuff.h"
+#include "ipc_frec.h"
+
+/*
+ * ITM stimulus port of trace events of this core.
+ * Both cores share single SWO pin through trace funnel, SWO does not carry source ID,
+ * cores therefore write to different ports
+ */
+#ifndef RINGBUFF_TRACE_PORT
+#if defined(CORE_CM7)
+#define RINGBUFF_TRACE_PORT                 8
+#else
+#define RINGBUFF_TRACE_PORT                 16
+#endif
+#endif
+
+/*
+ * Write DWT cycle counter to port RINGBUFF_TRACE_PORT + 1 after every event.
+ * Disabled by default, ITM local timestamp packets already stamp events in core cycles
+ */
+#ifndef RINGBUFF_TRACE_STAMP
+#define RINGBUFF_TRACE_STAMP                0
+#endif
+
+/*
+ * Event word, single 32-bit stimulus write:
+ *
+ * - Bits 31:24: Buffer trace ID, see ringbuff_set_trace_id
+ * - Bits 23:20: Event, ringbuff_evt_type_t
+ * - Bits 19:0: Number of bytes, saturated
+ */
+#define RINGBUFF_TRACE_LEN_MAX              0x000FFFFF
+#define RINGBUFF_TRACE_WORD(id, evt, len)   (((uint32_t)(id) << 24) | (((uint32_t)(evt) & 0x0F) << 20)   \
+                                                | ((len) > RINGBUFF_TRACE_LEN_MAX ? RINGBUFF_TRACE_LEN_MAX : (uint32_t)(len)))
+
+#if RINGBUFF_USE_TRACE
+
+/* Number of events dropped on full stimulus port FIFO */
+extern volatile uint32_t ringbuff_trace_drops;
+
+void        ringbuff_trace_init(void);
+
+/**
+ * \brief           Emit trace event of buffer operation, \ref RINGBUFF_TRACE hook.
+ *
+ * Event is written only when stimulus port is enabled, by \ref ringbuff_trace_init or trace tool.
+ * With \ref IPC_FREC, flight recorder gets every event, also when port is disabled.
+ * Event is dropped and counted in \ref ringbuff_trace_drops when port FIFO is full,
+ * function never waits for SWO output
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       evt: Event type
+ * \param[in]       len: Number of bytes written or read
+ */
+static inline void
+ringbuff_trace(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_evt_type_t evt, size_t len) {
+    uint32_t word = RINGBUFF_TRACE_WORD(buff->trace_id, evt, len);
+#if RINGBUFF_TRACE_STAMP
+    uint32_t primask;
+#endif /* RINGBUFF_TRACE_STAMP */
+
+#if IPC_FREC
+    ipc_frec_add(word);
+#endif /* IPC_FREC */
+    if ((ITM->TER & (1UL << RINGBUFF_TRACE_PORT)) == 0) {
+        return;
+    }
+#if RINGBUFF_TRACE_STAMP
+    /* Event and stamp are written as pair, interrupt may not write its event in between */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (ITM->PORT[RINGBUFF_TRACE_PORT].u32 != 0 && ITM->PORT[RINGBUFF_TRACE_PORT + 1].u32 != 0) {
+        ITM->PORT[RINGBUFF_TRACE_PORT].u32 = word;
+        ITM->PORT[RINGBUFF_TRACE_PORT + 1].u32 = DWT->CYCCNT;
+    } else {
+        ++ringbuff_trace_drops;
+    }
+    __set_PRIMASK(primask);
+#else
+    if (ITM->PORT[RINGBUFF_TRACE_PORT].u32 != 0) {  /* Reads FIFO ready */
+        ITM->PORT[RINGBUFF_TRACE_PORT].u32 = word;
+    } else {
+        ++ringbuff_trace_drops;
+    }
+#endif /* RINGBUFF_TRACE_STAMP */
+}
+
+#endif /* RINGBUFF_USE_TRACE */
+
+#endif /* RINGBUFF_TRACE_HDR_H */
@@ -0,0 +1,105 @@
+/**
+ * \file            ringbuff_uart.h
+ * \brief           Ring buffer UART transfers with DMA
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef RINGBUFF_UART_HDR_H
+#define RINGBUFF_UART_HDR_H
+
+#include "stm32h7xx_hal.h"
+#include "ringbuff/ringbuff.h"
+#include "ipc_wait.h"
+
+#ifdef HAL_UART_MODULE_ENABLED
+
+struct ringbuff_uart_tx;
+
+/**
+ * \brief           Data sent callback, called from UART interrupt
+ *                  after sent data were released from buffer
+ * \param[in]       tx: UART transmitter handle
+ * \param[in]       len: Number of bytes released
+ */
+typedef void (*ringbuff_uart_tx_done_fn)(struct ringbuff_uart_tx* tx, size_t len);
+
+/**
+ * \brief           UART transmitter, sends buffer data with DMA directly from buffer memory
+ */
+typedef struct ringbuff_uart_tx {
+    UART_HandleTypeDef* huart;                  /*!< UART handle, with TX DMA linked */
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Buffer handle, consumer side */
+    ringbuff_uart_tx_done_fn done_fn;           /*!< Data sent callback */
+    volatile size_t len;                        /*!< Length of active transfer, `0` when idle */
+    size_t batch_len;                           /*!< Pending length which starts transfer at once, `0` sends every block */
+    uint32_t batch_deadline_us;                 /*!< Maximum time data wait for batch to fill */
+    uint32_t batch_idle_us;                     /*!< Time without new data which closes batch */
+    size_t batch_pending;                       /*!< Pending length at previous check, `0` when no batch is open */
+    ipc_wait_t batch_deadline;                  /*!< Deadline of open batch */
+    ipc_wait_t batch_idle;                      /*!< Idle time of open batch */
+} ringbuff_uart_tx_t;
+
+uint8_t     ringbuff_uart_tx_init(ringbuff_uart_tx_t* tx, UART_HandleTypeDef* huart, RINGBUFF_VOLATILE ringbuff_t* rb, ringbuff_uart_tx_done_fn done_fn);
+void        ringbuff_uart_tx_set_batch(ringbuff_uart_tx_t* tx, size_t len, uint32_t deadline_us, uint32_t idle_us);
+uint8_t     ringbuff_uart_tx_start(ringbuff_uart_tx_t* tx);
+uint8_t     ringbuff_uart_tx_poll(ringbuff_uart_tx_t* tx);
+void        ringbuff_uart_tx_cplt(ringbuff_uart_tx_t* tx);
+void        ringbuff_uart_tx_error(ringbuff_uart_tx_t* tx);
+uint8_t     ringbuff_uart_tx_is_busy(ringbuff_uart_tx_t* tx);
+
+struct ringbuff_uart_rx;
+
+/**
+ * \brief           Data received callback, called from UART or DMA interrupt
+ *                  after received data were committed to buffer
+ * \param[in]       rx: UART receiver handle
+ * \param[in]       len: Number of bytes committed
+ */
+typedef void (*ringbuff_uart_rx_done_fn)(struct ringbuff_uart_rx* rx, size_t len);
+
+/**
+ * \brief           UART receiver, receives data with DMA directly to buffer memory
+ */
+typedef struct ringbuff_uart_rx {
+    UART_HandleTypeDef* huart;                  /*!< UART handle, with RX DMA linked */
+    RINGBUFF_VOLATILE ringbuff_t* rb;           /*!< Buffer handle, producer side */
+    ringbuff_uart_rx_done_fn done_fn;           /*!< Data received callback */
+    volatile size_t len;                        /*!< Length of active transfer, `0` when idle */
+    volatile size_t pos;                        /*!< Number of bytes of active transfer already committed */
+} ringbuff_uart_rx_t;
+
+uint8_t     ringbuff_uart_rx_init(ringbuff_uart_rx_t* rx, UART_HandleTypeDef* huart, RINGBUFF_VOLATILE ringbuff_t* rb, ringbuff_uart_rx_done_fn done_fn);
+uint8_t     ringbuff_uart_rx_start(ringbuff_uart_rx_t* rx);
+void        ringbuff_uart_rx_half_cplt(ringbuff_uart_rx_t* rx);
+void        ringbuff_uart_rx_cplt(ringbuff_uart_rx_t* rx);
+void        ringbuff_uart_rx_irq(ringbuff_uart_rx_t* rx);
+void        ringbuff_uart_rx_error(ringbuff_uart_rx_t* rx);
+uint8_t     ringbuff_uart_rx_is_busy(ringbuff_uart_rx_t* rx);
+
+#endif /* HAL_UART_MODULE_ENABLED */
+
+#endif /* RINGBUFF_UART_HDR_H */
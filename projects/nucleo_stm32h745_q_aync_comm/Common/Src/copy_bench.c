@@ -0,0 +1,215 @@
+/**
+ * \file            copy_bench.c
+ * \brief           Copy kernel benchmark
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include "main.h"
+#include "common.h"
+#include "copy_bench.h"
+#include "ipc_chan.h"
+#include "ringbuff/ringbuff_spec.h"
+
+#if COPY_BENCH
+
+#if defined(CORE_CM7)
+#define COPY_BENCH_CORE                     "CM7"
+#define COPY_BENCH_SHD_ADDR                 (IPC_SHM->bench_cm7)
+#else
+#define COPY_BENCH_CORE                     "CM4"
+#define COPY_BENCH_SHD_ADDR                 (IPC_SHM->bench_cm4)
+#endif
+
+/* Number of copies per measurement */
+#define COPY_BENCH_LOOPS                    16
+
+/* Ring buffer write and read length */
+#define COPY_BENCH_CHUNK                    0x00000100
+
+/* Core-local test memory, `4` bytes extra for misaligned source */
+static uint32_t local_mem[(COPY_BENCH_LEN + 4) / sizeof(uint32_t)];
+static uint32_t local_out[COPY_BENCH_LEN / sizeof(uint32_t)];
+
+/* Ring buffer on shared scratch memory */
+static ringbuff_t rb_bench;
+
+/* Same buffer used by this core only, specialized to plain indexed copy */
+RINGBUFF_SPEC_DEFINE(rb_bench_local, RINGBUFF_SPEC_LOCAL)
+
+/**
+ * \brief           Copy function under test, `memcpy` compatible
+ */
+typedef void * (*copy_fn)(void* dst, const void* src, size_t len);
+
+/**
+ * \brief           Measure copy throughput
+ * \param[in]       fn: Copy function
+ * \param[out]      dst: Destination memory
+ * \param[in]       src: Source memory
+ * \return          Throughput in units of `10 kB/s`, `MB/s * 100`
+ */
+static uint32_t
+prv_measure(copy_fn fn, void* dst, const void* src) {
+    uint32_t start, cycles;
+
+    fn(dst, src, COPY_BENCH_LEN);               /* Warm-up, fill caches and prefetch queues */
+    start = CYCCNT_GET();
+    for (size_t i = 0; i < COPY_BENCH_LOOPS; ++i) {
+        fn(dst, src, COPY_BENCH_LEN);
+    }
+    cycles = CYCCNT_GET() - start;
+    if (cycles == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)COPY_BENCH_LEN * COPY_BENCH_LOOPS * SystemCoreClock / 10000) / cycles);
+}
+
+/**
+ * \brief           Measure ring buffer throughput through shared memory,
+ *                  data are written and read back in chunks of \ref COPY_BENCH_CHUNK bytes
+ * \param[in]       rb: Buffer handle, data array in shared memory
+ * \param[in]       src: Source memory, \ref COPY_BENCH_LEN bytes
+ * \param[out]      dst: Destination memory, \ref COPY_BENCH_LEN bytes
+ * \return          Throughput in units of `10 kB/s`, `MB/s * 100`
+ */
+static uint32_t
+prv_measure_ring(ringbuff_t* rb, const uint8_t* src, uint8_t* dst) {
+    uint32_t start, cycles;
+
+    start = CYCCNT_GET();
+    for (size_t i = 0; i < COPY_BENCH_LOOPS; ++i) {
+        for (size_t off = 0; off < COPY_BENCH_LEN; off += COPY_BENCH_CHUNK) {
+            ringbuff_write(rb, &src[off], COPY_BENCH_CHUNK);
+            ringbuff_read(rb, &dst[off], COPY_BENCH_CHUNK);
+        }
+    }
+    cycles = CYCCNT_GET() - start;
+    if (cycles == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)COPY_BENCH_LEN * COPY_BENCH_LOOPS * SystemCoreClock / 10000) / cycles);
+}
+
+/**
+ * \brief           Measure throughput of specialized core-local ring buffer,
+ *                  same pattern as \ref prv_measure_ring
+ * \param[in]       rb: Buffer handle, not shared with other core
+ * \param[in]       src: Source memory, \ref COPY_BENCH_LEN bytes
+ * \param[out]      dst: Destination memory, \ref COPY_BENCH_LEN bytes
+ * \return          Throughput in units of `10 kB/s`, `MB/s * 100`
+ */
+static uint32_t
+prv_measure_ring_local(ringbuff_t* rb, const uint8_t* src, uint8_t* dst) {
+    uint32_t start, cycles;
+
+    start = CYCCNT_GET();
+    for (size_t i = 0; i < COPY_BENCH_LOOPS; ++i) {
+        for (size_t off = 0; off < COPY_BENCH_LEN; off += COPY_BENCH_CHUNK) {
+            rb_bench_local_write(rb, &src[off], COPY_BENCH_CHUNK);
+            rb_bench_local_read(rb, &dst[off], COPY_BENCH_CHUNK);
+        }
+    }
+    cycles = CYCCNT_GET() - start;
+    if (cycles == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)COPY_BENCH_LEN * COPY_BENCH_LOOPS * SystemCoreClock / 10000) / cycles);
+}
+
+/**
+ * \brief           Run copy benchmark on current core and report results
+ *
+ * Measures `memcpy` and \ref ringbuff_memcpy (default \ref RINGBUFF_MEMCPY)
+ * for copies from core-local memory to shared RAM and back,
+ * with source address offset `0-3` bytes from word boundary.
+ *
+ * Each report line has format `[core] kernel dir off:x MB/s`
+ *
+ * Last line reports ring buffer write and read throughput through shared memory,
+ * `maint:1` when data array is cacheable and cache maintenance is done (\ref IPC_CHAN_CACHE_MAINT).
+ * Compare builds with different `SHD_RAM_DATA_CACHE` setting.
+ * It is followed by the same test with \ref RINGBUFF_SPEC_LOCAL functions,
+ * without volatile accesses, barriers, magic checks and events
+ *
+ * \param[in]       out_fn: Output function for report lines
+ */
+void
+copy_bench_run(copy_bench_out_fn out_fn) {
+    static const struct {
+        const char* name;
+        copy_fn fn;
+    } kernels[] = {
+        { "memcpy", memcpy },
+        { "ringbuff_memcpy", ringbuff_memcpy },
+    };
+    uint8_t* local = (uint8_t *)local_mem;
+    uint8_t* shd = (uint8_t *)COPY_BENCH_SHD_ADDR;
+    char str[64];
+    uint32_t tput;
+    int len;
+
+    CYCCNT_INIT();
+    for (size_t i = 0; i < COPY_BENCH_LEN + 4; ++i) {
+        local[i] = (uint8_t)i;
+    }
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        for (size_t off = 0; off < 4; ++off) {
+            /* Core-local memory to shared memory, as in ringbuff_write */
+            tput = prv_measure(kernels[k].fn, shd, &local[off]);
+            len = sprintf(str, "[" COPY_BENCH_CORE "] %s local->shd off:%u %u.%02u MB/s\r\n",
+                            kernels[k].name, (unsigned)off, (unsigned)(tput / 100), (unsigned)(tput % 100));
+            out_fn(str, len);
+
+            /* Shared memory to core-local memory, as in ringbuff_read */
+            tput = prv_measure(kernels[k].fn, local, &shd[off]);
+            len = sprintf(str, "[" COPY_BENCH_CORE "] %s shd->local off:%u %u.%02u MB/s\r\n",
+                            kernels[k].name, (unsigned)off, (unsigned)(tput / 100), (unsigned)(tput % 100));
+            out_fn(str, len);
+        }
+    }
+
+    /* Ring buffer through shared memory, with same cache attributes as channel data */
+    if (ringbuff_init(&rb_bench, shd, COPY_BENCH_LEN)) {
+#if IPC_CHAN_CACHE_MAINT
+        ringbuff_set_cache_maint(&rb_bench, 1);
+#endif /* IPC_CHAN_CACHE_MAINT */
+        tput = prv_measure_ring(&rb_bench, local, (uint8_t *)local_out);
+        len = sprintf(str, "[" COPY_BENCH_CORE "] ringbuff write+read maint:%u %u.%02u MB/s\r\n",
+                        (unsigned)IPC_CHAN_CACHE_MAINT, (unsigned)(tput / 100), (unsigned)(tput % 100));
+        out_fn(str, len);
+
+        /* Buffer is private to this core, so cache maintenance is not needed */
+        ringbuff_reset(&rb_bench);
+        tput = prv_measure_ring_local(&rb_bench, local, (uint8_t *)local_out);
+        len = sprintf(str, "[" COPY_BENCH_CORE "] ringbuff spec local write+read %u.%02u MB/s\r\n",
+                        (unsigned)(tput / 100), (unsigned)(tput % 100));
+        out_fn(str, len);
+    }
+}
+
+#endif /* COPY_BENCH */
@@ -0,0 +1,572 @@
+/**
+ * \file            ipc_bench.c
+ * \brief           Inter-core pipe benchmark
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_bench.h"
+#include "ipc_chan.h"
+#include "ipc_wait.h"
+#include "ringbuff_trace.h"
+
+#if IPC_BENCH
+
+/* Largest message length of sweep, sweep starts at `1` byte and doubles */
+#define IPC_BENCH_MAX_LEN                   0x00001000
+
+/* Number of messages per latency measurement */
+#define IPC_BENCH_LOOPS                     64
+
+/* Number of bytes per throughput measurement */
+#define IPC_BENCH_TPUT_LEN                  0x00010000
+
+/* Time for CPU2 to accept command, in units of milliseconds */
+#define IPC_BENCH_ACK_TIMEOUT               1000
+
+/* RPC call timeout, first call waits for CPU2 to enter application loop, in units of microseconds */
+#define IPC_BENCH_RPC_TIMEOUT_US            100000
+
+/* Command magic, command is echoed back by CPU2 as acknowledge */
+#define IPC_BENCH_CMD_MAGIC                 0x42454E43
+
+/**
+ * \brief           Test mode of CPU2
+ */
+typedef enum {
+    IPC_BENCH_MODE_DISCARD,                     /*!< Read and drop `total` bytes */
+    IPC_BENCH_MODE_ECHO,                        /*!< Read and write back `total` bytes in messages of `msg_len` bytes */
+    IPC_BENCH_MODE_DONE,                        /*!< Benchmark finished, CPU2 returns to application */
+} ipc_bench_mode_t;
+
+/**
+ * \brief           Command sent in-band before every measurement, while both pipes are empty
+ */
+typedef struct {
+    uint32_t magic;                             /*!< Set to \ref IPC_BENCH_CMD_MAGIC */
+    uint32_t mode;                              /*!< Test mode, \ref ipc_bench_mode_t */
+    uint32_t msg_len;                           /*!< Message length in units of bytes */
+    uint32_t total;                             /*!< Total number of bytes of measurement */
+} ipc_bench_cmd_t;
+
+/**
+ * \brief           Latency statistics in units of CPU cycles
+ */
+typedef struct {
+    uint32_t min;                               /*!< Minimum */
+    uint32_t max;                               /*!< Maximum */
+    uint64_t sum;                               /*!< Sum of all samples */
+} ipc_bench_stat_t;
+
+/* Message memory, core-local */
+static uint8_t bench_buf[IPC_BENCH_MAX_LEN];
+
+/**
+ * \brief           Write all bytes, wait for free memory
+ * \param[in]       rb: Buffer handle
+ * \param[in]       data: Data to write
+ * \param[in]       len: Number of bytes
+ */
+static void
+prv_write_all(ringbuff_t* rb, const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t written;
+
+    while (len > 0) {
+        written = ringbuff_write(rb, d, len);
+        d += written;
+        len -= written;
+    }
+}
+
+/**
+ * \brief           Read exact number of bytes, wait for data
+ * \param[in]       rb: Buffer handle
+ * \param[out]      data: Memory to read to
+ * \param[in]       len: Number of bytes
+ */
+static void
+prv_read_all(ringbuff_t* rb, void* data, size_t len) {
+    uint8_t* d = data;
+    size_t read;
+
+    while (len > 0) {
+        read = ringbuff_read(rb, d, len);
+        d += read;
+        len -= read;
+    }
+}
+
+/**
+ * \brief           Send command to CPU2 and wait for acknowledge
+ * \param[in]       tx: Buffer to CPU2
+ * \param[in]       rx: Buffer from CPU2
+ * \param[in]       mode: Test mode
+ * \param[in]       msg_len: Message length
+ * \param[in]       total: Total number of bytes
+ * \return          `1` when CPU2 acknowledged, `0` on timeout
+ */
+static uint8_t
+prv_command(ringbuff_t* tx, ringbuff_t* rx, ipc_bench_mode_t mode, uint32_t msg_len, uint32_t total) {
+    ipc_bench_cmd_t cmd = { IPC_BENCH_CMD_MAGIC, mode, msg_len, total }, ack;
+    uint32_t start = HAL_GetTick();
+
+    prv_write_all(tx, &cmd, sizeof(cmd));
+    while (ringbuff_get_full(rx) < sizeof(ack)) {
+        if (HAL_GetTick() - start > IPC_BENCH_ACK_TIMEOUT) {
+            return 0;
+        }
+    }
+    prv_read_all(rx, &ack, sizeof(ack));
+    return memcmp(&ack, &cmd, sizeof(cmd)) == 0;
+}
+
+/**
+ * \brief           Add sample to statistics
+ * \param[in,out]   stat: Statistics
+ * \param[in]       cycles: Sample in units of CPU cycles
+ */
+static void
+prv_stat_add(ipc_bench_stat_t* stat, uint32_t cycles) {
+    if (cycles < stat->min) {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max) {
+        stat->max = cycles;
+    }
+    stat->sum += cycles;
+}
+
+/**
+ * \brief           Report latency statistics, `[BENCH] name len:x min:x avg:x max:x cyc avg:x ns`
+ * \param[in]       out_fn: Output function
+ * \param[in]       name: Measurement name
+ * \param[in]       len: Message length
+ * \param[in]       stat: Statistics of \ref IPC_BENCH_LOOPS samples
+ */
+static void
+prv_report_lat(ipc_bench_out_fn out_fn, const char* name, size_t len, const ipc_bench_stat_t* stat) {
+    char str[96];
+    uint32_t avg = (uint32_t)(stat->sum / IPC_BENCH_LOOPS);
+    int n;
+
+    n = sprintf(str, "[BENCH] %s len:%u min:%u avg:%u max:%u cyc avg:%u ns\r\n", name, (unsigned)len,
+                (unsigned)stat->min, (unsigned)avg, (unsigned)stat->max,
+                (unsigned)((uint64_t)avg * 1000 / CYCCNT_PER_US()));
+    out_fn(str, n);
+}
+
+/**
+ * \brief           Measure one-way latency, from start of write
+ *                  until producer sees data released by consumer
+ * \param[in]       tx: Buffer to CPU2
+ * \param[in]       len: Message length
+ * \param[out]      stat: Statistics
+ */
+static void
+prv_measure_oneway(ringbuff_t* tx, size_t len, ipc_bench_stat_t* stat) {
+    uint32_t start;
+
+    for (size_t i = 0; i < IPC_BENCH_LOOPS; ++i) {
+        start = CYCCNT_GET();
+        ringbuff_write(tx, bench_buf, len);
+        while (ringbuff_get_full(tx) > 0) {}
+        prv_stat_add(stat, CYCCNT_GET() - start);
+    }
+}
+
+/**
+ * \brief           Measure round-trip latency, message echoed by CPU2
+ * \param[in]       tx: Buffer to CPU2
+ * \param[in]       rx: Buffer from CPU2
+ * \param[in]       len: Message length
+ * \param[out]      stat: Statistics
+ */
+static void
+prv_measure_rtt(ringbuff_t* tx, ringbuff_t* rx, size_t len, ipc_bench_stat_t* stat) {
+    uint32_t start;
+
+    for (size_t i = 0; i < IPC_BENCH_LOOPS; ++i) {
+        start = CYCCNT_GET();
+        ringbuff_write(tx, bench_buf, len);
+        prv_read_all(rx, bench_buf, len);
+        prv_stat_add(stat, CYCCNT_GET() - start);
+    }
+}
+
+/**
+ * \brief           Measure sustained throughput, \ref IPC_BENCH_TPUT_LEN bytes
+ *                  written in messages while CPU2 reads
+ * \param[in]       tx: Buffer to CPU2
+ * \param[in]       len: Message length
+ * \return          Throughput in units of `10 kB/s`, `MB/s * 100`
+ */
+static uint32_t
+prv_measure_tput(ringbuff_t* tx, size_t len) {
+    uint32_t start, cycles;
+
+    start = CYCCNT_GET();
+    for (size_t sent = 0; sent < IPC_BENCH_TPUT_LEN; sent += len) {
+        prv_write_all(tx, bench_buf, len);
+    }
+    while (ringbuff_get_full(tx) > 0) {}
+    cycles = CYCCNT_GET() - start;
+    if (cycles == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)IPC_BENCH_TPUT_LEN * SystemCoreClock / 10000) / cycles);
+}
+
+#if RINGBUFF_USE_TRACE
+
+/**
+ * \brief           Measure cost of trace hook, \ref RINGBUFF_TRACE.
+ *                  Emits \ref IPC_BENCH_LOOPS read events of `0` bytes
+ * \param[in]       rb: Buffer handle
+ * \return          Average number of cycles per event
+ */
+static uint32_t
+prv_measure_trace(ringbuff_t* rb) {
+    uint32_t start, cycles;
+
+    start = CYCCNT_GET();
+    for (size_t i = 0; i < IPC_BENCH_LOOPS; ++i) {
+        RINGBUFF_TRACE(rb, RINGBUFF_EVT_READ, 0);
+    }
+    cycles = CYCCNT_GET() - start;
+    return cycles / IPC_BENCH_LOOPS;
+}
+
+#endif /* RINGBUFF_USE_TRACE */
+
+/**
+ * \brief           Run pipe benchmark on CPU1, CPU2 must run \ref ipc_bench_serve
+ *
+ * Sweeps message length from `1` byte to \ref IPC_BENCH_MAX_LEN bytes and reports
+ *
+ * - `oneway`: time from start of \ref ringbuff_write until CPU2 read whole message,
+ *      observed by CPU1 as empty buffer. Core cycle counters are not synchronized,
+ *      latency is measured on CPU1 only and includes propagation of read pointer back to CPU1
+ * - `rtt`: time from start of write until message echoed by CPU2 was read back
+ * - `tput`: sustained throughput of \ref IPC_BENCH_TPUT_LEN bytes
+ *
+ * Both cores poll buffers, doorbells are not used.
+ * First report line lists build configuration, compare builds with different settings.
+ * With \ref RINGBUFF_USE_TRACE, second line reports cycles spent in trace hook per event
+ *
+ * \param[in]       tx: Buffer to CPU2, empty
+ * \param[in]       rx: Buffer from CPU2, empty
+ * \param[in]       out_fn: Output function for report lines
+ */
+void
+ipc_bench_run(ringbuff_t* tx, ringbuff_t* rx, ipc_bench_out_fn out_fn) {
+    ipc_bench_stat_t stat;
+    char str[96];
+    uint32_t tput;
+    int n;
+
+    CYCCNT_INIT();
+    for (size_t i = 0; i < sizeof(bench_buf); ++i) {
+        bench_buf[i] = (uint8_t)i;
+    }
+    n = sprintf(str, "[BENCH] spsc:%u pow2:%u cache:%u maint:%u clk:%u MHz\r\n",
+                (unsigned)RINGBUFF_USE_SPSC, (unsigned)RINGBUFF_USE_POW2, (unsigned)SHD_RAM_DATA_CACHE,
+                (unsigned)IPC_CHAN_CACHE_MAINT, (unsigned)CYCCNT_PER_US());
+    out_fn(str, n);
+#if RINGBUFF_USE_TRACE
+    /* Cost of trace hook per event, with events actually emitted when port is enabled */
+    n = sprintf(str, "[BENCH] trace port:%u en:%u %u cyc/evt\r\n", (unsigned)RINGBUFF_TRACE_PORT,
+                (unsigned)((ITM->TER >> RINGBUFF_TRACE_PORT) & 0x01), (unsigned)prv_measure_trace(tx));
+    out_fn(str, n);
+#endif /* RINGBUFF_USE_TRACE */
+
+    for (size_t len = 1; len <= IPC_BENCH_MAX_LEN; len <<= 1) {
+        /* One-way latency */
+        stat = (ipc_bench_stat_t){ UINT32_MAX, 0, 0 };
+        if (!prv_command(tx, rx, IPC_BENCH_MODE_DISCARD, len, len * IPC_BENCH_LOOPS)) {
+            break;
+        }
+        prv_measure_oneway(tx, len, &stat);
+        prv_report_lat(out_fn, "oneway", len, &stat);
+
+        /* Round-trip latency */
+        stat = (ipc_bench_stat_t){ UINT32_MAX, 0, 0 };
+        if (!prv_command(tx, rx, IPC_BENCH_MODE_ECHO, len, len * IPC_BENCH_LOOPS)) {
+            break;
+        }
+        prv_measure_rtt(tx, rx, len, &stat);
+        prv_report_lat(out_fn, "rtt", len, &stat);
+
+        /* Throughput */
+        if (!prv_command(tx, rx, IPC_BENCH_MODE_DISCARD, len, IPC_BENCH_TPUT_LEN)) {
+            break;
+        }
+        tput = prv_measure_tput(tx, len);
+        n = sprintf(str, "[BENCH] tput len:%u %u.%02u MB/s\r\n",
+                    (unsigned)len, (unsigned)(tput / 100), (unsigned)(tput % 100));
+        out_fn(str, n);
+    }
+    if (!prv_command(tx, rx, IPC_BENCH_MODE_DONE, 0, 0)) {
+        out_fn("[BENCH] CPU2 not responding\r\n", 29);
+    }
+}
+
+/**
+ * \brief           Measure RPC round trip on CPU1, after \ref ipc_bench_run
+ *
+ * Calls \ref IPC_RPC_METHOD_ECHO synchronously with arguments from `4` bytes to \ref IPC_RPC_MAX_LEN bytes
+ * and reports `rpc` latency, from start of \ref ipc_rpc_call until result was copied back.
+ * Unlike pipe benchmark, CPU2 serves calls from its application loop,
+ * round trip therefore includes both doorbells and wake-up of CPU2 from `WFI`
+ *
+ * \param[in]       cli: RPC client, responses are not polled by other context
+ * \param[in]       out_fn: Output function for report lines
+ */
+void
+ipc_bench_rpc(ipc_rpc_client_t* cli, ipc_bench_out_fn out_fn) {
+    ipc_bench_stat_t stat;
+    uint32_t start, cycles;
+    size_t res_len;
+
+    /* First call synchronizes with CPU2 */
+    if (ipc_rpc_call(cli, IPC_RPC_METHOD_ECHO, bench_buf, 4, NULL, 0, NULL, IPC_BENCH_RPC_TIMEOUT_US) != IPC_RPC_OK) {
+        out_fn("[BENCH] rpc CPU2 not responding\r\n", 33);
+        return;
+    }
+    for (size_t len = 4; len <= IPC_RPC_MAX_LEN; len <<= 1) {
+        stat = (ipc_bench_stat_t){ UINT32_MAX, 0, 0 };
+        for (size_t i = 0; i < IPC_BENCH_LOOPS; ++i) {
+            start = CYCCNT_GET();
+            if (ipc_rpc_call(cli, IPC_RPC_METHOD_ECHO, bench_buf, len, &bench_buf[IPC_RPC_MAX_LEN],
+                                IPC_RPC_MAX_LEN, &res_len, IPC_BENCH_RPC_TIMEOUT_US) != IPC_RPC_OK
+                || res_len != len) {
+                out_fn("[BENCH] rpc call failed\r\n", 25);
+                return;
+            }
+            cycles = CYCCNT_GET() - start;
+            prv_stat_add(&stat, cycles);
+        }
+        prv_report_lat(out_fn, "rpc", len, &stat);
+    }
+}
+
+#if IPC_RPMSG
+
+/* Echoes received by benchmark endpoint */
+static volatile uint32_t rpmsg_echoed;
+
+/**
+ * \brief           Benchmark endpoint receive callback, counts echoes
+ * \param[in]       ept: Endpoint
+ * \param[in]       data: Payload
+ * \param[in]       len: Payload length in units of bytes
+ * \param[in]       src: Address of CPU2 echo endpoint
+ * \param[in]       priv: Private data
+ * \return          \ref RPMSG_SUCCESS
+ */
+static int
+prv_rpmsg_cb(struct rpmsg_endpoint* ept, void* data, size_t len, uint32_t src, void* priv) {
+    (void)ept;
+    (void)data;
+    (void)len;
+    (void)src;
+    (void)priv;
+    ++rpmsg_echoed;
+    return RPMSG_SUCCESS;
+}
+
+/**
+ * \brief           Deliver messages until number of echoes was received
+ * \param[in]       rdev: Device
+ * \param[in]       echoed: Expected value of \ref rpmsg_echoed
+ * \return          `1` on success, `0` on timeout
+ */
+static uint8_t
+prv_rpmsg_wait(struct rpmsg_device* rdev, uint32_t echoed) {
+    ipc_wait_t w;
+
+    ipc_wait_start(&w, IPC_BENCH_RPC_TIMEOUT_US);
+    while (rpmsg_echoed != echoed) {
+        ipc_rpmsg_poll(rdev);
+        if (ipc_wait_expired(&w)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * \brief           Measure RPMsg endpoint round trip on CPU1, after \ref ipc_bench_rpc
+ *
+ * Creates endpoint with \ref IPC_RPMSG_ECHO_NAME, bound by name service to CPU2 echo endpoint, and reports
+ *
+ * - `rpmsg`: time from start of \ref rpmsg_send until echo was delivered to endpoint callback
+ * - `rpmsg-nocopy`: same with \ref rpmsg_get_tx_payload_buffer and \ref rpmsg_send_nocopy,
+ *      payload is not written, as when application builds it in place
+ * - `rpmsg echo tput`: throughput of \ref IPC_BENCH_TPUT_LEN bytes in messages of \ref RPMSG_BUFFER_PAYLOAD bytes,
+ *      pipelined, every message echoed by CPU2
+ *
+ * CPU2 echoes from its application loop after doorbell, as `rpc`.
+ * Compare with `rtt` and `rpc` lines of the same report, and with numbers of OpenAMP virtio transport
+ * measured with the same endpoint code, which is not part of this repository
+ *
+ * \param[in]       rdev: Device, messages are not polled by other context
+ * \param[in]       out_fn: Output function for report lines
+ */
+void
+ipc_bench_rpmsg(struct rpmsg_device* rdev, ipc_bench_out_fn out_fn) {
+    static const size_t lens[] = { 16, 64, 256, RPMSG_BUFFER_PAYLOAD };
+    struct rpmsg_endpoint ept;
+    ipc_rpmsg_stats_t st;
+    ipc_bench_stat_t stat;
+    uint32_t start, cycles, tput, size, base, count, sent;
+    ipc_wait_t w;
+    uint8_t* buf;
+    char str[96];
+    int n;
+
+    if (rpmsg_create_ept(&ept, rdev, IPC_RPMSG_ECHO_NAME, RPMSG_ADDR_ANY, RPMSG_ADDR_ANY,
+                            prv_rpmsg_cb, NULL) != RPMSG_SUCCESS) {
+        out_fn("[BENCH] rpmsg endpoint failed\r\n", 31);
+        return;
+    }
+
+    /* CPU2 announced its endpoint at boot */
+    ipc_wait_start(&w, IPC_BENCH_RPC_TIMEOUT_US);
+    while (!is_rpmsg_ept_ready(&ept)) {
+        ipc_rpmsg_poll(rdev);
+        if (ipc_wait_expired(&w)) {
+            out_fn("[BENCH] rpmsg CPU2 not responding\r\n", 35);
+            rpmsg_destroy_ept(&ept);
+            return;
+        }
+    }
+
+    for (size_t k = 0; k < sizeof(lens) / sizeof(lens[0]); ++k) {
+        /* Payload copied to channel */
+        stat = (ipc_bench_stat_t){ UINT32_MAX, 0, 0 };
+        for (size_t i = 0; i < IPC_BENCH_LOOPS; ++i) {
+            start = CYCCNT_GET();
+            if (rpmsg_send(&ept, bench_buf, (int)lens[k]) < 0 || !prv_rpmsg_wait(rdev, rpmsg_echoed + 1)) {
+                out_fn("[BENCH] rpmsg send failed\r\n", 27);
+                rpmsg_destroy_ept(&ept);
+                return;
+            }
+            prv_stat_add(&stat, CYCCNT_GET() - start);
+        }
+        prv_report_lat(out_fn, "rpmsg", lens[k], &stat);
+
+        /* Payload buffer in channel memory */
+        stat = (ipc_bench_stat_t){ UINT32_MAX, 0, 0 };
+        for (size_t i = 0; i < IPC_BENCH_LOOPS; ++i) {
+            start = CYCCNT_GET();
+            if ((buf = rpmsg_get_tx_payload_buffer(&ept, &size, 1)) == NULL
+                || rpmsg_send_nocopy(&ept, buf, (int)lens[k]) < 0 || !prv_rpmsg_wait(rdev, rpmsg_echoed + 1)) {
+                out_fn("[BENCH] rpmsg send failed\r\n", 27);
+                rpmsg_destroy_ept(&ept);
+                return;
+            }
+            prv_stat_add(&stat, CYCCNT_GET() - start);
+        }
+        prv_report_lat(out_fn, "rpmsg-nocopy", lens[k], &stat);
+    }
+
+    /* Pipelined echo, CPU1 keeps channel to CPU2 filled while it receives echoes */
+    count = IPC_BENCH_TPUT_LEN / RPMSG_BUFFER_PAYLOAD;
+    base = rpmsg_echoed;
+    sent = 0;
+    ipc_wait_start(&w, IPC_BENCH_RPC_TIMEOUT_US * 10);
+    start = CYCCNT_GET();
+    while (rpmsg_echoed - base < count) {
+        if (sent < count && rpmsg_trysend(&ept, bench_buf, RPMSG_BUFFER_PAYLOAD) > 0) {
+            ++sent;
+        }
+        ipc_rpmsg_poll(rdev);
+        if (ipc_wait_expired(&w)) {
+            break;
+        }
+    }
+    cycles = CYCCNT_GET() - start;
+    tput = cycles > 0 ? (uint32_t)(((uint64_t)(rpmsg_echoed - base) * RPMSG_BUFFER_PAYLOAD * SystemCoreClock / 10000) / cycles) : 0;
+    n = sprintf(str, "[BENCH] rpmsg echo tput len:%u %u.%02u MB/s\r\n",
+                (unsigned)RPMSG_BUFFER_PAYLOAD, (unsigned)(tput / 100), (unsigned)(tput % 100));
+    out_fn(str, n);
+
+    /* Messages staged in core-local memory, at end of channel */
+    ipc_rpmsg_get_stats(rdev, &st);
+    n = sprintf(str, "[BENCH] rpmsg sent:%u tx_copies:%u rx_copies:%u dropped:%u\r\n",
+                (unsigned)st.sent, (unsigned)st.tx_copies, (unsigned)st.rx_copies, (unsigned)st.dropped);
+    out_fn(str, n);
+    rpmsg_destroy_ept(&ept);
+}
+
+#endif /* IPC_RPMSG */
+
+/**
+ * \brief           Serve pipe benchmark on CPU2, returns when CPU1 finished
+ *
+ * Waits for commands from CPU1, acknowledges each and then
+ * drops or echoes number of bytes given by command
+ *
+ * \param[in]       rx: Buffer from CPU1
+ * \param[in]       tx: Buffer to CPU1
+ */
+void
+ipc_bench_serve(ringbuff_t* rx, ringbuff_t* tx) {
+    ipc_bench_cmd_t cmd;
+    size_t len;
+
+    while (1) {
+        prv_read_all(rx, &cmd, sizeof(cmd));
+        if (cmd.magic != IPC_BENCH_CMD_MAGIC || cmd.msg_len > IPC_BENCH_MAX_LEN) {
+            return;
+        }
+        prv_write_all(tx, &cmd, sizeof(cmd));
+        switch (cmd.mode) {
+            case IPC_BENCH_MODE_DISCARD:
+                while (cmd.total > 0) {
+                    len = ringbuff_read(rx, bench_buf, cmd.total > sizeof(bench_buf) ? sizeof(bench_buf) : cmd.total);
+                    cmd.total -= len;
+                }
+                break;
+            case IPC_BENCH_MODE_ECHO:
+                while (cmd.total > 0) {
+                    prv_read_all(rx, bench_buf, cmd.msg_len);
+                    prv_write_all(tx, bench_buf, cmd.msg_len);
+                    cmd.total -= cmd.msg_len;
+                }
+                break;
+            default:
+                return;
+        }
+    }
+}
+
+#endif /* IPC_BENCH */
@@ -0,0 +1,227 @@
+/**
+ * \file            ipc_blog.c
+ * \brief           Deferred binary log
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_blog.h"
+
+/*
+ * CPU2 writes format string address, timestamp and raw arguments, 12 bytes plus 4 bytes per argument.
+ * Formatting is done by CPU1 or by host tool which reads strings from CPU2 image (ELF file).
+ * CPU1 reads format strings directly, CPU2 flash is mapped at the same address for both cores
+ */
+
+#if IPC_BLOG
+
+/* CPU2 flash, FLASH region of CPU2 linker script */
+#define IPC_BLOG_FLASH_START                0x08100000
+#define IPC_BLOG_FLASH_LEN                  0x00100000
+#define IPC_BLOG_IN_FLASH(addr)             ((uint32_t)(addr) - IPC_BLOG_FLASH_START < IPC_BLOG_FLASH_LEN)
+
+/* Conversion characters of format specification */
+#define IPC_BLOG_CONV                       "diouxXcsp%"
+
+/* Record length in units of bytes */
+#define IPC_BLOG_REC_LEN(nargs)             ((3 + (nargs)) * sizeof(uint32_t))
+
+/* Log buffer of producer */
+static RINGBUFF_VOLATILE ringbuff_t* blog_rb;
+
+/* Number of records dropped as buffer did not have enough free memory */
+static uint32_t dropped;
+
+/**
+ * \brief           Set buffer for records, called by CPU2
+ * \param[in]       rb: Producer buffer handle
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_blog_init(RINGBUFF_VOLATILE ringbuff_t* rb) {
+    if (!ringbuff_is_ready(rb)) {
+        return 0;
+    }
+    blog_rb = rb;
+    return 1;
+}
+
+/**
+ * \brief           Write record to buffer, use \ref IPC_LOG macro instead.
+ *
+ * Record is written in full or dropped when buffer does not have enough free memory,
+ * same rules as for \ref ringbuff_write apply
+ *
+ * \param[in]       fmt: Format string in flash
+ * \param[in]       args: Arguments
+ * \param[in]       nargs: Number of arguments
+ * \return          Number of bytes written, `0` when dropped
+ */
+size_t
+ipc_blog_write(const char* fmt, const uint32_t* args, size_t nargs) {
+    uint32_t hdr[3];
+    ringbuff_iovec_t iov[2];
+
+    if (blog_rb == NULL || nargs > IPC_BLOG_MAX_ARGS) {
+        return 0;
+    }
+    hdr[0] = ((uint32_t)IPC_BLOG_SYNC << 24) | (uint32_t)nargs;
+    hdr[1] = (uint32_t)fmt;
+    hdr[2] = HAL_GetTick();
+    iov[0].data = hdr;
+    iov[0].len = sizeof(hdr);
+    iov[1].data = args;
+    iov[1].len = nargs * sizeof(uint32_t);
+    if (ringbuff_writev(blog_rb, iov, nargs > 0 ? 2 : 1) == 0) {
+        ++dropped;
+        return 0;
+    }
+    return IPC_BLOG_REC_LEN(nargs);
+}
+
+/**
+ * \brief           Get number of records dropped due to full buffer
+ * \return          Number of dropped records since startup
+ */
+uint32_t
+ipc_blog_get_dropped(void) {
+    return dropped;
+}
+
+/**
+ * \brief           Read one record, called by CPU1
+ *
+ * Words without valid header are skipped, decoder then
+ * continues with next record
+ *
+ * \param[in]       rb: Consumer buffer handle
+ * \param[out]      rec: Record
+ * \return          `1` when record was read, `0` when buffer is empty
+ */
+uint8_t
+ipc_blog_read(RINGBUFF_VOLATILE ringbuff_t* rb, ipc_blog_rec_t* rec) {
+    size_t nargs;
+
+    while (ringbuff_peek(rb, 0, rec, IPC_BLOG_REC_LEN(0)) == IPC_BLOG_REC_LEN(0)) {
+        nargs = rec->hdr & 0xFF;
+        if ((rec->hdr >> 24) != IPC_BLOG_SYNC || nargs > IPC_BLOG_MAX_ARGS) {
+            ringbuff_skip(rb, sizeof(uint32_t));
+            continue;
+        }
+        if (ringbuff_get_full(rb) < IPC_BLOG_REC_LEN(nargs)) {
+            return 0;                           /* Records are written in full, not expected */
+        }
+        ringbuff_read(rb, rec, IPC_BLOG_REC_LEN(nargs));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Advance output position by `snprintf` result, output is truncated at end of memory
+ * \param[in]       pos: Current position
+ * \param[in]       n: Return value of `snprintf`
+ * \param[in]       len: Length of output memory in units of bytes
+ * \return          New position
+ */
+static size_t
+prv_advance(size_t pos, int n, size_t len) {
+    if (n <= 0) {
+        return pos;
+    }
+    return pos + (size_t)n < len ? pos + (size_t)n : len - 1;
+}
+
+/**
+ * \brief           Render record to text, with `[s.ms] ` timestamp prefix
+ *
+ * Conversions of format string are done with `snprintf` one at a time,
+ * each takes one 32-bit argument. `%s` argument outside CPU2 flash is rendered as `(?)`
+ *
+ * \param[in]       rec: Record from \ref ipc_blog_read
+ * \param[out]      str: Output string, always `0` terminated
+ * \param[in]       len: Length of output memory in units of bytes
+ * \return          Length of text, without `0` termination
+ */
+size_t
+ipc_blog_render(const ipc_blog_rec_t* rec, char* str, size_t len) {
+    const char* fmt = (const char *)rec->fmt;
+    size_t nargs = rec->hdr & 0xFF, arg = 0, pos, spec_len;
+    char spec[16];
+    int n;
+
+    if (len == 0) {
+        return 0;
+    }
+    n = snprintf(str, len, "[%u.%03u] ", (unsigned)(rec->stamp / 1000), (unsigned)(rec->stamp % 1000));
+    pos = prv_advance(0, n, len);
+    if (!IPC_BLOG_IN_FLASH(fmt)) {
+        n = snprintf(&str[pos], len - pos, "(?) %08X", (unsigned)rec->fmt);
+        return prv_advance(pos, n, len);
+    }
+
+    while (*fmt != '\0' && pos < len - 1) {
+        if (*fmt != '%') {
+            str[pos++] = *fmt++;
+            continue;
+        }
+
+        /* Copy single conversion specification, flags, width and length modifier */
+        spec_len = 0;
+        spec[spec_len++] = *fmt++;
+        while (*fmt != '\0' && strchr(IPC_BLOG_CONV, *fmt) == NULL && spec_len < sizeof(spec) - 2) {
+            spec[spec_len++] = *fmt++;
+        }
+        if (*fmt == '\0' || strchr(IPC_BLOG_CONV, *fmt) == NULL) {
+            break;                              /* Incomplete or invalid specification */
+        }
+        spec[spec_len++] = *fmt++;
+        spec[spec_len] = '\0';
+
+        if (spec[spec_len - 1] == '%') {
+            n = snprintf(&str[pos], len - pos, "%%");
+        } else if (arg >= nargs) {
+            n = snprintf(&str[pos], len - pos, "(?)");
+        } else if (spec[spec_len - 1] == 's') {
+            const char* s = IPC_BLOG_IN_FLASH(rec->args[arg]) ? (const char *)rec->args[arg] : "(?)";
+
+            n = snprintf(&str[pos], len - pos, spec, s);
+            ++arg;
+        } else {
+            n = snprintf(&str[pos], len - pos, spec, (unsigned)rec->args[arg]);
+            ++arg;
+        }
+        pos = prv_advance(pos, n, len);
+    }
+    str[pos] = '\0';
+    return pos;
+}
+
+#endif /* IPC_BLOG */
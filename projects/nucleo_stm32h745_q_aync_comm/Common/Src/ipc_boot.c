@@ -0,0 +1,168 @@
+/**
+ * \file            ipc_boot.c
+ * \brief           Boot handshake of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_boot.h"
+#include "ipc_chan.h"
+#include "ipc_notify.h"
+#include "ipc_wait.h"
+
+/*
+ * Both cores initialize in parallel, CPU2 runs HAL_Init while CPU1 configures clocks and channels.
+ *
+ * Stale boot record from before reset must never be taken as valid, hardware semaphores are reset with system:
+ *
+ * - CPU2 listens on HSEM_BOOT_CPU1 and then takes HSEM_BOOT_CPU2, which tells CPU1 it is alive and listening
+ * - CPU1 writes boot record, advances its stage and rings HSEM_BOOT_CPU1 once CPU2 is alive.
+ *      Before it publishes channel directory stage it waits for CPU2 to be alive, so CPU2 never misses it
+ * - CPU2 reads boot record only after it was notified in current boot, verifies ABI and layout hash,
+ *      attaches to channels and releases HSEM_BOOT_CPU2, which notifies CPU1
+ * - After CPU1 reset CPU2 alone, see ipc_peer.c, boot record stays valid and CPU1 replays channel stage
+ */
+
+_Static_assert(HSEM_BOOT_CPU2 < IPC_NOTIFY_SEM_COUNT, "Boot semaphore does not fit to hardware semaphores");
+
+#define IPC_BOOT_SHARED                     (&IPC_SHM->ctrl.boot)
+
+#if defined(CORE_CM7)
+#define IPC_BOOT_CORE                       IPC_BOOT_CPU1
+#define IPC_BOOT_SEM_OWN                    HSEM_BOOT_CPU1
+#define IPC_BOOT_SEM_PEER                   HSEM_BOOT_CPU2
+#else
+#define IPC_BOOT_CORE                       IPC_BOOT_CPU2
+#define IPC_BOOT_SEM_OWN                    HSEM_BOOT_CPU2
+#define IPC_BOOT_SEM_PEER                   HSEM_BOOT_CPU1
+#endif
+
+/* Incremented from HSEM interrupt each time other core advanced its stage in current boot */
+static volatile uint32_t boot_evts;
+
+/**
+ * \brief           Other core advanced stage, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: User argument
+ */
+static void
+prv_boot_notify(uint32_t sem_id, void* arg) {
+    boot_evts = boot_evts + 1;
+}
+
+/**
+ * \brief           Start boot handshake, first call of both cores after reset.
+ *
+ * CPU1 calls it before it starts CPU2 and writes boot record.
+ * CPU2 calls it before HAL_Init, notification is delivered once HSEM interrupt is enabled
+ */
+void
+ipc_boot_start(void) {
+    __HAL_RCC_HSEM_CLK_ENABLE();
+    ipc_notify_listen(IPC_BOOT_SEM_PEER, prv_boot_notify, NULL);
+#if defined(CORE_CM7)
+    {
+        volatile ipc_boot_shared_t* boot = IPC_BOOT_SHARED;
+
+        boot->stage[IPC_BOOT_CPU1] = IPC_BOOT_STAGE_NONE;
+        boot->magic = IPC_BOOT_MAGIC;
+        boot->abi = IPC_BOOT_ABI;
+        boot->layout_hash = ipc_chan_layout_hash();
+        __DMB();
+        boot->stage[IPC_BOOT_CPU1] = IPC_BOOT_STAGE_STARTED;
+    }
+#else
+    HAL_HSEM_FastTake(HSEM_BOOT_CPU2);          /* Alive, listening on HSEM_BOOT_CPU1 */
+#endif /* defined(CORE_CM7) */
+}
+
+/**
+ * \brief           Advance stage of current core and notify other core
+ *
+ * CPU1 waits for CPU2 to be alive before \ref IPC_BOOT_STAGE_CHANNELS, other stages are notified when it is alive already.
+ * CPU2 notifies \ref IPC_BOOT_STAGE_ATTACHED by release of its alive semaphore
+ *
+ * \param[in]       stage: New stage
+ */
+void
+ipc_boot_advance(ipc_boot_stage_t stage) {
+    volatile ipc_boot_shared_t* boot = IPC_BOOT_SHARED;
+
+    __DMB();                                    /* Stage data before stage */
+    boot->stage[IPC_BOOT_CORE] = stage;
+    __DSB();
+#if defined(CORE_CM7)
+    if (stage >= IPC_BOOT_STAGE_CHANNELS) {
+        WAIT_COND_WITH_TIMEOUT_US(!HAL_HSEM_IsSemTaken(HSEM_BOOT_CPU2), IPC_BOOT_TIMEOUT_US);
+    }
+    if (HAL_HSEM_IsSemTaken(HSEM_BOOT_CPU2)) {
+        HSEM_TAKE_RELEASE(HSEM_BOOT_CPU1);
+    }
+#else
+    HAL_HSEM_Release(HSEM_BOOT_CPU2, 0);
+#endif /* defined(CORE_CM7) */
+}
+
+/**
+ * \brief           Wait until other core reached stage in current boot.
+ *                  Core sleeps until notified, HSEM interrupt and SysTick must be enabled
+ * \param[in]       core: Core to wait for, \ref IPC_BOOT_CPU1 or \ref IPC_BOOT_CPU2
+ * \param[in]       stage: Stage to wait for
+ * \param[in]       timeout_us: Timeout in units of microseconds
+ * \return          `1` when stage was reached and boot record matches this image, `0` on timeout or mismatch
+ */
+uint8_t
+ipc_boot_wait(uint32_t core, ipc_boot_stage_t stage, uint32_t timeout_us) {
+    volatile ipc_boot_shared_t* boot = IPC_BOOT_SHARED;
+    ipc_wait_t wait;
+    uint32_t evts;
+
+    if (core == IPC_BOOT_CORE || core > IPC_BOOT_CPU2) {
+        return 0;
+    }
+    ipc_wait_start_tick(&wait, timeout_us);
+    while (1) {
+        /* Boot record is read only once other core notified in current boot */
+        evts = boot_evts;
+        if (evts > 0 && boot->stage[core] >= stage) {
+            break;
+        }
+        if (ipc_wait_expired(&wait)) {
+            return 0;
+        }
+
+        /* Sleep until next notification or systick */
+        __disable_irq();
+        if (boot_evts == evts) {
+            __WFI();
+        }
+        __enable_irq();
+    }
+    __DMB();                                    /* Stage before stage data */
+    return boot->magic == IPC_BOOT_MAGIC && boot->abi == IPC_BOOT_ABI && boot->layout_hash == ipc_chan_layout_hash();
+}
@@ -0,0 +1,549 @@
+/**
+ * \file            ipc_chan.c
+ * \brief           Channel directory in shared memory
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_chan.h"
+#include "ipc_heap.h"
+
+#include <stddef.h>
+
+/*
+ * Shared RAM layout, only object in `.shared_ram` NOLOAD section of both images.
+ * Linker script asserts it starts at SRAM4 origin and fails on overflow
+ */
+ipc_shm_t ipc_shm __attribute__((section(".shared_ram")));
+
+/* Layouts of channel data placed outside SRAM4, only objects in `.shared_axi` and `.shared_d2` sections */
+ipc_shm_axi_t ipc_shm_axi __attribute__((section(".shared_axi")));
+ipc_shm_d2_t ipc_shm_d2 __attribute__((section(".shared_d2")));
+
+/* Directory at the beginning of shared RAM */
+#define IPC_CHAN_DIR                        (&IPC_SHM->ctrl.dir)
+
+/* Layout checks */
+_Static_assert(IPC_CHAN_COUNT <= IPC_CHAN_MAX, "Too many channels in IPC_CHAN_TABLE");
+_Static_assert(sizeof(ipc_shm_ctrl_t) <= IPC_SHM_CTRL_LEN, "Directory and channel pointers do not fit to control part");
+_Static_assert((IPC_SHM_CTRL_LEN & (IPC_SHM_CTRL_LEN - 1)) == 0, "Control part length must be power of 2, CPU1 MPU region size");
+_Static_assert((IPC_SHM_NC_LEN & (IPC_SHM_NC_LEN - 1)) == 0 && IPC_SHM_NC_LEN >= IPC_SHM_CTRL_LEN, "Non-cacheable part length must be power of 2, CPU1 MPU region size");
+_Static_assert(IPC_SHM_FIXED_LEN + IPC_CHAN_MIN_SUM <= SHD_RAM_LEN, "Minimum channel lengths do not fit to shared RAM");
+_Static_assert(sizeof(ipc_shm_t) <= SHD_RAM_LEN - IPC_SHM_FREC_LEN, "Shared RAM layout overflows shared RAM");
+_Static_assert(sizeof(ipc_shm_axi_t) <= SHD_AXI_LEN, "AXI layout overflows SHD_AXI region");
+_Static_assert(sizeof(ipc_shm_d2_t) <= SHD_D2_LEN, "D2 layout overflows SHD_D2 region");
+_Static_assert(!IPC_RESIZE || IPC_CHAN_AWAY_COUNT == 0, "IPC_RESIZE re-carves SRAM4 only, all channel data must be in SRAM4");
+#define IPC_CHAN_X_ASSERT(name, min_len, weight, region)                                \
+    _Static_assert(IPC_CHAN_LEN_##name >= (min_len), "Channel " #name " is shorter than minimum length"); \
+    _Static_assert(!RINGBUFF_USE_POW2 || (IPC_CHAN_LEN_##name & (IPC_CHAN_LEN_##name - 1)) == 0, "Channel " #name " length is not power of 2"); \
+    _Static_assert(IPC_SHM_REGION(region) == SHD_REGION_SRAM4 || (weight) == 0, "Channel " #name " outside SRAM4 must have weight 0");
+IPC_CHAN_TABLE(IPC_CHAN_X_ASSERT)
+
+/**
+ * \brief           Location of channel in shared RAM layout
+ */
+typedef struct {
+    uint32_t shared_off;                        /*!< Offset of pointers */
+    uint32_t data_off;                          /*!< Offset of data in layout of its region */
+    uint32_t data_len;                          /*!< Data length */
+    uint32_t min_len;                           /*!< Minimum data length */
+    uint32_t region;                            /*!< Placement region of data, SHD_REGION_<region> */
+} ipc_chan_layout_t;
+
+/* Layout type of each placement region */
+#define IPC_CHAN_LAYOUT_SRAM4               ipc_shm_t
+#define IPC_CHAN_LAYOUT_AXI                 ipc_shm_axi_t
+#define IPC_CHAN_LAYOUT_D2                  ipc_shm_d2_t
+
+/* Layout of channels, indexed by channel ID */
+#define IPC_CHAN_X_LAYOUT(name, min_len, weight, region)                                \
+    { offsetof(ipc_shm_t, ctrl.shared_##name), offsetof(IPC_CHAN_LAYOUT_##region, data_##name), IPC_CHAN_LEN_##name, \
+        (min_len), IPC_SHM_REGION(region) },
+static const ipc_chan_layout_t chan_layout[] = {
+    IPC_CHAN_TABLE(IPC_CHAN_X_LAYOUT)
+};
+
+/* Start of layout of each placement region, indexed by SHD_REGION_<region> */
+static void* const region_base[] = {
+    [SHD_REGION_SRAM4] = &ipc_shm,
+    [SHD_REGION_AXI] = &ipc_shm_axi,
+    [SHD_REGION_D2] = &ipc_shm_d2,
+};
+
+#if RINGBUFF_USE_RATE
+/**
+ * \brief           Producer rate limit of channel
+ */
+typedef struct {
+    uint32_t rate;                              /*!< Average rate in units of bytes per second, `0` when not limited */
+    uint32_t burst;                             /*!< Bucket depth in units of bytes */
+} ipc_chan_rate_t;
+
+/* Rate limits, indexed by channel ID */
+#define IPC_RATE_X_LIMIT(name, rate, burst) [IPC_CHAN_##name] = { (rate), (burst) },
+static const ipc_chan_rate_t chan_rate[IPC_CHAN_COUNT] = {
+    IPC_RATE_TABLE(IPC_RATE_X_LIMIT)
+};
+#endif /* RINGBUFF_USE_RATE */
+
+#if IPC_RESIZE || IPC_SCAN
+/* Local handles of channels created or opened by this core, indexed by channel ID */
+static RINGBUFF_VOLATILE ringbuff_t* chan_rb[IPC_CHAN_MAX];
+#endif /* IPC_RESIZE || IPC_SCAN */
+
+#if IPC_RESIZE
+/* Resize handshake */
+#define IPC_CHAN_RESIZE                     (&IPC_SHM->ctrl.resize)
+
+/* Data of all channels, contiguous in layout, re-carved on resize */
+#define IPC_CHAN_DATA_START                 (chan_layout[0].data_off)
+#define IPC_CHAN_DATA_END                   (chan_layout[IPC_CHAN_COUNT - 1].data_off + chan_layout[IPC_CHAN_COUNT - 1].data_len)
+
+#if !defined(CORE_CM7)
+/* Generation CPU2 handles are attached to */
+static uint32_t resize_gen;
+#endif /* !defined(CORE_CM7) */
+#endif /* IPC_RESIZE */
+
+/**
+ * \brief           Set up local handle after it was attached to channel memory
+ * \param[in]       id: Channel ID
+ * \param[in]       rb: Local buffer handle
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_handle_setup(uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb) {
+#if RINGBUFF_USE_TRACE
+    ringbuff_set_trace_id(rb, (uint8_t)id);     /* Channel ID identifies buffer in trace of both cores */
+#endif /* RINGBUFF_USE_TRACE */
+#if IPC_RESIZE || IPC_SCAN
+    chan_rb[id] = rb;
+#endif /* IPC_RESIZE || IPC_SCAN */
+#if RINGBUFF_USE_RATE
+    if (id < IPC_CHAN_COUNT && chan_rate[id].rate > 0) {
+        ringbuff_set_rate(rb, chan_rate[id].rate, chan_rate[id].burst);
+    }
+#endif /* RINGBUFF_USE_RATE */
+#if IPC_CHAN_CACHE_MAINT
+    return ringbuff_set_cache_maint(rb, 1);
+#else
+    (void)id;
+    (void)rb;
+    return 1;
+#endif /* IPC_CHAN_CACHE_MAINT */
+}
+
+/**
+ * \brief           Reset channel directory, all channels are removed.
+ *                  Called by CPU1 before other core is started
+ */
+void
+ipc_chan_dir_init(void) {
+    volatile ipc_chan_dir_t* dir = IPC_CHAN_DIR;
+
+    dir->magic = 0;
+    for (size_t i = 0; i < IPC_CHAN_MAX; ++i) {
+        dir->entries[i].shared_addr = 0;
+        dir->entries[i].data_addr = 0;
+        dir->entries[i].data_len = 0;
+        dir->entries[i].sem_id = 0;
+    }
+    dir->layout_len = sizeof(ipc_shm_t);
+#if IPC_RESIZE
+    IPC_CHAN_RESIZE->req = 0;
+    IPC_CHAN_RESIZE->ack = 0;
+    IPC_CHAN_RESIZE->done = 0;
+#endif /* IPC_RESIZE */
+#if IPC_LAT
+    ipc_lat_reset();
+#endif /* IPC_LAT */
+#if IPC_PUBSUB
+    ipc_topic_reset();
+#endif /* IPC_PUBSUB */
+#if IPC_PP
+    ipc_pp_reset();
+#endif /* IPC_PP */
+#if IPC_MPMC
+    ipc_mpmc_reset();
+#endif /* IPC_MPMC */
+#if IPC_STEAL
+    ipc_steal_reset();
+#endif /* IPC_STEAL */
+#if IPC_SOAK
+    ipc_soak_reset();
+#endif /* IPC_SOAK */
+#if IPC_HEAP
+    ipc_heap_init();
+#endif /* IPC_HEAP */
+}
+
+/**
+ * \brief           Create channel at its place in shared RAM layout,
+ *                  initialize its pointers and local handle
+ * \param[in]       id: Channel ID from \ref ipc_chan_id_t
+ * \param[in]       rb: Local buffer handle of CPU1
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_chan_create(uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb) {
+    volatile ipc_chan_dir_t* dir = IPC_CHAN_DIR;
+    uint32_t shared_addr, data_addr;
+
+    if (id >= IPC_CHAN_COUNT || dir->entries[id].shared_addr != 0) {
+        return 0;
+    }
+
+    shared_addr = (uint32_t)IPC_SHM + chan_layout[id].shared_off;
+    data_addr = (uint32_t)region_base[chan_layout[id].region] + chan_layout[id].data_off;
+    if (!ringbuff_init_shared(rb, (void *)shared_addr, (void *)data_addr, chan_layout[id].data_len)
+        || !prv_handle_setup(id, rb)) {
+        return 0;
+    }
+
+    dir->entries[id].data_addr = data_addr;
+    dir->entries[id].data_len = chan_layout[id].data_len;
+    dir->entries[id].sem_id = HSEM_CHAN(id);
+    dir->entries[id].shared_addr = shared_addr;
+    return 1;
+}
+
+/**
+ * \brief           Publish directory to other core, after all channels were created
+ */
+void
+ipc_chan_dir_publish(void) {
+    __DMB();                                    /* Entries before magic */
+    IPC_CHAN_DIR->magic = IPC_CHAN_DIR_MAGIC;
+    __DSB();
+}
+
+/**
+ * \brief           Check if directory was published by CPU1
+ * \return          `1` if ready, `0` otherwise
+ */
+uint8_t
+ipc_chan_dir_is_ready(void) {
+    uint8_t ready = IPC_CHAN_DIR->magic == IPC_CHAN_DIR_MAGIC;
+
+    __DMB();                                    /* Magic before entries */
+    return ready;
+}
+
+/**
+ * \brief           Attach local handle to channel found in directory
+ * \param[in]       id: Channel ID
+ * \param[in]       rb: Local buffer handle
+ * \return          `1` on success, `0` if directory is not ready, was built with different layout,
+ *                      or channel does not exist
+ */
+uint8_t
+ipc_chan_open(uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb) {
+    volatile ipc_chan_entry_t* e;
+
+    if (id >= IPC_CHAN_MAX || !ipc_chan_dir_is_ready()
+        || IPC_CHAN_DIR->layout_len != sizeof(ipc_shm_t)) {
+        return 0;
+    }
+    e = &IPC_CHAN_DIR->entries[id];
+    if (e->shared_addr == 0) {
+        return 0;
+    }
+    if (!ringbuff_attach(rb, (void *)e->shared_addr, (void *)e->data_addr, e->data_len)) {
+        return 0;
+    }
+    return prv_handle_setup(id, rb);
+}
+
+/**
+ * \brief           Get shared RAM layout hash, FNV-1a of layout size and location of all channels.
+ *                  Equal on both cores when images were built with the same layout
+ * \return          Layout hash
+ */
+uint32_t
+ipc_chan_layout_hash(void) {
+    uint32_t hash = 0x811C9DC5, len = sizeof(ipc_shm_t);
+
+    for (size_t i = 0; i < sizeof(len); ++i) {
+        hash = (hash ^ ((const uint8_t *)&len)[i]) * 0x01000193;
+    }
+    for (size_t i = 0; i < sizeof(chan_layout); ++i) {
+        hash = (hash ^ ((const uint8_t *)chan_layout)[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+#if IPC_SCAN
+
+/**
+ * \brief           Check pair of read and write pointers against buffer size.
+ *                  Write pointer is read again after read pointer, pair is consistent when it did not move
+ * \param[in]       size: Buffer size
+ * \param[in]       w: Write pointer
+ * \param[in]       r: Read pointer
+ * \return          `1` when pointers are in range or keep moving, `0` otherwise
+ */
+static uint8_t
+prv_check_ptr(size_t size, volatile size_t* w, volatile size_t* r) {
+    size_t wv, rv;
+
+    for (size_t i = 0; i < 4; ++i) {
+        wv = *w;
+        rv = *r;
+        if (*w != wv) {
+            continue;                           /* Producer wrote in between, retry */
+        }
+#if RINGBUFF_USE_POW2
+        return (size_t)(wv - rv) <= size;
+#else
+        return wv < size && rv < size;
+#endif /* RINGBUFF_USE_POW2 */
+    }
+    return 1;                                   /* Busy channel is checked in next pass */
+}
+
+/**
+ * \brief           Check integrity of channel created or opened by this core,
+ *                  its directory entry, local handle and pointers. Called from background scan
+ * \param[in]       id: Channel ID
+ * \return          \ref IPC_SCAN_OK when channel is intact or not used by this core, error otherwise
+ */
+ipc_scan_err_t
+ipc_chan_check(uint32_t id) {
+    volatile ipc_chan_entry_t* e;
+    RINGBUFF_VOLATILE ringbuff_t* rb;
+    uint32_t data_addr, data_len;
+
+    if (id >= IPC_CHAN_COUNT || (rb = chan_rb[id]) == NULL) {
+        return IPC_SCAN_OK;
+    }
+#if IPC_RESIZE
+    if (IPC_CHAN_RESIZE->req != IPC_CHAN_RESIZE->done) {
+        return IPC_SCAN_OK;                     /* Entries and handles are re-carved */
+    }
+#endif /* IPC_RESIZE */
+
+    /* Entry must describe channel place in layout, data move only with resize */
+    e = &IPC_CHAN_DIR->entries[id];
+    data_addr = e->data_addr;
+    data_len = e->data_len;
+    if (e->shared_addr != (uint32_t)IPC_SHM + chan_layout[id].shared_off
+        || e->sem_id != HSEM_CHAN(id)
+#if IPC_RESIZE
+        || data_len < chan_layout[id].min_len
+        || data_addr < (uint32_t)IPC_SHM + IPC_CHAN_DATA_START
+        || data_addr + data_len > (uint32_t)IPC_SHM + IPC_CHAN_DATA_END
+#else
+        || data_addr != (uint32_t)region_base[chan_layout[id].region] + chan_layout[id].data_off
+        || data_len != chan_layout[id].data_len
+#endif /* IPC_RESIZE */
+        ) {
+        return IPC_SCAN_ERR_ENTRY;
+    }
+
+    /* Local handle */
+    if (!ringbuff_is_ready(rb)) {
+        return IPC_SCAN_ERR_MAGIC;
+    }
+    if ((uint32_t)rb->buff != data_addr || rb->size != data_len
+        || (uint32_t)rb->shared != e->shared_addr) {
+        return IPC_SCAN_ERR_HANDLE;
+    }
+
+    /* Shared pointers and local copies, shadow copy never passes exact pointer of the other side */
+    if (!prv_check_ptr(rb->size, &rb->shared->w, &rb->shared->r)
+        || !prv_check_ptr(rb->size, &rb->w, &rb->r)) {
+        return IPC_SCAN_ERR_INDEX;
+    }
+    return IPC_SCAN_OK;
+}
+
+#endif /* IPC_SCAN */
+
+/**
+ * \brief           Get doorbell semaphore of channel
+ * \param[in]       id: Channel ID
+ * \return          Semaphore ID, to be used with \ref ipc_notify
+ */
+uint32_t
+ipc_chan_get_sem(uint32_t id) {
+    return id < IPC_CHAN_MAX ? IPC_CHAN_DIR->entries[id].sem_id : 0;
+}
+
+#if IPC_RESIZE
+
+#if defined(CORE_CM7)
+
+/**
+ * \brief           Request new data lengths of all channels, CPU1 only.
+ *
+ * Memory of channel data is re-carved in channel ID order, lengths move between channels
+ * while sum stays within data memory of compile-time layout.
+ * Pointers, semaphores and MPU regions do not move.
+ *
+ * Before request, application stops own access to channels, including DMA and interrupts,
+ * then calls \ref ipc_chan_resize_poll until it returns `0`.
+ * Channels are empty after resize, application drains them before request when data must not be lost
+ *
+ * \param[in]       data_len: New data lengths, indexed by channel ID, \ref IPC_CHAN_COUNT entries.
+ *                      Each must be power of 2 with \ref RINGBUFF_USE_POW2
+ *                      or multiple of cache line otherwise, and not shorter than minimum length
+ * \return          `1` if request was posted, `0` if lengths are invalid, do not fit or resize is pending
+ */
+uint8_t
+ipc_chan_resize_request(const uint32_t* data_len) {
+    volatile ipc_chan_resize_t* rs = IPC_CHAN_RESIZE;
+    uint32_t off = IPC_CHAN_DATA_START;
+
+    if (data_len == NULL || rs->req != rs->done) {
+        return 0;
+    }
+    for (size_t id = 0; id < IPC_CHAN_COUNT; ++id) {
+        if (data_len[id] < chan_layout[id].min_len || data_len[id] != IPC_CHAN_FIT_LEN(data_len[id])) {
+            return 0;
+        }
+        off = MEM_ALIGN_CACHE(off) + data_len[id];
+    }
+    if (off > IPC_CHAN_DATA_END) {
+        return 0;
+    }
+
+    for (size_t id = 0; id < IPC_CHAN_COUNT; ++id) {
+        rs->data_len[id] = data_len[id];
+    }
+    __DMB();                                    /* Lengths before generation */
+    rs->req = rs->req + 1;
+    __DSB();
+    return 1;
+}
+
+/**
+ * \brief           Progress channel resize, CPU1 side.
+ *
+ * After CPU2 acknowledged, none of cores accesses channels.
+ * Data of all channels is re-carved, directory entries are updated and local handles are re-initialized
+ *
+ * \return          `1` while resize is pending and channels must not be written, `0` otherwise
+ */
+uint8_t
+ipc_chan_resize_poll(void) {
+    volatile ipc_chan_resize_t* rs = IPC_CHAN_RESIZE;
+    volatile ipc_chan_dir_t* dir = IPC_CHAN_DIR;
+    RINGBUFF_VOLATILE ringbuff_t* rb;
+    ringbuff_evt_fn evt_fn;
+    uint32_t off, data_addr, len;
+    void* arg;
+
+    if (rs->req == rs->done) {
+        return 0;
+    }
+    if (rs->ack != rs->req) {
+        return 1;                               /* CPU2 did not stop writing yet */
+    }
+    __DMB();                                    /* Acknowledge before re-carve */
+    off = IPC_CHAN_DATA_START;
+    for (size_t id = 0; id < IPC_CHAN_COUNT; ++id) {
+        off = MEM_ALIGN_CACHE(off);
+        data_addr = (uint32_t)IPC_SHM + off;
+        len = rs->data_len[id];
+        off += len;
+
+        if ((rb = chan_rb[id]) == NULL) {
+            continue;                           /* Memory stays reserved for channel not created */
+        }
+        evt_fn = rb->evt_fn;                    /* Init clears handle, keep user settings */
+        arg = rb->arg;
+        if (!ringbuff_init_shared(rb, (void *)dir->entries[id].shared_addr, (void *)data_addr, len)
+            || !prv_handle_setup(id, rb)) {
+            return 1;                           /* Cannot happen, lengths were checked on request */
+        }
+        ringbuff_set_evt_fn(rb, evt_fn);
+        ringbuff_set_arg(rb, arg);
+        dir->entries[id].data_addr = data_addr;
+        dir->entries[id].data_len = len;
+    }
+    __DMB();                                    /* Entries and pointers before generation */
+    rs->done = rs->req;
+    __DSB();
+    return 0;
+}
+
+#else
+
+/**
+ * \brief           Progress channel resize, CPU2 side.
+ *
+ * Acknowledges new request on first call, caller stops all access to channels,
+ * and re-attaches local handles to directory after CPU1 re-carved channel data
+ *
+ * \note            Caller must not access any channel while function returns `1`
+ * \return          `1` while resize is pending and channels must not be written, `0` otherwise
+ */
+uint8_t
+ipc_chan_resize_poll(void) {
+    volatile ipc_chan_resize_t* rs = IPC_CHAN_RESIZE;
+    volatile ipc_chan_entry_t* e;
+    RINGBUFF_VOLATILE ringbuff_t* rb;
+    ringbuff_evt_fn evt_fn;
+    uint32_t req = rs->req, done;
+    void* arg;
+
+    if (req == resize_gen) {
+        return 0;
+    }
+    if (rs->ack != req) {
+        __DMB();                                /* Accesses of caller before acknowledge */
+        rs->ack = req;
+        __DSB();
+        return 1;
+    }
+    done = rs->done;
+    if (done != req) {
+        return 1;                               /* CPU1 did not re-carve yet */
+    }
+    __DMB();                                    /* Generation before entries */
+    for (size_t id = 0; id < IPC_CHAN_COUNT; ++id) {
+        if ((rb = chan_rb[id]) == NULL) {
+            continue;
+        }
+        e = &IPC_CHAN_DIR->entries[id];
+        evt_fn = rb->evt_fn;
+        arg = rb->arg;
+        if (!ringbuff_attach(rb, (void *)e->shared_addr, (void *)e->data_addr, e->data_len)
+            || !prv_handle_setup(id, rb)) {
+            return 1;
+        }
+        ringbuff_set_evt_fn(rb, evt_fn);
+        ringbuff_set_arg(rb, arg);
+    }
+    resize_gen = done;
+    return 0;
+}
+
+#endif /* defined(CORE_CM7) */
+
+#endif /* IPC_RESIZE */
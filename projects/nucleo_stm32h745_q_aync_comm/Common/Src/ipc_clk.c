@@ -0,0 +1,391 @@
+/**
+ * \file            ipc_clk.c
+ * \brief           Clock profiles of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_clk.h"
+#include "ipc_chan.h"
+
+/*
+ * Profiles are ordered by voltage scale, higher profile never runs at lower voltage.
+ * PLL1 input is HSI / 4 = 16MHz, VCO in wide range. HSI stays enabled,
+ * it clocks system while PLL1 is reconfigured and is kernel clock of USART3 in fast forwarder profile.
+ *
+ * Flash wait states and programming delay are for AXI clock at given voltage scale, see reference manual.
+ * VOS0 is not available with direct SMPS supply of Nucleo board, maximum profile needs LDO supply
+ */
+
+/**
+ * \brief           Clock profile configuration
+ */
+typedef struct {
+    uint32_t vos;                               /*!< Voltage scale, `PWR_REGULATOR_VOLTAGE_SCALEx` */
+    uint32_t pll_n;                             /*!< PLL1 multiplier, `0` to run from HSI without PLL1 */
+    uint32_t hclk_div;                          /*!< AXI and AHB divider, `RCC_HCLK_DIVx` */
+    uint32_t apb_div;                           /*!< Divider of all APB buses, `RCC_APBx_DIVy` value is the same for each bus */
+    uint32_t latency;                           /*!< Flash wait states, `FLASH_LATENCY_x` */
+    uint32_t prog_delay;                        /*!< Flash programming delay, `FLASH_PROGRAMMING_DELAY_x` */
+    uint8_t ldo_only;                           /*!< Set to `1` when profile needs LDO supply */
+} ipc_clk_profile_t;
+
+static const ipc_clk_profile_t
+clk_profiles[IPC_CLK_PROFILE_COUNT] = {
+    /* 64MHz CPU1 and CPU2 */
+    [IPC_CLK_PROFILE_LOW] = { PWR_REGULATOR_VOLTAGE_SCALE3, 0, RCC_HCLK_DIV1, RCC_APB1_DIV1, FLASH_LATENCY_1, FLASH_PROGRAMMING_DELAY_0, 0 },
+    /* 400MHz CPU1, 200MHz CPU2 and AXI, 100MHz APB */
+    [IPC_CLK_PROFILE_BALANCED] = { PWR_REGULATOR_VOLTAGE_SCALE1, 50, RCC_HCLK_DIV2, RCC_APB1_DIV2, FLASH_LATENCY_2, FLASH_PROGRAMMING_DELAY_2, 0 },
+    /* 480MHz CPU1, 240MHz CPU2 and AXI, 120MHz APB */
+    [IPC_CLK_PROFILE_MAX] = { PWR_REGULATOR_VOLTAGE_SCALE0, 60, RCC_HCLK_DIV2, RCC_APB1_DIV2, FLASH_LATENCY_4, FLASH_PROGRAMMING_DELAY_3, 1 },
+};
+
+#if IPC_CLK_PROFILE >= IPC_CLK_PROFILE_COUNT
+#error "IPC_CLK_PROFILE is not valid"
+#endif
+#if IPC_CLK_PROFILE == IPC_CLK_PROFILE_MAX && IPC_CLK_SUPPLY != PWR_LDO_SUPPLY
+#error "IPC_CLK_PROFILE_MAX needs VOS0, available with IPC_CLK_SUPPLY set to PWR_LDO_SUPPLY only"
+#endif
+
+#define IPC_CLK_SHARED                      (&IPC_SHM->ctrl.clk)
+
+/* Active profile, clocks after reset run at voltage scale of low profile */
+static uint32_t clk_profile = IPC_CLK_PROFILE_LOW;
+
+/* Last generation taken by CPU2 */
+static uint32_t clk_gen;
+
+/* Clock change event callback */
+static ipc_clk_evt_fn clk_evt_fn;
+
+/**
+ * \brief           Publish active clocks to CPU2, generation last
+ */
+static void
+prv_publish(void) {
+    volatile ipc_clk_shared_t* shared = IPC_CLK_SHARED;
+
+    shared->profile = clk_profile;
+    shared->sysclk_hz = HAL_RCC_GetSysClockFreq();
+    shared->hclk_hz = HAL_RCC_GetHCLKFreq();
+    shared->pclk_hz = HAL_RCC_GetPCLK1Freq();
+    __DMB();
+    shared->gen = shared->gen + 1;
+}
+
+/**
+ * \brief           Set voltage scale and wait until it is reached
+ * \param[in]       vos: Voltage scale, `PWR_REGULATOR_VOLTAGE_SCALEx`
+ */
+static void
+prv_set_vos(uint32_t vos) {
+    __HAL_PWR_VOLTAGESCALING_CONFIG(vos);
+    while (!__HAL_PWR_GET_FLAG(PWR_FLAG_VOSRDY)) {}
+}
+
+/**
+ * \brief           Set system clock source and dividers
+ * \param[in]       src: System clock source, `RCC_SYSCLKSOURCE_x`
+ * \param[in]       hclk_div: AXI and AHB divider
+ * \param[in]       apb_div: Divider of all APB buses
+ * \param[in]       latency: Flash wait states
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_set_sysclk(uint32_t src, uint32_t hclk_div, uint32_t apb_div, uint32_t latency) {
+    RCC_ClkInitTypeDef clk = {0};
+
+    /* APB dividers have the same encoding in each domain register, shifted to its field */
+    clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
+                    | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2
+                    | RCC_CLOCKTYPE_D3PCLK1 | RCC_CLOCKTYPE_D1PCLK1;
+    clk.SYSCLKSource = src;
+    clk.SYSCLKDivider = RCC_SYSCLK_DIV1;
+    clk.AHBCLKDivider = hclk_div;
+    clk.APB3CLKDivider = apb_div == RCC_APB1_DIV1 ? RCC_APB3_DIV1 : RCC_APB3_DIV2;
+    clk.APB1CLKDivider = apb_div == RCC_APB1_DIV1 ? RCC_APB1_DIV1 : RCC_APB1_DIV2;
+    clk.APB2CLKDivider = apb_div == RCC_APB1_DIV1 ? RCC_APB2_DIV1 : RCC_APB2_DIV2;
+    clk.APB4CLKDivider = apb_div == RCC_APB1_DIV1 ? RCC_APB4_DIV1 : RCC_APB4_DIV2;
+
+    /* HAL raises wait states before and lowers them after frequency change, SysTick is reconfigured */
+    return HAL_RCC_ClockConfig(&clk, latency) == HAL_OK;
+}
+
+/**
+ * \brief           Configure PLL1, voltage scale, flash wait states and bus dividers of profile
+ *                  and publish new clocks to CPU2.
+ *
+ * Called by CPU1 from `SystemClock_Config` after supply configuration, and at runtime.
+ * Peripherals clocked from buses must be stopped by caller during change
+ *
+ * \param[in]       profile: Profile to set, `IPC_CLK_PROFILE_*`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_clk_set(uint32_t profile) {
+    RCC_OscInitTypeDef osc = {0};
+    const ipc_clk_profile_t* p;
+
+    if (profile >= IPC_CLK_PROFILE_COUNT) {
+        return 0;
+    }
+    p = &clk_profiles[profile];
+    if (p->ldo_only && (PWR->CR3 & PWR_CR3_LDOEN) == 0) {
+        return 0;
+    }
+
+    /* Overdrive of VOS0 is enabled in SYSCFG */
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+
+    /* Raise voltage before frequency */
+    if (profile > clk_profile) {
+        prv_set_vos(p->vos);
+    }
+
+    /* PLL1 cannot be reconfigured while it clocks system, run from HSI meanwhile, current wait states are enough */
+    if (__HAL_RCC_GET_SYSCLK_SOURCE() == RCC_SYSCLKSOURCE_STATUS_PLLCLK
+        && !prv_set_sysclk(RCC_SYSCLKSOURCE_HSI, RCC_HCLK_DIV1, RCC_APB1_DIV1, __HAL_FLASH_GET_LATENCY())) {
+        return 0;
+    }
+
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+    osc.HSIState = RCC_HSI_DIV1;
+    osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+    if (p->pll_n > 0) {
+        osc.PLL.PLLState = RCC_PLL_ON;
+        osc.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+        osc.PLL.PLLM = 4;
+        osc.PLL.PLLN = p->pll_n;
+        osc.PLL.PLLP = 2;
+        osc.PLL.PLLQ = 4;
+        osc.PLL.PLLR = 2;
+        osc.PLL.PLLRGE = RCC_PLL1VCIRANGE_3;
+        osc.PLL.PLLVCOSEL = RCC_PLL1VCOWIDE;
+        osc.PLL.PLLFRACN = 0;
+    } else {
+        osc.PLL.PLLState = RCC_PLL_OFF;
+    }
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK
+        || !prv_set_sysclk(p->pll_n > 0 ? RCC_SYSCLKSOURCE_PLLCLK : RCC_SYSCLKSOURCE_HSI,
+                           p->hclk_div, p->apb_div, p->latency)) {
+        return 0;
+    }
+    __HAL_FLASH_SET_PROGRAM_DELAY(p->prog_delay);
+
+    /* Lower voltage after frequency */
+    if (profile < clk_profile) {
+        prv_set_vos(p->vos);
+    }
+    clk_profile = profile;
+    prv_publish();
+    return 1;
+}
+
+/**
+ * \brief           Take clock configuration published by CPU1.
+ *                  Updates `SystemCoreClock` and SysTick of CPU2 when clocks changed since last call
+ * \return          `1` when clocks changed, `0` otherwise
+ */
+uint8_t
+ipc_clk_sync(void) {
+    volatile ipc_clk_shared_t* shared = IPC_CLK_SHARED;
+    uint32_t gen = shared->gen;
+
+    if (gen == clk_gen) {
+        return 0;
+    }
+    __DMB();
+    clk_gen = gen;
+    clk_profile = shared->profile;
+    SystemCoreClock = shared->hclk_hz;
+    HAL_InitTick(uwTickPrio);
+    return 1;
+}
+
+/**
+ * \brief           Set clock change event callback, called by \ref ipc_clk_change on CPU1
+ *                  and by \ref ipc_clk_poll on CPU2
+ * \param[in]       fn: Callback function, `NULL` to disable
+ */
+void
+ipc_clk_set_evt_fn(ipc_clk_evt_fn fn) {
+    clk_evt_fn = fn;
+}
+
+#if IPC_DVFS
+
+#if UART_FWD_PROFILE != UART_FWD_PROFILE_FAST
+#error "IPC_DVFS needs UART_FWD_PROFILE_FAST, USART3 baudrate depends on D2PCLK1 otherwise"
+#endif
+
+/*
+ * Clock change handshake over control lane:
+ *
+ * - CPU1 calls IPC_RPC_METHOD_CLK_PAUSE with generation it will publish next
+ * - CPU2 responds and then stops SysTick and its timers in ipc_clk_poll,
+ *      it waits for generation in control part of shared RAM and does not access channels
+ * - CPU1 stops its own timers, switches clocks and publishes new generation, also when switch failed
+ * - Both cores continue with new SystemCoreClock and SysTick
+ *
+ * CPU2 waits until generation is reached, not until it changes. When response came after CPU1 timeout,
+ * CPU1 published generation already and CPU2 continues immediately
+ */
+
+/* Generation CPU2 waits for, valid while clk_paused is set */
+static uint32_t clk_pause_gen;
+static uint8_t clk_paused;
+
+/**
+ * \brief           Change clock profile at runtime, CPU2 is paused during change.
+ *                  Call from CPU1 main loop, it serves RPC responses while waiting for CPU2
+ * \param[in]       cli: RPC client of CPU2 methods
+ * \param[in]       profile: Profile to set, `IPC_CLK_PROFILE_*`
+ * \return          \ref IPC_RPC_OK on success, \ref ipc_rpc_status_t error otherwise, clocks are unchanged then
+ */
+int32_t
+ipc_clk_change(ipc_rpc_client_t* cli, uint32_t profile) {
+    volatile ipc_clk_shared_t* shared = IPC_CLK_SHARED;
+    uint32_t gen = shared->gen + 1;
+    int32_t status;
+    uint8_t ok;
+
+    if (profile >= IPC_CLK_PROFILE_COUNT) {
+        return IPC_RPC_ERR_ARGS;
+    }
+    if (profile == clk_profile) {
+        return IPC_RPC_OK;
+    }
+    if ((status = ipc_rpc_call(cli, IPC_RPC_METHOD_CLK_PAUSE, &gen, sizeof(gen),
+                                NULL, 0, NULL, IPC_DVFS_TIMEOUT_US)) != IPC_RPC_OK) {
+        prv_publish();                          /* Release CPU2 in case it pauses after timeout */
+        return status;
+    }
+
+    if (clk_evt_fn != NULL) {
+        clk_evt_fn(IPC_CLK_EVT_PAUSE);
+    }
+    if (!(ok = ipc_clk_set(profile))) {
+        prv_publish();                          /* Release CPU2 with unchanged clocks */
+    }
+    if (clk_evt_fn != NULL) {
+        clk_evt_fn(IPC_CLK_EVT_RESUME);
+    }
+    return ok ? IPC_RPC_OK : IPC_RPC_ERR_ARGS;
+}
+
+/**
+ * \brief           Initialize clock governor of CPU1
+ * \param[in]       gov: Governor handle
+ * \param[in]       buff: Monitored buffer, CPU1 consumer side
+ * \param[in]       up_level: Fill level in units of bytes which selects \ref IPC_DVFS_PROFILE_HIGH
+ * \param[in]       idle_ms: Time below `up_level` after which \ref IPC_DVFS_PROFILE_LOW is selected
+ */
+void
+ipc_clk_gov_init(ipc_clk_gov_t* gov, RINGBUFF_VOLATILE ringbuff_t* buff, size_t up_level, uint32_t idle_ms) {
+    gov->buff = buff;
+    gov->up_level = up_level;
+    gov->idle_ms = idle_ms;
+    gov->busy_time = HAL_GetTick();
+}
+
+/**
+ * \brief           Select profile from fill level of monitored buffer.
+ *                  Clocks ramp up at once and drop only after idle time, to not oscillate
+ * \param[in]       gov: Governor handle
+ * \param[in]       now: Current tick in units of milliseconds
+ * \return          Profile to set, active profile when no change is needed
+ */
+uint32_t
+ipc_clk_gov_poll(ipc_clk_gov_t* gov, uint32_t now) {
+    if (ringbuff_get_full(gov->buff) >= gov->up_level) {
+        gov->busy_time = now;
+        return IPC_DVFS_PROFILE_HIGH;
+    }
+    if (now - gov->busy_time >= gov->idle_ms) {
+        return IPC_DVFS_PROFILE_LOW;
+    }
+    return clk_profile;
+}
+
+/**
+ * \brief           RPC method \ref IPC_RPC_METHOD_CLK_PAUSE, served by CPU2.
+ *                  CPU2 pauses in next \ref ipc_clk_poll, after response was sent
+ * \param[in]       args: Generation to wait for, 4 bytes
+ * \param[in]       len: Length of arguments
+ * \param[out]      res: Unused
+ * \param[in,out]   res_len: Set to `0`
+ * \return          \ref IPC_RPC_OK on success, \ref IPC_RPC_ERR_ARGS otherwise
+ */
+int32_t
+ipc_clk_rpc_pause(const void* args, size_t len, void* res, size_t* res_len) {
+    if (len != sizeof(clk_pause_gen)) {
+        return IPC_RPC_ERR_ARGS;
+    }
+    memcpy(&clk_pause_gen, args, sizeof(clk_pause_gen));
+    clk_paused = 1;
+    *res_len = 0;
+    return IPC_RPC_OK;
+}
+
+/**
+ * \brief           Pause CPU2 while CPU1 changes clocks, when requested.
+ *                  Call from CPU2 main loop, before channels are accessed
+ * \return          `1` when core was paused and clocks were taken again, `0` otherwise
+ */
+uint8_t
+ipc_clk_poll(void) {
+    volatile ipc_clk_shared_t* shared = IPC_CLK_SHARED;
+
+    if (!clk_paused) {
+        return 0;
+    }
+    clk_paused = 0;
+    if (clk_evt_fn != NULL) {
+        clk_evt_fn(IPC_CLK_EVT_PAUSE);
+    }
+    HAL_SuspendTick();
+    while ((int32_t)(shared->gen - clk_pause_gen) < 0) {}
+    ipc_clk_sync();
+    HAL_ResumeTick();
+    if (clk_evt_fn != NULL) {
+        clk_evt_fn(IPC_CLK_EVT_RESUME);
+    }
+    return 1;
+}
+
+#endif /* IPC_DVFS */
+
+/**
+ * \brief           Get active clock profile
+ * \return          Profile, `IPC_CLK_PROFILE_*`
+ */
+uint32_t
+ipc_clk_get_profile(void) {
+    return clk_profile;
+}
@@ -0,0 +1,123 @@
+/**
+ * \file            ipc_cobs.c
+ * \brief           COBS framing
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "ipc_cobs.h"
+
+/*
+ * Consistent overhead byte stuffing, at most 1 byte per 254 bytes of input plus delimiter.
+ * Encoder reads every input byte once, from ring buffer spans in place.
+ * Codec has no dependency on target, host decoder builds from this file
+ */
+
+/**
+ * \brief           Start frame
+ * \param[in]       enc: Encoder handle
+ * \param[out]      out: Output memory
+ */
+void
+ipc_cobs_enc_begin(ipc_cobs_enc_t* enc, uint8_t* out) {
+    enc->out = out;
+    enc->code = 0;
+    enc->len = 1;
+}
+
+/**
+ * \brief           Add input fragment to frame
+ * \param[in]       enc: Encoder handle
+ * \param[in]       data: Input data
+ * \param[in]       len: Input length in units of bytes
+ */
+void
+ipc_cobs_enc_put(ipc_cobs_enc_t* enc, const void* data, size_t len) {
+    const uint8_t* d = data;
+    uint8_t* out = enc->out;
+    size_t pos = enc->len, code = enc->code;
+
+    for (; len > 0; --len, ++d) {
+        if (*d == 0) {
+            out[code] = (uint8_t)(pos - code);
+            code = pos++;
+        } else {
+            out[pos++] = *d;
+            if (pos - code == 0xFF) {
+                /* Block of 254 non-zero bytes, next code byte does not stand for zero */
+                out[code] = 0xFF;
+                code = pos++;
+            }
+        }
+    }
+    enc->len = pos;
+    enc->code = code;
+}
+
+/**
+ * \brief           Finish frame and add delimiter
+ * \param[in]       enc: Encoder handle
+ * \return          Frame length in units of bytes, including delimiter
+ */
+size_t
+ipc_cobs_enc_end(ipc_cobs_enc_t* enc) {
+    enc->out[enc->code] = (uint8_t)(enc->len - enc->code);
+    enc->out[enc->len++] = IPC_COBS_DELIM;
+    return enc->len;
+}
+
+/**
+ * \brief           Decode one frame
+ * \param[in]       in: Encoded frame, without delimiter
+ * \param[in]       len: Encoded length in units of bytes
+ * \param[out]      out: Output memory for decoded record
+ * \param[in]       size: Size of `out` in units of bytes
+ * \return          Decoded length, `-1` when frame is corrupted or does not fit to `out`
+ */
+int32_t
+ipc_cobs_decode(const uint8_t* in, size_t len, uint8_t* out, size_t size) {
+    size_t pos = 0, n = 0, code;
+
+    while (pos < len) {
+        code = in[pos++];
+        if (code == 0 || pos + code - 1 > len || n + code - 1 > size) {
+            return -1;
+        }
+        for (size_t k = 1; k < code; ++k) {
+            if (in[pos] == 0) {
+                return -1;
+            }
+            out[n++] = in[pos++];
+        }
+        if (code < 0xFF && pos < len) {
+            if (n >= size) {
+                return -1;
+            }
+            out[n++] = 0;
+        }
+    }
+    return (int32_t)n;
+}
@@ -0,0 +1,107 @@
+/**
+ * \file            ipc_cobs_sink.c
+ * \brief           COBS framing stage of router sink
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_cobs_sink.h"
+
+#if IPC_COBS
+
+#if !IPC_ROUTE
+#error "IPC_COBS needs IPC_ROUTE, framing is stage of router sink"
+#endif /* !IPC_ROUTE */
+#if IPC_LZ
+#error "IPC_COBS and IPC_LZ are both encoding stages of UART sink, enable one of them"
+#endif /* IPC_LZ */
+
+/*
+ * Every linear block routed to sink becomes one record, tagged with channel ID of its source,
+ * blocks longer than IPC_COBS_DATA_MAX are split. Record is encoded in single pass,
+ * directly to sink queue memory when it has linear memory for worst case,
+ * to frame memory and copied otherwise. Frame is queued as a whole or dropped
+ */
+
+/**
+ * \brief           Frame data of source, \ref ipc_sink_put_fn of COBS stage
+ * \param[in]       sink: Sink handle
+ * \param[in]       id: Channel ID of source
+ * \param[in]       data: Data to queue
+ * \param[in]       len: Data length in units of bytes
+ * \return          `1` if any frame was queued, `0` otherwise
+ */
+static uint8_t
+prv_cobs_put(ipc_sink_t* sink, uint32_t id, const uint8_t* data, size_t len) {
+    ipc_cobs_sink_t* cs = sink->stage;
+    ipc_cobs_enc_t enc;
+    uint8_t tag = (uint8_t)id, queued = 0, direct;
+    size_t n, flen;
+
+    while (len > 0) {
+        n = len > IPC_COBS_DATA_MAX ? IPC_COBS_DATA_MAX : len;
+        direct = ringbuff_get_linear_block_write_length(sink->queue) >= IPC_COBS_ENC_MAX(1 + n);
+        ipc_cobs_enc_begin(&enc, direct ? ringbuff_get_linear_block_write_address(sink->queue) : cs->frame);
+        ipc_cobs_enc_put(&enc, &tag, 1);
+        ipc_cobs_enc_put(&enc, data, n);
+        flen = ipc_cobs_enc_end(&enc);
+        if (direct) {
+            ringbuff_advance(sink->queue, flen);
+        } else if (ringbuff_write_all(sink->queue, cs->frame, flen) == RINGBUFF_WOULD_BLOCK) {
+            sink->drops += n;
+            data += n;
+            len -= n;
+            continue;
+        }
+        sink->bytes += n;
+        ++cs->frames;
+        queued = 1;
+        data += n;
+        len -= n;
+    }
+    return queued;
+}
+
+/**
+ * \brief           Add COBS framing stage to sink
+ * \param[in]       cs: Framing stage, in core-local memory
+ * \param[in]       sink: Sink handle, initialized with queue
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_cobs_sink_init(ipc_cobs_sink_t* cs, ipc_sink_t* sink) {
+    if (cs == NULL || sink == NULL || sink->queue == NULL) {
+        return 0;
+    }
+    cs->frames = 0;
+    sink->stage = cs;
+    sink->put_fn = prv_cobs_put;
+    return 1;
+}
+
+#endif /* IPC_COBS */
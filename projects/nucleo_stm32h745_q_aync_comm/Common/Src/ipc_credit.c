@@ -0,0 +1,245 @@
+/**
+ * \file            ipc_credit.c
+ * \brief           Credit-based flow control of channel streams
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_credit.h"
+#include "ipc_chan.h"
+
+#if IPC_CREDIT
+
+/*
+ * Producer may send `granted - sent` bytes to each stream, records count with header.
+ * Consumer grants bytes back after it read them, in batches of at least `batch` bytes.
+ *
+ * Grants are free-running counters in shared RAM, written by consumer only,
+ * the same way as buffer read pointer. Reverse pipe is not used, it carries
+ * other data and has its own single producer.
+ *
+ * Initial windows of all streams together do not exceed buffer capacity,
+ * send with enough credit therefore always fits to buffer and no stream
+ * can fill buffer for other streams
+ */
+
+/* Credits of channel */
+#define IPC_CREDIT_SHARED(id)               (&IPC_SHM->ctrl.credit[(id)])
+
+/* Bytes used by record in buffer */
+#define IPC_CREDIT_REC_LEN(len)             (sizeof(ipc_credit_hdr_t) + (len))
+
+/**
+ * \brief           Grant released bytes of stream back to producer
+ * \param[in]       rx: Consumer handle
+ * \param[in]       stream: Stream index
+ */
+static void
+prv_grant(ipc_credit_rx_t* rx, uint32_t stream) {
+    if (rx->released[stream] == 0) {
+        return;
+    }
+    __DMB();                                    /* Read pointer before grant */
+    rx->shared->granted[stream] += rx->released[stream];
+    rx->released[stream] = 0;
+}
+
+/**
+ * \brief           Set initial credit windows of channel streams.
+ *                  Called by CPU1 after channel is created, before directory is published
+ * \param[in]       id: Channel ID
+ * \param[in]       rb: Channel buffer handle, empty
+ * \param[in]       windows: Initial credit of each stream in units of bytes, including record headers
+ * \param[in]       count: Number of entries in `windows`, up to \ref IPC_CREDIT_STREAMS.
+ *                      Other streams get no credit
+ * \return          `1` on success, `0` if windows together exceed buffer capacity
+ */
+uint8_t
+ipc_credit_init(uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb, const uint32_t* windows, size_t count) {
+    volatile ipc_credit_shared_t* credit;
+    size_t sum = 0;
+
+    if (id >= IPC_CHAN_COUNT || windows == NULL || count > IPC_CREDIT_STREAMS) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        sum += windows[i];
+    }
+    if (sum > ringbuff_get_free(rb)) {
+        return 0;
+    }
+    credit = IPC_CREDIT_SHARED(id);
+    for (size_t i = 0; i < IPC_CREDIT_STREAMS; ++i) {
+        credit->granted[i] = i < count ? windows[i] : 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Initialize producer side of channel with credits
+ * \param[in]       tx: Producer handle
+ * \param[in]       id: Channel ID
+ * \param[in]       rb: Channel buffer handle, producer side
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_credit_tx_init(ipc_credit_tx_t* tx, uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb) {
+    if (tx == NULL || rb == NULL || id >= IPC_CHAN_COUNT) {
+        return 0;
+    }
+    memset(tx, 0x00, sizeof(*tx));
+    tx->rb = rb;
+    tx->shared = IPC_CREDIT_SHARED(id);
+    return 1;
+}
+
+/**
+ * \brief           Get credit of stream
+ * \param[in]       tx: Producer handle
+ * \param[in]       stream: Stream index
+ * \return          Number of bytes stream may send, including record headers
+ */
+uint32_t
+ipc_credit_get(ipc_credit_tx_t* tx, uint32_t stream) {
+    if (tx == NULL || stream >= IPC_CREDIT_STREAMS) {
+        return 0;
+    }
+    tx->granted[stream] = tx->shared->granted[stream];
+    __DMB();                                    /* Grant before read pointer */
+    return tx->granted[stream] - tx->sent[stream];
+}
+
+/**
+ * \brief           Send record to stream, when stream has enough credit.
+ *                  Record is written as a whole or not at all
+ * \param[in]       tx: Producer handle
+ * \param[in]       stream: Stream index
+ * \param[in]       data: Record payload
+ * \param[in]       len: Payload length in units of bytes, up to `65535`
+ * \return          `len` on success, `0` if stream has not enough credit
+ */
+size_t
+ipc_credit_send(ipc_credit_tx_t* tx, uint32_t stream, const void* data, size_t len) {
+    ipc_credit_hdr_t hdr;
+    uint32_t need;
+
+    if (tx == NULL || stream >= IPC_CREDIT_STREAMS || data == NULL
+        || len == 0 || len > UINT16_MAX) {
+        return 0;
+    }
+    need = IPC_CREDIT_REC_LEN(len);
+
+    /* Shadow grant is refreshed only when it indicates too little credit */
+    if (tx->granted[stream] - tx->sent[stream] < need
+        && ipc_credit_get(tx, stream) < need) {
+        return 0;
+    }
+
+    hdr.stream = (uint16_t)stream;
+    hdr.len = (uint16_t)len;
+    ringbuff_iovec_t iov[] = {
+        { &hdr, sizeof(hdr) },
+        { data, len },
+    };
+    if (ringbuff_writev(tx->rb, iov, sizeof(iov) / sizeof(iov[0])) == 0) {
+        return 0;
+    }
+    tx->sent[stream] += need;
+    return len;
+}
+
+/**
+ * \brief           Initialize consumer side of channel with credits
+ * \param[in]       rx: Consumer handle
+ * \param[in]       id: Channel ID
+ * \param[in]       rb: Channel buffer handle, consumer side
+ * \param[in]       batch: Number of read bytes per stream granted back at once.
+ *                      Larger batch means fewer grant updates and less producer refreshes,
+ *                      it must be lower than smallest stream window
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_credit_rx_init(ipc_credit_rx_t* rx, uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb, uint32_t batch) {
+    if (rx == NULL || rb == NULL || id >= IPC_CHAN_COUNT) {
+        return 0;
+    }
+    memset(rx, 0x00, sizeof(*rx));
+    rx->rb = rb;
+    rx->shared = IPC_CREDIT_SHARED(id);
+    rx->batch = batch;
+    return 1;
+}
+
+/**
+ * \brief           Receive next record from channel and release its credit
+ * \param[in]       rx: Consumer handle
+ * \param[out]      stream: Output variable to write stream index to
+ * \param[out]      data: Memory to copy record payload to
+ * \param[in]       size: Size of `data` array in units of bytes
+ * \return          Payload length in units of bytes, `0` if there is no record
+ *                      or when it does not fit to `data` array. Record then stays in buffer
+ */
+size_t
+ipc_credit_recv(ipc_credit_rx_t* rx, uint32_t* stream, void* data, size_t size) {
+    ipc_credit_hdr_t hdr;
+
+    if (rx == NULL || stream == NULL || data == NULL
+        || ringbuff_peek(rx->rb, 0, &hdr, sizeof(hdr)) != sizeof(hdr)
+        || hdr.stream >= IPC_CREDIT_STREAMS || hdr.len > size
+        || ringbuff_get_full(rx->rb) < IPC_CREDIT_REC_LEN(hdr.len)) {
+        return 0;
+    }
+
+    ringbuff_skip(rx->rb, sizeof(hdr));
+    ringbuff_read(rx->rb, data, hdr.len);
+    *stream = hdr.stream;
+
+    rx->released[hdr.stream] += IPC_CREDIT_REC_LEN(hdr.len);
+    if (rx->released[hdr.stream] >= rx->batch) {
+        prv_grant(rx, hdr.stream);
+    }
+    return hdr.len;
+}
+
+/**
+ * \brief           Grant all released bytes back to producer, regardless of batch.
+ *                  Call when consumer drained channel, before it goes to sleep
+ * \param[in]       rx: Consumer handle
+ */
+void
+ipc_credit_rx_flush(ipc_credit_rx_t* rx) {
+    if (rx == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < IPC_CREDIT_STREAMS; ++i) {
+        prv_grant(rx, i);
+    }
+}
+
+#endif /* IPC_CREDIT */
@@ -0,0 +1,173 @@
+/**
+ * \file            ipc_drain.c
+ * \brief           Interrupt-side channel drain with bounded budget
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_drain.h"
+
+#if IPC_DRAIN
+
+/*
+ * Doorbell interrupt consumes at most budget of its channel and leaves the rest
+ * to continuation in IPC_DRAIN_IRQn, PendSV by default, at lowest priority.
+ * Continuation runs budget of every deferred drain and pends itself again while data are left,
+ * so other interrupts are served between budgets and a burst never holds doorbell interrupt
+ * for longer than one budget. Burst is still consumed before thread mode runs.
+ *
+ * Doorbell interrupt preempts continuation, never the other way around.
+ * It returns without touching channel while continuation drains it,
+ * continuation checks channel again after it finished, so no data are left behind
+ */
+
+#define IPC_DRAIN_MIN(x, y)                 ((x) < (y) ? (x) : (y))
+
+/* Registered drains, walked by continuation */
+static ipc_drain_t* drains;
+
+/**
+ * \brief           Request continuation
+ */
+static void
+prv_pend(void) {
+    if (IPC_DRAIN_IRQn == PendSV_IRQn) {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    } else {
+        NVIC_SetPendingIRQ(IPC_DRAIN_IRQn);
+    }
+}
+
+/**
+ * \brief           Consume up to budget of channel and defer the rest
+ * \param[in]       d: Drain handle
+ */
+static void
+prv_run(ipc_drain_t* d) {
+    ringbuff_msg_span_t spans[IPC_DRAIN_BATCH];
+    size_t n = 0, cnt, len;
+
+    d->busy = 1;
+    ++d->runs;
+    if (d->mode == IPC_DRAIN_MSGS) {
+        while (n < d->budget
+               && (cnt = ringbuff_msg_recv_batch(d->rb, spans, IPC_DRAIN_MIN(d->budget - n, IPC_DRAIN_BATCH))) > 0) {
+            for (size_t i = 0; i < cnt; ++i) {
+                if (spans[i].len1 + spans[i].len2 > 0) {
+                    d->fn(d, &spans[i]);        /* Empty span is message dropped by integrity check */
+                }
+            }
+            ringbuff_msg_recv_batch_release(d->rb, cnt);
+            n += cnt;
+        }
+    } else {
+        while (n < d->budget && (len = ringbuff_get_linear_block_read_length(d->rb)) > 0) {
+            spans[0].ptr1 = ringbuff_get_linear_block_read_address(d->rb);
+            spans[0].len1 = IPC_DRAIN_MIN(len, d->budget - n);
+            spans[0].ptr2 = NULL;
+            spans[0].len2 = 0;
+            d->fn(d, &spans[0]);
+            ringbuff_skip(d->rb, spans[0].len1);
+            n += spans[0].len1;
+        }
+    }
+    d->busy = 0;
+
+    /* Doorbell during run returned early, its data are checked here */
+    if (ringbuff_get_full(d->rb) > 0) {
+        ++d->defers;
+        d->deferred = 1;
+        prv_pend();
+    }
+}
+
+/**
+ * \brief           Initialize drain and register it with continuation.
+ *                  Call from thread before doorbell of channel is listened to
+ * \param[in]       d: Drain handle
+ * \param[in]       rb: Buffer handle, consumer side. Drain must be its only consumer
+ * \param[in]       mode: Budget unit
+ * \param[in]       budget: Bytes or messages consumed per interrupt, greater than `0`
+ * \param[in]       fn: Data callback
+ * \param[in]       arg: User argument
+ */
+void
+ipc_drain_init(ipc_drain_t* d, RINGBUFF_VOLATILE ringbuff_t* rb, ipc_drain_mode_t mode, size_t budget,
+               ipc_drain_fn fn, void* arg) {
+    uint32_t primask;
+
+    d->rb = rb;
+    d->fn = fn;
+    d->arg = arg;
+    d->mode = mode;
+    d->budget = budget > 0 ? budget : 1;
+    d->busy = 0;
+    d->deferred = 0;
+    d->runs = 0;
+    d->defers = 0;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    d->next = drains;
+    drains = d;
+    __set_PRIMASK(primask);
+
+    /* Continuation runs below every other interrupt */
+    NVIC_SetPriority(IPC_DRAIN_IRQn, (1UL << __NVIC_PRIO_BITS) - 1);
+    if (IPC_DRAIN_IRQn != PendSV_IRQn) {
+        NVIC_EnableIRQ(IPC_DRAIN_IRQn);
+    }
+}
+
+/**
+ * \brief           Drain channel after doorbell, call from doorbell callback in HSEM interrupt
+ * \param[in]       d: Drain handle
+ */
+void
+ipc_drain_irq(ipc_drain_t* d) {
+    if (d->busy) {
+        return;                                 /* Continuation drains channel, it checks it again when done */
+    }
+    prv_run(d);
+}
+
+/**
+ * \brief           Continue deferred drains, one budget each.
+ *                  Call from `PendSV_Handler` or handler of \ref IPC_DRAIN_IRQn
+ */
+void
+ipc_drain_resume(void) {
+    for (ipc_drain_t* d = drains; d != NULL; d = d->next) {
+        if (d->deferred) {
+            d->deferred = 0;
+            prv_run(d);
+        }
+    }
+}
+
+#endif /* IPC_DRAIN */
@@ -0,0 +1,170 @@
+/**
+ * \file            ipc_frec.c
+ * \brief           Flight recorder of IPC events in retained SRAM4
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_frec.h"
+
+#if IPC_FREC
+
+/*
+ * Each core appends to its own ring, from thread and interrupts, see ipc_frec_add.
+ * Appending is few instructions and never waits, ring overwrites its oldest events.
+ *
+ * Boot checks magic, version and length of ring of current core. Power-on content fails the check
+ * and ring is cleared, otherwise ring is kept and boot only advances `mark` and `boots`.
+ * Events before `mark` belong to previous boots and are reported by ipc_frec_dump.
+ *
+ * CPU1 has recorder non-cacheable in its MPU, no event stays in D-cache over reset.
+ * Entry being written when reset hits may hold event of previous lap
+ */
+
+_Static_assert(sizeof(ipc_frec_hdr_t) == MEM_CACHE_LINE_SIZE, "Ring header must be one cache line");
+_Static_assert(2 * sizeof(ipc_frec_ring_t) <= IPC_FREC_LEN, "Rings do not fit to recorder");
+_Static_assert(IPC_FREC_ADDR == SHD_RAM_START_ADDR + SHD_RAM_LEN - IPC_FREC_LEN, "Recorder must be at end of SRAM4");
+_Static_assert(IPC_FREC_EVT_READ == RINGBUFF_EVT_READ && IPC_FREC_EVT_WRITE == RINGBUFF_EVT_WRITE
+                && IPC_FREC_EVT_RESET == RINGBUFF_EVT_RESET, "Buffer event values do not match ringbuff_evt_type_t");
+
+/* Reset status register of current core */
+#if defined(CORE_CM7)
+#define IPC_FREC_RSR                        (RCC_C1->RSR)
+#else
+#define IPC_FREC_RSR                        (RCC_C2->RSR)
+#endif
+
+/* Event names, indexed by event */
+static const char* const evt_names[16] = {
+    [IPC_FREC_EVT_READ] = "read",
+    [IPC_FREC_EVT_WRITE] = "write",
+    [IPC_FREC_EVT_RESET] = "reset",
+    [IPC_FREC_EVT_NOTIFY] = "notify",
+    [IPC_FREC_EVT_DOORBELL] = "doorbell",
+    [IPC_FREC_EVT_DROP] = "drop",
+    [IPC_FREC_EVT_BOOT] = "boot",
+};
+
+/**
+ * \brief           Start recorder of current core, first call after reset.
+ *                  Keeps valid ring of previous boots and appends boot event
+ *
+ * CPU1 clears its reset flags, flags of next boot show only its own reset.
+ * CPU2 flags are cleared by CPU1 on CPU2 recovery, see ipc_peer.c, and accumulate otherwise
+ */
+void
+ipc_frec_init(void) {
+    volatile ipc_frec_ring_t* ring = IPC_FREC_RING(IPC_FREC_CORE);
+    uint32_t rsr = IPC_FREC_RSR;
+
+    CYCCNT_INIT();                              /* Time base of events */
+#if defined(CORE_CM7)
+    RCC_C1->RSR = RCC_RSR_RMVF;
+#endif /* defined(CORE_CM7) */
+    if (ring->hdr.magic != IPC_FREC_MAGIC || ring->hdr.version != IPC_FREC_VERSION
+        || ring->hdr.entries != IPC_FREC_ENTRIES || ring->hdr.count >= IPC_FREC_WRAP) {
+        memset((void *)ring, 0x00, sizeof(*ring));
+        ring->hdr.version = IPC_FREC_VERSION;
+        ring->hdr.entries = IPC_FREC_ENTRIES;
+        __DMB();
+        ring->hdr.magic = IPC_FREC_MAGIC;
+    } else {
+        ring->hdr.boots = ring->hdr.boots + 1;
+    }
+    ring->hdr.mark = ring->hdr.count;
+    ring->hdr.rsr = rsr;
+    ipc_frec_add(IPC_FREC_WORD(ring->hdr.boots, IPC_FREC_EVT_BOOT, rsr >> 16));
+}
+
+/**
+ * \brief           Output last events of previous boots of core, oldest first
+ *
+ * Ring of other core can be dumped once it called \ref ipc_frec_init in current boot,
+ * for example after \ref IPC_BOOT_STAGE_ATTACHED.
+ * Events overwritten by current boot while dump runs are skipped
+ *
+ * \param[in]       core: Core of ring, \ref IPC_FREC_CPU1 or \ref IPC_FREC_CPU2
+ * \param[in]       last: Maximum number of events
+ * \param[in]       out_fn: Output function
+ * \return          Number of events output
+ */
+size_t
+ipc_frec_dump(uint32_t core, size_t last, ipc_frec_out_fn out_fn) {
+    volatile ipc_frec_ring_t* ring;
+    ipc_frec_entry_t e;
+    uint32_t mark, pos, age, count;
+    size_t n, done = 0;
+    char str[80];
+
+    if (core > IPC_FREC_CPU2 || out_fn == NULL) {
+        return 0;
+    }
+    ring = IPC_FREC_RING(core);
+    if (ring->hdr.magic != IPC_FREC_MAGIC || ring->hdr.version != IPC_FREC_VERSION || ring->hdr.boots == 0) {
+        return 0;                               /* Ring was cleared in current boot */
+    }
+
+    /* Events before mark, fewer than ring holds only once after counter wrap */
+    mark = ring->hdr.mark;
+    if (last > IPC_FREC_ENTRIES) {
+        last = IPC_FREC_ENTRIES;
+    }
+    if (last > mark) {
+        last = mark;
+    }
+    n = sprintf(str, "[FREC] CPU%u boot:%u reset:0x%04X last:%u\r\n",
+                (unsigned)core + 1, (unsigned)ring->hdr.boots, (unsigned)(ring->hdr.rsr >> 16), (unsigned)last);
+    out_fn(str, n);
+    for (size_t i = last; i > 0; --i) {
+        pos = mark - (uint32_t)i;
+        e.stamp = ring->entry[pos % IPC_FREC_ENTRIES].stamp;
+        e.word = ring->entry[pos % IPC_FREC_ENTRIES].word;
+
+        /* Entry is valid while current boot did not append full ring after it */
+        __DMB();
+        count = ring->hdr.count;
+        age = count >= pos ? count - pos : count + (IPC_FREC_WRAP - pos);
+        if (age > IPC_FREC_ENTRIES) {
+            continue;
+        }
+        if (evt_names[IPC_FREC_WORD_EVT(e.word)] != NULL) {
+            n = sprintf(str, "[FREC] -%u cyc:%lu %s id:%u len:%u\r\n", (unsigned)i, (unsigned long)e.stamp,
+                        evt_names[IPC_FREC_WORD_EVT(e.word)], (unsigned)IPC_FREC_WORD_ID(e.word), (unsigned)IPC_FREC_WORD_LEN(e.word));
+        } else {
+            n = sprintf(str, "[FREC] -%u cyc:%lu evt%u id:%u len:%u\r\n", (unsigned)i, (unsigned long)e.stamp,
+                        (unsigned)IPC_FREC_WORD_EVT(e.word), (unsigned)IPC_FREC_WORD_ID(e.word), (unsigned)IPC_FREC_WORD_LEN(e.word));
+        }
+        out_fn(str, n);
+        ++done;
+    }
+    return done;
+}
+
+#endif /* IPC_FREC */
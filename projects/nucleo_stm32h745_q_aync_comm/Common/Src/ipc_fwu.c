@@ -0,0 +1,462 @@
+/**
+ * \file            ipc_fwu.c
+ * \brief           CPU2 firmware update through shared memory
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_fwu.h"
+#include "ipc_chan.h"
+#include "ipc_notify.h"
+#include "ipc_wait.h"
+
+#if IPC_FWU
+
+/*
+ * CPU2 executes from flash bank 2, the bank being replaced. Once header is taken, CPU2 masks
+ * interrupts and runs from `.ramfunc` until reset: ring buffer hot path and code below
+ * are RAM resident, flash is controlled with registers only and vector table is not used.
+ * CPU1 executes from bank 1 and keeps streaming, read-while-write is across banks.
+ *
+ * Transfer overlaps with flash operations: flash words are programmed from channel memory
+ * in place while CPU1 writes next chunks to rest of the channel, sector is erased when its first
+ * word is due and chunks queued meanwhile cover erase time. Update time approaches sum
+ * of erase and programming time, CPU2 reports both and time it waited for data.
+ * CPU1 verifies bank 2 against image and resets system, new image boots with normal handshake
+ */
+
+/* Update progress */
+#define IPC_FWU_SHARED                      (&IPC_SHM->ctrl.fwu)
+
+#define IPC_FWU_MIN(x, y)                   ((x) < (y) ? (x) : (y))
+
+/* Error flags of flash status register */
+#define IPC_FWU_FLASH_ERR                   (FLASH_SR_WRPERR | FLASH_SR_PGSERR | FLASH_SR_STRBERR | FLASH_SR_INCERR | FLASH_SR_OPERR)
+
+/* Code that runs while flash bank 2 is erased or programmed */
+#if defined(CORE_CM4)
+#define IPC_FWU_RAM                         __attribute__((section(".ramfunc"), noinline))
+#else
+#define IPC_FWU_RAM
+#endif
+
+#if defined(CORE_CM4)
+_Static_assert(!RINGBUFF_USE_MSG_CRC && !RINGBUFF_USE_TRACE, "Message CRC and trace hooks are in flash, CPU2 programs bank 2 from RAM");
+#endif /* defined(CORE_CM4) */
+_Static_assert(IPC_FWU_CHUNK_LEN % IPC_FWU_WORD_LEN == 0, "Chunk must be multiple of flash word");
+_Static_assert(sizeof(ipc_fwu_hdr_t) == IPC_FWU_WORD_LEN, "Image in staging slot must start on flash word");
+
+/**
+ * \brief           Programming state of CPU2, on stack in RAM
+ */
+typedef struct {
+    uint32_t addr;                              /*!< Address of next flash word */
+    uint32_t len;                               /*!< Image length in units of bytes */
+    uint32_t fed;                               /*!< Number of image bytes received */
+    uint32_t word[IPC_FWU_WORD_LEN / 4];        /*!< Flash word assembled from unaligned or split data */
+    uint32_t word_len;                          /*!< Number of bytes in assembled flash word */
+    uint32_t cyc_per_us;                        /*!< Cycle counter ticks per microsecond */
+    uint32_t erase_cyc;                         /*!< Erase cycles not yet accounted in microseconds */
+    uint32_t prog_cyc;                          /*!< Programming cycles not yet accounted in microseconds */
+    uint32_t stall_cyc;                         /*!< Stall cycles not yet accounted in microseconds */
+} ipc_fwu_run_t;
+
+/* CPU1 local copy of chunk, used when reserved memory would wrap and for verification */
+static uint32_t fwu_stage[IPC_FWU_CHUNK_LEN / 4];
+
+/**
+ * \brief           Add time since start to shared counter in microseconds
+ * \param[in,out]   us: Shared counter
+ * \param[in,out]   cyc: Cycles not yet accounted
+ * \param[in]       start: Cycle counter at start
+ * \param[in]       cyc_per_us: Cycle counter ticks per microsecond
+ */
+static IPC_FWU_RAM void
+prv_time_add(volatile uint32_t* us, uint32_t* cyc, uint32_t start, uint32_t cyc_per_us) {
+    *cyc += CYCCNT_GET() - start;
+    *us += *cyc / cyc_per_us;
+    *cyc %= cyc_per_us;
+}
+
+/**
+ * \brief           Wait for bank 2 operation to finish
+ * \return          `1` on success, `0` on flash error
+ */
+static IPC_FWU_RAM uint8_t
+prv_flash_wait(void) {
+    uint32_t sr;
+
+    while ((sr = FLASH->SR2) & (FLASH_SR_QW | FLASH_SR_BSY)) {}
+    if (sr & IPC_FWU_FLASH_ERR) {
+        IPC_FWU_SHARED->flash_err = sr & IPC_FWU_FLASH_ERR;
+        return 0;
+    }
+    FLASH->CCR2 = FLASH_CCR_CLR_EOP;
+    return 1;
+}
+
+/**
+ * \brief           Program flash word at current address, erase sector first when word starts it
+ * \param[in,out]   run: Programming state
+ * \param[in]       src: Flash word data, word aligned
+ * \return          `1` on success, `0` on flash error
+ */
+static IPC_FWU_RAM uint8_t
+prv_program(ipc_fwu_run_t* run, const uint32_t* src) {
+    volatile ipc_fwu_shared_t* shared = IPC_FWU_SHARED;
+    volatile uint32_t* dst = (volatile uint32_t *)run->addr;
+    uint32_t start;
+    uint8_t ok;
+
+    if ((run->addr - FLASH_BANK2_BASE) % FLASH_SECTOR_SIZE == 0) {
+        shared->state = IPC_FWU_STATE_ERASE;
+        start = CYCCNT_GET();
+        FLASH->CR2 &= ~(FLASH_CR_PSIZE | FLASH_CR_SNB);
+        FLASH->CR2 |= FLASH_CR_SER | FLASH_CR_PSIZE_1
+                        | (((run->addr - FLASH_BANK2_BASE) / FLASH_SECTOR_SIZE) << FLASH_CR_SNB_Pos) | FLASH_CR_START;
+        ok = prv_flash_wait();
+        FLASH->CR2 &= ~(FLASH_CR_SER | FLASH_CR_SNB);
+        prv_time_add(&shared->erase_us, &run->erase_cyc, start, run->cyc_per_us);
+        if (!ok) {
+            return 0;
+        }
+        shared->state = IPC_FWU_STATE_PROGRAM;
+    }
+
+    /* Write buffer is programmed once all 8 words of flash word are written */
+    start = CYCCNT_GET();
+    FLASH->CR2 |= FLASH_CR_PG;
+    __ISB();
+    __DSB();
+    for (size_t i = 0; i < IPC_FWU_WORD_LEN / 4; ++i) {
+        dst[i] = src[i];
+    }
+    __ISB();
+    __DSB();
+    ok = prv_flash_wait();
+    FLASH->CR2 &= ~FLASH_CR_PG;
+    prv_time_add(&shared->prog_us, &run->prog_cyc, start, run->cyc_per_us);
+
+    run->addr += IPC_FWU_WORD_LEN;
+    shared->written = IPC_FWU_MIN(run->addr - FLASH_BANK2_BASE, run->len);
+    return ok;
+}
+
+/**
+ * \brief           Program received image data
+ *
+ * Aligned flash words are programmed directly from channel memory,
+ * words split between messages or ring end are assembled first
+ *
+ * \param[in,out]   run: Programming state
+ * \param[in]       data: Image data
+ * \param[in]       len: Data length in units of bytes
+ * \return          `1` on success, `0` on flash error
+ */
+static IPC_FWU_RAM uint8_t
+prv_feed(ipc_fwu_run_t* run, const uint8_t* data, size_t len) {
+    volatile uint8_t* word = (volatile uint8_t *)run->word;    /* Volatile, byte loop is not turned to flash-resident `memcpy` */
+    size_t n;
+
+    while (len > 0) {
+        if (run->word_len == 0 && len >= IPC_FWU_WORD_LEN && ((uintptr_t)data & 0x03) == 0) {
+            if (!prv_program(run, (const uint32_t *)data)) {
+                return 0;
+            }
+            data += IPC_FWU_WORD_LEN;
+            len -= IPC_FWU_WORD_LEN;
+            continue;
+        }
+        n = IPC_FWU_MIN(IPC_FWU_WORD_LEN - run->word_len, len);
+        for (size_t i = 0; i < n; ++i) {
+            word[run->word_len + i] = data[i];
+        }
+        run->word_len += n;
+        data += n;
+        len -= n;
+        if (run->word_len == IPC_FWU_WORD_LEN) {
+            run->word_len = 0;
+            if (!prv_program(run, run->word)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * \brief           Program image to bank 2, runs on CPU2 from RAM with interrupts masked
+ * \param[in]       rx: Channel from CPU1, header already received
+ * \param[in]       len: Image length in units of bytes
+ */
+static IPC_FWU_RAM __attribute__((noreturn)) void
+prv_run(RINGBUFF_VOLATILE ringbuff_t* rx, uint32_t len) {
+    volatile ipc_fwu_shared_t* shared = IPC_FWU_SHARED;
+    volatile uint8_t* word;
+    ipc_fwu_run_t run;
+    void *ptr1, *ptr2;
+    size_t len1, len2, mlen;
+    uint32_t start;
+    uint8_t ok = 1;
+
+    run.addr = FLASH_BANK2_BASE;
+    run.len = len;
+    run.fed = 0;
+    run.word_len = 0;
+    run.cyc_per_us = CYCCNT_PER_US();
+    run.erase_cyc = 0;
+    run.prog_cyc = 0;
+    run.stall_cyc = 0;
+    shared->state = IPC_FWU_STATE_PROGRAM;
+
+    if (FLASH->CR2 & FLASH_CR_LOCK) {
+        FLASH->KEYR2 = FLASH_KEY1;
+        FLASH->KEYR2 = FLASH_KEY2;
+    }
+    FLASH->CCR2 = IPC_FWU_FLASH_ERR | FLASH_CCR_CLR_EOP;
+
+    while (ok && run.fed < run.len) {
+        /* Flash is idle while channel is empty, time is reported as stall */
+        start = CYCCNT_GET();
+        while ((mlen = ringbuff_msg_recv_acquire(rx, &ptr1, &len1, &ptr2, &len2)) == 0) {}
+        prv_time_add(&shared->stall_us, &run.stall_cyc, start, run.cyc_per_us);
+
+        mlen = IPC_FWU_MIN(mlen, run.len - run.fed);
+        len1 = IPC_FWU_MIN(len1, mlen);
+        ok = prv_feed(&run, ptr1, len1) && prv_feed(&run, ptr2, mlen - len1);
+        run.fed += mlen;
+        ringbuff_msg_recv_release(rx);
+    }
+
+    /* Last flash word is padded with erased value */
+    if (ok && run.word_len > 0) {
+        word = (volatile uint8_t *)run.word;
+        while (run.word_len < IPC_FWU_WORD_LEN) {
+            word[run.word_len++] = 0xFF;
+        }
+        ok = prv_program(&run, run.word);
+    }
+    FLASH->CR2 |= FLASH_CR_LOCK;
+    shared->state = ok ? IPC_FWU_STATE_DONE : IPC_FWU_STATE_ERROR;
+
+    /* Old image is gone, wait for system reset by CPU1 */
+    while (1) {
+        __WFI();
+    }
+}
+
+/**
+ * \brief           Take update request of CPU1, called by CPU2 from application loop
+ *
+ * Function does not return once valid header is received,
+ * CPU2 programs the image and waits for system reset by CPU1
+ *
+ * \param[in]       rx: Channel from CPU1, FWU_CM7_TO_CM4
+ */
+void
+ipc_fwu_poll(RINGBUFF_VOLATILE ringbuff_t* rx) {
+    ipc_fwu_hdr_t hdr;
+    size_t len;
+
+    while ((len = ringbuff_msg_peek_len(rx)) > 0) {
+        if (len != sizeof(hdr)) {
+            ringbuff_msg_recv_release(rx);      /* Chunk of update CPU1 gave up on */
+            continue;
+        }
+        ringbuff_msg_recv(rx, &hdr, sizeof(hdr));
+        if (hdr.magic == IPC_FWU_MAGIC && hdr.len > 0 && hdr.len <= IPC_FWU_SLOT_LEN - sizeof(hdr)) {
+            CYCCNT_INIT();
+            __disable_irq();
+            prv_run(rx, hdr.len);
+        }
+    }
+}
+
+/**
+ * \brief           Update CPU2 image, called by CPU1
+ *
+ * Chunks are read by `read_fn` directly to reserved channel memory. Function returns once
+ * CPU2 programmed the image and bank 2 matches it, caller resets system to boot new image.
+ * CPU2 does not run its application after it took the header, also when update fails
+ *
+ * \param[in]       tx: Channel to CPU2, FWU_CM7_TO_CM4
+ * \param[in]       len: Image length in units of bytes
+ * \param[in]       read_fn: Image source
+ * \param[in]       arg: User argument of `read_fn`
+ * \param[out]      stats: Update result
+ * \return          `1` when bank 2 holds the image, `0` otherwise
+ */
+uint8_t
+ipc_fwu_update(RINGBUFF_VOLATILE ringbuff_t* tx, size_t len, ipc_fwu_read_fn read_fn, void* arg, ipc_fwu_stats_t* stats) {
+    volatile ipc_fwu_shared_t* shared = IPC_FWU_SHARED;
+    ipc_fwu_hdr_t hdr = {0};
+    ipc_wait_t w;
+    size_t off, n;
+    uint32_t start;
+    uint8_t* out;
+    uint8_t ok = 1;
+
+    if (tx == NULL || read_fn == NULL || stats == NULL || len == 0 || len > IPC_FWU_SLOT_LEN - sizeof(hdr)) {
+        return 0;
+    }
+    memset(stats, 0x00, sizeof(*stats));
+    stats->len = len;
+    shared->state = IPC_FWU_STATE_IDLE;
+    shared->written = 0;
+    shared->flash_err = 0;
+    shared->erase_us = 0;
+    shared->prog_us = 0;
+    shared->stall_us = 0;
+
+    /* CPU2 takes header from its application loop */
+    hdr.magic = IPC_FWU_MAGIC;
+    hdr.len = len;
+    start = HAL_GetTick();
+    if (ringbuff_msg_send(tx, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return 0;
+    }
+    ipc_notify(HSEM_FWU_CM7_TO_CM4);
+    ipc_wait_start(&w, IPC_FWU_START_TIMEOUT_US);
+    while (shared->state == IPC_FWU_STATE_IDLE) {
+        if (ipc_wait_expired(&w)) {
+            return 0;
+        }
+    }
+
+    /* Stream chunks, CPU2 drains channel at flash speed */
+    for (off = 0; ok && off < len; off += n) {
+        n = IPC_FWU_MIN(IPC_FWU_CHUNK_LEN, len - off);
+        ipc_wait_start(&w, IPC_FWU_TIMEOUT_US);
+        while (1) {
+            if ((out = ringbuff_msg_send_reserve(tx, n)) != NULL) {
+                ok = read_fn(arg, off, out, n) && ringbuff_msg_send_commit(tx, n) == n;
+                break;
+            }
+            if (ringbuff_get_free(tx) >= sizeof(ringbuff_msg_hdr_t) + n) {
+                ok = read_fn(arg, off, fwu_stage, n) && ringbuff_msg_send(tx, fwu_stage, n) == n;
+                ++stats->copies;
+                break;
+            }
+            if (shared->state == IPC_FWU_STATE_ERROR || ipc_wait_expired(&w)) {
+                ok = 0;
+                break;
+            }
+        }
+        ++stats->chunks;
+    }
+
+    /* Last words are programmed after channel is drained */
+    ipc_wait_start(&w, IPC_FWU_TIMEOUT_US);
+    while (ok && shared->state != IPC_FWU_STATE_DONE) {
+        if (shared->state == IPC_FWU_STATE_ERROR || ipc_wait_expired(&w)) {
+            ok = 0;
+        }
+    }
+
+    /* Verify bank 2, lines read before update may be in D-cache */
+#if defined(CORE_CM7)
+    SCB_InvalidateDCache_by_Addr((void *)FLASH_BANK2_BASE, (int32_t)len);
+#endif /* defined(CORE_CM7) */
+    for (off = 0; ok && off < len; off += n) {
+        n = IPC_FWU_MIN(IPC_FWU_CHUNK_LEN, len - off);
+        ok = read_fn(arg, off, fwu_stage, n) && memcmp((const void *)(FLASH_BANK2_BASE + off), fwu_stage, n) == 0;
+    }
+
+    stats->total_ms = HAL_GetTick() - start;
+    stats->erase_us = shared->erase_us;
+    stats->prog_us = shared->prog_us;
+    stats->stall_us = shared->stall_us;
+    stats->flash_err = shared->flash_err;
+    return ok;
+}
+
+/**
+ * \brief           Check staging slot for CPU2 image, called by CPU1
+ * \param[out]      len: Image length in units of bytes
+ * \return          `1` when slot holds image different from bank 2, `0` otherwise
+ */
+uint8_t
+ipc_fwu_slot_check(size_t* len) {
+    const ipc_fwu_hdr_t* hdr = (const void *)IPC_FWU_SLOT_ADDR;
+
+    if (len == NULL || hdr->magic != IPC_FWU_MAGIC || hdr->len == 0 || hdr->len > IPC_FWU_SLOT_LEN - sizeof(*hdr)
+        || memcmp(hdr + 1, (const void *)FLASH_BANK2_BASE, hdr->len) == 0) {
+        return 0;
+    }
+    *len = hdr->len;
+    return 1;
+}
+
+/**
+ * \brief           Image source for staging slot, \ref ipc_fwu_read_fn
+ * \param[in]       arg: Unused
+ * \param[in]       off: Offset in image in units of bytes
+ * \param[out]      data: Output memory
+ * \param[in]       len: Number of bytes to copy
+ * \return          `1`
+ */
+uint8_t
+ipc_fwu_slot_read(void* arg, size_t off, void* data, size_t len) {
+    memcpy(data, (const uint8_t *)IPC_FWU_SLOT_ADDR + sizeof(ipc_fwu_hdr_t) + off, len);
+    return 1;
+}
+
+/**
+ * \brief           Update CPU2 from staging slot when it holds new image, called by CPU1
+ * \param[in]       tx: Channel to CPU2, FWU_CM7_TO_CM4
+ * \param[in]       out_fn: Output function for report
+ * \return          `1` when bank 2 holds new image and system must be reset, `0` otherwise
+ */
+uint8_t
+ipc_fwu_slot_update(RINGBUFF_VOLATILE ringbuff_t* tx, ipc_fwu_out_fn out_fn) {
+    ipc_fwu_stats_t stats;
+    char str[128];
+    size_t len;
+    uint8_t ok;
+
+    if (!ipc_fwu_slot_check(&len)) {
+        return 0;
+    }
+    ok = ipc_fwu_update(tx, len, ipc_fwu_slot_read, NULL, &stats);
+    if (ok) {
+        len = sprintf(str, "[CM7] fwu %u bytes in %u ms, %u KB/s erase:%u ms prog:%u ms stall:%u ms copies:%u/%u\r\n",
+                      (unsigned)stats.len, (unsigned)stats.total_ms,
+                      (unsigned)(stats.total_ms > 0 ? stats.len / stats.total_ms : 0),
+                      (unsigned)(stats.erase_us / 1000), (unsigned)(stats.prog_us / 1000), (unsigned)(stats.stall_us / 1000),
+                      (unsigned)stats.copies, (unsigned)stats.chunks);
+    } else {
+        len = sprintf(str, "[CM7] fwu failed, written:%u/%u flash_err:0x%08X\r\n",
+                      (unsigned)IPC_FWU_SHARED->written, (unsigned)stats.len, (unsigned)stats.flash_err);
+    }
+    out_fn(str, len);
+    return ok;
+}
+
+#endif /* IPC_FWU */
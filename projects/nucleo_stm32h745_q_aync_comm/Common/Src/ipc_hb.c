@@ -0,0 +1,189 @@
+/**
+ * \file            ipc_hb.c
+ * \brief           Peer heartbeat and health monitor
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_hb.h"
+#include "ipc_chan.h"
+
+#if IPC_HB
+
+/* Peer health */
+#define IPC_HB_SHARED                       (&IPC_SHM->ctrl.hb)
+
+/**
+ * \brief           Heartbeat answer of CPU2
+ */
+typedef struct {
+    uint32_t seq;                               /*!< Echoed sequence number */
+    uint32_t uptime_ms;                         /*!< CPU2 tick */
+} ipc_hb_ack_t;
+
+/**
+ * \brief           Heartbeat call completed, runs on CPU1 from \ref ipc_rpc_client_poll
+ * \param[in]       status: Call status
+ * \param[in]       res: Result, \ref ipc_hb_ack_t
+ * \param[in]       len: Result length in units of bytes
+ * \param[in]       arg: Heartbeat monitor
+ */
+static void
+prv_beat_done(int32_t status, const void* res, size_t len, void* arg) {
+    volatile ipc_hb_shared_t* shared = IPC_HB_SHARED;
+    ipc_hb_t* hb = arg;
+    ipc_hb_ack_t ack;
+    uint32_t rtt;
+
+    hb->in_flight = 0;
+    if (status != IPC_RPC_OK || len != sizeof(ack)) {
+        ++shared->lost;
+        return;
+    }
+    memcpy(&ack, res, sizeof(ack));
+    if (ack.seq != hb->seq) {
+        ++shared->lost;
+        return;
+    }
+
+    rtt = (uint32_t)((uint64_t)(CYCCNT_GET() - hb->start) * 1000 / CYCCNT_PER_US());
+    hb->ack_time = HAL_GetTick();
+    ++shared->acked;
+    shared->peer_uptime_ms = ack.uptime_ms;
+    shared->rtt_last_ns = rtt;
+    shared->rtt_avg_ns = shared->acked == 1 ? rtt : shared->rtt_avg_ns - shared->rtt_avg_ns / 8 + rtt / 8;
+    if (rtt > shared->rtt_max_ns) {
+        shared->rtt_max_ns = rtt;
+    }
+    if (!shared->alive) {
+        shared->alive = 1;
+        if (hb->evt_fn != NULL) {
+            hb->evt_fn(IPC_HB_EVT_RECOVERED);
+        }
+    }
+}
+
+/**
+ * \brief           Initialize heartbeat monitor, CPU2 is considered alive until first window expires
+ * \param[in]       hb: Heartbeat monitor
+ * \param[in]       cli: RPC client to CPU2, CPU2 serves \ref IPC_RPC_METHOD_HEARTBEAT with \ref ipc_hb_rpc_beat
+ * \param[in]       period_ms: Heartbeat period in units of milliseconds
+ * \param[in]       window_ms: Time without answer after which CPU2 is lost, in units of milliseconds
+ * \param[in]       evt_fn: Health change callback, can be `NULL`
+ */
+void
+ipc_hb_init(ipc_hb_t* hb, ipc_rpc_client_t* cli, uint32_t period_ms, uint32_t window_ms, ipc_hb_evt_fn evt_fn) {
+    volatile ipc_hb_shared_t* shared = IPC_HB_SHARED;
+
+    memset(hb, 0x00, sizeof(*hb));
+    hb->cli = cli;
+    hb->period_ms = period_ms;
+    hb->window_ms = window_ms;
+    hb->evt_fn = evt_fn;
+    hb->send_time = hb->ack_time = HAL_GetTick();
+    memset((void *)shared, 0x00, sizeof(*shared));
+    shared->alive = 1;
+}
+
+/**
+ * \brief           Send heartbeat when period elapsed and check peer liveness, call from CPU1 main loop
+ *
+ * Single heartbeat is in flight, its RPC timeout is window.
+ * Answer is served by CPU2 main loop, CPU2 which only runs interrupts is detected as lost too
+ *
+ * \param[in]       hb: Heartbeat monitor
+ * \param[in]       now: Current tick in units of milliseconds
+ * \return          `1` when CPU2 is alive, `0` otherwise
+ */
+uint8_t
+ipc_hb_poll(ipc_hb_t* hb, uint32_t now) {
+    volatile ipc_hb_shared_t* shared = IPC_HB_SHARED;
+    uint32_t seq;
+    void* args;
+
+    if (!hb->in_flight && now - hb->send_time >= hb->period_ms) {
+        if ((args = ipc_rpc_call_reserve(hb->cli, IPC_RPC_METHOD_HEARTBEAT, sizeof(seq))) != NULL) {
+            seq = hb->seq + 1;
+            memcpy(args, &seq, sizeof(seq));
+            hb->start = CYCCNT_GET();
+            if (ipc_rpc_call_commit(hb->cli, sizeof(seq), hb->window_ms * 1000, prv_beat_done, hb) != 0) {
+                hb->seq = seq;
+                ++shared->sent;
+                hb->in_flight = 1;
+                hb->send_time = now;
+            }
+        }
+    }
+    if (shared->alive && now - hb->ack_time >= hb->window_ms) {
+        shared->alive = 0;
+        ++shared->losses;
+        if (hb->evt_fn != NULL) {
+            hb->evt_fn(IPC_HB_EVT_LOST);
+        }
+    }
+    return shared->alive;
+}
+
+/**
+ * \brief           RPC method \ref IPC_RPC_METHOD_HEARTBEAT, runs on CPU2.
+ *                  Result is echoed sequence number and CPU2 tick
+ */
+int32_t
+ipc_hb_rpc_beat(const void* args, size_t len, void* res, size_t* res_len) {
+    ipc_hb_ack_t ack;
+
+    if (len != sizeof(ack.seq) || *res_len < sizeof(ack)) {
+        return IPC_RPC_ERR_ARGS;
+    }
+    memcpy(&ack.seq, args, sizeof(ack.seq));
+    ack.uptime_ms = HAL_GetTick();
+    memcpy(res, &ack, sizeof(ack));
+    *res_len = sizeof(ack);
+    return IPC_RPC_OK;
+}
+
+/**
+ * \brief           Check if CPU2 answered within window
+ * \return          `1` when alive, `0` otherwise
+ */
+uint8_t
+ipc_hb_is_alive(void) {
+    return IPC_HB_SHARED->alive;
+}
+
+/**
+ * \brief           Get peer health, from any core
+ * \param[out]      stats: Copy of health record
+ */
+void
+ipc_hb_get_stats(ipc_hb_shared_t* stats) {
+    memcpy(stats, (const void *)IPC_HB_SHARED, sizeof(*stats));
+}
+
+#endif /* IPC_HB */
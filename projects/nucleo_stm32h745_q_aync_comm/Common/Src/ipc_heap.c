@@ -0,0 +1,365 @@
+/**
+ * \file            ipc_heap.c
+ * \brief           Variable-size shared heap
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_heap.h"
+#include "ipc_chan.h"
+
+#if IPC_HEAP
+
+/*
+ * Two-level segregated fit allocator, TLSF. Free blocks are kept in lists by size class:
+ * first level is power of 2, second level splits it to IPC_HEAP_SL_COUNT linear ranges.
+ * Bitmaps of non-empty lists find suitable free block with two bit scans, allocation and free are O(1).
+ *
+ * Every block starts with header, offset of physically previous block and block size.
+ * Free block keeps free list links in its payload. Free neighbours are merged on free.
+ * Heap ends with zero-size used sentinel block.
+ *
+ * Heap is in shared RAM, at the same address for both cores. All operations run
+ * with local interrupts disabled and HSEM_HEAP taken, only for list and header updates
+ */
+
+/* Heap memory, control structure first */
+#define IPC_HEAP_MEM                        ((uint8_t *)ipc_shm.heap)
+#define IPC_HEAP_CTRL                       ((ipc_heap_ctrl_t *)IPC_HEAP_MEM)
+
+/* Block header length and minimum block length, header and free list links */
+#define IPC_HEAP_HDR_LEN                    8
+#define IPC_HEAP_MIN_BLOCK                  16
+
+/* Block is free, bit in size field */
+#define IPC_HEAP_FLAG_FREE                  0x00000001
+
+/* Offset of first block and of sentinel block */
+#define IPC_HEAP_FIRST                      ((sizeof(ipc_heap_ctrl_t) + IPC_HEAP_ALIGN - 1) & ~(IPC_HEAP_ALIGN - 1))
+#define IPC_HEAP_END                        ((IPC_SHM_HEAP_LEN - IPC_HEAP_HDR_LEN) & ~(IPC_HEAP_ALIGN - 1))
+
+_Static_assert(IPC_SHM_HEAP_LEN <= (1UL << IPC_HEAP_FL_MAX), "Heap is longer than largest size class");
+_Static_assert(IPC_HEAP_END > IPC_HEAP_FIRST + IPC_HEAP_MIN_BLOCK, "Heap is too small for control structure");
+
+/**
+ * \brief           Block header
+ */
+typedef struct {
+    uint32_t prev_phys;                         /*!< Offset of physically previous block */
+    uint32_t size;                              /*!< Block length including header, \ref IPC_HEAP_FLAG_FREE */
+    uint32_t next_free;                         /*!< Next block in free list, valid for free block only */
+    uint32_t prev_free;                         /*!< Previous block in free list, valid for free block only */
+} ipc_heap_block_t;
+
+/* Block at offset */
+#define IPC_HEAP_BLOCK(off)                 ((ipc_heap_block_t *)(IPC_HEAP_MEM + (off)))
+#define IPC_HEAP_BLOCK_SIZE(b)              ((b)->size & ~IPC_HEAP_FLAG_FREE)
+
+/**
+ * \brief           Take heap lock, disables local interrupts
+ * \return          Previous interrupt mask, for \ref prv_unlock
+ */
+static uint32_t
+prv_lock(void) {
+    return ipc_lock_take(&IPC_HEAP_CTRL->lock);
+}
+
+/**
+ * \brief           Release heap lock
+ * \param[in]       primask: Interrupt mask from \ref prv_lock
+ */
+static void
+prv_unlock(uint32_t primask) {
+    ipc_lock_release(&IPC_HEAP_CTRL->lock, primask);
+}
+
+/**
+ * \brief           Get size class of block
+ * \param[in]       size: Block length
+ * \param[out]      fl: First-level index
+ * \param[out]      sl: Second-level index
+ */
+static void
+prv_mapping(uint32_t size, uint32_t* fl, uint32_t* sl) {
+    uint32_t f;
+
+    if (size < IPC_HEAP_SMALL_LEN) {
+        *fl = 0;
+        *sl = size / (IPC_HEAP_SMALL_LEN / IPC_HEAP_SL_COUNT);
+    } else {
+        f = 31 - __builtin_clz(size);
+        *sl = (size >> (f - IPC_HEAP_SL_LOG2)) ^ IPC_HEAP_SL_COUNT;
+        *fl = f - (IPC_HEAP_FL_SHIFT - 1);
+    }
+}
+
+/**
+ * \brief           Insert free block to its list
+ * \param[in]       ctrl: Heap control
+ * \param[in]       off: Block offset
+ */
+static void
+prv_insert(ipc_heap_ctrl_t* ctrl, uint32_t off) {
+    ipc_heap_block_t* b = IPC_HEAP_BLOCK(off);
+    uint32_t fl, sl;
+
+    prv_mapping(IPC_HEAP_BLOCK_SIZE(b), &fl, &sl);
+    b->next_free = ctrl->free[fl][sl];
+    b->prev_free = 0;
+    if (b->next_free != 0) {
+        IPC_HEAP_BLOCK(b->next_free)->prev_free = off;
+    }
+    ctrl->free[fl][sl] = off;
+    ctrl->fl_bitmap |= 1UL << fl;
+    ctrl->sl_bitmap[fl] |= 1UL << sl;
+}
+
+/**
+ * \brief           Remove free block from its list
+ * \param[in]       ctrl: Heap control
+ * \param[in]       off: Block offset
+ */
+static void
+prv_remove(ipc_heap_ctrl_t* ctrl, uint32_t off) {
+    ipc_heap_block_t* b = IPC_HEAP_BLOCK(off);
+    uint32_t fl, sl;
+
+    prv_mapping(IPC_HEAP_BLOCK_SIZE(b), &fl, &sl);
+    if (b->prev_free != 0) {
+        IPC_HEAP_BLOCK(b->prev_free)->next_free = b->next_free;
+    } else {
+        ctrl->free[fl][sl] = b->next_free;
+    }
+    if (b->next_free != 0) {
+        IPC_HEAP_BLOCK(b->next_free)->prev_free = b->prev_free;
+    }
+    if (ctrl->free[fl][sl] == 0) {
+        ctrl->sl_bitmap[fl] &= ~(1UL << sl);
+        if (ctrl->sl_bitmap[fl] == 0) {
+            ctrl->fl_bitmap &= ~(1UL << fl);
+        }
+    }
+}
+
+/**
+ * \brief           Initialize heap, single free block.
+ *                  Called by CPU1 from \ref ipc_chan_dir_init
+ */
+void
+ipc_heap_init(void) {
+    ipc_heap_ctrl_t* ctrl = IPC_HEAP_CTRL;
+    ipc_heap_block_t* b;
+
+    memset(ctrl, 0x00, sizeof(*ctrl));
+    ipc_lock_init(&ctrl->lock, HSEM_HEAP);
+    ctrl->total = IPC_HEAP_END - IPC_HEAP_FIRST;
+
+    b = IPC_HEAP_BLOCK(IPC_HEAP_FIRST);
+    b->prev_phys = 0;
+    b->size = ctrl->total | IPC_HEAP_FLAG_FREE;
+    prv_insert(ctrl, IPC_HEAP_FIRST);
+
+    b = IPC_HEAP_BLOCK(IPC_HEAP_END);           /* Sentinel, never merged */
+    b->prev_phys = IPC_HEAP_FIRST;
+    b->size = 0;
+    __DSB();
+}
+
+/**
+ * \brief           Allocate memory from shared heap
+ * \param[in]       len: Number of bytes
+ * \return          Memory aligned to \ref IPC_HEAP_ALIGN bytes, `NULL` if no free block is large enough
+ */
+void *
+ipc_heap_alloc(size_t len) {
+    ipc_heap_ctrl_t* ctrl = IPC_HEAP_CTRL;
+    ipc_heap_block_t* b;
+    uint32_t need, search, fl, sl, map, off, size, rem, primask;
+
+    if (len == 0 || len > IPC_SHM_HEAP_LEN) {
+        return NULL;
+    }
+    need = (uint32_t)((len + IPC_HEAP_HDR_LEN + IPC_HEAP_ALIGN - 1) & ~(IPC_HEAP_ALIGN - 1));
+    if (need < IPC_HEAP_MIN_BLOCK) {
+        need = IPC_HEAP_MIN_BLOCK;
+    }
+
+    /* Round up to next size class, every block in found list is large enough */
+    search = need;
+    if (search >= IPC_HEAP_SMALL_LEN) {
+        search += (1UL << (31 - __builtin_clz(search) - IPC_HEAP_SL_LOG2)) - 1;
+    }
+    prv_mapping(search, &fl, &sl);
+
+    primask = prv_lock();
+    map = fl < IPC_HEAP_FL_COUNT ? ctrl->sl_bitmap[fl] & (~0UL << sl) : 0;
+    if (map == 0) {
+        map = fl + 1 < IPC_HEAP_FL_COUNT ? ctrl->fl_bitmap & (~0UL << (fl + 1)) : 0;
+        if (map == 0) {
+            ++ctrl->fails;
+            prv_unlock(primask);
+            return NULL;
+        }
+        fl = __builtin_ctz(map);
+        map = ctrl->sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(map);
+    off = ctrl->free[fl][sl];
+    prv_remove(ctrl, off);
+
+    /* Split remainder to new free block */
+    b = IPC_HEAP_BLOCK(off);
+    size = IPC_HEAP_BLOCK_SIZE(b);
+    if (size - need >= IPC_HEAP_MIN_BLOCK) {
+        rem = off + need;
+        IPC_HEAP_BLOCK(rem)->prev_phys = off;
+        IPC_HEAP_BLOCK(rem)->size = (size - need) | IPC_HEAP_FLAG_FREE;
+        IPC_HEAP_BLOCK(off + size)->prev_phys = rem;
+        prv_insert(ctrl, rem);
+        size = need;
+    }
+    b->size = size;
+
+    ctrl->used += size;
+    if (ctrl->used > ctrl->peak) {
+        ctrl->peak = ctrl->used;
+    }
+    ++ctrl->allocs;
+    prv_unlock(primask);
+    return (uint8_t *)b + IPC_HEAP_HDR_LEN;
+}
+
+/**
+ * \brief           Free memory allocated by either core
+ * \param[in]       ptr: Memory from \ref ipc_heap_alloc, `NULL` is ignored
+ */
+void
+ipc_heap_free(void* ptr) {
+    ipc_heap_ctrl_t* ctrl = IPC_HEAP_CTRL;
+    ipc_heap_block_t* b;
+    uint32_t off, size, next, prev, primask;
+
+    if (ptr == NULL || (uint8_t *)ptr < IPC_HEAP_MEM + IPC_HEAP_FIRST + IPC_HEAP_HDR_LEN
+        || (uint8_t *)ptr >= IPC_HEAP_MEM + IPC_HEAP_END
+        || ((uint32_t)ptr & (IPC_HEAP_ALIGN - 1)) != 0) {
+        return;
+    }
+    off = (uint32_t)((uint8_t *)ptr - IPC_HEAP_MEM) - IPC_HEAP_HDR_LEN;
+
+    primask = prv_lock();
+    b = IPC_HEAP_BLOCK(off);
+    if (b->size & IPC_HEAP_FLAG_FREE) {
+        prv_unlock(primask);                    /* Double free */
+        return;
+    }
+    size = IPC_HEAP_BLOCK_SIZE(b);
+    ctrl->used -= size;
+
+    /* Merge with next and previous free blocks */
+    next = off + size;
+    if (IPC_HEAP_BLOCK(next)->size & IPC_HEAP_FLAG_FREE) {
+        prv_remove(ctrl, next);
+        size += IPC_HEAP_BLOCK_SIZE(IPC_HEAP_BLOCK(next));
+    }
+    prev = b->prev_phys;
+    if (off != IPC_HEAP_FIRST && (IPC_HEAP_BLOCK(prev)->size & IPC_HEAP_FLAG_FREE)) {
+        prv_remove(ctrl, prev);
+        size += IPC_HEAP_BLOCK_SIZE(IPC_HEAP_BLOCK(prev));
+        off = prev;
+    }
+    IPC_HEAP_BLOCK(off)->size = size | IPC_HEAP_FLAG_FREE;
+    IPC_HEAP_BLOCK(off + size)->prev_phys = off;
+    prv_insert(ctrl, off);
+    prv_unlock(primask);
+}
+
+/**
+ * \brief           Get offset of heap memory, to be sent in message to other core
+ * \param[in]       ptr: Memory from \ref ipc_heap_alloc
+ * \return          Offset from heap start, `0` for invalid pointer
+ */
+uint32_t
+ipc_heap_ptr_to_off(const void* ptr) {
+    if ((const uint8_t *)ptr < IPC_HEAP_MEM + IPC_HEAP_FIRST || (const uint8_t *)ptr >= IPC_HEAP_MEM + IPC_HEAP_END) {
+        return 0;
+    }
+    return (uint32_t)((const uint8_t *)ptr - IPC_HEAP_MEM);
+}
+
+/**
+ * \brief           Get heap memory from offset received from other core
+ * \param[in]       off: Offset from \ref ipc_heap_ptr_to_off
+ * \return          Memory, `NULL` for invalid offset
+ */
+void *
+ipc_heap_off_to_ptr(uint32_t off) {
+    if (off < IPC_HEAP_FIRST || off >= IPC_HEAP_END) {
+        return NULL;
+    }
+    return IPC_HEAP_MEM + off;
+}
+
+/**
+ * \brief           Get heap usage and fragmentation
+ * \param[out]      stats: Output statistics
+ */
+void
+ipc_heap_get_stats(ipc_heap_stats_t* stats) {
+    ipc_heap_ctrl_t* ctrl = IPC_HEAP_CTRL;
+    uint32_t fl, sl, off, free_len, primask;
+
+    if (stats == NULL) {
+        return;
+    }
+    primask = prv_lock();
+    stats->total = ctrl->total;
+    stats->used = ctrl->used;
+    stats->peak = ctrl->peak;
+    stats->allocs = ctrl->allocs;
+    stats->fails = ctrl->fails;
+
+    /* Largest free block is in highest non-empty list */
+    stats->largest_free = 0;
+    if (ctrl->fl_bitmap != 0) {
+        fl = 31 - __builtin_clz(ctrl->fl_bitmap);
+        sl = 31 - __builtin_clz(ctrl->sl_bitmap[fl]);
+        for (off = ctrl->free[fl][sl]; off != 0; off = IPC_HEAP_BLOCK(off)->next_free) {
+            if (IPC_HEAP_BLOCK_SIZE(IPC_HEAP_BLOCK(off)) > stats->largest_free) {
+                stats->largest_free = IPC_HEAP_BLOCK_SIZE(IPC_HEAP_BLOCK(off));
+            }
+        }
+    }
+    prv_unlock(primask);
+    ipc_lock_get_stats(&ctrl->lock, &stats->lock);
+
+    free_len = stats->total - stats->used;
+    stats->frag = free_len > 0 ? 1000 - (uint32_t)((uint64_t)stats->largest_free * 1000 / free_len) : 0;
+}
+
+#endif /* IPC_HEAP */
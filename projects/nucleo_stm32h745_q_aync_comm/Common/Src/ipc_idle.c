@@ -0,0 +1,103 @@
+/**
+ * \file            ipc_idle.c
+ * \brief           CPU2 idle with D2 domain stop
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_idle.h"
+#include "ipc_lat.h"
+
+#if IPC_IDLE_STOP
+
+#if !IPC_SCHED
+#error "IPC_IDLE_STOP needs IPC_SCHED, periodic work of main loop is always due otherwise"
+#endif
+
+/*
+ * CPU2 enters CStop, core clock and SysTick stop. D2 domain enters DStop too
+ * when no D2 peripheral is allocated by CPU1, its RAM and registers are retained.
+ * Channels are in SRAM4 in D3 domain, which keeps running with CPU1.
+ *
+ * Stop is entered with interrupts disabled and WFI, pending HSEM interrupt of doorbell wakes up core,
+ * handler runs once caller enables interrupts. System clock is not changed by D2 stop, CPU1 owns it
+ */
+
+static uint32_t idle_stops;
+#if IPC_LAT
+static uint32_t idle_wakes;
+static uint64_t idle_wake_sum;                  /* Timebase ticks */
+static uint32_t idle_wake_max;
+#endif /* IPC_LAT */
+
+/**
+ * \brief           Stop CPU2 until doorbell, call with interrupts disabled
+ *                  when no timer runs and no data are left to process.
+ *                  Coalesced doorbells of CPU2 writes must be rung before
+ */
+void
+ipc_idle_stop(void) {
+#if IPC_LAT
+    uint32_t start, stamp, now;
+
+    start = ipc_lat_now();
+#endif /* IPC_LAT */
+    ++idle_stops;
+    HAL_PWREx_EnterSTOPMode(PWR_MAINREGULATOR_ON, PWR_STOPENTRY_WFI, PWR_D2_DOMAIN);
+#if IPC_LAT
+    /* Wake-to-first-byte, when CPU1 wrote data during stop */
+    now = ipc_lat_now();
+    if (ipc_lat_last_stamp(IPC_CHAN_CM7_TO_CM4, &stamp) && (int32_t)(stamp - start) >= 0) {
+        ++idle_wakes;
+        idle_wake_sum += now - stamp;
+        if (now - stamp > idle_wake_max) {
+            idle_wake_max = now - stamp;
+        }
+    }
+#endif /* IPC_LAT */
+}
+
+/**
+ * \brief           Get idle statistics of CPU2
+ * \param[out]      stats: Output statistics, wake-up latency is `0` without `IPC_LAT`
+ */
+void
+ipc_idle_get_stats(ipc_idle_stats_t* stats) {
+    stats->stops = idle_stops;
+#if IPC_LAT
+    stats->wakes = idle_wakes;
+    stats->wake_avg_ns = idle_wakes > 0 ? ipc_lat_to_ns((uint32_t)(idle_wake_sum / idle_wakes)) : 0;
+    stats->wake_max_ns = ipc_lat_to_ns(idle_wake_max);
+#else
+    stats->wakes = 0;
+    stats->wake_avg_ns = 0;
+    stats->wake_max_ns = 0;
+#endif /* IPC_LAT */
+}
+
+#endif /* IPC_IDLE_STOP */
@@ -0,0 +1,315 @@
+/**
+ * \file            ipc_job.c
+ * \brief           Job offload from CPU1 to CPU2
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_job.h"
+#include "ipc_notify.h"
+
+#if IPC_JOB
+
+/*
+ * CPU1 submits job descriptors, header and arguments, as messages to job channel
+ * and rings doorbell once per batch, with ipc_job_flush.
+ * CPU2 executes all queued jobs from its loop and writes one completion message per job,
+ * header with status and result, and rings doorbell of completion channel once per batch.
+ *
+ * Header carries address of CPU1 future and CPU1 cycle counter at submit,
+ * both are echoed back unchanged, CPU2 keeps no state of jobs in flight.
+ * Latency is therefore measured with single clock, including queueing and execution time
+ */
+
+/* Completion with maximum result, including message header */
+#define IPC_JOB_COMPL_LEN                   (sizeof(ringbuff_msg_hdr_t) + sizeof(ipc_job_hdr_t) + IPC_JOB_MAX_LEN)
+
+/* Completions taken per burst on CPU1 */
+#define IPC_JOB_POLL_BATCH                  8
+
+/**
+ * \brief           Initialize submitting side on CPU1
+ * \param[in]       q: Queue handle
+ * \param[in]       tx: Job channel buffer handle, producer side
+ * \param[in]       rx: Completion channel buffer handle, consumer side
+ * \param[in]       sem_id: Job channel doorbell
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_job_queue_init(ipc_job_queue_t* q, RINGBUFF_VOLATILE ringbuff_t* tx, RINGBUFF_VOLATILE ringbuff_t* rx, uint32_t sem_id) {
+    if (q == NULL || tx == NULL || rx == NULL) {
+        return 0;
+    }
+    memset(q, 0x00, sizeof(*q));
+    q->tx = tx;
+    q->rx = rx;
+    q->sem_id = sem_id;
+    q->lat_min = UINT32_MAX;
+    CYCCNT_INIT();                              /* Latency time base */
+    return 1;
+}
+
+/**
+ * \brief           Submit job to CPU2.
+ *                  Doorbell is not rung, call \ref ipc_job_flush after last job of batch
+ * \param[in]       q: Queue handle
+ * \param[in]       fn_id: Function ID
+ * \param[in]       args: Job arguments, copied to job channel
+ * \param[in]       len: Length of arguments, up to \ref IPC_JOB_MAX_LEN bytes
+ * \param[out]      future: Future, \ref IPC_JOB_PENDING until completion is received by \ref ipc_job_poll.
+ *                      It must stay valid until then
+ * \return          `1` if job was queued, `0` if job channel is full or parameters are invalid
+ */
+uint8_t
+ipc_job_submit(ipc_job_queue_t* q, uint16_t fn_id, const void* args, size_t len, ipc_job_future_t* future) {
+    uint8_t stage[sizeof(ipc_job_hdr_t) + IPC_JOB_MAX_LEN];
+    ipc_job_hdr_t hdr;
+    uint8_t* out;
+    uint8_t ok;
+
+    if (q == NULL || future == NULL || len > IPC_JOB_MAX_LEN || (args == NULL && len > 0)) {
+        return 0;
+    }
+    hdr.tag = (uint32_t)future;
+    hdr.fn = fn_id;
+    hdr.status = 0;
+
+    /* Descriptor is written in place when linear memory is available */
+    out = ringbuff_msg_send_reserve(q->tx, sizeof(hdr) + len);
+    if (out == NULL) {
+        out = stage;
+    }
+    if (len > 0) {
+        memcpy(out + sizeof(hdr), args, len);
+    }
+    hdr.start = CYCCNT_GET();
+    memcpy(out, &hdr, sizeof(hdr));
+    if (out == stage) {
+        ok = ringbuff_msg_send(q->tx, stage, sizeof(hdr) + len) > 0;
+    } else {
+        ok = ringbuff_msg_send_commit(q->tx, sizeof(hdr) + len) > 0;
+    }
+    if (!ok) {
+        return 0;
+    }
+
+    /* Completion is resolved by ipc_job_poll of the same core, never before this point */
+    future->status = IPC_JOB_PENDING;
+    ++q->batch;
+    ++q->submitted;
+    if (q->submitted - q->completed > q->max_depth) {
+        q->max_depth = q->submitted - q->completed;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Ring CPU2 doorbell once for all jobs submitted since last call
+ * \param[in]       q: Queue handle
+ */
+void
+ipc_job_flush(ipc_job_queue_t* q) {
+    if (q != NULL && q->batch > 0) {
+        q->batch = 0;
+        ipc_notify(q->sem_id);
+    }
+}
+
+/**
+ * \brief           Receive completions and resolve their futures, on CPU1.
+ *                  Burst of completions is taken with single load of write pointer of CPU2
+ *                  and released with single store of read pointer
+ * \param[in]       q: Queue handle
+ * \return          Number of completed jobs
+ */
+size_t
+ipc_job_poll(ipc_job_queue_t* q) {
+    uint8_t msg[sizeof(ipc_job_hdr_t) + IPC_JOB_MAX_LEN];
+    ringbuff_msg_span_t spans[IPC_JOB_POLL_BATCH];
+    ipc_job_future_t* future;
+    ipc_job_hdr_t hdr;
+    size_t len, cnt, n = 0;
+    const uint8_t* d;
+    uint32_t lat;
+
+    if (q == NULL) {
+        return 0;
+    }
+    while ((cnt = ringbuff_msg_recv_batch(q->rx, spans, IPC_JOB_POLL_BATCH)) > 0) {
+        for (size_t i = 0; i < cnt; ++i) {
+            len = spans[i].len1 + spans[i].len2;
+            if (len < sizeof(hdr) || len > sizeof(msg)) {
+                continue;                       /* Invalid completion, removed from channel with batch */
+            }
+            d = spans[i].ptr1;
+            if (spans[i].len2 > 0) {
+                /* Completion wraps at end of channel */
+                memcpy(msg, spans[i].ptr1, spans[i].len1);
+                memcpy(&msg[spans[i].len1], spans[i].ptr2, spans[i].len2);
+                d = msg;
+            }
+            memcpy(&hdr, d, sizeof(hdr));
+            lat = CYCCNT_GET() - hdr.start;
+            future = (ipc_job_future_t *)hdr.tag;
+
+            future->lat = lat;
+            future->res_len = len - sizeof(hdr);
+            memcpy(future->res, &d[sizeof(hdr)], future->res_len);
+            __DMB();                            /* Result before status */
+            future->status = hdr.status;
+
+            ++q->completed;
+            q->lat_sum += lat;
+            if (lat < q->lat_min) {
+                q->lat_min = lat;
+            }
+            if (lat > q->lat_max) {
+                q->lat_max = lat;
+            }
+            ++n;
+        }
+        ringbuff_msg_recv_batch_release(q->rx, cnt);
+    }
+    return n;
+}
+
+/**
+ * \brief           Get queue depth and latency statistics
+ * \param[in]       q: Queue handle
+ * \param[out]      stats: Statistics
+ */
+void
+ipc_job_get_stats(ipc_job_queue_t* q, ipc_job_stats_t* stats) {
+    if (q == NULL || stats == NULL) {
+        return;
+    }
+    stats->submitted = q->submitted;
+    stats->completed = q->completed;
+    stats->depth = q->submitted - q->completed;
+    stats->max_depth = q->max_depth;
+    stats->lat_min = q->completed > 0 ? q->lat_min : 0;
+    stats->lat_max = q->lat_max;
+    stats->lat_avg = q->completed > 0 ? (uint32_t)(q->lat_sum / q->completed) : 0;
+}
+
+/**
+ * \brief           Initialize executing side on CPU2
+ * \param[in]       w: Worker handle
+ * \param[in]       rx: Job channel buffer handle, consumer side
+ * \param[in]       tx: Completion channel buffer handle, producer side
+ * \param[in]       sem_id: Completion channel doorbell
+ * \param[in]       fns: Function table
+ * \param[in]       count: Number of entries in function table
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_job_worker_init(ipc_job_worker_t* w, RINGBUFF_VOLATILE ringbuff_t* rx, RINGBUFF_VOLATILE ringbuff_t* tx,
+                    uint32_t sem_id, const ipc_job_entry_t* fns, size_t count) {
+    if (w == NULL || rx == NULL || tx == NULL || (fns == NULL && count > 0)) {
+        return 0;
+    }
+    w->rx = rx;
+    w->tx = tx;
+    w->sem_id = sem_id;
+    w->fns = fns;
+    w->count = count;
+    return 1;
+}
+
+/**
+ * \brief           Execute all queued jobs, on CPU2.
+ *
+ * Job stays queued while completion channel cannot accept completion with maximum result,
+ * CPU1 doorbell is rung once after last executed job
+ *
+ * \param[in]       w: Worker handle
+ * \return          Number of executed jobs
+ */
+size_t
+ipc_job_worker_poll(ipc_job_worker_t* w) {
+    uint8_t in[sizeof(ipc_job_hdr_t) + IPC_JOB_MAX_LEN];
+    void *addr1, *addr2;
+    size_t len, len1, len2, res_len, n = 0;
+    const uint8_t* job;
+    ipc_job_hdr_t hdr;
+    uint8_t* out;
+
+    if (w == NULL) {
+        return 0;
+    }
+    while (ringbuff_get_free(w->tx) >= IPC_JOB_COMPL_LEN
+            && (len = ringbuff_msg_recv_acquire(w->rx, &addr1, &len1, &addr2, &len2)) > 0) {
+        if (len < sizeof(hdr) || len > sizeof(in)) {
+            ringbuff_msg_recv_release(w->rx);   /* Invalid descriptor */
+            continue;
+        }
+
+        /* Arguments are used in place, unless descriptor wraps at end of buffer */
+        job = addr1;
+        if (len2 > 0) {
+            memcpy(in, addr1, len1);
+            memcpy(&in[len1], addr2, len2);
+            job = in;
+        }
+        memcpy(&hdr, job, sizeof(hdr));
+
+        out = ringbuff_msg_send_reserve(w->tx, sizeof(hdr) + IPC_JOB_MAX_LEN);
+        if (out == NULL) {
+            out = w->stage;
+        }
+        res_len = 0;
+        hdr.status = IPC_JOB_ERR_FN;
+        for (size_t i = 0; i < w->count; ++i) {
+            if (w->fns[i].fn_id == hdr.fn) {
+                res_len = IPC_JOB_MAX_LEN;
+                hdr.status = (int16_t)w->fns[i].fn(job + sizeof(hdr), len - sizeof(hdr), out + sizeof(hdr), &res_len);
+                if (res_len > IPC_JOB_MAX_LEN) {
+                    res_len = IPC_JOB_MAX_LEN;
+                }
+                break;
+            }
+        }
+        memcpy(out, &hdr, sizeof(hdr));
+        ringbuff_msg_recv_release(w->rx);
+
+        /* Free memory was checked, completion is not dropped */
+        if (out == w->stage) {
+            ringbuff_msg_send(w->tx, out, sizeof(hdr) + res_len);
+        } else {
+            ringbuff_msg_send_commit(w->tx, sizeof(hdr) + res_len);
+        }
+        ++n;
+    }
+    if (n > 0) {
+        ipc_notify(w->sem_id);
+    }
+    return n;
+}
+
+#endif /* IPC_JOB */
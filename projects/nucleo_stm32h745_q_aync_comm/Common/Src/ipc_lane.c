@@ -0,0 +1,160 @@
+/**
+ * \file            ipc_lane.c
+ * \brief           Priority lanes, control and bulk channel per direction
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_lane.h"
+#include "ipc_notify.h"
+
+/*
+ * Each direction has small control channel with message records and its own doorbell,
+ * next to bulk channel. Control messages never queue behind bulk data,
+ * consumer serves control lane first and bulk lane only when control lane is empty,
+ * or once after every `bulk_every` control messages when bulk data are waiting
+ */
+
+/**
+ * \brief           Initialize producer side of control lane
+ * \param[in]       tx: Producer handle
+ * \param[in]       ctrl: Control channel buffer handle, producer side
+ * \param[in]       sem_id: Control channel doorbell semaphore
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_lane_tx_init(ipc_lane_tx_t* tx, RINGBUFF_VOLATILE ringbuff_t* ctrl, uint32_t sem_id) {
+    if (tx == NULL || ctrl == NULL) {
+        return 0;
+    }
+    tx->ctrl = ctrl;
+    tx->sem_id = sem_id;
+    return 1;
+}
+
+/**
+ * \brief           Send control message and ring control doorbell immediately, without coalescing
+ * \param[in]       tx: Producer handle
+ * \param[in]       data: Message data
+ * \param[in]       len: Message length in units of bytes
+ * \return          `len` on success, `0` if control channel is full
+ */
+size_t
+ipc_lane_ctrl_send(ipc_lane_tx_t* tx, const void* data, size_t len) {
+    if (tx == NULL || ringbuff_msg_send(tx->ctrl, data, len) == 0) {
+        return 0;
+    }
+    ipc_notify(tx->sem_id);
+    return len;
+}
+
+/**
+ * \brief           Initialize consumer side of control and bulk lane
+ * \param[in]       rx: Consumer handle
+ * \param[in]       ctrl: Control channel buffer handle, consumer side
+ * \param[in]       bulk: Bulk channel buffer handle, consumer side
+ * \param[in]       bulk_every: Starvation protection of bulk lane, number of consecutive control
+ *                      messages after which waiting bulk data are served once. `0` for strict priority
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_lane_rx_init(ipc_lane_rx_t* rx, RINGBUFF_VOLATILE ringbuff_t* ctrl, RINGBUFF_VOLATILE ringbuff_t* bulk, uint32_t bulk_every) {
+    if (rx == NULL || ctrl == NULL || bulk == NULL) {
+        return 0;
+    }
+    rx->ctrl = ctrl;
+    rx->bulk = bulk;
+    rx->bulk_every = bulk_every;
+    rx->ctrl_run = 0;
+    return 1;
+}
+
+/**
+ * \brief           Select lane to serve next.
+ *                  Caller must then read one control message or one block of bulk data, respectively
+ * \param[in]       rx: Consumer handle
+ * \return          Lane to serve, \ref IPC_LANE_NONE if both are empty
+ */
+ipc_lane_t
+ipc_lane_next(ipc_lane_rx_t* rx) {
+    uint8_t ctrl, bulk;
+
+    ctrl = ringbuff_msg_peek_len(rx->ctrl) > 0;
+    bulk = ringbuff_get_full(rx->bulk) > 0;
+    if (ctrl && (!bulk || rx->bulk_every == 0 || rx->ctrl_run < rx->bulk_every)) {
+        if (bulk) {
+            ++rx->ctrl_run;
+        }
+        return IPC_LANE_CTRL;
+    }
+    rx->ctrl_run = 0;
+    return bulk ? IPC_LANE_BULK : IPC_LANE_NONE;
+}
+
+/**
+ * \brief           Receive control message.
+ *                  Message longer than `data` array is dropped, it would block control lane otherwise
+ * \param[in]       ctrl: Control channel buffer handle, consumer side
+ * \param[out]      data: Memory to copy message to
+ * \param[in]       size: Size of `data` array in units of bytes
+ * \return          Message length in units of bytes, `0` if there is no message.
+ *                      Value greater than `size` when message was dropped
+ */
+size_t
+ipc_lane_ctrl_recv(RINGBUFF_VOLATILE ringbuff_t* ctrl, void* data, size_t size) {
+    size_t len;
+
+    len = ringbuff_msg_peek_len(ctrl);
+    if (len > size) {
+        ringbuff_msg_recv_release(ctrl);
+        return len;
+    }
+    return len > 0 ? ringbuff_msg_recv(ctrl, data, size) : 0;
+}
+
+/**
+ * \brief           Read next control message or bulk data, control lane first
+ * \param[in]       rx: Consumer handle
+ * \param[out]      data: Memory to copy data to, must fit largest control message
+ * \param[in]       size: Size of `data` array in units of bytes, maximum bulk block length
+ * \param[out]      lane: Output variable to write lane of returned data to
+ * \return          Number of bytes read, `0` if both lanes are empty.
+ *                      Value greater than `size` for dropped control message, see \ref ipc_lane_ctrl_recv
+ */
+size_t
+ipc_lane_read(ipc_lane_rx_t* rx, void* data, size_t size, ipc_lane_t* lane) {
+    *lane = ipc_lane_next(rx);
+    switch (*lane) {
+        case IPC_LANE_CTRL:
+            return ipc_lane_ctrl_recv(rx->ctrl, data, size);
+        case IPC_LANE_BULK:
+            return ringbuff_read(rx->bulk, data, size);
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,305 @@
+/**
+ * \file            ipc_lat.c
+ * \brief           Inter-core message latency histogram
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_lat.h"
+#include "ipc_chan.h"
+
+#if IPC_LAT
+
+/*
+ * Timebase is TIM2, 32-bit free-running counter at timer kernel clock.
+ * It is in D2 domain, CPU2 starts it, both cores read its counter.
+ * D3 domain has only 16-bit LPTIM timers
+ */
+#define IPC_LAT_TIM                         TIM2
+
+/* Latency instrumentation of channel */
+#define IPC_LAT_SHARED(id)                  (&IPC_SHM->ctrl.lat[(id)])
+
+/* Next stamp to bin, per consumed channel of current core */
+static uint32_t lat_tail[IPC_CHAN_COUNT];
+
+/* Timebase frequency in units of Hz */
+static uint32_t lat_tick_hz;
+
+/* Channel names for report */
+#define IPC_LAT_X_NAME(name, min_len, weight, region)   #name,
+static const char* const lat_names[] = {
+    IPC_CHAN_TABLE(IPC_LAT_X_NAME)
+};
+
+/**
+ * \brief           Enable timebase, called by both cores.
+ *                  Counter is started by first core, once D2 domain is running
+ */
+void
+ipc_lat_timebase_init(void) {
+    __HAL_RCC_TIM2_CLK_ENABLE();
+
+    /* APB1 timer clock is twice PCLK1 when APB1 is divided */
+    lat_tick_hz = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_APB1_DIV1) {
+        lat_tick_hz *= 2;
+    }
+
+    if ((IPC_LAT_TIM->CR1 & TIM_CR1_CEN) == 0) {
+        IPC_LAT_TIM->PSC = 0;
+        IPC_LAT_TIM->ARR = 0xFFFFFFFF;
+        IPC_LAT_TIM->EGR = TIM_EGR_UG;
+        IPC_LAT_TIM->CR1 = TIM_CR1_CEN;
+    }
+}
+
+/**
+ * \brief           Get timebase value, same on both cores
+ * \return          Counter value in units of timebase ticks
+ */
+uint32_t
+ipc_lat_now(void) {
+    return IPC_LAT_TIM->CNT;
+}
+
+/**
+ * \brief           Reset instrumentation of all channels.
+ *                  Called by CPU1 with channel directory, before other core is started
+ */
+void
+ipc_lat_reset(void) {
+    memset((void *)IPC_SHM->ctrl.lat, 0x00, sizeof(IPC_SHM->ctrl.lat));
+    memset(lat_tail, 0x00, sizeof(lat_tail));
+}
+
+/**
+ * \brief           Stamp data written to channel, call after write
+ * \param[in]       id: Channel ID, written by current core
+ */
+void
+ipc_lat_stamp(uint32_t id) {
+    volatile ipc_lat_shared_t* lat;
+    uint32_t head;
+
+    if (id >= IPC_CHAN_COUNT) {
+        return;
+    }
+    lat = IPC_LAT_SHARED(id);
+    head = lat->head;
+    lat->stamps[head % IPC_LAT_STAMPS] = ipc_lat_now();
+    __DMB();                                    /* Stamp before head */
+    lat->head = head + 1;
+}
+
+/**
+ * \brief           Get histogram bin of latency
+ * \param[in]       ticks: Latency in units of timebase ticks
+ * \return          Bin index
+ */
+static uint32_t
+prv_bin(uint32_t ticks) {
+    uint32_t e;
+
+    if (ticks < 4) {
+        return ticks;
+    }
+    e = 31 - __CLZ(ticks);
+    return 4 * (e - 1) + ((ticks >> (e - 2)) & 0x03);
+}
+
+/**
+ * \brief           Get upper bound of histogram bin
+ * \param[in]       bin: Bin index
+ * \return          First latency not in bin, in units of timebase ticks
+ */
+static uint64_t
+prv_bin_upper(uint32_t bin) {
+    if (bin < 4) {
+        return bin + 1;
+    }
+    return (uint64_t)(5 + (bin & 0x03)) << (bin / 4 - 1);
+}
+
+/**
+ * \brief           Bin latency of all stamps written before doorbell,
+ *                  call from doorbell callback of consumed channel
+ * \param[in]       id: Channel ID, read by current core
+ */
+void
+ipc_lat_delivered(uint32_t id) {
+    volatile ipc_lat_shared_t* lat;
+    uint32_t head, now, stamp, ticks;
+
+    if (id >= IPC_CHAN_COUNT) {
+        return;
+    }
+    lat = IPC_LAT_SHARED(id);
+    head = lat->head;
+    __DMB();                                    /* Head before stamps */
+    now = ipc_lat_now();                        /* All stamps up to head were taken before */
+    if (head - lat_tail[id] > IPC_LAT_STAMPS) {
+        lat->lost += head - lat_tail[id] - IPC_LAT_STAMPS;
+        lat_tail[id] = head - IPC_LAT_STAMPS;
+    }
+    for (; lat_tail[id] != head; ++lat_tail[id]) {
+        stamp = lat->stamps[lat_tail[id] % IPC_LAT_STAMPS];
+        __DMB();                                /* Stamp before overwrite check */
+        if (lat->head - lat_tail[id] > IPC_LAT_STAMPS) {
+            ++lat->lost;                        /* Overwritten by producer while read */
+            continue;
+        }
+
+        ticks = now - stamp;
+        ++lat->bins[prv_bin(ticks)];
+        if (ticks > lat->max) {
+            lat->max = ticks;
+        }
+        ++lat->count;
+    }
+}
+
+/**
+ * \brief           Convert timebase ticks to nanoseconds
+ * \param[in]       ticks: Number of ticks
+ * \return          Nanoseconds, saturated to 32-bit
+ */
+static uint32_t
+prv_ticks_to_ns(uint64_t ticks) {
+    uint64_t ns;
+
+    if (lat_tick_hz == 0) {
+        return 0;
+    }
+    ns = ticks * 1000000000ULL / lat_tick_hz;
+    return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+/**
+ * \brief           Get latency of percentile from histogram
+ * \param[in]       lat: Channel instrumentation
+ * \param[in]       count: Number of samples
+ * \param[in]       pct: Percentile, `1-100`
+ * \return          Upper bound of bin with requested percentile, in units of nanoseconds
+ */
+static uint32_t
+prv_percentile(volatile ipc_lat_shared_t* lat, uint32_t count, uint32_t pct) {
+    uint32_t target, sum = 0;
+
+    target = (uint32_t)(((uint64_t)count * pct + 99) / 100);
+    for (uint32_t i = 0; i < IPC_LAT_BINS; ++i) {
+        sum += lat->bins[i];
+        if (sum >= target) {
+            return prv_ticks_to_ns(prv_bin_upper(i));
+        }
+    }
+    return prv_ticks_to_ns(lat->max);
+}
+
+/**
+ * \brief           Get latency summary of channel, from any core.
+ *                  Histogram may be updated by consumer during call, summary is approximate then
+ * \param[in]       id: Channel ID
+ * \param[out]      sum: Output summary
+ * \return          `1` when channel has samples, `0` otherwise
+ */
+uint8_t
+ipc_lat_get_summary(uint32_t id, ipc_lat_summary_t* sum) {
+    volatile ipc_lat_shared_t* lat;
+
+    if (id >= IPC_CHAN_COUNT || sum == NULL) {
+        return 0;
+    }
+    lat = IPC_LAT_SHARED(id);
+    sum->count = lat->count;
+    sum->lost = lat->lost;
+    if (sum->count == 0) {
+        return 0;
+    }
+    sum->p50_ns = prv_percentile(lat, sum->count, 50);
+    sum->p99_ns = prv_percentile(lat, sum->count, 99);
+    sum->max_ns = prv_ticks_to_ns(lat->max);
+    return 1;
+}
+
+/**
+ * \brief           Get timebase value of last stamp of channel, from any core
+ * \param[in]       id: Channel ID
+ * \param[out]      stamp: Timebase value at last write
+ * \return          `1` when channel was stamped, `0` otherwise
+ */
+uint8_t
+ipc_lat_last_stamp(uint32_t id, uint32_t* stamp) {
+    volatile ipc_lat_shared_t* lat;
+    uint32_t head;
+
+    if (id >= IPC_CHAN_COUNT || stamp == NULL) {
+        return 0;
+    }
+    lat = IPC_LAT_SHARED(id);
+    if ((head = lat->head) == 0) {
+        return 0;
+    }
+    __DMB();                                    /* Head before stamps */
+    *stamp = lat->stamps[(head - 1) % IPC_LAT_STAMPS];
+    return 1;
+}
+
+/**
+ * \brief           Convert timebase ticks to nanoseconds
+ * \param[in]       ticks: Number of ticks
+ * \return          Nanoseconds, saturated to 32-bit
+ */
+uint32_t
+ipc_lat_to_ns(uint32_t ticks) {
+    return prv_ticks_to_ns(ticks);
+}
+
+/**
+ * \brief           Report latency of all channels with samples,
+ *                  `[LAT] name n:x p50:x p99:x max:x ns lost:x`
+ * \param[in]       out_fn: Output function for report lines
+ */
+void
+ipc_lat_report(ipc_lat_out_fn out_fn) {
+    ipc_lat_summary_t sum;
+    char str[96];
+    int len;
+
+    for (uint32_t id = 0; id < IPC_CHAN_COUNT; ++id) {
+        if (ipc_lat_get_summary(id, &sum)) {
+            len = sprintf(str, "[LAT] %s n:%u p50:%u p99:%u max:%u ns lost:%u\r\n", lat_names[id],
+                            (unsigned)sum.count, (unsigned)sum.p50_ns, (unsigned)sum.p99_ns,
+                            (unsigned)sum.max_ns, (unsigned)sum.lost);
+            out_fn(str, len);
+        }
+    }
+}
+
+#endif /* IPC_LAT */
@@ -0,0 +1,161 @@
+/**
+ * \file            ipc_load.c
+ * \brief           Per-core CPU load accounting
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_load.h"
+#include "ipc_chan.h"
+
+#if IPC_LOAD
+
+/*
+ * Core runs in exactly one bucket at a time, application loop switches bucket
+ * around channel, forwarding and sleep sections. Switch charges cycles since previous switch
+ * to bucket that ends, interrupts are charged to the bucket they interrupt.
+ *
+ * Cycle counter stops while core sleeps, period length is therefore taken from tick,
+ * cycles of period not seen by cycle counter are charged to idle bucket.
+ * Tick stops in stop mode as well, time CPU2 spends in stop with IPC_IDLE_STOP is not part of period
+ */
+
+#if defined(CORE_CM7)
+#define IPC_LOAD_CORE                       0
+#else
+#define IPC_LOAD_CORE                       1
+#endif
+
+/* Load of current core */
+#define IPC_LOAD_SHARED                     (&IPC_SHM->ctrl.load[IPC_LOAD_CORE])
+
+static ipc_load_bucket_t cur;                   /* Active bucket */
+static uint32_t stamp;                          /* Cycle counter at last switch */
+static uint32_t acc[IPC_LOAD_COUNT];            /* Cycles charged in active period */
+static uint32_t period_start;                   /* Tick at start of active period */
+
+/**
+ * \brief           Start accounting on current core, application bucket is active
+ */
+void
+ipc_load_init(void) {
+    CYCCNT_INIT();                              /* Time base of buckets */
+    memset(acc, 0x00, sizeof(acc));
+    memset((void *)IPC_LOAD_SHARED, 0x00, sizeof(*IPC_LOAD_SHARED));
+    cur = IPC_LOAD_APP;
+    stamp = CYCCNT_GET();
+    period_start = HAL_GetTick();
+}
+
+/**
+ * \brief           Charge cycles since last switch to active bucket and activate new bucket.
+ *                  Can be called from interrupt, which restores returned bucket before it returns
+ * \param[in]       bucket: Bucket to activate
+ * \return          Previously active bucket
+ */
+ipc_load_bucket_t
+ipc_load_switch(ipc_load_bucket_t bucket) {
+    ipc_load_bucket_t prev;
+    uint32_t primask, now;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    now = CYCCNT_GET();
+    acc[cur] += now - stamp;
+    stamp = now;
+    prev = cur;
+    cur = bucket;
+    __set_PRIMASK(primask);
+    return prev;
+}
+
+/**
+ * \brief           Publish load of period once it elapsed, call from application loop
+ * \param[in]       now: Current tick
+ * \return          `1` if new period was published, `0` otherwise
+ */
+uint8_t
+ipc_load_poll(uint32_t now) {
+    volatile ipc_load_shared_t* shared = IPC_LOAD_SHARED;
+    uint32_t cycles[IPC_LOAD_COUNT], primask, period, busy = 0;
+
+    if (now - period_start < IPC_LOAD_PERIOD_MS) {
+        return 0;
+    }
+
+    /* Close period, active bucket continues in next one */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    ipc_load_switch(cur);
+    memcpy(cycles, acc, sizeof(cycles));
+    memset(acc, 0x00, sizeof(acc));
+    __set_PRIMASK(primask);
+
+    period = (now - period_start) * (SystemCoreClock / 1000);
+    period_start = now;
+    for (size_t i = 0; i < IPC_LOAD_COUNT; ++i) {
+        busy += cycles[i];
+    }
+    if (period > busy) {
+        cycles[IPC_LOAD_IDLE] += period - busy;     /* Sleep is not counted by cycle counter */
+    } else {
+        period = busy;
+    }
+
+    ++shared->seq;
+    __DMB();
+    shared->period_cycles = period;
+    for (size_t i = 0; i < IPC_LOAD_COUNT; ++i) {
+        shared->cycles[i] = cycles[i];
+        shared->permille[i] = period > 0 ? (uint32_t)((uint64_t)cycles[i] * 1000 / period) : 0;
+    }
+    __DMB();
+    ++shared->seq;
+    return 1;
+}
+
+/**
+ * \brief           Get load of last period of any core
+ * \param[in]       core: `0` for CPU1, `1` for CPU2
+ * \param[out]      stats: Load, consistent copy of single period
+ */
+void
+ipc_load_get_stats(uint32_t core, ipc_load_shared_t* stats) {
+    volatile ipc_load_shared_t* shared = &IPC_SHM->ctrl.load[core & 1];
+    uint32_t seq;
+
+    do {
+        seq = shared->seq;
+        __DMB();
+        memcpy(stats, (const void *)shared, sizeof(*stats));
+        __DMB();
+    } while ((seq & 1) || seq != shared->seq);
+}
+
+#endif /* IPC_LOAD */
@@ -0,0 +1,175 @@
+/**
+ * \file            ipc_lock.c
+ * \brief           Cross-core lock over hardware semaphore
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_lock.h"
+
+/*
+ * Lock over one hardware semaphore, for data structures written by both cores.
+ *
+ * Semaphore is taken with 1-step read lock, which succeeds again on the core
+ * that already owns it, interrupts of current core are therefore disabled
+ * while lock is held and critical section must stay short.
+ *
+ * Take spins IPC_LOCK_SPIN times, then waits in WFI for semaphore free interrupt
+ * of the lock semaphore, so waiting core stops polling the shared bus.
+ * Notification is activated before last try, release between try and WFI
+ * leaves interrupt pending and WFI returns at once. HSEM interrupt must be enabled
+ * in NVIC of current core, HAL_HSEM_FreeCallback ignores semaphore without listener.
+ * Caller that has interrupts disabled keeps spinning, pending interrupt ends every WFI.
+ *
+ * Every take and release updates counters of lock, read them with \ref ipc_lock_get_stats
+ */
+
+/**
+ * \brief           Initialize lock, before any core takes it
+ * \param[in]       lock: Lock in shared memory
+ * \param[in]       sem_id: Hardware semaphore ID, not used for doorbells
+ */
+void
+ipc_lock_init(ipc_lock_t* lock, uint32_t sem_id) {
+    lock->sem_id = sem_id;
+    ipc_lock_reset_stats(lock);
+}
+
+/**
+ * \brief           Account successful take, called with lock held
+ * \param[in]       lock: Lock
+ * \param[in]       contended: Set to `1` when lock was found taken before
+ */
+static void
+prv_taken(ipc_lock_t* lock, uint8_t contended) {
+    __DMB();                                    /* Protected data after take */
+    lock->taken_at = CYCCNT_GET();
+    ++lock->acquisitions;
+    if (contended) {
+        ++lock->contentions;
+    }
+}
+
+/**
+ * \brief           Try to take lock without waiting
+ * \param[in]       lock: Lock
+ * \param[out]      primask: Previous interrupt mask on success, for \ref ipc_lock_release
+ * \return          `1` when lock was taken, `0` otherwise
+ */
+uint8_t
+ipc_lock_try(ipc_lock_t* lock, uint32_t* primask) {
+    uint32_t pm = __get_PRIMASK();
+
+    __disable_irq();
+    if (HAL_HSEM_FastTake(lock->sem_id) != HAL_OK) {
+        __set_PRIMASK(pm);
+        return 0;
+    }
+    prv_taken(lock, 0);
+    *primask = pm;
+    return 1;
+}
+
+/**
+ * \brief           Take lock, spin and then sleep until other core releases it.
+ *                  Interrupts of current core stay disabled until \ref ipc_lock_release
+ * \param[in]       lock: Lock
+ * \return          Previous interrupt mask, for \ref ipc_lock_release
+ */
+uint32_t
+ipc_lock_take(ipc_lock_t* lock) {
+    uint32_t primask = __get_PRIMASK(), tries = 0, mask = __HAL_HSEM_SEMID_TO_MASK(lock->sem_id);
+
+    for (;; ++tries) {
+        __disable_irq();
+        if (HAL_HSEM_FastTake(lock->sem_id) == HAL_OK) {
+            break;
+        }
+        if (tries >= IPC_LOCK_SPIN) {
+            HAL_HSEM_ActivateNotification(mask);
+            if (HAL_HSEM_FastTake(lock->sem_id) == HAL_OK) {
+                HAL_HSEM_DeactivateNotification(mask);
+                break;
+            }
+            __WFI();                            /* Pending interrupt wakes core with interrupts disabled */
+            HAL_HSEM_DeactivateNotification(mask);
+            __HAL_HSEM_CLEAR_FLAG(mask);
+            ++lock->sleeps;                     /* Owner never waits, only waiting core writes it */
+        }
+        __set_PRIMASK(primask);                 /* Serve interrupts between tries */
+    }
+    prv_taken(lock, tries > 0);
+    return primask;
+}
+
+/**
+ * \brief           Release lock taken by current core
+ * \param[in]       lock: Lock
+ * \param[in]       primask: Interrupt mask from \ref ipc_lock_take or \ref ipc_lock_try
+ */
+void
+ipc_lock_release(ipc_lock_t* lock, uint32_t primask) {
+    uint32_t hold = CYCCNT_GET() - lock->taken_at;
+
+    if (hold > lock->max_hold[IPC_LOCK_CORE]) {
+        lock->max_hold[IPC_LOCK_CORE] = hold;
+    }
+    __DMB();                                    /* Protected data before release */
+    HAL_HSEM_Release(lock->sem_id, 0);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * \brief           Get lock counters, without taking lock
+ * \param[in]       lock: Lock
+ * \param[out]      stats: Output statistics
+ */
+void
+ipc_lock_get_stats(const ipc_lock_t* lock, ipc_lock_stats_t* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    stats->acquisitions = lock->acquisitions;
+    stats->contentions = lock->contentions;
+    stats->sleeps = lock->sleeps;
+    stats->max_hold[0] = lock->max_hold[0];
+    stats->max_hold[1] = lock->max_hold[1];
+}
+
+/**
+ * \brief           Reset lock counters
+ * \param[in]       lock: Lock
+ */
+void
+ipc_lock_reset_stats(ipc_lock_t* lock) {
+    lock->acquisitions = 0;
+    lock->contentions = 0;
+    lock->sleeps = 0;
+    lock->max_hold[0] = 0;
+    lock->max_hold[1] = 0;
+}
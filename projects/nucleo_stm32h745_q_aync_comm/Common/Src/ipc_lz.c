@@ -0,0 +1,330 @@
+/**
+ * \file            ipc_lz.c
+ * \brief           LZ stream codec with bounded window
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "ipc_lz.h"
+
+/*
+ * LZ77 codec with byte-aligned tokens, for redundant text and telemetry.
+ * Encoder finds one candidate per position from hash table of last positions,
+ * it needs 6kB and no allocation. Decoder needs 2kB window.
+ *
+ * Frames are independent of transport, frame that did not compress is stored.
+ * Key frame resets window, receiver attaching to running stream or after lost frame
+ * synchronizes on next key frame, sent at least every IPC_LZ_KEY_INTERVAL frames.
+ *
+ * Codec has no dependency on target, host decoder builds from this file
+ */
+
+/* Hash of 3 bytes at position */
+#define IPC_LZ_HASH(p)                      ((uint32_t)(((uint32_t)(p)[0] << 16 | (uint32_t)(p)[1] << 8 | (p)[2]) * 2654435761UL) >> (32 - IPC_LZ_HASH_BITS))
+
+/**
+ * \brief           Initialize encoder, first frame is key frame
+ * \param[in]       enc: Encoder handle
+ */
+void
+ipc_lz_enc_init(ipc_lz_enc_t* enc) {
+    memset(enc->head, 0x00, sizeof(enc->head));
+    enc->hist_len = 0;
+    enc->pending = 0;
+    enc->frames = 0;
+    enc->key = 1;
+    enc->bytes_in = 0;
+    enc->bytes_out = 0;
+}
+
+/**
+ * \brief           Make next frame key frame.
+ *                  Call when frame was lost on transport, receiver loses synchronization until key frame
+ * \param[in]       enc: Encoder handle
+ */
+void
+ipc_lz_enc_reset(ipc_lz_enc_t* enc) {
+    enc->key = 1;
+}
+
+/**
+ * \brief           Drop oldest history, keep last window and pending input
+ * \param[in]       enc: Encoder handle
+ */
+static void
+prv_enc_slide(ipc_lz_enc_t* enc) {
+    size_t shift = enc->hist_len - IPC_LZ_WINDOW;
+
+    memmove(enc->hist, &enc->hist[shift], IPC_LZ_WINDOW + enc->pending);
+    enc->hist_len = IPC_LZ_WINDOW;
+    for (size_t i = 0; i < sizeof(enc->head) / sizeof(enc->head[0]); ++i) {
+        enc->head[i] = enc->head[i] > shift ? (uint16_t)(enc->head[i] - shift) : 0;
+    }
+}
+
+/**
+ * \brief           Add input to pending frame
+ * \param[in]       enc: Encoder handle
+ * \param[in]       data: Input data
+ * \param[in]       len: Input length in units of bytes
+ * \return          Number of bytes accepted, limited by free space of pending frame.
+ *                      Frame is full and must be flushed when less than `len`
+ */
+size_t
+ipc_lz_enc_write(ipc_lz_enc_t* enc, const void* data, size_t len) {
+    if (len > IPC_LZ_FRAME_MAX - enc->pending) {
+        len = IPC_LZ_FRAME_MAX - enc->pending;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    if (enc->hist_len + enc->pending + len > sizeof(enc->hist)) {
+        prv_enc_slide(enc);
+    }
+    memcpy(&enc->hist[enc->hist_len + enc->pending], data, len);
+    enc->pending += len;
+    return len;
+}
+
+/**
+ * \brief           Encode pending input to frame
+ * \param[in]       enc: Encoder handle
+ * \param[out]      out: Output memory for frame, at least \ref IPC_LZ_OUT_MAX bytes
+ * \return          Frame length in units of bytes, `0` when no input is pending
+ */
+size_t
+ipc_lz_enc_flush(ipc_lz_enc_t* enc, uint8_t* out) {
+    const uint8_t* hist = enc->hist;
+    uint8_t* p = &out[IPC_LZ_HDR_LEN];
+    uint8_t* ctrl = NULL;
+    const uint8_t* limit = &out[IPC_LZ_HDR_LEN + enc->pending];
+    size_t i, end, cand = 0, best, bit = 8, plen;
+    uint8_t flags = 0;
+
+    if (enc->pending == 0) {
+        return 0;
+    }
+    if (enc->key || enc->frames >= IPC_LZ_KEY_INTERVAL) {
+        /* Forget history, matches refer to this frame only */
+        memmove(enc->hist, &enc->hist[enc->hist_len], enc->pending);
+        memset(enc->head, 0x00, sizeof(enc->head));
+        enc->hist_len = 0;
+        enc->frames = 0;
+        enc->key = 0;
+        flags |= IPC_LZ_FLAG_KEY;
+    }
+
+    i = enc->hist_len;
+    end = enc->hist_len + enc->pending;
+    while (i < end) {
+        /* Stored frame is not longer, stop when next token may exceed it */
+        if (p + 3 > limit) {
+            p = NULL;
+            break;
+        }
+        if (bit == 8) {
+            ctrl = p++;
+            *ctrl = 0;
+            bit = 0;
+        }
+
+        best = 0;
+        if (end - i >= IPC_LZ_MIN_MATCH) {
+            uint32_t h = IPC_LZ_HASH(&hist[i]);
+
+            cand = enc->head[h];
+            enc->head[h] = (uint16_t)(i + 1);
+            if (cand > 0 && i - (cand - 1) <= IPC_LZ_WINDOW) {
+                size_t max = end - i < IPC_LZ_MAX_MATCH ? end - i : IPC_LZ_MAX_MATCH;
+
+                --cand;
+                while (best < max && hist[cand + best] == hist[i + best]) {
+                    ++best;
+                }
+            }
+        }
+        if (best >= IPC_LZ_MIN_MATCH) {
+            uint32_t tok = (uint32_t)(i - cand - 1) | (uint32_t)(best - IPC_LZ_MIN_MATCH) << 11;
+
+            *ctrl |= (uint8_t)(1 << bit);
+            *p++ = (uint8_t)tok;
+            *p++ = (uint8_t)(tok >> 8);
+
+            /* Later matches can start inside this one */
+            for (size_t k = i + 1; k < i + best && end - k >= IPC_LZ_MIN_MATCH; ++k) {
+                enc->head[IPC_LZ_HASH(&hist[k])] = (uint16_t)(k + 1);
+            }
+            i += best;
+        } else {
+            *p++ = hist[i++];
+        }
+        ++bit;
+    }
+
+    if (p == NULL) {
+        /* Frame did not compress, store it. Hash table stays valid, decoder gets same window */
+        memcpy(&out[IPC_LZ_HDR_LEN], &hist[enc->hist_len], enc->pending);
+        plen = enc->pending;
+        flags |= IPC_LZ_FLAG_RAW;
+    } else {
+        plen = (size_t)(p - &out[IPC_LZ_HDR_LEN]);
+    }
+
+    out[0] = IPC_LZ_MAGIC;
+    out[1] = flags;
+    out[2] = (uint8_t)plen;
+    out[3] = (uint8_t)(plen >> 8);
+    out[4] = (uint8_t)enc->pending;
+    out[5] = (uint8_t)(enc->pending >> 8);
+
+    enc->bytes_in += enc->pending;
+    enc->bytes_out += IPC_LZ_HDR_LEN + plen;
+    enc->hist_len = end;
+    enc->pending = 0;
+    ++enc->frames;
+    return IPC_LZ_HDR_LEN + plen;
+}
+
+/**
+ * \brief           Initialize decoder, it waits for key frame
+ * \param[in]       dec: Decoder handle
+ */
+void
+ipc_lz_dec_init(ipc_lz_dec_t* dec) {
+    dec->pos = 0;
+    dec->sync = 0;
+}
+
+/**
+ * \brief           Get total frame length from header
+ * \param[in]       hdr: First \ref IPC_LZ_HDR_LEN bytes of frame
+ * \return          Frame length in units of bytes, `0` when header is not valid
+ */
+size_t
+ipc_lz_frame_len(const uint8_t* hdr) {
+    size_t plen = hdr[2] | (size_t)hdr[3] << 8;
+    size_t rlen = hdr[4] | (size_t)hdr[5] << 8;
+
+    if (hdr[0] != IPC_LZ_MAGIC || (hdr[1] & ~(IPC_LZ_FLAG_KEY | IPC_LZ_FLAG_RAW)) != 0
+        || rlen == 0 || rlen > IPC_LZ_FRAME_MAX || plen > IPC_LZ_FRAME_MAX) {
+        return 0;
+    }
+    return IPC_LZ_HDR_LEN + plen;
+}
+
+/**
+ * \brief           Put decoded byte to output and window
+ * \param[in]       dec: Decoder handle
+ * \param[in]       b: Decoded byte
+ */
+static inline void
+prv_dec_put(ipc_lz_dec_t* dec, uint8_t b) {
+    dec->win[dec->pos++ & (IPC_LZ_WINDOW - 1)] = b;
+}
+
+/**
+ * \brief           Decode one frame
+ * \param[in]       dec: Decoder handle
+ * \param[in]       frame: Complete frame, length checked with \ref ipc_lz_frame_len
+ * \param[in]       len: Frame length in units of bytes
+ * \param[out]      out: Output memory for decoded data
+ * \param[in]       size: Size of `out` in units of bytes, \ref IPC_LZ_FRAME_MAX covers every frame
+ * \return          Decoded length, `-1` when frame is corrupted or decoder waits for key frame
+ */
+int32_t
+ipc_lz_dec_frame(ipc_lz_dec_t* dec, const uint8_t* frame, size_t len, uint8_t* out, size_t size) {
+    const uint8_t* p = &frame[IPC_LZ_HDR_LEN];
+    const uint8_t* end = &frame[len];
+    size_t rlen, n = 0;
+    uint8_t ctrl = 0;
+
+    if (len < IPC_LZ_HDR_LEN || ipc_lz_frame_len(frame) != len) {
+        dec->sync = 0;
+        return -1;
+    }
+    rlen = frame[4] | (size_t)frame[5] << 8;
+    if (frame[1] & IPC_LZ_FLAG_KEY) {
+        dec->pos = 0;
+        dec->sync = 1;
+    }
+    if (!dec->sync || rlen > size) {
+        return -1;
+    }
+
+    if (frame[1] & IPC_LZ_FLAG_RAW) {
+        if ((size_t)(end - p) != rlen) {
+            dec->sync = 0;
+            return -1;
+        }
+        for (; n < rlen; ++n) {
+            out[n] = p[n];
+            prv_dec_put(dec, p[n]);
+        }
+        return (int32_t)n;
+    }
+
+    for (size_t bit = 8; n < rlen; ++bit) {
+        if (bit == 8) {
+            if (p >= end) {
+                break;
+            }
+            ctrl = *p++;
+            bit = 0;
+        }
+        if (ctrl & (1 << bit)) {
+            size_t tok, dist, mlen;
+
+            if (end - p < 2) {
+                break;
+            }
+            tok = p[0] | (size_t)p[1] << 8;
+            p += 2;
+            dist = (tok & 0x07FF) + 1;
+            mlen = (tok >> 11) + IPC_LZ_MIN_MATCH;
+            if (dist > dec->pos || n + mlen > rlen) {
+                break;
+            }
+            for (size_t k = 0; k < mlen; ++k) {
+                uint8_t b = dec->win[(dec->pos - dist) & (IPC_LZ_WINDOW - 1)];
+
+                out[n++] = b;
+                prv_dec_put(dec, b);
+            }
+        } else {
+            if (p >= end) {
+                break;
+            }
+            out[n++] = *p;
+            prv_dec_put(dec, *p++);
+        }
+    }
+    if (n != rlen || p != end) {
+        dec->sync = 0;
+        return -1;
+    }
+    return (int32_t)n;
+}
@@ -0,0 +1,141 @@
+/**
+ * \file            ipc_lz_sink.c
+ * \brief           Compressing stage of router sink
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_lz_sink.h"
+
+#if IPC_LZ
+
+#if !IPC_ROUTE
+#error "IPC_LZ needs IPC_ROUTE, compression is stage of router sink"
+#endif /* !IPC_ROUTE */
+
+/*
+ * Input routed to sink is collected to frames of up to IPC_LZ_FRAME_MAX bytes.
+ * Full frame is encoded at once, partial frame after flush time. Frame is written
+ * to sink queue as a whole or dropped when queue is full, next frame is then key frame
+ * and host decoder synchronizes again. Sink policy does not apply, frames are never overwritten
+ */
+
+/**
+ * \brief           Encode pending input and queue frame
+ * \param[in]       sink: Sink handle
+ * \param[in]       lzs: Compressing stage
+ * \return          `1` if frame was queued, `0` otherwise
+ */
+static uint8_t
+prv_lz_flush(ipc_sink_t* sink, ipc_lz_sink_t* lzs) {
+    size_t in = ipc_lz_enc_pending(&lzs->enc);
+    size_t len = ipc_lz_enc_flush(&lzs->enc, lzs->frame);
+
+    if (len == 0) {
+        return 0;
+    }
+    if (ringbuff_write_all(sink->queue, lzs->frame, len) == RINGBUFF_WOULD_BLOCK) {
+        sink->drops += in;
+        ipc_lz_enc_reset(&lzs->enc);
+        return 0;
+    }
+    sink->bytes += in;
+    return 1;
+}
+
+/**
+ * \brief           Collect input to frame, \ref ipc_sink_put_fn of compressing stage
+ * \param[in]       sink: Sink handle
+ * \param[in]       id: Channel ID of source, not used, sources share one stream
+ * \param[in]       data: Data to queue
+ * \param[in]       len: Data length in units of bytes
+ * \return          `1` if frame was queued, `0` otherwise
+ */
+static uint8_t
+prv_lz_put(ipc_sink_t* sink, uint32_t id, const uint8_t* data, size_t len) {
+    ipc_lz_sink_t* lzs = sink->stage;
+    uint8_t queued = 0;
+    size_t n;
+
+    while (len > 0) {
+        if (ipc_lz_enc_pending(&lzs->enc) == 0) {
+            ipc_wait_start(&lzs->flush, lzs->flush_us);
+        }
+        n = ipc_lz_enc_write(&lzs->enc, data, len);
+        data += n;
+        len -= n;
+        if (ipc_lz_enc_pending(&lzs->enc) == IPC_LZ_FRAME_MAX) {
+            queued |= prv_lz_flush(sink, lzs);
+        }
+    }
+    return queued;
+}
+
+/**
+ * \brief           Add compressing stage to sink
+ * \param[in]       lzs: Compressing stage, in core-local memory
+ * \param[in]       sink: Sink handle, initialized with queue
+ * \param[in]       flush_us: Maximum time input waits for frame to fill, in units of microseconds
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_lz_sink_init(ipc_lz_sink_t* lzs, ipc_sink_t* sink, uint32_t flush_us) {
+    if (lzs == NULL || sink == NULL || sink->queue == NULL) {
+        return 0;
+    }
+    ipc_lz_enc_init(&lzs->enc);
+    lzs->flush_us = flush_us;
+    sink->stage = lzs;
+    sink->put_fn = prv_lz_put;
+    return 1;
+}
+
+/**
+ * \brief           Queue partial frame once its flush time elapsed and kick sink.
+ *                  Call from thread loop
+ * \param[in]       sink: Sink handle with compressing stage
+ * \return          `1` while input is pending, flush time is measured with cycle counter
+ *                      and core may not sleep, `0` otherwise
+ */
+uint8_t
+ipc_lz_sink_poll(ipc_sink_t* sink) {
+    ipc_lz_sink_t* lzs = sink->stage;
+
+    if (ipc_lz_enc_pending(&lzs->enc) == 0) {
+        return 0;
+    }
+    if (!ipc_wait_expired(&lzs->flush)) {
+        return 1;
+    }
+    if (prv_lz_flush(sink, lzs) && sink->kick_fn != NULL) {
+        sink->kick_fn(sink);
+    }
+    return 0;
+}
+
+#endif /* IPC_LZ */
@@ -0,0 +1,152 @@
+/**
+ * \file            ipc_mon.c
+ * \brief           Introspection block for host monitoring over SWD
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stddef.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_mon.h"
+#include "ipc_chan.h"
+
+#if IPC_MON
+
+/* Introspection header in control part of shared RAM */
+#define IPC_MON_HDR                         (&IPC_SHM->ctrl.mon)
+
+/* Address in shared RAM of member of layout, constant expression */
+#define IPC_MON_SHM_ADDR(member)            (SHD_RAM_START_ADDR + offsetof(ipc_shm_t, member))
+
+_Static_assert(IPC_MON_SHM_ADDR(ctrl.mon) == IPC_MON_ADDR, "Introspection header must stay at fixed address");
+_Static_assert(IPC_CHAN_COUNT <= IPC_MON_CHAN_MAX, "Too many channels for introspection descriptor");
+_Static_assert(offsetof(ipc_chan_entry_t, shared_addr) == 0 && offsetof(ipc_chan_entry_t, data_addr) == 4
+    && offsetof(ipc_chan_entry_t, data_len) == 8, "Directory entry layout differs from introspection contract");
+#if IPC_HB
+_Static_assert(sizeof(ipc_hb_shared_t) == 9 * sizeof(uint32_t), "Heartbeat statistics differ from introspection contract");
+#endif /* IPC_HB */
+
+/*
+ * Build ID of image, set from build system, for example -DIPC_MON_BUILD_ID=0x$(git rev-parse --short=8 HEAD).
+ * Hash of compile date and time of this file is used when not set
+ */
+#ifndef IPC_MON_BUILD_ID
+#define IPC_MON_BUILD_ID                    0
+#endif
+
+#if defined(CORE_CM7)
+
+/* Offset of statistics field in channel pointers */
+#if RINGBUFF_USE_STATS
+#define IPC_MON_STATS_OFF(field)            offsetof(ringbuff_shared_t, field)
+#else
+#define IPC_MON_STATS_OFF(field)            IPC_MON_NONE
+#endif /* RINGBUFF_USE_STATS */
+
+/* Channel names, indexed by channel ID */
+#define IPC_MON_X_NAME(name, min_len, weight, region)   [IPC_CHAN_##name] = #name,
+
+/* Descriptor in flash, host reads it once per connection */
+static const ipc_mon_desc_t ipc_mon_desc = {
+    .magic = IPC_MON_MAGIC,
+    .version = IPC_MON_VERSION,
+    .len = sizeof(ipc_mon_desc_t),
+    .pow2 = RINGBUFF_USE_POW2,
+    .dir_addr = IPC_MON_SHM_ADDR(ctrl.dir),
+    .dir_entries_off = offsetof(ipc_chan_dir_t, entries),
+    .dir_entry_len = sizeof(ipc_chan_entry_t),
+    .chan_count = IPC_CHAN_COUNT,
+    .shared_len = sizeof(ringbuff_shared_t),
+    .off_w = offsetof(ringbuff_shared_t, w),
+    .off_r = offsetof(ringbuff_shared_t, r),
+    .off_bytes_in = IPC_MON_STATS_OFF(bytes_in),
+    .off_writes = IPC_MON_STATS_OFF(writes),
+    .off_short_writes = IPC_MON_STATS_OFF(short_writes),
+    .off_max_full = IPC_MON_STATS_OFF(max_full),
+    .off_bytes_out = IPC_MON_STATS_OFF(bytes_out),
+    .off_reads = IPC_MON_STATS_OFF(reads),
+#if IPC_HB
+    .hb_addr = IPC_MON_SHM_ADDR(ctrl.hb),
+#endif /* IPC_HB */
+    .names = { IPC_CHAN_TABLE(IPC_MON_X_NAME) },
+};
+
+#endif /* defined(CORE_CM7) */
+
+/**
+ * \brief           Get build ID of this image
+ * \return          Build ID, never `0`
+ */
+static uint32_t
+prv_build_id(void) {
+    static const char stamp[] = __DATE__ " " __TIME__;
+    uint32_t hash = 0x811C9DC5;
+
+    if (IPC_MON_BUILD_ID != 0) {
+        return IPC_MON_BUILD_ID;
+    }
+    for (size_t i = 0; i < sizeof(stamp) - 1; ++i) {
+        hash = (hash ^ (uint8_t)stamp[i]) * 0x01000193;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+#if defined(CORE_CM7)
+
+/**
+ * \brief           Publish introspection header, CPU1 only.
+ *                  Called once after channel directory was published
+ */
+void
+ipc_mon_init(void) {
+    volatile ipc_mon_hdr_t* hdr = IPC_MON_HDR;
+
+    hdr->magic = 0;
+    __DMB();                                    /* Host ignores header while it changes */
+    hdr->version = IPC_MON_VERSION;
+    hdr->desc_addr = (uint32_t)&ipc_mon_desc;
+    hdr->build_id[IPC_MON_CPU1] = prv_build_id();
+    hdr->build_id[IPC_MON_CPU2] = 0;
+    hdr->layout_hash = ipc_chan_layout_hash();
+    __DMB();                                    /* Fields before magic */
+    hdr->magic = IPC_MON_MAGIC;
+}
+
+#else
+
+/**
+ * \brief           Publish build ID of CPU2 in introspection header, CPU2 only.
+ *                  Called after CPU2 attached to channels
+ */
+void
+ipc_mon_attach(void) {
+    IPC_MON_HDR->build_id[IPC_MON_CPU2] = prv_build_id();
+}
+
+#endif /* defined(CORE_CM7) */
+
+#endif /* IPC_MON */
@@ -0,0 +1,207 @@
+/**
+ * \file            ipc_mpmc.c
+ * \brief           Multi-producer multi-consumer ring of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_mpmc.h"
+#include "ipc_chan.h"
+#include "ipc_notify.h"
+
+#include <string.h>
+
+#if IPC_MPMC
+
+/*
+ * Bounded ring of fixed slots, pushed and popped by any context of both cores (D. Vyukov MPMC queue).
+ *
+ * Each slot has sequence number. Slot at position `pos` is free for push when its sequence is `pos`,
+ * holds item for pop when it is `pos + 1` and is free for next lap when it is `pos + slots`.
+ * Producer and consumer claim position by advancing `enq_pos` or `deq_pos` after sequence check,
+ * item is copied after claim and slot is handed over with sequence store, claims of other
+ * producers and consumers do not wait for the copy.
+ *
+ * Claim is compare-and-swap in original queue. Exclusive monitor of each core only sees
+ * its own accesses, STREX does not fail on store of other core to shared RAM,
+ * claims therefore take ring lock HSEM_MPMC_LOCK(id) for few instructions.
+ *
+ * Ring state is in non-cacheable control part. Slots follow channel data cache policy,
+ * producer cleans slot before sequence store and consumer invalidates it before copy.
+ * Every push rings doorbell, HSEM_MPMC(id), which both cores may listen on
+ */
+
+/* Ring state, positions are accessed with lock held and slot sequences are volatile */
+#define IPC_MPMC_SHARED(id)                 ((ipc_mpmc_shared_t *)&IPC_SHM->ctrl.mpmc[(id)])
+
+/* Layout checks */
+#define IPC_MPMC_X_ASSERT(name, slots, slot_len)                                        \
+    _Static_assert((slots) >= 2 && (slots) <= IPC_MPMC_MAX_SLOTS && ((slots) & ((slots) - 1)) == 0, "MPMC ring " #name " slot count is not power of 2 in range"); \
+    _Static_assert((slot_len) > 0 && ((slot_len) % MEM_CACHE_LINE_SIZE) == 0, "MPMC ring " #name " slot length is not multiple of cache line");
+IPC_MPMC_TABLE(IPC_MPMC_X_ASSERT)
+_Static_assert(HSEM_MPMC_LOCK(IPC_MPMC_COUNT - 1) < IPC_NOTIFY_SEM_COUNT, "MPMC semaphores do not fit to hardware semaphores");
+
+/**
+ * \brief           Slots of MPMC ring in shared RAM layout
+ */
+typedef struct {
+    uint32_t data_off;                          /*!< Offset of first slot */
+    uint32_t slot_len;                          /*!< Slot length */
+    uint32_t slots;                             /*!< Number of slots */
+} ipc_mpmc_layout_t;
+
+/* Layout of MPMC rings, indexed by ring ID */
+#define IPC_MPMC_X_LAYOUT(name, slots, slot_len)    { offsetof(ipc_shm_t, mpmc_##name), (slot_len), (slots) },
+static const ipc_mpmc_layout_t mpmc_layout[] = {
+    IPC_MPMC_TABLE(IPC_MPMC_X_LAYOUT)
+};
+
+/**
+ * \brief           Reset all MPMC rings to empty.
+ *                  Called by CPU1 from \ref ipc_chan_dir_init
+ */
+void
+ipc_mpmc_reset(void) {
+    for (size_t i = 0; i < IPC_MPMC_COUNT; ++i) {
+        ipc_mpmc_shared_t* s = IPC_MPMC_SHARED(i);
+
+        ipc_lock_init(&s->lock, HSEM_MPMC_LOCK(i));
+        s->enq_pos = 0;
+        s->deq_pos = 0;
+        s->full = 0;
+        s->popped[0] = 0;
+        s->popped[1] = 0;
+        for (size_t k = 0; k < IPC_MPMC_MAX_SLOTS; ++k) {
+            s->seq[k] = k;
+        }
+    }
+}
+
+/**
+ * \brief           Initialize handle of MPMC ring, on any core
+ * \param[in]       q: Ring handle
+ * \param[in]       id: Ring ID from \ref ipc_mpmc_id_t
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_mpmc_init(ipc_mpmc_t* q, uint32_t id) {
+    if (q == NULL || id >= IPC_MPMC_COUNT) {
+        return 0;
+    }
+    q->shared = IPC_MPMC_SHARED(id);
+    q->data = (uint8_t *)IPC_SHM + mpmc_layout[id].data_off;
+    q->slot_len = mpmc_layout[id].slot_len;
+    q->slots = mpmc_layout[id].slots;
+    q->sem_id = HSEM_MPMC(id);
+    return 1;
+}
+
+/**
+ * \brief           Push item and ring doorbell of ring
+ * \param[in]       q: Ring handle
+ * \param[in]       item: Item data
+ * \param[in]       len: Item length, up to slot length, rest of slot is not defined
+ * \return          `1` on success, `0` when ring is full
+ */
+uint8_t
+ipc_mpmc_push(ipc_mpmc_t* q, const void* item, size_t len) {
+    ipc_mpmc_shared_t* s;
+    uint32_t pos, idx, primask;
+    uint8_t* slot;
+
+    if (q == NULL || len > q->slot_len) {
+        return 0;
+    }
+    s = q->shared;
+
+    /* Claim position of free slot */
+    primask = ipc_lock_take(&s->lock);
+    pos = s->enq_pos;
+    idx = pos & (q->slots - 1);
+    if (s->seq[idx] != pos) {
+        ++s->full;                              /* Slot still holds item of previous lap */
+        ipc_lock_release(&s->lock, primask);
+        return 0;
+    }
+    s->enq_pos = pos + 1;
+    ipc_lock_release(&s->lock, primask);
+
+    /* Slot is owned until sequence store */
+    slot = &q->data[idx * q->slot_len];
+    memcpy(slot, item, len);
+#if IPC_CHAN_CACHE_MAINT
+    SCB_CleanDCache_by_Addr((void *)slot, (int32_t)q->slot_len);
+#endif /* IPC_CHAN_CACHE_MAINT */
+    __DMB();                                    /* Item before sequence */
+    s->seq[idx] = pos + 1;
+    ipc_notify(q->sem_id);
+    return 1;
+}
+
+/**
+ * \brief           Pop oldest item
+ * \param[in]       q: Ring handle
+ * \param[out]      item: Output of slot length
+ * \return          `1` on success, `0` when ring is empty or oldest item is still being pushed
+ */
+uint8_t
+ipc_mpmc_pop(ipc_mpmc_t* q, void* item) {
+    ipc_mpmc_shared_t* s;
+    uint32_t pos, idx, primask;
+    uint8_t* slot;
+
+    if (q == NULL) {
+        return 0;
+    }
+    s = q->shared;
+
+    /* Claim position of filled slot */
+    primask = ipc_lock_take(&s->lock);
+    pos = s->deq_pos;
+    idx = pos & (q->slots - 1);
+    if (s->seq[idx] != pos + 1) {
+        ipc_lock_release(&s->lock, primask);
+        return 0;
+    }
+    s->deq_pos = pos + 1;
+    ++s->popped[IPC_LOCK_CORE];
+    ipc_lock_release(&s->lock, primask);
+
+    /* Slot is owned until sequence store */
+    __DMB();                                    /* Sequence before item */
+    slot = &q->data[idx * q->slot_len];
+#if IPC_CHAN_CACHE_MAINT
+    SCB_InvalidateDCache_by_Addr((void *)slot, (int32_t)q->slot_len);
+#endif /* IPC_CHAN_CACHE_MAINT */
+    memcpy(item, slot, q->slot_len);
+    __DMB();                                    /* Item read before slot is free */
+    s->seq[idx] = pos + q->slots;
+    return 1;
+}
+
+#endif /* IPC_MPMC */
@@ -0,0 +1,237 @@
+/**
+ * \file            ipc_notify.c
+ * \brief           Inter-core doorbell notification
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_notify.h"
+#include "ipc_lat.h"
+#include "ipc_frec.h"
+#include "ringbuff_async.h"
+
+/**
+ * \brief           Listener for single semaphore
+ */
+typedef struct {
+    ipc_notify_fn fn;                           /*!< Callback function */
+    void* arg;                                  /*!< User argument */
+} ipc_notify_listener_t;
+
+/* Listeners of current core */
+static ipc_notify_listener_t listeners[IPC_NOTIFY_SEM_COUNT];
+
+/**
+ * \brief           Register callback for semaphore released by other core
+ *
+ * Consumer of a pipe listens on pipe semaphore,
+ * callback is called from HSEM interrupt each time producer calls \ref ipc_notify
+ *
+ * \note            HSEM interrupt must be enabled in NVIC on current core
+ * \param[in]       sem_id: Semaphore ID, for example \ref HSEM_CM4_TO_CM7
+ * \param[in]       fn: Callback function
+ * \param[in]       arg: User argument passed to callback
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_notify_listen(uint32_t sem_id, ipc_notify_fn fn, void* arg) {
+    if (sem_id >= IPC_NOTIFY_SEM_COUNT || fn == NULL) {
+        return 0;
+    }
+    listeners[sem_id].arg = arg;
+    listeners[sem_id].fn = fn;
+    HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(sem_id));
+    return 1;
+}
+
+/**
+ * \brief           Stop listening on semaphore
+ * \param[in]       sem_id: Semaphore ID
+ */
+void
+ipc_notify_unlisten(uint32_t sem_id) {
+    if (sem_id >= IPC_NOTIFY_SEM_COUNT) {
+        return;
+    }
+    HAL_HSEM_DeactivateNotification(__HAL_HSEM_SEMID_TO_MASK(sem_id));
+    listeners[sem_id].fn = NULL;
+}
+
+/**
+ * \brief           Signal other core, called by producer after data were written to pipe
+ *
+ * Take and release of semaphore triggers interrupt on core that listens on it.
+ * Notification carries no data, consumer drains pipe until empty
+ *
+ * \param[in]       sem_id: Semaphore ID, for example \ref HSEM_CM4_TO_CM7
+ */
+void
+ipc_notify(uint32_t sem_id) {
+#if IPC_FREC
+    ipc_frec_add(IPC_FREC_WORD(sem_id, IPC_FREC_EVT_NOTIFY, 0));
+#endif /* IPC_FREC */
+    HSEM_TAKE_RELEASE(sem_id);
+}
+
+/**
+ * \brief           Semaphore released callback, called from `HAL_HSEM_IRQHandler`
+ *
+ * HAL disables notification for all signaled semaphores,
+ * it is activated again before listener is called,
+ * to not lose notification when producer signals during callback.
+ *
+ * Released semaphores are visited from highest ID, signals (HSEM_SIGNAL)
+ * are dispatched before channel doorbells.
+ * Pending completion callbacks (\ref IPC_ASYNC) are evaluated last
+ *
+ * \param[in]       SemMask: Mask of released semaphores
+ */
+void
+HAL_HSEM_FreeCallback(uint32_t SemMask) {
+    while (SemMask != 0) {
+        uint32_t id = 31 - __CLZ(SemMask);
+        uint32_t mask = __HAL_HSEM_SEMID_TO_MASK(id);
+
+        SemMask &= ~mask;
+        if (listeners[id].fn != NULL) {
+            HAL_HSEM_ActivateNotification(mask);
+#if IPC_FREC
+            ipc_frec_add(IPC_FREC_WORD(id, IPC_FREC_EVT_DOORBELL, 0));
+#endif /* IPC_FREC */
+#if IPC_LAT
+            ipc_lat_delivered(id - HSEM_CHAN(0));   /* Doorbell of channel, latency up to consumer interrupt */
+#endif /* IPC_LAT */
+            listeners[id].fn(id, listeners[id].arg);
+        }
+    }
+#if IPC_ASYNC
+    ringbuff_async_poll();                      /* Peer wrote data or freed memory */
+#endif /* IPC_ASYNC */
+}
+
+/**
+ * \brief           Ring doorbell and reset pending writes
+ * \param[in]       c: Coalescing policy
+ */
+static void
+prv_coalesce_fire(ipc_notify_coalesce_t* c) {
+    c->pending = 0;
+    ipc_notify(c->sem_id);
+}
+
+/**
+ * \brief           Check if oldest not signaled write exceeded timeout
+ * \param[in]       c: Coalescing policy
+ * \return          `1` if timeout expired, `0` otherwise
+ */
+static uint8_t
+prv_coalesce_expired(ipc_notify_coalesce_t* c) {
+    return c->timeout_us > 0 && c->pending > 0
+        && (CYCCNT_GET() - c->first_time) >= c->timeout_us * CYCCNT_PER_US();
+}
+
+/**
+ * \brief           Buffer event callback of producer handle
+ * \param[in]       buff: Buffer handle
+ * \param[in]       evt: Event type
+ * \param[in]       bp: Number of bytes written
+ */
+static void
+prv_coalesce_evt(RINGBUFF_VOLATILE ringbuff_t* buff, ringbuff_evt_type_t evt, size_t bp) {
+    ipc_notify_coalesce_t* c = ringbuff_get_arg(buff);
+
+    if (c == NULL || evt != RINGBUFF_EVT_WRITE) {
+        return;
+    }
+    if (c->pending++ == 0) {
+        c->first_time = CYCCNT_GET();
+    }
+    if ((c->level == 0 && c->count == 0 && c->timeout_us == 0)
+        || (c->level > 0 && ringbuff_get_full(buff) >= c->level)
+        || (c->count > 0 && c->pending >= c->count)
+        || prv_coalesce_expired(c)) {
+        prv_coalesce_fire(c);
+    }
+}
+
+/**
+ * \brief           Setup doorbell coalescing for pipe, on producer core
+ *
+ * Policy is driven by write events of producer handle,
+ * it takes over handle event callback and user argument.
+ * When timeout is used, \ref ipc_notify_coalesce_poll must be called periodically.
+ * Timeout is measured with cycle counter, which stops in sleep,
+ * producer core must not sleep while `pending` is not `0`
+ *
+ * \param[in]       c: Coalescing policy
+ * \param[in]       rb: Producer buffer handle
+ * \param[in]       sem_id: Pipe semaphore ID
+ * \param[in]       level: Fill level threshold in units of bytes, `0` to disable
+ * \param[in]       count: Number of writes threshold, `0` to disable
+ * \param[in]       timeout_us: Timeout from first not signaled write in units of microseconds, `0` to disable
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_notify_coalesce_init(ipc_notify_coalesce_t* c, RINGBUFF_VOLATILE ringbuff_t* rb, uint32_t sem_id,
+                            size_t level, uint32_t count, uint32_t timeout_us) {
+    if (c == NULL || sem_id >= IPC_NOTIFY_SEM_COUNT || !ringbuff_is_ready(rb)) {
+        return 0;
+    }
+    c->sem_id = sem_id;
+    c->level = level;
+    c->count = count;
+    c->timeout_us = timeout_us;
+    c->pending = 0;
+    CYCCNT_INIT();
+    ringbuff_set_arg(rb, c);
+    ringbuff_set_evt_fn(rb, prv_coalesce_evt);
+    return 1;
+}
+
+/**
+ * \brief           Ring doorbell if timeout of oldest not signaled write expired.
+ *                  Called periodically from producer main loop
+ * \param[in]       c: Coalescing policy
+ */
+void
+ipc_notify_coalesce_poll(ipc_notify_coalesce_t* c) {
+    if (prv_coalesce_expired(c)) {
+        prv_coalesce_fire(c);
+    }
+}
+
+/**
+ * \brief           Ring doorbell immediately, if any write is not signaled yet
+ * \param[in]       c: Coalescing policy
+ */
+void
+ipc_notify_coalesce_flush(ipc_notify_coalesce_t* c) {
+    if (c->pending > 0) {
+        prv_coalesce_fire(c);
+    }
+}
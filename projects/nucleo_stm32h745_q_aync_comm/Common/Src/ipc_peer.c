@@ -0,0 +1,131 @@
+/**
+ * \file            ipc_peer.c
+ * \brief           CPU2 reset and channel resynchronization
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_peer.h"
+#include "ipc_boot.h"
+#include "ipc_chan.h"
+#include "ipc_wait.h"
+
+#if IPC_PEER_RESET && defined(CORE_CM7)
+
+/*
+ * CPU2 is reset alone by WWDG2, reset scope of WWDG2 is CPU2 by default (RCC_GCR.WW2RSC = 0).
+ * Shared RAM, channel directory and hardware semaphores are not reset,
+ * each ring keeps pointers of CPU1 side and CPU2 re-attaches to them:
+ *
+ * - Channels written by CPU2 keep all committed data, CPU1 reads them as before
+ * - Channels read by CPU2 keep or drop data not yet read, see \ref ipc_peer_data_t
+ */
+
+/* Channel names, channels read by CPU2 end with CM7_TO_CM4 */
+#define IPC_PEER_X_NAME(name, min_len, weight, region)  #name,
+static const char* const peer_names[] = {
+    IPC_CHAN_TABLE(IPC_PEER_X_NAME)
+};
+
+/**
+ * \brief           Check if CPU2 reads channel
+ * \param[in]       id: Channel ID
+ * \return          `1` when CPU2 is consumer, `0` otherwise
+ */
+static uint8_t
+prv_is_cpu2_rx(uint32_t id) {
+    static const char sfx[] = "CM7_TO_CM4";
+    size_t len = strlen(peer_names[id]);
+
+    return len >= sizeof(sfx) - 1 && strcmp(&peer_names[id][len - (sizeof(sfx) - 1)], sfx) == 0;
+}
+
+/**
+ * \brief           Reset CPU2 and replay boot handshake from channel stage, called by CPU1 from thread mode.
+ *
+ * Recovery takes time of CPU2 startup and HAL init instead of full system reset,
+ * CPU1 peripherals, clocks and channel directory stay untouched.
+ * Features with own state on CPU2 (pool ownership, job futures, topic readers) restart from their init,
+ * CPU1 calls in flight to CPU2 expire with timeout
+ *
+ * \param[in]       data: Policy for CPU1 data not yet read by CPU2
+ * \param[in]       timeout_us: Maximum time for reset and each handshake step, in units of microseconds
+ * \return          `1` when CPU2 attached again, `0` otherwise
+ */
+uint8_t
+ipc_peer_reset(ipc_peer_data_t data, uint32_t timeout_us) {
+    volatile ipc_boot_shared_t* boot = &IPC_SHM->ctrl.boot;
+    volatile ipc_chan_dir_t* dir = &IPC_SHM->ctrl.dir;
+    volatile ringbuff_shared_t* shared;
+    ipc_wait_t wait;
+
+    __HAL_RCC_WWDG2_CLK_ENABLE();
+    RCC_C2->RSR = RCC_RSR_RMVF;                 /* Clear reset flags of CPU2 */
+
+    /* Old CPU2 must not get HSEM interrupts or keep locks over reset */
+    HSEM->C2IER = 0;
+    HSEM->C2ICR = 0xFFFFFFFF;
+    HAL_HSEM_ReleaseAll(0, HSEM_CPU2_COREID);
+
+    /* Activate WWDG2 with counter below window, CPU2 is reset immediately */
+    WWDG2->CR = WWDG_CR_WDGA;
+    ipc_wait_start(&wait, timeout_us);
+    while ((RCC_C2->RSR & RCC_RSR_WWDG2RSTF) == 0) {
+        if (ipc_wait_expired(&wait)) {
+            return 0;
+        }
+    }
+
+    /*
+     * Restarted CPU2 waits for channel stage before it accesses channels,
+     * CPU1 owns its stage and read pointers until then
+     */
+    boot->stage[IPC_BOOT_CPU2] = IPC_BOOT_STAGE_NONE;
+    if (data == IPC_PEER_DISCARD) {
+        for (uint32_t id = 0; id < IPC_CHAN_COUNT; ++id) {
+            if (dir->entries[id].shared_addr != 0 && prv_is_cpu2_rx(id)) {
+                shared = (volatile ringbuff_shared_t *)dir->entries[id].shared_addr;
+                RINGBUFF_PTR_STORE(shared->r, RINGBUFF_PTR_LOAD(shared->w));
+            }
+        }
+    }
+    __DMB();                                    /* Pointers and stage before notification */
+
+    /* Wait for CPU2 to listen again, then replay channel stage */
+    ipc_wait_start(&wait, timeout_us);
+    while (!HAL_HSEM_IsSemTaken(HSEM_BOOT_CPU2)) {
+        if (ipc_wait_expired(&wait)) {
+            return 0;
+        }
+    }
+    ipc_boot_advance(IPC_BOOT_STAGE_CHANNELS);
+    return ipc_boot_wait(IPC_BOOT_CPU2, IPC_BOOT_STAGE_ATTACHED, timeout_us);
+}
+
+#endif /* IPC_PEER_RESET && defined(CORE_CM7) */
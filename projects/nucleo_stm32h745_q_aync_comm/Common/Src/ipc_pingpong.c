@@ -0,0 +1,188 @@
+/**
+ * \file            ipc_pingpong.c
+ * \brief           Ping-pong block channel
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_pingpong.h"
+#include "ipc_chan.h"
+#include "ipc_notify.h"
+
+#include <stddef.h>
+
+#if IPC_PP
+
+/*
+ * Ping-pong channel is array of fixed blocks in shared RAM, used in order by both sides.
+ * Consumer gets whole contiguous block, never split at end of buffer,
+ * and runs its kernels directly on block memory.
+ *
+ * Each block has ownership flag in control part. Producer sets it to consumer after block was filled,
+ * consumer sets it back to producer after block was processed. Each side writes flag
+ * only while it owns the block, no lock is needed.
+ *
+ * Producer rings channel doorbell, HSEM_PP(id), for every committed block.
+ * Consumer does not notify release, producer is driven by its data rate
+ * and finds next block busy when consumer is late
+ */
+
+/* Channel state */
+#define IPC_PP_SHARED(id)                   (&IPC_SHM->ctrl.pp[(id)])
+
+/* Layout checks */
+#define IPC_PP_X_ASSERT(name, blocks, block_len)                                        \
+    _Static_assert((blocks) >= 2 && (blocks) <= IPC_PP_MAX_BLOCKS, "Ping-pong channel " #name " block count is out of range"); \
+    _Static_assert((block_len) > 0 && ((block_len) % MEM_CACHE_LINE_SIZE) == 0, "Ping-pong channel " #name " block length is not multiple of cache line");
+IPC_PP_TABLE(IPC_PP_X_ASSERT)
+
+/**
+ * \brief           Blocks of ping-pong channel in shared RAM layout
+ */
+typedef struct {
+    uint32_t data_off;                          /*!< Offset of first block */
+    uint32_t block_len;                         /*!< Block length */
+    uint32_t blocks;                            /*!< Number of blocks */
+} ipc_pp_layout_t;
+
+/* Layout of ping-pong channels, indexed by channel ID */
+#define IPC_PP_X_LAYOUT(name, blocks, block_len)    { offsetof(ipc_shm_t, pp_##name), (block_len), (blocks) },
+static const ipc_pp_layout_t pp_layout[] = {
+    IPC_PP_TABLE(IPC_PP_X_LAYOUT)
+};
+
+/**
+ * \brief           Reset all ping-pong channels, all blocks are owned by producer.
+ *                  Called by CPU1 from \ref ipc_chan_dir_init
+ */
+void
+ipc_pp_reset(void) {
+    for (size_t i = 0; i < IPC_PP_COUNT; ++i) {
+        for (size_t b = 0; b < IPC_PP_MAX_BLOCKS; ++b) {
+            IPC_PP_SHARED(i)->owner[b] = IPC_PP_OWNER_PRODUCER;
+        }
+    }
+}
+
+/**
+ * \brief           Initialize producer or consumer side of ping-pong channel,
+ *                  single producer and single consumer per channel
+ * \param[in]       pp: Channel handle
+ * \param[in]       id: Channel ID from \ref ipc_pp_id_t
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_pp_init(ipc_pp_t* pp, uint32_t id) {
+    if (pp == NULL || id >= IPC_PP_COUNT) {
+        return 0;
+    }
+    pp->shared = IPC_PP_SHARED(id);
+    pp->data = (uint8_t *)IPC_SHM + pp_layout[id].data_off;
+    pp->block_len = pp_layout[id].block_len;
+    pp->blocks = pp_layout[id].blocks;
+    pp->idx = 0;
+    pp->sem_id = HSEM_PP(id);
+    return 1;
+}
+
+/**
+ * \brief           Get next block to fill, producer side
+ * \param[in]       pp: Channel handle
+ * \return          Block data of channel block length, `NULL` if consumer still owns it
+ */
+void *
+ipc_pp_tx_acquire(ipc_pp_t* pp) {
+    if (pp == NULL || pp->shared->owner[pp->idx] != IPC_PP_OWNER_PRODUCER) {
+        return NULL;
+    }
+    __DMB();                                    /* Flag before block is written */
+    return &pp->data[pp->idx * pp->block_len];
+}
+
+/**
+ * \brief           Pass block from \ref ipc_pp_tx_acquire to consumer and ring channel doorbell
+ * \param[in]       pp: Channel handle
+ * \return          `1` on success, `0` if producer does not own block
+ */
+uint8_t
+ipc_pp_tx_commit(ipc_pp_t* pp) {
+    if (pp == NULL || pp->shared->owner[pp->idx] != IPC_PP_OWNER_PRODUCER) {
+        return 0;
+    }
+#if IPC_CHAN_CACHE_MAINT
+    SCB_CleanDCache_by_Addr((void *)&pp->data[pp->idx * pp->block_len], (int32_t)pp->block_len);
+#endif /* IPC_CHAN_CACHE_MAINT */
+    __DMB();                                    /* Block data before flag */
+    pp->shared->owner[pp->idx] = IPC_PP_OWNER_CONSUMER;
+    pp->idx = (pp->idx + 1) % pp->blocks;
+    ipc_notify(pp->sem_id);
+    return 1;
+}
+
+/**
+ * \brief           Get next filled block, consumer side.
+ *                  Block may be processed and modified in place until \ref ipc_pp_rx_release
+ * \param[in]       pp: Channel handle
+ * \return          Block data of channel block length, `NULL` if no block was committed
+ */
+void *
+ipc_pp_rx_acquire(ipc_pp_t* pp) {
+    uint8_t* block;
+
+    if (pp == NULL || pp->shared->owner[pp->idx] != IPC_PP_OWNER_CONSUMER) {
+        return NULL;
+    }
+    __DMB();                                    /* Flag before block is read */
+    block = &pp->data[pp->idx * pp->block_len];
+#if IPC_CHAN_CACHE_MAINT
+    SCB_InvalidateDCache_by_Addr((void *)block, (int32_t)pp->block_len);
+#endif /* IPC_CHAN_CACHE_MAINT */
+    return block;
+}
+
+/**
+ * \brief           Return block from \ref ipc_pp_rx_acquire to producer
+ * \param[in]       pp: Channel handle
+ * \return          `1` on success, `0` if consumer does not own block
+ */
+uint8_t
+ipc_pp_rx_release(ipc_pp_t* pp) {
+    if (pp == NULL || pp->shared->owner[pp->idx] != IPC_PP_OWNER_CONSUMER) {
+        return 0;
+    }
+#if IPC_CHAN_CACHE_MAINT
+    /* Drop lines written in place, they must not be evicted over next producer data */
+    SCB_InvalidateDCache_by_Addr((void *)&pp->data[pp->idx * pp->block_len], (int32_t)pp->block_len);
+#endif /* IPC_CHAN_CACHE_MAINT */
+    __DMB();                                    /* Block accesses before flag */
+    pp->shared->owner[pp->idx] = IPC_PP_OWNER_PRODUCER;
+    pp->idx = (pp->idx + 1) % pp->blocks;
+    return 1;
+}
+
+#endif /* IPC_PP */
@@ -0,0 +1,352 @@
+/**
+ * \file            ipc_pool.c
+ * \brief           Buffer pool with descriptor passing
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_pool.h"
+#include "ipc_notify.h"
+
+#if IPC_POOL
+
+/*
+ * Pool is array of IPC_POOL_BLOCKS fixed blocks in POOL_RAM, SRAM3.
+ * Free blocks are kept in bit mask of allocating side, CPU2, no shared free list.
+ *
+ * Block is shared by reference count in its header, split per core.
+ * Each core modifies only its own counter, with LDREX/STREX against other contexts of the same core.
+ * Exclusive accesses therefore never compete between cores, no global exclusive monitor is needed:
+ *
+ * - Allocation sets CPU2 counter to `1`, for allocating context
+ * - Descriptor message in descriptor channel adds one CPU2 reference for CPU1 and sets CPU1 counter to `1`.
+ *      Block is sent to CPU1 at most once at a time, CPU1 shares it further with \ref ipc_pool_retain
+ * - When CPU1 counter drops to `0`, block index in return channel drops reference of CPU1 in CPU2 counter
+ * - When CPU2 counter drops to `0`, block is free
+ *
+ * Both channels are single-producer single-consumer ring buffers, pool needs no lock.
+ * Pool memory is non-cacheable for CPU1, see MPU_Config, block data need no cache maintenance
+ */
+
+/* Reference counter index of each core */
+#define IPC_POOL_CPU1                       0
+#define IPC_POOL_CPU2                       1
+#if defined(CORE_CM7)
+#define IPC_POOL_CORE                       IPC_POOL_CPU1
+#else
+#define IPC_POOL_CORE                       IPC_POOL_CPU2
+#endif
+
+/* Pool memory, only object in `.pool_ram` NOLOAD section of both images */
+static uint8_t ipc_pool_mem[IPC_POOL_BLOCKS][IPC_POOL_BLOCK_LEN] __attribute__((section(".pool_ram"), aligned(32)));
+
+/* Header of block */
+#define IPC_POOL_HDR(idx)                   ((volatile ipc_pool_hdr_t *)ipc_pool_mem[(idx)])
+
+_Static_assert(IPC_POOL_BLOCKS > 0 && IPC_POOL_BLOCKS <= 32, "Pool block count does not fit to free mask");
+_Static_assert(sizeof(ipc_pool_mem) <= POOL_RAM_LEN, "Pool overflows pool RAM");
+_Static_assert(sizeof(ipc_pool_hdr_t) <= IPC_POOL_HDR_LEN, "Pool block header is too long");
+
+/**
+ * \brief           Add to counter atomically against other contexts of this core
+ * \param[in]       p: Counter, modified by this core only
+ * \param[in]       d: Value to add
+ * \return          New counter value
+ */
+static uint32_t
+prv_add(volatile uint32_t* p, int32_t d) {
+    uint32_t v;
+
+    do {
+        v = __LDREXW(p) + (uint32_t)d;
+    } while (__STREXW(v, p) != 0);
+    return v;
+}
+
+/**
+ * \brief           Set or clear bits atomically against other contexts of this core
+ * \param[in]       p: Bit mask
+ * \param[in]       set: Bits to set
+ * \param[in]       clr: Bits to clear
+ */
+static void
+prv_bits(volatile uint32_t* p, uint32_t set, uint32_t clr) {
+    uint32_t v;
+
+    do {
+        v = (__LDREXW(p) & ~clr) | set;
+    } while (__STREXW(v, p) != 0);
+}
+
+/**
+ * \brief           Get index of block
+ * \param[in]       block: Block data address
+ * \return          Block index, \ref IPC_POOL_BLOCKS if address is not start of block data
+ */
+static uint32_t
+prv_index(const void* block) {
+    uint32_t off = (uint32_t)((const uint8_t *)block - &ipc_pool_mem[0][0]) - IPC_POOL_HDR_LEN;
+
+    if ((const uint8_t *)block < &ipc_pool_mem[0][IPC_POOL_HDR_LEN] || off >= sizeof(ipc_pool_mem)
+        || (off % IPC_POOL_BLOCK_LEN) != 0) {
+        return IPC_POOL_BLOCKS;
+    }
+    return off / IPC_POOL_BLOCK_LEN;
+}
+
+/**
+ * \brief           Drop CPU2 reference, block is free when it was the last one
+ * \param[in]       tx: Allocating side handle
+ * \param[in]       idx: Block index
+ */
+static void
+prv_put(ipc_pool_tx_t* tx, uint32_t idx) {
+    if (prv_add(&IPC_POOL_HDR(idx)->refs[IPC_POOL_CPU2], -1) == 0) {
+        prv_bits(&tx->free, 1UL << idx, 0);
+    }
+}
+
+/**
+ * \brief           Initialize allocating side on CPU2, all blocks are free.
+ *                  Call once, before receiving side uses pool
+ * \param[in]       tx: Allocating side handle
+ * \param[in]       desc: Descriptor channel buffer handle, producer side
+ * \param[in]       ret: Return channel buffer handle, consumer side
+ * \param[in]       sem_id: Descriptor channel doorbell
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_pool_tx_init(ipc_pool_tx_t* tx, RINGBUFF_VOLATILE ringbuff_t* desc, RINGBUFF_VOLATILE ringbuff_t* ret, uint32_t sem_id) {
+    if (tx == NULL || desc == NULL || ret == NULL
+        || ringbuff_get_free(ret) < IPC_POOL_BLOCKS) {
+        return 0;                               /* Return channel must hold index of every block */
+    }
+    tx->desc = desc;
+    tx->ret = ret;
+    tx->sem_id = sem_id;
+    tx->remote = 0;
+    for (size_t i = 0; i < IPC_POOL_BLOCKS; ++i) {
+        IPC_POOL_HDR(i)->refs[IPC_POOL_CPU1] = 0;
+        IPC_POOL_HDR(i)->refs[IPC_POOL_CPU2] = 0;
+    }
+    tx->free = IPC_POOL_BLOCKS == 32 ? 0xFFFFFFFF : ((1UL << IPC_POOL_BLOCKS) - 1);
+    return 1;
+}
+
+/**
+ * \brief           Allocate block, blocks released by CPU1 are reclaimed first.
+ *                  Call \ref ipc_pool_alloc and \ref ipc_pool_send from one context
+ * \param[in]       tx: Allocating side handle
+ * \return          Block data of \ref IPC_POOL_DATA_LEN bytes with one reference,
+ *                      `NULL` if all blocks are in use
+ */
+void *
+ipc_pool_alloc(ipc_pool_tx_t* tx) {
+    uint32_t free, idx;
+    uint8_t ret;
+
+    if (tx == NULL) {
+        return NULL;
+    }
+    while (ringbuff_read(tx->ret, &ret, 1) == 1) {
+        if (ret < IPC_POOL_BLOCKS && (tx->remote & (1UL << ret))) {
+            prv_bits(&tx->remote, 0, 1UL << ret);
+            prv_put(tx, ret);
+        }
+    }
+    do {
+        free = __LDREXW(&tx->free);
+        if (free == 0) {
+            __CLREX();
+            return NULL;
+        }
+        idx = __builtin_ctz(free);
+    } while (__STREXW(free & ~(1UL << idx), &tx->free) != 0);
+
+    IPC_POOL_HDR(idx)->refs[IPC_POOL_CPU1] = 0;
+    IPC_POOL_HDR(idx)->refs[IPC_POOL_CPU2] = 1;
+    return &ipc_pool_mem[idx][IPC_POOL_HDR_LEN];
+}
+
+/**
+ * \brief           Drop reference of CPU2 holder, block is free after last reference.
+ *                  Can be called from any context of CPU2
+ * \param[in]       tx: Allocating side handle
+ * \param[in]       block: Block data from \ref ipc_pool_alloc
+ */
+void
+ipc_pool_put(ipc_pool_tx_t* tx, void* block) {
+    uint32_t idx = prv_index(block);
+
+    if (tx != NULL && idx < IPC_POOL_BLOCKS) {
+        prv_put(tx, idx);
+    }
+}
+
+/**
+ * \brief           Send block to CPU1, only descriptor is copied to channel.
+ *                  Caller keeps its reference, drop it with \ref ipc_pool_put when done
+ * \param[in]       tx: Allocating side handle
+ * \param[in]       block: Block data from \ref ipc_pool_alloc, filled with data
+ * \param[in]       len: Number of valid bytes in block
+ * \return          `1` on success, `0` if descriptor channel is full or block is still at CPU1
+ */
+uint8_t
+ipc_pool_send(ipc_pool_tx_t* tx, void* block, size_t len) {
+    ipc_pool_desc_t d;
+    uint32_t idx = prv_index(block);
+
+    if (tx == NULL || idx >= IPC_POOL_BLOCKS || len > IPC_POOL_DATA_LEN
+        || (tx->remote & (1UL << idx))) {
+        return 0;
+    }
+    prv_add(&IPC_POOL_HDR(idx)->refs[IPC_POOL_CPU2], 1);   /* Reference of CPU1 */
+    prv_bits(&tx->remote, 1UL << idx, 0);
+    d.off = idx * IPC_POOL_BLOCK_LEN;
+    d.len = (uint32_t)len;
+    __DMB();                                    /* Block data before descriptor */
+    if (ringbuff_msg_send(tx->desc, &d, sizeof(d)) == 0) {
+        prv_bits(&tx->remote, 0, 1UL << idx);
+        prv_add(&IPC_POOL_HDR(idx)->refs[IPC_POOL_CPU2], -1);
+        return 0;
+    }
+    ipc_notify(tx->sem_id);
+    return 1;
+}
+
+/**
+ * \brief           Initialize receiving side on CPU1
+ * \param[in]       rx: Receiving side handle
+ * \param[in]       desc: Descriptor channel buffer handle, consumer side
+ * \param[in]       ret: Return channel buffer handle, producer side
+ * \param[in]       sem_id: Return channel doorbell
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_pool_rx_init(ipc_pool_rx_t* rx, RINGBUFF_VOLATILE ringbuff_t* desc, RINGBUFF_VOLATILE ringbuff_t* ret, uint32_t sem_id) {
+    if (rx == NULL || desc == NULL || ret == NULL) {
+        return 0;
+    }
+    rx->desc = desc;
+    rx->ret = ret;
+    rx->sem_id = sem_id;
+    return 1;
+}
+
+/**
+ * \brief           Receive next block, data are read in place
+ * \param[in]       rx: Receiving side handle
+ * \param[out]      len: Output variable to write number of valid bytes to
+ * \return          Block data with one reference, drop it with \ref ipc_pool_release.
+ *                      `NULL` if no block was received
+ */
+void *
+ipc_pool_recv(ipc_pool_rx_t* rx, size_t* len) {
+    ipc_pool_desc_t d;
+    uint32_t idx;
+
+    if (rx == NULL || len == NULL) {
+        return NULL;
+    }
+    while (ringbuff_msg_recv(rx->desc, &d, sizeof(d)) == sizeof(d)) {
+        idx = d.off / IPC_POOL_BLOCK_LEN;
+        if (idx < IPC_POOL_BLOCKS && (d.off % IPC_POOL_BLOCK_LEN) == 0
+            && d.len <= IPC_POOL_DATA_LEN) {
+            IPC_POOL_HDR(idx)->refs[IPC_POOL_CPU1] = 1; /* No other CPU1 holder, block is sent once at a time */
+            *len = d.len;
+            return &ipc_pool_mem[idx][IPC_POOL_HDR_LEN];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Drop reference of CPU1 holder, block returns to CPU2 after last reference.
+ *                  Can be called from any context of CPU1
+ * \param[in]       rx: Receiving side handle
+ * \param[in]       block: Block data from \ref ipc_pool_recv
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_pool_release(ipc_pool_rx_t* rx, void* block) {
+    uint32_t idx = prv_index(block), primask;
+    uint8_t b = (uint8_t)idx, ok;
+
+    if (rx == NULL || idx >= IPC_POOL_BLOCKS) {
+        return 0;
+    }
+    __DMB();                                    /* Block reads before reference is dropped */
+    if (prv_add(&IPC_POOL_HDR(idx)->refs[IPC_POOL_CPU1], -1) != 0) {
+        return 1;
+    }
+
+    /* Last holder may run in any context, return channel has single producer */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    ok = ringbuff_write(rx->ret, &b, 1) == 1;   /* Return channel holds all blocks */
+    __set_PRIMASK(primask);
+    if (ok) {
+        ipc_notify(rx->sem_id);
+    }
+    return ok;
+}
+
+/**
+ * \brief           Add reference of this core, for another holder of block.
+ *                  Caller must already hold reference
+ * \param[in]       block: Block data
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_pool_retain(void* block) {
+    uint32_t idx = prv_index(block);
+
+    if (idx >= IPC_POOL_BLOCKS) {
+        return 0;
+    }
+    prv_add(&IPC_POOL_HDR(idx)->refs[IPC_POOL_CORE], 1);
+    return 1;
+}
+
+/**
+ * \brief           Get reference count of block on one core, snapshot for diagnostics
+ * \param[in]       block: Block data
+ * \param[in]       core: `0` for CPU1, `1` for CPU2. CPU2 count includes one reference for CPU1
+ * \return          Reference count
+ */
+uint32_t
+ipc_pool_get_refs(const void* block, uint32_t core) {
+    uint32_t idx = prv_index(block);
+
+    if (idx >= IPC_POOL_BLOCKS || core > IPC_POOL_CPU2) {
+        return 0;
+    }
+    return IPC_POOL_HDR(idx)->refs[core];
+}
+
+#endif /* IPC_POOL */
@@ -0,0 +1,323 @@
+/**
+ * \file            ipc_pubsub.c
+ * \brief           Topic publish/subscribe between cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_pubsub.h"
+#include "ipc_chan.h"
+#include "ipc_notify.h"
+
+#include <stddef.h>
+
+#if IPC_PUBSUB
+
+/*
+ * Topic is broadcast ring buffer with single publisher and up to IPC_TOPIC_SUBS subscribers.
+ * Publisher writes each record once, every subscriber has its own read index.
+ *
+ * Record is header with payload length followed by payload, padded to 4 bytes.
+ * Indices are free-running, record may wrap at end of data array.
+ *
+ * With IPC_TOPIC_DROP policy, publisher evicts subscriber whose unread data would be overwritten:
+ * it increments eviction count of subscriber before it overwrites data.
+ * Evicted subscriber no longer gates publisher, it skips to newest data on next read and acknowledges eviction.
+ * Subscriber re-checks eviction count after copy, record overwritten during copy is discarded
+ */
+
+/* Topic state */
+#define IPC_TOPIC_SHARED(id)                (&IPC_SHM->ctrl.topic[(id)])
+
+/* Bytes used by record in topic data */
+#define IPC_TOPIC_REC_LEN(len)              (sizeof(uint32_t) + MEM_ALIGN(len))
+
+/* Layout checks */
+#define IPC_TOPIC_X_ASSERT(name, len)                                                   \
+    _Static_assert((len) >= 0x20 && ((len) & ((len) - 1)) == 0, "Topic " #name " length is not power of 2");
+IPC_TOPIC_TABLE(IPC_TOPIC_X_ASSERT)
+
+/**
+ * \brief           Data of topic in shared RAM layout
+ */
+typedef struct {
+    uint32_t data_off;                          /*!< Offset of data */
+    uint32_t data_len;                          /*!< Data length */
+} ipc_topic_layout_t;
+
+/* Layout of topics, indexed by topic ID */
+#define IPC_TOPIC_X_LAYOUT(name, len)       { offsetof(ipc_shm_t, topic_##name), (len) },
+static const ipc_topic_layout_t topic_layout[] = {
+    IPC_TOPIC_TABLE(IPC_TOPIC_X_LAYOUT)
+};
+
+/**
+ * \brief           Copy data from topic, with wrap at end of data array
+ * \param[in]       data: Topic data array
+ * \param[in]       size: Topic data length
+ * \param[in]       r: Read index, free-running
+ * \param[out]      dst: Destination memory
+ * \param[in]       len: Number of bytes to copy
+ */
+static void
+prv_copy_from(const uint8_t* data, uint32_t size, uint32_t r, void* dst, size_t len) {
+    size_t off = r & (size - 1), first = size - off;
+
+    if (first > len) {
+        first = len;
+    }
+#if IPC_CHAN_CACHE_MAINT
+    /* Topic data are only read by this core, lines can be invalidated whole */
+    SCB_InvalidateDCache_by_Addr((void *)&data[off], (int32_t)first);
+    if (len > first) {
+        SCB_InvalidateDCache_by_Addr((void *)data, (int32_t)(len - first));
+    }
+#endif /* IPC_CHAN_CACHE_MAINT */
+    memcpy(dst, &data[off], first);
+    if (len > first) {
+        memcpy((uint8_t *)dst + first, data, len - first);
+    }
+}
+
+/**
+ * \brief           Copy data to topic, with wrap at end of data array
+ * \param[in]       data: Topic data array
+ * \param[in]       size: Topic data length
+ * \param[in]       w: Write index, free-running
+ * \param[in]       src: Source memory
+ * \param[in]       len: Number of bytes to copy
+ */
+static void
+prv_copy_to(uint8_t* data, uint32_t size, uint32_t w, const void* src, size_t len) {
+    size_t off = w & (size - 1), first = size - off;
+
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&data[off], src, first);
+    if (len > first) {
+        memcpy(data, (const uint8_t *)src + first, len - first);
+    }
+#if IPC_CHAN_CACHE_MAINT
+    SCB_CleanDCache_by_Addr((void *)&data[off], (int32_t)first);
+    if (len > first) {
+        SCB_CleanDCache_by_Addr((void *)data, (int32_t)(len - first));
+    }
+#endif /* IPC_CHAN_CACHE_MAINT */
+}
+
+/**
+ * \brief           Reset state of all topics, no subscribers.
+ *                  Called by CPU1 from \ref ipc_chan_dir_init
+ */
+void
+ipc_topic_reset(void) {
+    for (size_t i = 0; i < IPC_TOPIC_COUNT; ++i) {
+        volatile ipc_topic_shared_t* t = IPC_TOPIC_SHARED(i);
+
+        t->w = 0;
+        for (size_t s = 0; s < IPC_TOPIC_SUBS; ++s) {
+            t->evict[s] = 0;
+            t->sub[s].r = 0;
+            t->sub[s].ack = 0;
+            t->sub[s].active = 0;
+        }
+    }
+}
+
+/**
+ * \brief           Initialize publisher of topic, single publisher per topic
+ * \param[in]       pub: Publisher handle
+ * \param[in]       id: Topic ID from \ref ipc_topic_id_t
+ * \param[in]       policy: Slow subscriber policy
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_topic_pub_init(ipc_topic_pub_t* pub, uint32_t id, ipc_topic_policy_t policy) {
+    if (pub == NULL || id >= IPC_TOPIC_COUNT) {
+        return 0;
+    }
+    pub->shared = IPC_TOPIC_SHARED(id);
+    pub->data = (uint8_t *)IPC_SHM + topic_layout[id].data_off;
+    pub->size = topic_layout[id].data_len;
+    pub->sem_id = HSEM_TOPIC(id);
+    pub->policy = policy;
+    return 1;
+}
+
+/**
+ * \brief           Publish record to all subscribers and ring topic doorbell
+ * \param[in]       pub: Publisher handle
+ * \param[in]       data: Record payload
+ * \param[in]       len: Payload length in units of bytes
+ * \return          `1` if record was published, `0` if it does not fit
+ *                      or slowest subscriber gates topic, \ref IPC_TOPIC_GATE
+ */
+uint8_t
+ipc_topic_publish(ipc_topic_pub_t* pub, const void* data, size_t len) {
+    volatile ipc_topic_shared_t* t;
+    uint32_t w, need, hdr = (uint32_t)len;
+
+    if (pub == NULL || (data == NULL && len > 0)) {
+        return 0;
+    }
+    need = IPC_TOPIC_REC_LEN(len);
+    if (need > pub->size) {
+        return 0;
+    }
+    t = pub->shared;
+    w = t->w;
+
+    /* Free memory is limited by slowest active subscriber, not evicted yet */
+    for (size_t i = 0; i < IPC_TOPIC_SUBS; ++i) {
+        if (!t->sub[i].active || t->evict[i] != t->sub[i].ack) {
+            continue;
+        }
+        if (pub->size - (w - t->sub[i].r) < need) {
+            if (pub->policy == IPC_TOPIC_GATE) {
+                return 0;
+            }
+            t->evict[i] = t->evict[i] + 1;
+        }
+    }
+    __DMB();                                    /* Evictions before data are overwritten */
+
+    prv_copy_to(pub->data, pub->size, w, &hdr, sizeof(hdr));
+    prv_copy_to(pub->data, pub->size, w + sizeof(hdr), data, len);
+    __DMB();                                    /* Data before write index */
+    t->w = w + need;
+    ipc_notify(pub->sem_id);
+    return 1;
+}
+
+/**
+ * \brief           Subscribe to topic, subscriber receives records published afterwards.
+ *                  All subscribers of topic must be on the same core, or use distinct indices
+ * \param[in]       sub: Subscriber handle
+ * \param[in]       id: Topic ID from \ref ipc_topic_id_t
+ * \param[in]       idx: Subscriber index, `0` to \ref IPC_TOPIC_SUBS `- 1`, unique per topic
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_topic_subscribe(ipc_topic_sub_t* sub, uint32_t id, uint32_t idx) {
+    volatile ipc_topic_shared_t* t;
+
+    if (sub == NULL || id >= IPC_TOPIC_COUNT || idx >= IPC_TOPIC_SUBS) {
+        return 0;
+    }
+    t = IPC_TOPIC_SHARED(id);
+    if (t->sub[idx].active) {
+        return 0;
+    }
+    sub->shared = t;
+    sub->data = (const uint8_t *)IPC_SHM + topic_layout[id].data_off;
+    sub->size = topic_layout[id].data_len;
+    sub->idx = idx;
+    sub->lost = 0;
+
+    t->sub[idx].ack = t->evict[idx];
+    t->sub[idx].r = t->w;
+    __DMB();                                    /* Read index before publisher sees subscriber */
+    t->sub[idx].active = 1;
+    return 1;
+}
+
+/**
+ * \brief           Remove subscriber, it no longer gates publisher
+ * \param[in]       sub: Subscriber handle
+ */
+void
+ipc_topic_unsubscribe(ipc_topic_sub_t* sub) {
+    if (sub != NULL && sub->shared != NULL) {
+        sub->shared->sub[sub->idx].active = 0;
+        sub->shared = NULL;
+    }
+}
+
+/**
+ * \brief           Read next record of topic
+ * \param[in]       sub: Subscriber handle
+ * \param[out]      data: Memory to copy payload to
+ * \param[in]       size: Size of `data` in units of bytes
+ * \return          Payload length, `0` if no record is available.
+ *                      Value greater than `size` means record did not fit and was dropped
+ */
+size_t
+ipc_topic_read(ipc_topic_sub_t* sub, void* data, size_t size) {
+    volatile ipc_topic_shared_t* t;
+    volatile ipc_topic_sub_shared_t* s;
+    uint32_t w, r, ev, len;
+
+    if (sub == NULL || sub->shared == NULL) {
+        return 0;
+    }
+    t = sub->shared;
+    s = &t->sub[sub->idx];
+    while (1) {
+        ev = t->evict[sub->idx];
+        if (ev != s->ack) {
+            /* Evicted, skip unread data to newest record */
+            __DMB();
+            s->r = t->w;
+            __DMB();                            /* Read index before acknowledge */
+            s->ack = ev;
+            ++sub->lost;
+            continue;
+        }
+        w = t->w;
+        __DMB();                                /* Write index before data */
+        r = s->r;
+        if (r == w) {
+            return 0;
+        }
+
+        prv_copy_from(sub->data, sub->size, r, &len, sizeof(len));
+        if (len <= sub->size - sizeof(len) && len <= size) {
+            prv_copy_from(sub->data, sub->size, r + sizeof(len), data, len);
+        }
+        __DMB();                                /* Data before eviction re-check */
+        if (t->evict[sub->idx] != ev) {
+            continue;                           /* Overwritten during copy */
+        }
+        s->r = r + IPC_TOPIC_REC_LEN(len);
+        return len;
+    }
+}
+
+/**
+ * \brief           Get number of evictions of subscriber, see \ref IPC_TOPIC_DROP
+ * \param[in]       sub: Subscriber handle
+ * \return          Number of times subscriber skipped unread data
+ */
+uint32_t
+ipc_topic_get_lost(const ipc_topic_sub_t* sub) {
+    return sub != NULL ? sub->lost : 0;
+}
+
+#endif /* IPC_PUBSUB */
@@ -0,0 +1,210 @@
+/**
+ * \file            ipc_route.c
+ * \brief           Output router, channels to sinks
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "common.h"
+#include "ipc_route.h"
+#include "ipc_frec.h"
+
+#if IPC_ROUTE
+
+/*
+ * Router runs in thread of CPU1. Each source channel is drained as fast as CPU2 fills it,
+ * every linear block is copied to queue of every sink of the channel.
+ * Sink with full queue drops block or overwrites its oldest data, per its policy,
+ * channel and other sinks are never held back by slow sink.
+ *
+ * Every sink has its own queue and drains it at its own pace, started by kick callback.
+ * Queue drained by DMA must be in DMA accessible memory, with cache maintenance when cacheable
+ */
+
+/* Maximum number of linear blocks read from one source in single poll, covers buffer wrap */
+#define IPC_ROUTE_BLOCKS_MAX                2
+
+/**
+ * \brief           Initialize sink
+ * \param[in]       sink: Sink handle
+ * \param[in]       queue: Sink queue, initialized. Set to `NULL` to discard data, counted in `bytes`
+ * \param[in]       policy: Policy on full queue. \ref IPC_SINK_OVERWRITE queue must be read
+ *                      in same thread as router, oldest data are skipped by router
+ * \param[in]       kick_fn: Drain start callback. Can be set to `NULL`
+ * \param[in]       arg: User argument
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_sink_init(ipc_sink_t* sink, RINGBUFF_VOLATILE ringbuff_t* queue, ipc_sink_policy_t policy, ipc_sink_kick_fn kick_fn, void* arg) {
+    if (sink == NULL || (queue != NULL && !ringbuff_is_ready(queue))) {
+        return 0;
+    }
+    sink->queue = queue;
+    sink->policy = policy;
+    sink->kick_fn = kick_fn;
+    sink->arg = arg;
+    sink->put_fn = NULL;
+    sink->stage = NULL;
+    sink->bytes = 0;
+    sink->drops = 0;
+    return 1;
+}
+
+/**
+ * \brief           Queue data to sink
+ * \param[in]       sink: Sink handle
+ * \param[in]       id: Channel ID of source
+ * \param[in]       data: Data to queue
+ * \param[in]       len: Data length in units of bytes
+ * \return          `1` if data were queued and sink must be kicked, `0` otherwise
+ */
+static uint8_t
+prv_sink_put(ipc_sink_t* sink, uint32_t id, const uint8_t* data, size_t len) {
+    size_t cap, free;
+
+    if (sink->queue == NULL) {
+        sink->bytes += len;
+        return 0;
+    }
+    if (sink->put_fn != NULL) {
+        return sink->put_fn(sink, id, data, len);
+    }
+    if (sink->policy == IPC_SINK_OVERWRITE) {
+        /* Keep newest data, which may be more than whole queue holds */
+        free = ringbuff_get_free(sink->queue);
+        cap = free + ringbuff_get_full(sink->queue);
+        if (len > cap) {
+            sink->drops += len - cap;
+#if IPC_FREC
+            ipc_frec_add(IPC_FREC_WORD(id, IPC_FREC_EVT_DROP, len - cap));
+#endif /* IPC_FREC */
+            data += len - cap;
+            len = cap;
+        }
+        if (free < len) {
+            ringbuff_skip(sink->queue, len - free);
+            sink->drops += len - free;
+#if IPC_FREC
+            ipc_frec_add(IPC_FREC_WORD(id, IPC_FREC_EVT_DROP, len - free));
+#endif /* IPC_FREC */
+        }
+    }
+    if (ringbuff_write_all(sink->queue, data, len) == RINGBUFF_WOULD_BLOCK) {
+        sink->drops += len;
+#if IPC_FREC
+        ipc_frec_add(IPC_FREC_WORD(id, IPC_FREC_EVT_DROP, len));
+#endif /* IPC_FREC */
+        return 0;
+    }
+    sink->bytes += len;
+    return 1;
+}
+
+/**
+ * \brief           Initialize router without sinks and sources
+ * \param[in]       r: Router handle
+ */
+void
+ipc_router_init(ipc_router_t* r) {
+    r->sink_count = 0;
+    r->src_count = 0;
+}
+
+/**
+ * \brief           Add sink to router
+ * \param[in]       r: Router handle
+ * \param[in]       sink: Sink handle, initialized
+ * \return          Sink bit for \ref ipc_router_add_src, `0` when router has no free sink
+ */
+uint32_t
+ipc_router_add_sink(ipc_router_t* r, ipc_sink_t* sink) {
+    if (sink == NULL || r->sink_count >= IPC_ROUTE_SINK_MAX) {
+        return 0;
+    }
+    r->sinks[r->sink_count] = sink;
+    return 1UL << r->sink_count++;
+}
+
+/**
+ * \brief           Add source channel to router, routes are fixed after start of polling
+ * \param[in]       r: Router handle
+ * \param[in]       id: Channel ID, it tags data of channel in encoding stages
+ * \param[in]       rb: Channel handle, consumer side. Router is its only consumer
+ * \param[in]       sinks: Mask of sink bits the channel is routed to
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_router_add_src(ipc_router_t* r, uint32_t id, RINGBUFF_VOLATILE ringbuff_t* rb, uint32_t sinks) {
+    if (!ringbuff_is_ready(rb) || r->src_count >= IPC_ROUTE_SRC_MAX
+        || sinks == 0 || (sinks >> r->sink_count) != 0) {
+        return 0;
+    }
+    r->src[r->src_count].rb = rb;
+    r->src[r->src_count].id = id;
+    r->src[r->src_count].sinks = sinks;
+    ++r->src_count;
+    return 1;
+}
+
+/**
+ * \brief           Copy data of all sources to their sinks and kick sinks with new data.
+ *                  Call from thread when source channel was notified
+ * \param[in]       r: Router handle
+ * \return          Number of bytes released from sources
+ */
+size_t
+ipc_router_poll(ipc_router_t* r) {
+    uint32_t kick = 0;
+    size_t total = 0, len;
+    const uint8_t* addr;
+
+    for (size_t i = 0; i < r->src_count; ++i) {
+        ipc_route_src_t* src = &r->src[i];
+
+        for (size_t n = 0; n < IPC_ROUTE_BLOCKS_MAX; ++n) {
+            len = ringbuff_get_linear_block_read_length(src->rb);
+            if (len == 0) {
+                break;
+            }
+            addr = ringbuff_get_linear_block_read_address(src->rb);
+            for (size_t s = 0; s < r->sink_count; ++s) {
+                if ((src->sinks & (1UL << s)) != 0 && prv_sink_put(r->sinks[s], src->id, addr, len)) {
+                    kick |= 1UL << s;
+                }
+            }
+            ringbuff_skip(src->rb, len);
+            total += len;
+        }
+    }
+    for (size_t s = 0; s < r->sink_count; ++s) {
+        if ((kick & (1UL << s)) != 0 && r->sinks[s]->kick_fn != NULL) {
+            r->sinks[s]->kick_fn(r->sinks[s]);
+        }
+    }
+    return total;
+}
+
+#endif /* IPC_ROUTE */
@@ -0,0 +1,364 @@
+/**
+ * \file            ipc_rpc.c
+ * \brief           Request and response calls over control lanes
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_rpc.h"
+#include "ipc_lane.h"
+#include "ipc_notify.h"
+
+/*
+ * Requests and responses are messages on control lanes, header followed by arguments or result.
+ * Client assigns correlation ID to each call and server echoes it in response,
+ * responses may therefore arrive in any order.
+ *
+ * Arguments and results are written directly to channel memory reserved with
+ * ringbuff_msg_send_reserve. When message would wrap at end of buffer,
+ * it is written to core-local stage memory and copied to channel instead
+ */
+
+/**
+ * \brief           Get free call slot
+ * \param[in]       cli: Client handle
+ * \return          Free slot, `NULL` if all calls are in flight
+ */
+static ipc_rpc_call_t*
+prv_free_call(ipc_rpc_client_t* cli) {
+    for (size_t i = 0; i < IPC_RPC_PENDING; ++i) {
+        if (cli->calls[i].corr == 0) {
+            return &cli->calls[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Initialize server
+ * \param[in]       srv: Server handle
+ * \param[in]       tx: Response channel buffer handle, producer side
+ * \param[in]       sem_id: Response channel doorbell
+ * \param[in]       methods: Method table, must stay valid while server is used
+ * \param[in]       count: Number of entries in method table
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_rpc_server_init(ipc_rpc_server_t* srv, RINGBUFF_VOLATILE ringbuff_t* tx, uint32_t sem_id,
+                    const ipc_rpc_method_t* methods, size_t count) {
+    if (srv == NULL || tx == NULL || (methods == NULL && count > 0)) {
+        return 0;
+    }
+    srv->tx = tx;
+    srv->sem_id = sem_id;
+    srv->methods = methods;
+    srv->count = count;
+    return 1;
+}
+
+/**
+ * \brief           Execute request and send response
+ *
+ * Call for every message received on request channel.
+ * Method writes its result directly to response channel memory
+ *
+ * \param[in]       srv: Server handle
+ * \param[in]       msg: Request message
+ * \param[in]       len: Request message length in units of bytes
+ * \return          `1` if response was sent, `0` otherwise
+ */
+uint8_t
+ipc_rpc_serve(ipc_rpc_server_t* srv, const void* msg, size_t len) {
+    ipc_rpc_hdr_t hdr;
+    uint8_t* out;
+    size_t res_len = 0, i;
+    uint8_t staged = 0, ok;
+
+    if (srv == NULL || msg == NULL || len < sizeof(hdr)) {
+        return 0;
+    }
+    memcpy(&hdr, msg, sizeof(hdr));
+
+    out = ringbuff_msg_send_reserve(srv->tx, sizeof(hdr) + IPC_RPC_MAX_LEN);
+    if (out == NULL) {
+        out = srv->stage;
+        staged = 1;
+    }
+
+    hdr.status = IPC_RPC_ERR_METHOD;
+    for (i = 0; i < srv->count; ++i) {
+        if (srv->methods[i].method == hdr.method) {
+            res_len = IPC_RPC_MAX_LEN;
+            hdr.status = (int16_t)srv->methods[i].fn((const uint8_t *)msg + sizeof(hdr), len - sizeof(hdr),
+                                                     out + sizeof(hdr), &res_len);
+            if (res_len > IPC_RPC_MAX_LEN) {
+                res_len = IPC_RPC_MAX_LEN;
+            }
+            break;
+        }
+    }
+    memcpy(out, &hdr, sizeof(hdr));
+
+    if (staged) {
+        ok = ringbuff_msg_send(srv->tx, out, sizeof(hdr) + res_len) > 0;
+    } else {
+        ok = ringbuff_msg_send_commit(srv->tx, sizeof(hdr) + res_len) > 0;
+    }
+    if (ok) {
+        ipc_notify(srv->sem_id);
+    }
+    return ok;
+}
+
+/**
+ * \brief           Initialize client
+ * \param[in]       cli: Client handle
+ * \param[in]       tx: Request channel buffer handle, producer side
+ * \param[in]       rx: Response channel buffer handle, consumer side
+ * \param[in]       sem_id: Request channel doorbell
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_rpc_client_init(ipc_rpc_client_t* cli, RINGBUFF_VOLATILE ringbuff_t* tx, RINGBUFF_VOLATILE ringbuff_t* rx, uint32_t sem_id) {
+    if (cli == NULL || tx == NULL || rx == NULL) {
+        return 0;
+    }
+    memset(cli, 0x00, sizeof(*cli));
+    cli->tx = tx;
+    cli->rx = rx;
+    cli->sem_id = sem_id;
+    cli->next_corr = 1;
+    CYCCNT_INIT();                              /* Time base of call timeouts */
+    return 1;
+}
+
+/**
+ * \brief           Reserve request of asynchronous call, for zero-copy arguments.
+ *                  Request is sent with \ref ipc_rpc_call_commit
+ * \param[in]       cli: Client handle
+ * \param[in]       method: Method ID
+ * \param[in]       len: Maximum length of arguments in units of bytes, up to \ref IPC_RPC_MAX_LEN
+ * \return          Memory to write arguments to, not aligned. `NULL` if no call slot is free
+ *                      or request channel is full
+ */
+void *
+ipc_rpc_call_reserve(ipc_rpc_client_t* cli, uint16_t method, size_t len) {
+    ipc_rpc_hdr_t hdr = {0};
+
+    if (cli == NULL || cli->req != NULL || len > IPC_RPC_MAX_LEN || prv_free_call(cli) == NULL) {
+        return NULL;
+    }
+    cli->req = ringbuff_msg_send_reserve(cli->tx, sizeof(hdr) + len);
+    cli->staged = 0;
+    if (cli->req == NULL) {
+        if (ringbuff_get_free(cli->tx) < sizeof(ringbuff_msg_hdr_t) + sizeof(hdr) + len) {
+            return NULL;
+        }
+        cli->req = cli->stage;                  /* Message would wrap, use stage memory */
+        cli->staged = 1;
+    }
+    cli->req_len = len;
+    hdr.method = method;
+    memcpy(cli->req, &hdr, sizeof(hdr));
+    return cli->req + sizeof(hdr);
+}
+
+/**
+ * \brief           Send request reserved with \ref ipc_rpc_call_reserve
+ * \param[in]       cli: Client handle
+ * \param[in]       len: Length of arguments in units of bytes, up to reserved length
+ * \param[in]       timeout_us: Response timeout in units of microseconds
+ * \param[in]       fn: Completion callback, called from \ref ipc_rpc_client_poll. Can be set to `NULL`
+ * \param[in]       arg: User argument of callback
+ * \return          Correlation ID of call, `0` on failure
+ */
+uint32_t
+ipc_rpc_call_commit(ipc_rpc_client_t* cli, size_t len, uint32_t timeout_us, ipc_rpc_done_fn fn, void* arg) {
+    ipc_rpc_call_t* call;
+    uint32_t corr;
+    uint8_t ok;
+
+    if (cli == NULL || cli->req == NULL) {
+        return 0;
+    }
+    if (len > cli->req_len || (call = prv_free_call(cli)) == NULL) {
+        cli->req = NULL;
+        return 0;
+    }
+
+    corr = cli->next_corr++;
+    if (cli->next_corr == 0) {
+        cli->next_corr = 1;
+    }
+    memcpy(cli->req, &corr, sizeof(corr));      /* Correlation ID is first header field */
+    if (cli->staged) {
+        ok = ringbuff_msg_send(cli->tx, cli->req, sizeof(ipc_rpc_hdr_t) + len) > 0;
+    } else {
+        ok = ringbuff_msg_send_commit(cli->tx, sizeof(ipc_rpc_hdr_t) + len) > 0;
+    }
+    cli->req = NULL;
+    if (!ok) {
+        return 0;
+    }
+
+    call->corr = corr;
+    call->fn = fn;
+    call->arg = arg;
+    call->start = CYCCNT_GET();
+    call->timeout = timeout_us * CYCCNT_PER_US();
+    ipc_notify(cli->sem_id);
+    return corr;
+}
+
+/**
+ * \brief           Result of synchronous call
+ */
+typedef struct {
+    void* res;                                  /*!< Memory for result */
+    size_t size;                                /*!< Size of result memory */
+    size_t len;                                 /*!< Result length */
+    int32_t status;                             /*!< Call status */
+    uint8_t done;                               /*!< Set to `1` when call completed */
+} prv_sync_t;
+
+/**
+ * \brief           Completion callback of synchronous call
+ */
+static void
+prv_sync_done(int32_t status, const void* res, size_t len, void* arg) {
+    prv_sync_t* sync = arg;
+
+    sync->status = status;
+    sync->len = len;
+    if (res != NULL && sync->res != NULL) {
+        memcpy(sync->res, res, len < sync->size ? len : sync->size);
+    }
+    sync->done = 1;
+}
+
+/**
+ * \brief           Call method and wait for its result.
+ *                  Responses of other calls received meanwhile are completed as well
+ * \param[in]       cli: Client handle
+ * \param[in]       method: Method ID
+ * \param[in]       args: Call arguments, can be `NULL` when `len == 0`
+ * \param[in]       len: Length of arguments in units of bytes, up to \ref IPC_RPC_MAX_LEN
+ * \param[out]      res: Memory to copy result to, can be `NULL`
+ * \param[in]       size: Size of `res` memory in units of bytes, longer result is truncated
+ * \param[out]      res_len: Output variable to write result length to, can be `NULL`
+ * \param[in]       timeout_us: Response timeout in units of microseconds
+ * \return          Call status, \ref ipc_rpc_status_t or method specific value
+ */
+int32_t
+ipc_rpc_call(ipc_rpc_client_t* cli, uint16_t method, const void* args, size_t len,
+                void* res, size_t size, size_t* res_len, uint32_t timeout_us) {
+    prv_sync_t sync = { res, size, 0, IPC_RPC_ERR_BUSY, 0 };
+    void* p;
+
+    if ((p = ipc_rpc_call_reserve(cli, method, len)) == NULL) {
+        return IPC_RPC_ERR_BUSY;
+    }
+    if (len > 0) {
+        memcpy(p, args, len);
+    }
+    if (ipc_rpc_call_commit(cli, len, timeout_us, prv_sync_done, &sync) == 0) {
+        return IPC_RPC_ERR_BUSY;
+    }
+    while (!sync.done) {
+        ipc_rpc_client_poll(cli);
+    }
+    if (res_len != NULL) {
+        *res_len = sync.len;
+    }
+    return sync.status;
+}
+
+/**
+ * \brief           Complete call with response message.
+ *                  Response without call in flight, for example after timeout, is ignored
+ * \param[in]       cli: Client handle
+ * \param[in]       msg: Response message
+ * \param[in]       len: Response message length in units of bytes
+ */
+void
+ipc_rpc_client_input(ipc_rpc_client_t* cli, const void* msg, size_t len) {
+    ipc_rpc_hdr_t hdr;
+    ipc_rpc_done_fn fn;
+    void* arg;
+
+    if (cli == NULL || msg == NULL || len < sizeof(hdr)) {
+        return;
+    }
+    memcpy(&hdr, msg, sizeof(hdr));
+    for (size_t i = 0; i < IPC_RPC_PENDING; ++i) {
+        if (hdr.corr != 0 && cli->calls[i].corr == hdr.corr) {
+            fn = cli->calls[i].fn;
+            arg = cli->calls[i].arg;
+            cli->calls[i].corr = 0;             /* Slot is free before callback, it may start new call */
+            if (fn != NULL) {
+                fn(hdr.status, (const uint8_t *)msg + sizeof(hdr), len - sizeof(hdr), arg);
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * \brief           Receive responses and expire calls without response.
+ *                  Call from main loop of client core, when response doorbell was rung
+ *                  or periodically while calls are in flight
+ * \param[in]       cli: Client handle
+ */
+void
+ipc_rpc_client_poll(ipc_rpc_client_t* cli) {
+    uint8_t msg[sizeof(ipc_rpc_hdr_t) + IPC_RPC_MAX_LEN];
+    ipc_rpc_done_fn fn;
+    void* arg;
+    size_t len;
+
+    if (cli == NULL) {
+        return;
+    }
+    while ((len = ipc_lane_ctrl_recv(cli->rx, msg, sizeof(msg))) > 0) {
+        if (len <= sizeof(msg)) {
+            ipc_rpc_client_input(cli, msg, len);
+        }
+    }
+    for (size_t i = 0; i < IPC_RPC_PENDING; ++i) {
+        if (cli->calls[i].corr != 0
+            && (CYCCNT_GET() - cli->calls[i].start) >= cli->calls[i].timeout) {
+            fn = cli->calls[i].fn;
+            arg = cli->calls[i].arg;
+            cli->calls[i].corr = 0;
+            if (fn != NULL) {
+                fn(IPC_RPC_ERR_TIMEOUT, NULL, 0, arg);
+            }
+        }
+    }
+}
@@ -0,0 +1,516 @@
+/**
+ * \file            ipc_rpmsg.c
+ * \brief           RPMsg endpoint API on channels
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_rpmsg.h"
+#include "ipc_notify.h"
+#include "ipc_wait.h"
+
+#if IPC_RPMSG
+
+/*
+ * Each core has one device on pair of message channels, RPMSG_CM7_TO_CM4 and RPMSG_CM4_TO_CM7.
+ * Every RPMsg message is one ring buffer message, address header followed by payload,
+ * doorbell of channel is rung after every send as virtio kick of OpenAMP.
+ *
+ * Compared to OpenAMP virtio path, there are no descriptor, available and used rings,
+ * no buffer ownership round trip and payload is not limited to fixed buffers:
+ * message takes only its own length of channel memory.
+ * Payload is written in place with ring buffer reservation and delivered in place,
+ * with one copy to core-local memory only when message wraps at end of channel.
+ *
+ * Messages are consumed in order. Held receive buffer stops delivery of later messages
+ * of the device until it is released, only one zero-copy transmit buffer can be taken at a time.
+ *
+ * Name service follows OpenAMP: endpoint created with name is announced to address
+ * RPMSG_NS_EPT_ADDR, and local endpoint with same name and RPMSG_ADDR_ANY destination is bound to it
+ */
+
+/* Name service flags */
+#define IPC_RPMSG_NS_CREATE                 0
+#define IPC_RPMSG_NS_DESTROY                1
+
+/**
+ * \brief           Address header in front of every payload
+ */
+typedef struct {
+    uint32_t src;                               /*!< Address of sending endpoint */
+    uint32_t dst;                               /*!< Address of receiving endpoint */
+} ipc_rpmsg_hdr_t;
+
+/**
+ * \brief           Name service announcement, as OpenAMP `struct rpmsg_ns_msg`
+ */
+typedef struct {
+    char name[RPMSG_NAME_SIZE];                 /*!< Endpoint name */
+    uint32_t addr;                              /*!< Endpoint address */
+    uint32_t flags;                             /*!< \ref IPC_RPMSG_NS_CREATE or \ref IPC_RPMSG_NS_DESTROY */
+} ipc_rpmsg_ns_msg_t;
+
+/* Channel memory of message with maximum payload, including ring buffer message header */
+#define IPC_RPMSG_MSG_LEN                   (sizeof(ringbuff_msg_hdr_t) + sizeof(ipc_rpmsg_hdr_t) + RPMSG_BUFFER_PAYLOAD)
+
+_Static_assert(sizeof(((struct rpmsg_device *)0)->tx_stage) >= sizeof(ipc_rpmsg_hdr_t) + RPMSG_BUFFER_PAYLOAD, "Stage memory is too short");
+
+/**
+ * \brief           Find endpoint by local address
+ * \param[in]       rdev: Device
+ * \param[in]       addr: Local address
+ * \return          Endpoint, `NULL` if not created
+ */
+static struct rpmsg_endpoint *
+prv_ept_find(struct rpmsg_device* rdev, uint32_t addr) {
+    for (struct rpmsg_endpoint* ept = rdev->epts; ept != NULL; ept = ept->next) {
+        if (ept->addr == addr) {
+            return ept;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Announce endpoint to other core
+ * \param[in]       ept: Endpoint with name
+ * \param[in]       flags: \ref IPC_RPMSG_NS_CREATE or \ref IPC_RPMSG_NS_DESTROY
+ * \return          \ref RPMSG_SUCCESS or negative error code
+ */
+static int
+prv_ns_announce(struct rpmsg_endpoint* ept, uint32_t flags) {
+    ipc_rpmsg_ns_msg_t ns = {0};
+    int res;
+
+    strncpy(ns.name, ept->name, sizeof(ns.name) - 1);
+    ns.addr = ept->addr;
+    ns.flags = flags;
+    res = rpmsg_send_offchannel_raw(ept, ept->addr, RPMSG_NS_EPT_ADDR, &ns, sizeof(ns), 1);
+    return res < 0 ? res : RPMSG_SUCCESS;
+}
+
+/**
+ * \brief           Process name service announcement of other core
+ * \param[in]       rdev: Device
+ * \param[in]       data: Announcement, not aligned
+ * \param[in]       len: Announcement length in units of bytes
+ */
+static void
+prv_ns_process(struct rpmsg_device* rdev, const void* data, size_t len) {
+    ipc_rpmsg_ns_msg_t ns;
+
+    if (len != sizeof(ns)) {
+        return;
+    }
+    memcpy(&ns, data, sizeof(ns));
+    ns.name[sizeof(ns.name) - 1] = '\0';
+    for (struct rpmsg_endpoint* ept = rdev->epts; ept != NULL; ept = ept->next) {
+        if (strncmp(ept->name, ns.name, sizeof(ns.name)) != 0) {
+            continue;
+        }
+        if (ns.flags == IPC_RPMSG_NS_CREATE && ept->dest_addr == RPMSG_ADDR_ANY) {
+            ept->dest_addr = ns.addr;
+            return;
+        }
+        if (ns.flags == IPC_RPMSG_NS_DESTROY && ept->dest_addr == ns.addr) {
+            ept->dest_addr = RPMSG_ADDR_ANY;
+            if (ept->ns_unbind_cb != NULL) {
+                ept->ns_unbind_cb(ept);
+            }
+            return;
+        }
+    }
+    if (ns.flags == IPC_RPMSG_NS_CREATE && rdev->ns_bind_cb != NULL) {
+        rdev->ns_bind_cb(rdev, ns.name, ns.addr);
+    }
+}
+
+/**
+ * \brief           Finish send of message written to transmit memory
+ * \param[in]       rdev: Device
+ */
+static void
+prv_sent(struct rpmsg_device* rdev) {
+    ++rdev->stats.sent;
+    ipc_notify(rdev->sem_id);
+}
+
+/**
+ * \brief           Initialize device on pair of channels
+ * \param[in]       rdev: Device
+ * \param[in]       tx: Channel to other core, producer side
+ * \param[in]       rx: Channel from other core, consumer side
+ * \param[in]       sem_id: Doorbell of channel to other core
+ * \param[in]       ns_bind_cb: Callback for announcements without local endpoint, can be `NULL`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_rpmsg_init(struct rpmsg_device* rdev, RINGBUFF_VOLATILE ringbuff_t* tx, RINGBUFF_VOLATILE ringbuff_t* rx,
+                uint32_t sem_id, rpmsg_ns_bind_cb ns_bind_cb) {
+    if (rdev == NULL || tx == NULL || rx == NULL) {
+        return 0;
+    }
+    memset(rdev, 0x00, sizeof(*rdev));
+    rdev->tx = tx;
+    rdev->rx = rx;
+    rdev->sem_id = sem_id;
+    rdev->next_addr = RPMSG_RESERVED_ADDRESSES;
+    rdev->ns_bind_cb = ns_bind_cb;
+    CYCCNT_INIT();                              /* Send timeout time base */
+    return 1;
+}
+
+/**
+ * \brief           Deliver received messages to endpoints.
+ *                  Call from application loop after doorbell of channel from other core
+ * \param[in]       rdev: Device
+ * \return          Number of processed messages
+ */
+size_t
+ipc_rpmsg_poll(struct rpmsg_device* rdev) {
+    struct rpmsg_endpoint* ept;
+    void *addr1, *addr2;
+    size_t len, len1, len2, n = 0;
+    ipc_rpmsg_hdr_t hdr;
+    uint8_t* msg;
+
+    if (rdev == NULL) {
+        return 0;
+    }
+    while (!rdev->rx_held && (len = ringbuff_msg_recv_acquire(rdev->rx, &addr1, &len1, &addr2, &len2)) > 0) {
+        ++n;
+        if (len < sizeof(hdr) || len > sizeof(hdr) + RPMSG_BUFFER_PAYLOAD) {
+            ++rdev->stats.dropped;
+            ringbuff_msg_recv_release(rdev->rx);
+            continue;
+        }
+
+        /* Payload is delivered in place, unless message wraps at end of channel */
+        msg = addr1;
+        if (len2 > 0) {
+            memcpy(rdev->rx_stage, addr1, len1);
+            memcpy((uint8_t *)rdev->rx_stage + len1, addr2, len2);
+            msg = (uint8_t *)rdev->rx_stage;
+            ++rdev->stats.rx_copies;
+        }
+        memcpy(&hdr, msg, sizeof(hdr));
+        if (hdr.dst == RPMSG_NS_EPT_ADDR) {
+            prv_ns_process(rdev, msg + sizeof(hdr), len - sizeof(hdr));
+        } else if ((ept = prv_ept_find(rdev, hdr.dst)) != NULL && ept->cb != NULL) {
+            ++rdev->stats.received;
+            ept->cb(ept, msg + sizeof(hdr), len - sizeof(hdr), hdr.src, ept->priv);
+        } else {
+            ++rdev->stats.dropped;
+        }
+
+        /* Held message stays in channel until rpmsg_release_rx_buffer */
+        if (!rdev->rx_held) {
+            ringbuff_msg_recv_release(rdev->rx);
+        }
+    }
+    return n;
+}
+
+/**
+ * \brief           Get device statistics
+ * \param[in]       rdev: Device
+ * \param[out]      stats: Statistics
+ */
+void
+ipc_rpmsg_get_stats(struct rpmsg_device* rdev, ipc_rpmsg_stats_t* stats) {
+    if (rdev != NULL && stats != NULL) {
+        *stats = rdev->stats;
+    }
+}
+
+/**
+ * \brief           Create endpoint, announce it when it has name
+ * \param[out]      ept: Endpoint, must stay valid until \ref rpmsg_destroy_ept
+ * \param[in]       rdev: Device
+ * \param[in]       name: Endpoint name, can be `NULL` or empty for endpoint that is not announced
+ * \param[in]       src: Local address, \ref RPMSG_ADDR_ANY for dynamic address
+ * \param[in]       dest: Remote address, \ref RPMSG_ADDR_ANY to bind with name service
+ * \param[in]       cb: Receive callback
+ * \param[in]       ns_unbind_cb: Remote endpoint destroyed callback, can be `NULL`
+ * \return          \ref RPMSG_SUCCESS on success, negative error code otherwise
+ */
+int
+rpmsg_create_ept(struct rpmsg_endpoint* ept, struct rpmsg_device* rdev, const char* name,
+                    uint32_t src, uint32_t dest, rpmsg_ept_cb cb, rpmsg_ns_unbind_cb ns_unbind_cb) {
+    if (ept == NULL || rdev == NULL || cb == NULL) {
+        return RPMSG_ERR_PARAM;
+    }
+    if (src == RPMSG_ADDR_ANY) {
+        while (prv_ept_find(rdev, rdev->next_addr) != NULL) {
+            ++rdev->next_addr;
+        }
+        src = rdev->next_addr++;
+    } else if (src == RPMSG_NS_EPT_ADDR || prv_ept_find(rdev, src) != NULL) {
+        return RPMSG_ERR_ADDR;
+    }
+
+    memset(ept, 0x00, sizeof(*ept));
+    if (name != NULL) {
+        strncpy(ept->name, name, sizeof(ept->name) - 1);
+    }
+    ept->rdev = rdev;
+    ept->addr = src;
+    ept->dest_addr = dest;
+    ept->cb = cb;
+    ept->ns_unbind_cb = ns_unbind_cb;
+    ept->next = rdev->epts;
+    rdev->epts = ept;
+    if (ept->name[0] != '\0') {
+        return prv_ns_announce(ept, IPC_RPMSG_NS_CREATE);
+    }
+    return RPMSG_SUCCESS;
+}
+
+/**
+ * \brief           Destroy endpoint, announce it when it has name
+ * \param[in]       ept: Endpoint created with \ref rpmsg_create_ept
+ */
+void
+rpmsg_destroy_ept(struct rpmsg_endpoint* ept) {
+    struct rpmsg_device* rdev;
+
+    if (ept == NULL || (rdev = ept->rdev) == NULL) {
+        return;
+    }
+    if (ept->name[0] != '\0') {
+        prv_ns_announce(ept, IPC_RPMSG_NS_DESTROY);
+    }
+    for (struct rpmsg_endpoint** p = &rdev->epts; *p != NULL; p = &(*p)->next) {
+        if (*p == ept) {
+            *p = ept->next;
+            break;
+        }
+    }
+    ept->rdev = NULL;
+}
+
+/**
+ * \brief           Send message, payload is copied to channel
+ * \param[in]       ept: Endpoint
+ * \param[in]       src: Source address
+ * \param[in]       dst: Remote address
+ * \param[in]       data: Payload
+ * \param[in]       len: Payload length, up to \ref RPMSG_BUFFER_PAYLOAD bytes
+ * \param[in]       wait: Set to `1` to wait up to \ref IPC_RPMSG_SEND_TIMEOUT_US for channel memory
+ * \return          Number of sent bytes, \ref RPMSG_ERR_NO_BUFF when channel is full,
+ *                      \ref RPMSG_ERR_DEV_STATE while zero-copy transmit buffer is taken,
+ *                      other negative error code otherwise
+ */
+int
+rpmsg_send_offchannel_raw(struct rpmsg_endpoint* ept, uint32_t src, uint32_t dst,
+                            const void* data, int len, int wait) {
+    struct rpmsg_device* rdev;
+    ipc_rpmsg_hdr_t hdr;
+    ipc_wait_t w;
+    uint8_t* out;
+
+    if (ept == NULL || (rdev = ept->rdev) == NULL || len < 0 || (data == NULL && len > 0)) {
+        return RPMSG_ERR_PARAM;
+    }
+    if (len > RPMSG_BUFFER_PAYLOAD) {
+        return RPMSG_ERR_BUFF_SIZE;
+    }
+    if (src == RPMSG_ADDR_ANY || dst == RPMSG_ADDR_ANY) {
+        return RPMSG_ERR_ADDR;
+    }
+    if (rdev->tx_buf != NULL) {
+        return RPMSG_ERR_DEV_STATE;             /* Would overwrite reserved payload */
+    }
+
+    hdr.src = src;
+    hdr.dst = dst;
+    ipc_wait_start(&w, IPC_RPMSG_SEND_TIMEOUT_US);
+    while (1) {
+        /* Payload is written in place when linear memory is available */
+        if ((out = ringbuff_msg_send_reserve(rdev->tx, sizeof(hdr) + len)) != NULL) {
+            memcpy(out, &hdr, sizeof(hdr));
+            if (len > 0) {
+                memcpy(out + sizeof(hdr), data, len);
+            }
+            ringbuff_msg_send_commit(rdev->tx, sizeof(hdr) + len);
+            break;
+        }
+        if (ringbuff_get_free(rdev->tx) >= sizeof(ringbuff_msg_hdr_t) + sizeof(hdr) + len) {
+            out = (uint8_t *)rdev->tx_stage;
+            memcpy(out, &hdr, sizeof(hdr));
+            if (len > 0) {
+                memcpy(out + sizeof(hdr), data, len);
+            }
+            ringbuff_msg_send(rdev->tx, out, sizeof(hdr) + len);
+            ++rdev->stats.tx_copies;
+            break;
+        }
+        if (!wait || ipc_wait_expired(&w)) {
+            return RPMSG_ERR_NO_BUFF;
+        }
+    }
+    prv_sent(rdev);
+    return len;
+}
+
+/**
+ * \brief           Get maximum payload length of one message
+ * \param[in]       ept: Endpoint
+ * \return          \ref RPMSG_BUFFER_PAYLOAD, negative error code otherwise
+ */
+int
+rpmsg_get_tx_buffer_size(struct rpmsg_endpoint* ept) {
+    if (ept == NULL || ept->rdev == NULL) {
+        return RPMSG_ERR_PARAM;
+    }
+    return RPMSG_BUFFER_PAYLOAD;
+}
+
+/**
+ * \brief           Take payload buffer for zero-copy send with \ref rpmsg_send_nocopy.
+ *
+ * Buffer is in channel memory, in core-local memory when message would wrap at end of channel.
+ * Channel memory for message with maximum payload is available once function returns,
+ * following send does not fail for lack of memory
+ *
+ * \param[in]       ept: Endpoint
+ * \param[out]      len: Output variable to write buffer length to, \ref RPMSG_BUFFER_PAYLOAD
+ * \param[in]       wait: Set to `1` to wait up to \ref IPC_RPMSG_SEND_TIMEOUT_US for channel memory
+ * \return          Payload buffer, not aligned, `NULL` when channel is full or buffer is already taken
+ */
+void *
+rpmsg_get_tx_payload_buffer(struct rpmsg_endpoint* ept, uint32_t* len, int wait) {
+    struct rpmsg_device* rdev;
+    ipc_wait_t w;
+
+    if (ept == NULL || (rdev = ept->rdev) == NULL || len == NULL || rdev->tx_buf != NULL) {
+        return NULL;
+    }
+    ipc_wait_start(&w, IPC_RPMSG_SEND_TIMEOUT_US);
+    while (ringbuff_get_free(rdev->tx) < IPC_RPMSG_MSG_LEN) {
+        if (!wait || ipc_wait_expired(&w)) {
+            return NULL;
+        }
+    }
+    rdev->tx_buf = ringbuff_msg_send_reserve(rdev->tx, sizeof(ipc_rpmsg_hdr_t) + RPMSG_BUFFER_PAYLOAD);
+    if (rdev->tx_buf == NULL) {
+        rdev->tx_buf = (uint8_t *)rdev->tx_stage;
+    }
+    *len = RPMSG_BUFFER_PAYLOAD;
+    return rdev->tx_buf + sizeof(ipc_rpmsg_hdr_t);
+}
+
+/**
+ * \brief           Send payload buffer taken with \ref rpmsg_get_tx_payload_buffer
+ * \param[in]       ept: Endpoint
+ * \param[in]       src: Source address
+ * \param[in]       dst: Remote address
+ * \param[in]       data: Payload buffer
+ * \param[in]       len: Payload length, up to \ref RPMSG_BUFFER_PAYLOAD bytes
+ * \return          Number of sent bytes, negative error code otherwise. Buffer is returned on success only
+ */
+int
+rpmsg_send_offchannel_nocopy(struct rpmsg_endpoint* ept, uint32_t src, uint32_t dst, const void* data, int len) {
+    struct rpmsg_device* rdev;
+    ipc_rpmsg_hdr_t hdr;
+
+    if (ept == NULL || (rdev = ept->rdev) == NULL || rdev->tx_buf == NULL
+        || data != rdev->tx_buf + sizeof(hdr) || len < 0) {
+        return RPMSG_ERR_PARAM;
+    }
+    if (len > RPMSG_BUFFER_PAYLOAD) {
+        return RPMSG_ERR_BUFF_SIZE;
+    }
+    if (src == RPMSG_ADDR_ANY || dst == RPMSG_ADDR_ANY) {
+        return RPMSG_ERR_ADDR;
+    }
+
+    /* Memory was checked when buffer was taken, send does not fail */
+    hdr.src = src;
+    hdr.dst = dst;
+    memcpy(rdev->tx_buf, &hdr, sizeof(hdr));
+    if (rdev->tx_buf == (uint8_t *)rdev->tx_stage) {
+        ringbuff_msg_send(rdev->tx, rdev->tx_buf, sizeof(hdr) + len);
+        ++rdev->stats.tx_copies;
+    } else {
+        ringbuff_msg_send_commit(rdev->tx, sizeof(hdr) + len);
+    }
+    rdev->tx_buf = NULL;
+    prv_sent(rdev);
+    return len;
+}
+
+/**
+ * \brief           Return payload buffer taken with \ref rpmsg_get_tx_payload_buffer without sending it
+ * \param[in]       ept: Endpoint
+ * \param[in]       txbuf: Payload buffer
+ * \return          \ref RPMSG_SUCCESS on success, negative error code otherwise
+ */
+int
+rpmsg_release_tx_buffer(struct rpmsg_endpoint* ept, void* txbuf) {
+    struct rpmsg_device* rdev;
+
+    if (ept == NULL || (rdev = ept->rdev) == NULL || rdev->tx_buf == NULL
+        || txbuf != rdev->tx_buf + sizeof(ipc_rpmsg_hdr_t)) {
+        return RPMSG_ERR_PARAM;
+    }
+    rdev->tx_buf = NULL;
+    return RPMSG_SUCCESS;
+}
+
+/**
+ * \brief           Keep received payload after receive callback returns.
+ *                  Call from receive callback, later messages are delivered after \ref rpmsg_release_rx_buffer
+ * \param[in]       ept: Endpoint
+ * \param[in]       rxbuf: Payload given to receive callback
+ */
+void
+rpmsg_hold_rx_buffer(struct rpmsg_endpoint* ept, void* rxbuf) {
+    (void)rxbuf;
+    if (ept != NULL && ept->rdev != NULL) {
+        ept->rdev->rx_held = 1;
+    }
+}
+
+/**
+ * \brief           Release payload held with \ref rpmsg_hold_rx_buffer, message is removed from channel.
+ *                  Call \ref ipc_rpmsg_poll afterwards to deliver later messages
+ * \param[in]       ept: Endpoint
+ * \param[in]       rxbuf: Held payload
+ */
+void
+rpmsg_release_rx_buffer(struct rpmsg_endpoint* ept, void* rxbuf) {
+    (void)rxbuf;
+    if (ept != NULL && ept->rdev != NULL && ept->rdev->rx_held) {
+        ept->rdev->rx_held = 0;
+        ringbuff_msg_recv_release(ept->rdev->rx);
+    }
+}
+
+#endif /* IPC_RPMSG */
@@ -0,0 +1,138 @@
+/**
+ * \file            ipc_scan.c
+ * \brief           Background integrity scan of shared channels
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_scan.h"
+#include "ipc_chan.h"
+
+#if IPC_SCAN
+
+/* Items in scan order, directory and layout hash first, then channels by ID */
+#define IPC_SCAN_ITEMS                      (1 + IPC_CHAN_COUNT)
+
+_Static_assert(IPC_SCAN_ITEMS <= 32, "Item state must fit to 32-bit mask");
+
+static ipc_scan_alarm_fn scan_alarm_fn;
+static ipc_scan_stats_t scan_stats;
+static uint32_t scan_hash;                      /* Layout hash of this image */
+static uint32_t scan_bad;                       /* Bit per item with raised alarm, cleared when item is good again */
+static size_t scan_next;                        /* Next item to check */
+
+/**
+ * \brief           Check channel directory header and boot record layout hash
+ * \return          \ref IPC_SCAN_OK when intact, error otherwise
+ */
+static ipc_scan_err_t
+prv_check_dir(void) {
+    volatile ipc_chan_dir_t* dir = &IPC_SHM->ctrl.dir;
+    volatile ipc_boot_shared_t* boot = &IPC_SHM->ctrl.boot;
+
+    if (dir->magic != IPC_CHAN_DIR_MAGIC || dir->layout_len != sizeof(ipc_shm_t)) {
+        return IPC_SCAN_ERR_DIR;
+    }
+    if (boot->magic != IPC_BOOT_MAGIC || boot->layout_hash != scan_hash) {
+        return IPC_SCAN_ERR_LAYOUT;
+    }
+    return IPC_SCAN_OK;
+}
+
+/**
+ * \brief           Initialize background scan, after channels were created or opened.
+ *
+ * Scan replaces per-call magic validation of ring buffer functions
+ * (build with `RINGBUFF_USE_MAGIC_CHECK=0`) by periodic check of all channels used by this core:
+ * directory header, layout hash of boot record, directory entries against layout,
+ * magic words and geometry of local handles and read and write pointer ranges
+ *
+ * \param[in]       alarm_fn: Corruption alarm callback, may be `NULL`
+ */
+void
+ipc_scan_init(ipc_scan_alarm_fn alarm_fn) {
+    memset(&scan_stats, 0x00, sizeof(scan_stats));
+    scan_alarm_fn = alarm_fn;
+    scan_hash = ipc_chan_layout_hash();
+    scan_bad = 0;
+    scan_next = 0;
+}
+
+/**
+ * \brief           Check next items, from low priority periodic task or timer.
+ *                  Each item is directory or one channel, all items are checked in
+ *                  \ref IPC_CHAN_COUNT `+ 1` steps
+ * \param[in]       steps: Number of items to check
+ * \return          Number of corrupted items found
+ */
+size_t
+ipc_scan_run(size_t steps) {
+    ipc_scan_err_t err;
+    uint32_t id, bit;
+    size_t found = 0;
+
+    for (; steps > 0; --steps) {
+        id = scan_next == 0 ? IPC_SCAN_ID_DIR : (uint32_t)(scan_next - 1);
+        err = scan_next == 0 ? prv_check_dir() : ipc_chan_check(id);
+        bit = 1UL << scan_next;
+
+        ++scan_stats.checks;
+        if (err != IPC_SCAN_OK) {
+            ++found;
+            ++scan_stats.errors;
+            scan_stats.last_id = id;
+            scan_stats.last_err = err;
+            if (!(scan_bad & bit)) {
+                scan_bad |= bit;
+                ++scan_stats.alarms;
+                if (scan_alarm_fn != NULL) {
+                    scan_alarm_fn(id, err);
+                }
+            }
+        } else {
+            scan_bad &= ~bit;
+        }
+        if (++scan_next == IPC_SCAN_ITEMS) {
+            scan_next = 0;
+            ++scan_stats.passes;
+        }
+    }
+    return found;
+}
+
+/**
+ * \brief           Get scan statistics of this core
+ * \param[out]      stats: Output statistics
+ */
+void
+ipc_scan_get_stats(ipc_scan_stats_t* stats) {
+    *stats = scan_stats;
+}
+
+#endif /* IPC_SCAN */
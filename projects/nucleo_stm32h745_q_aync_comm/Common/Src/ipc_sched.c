@@ -0,0 +1,260 @@
+/**
+ * \file            ipc_sched.c
+ * \brief           Cooperative scheduler with timer wheel
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_sched.h"
+
+#if IPC_SCHED
+
+/*
+ * Timers are kept in wheel of IPC_SCHED_WHEEL_LEN slots, slot index is expiry tick modulo wheel length.
+ * SysTick visits only slot of current tick, timers expiring in later rounds stay in slot.
+ * Expired timer posts its task to ready queue, FIFO list served by ipc_sched_run.
+ *
+ * Wheel and ready queue are modified from SysTick, other interrupts and thread mode,
+ * all modifications are short critical sections with interrupts disabled
+ */
+
+_Static_assert((IPC_SCHED_WHEEL_LEN & (IPC_SCHED_WHEEL_LEN - 1)) == 0, "Wheel length must be power of 2");
+
+static ipc_sched_task_t* wheel[IPC_SCHED_WHEEL_LEN];
+static ipc_sched_task_t* ready_head;
+static ipc_sched_task_t* ready_tail;
+static volatile uint32_t now;                   /* Ticks since start */
+static size_t armed_cnt;                        /* Number of timers in wheel */
+
+/* Critical section against interrupts of this core */
+#define IPC_SCHED_LOCK(p)                   do { (p) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define IPC_SCHED_UNLOCK(p)                 __set_PRIMASK(p)
+
+/**
+ * \brief           Add task to ready queue, interrupts disabled
+ * \param[in]       t: Task
+ */
+static void
+prv_ready(ipc_sched_task_t* t) {
+    if (t->ready) {
+        return;                                 /* Posted already, runs once */
+    }
+    t->ready = 1;
+    t->next_ready = NULL;
+    if (ready_tail != NULL) {
+        ready_tail->next_ready = t;
+    } else {
+        ready_head = t;
+    }
+    ready_tail = t;
+}
+
+/**
+ * \brief           Insert timer to wheel slot of its expiry, interrupts disabled
+ * \param[in]       t: Task
+ */
+static void
+prv_insert(ipc_sched_task_t* t) {
+    ipc_sched_task_t** slot = &wheel[t->expires & (IPC_SCHED_WHEEL_LEN - 1)];
+
+    t->next_timer = *slot;
+    *slot = t;
+    t->armed = 1;
+    ++armed_cnt;
+}
+
+/**
+ * \brief           Remove timer from its wheel slot, interrupts disabled
+ * \param[in]       t: Task
+ */
+static void
+prv_remove(ipc_sched_task_t* t) {
+    ipc_sched_task_t** p = &wheel[t->expires & (IPC_SCHED_WHEEL_LEN - 1)];
+
+    while (*p != NULL && *p != t) {
+        p = &(*p)->next_timer;
+    }
+    if (*p != NULL) {
+        *p = t->next_timer;
+    }
+    t->armed = 0;
+    --armed_cnt;
+}
+
+/**
+ * \brief           Initialize task, it is neither ready nor timed
+ * \param[in]       t: Task
+ * \param[in]       fn: Task function
+ * \param[in]       arg: User argument
+ */
+void
+ipc_sched_task_init(ipc_sched_task_t* t, ipc_sched_fn fn, void* arg) {
+    t->next_ready = NULL;
+    t->next_timer = NULL;
+    t->fn = fn;
+    t->arg = arg;
+    t->expires = 0;
+    t->period = 0;
+    t->ready = 0;
+    t->armed = 0;
+}
+
+/**
+ * \brief           Make task ready, for example from doorbell callback in HSEM interrupt.
+ *                  Task posted several times before it runs, runs once
+ * \param[in]       t: Task
+ */
+void
+ipc_sched_post(ipc_sched_task_t* t) {
+    uint32_t primask;
+
+    IPC_SCHED_LOCK(primask);
+    prv_ready(t);
+    IPC_SCHED_UNLOCK(primask);
+}
+
+/**
+ * \brief           Start or restart task timer
+ * \param[in]       t: Task
+ * \param[in]       delay: Ticks to first expiry, at least `1`
+ * \param[in]       period: Ticks between following expiries, `0` for one-shot timer
+ */
+void
+ipc_sched_timer_start(ipc_sched_task_t* t, uint32_t delay, uint32_t period) {
+    uint32_t primask;
+
+    IPC_SCHED_LOCK(primask);
+    if (t->armed) {
+        prv_remove(t);
+    }
+    t->expires = now + (delay > 0 ? delay : 1);
+    t->period = period;
+    prv_insert(t);
+    IPC_SCHED_UNLOCK(primask);
+}
+
+/**
+ * \brief           Stop task timer, task already posted by timer still runs
+ * \param[in]       t: Task
+ */
+void
+ipc_sched_timer_stop(ipc_sched_task_t* t) {
+    uint32_t primask;
+
+    IPC_SCHED_LOCK(primask);
+    if (t->armed) {
+        prv_remove(t);
+    }
+    IPC_SCHED_UNLOCK(primask);
+}
+
+/**
+ * \brief           Advance timer wheel by one tick, called from SysTick interrupt
+ */
+void
+ipc_sched_tick(void) {
+    ipc_sched_task_t **p, *t;
+    uint32_t primask;
+
+    IPC_SCHED_LOCK(primask);
+    now = now + 1;
+    p = &wheel[now & (IPC_SCHED_WHEEL_LEN - 1)];
+    while ((t = *p) != NULL) {
+        if (t->expires != now) {
+            p = &t->next_timer;                 /* Later round */
+            continue;
+        }
+        *p = t->next_timer;
+        t->armed = 0;
+        --armed_cnt;
+        prv_ready(t);
+        if (t->period > 0) {
+            t->expires = now + t->period;
+            if ((t->expires & (IPC_SCHED_WHEEL_LEN - 1)) == (now & (IPC_SCHED_WHEEL_LEN - 1))) {
+                t->next_timer = *p;             /* Same slot, keep after current position */
+                *p = t;
+                t->armed = 1;
+                ++armed_cnt;
+                p = &t->next_timer;
+            } else {
+                prv_insert(t);
+            }
+        }
+    }
+    IPC_SCHED_UNLOCK(primask);
+}
+
+/**
+ * \brief           Run all ready tasks, in order they became ready.
+ *                  Tasks posted while running are served in the same call
+ * \return          Number of tasks run
+ */
+size_t
+ipc_sched_run(void) {
+    ipc_sched_task_t* t;
+    uint32_t primask;
+    size_t n = 0;
+
+    while (1) {
+        IPC_SCHED_LOCK(primask);
+        if ((t = ready_head) != NULL) {
+            ready_head = t->next_ready;
+            if (ready_head == NULL) {
+                ready_tail = NULL;
+            }
+            t->ready = 0;                       /* Task may be posted again while it runs */
+        }
+        IPC_SCHED_UNLOCK(primask);
+        if (t == NULL) {
+            break;
+        }
+        t->fn(t->arg);
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * \brief           Check if no task is ready, call with interrupts disabled before `WFI`
+ * \return          `1` if core may sleep, `0` otherwise
+ */
+uint8_t
+ipc_sched_is_idle(void) {
+    return ready_head == NULL;
+}
+
+/**
+ * \brief           Get number of running timers, call with interrupts disabled before core stops SysTick
+ * \return          Number of timers in wheel
+ */
+size_t
+ipc_sched_timers_armed(void) {
+    return armed_cnt;
+}
+
+#endif /* IPC_SCHED */
@@ -0,0 +1,97 @@
+/**
+ * \file            ipc_signal.c
+ * \brief           Payload-less cross-core signals
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_signal.h"
+
+/*
+ * Each signal of IPC_SIGNAL_TABLE owns one hardware semaphore, HSEM_SIGNAL(id),
+ * after semaphores of channels, topics, heap and ping-pong channels.
+ * Signal carries no data and goes through no ring buffer,
+ * delivery takes semaphore release and HSEM interrupt entry only.
+ *
+ * Repeated raises before receiving core served interrupt are delivered once.
+ * Signals are dispatched before channel doorbells of the same interrupt, see HAL_HSEM_FreeCallback
+ */
+
+_Static_assert(HSEM_SIGNAL(IPC_SIGNAL_COUNT) <= IPC_NOTIFY_SEM_COUNT, "Signals do not fit to hardware semaphores");
+
+/**
+ * \brief           Listener of single signal
+ */
+typedef struct {
+    ipc_signal_fn fn;                           /*!< Callback function */
+    void* arg;                                  /*!< User argument */
+} ipc_signal_listener_t;
+
+/* Signal listeners of current core */
+static ipc_signal_listener_t signal_listeners[IPC_SIGNAL_COUNT];
+
+/**
+ * \brief           Semaphore callback of all signals, translates semaphore to signal
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: Listener of signal
+ */
+static void
+prv_signal_notify(uint32_t sem_id, void* arg) {
+    ipc_signal_listener_t* l = arg;
+
+    l->fn(sem_id - HSEM_SIGNAL(0), l->arg);
+}
+
+/**
+ * \brief           Register callback for signal raised by other core
+ * \note            HSEM interrupt must be enabled in NVIC on current core
+ * \param[in]       id: Signal ID from \ref ipc_signal_id_t
+ * \param[in]       fn: Callback function, called from HSEM interrupt
+ * \param[in]       arg: User argument passed to callback
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_signal_listen(uint32_t id, ipc_signal_fn fn, void* arg) {
+    if (id >= IPC_SIGNAL_COUNT || fn == NULL) {
+        return 0;
+    }
+    signal_listeners[id].fn = fn;
+    signal_listeners[id].arg = arg;
+    return ipc_notify_listen(HSEM_SIGNAL(id), prv_signal_notify, &signal_listeners[id]);
+}
+
+/**
+ * \brief           Stop listening on signal
+ * \param[in]       id: Signal ID
+ */
+void
+ipc_signal_unlisten(uint32_t id) {
+    if (id < IPC_SIGNAL_COUNT) {
+        ipc_notify_unlisten(HSEM_SIGNAL(id));
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ * \file            ipc_soak.c
+ * \brief           Saturation soak test of both pipes
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include "main.h"
+#include "common.h"
+#include "ipc_soak.h"
+#include "ipc_chan.h"
+
+#if IPC_SOAK
+
+/*
+ * Each core writes pseudo-random byte stream to its transmit pipe at full rate
+ * and verifies stream of other core byte by byte. Chunk lengths vary,
+ * so that writes and reads start at any offset and cross end of buffer.
+ * No doorbells are used, both cores poll. Test never ends
+ */
+
+#if defined(CORE_CM7)
+#define IPC_SOAK_CORE                       0
+#define IPC_SOAK_TX_SEED                    0x9ABCDEF0  /* CPU1 to CPU2 stream */
+#define IPC_SOAK_RX_SEED                    0x12345678  /* CPU2 to CPU1 stream */
+#define IPC_SOAK_LED_PORT                   LD1_GPIO_PORT
+#define IPC_SOAK_LED_PIN                    LD1_GPIO_PIN
+#else
+#define IPC_SOAK_CORE                       1
+#define IPC_SOAK_TX_SEED                    0x12345678
+#define IPC_SOAK_RX_SEED                    0x9ABCDEF0
+#define IPC_SOAK_LED_PORT                   LD3_GPIO_PORT
+#define IPC_SOAK_LED_PIN                    LD3_GPIO_PIN
+#endif
+
+/* Maximum chunk length of single write and read */
+#define IPC_SOAK_CHUNK                      0x00000200
+
+/* Report and LED period, in units of milliseconds */
+#define IPC_SOAK_REPORT_MS                  1000
+
+/* Statistics of current core */
+#define IPC_SOAK_STATS                      (&IPC_SHM->ctrl.soak[IPC_SOAK_CORE])
+
+/**
+ * \brief           Byte stream generator, xorshift32
+ */
+typedef struct {
+    uint32_t state;                             /*!< Generator state */
+    uint32_t word;                              /*!< Remaining bytes of last word */
+    uint8_t left;                               /*!< Number of bytes left in `word` */
+} ipc_soak_gen_t;
+
+static uint8_t tx_buf[IPC_SOAK_CHUNK];
+static uint8_t rx_buf[IPC_SOAK_CHUNK];
+
+/**
+ * \brief           Advance xorshift32 state
+ * \param[in,out]   state: Generator state, never `0`
+ * \return          New state
+ */
+static uint32_t
+prv_xorshift(uint32_t* state) {
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/**
+ * \brief           Get next byte of stream
+ * \param[in,out]   gen: Generator
+ * \return          Stream byte
+ */
+static uint8_t
+prv_next(ipc_soak_gen_t* gen) {
+    uint8_t b;
+
+    if (gen->left == 0) {
+        gen->word = prv_xorshift(&gen->state);
+        gen->left = 4;
+    }
+    b = (uint8_t)gen->word;
+    gen->word >>= 8;
+    --gen->left;
+    return b;
+}
+
+/**
+ * \brief           Format statistics of one core
+ * \param[out]      str: Output string
+ * \param[in]       name: Core name
+ * \param[in]       stats: Statistics
+ * \param[in]       prev_rx: Received bytes at previous report
+ * \return          Length of string
+ */
+static int
+prv_format(char* str, const char* name, volatile ipc_soak_stats_t* stats, uint32_t prev_rx) {
+    uint32_t rate = (stats->bytes_rx - prev_rx) / (IPC_SOAK_REPORT_MS * 10);    /* Units of `10 kB/s` */
+
+    return sprintf(str, " %s rx %u.%02u MB/s err:%u fill:%u-%u",
+                    name, (unsigned)(rate / 100), (unsigned)(rate % 100), (unsigned)stats->errors,
+                    (unsigned)stats->fill_min, (unsigned)stats->fill_max);
+}
+
+/**
+ * \brief           Reset statistics of both cores, called by CPU1 before other core is started
+ */
+void
+ipc_soak_reset(void) {
+    for (size_t i = 0; i < 2; ++i) {
+        IPC_SHM->ctrl.soak[i] = (ipc_soak_stats_t){ 0, 0, 0, UINT32_MAX, 0 };
+    }
+}
+
+/**
+ * \brief           Run soak test on current core, function never returns
+ *
+ * Both cores must call it with empty pipes. LED of core (LD1 on CPU1, LD3 on CPU2)
+ * blinks while no error was detected and stays on after first error.
+ *
+ * CPU1 reports throughput, errors and fill levels of both cores every second,
+ * `[SOAK] t:s CM7 rx x.xx MB/s err:n fill:min-max CM4 rx ...`
+ *
+ * \param[in]       tx: Buffer to other core
+ * \param[in]       rx: Buffer from other core
+ * \param[in]       out_fn: Output function for report lines, `NULL` on CPU2
+ */
+void
+ipc_soak_run(ringbuff_t* tx, ringbuff_t* rx, ipc_soak_out_fn out_fn) {
+    volatile ipc_soak_stats_t* stats = IPC_SOAK_STATS;
+    ipc_soak_gen_t gen_tx = { IPC_SOAK_TX_SEED, 0, 0 }, gen_rx = { IPC_SOAK_RX_SEED, 0, 0 };
+    uint32_t len_seed = IPC_SOAK_TX_SEED ^ 0x5A5A5A5A, prev_rx[2] = { 0, 0 };
+    uint32_t time, t_report = HAL_GetTick(), t_start = t_report;
+    size_t tx_len = 0, tx_off = 0, len, full;
+    char str[160];
+    int n;
+
+    while (1) {
+        /* Next chunk of stream, length 1 to IPC_SOAK_CHUNK bytes */
+        if (tx_off == tx_len) {
+            tx_len = 1 + prv_xorshift(&len_seed) % IPC_SOAK_CHUNK;
+            tx_off = 0;
+            for (size_t i = 0; i < tx_len; ++i) {
+                tx_buf[i] = prv_next(&gen_tx);
+            }
+        }
+        len = ringbuff_write(tx, &tx_buf[tx_off], tx_len - tx_off);
+        tx_off += len;
+        stats->bytes_tx += len;
+
+        /* Verify stream of other core */
+        full = ringbuff_get_full(rx);
+        if (full < stats->fill_min) {
+            stats->fill_min = full;
+        }
+        if (full > stats->fill_max) {
+            stats->fill_max = full;
+        }
+        len = ringbuff_read(rx, rx_buf, 1 + prv_xorshift(&len_seed) % IPC_SOAK_CHUNK);
+        for (size_t i = 0; i < len; ++i) {
+            if (rx_buf[i] != prv_next(&gen_rx)) {
+                ++stats->errors;
+            }
+        }
+        stats->bytes_rx += len;
+
+        /* Report and blink */
+        time = HAL_GetTick();
+        if (time - t_report >= IPC_SOAK_REPORT_MS) {
+            t_report = time;
+            if (stats->errors == 0) {
+                HAL_GPIO_TogglePin(IPC_SOAK_LED_PORT, IPC_SOAK_LED_PIN);
+            } else {
+                HAL_GPIO_WritePin(IPC_SOAK_LED_PORT, IPC_SOAK_LED_PIN, GPIO_PIN_SET);
+            }
+            if (out_fn != NULL) {
+                n = sprintf(str, "[SOAK] t:%u", (unsigned)((time - t_start) / 1000));
+                n += prv_format(&str[n], "CM7", &IPC_SHM->ctrl.soak[0], prev_rx[0]);
+                n += prv_format(&str[n], "CM4", &IPC_SHM->ctrl.soak[1], prev_rx[1]);
+                n += sprintf(&str[n], "\r\n");
+                out_fn(str, n);
+            }
+            prev_rx[0] = IPC_SHM->ctrl.soak[0].bytes_rx;
+            prev_rx[1] = IPC_SHM->ctrl.soak[1].bytes_rx;
+        }
+    }
+}
+
+#endif /* IPC_SOAK */
@@ -0,0 +1,329 @@
+/**
+ * \file            ipc_steal.c
+ * \brief           Work-stealing job deques of both cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_steal.h"
+#include "ipc_chan.h"
+#include "ipc_notify.h"
+#include "ipc_time.h"
+
+#include <string.h>
+
+#if IPC_STEAL
+
+/*
+ * Each core owns job deque in shared RAM. Owner submits jobs to bottom and runs newest job first,
+ * data of recent job are likely still in its cache. Core with empty deque steals oldest jobs
+ * from top of deque of other core, so both cores stay busy when jobs come in bursts to one of them.
+ *
+ * Steal takes share of queued jobs proportional to thief clock, `queued * thief / (thief + owner)`
+ * rounded up, at most IPC_STEAL_BATCH. Both cores then finish their part at about the same time,
+ * CPU2 at 240 MHz takes one third of CPU1 backlog and CPU1 at 480 MHz two thirds of CPU2 backlog.
+ * Clock of each core is published in its deque on every poll.
+ *
+ * Owner and thief update positions with deque lock HSEM_STEAL_LOCK(core) held, instead of
+ * lock-free protocol, exclusive monitors of the cores do not see each other.
+ * Jobs are copied under lock, one cache line each.
+ *
+ * \ref ipc_steal_flush rings HSEM_STEAL(core), other core listens on it and steals when idle.
+ * Latency is measured from submit to completion with ipc_now_ns when IPC_TIME is enabled.
+ * Otherwise it is measured with SysTick, in steps of `1 ms`, and only for jobs run by core that submitted them,
+ * SysTick of other core is not related to own one
+ */
+
+/* Deque state and slots of core */
+#define IPC_STEAL_SHARED(core)              ((ipc_steal_shared_t *)&IPC_SHM->ctrl.steal[(core)])
+#define IPC_STEAL_JOBS(core)                ((ipc_steal_job_t *)IPC_SHM->steal[(core)])
+#define IPC_STEAL_SLOT(jobs, pos)           (&(jobs)[(pos) & (IPC_STEAL_SLOTS - 1)])
+
+_Static_assert((IPC_STEAL_SLOTS & (IPC_STEAL_SLOTS - 1)) == 0, "Deque length is not power of 2");
+_Static_assert(IPC_STEAL_BATCH > 0 && IPC_STEAL_BATCH <= IPC_STEAL_SLOTS, "Steal batch is out of range");
+_Static_assert(sizeof(ipc_steal_job_t) == MEM_CACHE_LINE_SIZE, "Job descriptor is not one cache line");
+_Static_assert(HSEM_STEAL_LOCK(1) < IPC_NOTIFY_SEM_COUNT, "Deque semaphores do not fit to hardware semaphores");
+
+/**
+ * \brief           Get time for job latency
+ * \return          Time in units of microseconds
+ */
+static uint32_t
+prv_now_us(void) {
+#if IPC_TIME
+    return (uint32_t)(ipc_now_ns() / 1000);
+#else
+    return HAL_GetTick() * 1000;
+#endif /* IPC_TIME */
+}
+
+/**
+ * \brief           Reset deques of both cores to empty.
+ *                  Called by CPU1 from \ref ipc_chan_dir_init
+ */
+void
+ipc_steal_reset(void) {
+    for (uint32_t core = 0; core < 2; ++core) {
+        ipc_steal_shared_t* s = IPC_STEAL_SHARED(core);
+
+        memset(s, 0x00, sizeof(*s));
+        ipc_lock_init(&s->lock, HSEM_STEAL_LOCK(core));
+    }
+}
+
+/**
+ * \brief           Initialize worker of current core
+ * \param[in]       w: Worker handle
+ * \param[in]       fns: Function table, same function IDs on both cores
+ * \param[in]       count: Number of entries in function table
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ipc_steal_init(ipc_steal_t* w, const ipc_steal_entry_t* fns, size_t count) {
+    if (w == NULL || fns == NULL) {
+        return 0;
+    }
+    w->own = IPC_STEAL_SHARED(IPC_LOCK_CORE);
+    w->peer = IPC_STEAL_SHARED(1 - IPC_LOCK_CORE);
+    w->own_jobs = IPC_STEAL_JOBS(IPC_LOCK_CORE);
+    w->peer_jobs = IPC_STEAL_JOBS(1 - IPC_LOCK_CORE);
+    w->sem_id = HSEM_STEAL(IPC_LOCK_CORE);
+    w->batch = 0;
+    w->fns = fns;
+    w->count = count;
+    w->own->mhz = CYCCNT_PER_US();
+    return 1;
+}
+
+/**
+ * \brief           Queue job to deque of current core, doorbell is rung by \ref ipc_steal_flush
+ * \param[in]       w: Worker handle
+ * \param[in]       fn_id: Function ID
+ * \param[in]       args: Job arguments
+ * \param[in]       len: Length of arguments, up to \ref IPC_STEAL_ARGS_LEN
+ * \return          `1` on success, `0` when deque is full
+ */
+uint8_t
+ipc_steal_submit(ipc_steal_t* w, uint16_t fn_id, const void* args, size_t len) {
+    ipc_steal_job_t* job;
+    uint32_t primask;
+
+    if (w == NULL || len > IPC_STEAL_ARGS_LEN) {
+        return 0;
+    }
+    primask = ipc_lock_take(&w->own->lock);
+    if (w->own->bottom - w->own->top >= IPC_STEAL_SLOTS) {
+        ++w->own->full;
+        ipc_lock_release(&w->own->lock, primask);
+        return 0;
+    }
+    job = IPC_STEAL_SLOT(w->own_jobs, w->own->bottom);
+    job->fn_id = fn_id;
+    job->len = (uint16_t)len;
+    job->submit_us = prv_now_us();
+    memcpy(job->args, args, len);
+#if IPC_CHAN_CACHE_MAINT
+    SCB_CleanDCache_by_Addr((void *)job, (int32_t)sizeof(*job));
+#endif /* IPC_CHAN_CACHE_MAINT */
+    ++w->own->bottom;
+    ipc_lock_release(&w->own->lock, primask);
+    ++w->batch;
+    return 1;
+}
+
+/**
+ * \brief           Ring doorbell of own deque for jobs submitted since last flush
+ * \param[in]       w: Worker handle
+ */
+void
+ipc_steal_flush(ipc_steal_t* w) {
+    if (w != NULL && w->batch > 0) {
+        w->batch = 0;
+        ipc_notify(w->sem_id);
+    }
+}
+
+/**
+ * \brief           Copy jobs out of deque, called with deque lock held
+ * \param[in]       jobs: Deque slots
+ * \param[in]       pos: Position of first job
+ * \param[out]      out: Output jobs
+ * \param[in]       n: Number of jobs
+ */
+static void
+prv_copy_out(ipc_steal_job_t* jobs, uint32_t pos, ipc_steal_job_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        ipc_steal_job_t* job = IPC_STEAL_SLOT(jobs, pos + i);
+
+#if IPC_CHAN_CACHE_MAINT
+        SCB_InvalidateDCache_by_Addr((void *)job, (int32_t)sizeof(*job));
+#endif /* IPC_CHAN_CACHE_MAINT */
+        out[i] = *job;
+    }
+}
+
+/**
+ * \brief           Take newest job of own deque
+ * \param[in]       w: Worker handle
+ * \param[out]      out: Output job
+ * \return          `1` on success, `0` when deque is empty
+ */
+static uint8_t
+prv_pop(ipc_steal_t* w, ipc_steal_job_t* out) {
+    uint32_t primask;
+    uint8_t res = 0;
+
+    primask = ipc_lock_take(&w->own->lock);
+    if (w->own->bottom != w->own->top) {
+        prv_copy_out(w->own_jobs, --w->own->bottom, out, 1);
+        res = 1;
+    }
+    ipc_lock_release(&w->own->lock, primask);
+    return res;
+}
+
+/**
+ * \brief           Take share of oldest jobs of other core, by clock ratio of both cores
+ * \param[in]       w: Worker handle
+ * \param[out]      out: Output jobs, \ref IPC_STEAL_BATCH entries
+ * \return          Number of stolen jobs
+ */
+static size_t
+prv_steal(ipc_steal_t* w, ipc_steal_job_t* out) {
+    uint32_t primask, queued, mine, theirs;
+    size_t n = 0;
+
+    mine = w->own->mhz;
+    theirs = w->peer->mhz > 0 ? w->peer->mhz : mine;
+    primask = ipc_lock_take(&w->peer->lock);
+    queued = w->peer->bottom - w->peer->top;
+    if (queued > 0) {
+        n = (queued * mine + mine + theirs - 1) / (mine + theirs);
+        if (n > IPC_STEAL_BATCH) {
+            n = IPC_STEAL_BATCH;
+        }
+        prv_copy_out(w->peer_jobs, w->peer->top, out, n);
+        w->peer->top += n;
+    }
+    ipc_lock_release(&w->peer->lock, primask);
+    if (n > 0) {
+        ++w->own->steals;
+        w->own->stolen += n;
+    }
+    return n;
+}
+
+/**
+ * \brief           Execute job and account its latency
+ * \param[in]       w: Worker handle
+ * \param[in]       job: Job
+ * \param[in]       stolen: Set to `1` when job was submitted by other core
+ */
+static void
+prv_run(ipc_steal_t* w, const ipc_steal_job_t* job, uint8_t stolen) {
+    uint32_t lat, samples;
+
+    for (size_t i = 0; i < w->count; ++i) {
+        if (w->fns[i].fn_id == job->fn_id) {
+            w->fns[i].fn(job->args, job->len);
+            break;
+        }
+    }
+#if IPC_TIME
+    (void)stolen;
+    samples = w->own->executed;
+#else
+    if (stolen) {
+        ++w->own->executed;
+        return;
+    }
+    samples = w->own->executed - w->own->stolen;   /* Stolen jobs are counted before they run, all ran already */
+#endif /* IPC_TIME */
+    lat = prv_now_us() - job->submit_us;
+    if (lat > w->own->lat_max_us) {
+        w->own->lat_max_us = lat;
+    }
+    w->own->lat_avg_us = samples == 0 ? lat
+        : w->own->lat_avg_us + (int32_t)(lat - w->own->lat_avg_us) / 16;
+    ++w->own->executed;
+}
+
+/**
+ * \brief           Run jobs of own deque, then steal from other core until both deques are empty.
+ *                  Called when own jobs were submitted and from doorbell of other core
+ * \param[in]       w: Worker handle
+ * \return          Number of executed jobs
+ */
+size_t
+ipc_steal_poll(ipc_steal_t* w) {
+    ipc_steal_job_t jobs[IPC_STEAL_BATCH];
+    size_t n, done = 0;
+
+    if (w == NULL) {
+        return 0;
+    }
+    w->own->mhz = CYCCNT_PER_US();              /* Clock may change with IPC_DVFS */
+    for (;;) {
+        if (prv_pop(w, &jobs[0])) {
+            prv_run(w, &jobs[0], 0);
+            ++done;
+        } else if ((n = prv_steal(w, jobs)) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+                prv_run(w, &jobs[i], 1);
+            }
+            done += n;
+        } else {
+            break;
+        }
+    }
+    return done;
+}
+
+/**
+ * \brief           Get worker statistics of either core
+ * \param[in]       core: `0` for CPU1, `1` for CPU2
+ * \param[out]      stats: Output statistics
+ */
+void
+ipc_steal_get_stats(uint32_t core, ipc_steal_stats_t* stats) {
+    ipc_steal_shared_t* s;
+
+    if (core > 1 || stats == NULL) {
+        return;
+    }
+    s = IPC_STEAL_SHARED(core);
+    stats->depth = s->bottom - s->top;
+    stats->executed = s->executed;
+    stats->stolen = s->stolen;
+    stats->steals = s->steals;
+    stats->full = s->full;
+    stats->lat_avg_us = s->lat_avg_us;
+    stats->lat_max_us = s->lat_max_us;
+}
+
+#endif /* IPC_STEAL */
@@ -0,0 +1,165 @@
+/**
+ * \file            ipc_time.c
+ * \brief           Cross-core timestamps
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_time.h"
+#include "ipc_chan.h"
+
+#if IPC_TIME
+
+/*
+ * Timebase is TIM5, 32-bit free-running counter at timer kernel clock.
+ * Both cores read the same counter, there is no offset between cores to calibrate.
+ * D3 domain has only 16-bit LPTIM timers, TIM2 is used by latency instrumentation
+ */
+#define IPC_TIME_TIM                        TIM5
+
+/* Ticks after which CPU1 moves epoch, well below counter wrap */
+#define IPC_TIME_REBASE_TICKS               0x40000000UL
+
+/* Timebase epoch */
+#define IPC_TIME_SHARED                     (&IPC_SHM->ctrl.time)
+
+/**
+ * \brief           Get counter frequency from current clock tree
+ * \return          Timer kernel clock in units of Hz
+ */
+static uint32_t
+prv_tick_hz(void) {
+    uint32_t hz = HAL_RCC_GetPCLK1Freq();
+
+    /* APB1 timer clock is twice PCLK1 when APB1 is divided */
+    if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_APB1_DIV1) {
+        hz *= 2;
+    }
+    return hz;
+}
+
+/**
+ * \brief           Start timebase and publish first epoch.
+ *                  Called by CPU1 after clock configuration, before CPU2 attaches to channels
+ */
+void
+ipc_time_init(void) {
+    volatile ipc_time_shared_t* t = IPC_TIME_SHARED;
+
+    /* Clock allocated to CPU1 keeps timer running while CPU2 is in stop mode */
+    __HAL_RCC_TIM5_CLK_ENABLE();
+    IPC_TIME_TIM->CR1 = 0;
+    IPC_TIME_TIM->PSC = 0;
+    IPC_TIME_TIM->ARR = 0xFFFFFFFF;
+    IPC_TIME_TIM->EGR = TIM_EGR_UG;
+
+    t->seq = 0;
+    t->base_cnt = 0;
+    t->base_ns = 0;
+    t->tick_hz = prv_tick_hz();
+    t->mult = (uint32_t)((1000000000ULL << 24) / t->tick_hz);
+    __DMB();                                    /* Epoch before counter starts */
+    IPC_TIME_TIM->CR1 = TIM_CR1_CEN;
+}
+
+/**
+ * \brief           Move epoch to current time and take counter frequency from clock tree.
+ *                  Called by CPU1 from \ref ipc_time_poll, and before and after each clock change.
+ *
+ * Ticks counted while clock switches are converted with old frequency,
+ * error of clock change is at most duration of switch
+ */
+void
+ipc_time_rebase(void) {
+    volatile ipc_time_shared_t* t = IPC_TIME_SHARED;
+    uint32_t cnt, primask, hz;
+    uint64_t ns;
+
+    hz = prv_tick_hz();
+
+    /* Readers in interrupt of CPU1 must not see odd sequence forever */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    cnt = IPC_TIME_TIM->CNT;
+    ns = t->base_ns + (((uint64_t)(cnt - t->base_cnt) * t->mult) >> 24);
+    t->seq = t->seq + 1;
+    __DMB();                                    /* Odd sequence before fields */
+    t->base_cnt = cnt;
+    t->base_ns = ns;
+    if (hz != t->tick_hz) {
+        t->tick_hz = hz;
+        t->mult = (uint32_t)((1000000000ULL << 24) / hz);
+    }
+    __DMB();                                    /* Fields before even sequence */
+    t->seq = t->seq + 1;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * \brief           Move epoch before counter wraps, call by CPU1 from main loop.
+ *                  Epoch moves every `2^30` ticks and readers stay valid up to `2^32` ticks,
+ *                  call at least once per `~13s` at `240 MHz` timer clock
+ */
+void
+ipc_time_poll(void) {
+    volatile ipc_time_shared_t* t = IPC_TIME_SHARED;
+
+    if (IPC_TIME_TIM->CNT - t->base_cnt >= IPC_TIME_REBASE_TICKS) {
+        ipc_time_rebase();
+    }
+}
+
+/**
+ * \brief           Get time since CPU1 started timebase, from any core and context.
+ *
+ * Both cores read the same counter, skew between cores is `0`, resolution is `1` tick
+ * (`5 ns` at `200 MHz` timer clock, `15.6 ns` at `64 MHz`).
+ * Cost is one APB1 register read, `2` sequence reads from shared RAM and one `32x32` to `64-bit` multiply,
+ * no division. Call retries only when it overlapped epoch update of CPU1
+ *
+ * \return          Time in units of nanoseconds
+ */
+uint64_t
+ipc_now_ns(void) {
+    volatile ipc_time_shared_t* t = IPC_TIME_SHARED;
+    uint32_t seq, cnt, base_cnt, mult;
+    uint64_t base_ns;
+
+    do {
+        seq = t->seq;
+        __DMB();                                /* Sequence before fields */
+        base_cnt = t->base_cnt;
+        base_ns = t->base_ns;
+        mult = t->mult;
+        cnt = IPC_TIME_TIM->CNT;
+        __DMB();                                /* Fields before sequence check */
+    } while ((seq & 0x01) || seq != t->seq);
+    return base_ns + (((uint64_t)(cnt - base_cnt) * mult) >> 24);
+}
+
+#endif /* IPC_TIME */
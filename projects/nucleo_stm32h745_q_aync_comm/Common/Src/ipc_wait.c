@@ -0,0 +1,94 @@
+/**
+ * \file            ipc_wait.c
+ * \brief           Cycle-accurate timeouts
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ipc_wait.h"
+
+/**
+ * \brief           Start timeout
+ *
+ * Timeout counts core cycles, independent of loop body, cache state and optimization level.
+ * Elapsed cycles accumulate on every check, so cycle counter may wrap during wait
+ * as long as \ref ipc_wait_expired is called at least once per wrap period (`~8s` at `480 MHz`).
+ * Cycles are converted with current `SystemCoreClock` on each check and follow clock profile changes
+ *
+ * Cycle counter stops in sleep, waits that sleep between checks use \ref ipc_wait_start_tick
+ *
+ * \param[in]       w: Timeout handle
+ * \param[in]       timeout_us: Timeout in units of microseconds, `IPC_WAIT_FOREVER` to never expire
+ */
+void
+ipc_wait_start(ipc_wait_t* w, uint32_t timeout_us) {
+    CYCCNT_INIT();
+    w->timeout_us = timeout_us;
+    w->elapsed = 0;
+    w->tick = 0;
+    w->last = CYCCNT_GET();
+}
+
+/**
+ * \brief           Start timeout of wait that sleeps between checks
+ *
+ * Cycle counter stops while core sleeps in `WFI` or `WFE`, timeout is measured with tick instead.
+ * Timeout is rounded up to whole ticks of `1 ms` and never expires early,
+ * SysTick interrupt must be enabled and bounds each sleep to `1` tick
+ *
+ * \param[in]       w: Timeout handle
+ * \param[in]       timeout_us: Timeout in units of microseconds, `IPC_WAIT_FOREVER` to never expire
+ */
+void
+ipc_wait_start_tick(ipc_wait_t* w, uint32_t timeout_us) {
+    w->timeout_us = timeout_us;
+    w->elapsed = 0;
+    w->tick = 1;
+    w->last = HAL_GetTick();
+}
+
+/**
+ * \brief           Check if timeout expired
+ * \param[in]       w: Timeout handle
+ * \return          `1` if timeout expired, `0` otherwise
+ */
+uint8_t
+ipc_wait_expired(ipc_wait_t* w) {
+    uint32_t now;
+
+    if (w->tick) {
+        /* Start tick may be partially elapsed, one tick more than timeout */
+        return w->timeout_us != IPC_WAIT_FOREVER
+            && HAL_GetTick() - w->last > w->timeout_us / 1000 + (w->timeout_us % 1000 != 0);
+    }
+    now = CYCCNT_GET();
+    w->elapsed += now - w->last;
+    w->last = now;
+    return w->timeout_us != IPC_WAIT_FOREVER
+        && w->elapsed >= (uint64_t)w->timeout_us * CYCCNT_PER_US();
+}
@@ -0,0 +1,235 @@
+/**
+ * \file            mem_bench.c
+ * \brief           Bus matrix benchmark
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include "main.h"
+#include "common.h"
+#include "mem_bench.h"
+#include "ipc_chan.h"
+
+#if MEM_BENCH
+
+#if defined(CORE_CM7)
+#define MEM_BENCH_CORE                      "CM7"
+#define MEM_BENCH_IDX                       0
+#else
+#define MEM_BENCH_CORE                      "CM4"
+#define MEM_BENCH_IDX                       1
+#endif
+
+/* Number of passes over scratch memory per throughput measurement */
+#define MEM_BENCH_LOOPS                     8
+
+/* Words in scratch memory and in one cache line */
+#define MEM_BENCH_WORDS                     (MEM_BENCH_LEN / sizeof(uint32_t))
+#define MEM_BENCH_LINE_WORDS                (MEM_CACHE_LINE_SIZE / sizeof(uint32_t))
+
+/* Cache lines between successive loads of pointer chase, odd to visit every line once */
+#define MEM_BENCH_CHASE_STRIDE              5
+#define MEM_BENCH_CHASE_LOADS               (MEM_BENCH_LEN / MEM_CACHE_LINE_SIZE)
+
+/* Core-local reference memory, DTCM or AXI SRAM on CPU1, D2 SRAM1 on CPU2 */
+static uint32_t local_mem[MEM_BENCH_WORDS] __ALIGNED(MEM_CACHE_LINE_SIZE);
+
+/* Read results are accumulated here, for loads not to be optimized away */
+static volatile uint32_t sink;
+
+/**
+ * \brief           Invalidate cache lines before memory is read,
+ *                  when data are cacheable for this core as channel data
+ * \param[in]       mem: Scratch memory
+ * \param[in]       maint: Set to `1` when memory has channel data attributes
+ */
+static void
+prv_invalidate(volatile uint32_t* mem, uint8_t maint) {
+#if IPC_CHAN_CACHE_MAINT
+    if (maint) {
+        SCB_InvalidateDCache_by_Addr((void *)mem, MEM_BENCH_LEN);
+    }
+#else
+    (void)mem;
+    (void)maint;
+#endif /* IPC_CHAN_CACHE_MAINT */
+}
+
+/**
+ * \brief           Clean cache lines after memory is written,
+ *                  when data are cacheable for this core as channel data
+ * \param[in]       mem: Scratch memory
+ * \param[in]       maint: Set to `1` when memory has channel data attributes
+ */
+static void
+prv_clean(volatile uint32_t* mem, uint8_t maint) {
+#if IPC_CHAN_CACHE_MAINT
+    if (maint) {
+        SCB_CleanDCache_by_Addr((void *)mem, MEM_BENCH_LEN);
+    }
+#else
+    (void)mem;
+    (void)maint;
+#endif /* IPC_CHAN_CACHE_MAINT */
+}
+
+/**
+ * \brief           Convert cycles spent on moving data to throughput
+ * \param[in]       cycles: Core cycles for \ref MEM_BENCH_LOOPS passes
+ * \return          Throughput in units of `10 kB/s`, `MB/s * 100`
+ */
+static uint32_t
+prv_tput(uint32_t cycles) {
+    if (cycles == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)MEM_BENCH_LEN * MEM_BENCH_LOOPS * SystemCoreClock / 10000) / cycles);
+}
+
+/**
+ * \brief           Measure sequential word read throughput
+ * \param[in]       mem: Scratch memory, \ref MEM_BENCH_LEN bytes
+ * \param[in]       maint: Set to `1` when memory has channel data attributes
+ * \return          Throughput in units of `10 kB/s`, `MB/s * 100`
+ */
+static uint32_t
+prv_measure_read(volatile uint32_t* mem, uint8_t maint) {
+    uint32_t start, cycles = 0, acc = 0;
+
+    for (size_t l = 0; l < MEM_BENCH_LOOPS; ++l) {
+        start = CYCCNT_GET();
+        prv_invalidate(mem, maint);             /* Counted, as for channel reads */
+        for (size_t i = 0; i < MEM_BENCH_WORDS; i += 4) {
+            acc += mem[i] + mem[i + 1] + mem[i + 2] + mem[i + 3];
+        }
+        cycles += CYCCNT_GET() - start;
+    }
+    sink = acc;
+    return prv_tput(cycles);
+}
+
+/**
+ * \brief           Measure sequential word write throughput
+ * \param[out]      mem: Scratch memory, \ref MEM_BENCH_LEN bytes
+ * \param[in]       maint: Set to `1` when memory has channel data attributes
+ * \return          Throughput in units of `10 kB/s`, `MB/s * 100`
+ */
+static uint32_t
+prv_measure_write(volatile uint32_t* mem, uint8_t maint) {
+    uint32_t start, cycles;
+
+    start = CYCCNT_GET();
+    for (size_t l = 0; l < MEM_BENCH_LOOPS; ++l) {
+        for (size_t i = 0; i < MEM_BENCH_WORDS; i += 4) {
+            mem[i] = (uint32_t)i;
+            mem[i + 1] = (uint32_t)i;
+            mem[i + 2] = (uint32_t)i;
+            mem[i + 3] = (uint32_t)i;
+        }
+        prv_clean(mem, maint);                  /* Counted, as for channel writes */
+    }
+    __DSB();                                    /* Wait for write buffer to drain */
+    cycles = CYCCNT_GET() - start;
+    return prv_tput(cycles);
+}
+
+/**
+ * \brief           Measure load-to-use latency with dependent loads,
+ *                  each load goes to another cache line
+ * \param[in,out]   mem: Scratch memory, \ref MEM_BENCH_LEN bytes, chain is built in it
+ * \param[in]       maint: Set to `1` when memory has channel data attributes
+ * \return          Latency of one load in units of nanoseconds
+ */
+static uint32_t
+prv_measure_latency(volatile uint32_t* mem, uint8_t maint) {
+    volatile uint32_t* p;
+    uint32_t start, cycles;
+    size_t line = 0;
+
+    /* Chain visits every line once, in non-sequential order */
+    for (size_t i = 0; i < MEM_BENCH_CHASE_LOADS; ++i) {
+        size_t next = (line + MEM_BENCH_CHASE_STRIDE) % MEM_BENCH_CHASE_LOADS;
+        mem[line * MEM_BENCH_LINE_WORDS] = (uint32_t)&mem[next * MEM_BENCH_LINE_WORDS];
+        line = next;
+    }
+    prv_clean(mem, maint);
+    prv_invalidate(mem, maint);                 /* Not counted, every load must miss */
+
+    p = mem;
+    start = CYCCNT_GET();
+    for (size_t i = 0; i < MEM_BENCH_CHASE_LOADS; ++i) {
+        p = (volatile uint32_t *)*p;
+    }
+    cycles = CYCCNT_GET() - start;
+    sink = (uint32_t)p;
+    return (uint32_t)(((uint64_t)cycles * 1000) / (SystemCoreClock / 1000000) / MEM_BENCH_CHASE_LOADS);
+}
+
+/**
+ * \brief           Run bus matrix benchmark on current core and report results
+ *
+ * Measures sequential 32-bit read and write throughput and dependent load latency
+ * to core-local RAM and scratch memory of current core in each placement region of channel data,
+ * SRAM4 (D3), AXI SRAM (D1) and D2 SRAM2. Results show which region is closest to each core,
+ * to choose region column of channel table.
+ *
+ * Each report line has format `[core] mem region rd:x wr:y MB/s lat:z ns maint:m`,
+ * `maint:1` when shared region is cacheable for this core and cache maintenance is counted
+ * as for channel data (\ref IPC_CHAN_CACHE_MAINT). Compare builds with different `SHD_RAM_DATA_CACHE` setting.
+ * Interconnect between domains is shared, run it while other core is idle for repeatable results
+ *
+ * \param[in]       out_fn: Output function for report lines
+ */
+void
+mem_bench_run(mem_bench_out_fn out_fn) {
+    const struct {
+        const char* name;
+        volatile uint32_t* mem;
+        uint8_t maint;
+    } regions[] = {
+        { "local", local_mem, 0 },
+        { "SRAM4", (volatile uint32_t *)IPC_SHM->mem_bench[MEM_BENCH_IDX], IPC_CHAN_CACHE_MAINT },
+        { "AXI", (volatile uint32_t *)IPC_SHM_AXI->mem_bench[MEM_BENCH_IDX], IPC_CHAN_CACHE_MAINT },
+        { "D2", (volatile uint32_t *)IPC_SHM_D2->mem_bench[MEM_BENCH_IDX], IPC_CHAN_CACHE_MAINT },
+    };
+    uint32_t rd, wr, lat;
+    char str[80];
+    int len;
+
+    CYCCNT_INIT();
+    for (size_t r = 0; r < sizeof(regions) / sizeof(regions[0]); ++r) {
+        wr = prv_measure_write(regions[r].mem, regions[r].maint);
+        rd = prv_measure_read(regions[r].mem, regions[r].maint);
+        lat = prv_measure_latency(regions[r].mem, regions[r].maint);
+        len = sprintf(str, "[" MEM_BENCH_CORE "] mem %s rd:%u.%02u wr:%u.%02u MB/s lat:%u ns maint:%u\r\n",
+                        regions[r].name, (unsigned)(rd / 100), (unsigned)(rd % 100),
+                        (unsigned)(wr / 100), (unsigned)(wr % 100), (unsigned)lat, (unsigned)regions[r].maint);
+        out_fn(str, len);
+    }
+}
+
+#endif /* MEM_BENCH */
@@ -0,0 +1,232 @@
+/**
+ * \file            ringbuff_async.c
+ * \brief           Completion callbacks of ring buffer reads and writes
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ringbuff_async.h"
+
+#if IPC_ASYNC
+
+/*
+ * Pending callbacks are kept in slots of current core.
+ * Slot is claimed in `used` mask with LDREX/STREX, against HSEM interrupt
+ * re-arming callback, and becomes visible to evaluation when it is set in `armed` mask.
+ * Evaluation clears `armed` bit before callback is called, callback may arm new one.
+ *
+ * Peer doorbell is the event: after peer wrote data or freed memory, HSEM interrupt
+ * calls \ref ringbuff_async_poll from HAL_HSEM_FreeCallback, after channel listeners.
+ * Buffers without doorbell are evaluated by application calling ringbuff_async_poll
+ */
+
+/**
+ * \brief           Pending callback
+ */
+typedef struct {
+    RINGBUFF_VOLATILE ringbuff_t* buff;         /*!< Buffer handle */
+    size_t len;                                 /*!< Requested number of bytes */
+    uint8_t write;                              /*!< `1` for free memory, `0` for data */
+    ringbuff_async_fn fn;                       /*!< Callback */
+    void* ctx;                                  /*!< User context */
+} ringbuff_async_slot_t;
+
+static ringbuff_async_slot_t slots[RINGBUFF_ASYNC_SLOTS];
+static volatile uint32_t used;                  /* Claimed slots */
+static volatile uint32_t armed;                 /* Slots ready for evaluation */
+
+_Static_assert(RINGBUFF_ASYNC_SLOTS <= 32, "Slots do not fit to mask");
+
+/**
+ * \brief           Set or clear bits atomically against interrupts of this core
+ * \param[in]       p: Bit mask
+ * \param[in]       set: Bits to set
+ * \param[in]       clr: Bits to clear
+ */
+static void
+prv_bits(volatile uint32_t* p, uint32_t set, uint32_t clr) {
+    uint32_t v;
+
+    do {
+        v = (__LDREXW(p) & ~clr) | set;
+    } while (__STREXW(v, p) != 0);
+}
+
+/**
+ * \brief           Claim free slot
+ * \return          Slot index, \ref RINGBUFF_ASYNC_SLOTS when all slots are used
+ */
+static uint32_t
+prv_claim(void) {
+    uint32_t v, idx;
+
+    do {
+        v = __LDREXW(&used);
+        if ((~v & ((1ULL << RINGBUFF_ASYNC_SLOTS) - 1)) == 0) {
+            __CLREX();
+            return RINGBUFF_ASYNC_SLOTS;
+        }
+        idx = __CLZ(__RBIT(~v));                /* Lowest free slot */
+    } while (__STREXW(v | (1UL << idx), &used) != 0);
+    return idx;
+}
+
+/**
+ * \brief           Get bytes available for pending operation
+ * \param[in]       s: Slot
+ * \return          Ready bytes for read, free bytes for write
+ */
+static size_t
+prv_avail(const ringbuff_async_slot_t* s) {
+    return s->write ? ringbuff_get_free(s->buff) : ringbuff_get_full(s->buff);
+}
+
+/**
+ * \brief           Arm callback
+ * \param[in]       buff: Buffer handle
+ * \param[in]       len: Requested number of bytes
+ * \param[in]       write: `1` for free memory, `0` for data
+ * \param[in]       cb: Callback
+ * \param[in]       ctx: User context
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_arm(RINGBUFF_VOLATILE ringbuff_t* buff, size_t len, uint8_t write, ringbuff_async_fn cb, void* ctx) {
+    ringbuff_async_slot_t* s;
+    uint32_t idx;
+
+    if (!ringbuff_is_ready(buff) || cb == NULL || len == 0 || len > buff->size) {
+        return 0;
+    }
+    if ((idx = prv_claim()) == RINGBUFF_ASYNC_SLOTS) {
+        return 0;
+    }
+    s = &slots[idx];
+    s->buff = buff;
+    s->len = len;
+    s->write = write;
+    s->fn = cb;
+    s->ctx = ctx;
+    prv_bits(&armed, 1UL << idx, 0);
+
+    /* Condition may be met already, doorbell was rung before slot was armed */
+    ringbuff_async_poll();
+    return 1;
+}
+
+/**
+ * \brief           Call `cb` once, when at least `n` bytes are ready to be read from `buff`
+ *
+ * Callback is called from HSEM interrupt after peer doorbell, or from \ref ringbuff_async_poll.
+ * It is called before function returns when data are ready already
+ *
+ * \param[in]       buff: Buffer handle, consumer side
+ * \param[in]       n: Number of bytes
+ * \param[in]       cb: Callback
+ * \param[in]       ctx: User context passed to callback
+ * \return          `1` if callback is armed, `0` if parameters are invalid or all slots are used
+ */
+uint8_t
+ringbuff_read_async(RINGBUFF_VOLATILE ringbuff_t* buff, size_t n, ringbuff_async_fn cb, void* ctx) {
+    return prv_arm(buff, n, 0, cb, ctx);
+}
+
+/**
+ * \brief           Call `cb` once, when at least `m` bytes are free in `buff`
+ *
+ * Peer consumer must ring doorbell listened by this core after it reads data,
+ * otherwise callback is evaluated only by \ref ringbuff_async_poll from application
+ *
+ * \param[in]       buff: Buffer handle, producer side
+ * \param[in]       m: Number of bytes
+ * \param[in]       cb: Callback
+ * \param[in]       ctx: User context passed to callback
+ * \return          `1` if callback is armed, `0` if parameters are invalid or all slots are used
+ */
+uint8_t
+ringbuff_write_async(RINGBUFF_VOLATILE ringbuff_t* buff, size_t m, ringbuff_async_fn cb, void* ctx) {
+    return prv_arm(buff, m, 1, cb, ctx);
+}
+
+/**
+ * \brief           Cancel all pending callbacks of buffer
+ * \param[in]       buff: Buffer handle
+ */
+void
+ringbuff_async_cancel(RINGBUFF_VOLATILE ringbuff_t* buff) {
+    for (uint32_t idx = 0; idx < RINGBUFF_ASYNC_SLOTS; ++idx) {
+        if ((armed & (1UL << idx)) && slots[idx].buff == buff) {
+            prv_bits(&armed, 0, 1UL << idx);
+            prv_bits(&used, 0, 1UL << idx);
+        }
+    }
+}
+
+/**
+ * \brief           Evaluate pending callbacks and call those with condition met.
+ *                  Called from HSEM interrupt, may be called from application or deferred handler
+ */
+void
+ringbuff_async_poll(void) {
+    RINGBUFF_VOLATILE ringbuff_t* buff;
+    ringbuff_async_slot_t* s;
+    ringbuff_async_fn fn;
+    uint32_t pend = armed, idx, bit, v;
+    size_t len;
+    void* ctx;
+
+    while (pend != 0) {
+        idx = __CLZ(__RBIT(pend));
+        bit = 1UL << idx;
+        pend &= ~bit;
+
+        s = &slots[idx];
+        if ((len = prv_avail(s)) < s->len) {
+            continue;
+        }
+
+        /* Disarm once, context that cleared the bit calls callback */
+        do {
+            v = __LDREXW(&armed);
+            if ((v & bit) == 0) {
+                __CLREX();
+                break;
+            }
+        } while (__STREXW(v & ~bit, &armed) != 0);
+        if ((v & bit) == 0) {
+            continue;
+        }
+        buff = s->buff;
+        fn = s->fn;
+        ctx = s->ctx;
+        prv_bits(&used, 0, bit);                /* Slot is free, callback may arm it again */
+        fn(buff, len, ctx);
+    }
+}
+
+#endif /* IPC_ASYNC */
@@ -0,0 +1,113 @@
+/**
+ * \file            ringbuff_blocking.c
+ * \brief           Blocking ring buffer write and read
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ringbuff_blocking.h"
+#include "ipc_wait.h"
+
+/**
+ * \brief           Sleep until any event or interrupt
+ *
+ * `SEVONPEND` makes interrupt that becomes pending while core sleeps
+ * wake it up, even if interrupt was already handled before `WFE`, event register
+ * stays set and next `WFE` returns immediately. Peer doorbell (HSEM interrupt)
+ * and systick are the usual wake-up sources, latter bounds sleep to `1` tick
+ */
+static void
+prv_wait_event(void) {
+    SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+    __DSB();
+    __WFE();
+}
+
+/**
+ * \brief           Write all data to buffer, sleep while buffer is full
+ *
+ * Consumer core must ring producer doorbell after it frees memory,
+ * see \ref ipc_notify, otherwise writer wakes up on every systick only
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[in]       data: Data to write
+ * \param[in]       btw: Number of bytes to write
+ * \param[in]       timeout_us: Timeout in units of microseconds, `IPC_WAIT_FOREVER` to wait forever
+ * \return          Number of bytes written, less than `btw` on timeout
+ */
+size_t
+ringbuff_write_blocking(RINGBUFF_VOLATILE ringbuff_t* buff, const void* data, size_t btw, uint32_t timeout_us) {
+    const uint8_t* d = data;
+    ipc_wait_t wait;
+    size_t written = 0;
+
+    if (!ringbuff_is_ready(buff) || data == NULL) {
+        return 0;
+    }
+    ipc_wait_start_tick(&wait, timeout_us);
+    while (1) {
+        written += ringbuff_write(buff, &d[written], btw - written);
+        if (written == btw || ipc_wait_expired(&wait)) {
+            break;
+        }
+        prv_wait_event();
+    }
+    return written;
+}
+
+/**
+ * \brief           Read requested number of bytes from buffer, sleep while buffer is empty
+ *
+ * Producer core must ring consumer doorbell after it writes data,
+ * see \ref ipc_notify, otherwise reader wakes up on every systick only
+ *
+ * \param[in]       buff: Buffer handle
+ * \param[out]      data: Memory to read data to
+ * \param[in]       btr: Number of bytes to read
+ * \param[in]       timeout_us: Timeout in units of microseconds, `IPC_WAIT_FOREVER` to wait forever
+ * \return          Number of bytes read, less than `btr` on timeout
+ */
+size_t
+ringbuff_read_blocking(RINGBUFF_VOLATILE ringbuff_t* buff, void* data, size_t btr, uint32_t timeout_us) {
+    uint8_t* d = data;
+    ipc_wait_t wait;
+    size_t read = 0;
+
+    if (!ringbuff_is_ready(buff) || data == NULL) {
+        return 0;
+    }
+    ipc_wait_start_tick(&wait, timeout_us);
+    while (1) {
+        read += ringbuff_read(buff, &d[read], btr - read);
+        if (read == btr || ipc_wait_expired(&wait)) {
+            break;
+        }
+        prv_wait_event();
+    }
+    return read;
+}
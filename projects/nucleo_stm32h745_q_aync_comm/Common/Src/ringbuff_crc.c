@@ -0,0 +1,106 @@
+/**
+ * \file            ringbuff_crc.c
+ * \brief           Message CRC with hardware CRC unit
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "main.h"
+#include "common.h"
+#include "ringbuff_crc.h"
+#include "ipc_notify.h"
+
+#if RINGBUFF_USE_MSG_CRC
+
+_Static_assert(HSEM_CRC < IPC_NOTIFY_SEM_COUNT, "CRC semaphore does not fit to hardware semaphores");
+
+/*
+ * Single CRC unit in D3 domain is shared by both cores, it is taken with HSEM_CRC for one computation.
+ * Interrupts are disabled meanwhile, as semaphore taken by this core reads as taken
+ * for interrupt of the same core too.
+ *
+ * CRC-32 polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no reflection, reset configuration of unit.
+ * Words are fed byte reversed, unit processes words MSB first, CRC is the same as of byte stream
+ * and independent of fragment boundaries.
+ *
+ * Data are fed by CPU, 4 bytes per bus write. DMA does not pay off, consumer needs result
+ * in the same pass before message is delivered
+ */
+
+/**
+ * \brief           Enable CRC unit clock for this core, call once on each core at startup
+ */
+void
+ringbuff_crc_init(void) {
+    __HAL_RCC_CRC_CLK_ENABLE();
+}
+
+/**
+ * \brief           Feed data to CRC unit
+ * \param[in]       data: Data to feed
+ * \param[in]       len: Data length in units of bytes
+ */
+static void
+prv_crc_feed(const uint8_t* data, size_t len) {
+    uint32_t word;
+
+    for (; len >= 4; len -= 4, data += 4) {
+        memcpy(&word, data, sizeof(word));
+        CRC->DR = __REV(word);
+    }
+    for (; len > 0; --len, ++data) {
+        *(volatile uint8_t *)&CRC->DR = *data;
+    }
+}
+
+/**
+ * \brief           Compute CRC of message payload, \ref RINGBUFF_MSG_CRC hook
+ * \param[in]       d1: First fragment
+ * \param[in]       l1: First fragment length in units of bytes
+ * \param[in]       d2: Second fragment, `NULL` when not used
+ * \param[in]       l2: Second fragment length in units of bytes
+ * \return          CRC of both fragments
+ */
+uint32_t
+ringbuff_crc(const void* d1, size_t l1, const void* d2, size_t l2) {
+    uint32_t primask, crc;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    while (HAL_HSEM_FastTake(HSEM_CRC) != HAL_OK) {}
+    CRC->CR = CRC_CR_RESET;
+    prv_crc_feed(d1, l1);
+    if (d2 != NULL) {
+        prv_crc_feed(d2, l2);
+    }
+    crc = CRC->DR;
+    HAL_HSEM_Release(HSEM_CRC, 0);
+    __set_PRIMASK(primask);
+    return crc;
+}
+
+#endif /* RINGBUFF_USE_MSG_CRC */
@@ -0,0 +1,258 @@
+/**
+ * \file            ringbuff_dma.c
+ * \brief           Ring buffer transfers with MDMA
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "ringbuff_dma.h"
+
+/* Maximum MDMA block length in units of bytes */
+#define RINGBUFF_DMA_MAX_BLOCK              0x00010000
+
+#define BUF_DMA_MIN(x, y)                   ((x) < (y) ? (x) : (y))
+
+/**
+ * \brief           Finish transfer, advance buffer pointer and notify application
+ * \param[in]       dma: DMA transfer handle
+ * \param[in]       len: Number of transferred bytes, `0` on error
+ */
+static void
+prv_finish(ringbuff_dma_t* dma, size_t len) {
+    if (len > 0) {
+        if (dma->is_write) {
+            ringbuff_advance(dma->rb, len);
+        } else {
+            ringbuff_skip(dma->rb, len);
+        }
+    }
+    dma->busy = 0;
+    if (dma->done_fn != NULL) {
+        dma->done_fn(dma, len);
+    }
+}
+
+/**
+ * \brief           MDMA transfer complete callback
+ * \param[in]       hmdma: MDMA handle, first member of \ref ringbuff_dma_t
+ */
+static void
+prv_mdma_cplt(MDMA_HandleTypeDef* hmdma) {
+    ringbuff_dma_t* dma = (ringbuff_dma_t *)hmdma;
+
+    /* Start second segment, when data overflow end of buffer */
+    if (dma->len2 > 0) {
+        size_t len2 = dma->len2;
+
+        dma->len2 = 0;
+        if (HAL_MDMA_Start_IT(&dma->hmdma, dma->src2, dma->dst2, len2, 1) != HAL_OK) {
+            prv_finish(dma, 0);
+        }
+        return;
+    }
+    prv_finish(dma, dma->len);
+}
+
+/**
+ * \brief           MDMA transfer error callback
+ * \param[in]       hmdma: MDMA handle, first member of \ref ringbuff_dma_t
+ */
+static void
+prv_mdma_error(MDMA_HandleTypeDef* hmdma) {
+    prv_finish((ringbuff_dma_t *)hmdma, 0);
+}
+
+/**
+ * \brief           Start transfer of up to 2 segments
+ * \param[in]       dma: DMA transfer handle
+ * \param[in]       src1: First segment source address
+ * \param[in]       dst1: First segment destination address
+ * \param[in]       len1: First segment length
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_start(ringbuff_dma_t* dma, const void* src1, void* dst1, size_t len1) {
+    dma->busy = 1;
+    if (HAL_MDMA_Start_IT(&dma->hmdma, (uint32_t)src1, (uint32_t)dst1, len1, 1) != HAL_OK) {
+        dma->busy = 0;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Initialize DMA transfer handle for buffer
+ *
+ * Channel is configured for memory-to-memory transfers with software request.
+ * MDMA interrupt must be enabled by application and its handler
+ * must call `HAL_MDMA_IRQHandler(&dma->hmdma)`
+ *
+ * \param[in]       dma: DMA transfer handle
+ * \param[in]       rb: Buffer handle, already initialized or attached
+ * \param[in]       channel: MDMA channel, for example `MDMA_Channel0`
+ * \param[in]       done_fn: Transfer finished callback. Can be set to `NULL`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_dma_init(ringbuff_dma_t* dma, RINGBUFF_VOLATILE ringbuff_t* rb, MDMA_Channel_TypeDef* channel, ringbuff_dma_done_fn done_fn) {
+    if (dma == NULL || channel == NULL || !ringbuff_is_ready(rb)) {
+        return 0;
+    }
+
+    memset(dma, 0x00, sizeof(*dma));
+    dma->rb = rb;
+    dma->done_fn = done_fn;
+
+    __HAL_RCC_MDMA_CLK_ENABLE();
+    dma->hmdma.Instance = channel;
+    dma->hmdma.Init.Request = MDMA_REQUEST_SW;
+    dma->hmdma.Init.TransferTriggerMode = MDMA_BLOCK_TRANSFER;
+    dma->hmdma.Init.Priority = MDMA_PRIORITY_HIGH;
+    dma->hmdma.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+    dma->hmdma.Init.SourceInc = MDMA_SRC_INC_BYTE;
+    dma->hmdma.Init.DestinationInc = MDMA_DEST_INC_BYTE;
+    dma->hmdma.Init.SourceDataSize = MDMA_SRC_DATASIZE_BYTE;
+    dma->hmdma.Init.DestDataSize = MDMA_DEST_DATASIZE_BYTE;
+    dma->hmdma.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+    dma->hmdma.Init.BufferTransferLength = 128;
+    dma->hmdma.Init.SourceBurst = MDMA_SOURCE_BURST_SINGLE;
+    dma->hmdma.Init.DestBurst = MDMA_DEST_BURST_SINGLE;
+    dma->hmdma.Init.SourceBlockAddressOffset = 0;
+    dma->hmdma.Init.DestBlockAddressOffset = 0;
+    if (HAL_MDMA_Init(&dma->hmdma) != HAL_OK
+        || HAL_MDMA_RegisterCallback(&dma->hmdma, HAL_MDMA_XFER_CPLT_CB_ID, prv_mdma_cplt) != HAL_OK
+        || HAL_MDMA_RegisterCallback(&dma->hmdma, HAL_MDMA_XFER_ERROR_CB_ID, prv_mdma_error) != HAL_OK) {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Write data to buffer with MDMA
+ *
+ * Write pointer is advanced from transfer complete interrupt,
+ * data must stay valid until done callback is called.
+ * No other write may be done to the same buffer while transfer is active
+ *
+ * \param[in]       dma: DMA transfer handle
+ * \param[in]       data: Data to write
+ * \param[in]       btw: Number of bytes to write
+ * \return          Number of bytes accepted for transfer, `0` if busy or buffer full
+ */
+size_t
+ringbuff_write_dma(ringbuff_dma_t* dma, const void* data, size_t btw) {
+    size_t len1;
+
+    if (dma == NULL || data == NULL || btw == 0 || dma->busy) {
+        return 0;
+    }
+
+    /* Short writes are faster with CPU */
+    if (btw < RINGBUFF_DMA_THRESHOLD) {
+        btw = ringbuff_write(dma->rb, data, btw);
+        if (btw > 0 && dma->done_fn != NULL) {
+            dma->done_fn(dma, btw);
+        }
+        return btw;
+    }
+
+    btw = BUF_DMA_MIN(btw, ringbuff_get_free(dma->rb));
+    if (btw == 0) {
+        return 0;
+    }
+    len1 = BUF_DMA_MIN(btw, ringbuff_get_linear_block_write_length(dma->rb));
+    len1 = BUF_DMA_MIN(len1, RINGBUFF_DMA_MAX_BLOCK);
+    btw = BUF_DMA_MIN(btw, len1 + RINGBUFF_DMA_MAX_BLOCK);
+
+    dma->is_write = 1;
+    dma->len = btw;
+    dma->len2 = btw - len1;
+    dma->src2 = (uint32_t)((const uint8_t *)data + len1);
+    dma->dst2 = (uint32_t)dma->rb->buff;
+    if (!prv_start(dma, data, ringbuff_get_linear_block_write_address(dma->rb), len1)) {
+        return 0;
+    }
+    return btw;
+}
+
+/**
+ * \brief           Read data from buffer with MDMA
+ *
+ * Read pointer is advanced from transfer complete interrupt,
+ * data are valid in `data` once done callback is called.
+ * No other read may be done from the same buffer while transfer is active
+ *
+ * \param[in]       dma: DMA transfer handle
+ * \param[out]      data: Memory to read data to
+ * \param[in]       btr: Maximum number of bytes to read
+ * \return          Number of bytes being transferred, `0` if busy or buffer empty
+ */
+size_t
+ringbuff_read_dma(ringbuff_dma_t* dma, void* data, size_t btr) {
+    size_t len1;
+
+    if (dma == NULL || data == NULL || btr == 0 || dma->busy) {
+        return 0;
+    }
+
+    btr = BUF_DMA_MIN(btr, ringbuff_get_full(dma->rb));
+    if (btr == 0) {
+        return 0;
+    }
+
+    /* Short reads are faster with CPU */
+    if (btr < RINGBUFF_DMA_THRESHOLD) {
+        btr = ringbuff_read(dma->rb, data, btr);
+        if (btr > 0 && dma->done_fn != NULL) {
+            dma->done_fn(dma, btr);
+        }
+        return btr;
+    }
+
+    len1 = BUF_DMA_MIN(btr, ringbuff_get_linear_block_read_length(dma->rb));
+    len1 = BUF_DMA_MIN(len1, RINGBUFF_DMA_MAX_BLOCK);
+    btr = BUF_DMA_MIN(btr, len1 + RINGBUFF_DMA_MAX_BLOCK);
+
+    dma->is_write = 0;
+    dma->len = btr;
+    dma->len2 = btr - len1;
+    dma->src2 = (uint32_t)dma->rb->buff;
+    dma->dst2 = (uint32_t)((uint8_t *)data + len1);
+    if (!prv_start(dma, ringbuff_get_linear_block_read_address(dma->rb), data, len1)) {
+        return 0;
+    }
+    return btr;
+}
+
+/**
+ * \brief           Check if transfer is active
+ * \param[in]       dma: DMA transfer handle
+ * \return          `1` if busy, `0` otherwise
+ */
+uint8_t
+ringbuff_dma_is_busy(ringbuff_dma_t* dma) {
+    return dma != NULL && dma->busy;
+}
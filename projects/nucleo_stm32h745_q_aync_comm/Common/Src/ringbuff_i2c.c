@@ -0,0 +1,203 @@
+/**
+ * \file            ringbuff_i2c.c
+ * \brief           Ring buffer I2C sensor acquisition with DMA
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <string.h>
+#include "ringbuff_i2c.h"
+#include "ipc_frec.h"
+
+#ifdef HAL_I2C_MODULE_ENABLED
+
+/*
+ * Each sensor block is one message in buffer, record header followed by register block.
+ * Message payload is reserved with ringbuff_msg_send_reserve before transfer starts,
+ * DMA writes register block directly behind record header and transfer complete interrupt
+ * fills record header and commits message, CPU never copies sensor data.
+ *
+ * Record header is written after transfer finished, cache line shared with DMA data
+ * is not dirty while DMA writes behind cache.
+ * Only when message does not fit linear memory until end of buffer, block is read to stage memory
+ * and copied with ringbuff_msg_send, as reservation is never split
+ */
+
+/**
+ * \brief           Initialize I2C acquisition
+ * \param[in]       acq: Acquisition handle
+ * \param[in]       hi2c: I2C handle, initialized and with RX DMA linked in normal mode
+ * \param[in]       rb: Buffer handle to send records to, already initialized or attached.
+ *                      Acquisition must be its only producer
+ * \param[in]       sensors: Sensor table, must stay valid while acquisition is used
+ * \param[in]       count: Number of sensors in table
+ * \param[in]       done_fn: Scan finished callback. Can be set to `NULL`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_i2c_init(ringbuff_i2c_acq_t* acq, I2C_HandleTypeDef* hi2c, RINGBUFF_VOLATILE ringbuff_t* rb,
+                  const ringbuff_i2c_sensor_t* sensors, size_t count, ringbuff_i2c_done_fn done_fn) {
+    if (acq == NULL || hi2c == NULL || hi2c->hdmarx == NULL || !ringbuff_is_ready(rb)
+        || sensors == NULL || count == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (sensors[i].len == 0 || sensors[i].len > RINGBUFF_I2C_MAX_LEN) {
+            return 0;
+        }
+    }
+    memset(acq, 0x00, sizeof(*acq));
+    acq->hi2c = hi2c;
+    acq->rb = rb;
+    acq->sensors = sensors;
+    acq->count = count;
+    acq->done_fn = done_fn;
+    acq->idx = count;
+    return 1;
+}
+
+/**
+ * \brief           Start transfer of first sensor from current index which can be read.
+ *                  Scan finishes when no sensor is left
+ * \param[in]       acq: Acquisition handle
+ * \return          `1` if transfer is active after call, `0` when scan finished
+ */
+static uint8_t
+prv_read_next(ringbuff_i2c_acq_t* acq) {
+    const ringbuff_i2c_sensor_t* s;
+    uint8_t* dst;
+
+    for (; acq->idx < acq->count; ++acq->idx) {
+        s = &acq->sensors[acq->idx];
+        dst = ringbuff_msg_send_reserve(acq->rb, sizeof(ringbuff_i2c_rec_t) + s->len);
+        if (dst == NULL) {
+            if (ringbuff_get_free(acq->rb) < sizeof(ringbuff_msg_hdr_t) + sizeof(ringbuff_i2c_rec_t) + s->len) {
+                ++acq->dropped;                 /* Buffer is full, sensor is not read */
+#if IPC_FREC
+                ipc_frec_add(IPC_FREC_WORD(acq->idx, IPC_FREC_EVT_DROP, s->len));
+#endif /* IPC_FREC */
+                continue;
+            }
+            dst = acq->stage;
+        }
+#if RINGBUFF_USE_CACHE_MAINT
+        /* Drop cached copy of memory, DMA writes behind cache */
+        else if (acq->rb->cache_maint) {
+            ringbuff_cache_invalidate(acq->rb, (size_t)(dst - (uint8_t *)acq->rb->buff), sizeof(ringbuff_i2c_rec_t) + s->len);
+        }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+        /* Memory is set first, complete interrupt can fire before start function returns */
+        acq->dst = dst;
+        if (HAL_I2C_Mem_Read_DMA(acq->hi2c, (uint16_t)(s->dev_addr << 1), s->reg, s->reg_size,
+                                 &dst[sizeof(ringbuff_i2c_rec_t)], s->len) == HAL_OK) {
+            return 1;
+        }
+        ++acq->errors;
+    }
+    if (acq->done_fn != NULL && acq->scan_records > 0) {
+        acq->done_fn(acq, acq->scan_records);
+    }
+    return 0;
+}
+
+/**
+ * \brief           Start scan of all sensors when acquisition is idle
+ *
+ * Call periodically from thread or timer. Transfers chain automatically
+ * from \ref ringbuff_i2c_cplt until every sensor of table was read once.
+ * Sample of sensor is dropped when buffer is full, scan continues with next sensor.
+ *
+ * \note            Must not be called from interrupt with higher priority than I2C and DMA interrupts
+ * \param[in]       acq: Acquisition handle
+ * \return          `1` if transfer is active after call, `0` if no transfer could be started
+ */
+uint8_t
+ringbuff_i2c_start(ringbuff_i2c_acq_t* acq) {
+    if (acq->idx < acq->count) {
+        return 1;
+    }
+    acq->scan_records = 0;
+    acq->idx = 0;
+    return prv_read_next(acq);
+}
+
+/**
+ * \brief           Commit record of finished transfer and read next sensor.
+ *                  Call from `HAL_I2C_MemRxCpltCallback` for acquisition I2C
+ * \param[in]       acq: Acquisition handle
+ */
+void
+ringbuff_i2c_cplt(ringbuff_i2c_acq_t* acq) {
+    ringbuff_i2c_rec_t rec = {0};
+    size_t len;
+
+    if (acq->idx >= acq->count) {
+        return;
+    }
+    rec.time = HAL_GetTick();
+    rec.id = (uint16_t)acq->idx;
+    len = sizeof(rec) + acq->sensors[acq->idx].len;
+    memcpy(acq->dst, &rec, sizeof(rec));
+    if ((acq->dst == acq->stage ? ringbuff_msg_send(acq->rb, acq->stage, len) : ringbuff_msg_send_commit(acq->rb, len)) > 0) {
+        ++acq->scan_records;
+        ++acq->records;
+    } else {
+        ++acq->dropped;
+#if IPC_FREC
+        ipc_frec_add(IPC_FREC_WORD(acq->idx, IPC_FREC_EVT_DROP, acq->sensors[acq->idx].len));
+#endif /* IPC_FREC */
+    }
+    ++acq->idx;
+    prv_read_next(acq);
+}
+
+/**
+ * \brief           Skip sensor of failed transfer and read next sensor, reserved memory is not committed.
+ *                  Call from `HAL_I2C_ErrorCallback` for acquisition I2C
+ * \param[in]       acq: Acquisition handle
+ */
+void
+ringbuff_i2c_error(ringbuff_i2c_acq_t* acq) {
+    if (acq->idx >= acq->count) {
+        return;
+    }
+    ++acq->errors;
+    ++acq->idx;
+    prv_read_next(acq);
+}
+
+/**
+ * \brief           Check if scan is active
+ * \param[in]       acq: Acquisition handle
+ * \return          `1` if busy, `0` otherwise
+ */
+uint8_t
+ringbuff_i2c_is_busy(ringbuff_i2c_acq_t* acq) {
+    return acq->idx < acq->count;
+}
+
+#endif /* HAL_I2C_MODULE_ENABLED */
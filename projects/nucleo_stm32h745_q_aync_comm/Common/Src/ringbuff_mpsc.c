@@ -0,0 +1,155 @@
+/**
+ * \file            ringbuff_mpsc.c
+ * \brief           Multi-producer ring buffer write
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "ringbuff_mpsc.h"
+
+/*
+ * Producers claim space by advancing reserve pointer in `state` with LDREX/STREX,
+ * copy data in parallel and commit by decrementing producer count.
+ * Producer which brings count to `0` publishes reserve pointer as write pointer,
+ * all space claimed before that moment is filled at that time.
+ *
+ * Write pointer store is done inside exclusive sequence on `state`.
+ * Exception entry and return clear local exclusive monitor, hence if producer
+ * is preempted between the store and STREX, its STREX fails and it publishes
+ * again with latest state. Write pointer therefore never moves backwards.
+ *
+ * Exclusive accesses are only done on core-local `state`,
+ * no global exclusive monitor is needed for shared memory
+ */
+
+#if !RINGBUFF_USE_POW2
+#error "ringbuff_mpsc requires RINGBUFF_USE_POW2"
+#endif /* !RINGBUFF_USE_POW2 */
+
+#define MPSC_CNT_POS                        24
+#define MPSC_CNT_ONE                        (1UL << MPSC_CNT_POS)
+#define MPSC_PTR_MASK                       (MPSC_CNT_ONE - 1)
+#define MPSC_CNT(s)                         ((s) >> MPSC_CNT_POS)
+
+/* Maximum buffer size, difference of 24-bit pointers must be unambiguous */
+#define MPSC_MAX_SIZE                       (MPSC_CNT_ONE >> 1)
+
+/**
+ * \brief           Expand 24-bit pointer to full free-running pointer near reference
+ * \param[in]       ref: Full pointer not further than \ref MPSC_MAX_SIZE from result
+ * \param[in]       ptr: Bits `23:0` of pointer
+ * \return          Full pointer
+ */
+static RINGBUFF_HOT size_t
+prv_expand(size_t ref, uint32_t ptr) {
+    /* Sign-extend 24-bit difference */
+    return ref + (size_t)((int32_t)((ptr - (uint32_t)ref) << (32 - MPSC_CNT_POS)) >> (32 - MPSC_CNT_POS));
+}
+
+/**
+ * \brief           Initialize multi-producer write handle
+ *
+ * Buffer handle must already be initialized or attached
+ * and may not be written by regular write functions afterwards.
+ * Buffer size must not exceed `8MB`
+ *
+ * \param[in]       mpsc: Multi-producer write handle
+ * \param[in]       rb: Producer buffer handle
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_mpsc_init(ringbuff_mpsc_t* mpsc, RINGBUFF_VOLATILE ringbuff_t* rb) {
+    if (mpsc == NULL || !ringbuff_is_ready(rb) || rb->size > MPSC_MAX_SIZE) {
+        return 0;
+    }
+    mpsc->rb = rb;
+    mpsc->state = (uint32_t)rb->shared->w & MPSC_PTR_MASK;
+    return 1;
+}
+
+/**
+ * \brief           Write data to buffer, from thread or interrupt context
+ *
+ * Data are written either in full or not at all,
+ * interrupts are not disabled at any time.
+ * Data become visible to consumer when all producers
+ * which claimed space before have committed
+ *
+ * \param[in]       mpsc: Multi-producer write handle
+ * \param[in]       data: Data to write
+ * \param[in]       btw: Number of bytes to write
+ * \return          Number of bytes written, `btw` on success or `0` if not enough free memory
+ */
+RINGBUFF_HOT size_t
+ringbuff_mpsc_write(ringbuff_mpsc_t* mpsc, const void* data, size_t btw) {
+    RINGBUFF_VOLATILE ringbuff_t* rb = mpsc->rb;
+    const uint8_t* d = data;
+    uint32_t old, new;
+    size_t r, w, off, tocopy;
+
+    if (data == NULL || btw == 0 || btw > rb->size) {
+        return 0;
+    }
+
+    /* Claim space */
+    do {
+        old = __LDREXW(&mpsc->state);
+        r = rb->shared->r;                      /* Inside exclusive sequence, consistent with `old` */
+        __DMB();                                /* Read pointer before data, same as SPSC mode */
+        w = prv_expand(r, old & MPSC_PTR_MASK);
+        if (rb->size - (w - r) < btw) {
+            __CLREX();
+            return 0;
+        }
+        new = (old + MPSC_CNT_ONE) & ~MPSC_PTR_MASK;
+        new |= (uint32_t)(w + btw) & MPSC_PTR_MASK;
+    } while (__STREXW(new, &mpsc->state) != 0);
+
+    /* Copy data, in parallel with other producers */
+    off = w & (rb->size - 1);
+    tocopy = rb->size - off < btw ? rb->size - off : btw;
+    RINGBUFF_MEMCPY(&rb->buff[off], d, tocopy);
+    if (btw > tocopy) {
+        RINGBUFF_MEMCPY(rb->buff, &d[tocopy], btw - tocopy);
+    }
+#if RINGBUFF_USE_CACHE_MAINT
+    if (rb->cache_maint) {
+        ringbuff_cache_clean(rb, w, btw);
+    }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+    /* Commit, last producer publishes write pointer */
+    __DMB();                                    /* Data before write pointer */
+    do {
+        old = __LDREXW(&mpsc->state);
+        new = old - MPSC_CNT_ONE;
+        if (MPSC_CNT(new) == 0) {
+            rb->shared->w = prv_expand(rb->shared->w, new & MPSC_PTR_MASK);
+        }
+    } while (__STREXW(new, &mpsc->state) != 0);
+    return btw;
+}
@@ -0,0 +1,256 @@
+/**
+ * \file            ringbuff_printf.c
+ * \brief           Formatted output directly to ring buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "ringbuff_printf.h"
+
+/*
+ * Characters are formatted directly to free memory of the buffer,
+ * first to linear part at write pointer and then to the beginning of data array.
+ * Write pointer is advanced once at the end, consumer sees complete line or nothing.
+ *
+ * Only producer of the buffer may call formatter functions,
+ * same rules as for \ref ringbuff_write apply
+ */
+
+/**
+ * \brief           Output context, free memory of the buffer
+ */
+typedef struct {
+    uint8_t* addr1;                             /*!< Free memory at write pointer */
+    size_t len1;                                /*!< Length of memory at write pointer */
+    uint8_t* addr2;                             /*!< Free memory at the beginning of data array */
+    size_t len2;                                /*!< Length of memory at the beginning of data array */
+    size_t pos;                                 /*!< Number of characters formatted */
+} ringbuff_printf_ctx_t;
+
+/* Number of lines dropped as buffer did not have enough free memory */
+static uint32_t dropped;
+
+/**
+ * \brief           Put character to free memory, characters beyond free memory are counted only
+ * \param[in]       ctx: Output context
+ * \param[in]       c: Character
+ */
+static void
+prv_putc(ringbuff_printf_ctx_t* ctx, char c) {
+    if (ctx->pos < ctx->len1) {
+        ctx->addr1[ctx->pos] = (uint8_t)c;
+    } else if (ctx->pos - ctx->len1 < ctx->len2) {
+        ctx->addr2[ctx->pos - ctx->len1] = (uint8_t)c;
+    }
+    ++ctx->pos;
+}
+
+/**
+ * \brief           Put string with padding
+ * \param[in]       ctx: Output context
+ * \param[in]       str: String
+ * \param[in]       len: String length
+ * \param[in]       width: Minimum field width
+ * \param[in]       pad: Padding character, `' '` or `'0'`
+ * \param[in]       left: Set to `1` to align left
+ */
+static void
+prv_puts(ringbuff_printf_ctx_t* ctx, const char* str, size_t len, size_t width, char pad, uint8_t left) {
+    size_t fill = width > len ? width - len : 0;
+
+    if (!left) {
+        /* Sign goes before zero padding */
+        if (pad == '0' && len > 0 && *str == '-') {
+            prv_putc(ctx, *str++);
+            --len;
+        }
+        for (; fill > 0; --fill) {
+            prv_putc(ctx, pad);
+        }
+    }
+    while (len-- > 0) {
+        prv_putc(ctx, *str++);
+    }
+    for (; fill > 0; --fill) {
+        prv_putc(ctx, ' ');
+    }
+}
+
+/**
+ * \brief           Format unsigned number to the end of temporary string
+ * \param[in]       end: End of temporary string
+ * \param[in]       num: Number to format
+ * \param[in]       base: Number base, `10` or `16`
+ * \param[in]       digits: Digit characters
+ * \return          Pointer to first character
+ */
+static char*
+prv_utoa(char* end, uint32_t num, uint32_t base, const char* digits) {
+    do {
+        *--end = digits[num % base];
+        num /= base;
+    } while (num > 0);
+    return end;
+}
+
+/**
+ * \brief           Format string directly to buffer and publish it in single write pointer update
+ *
+ * Supported conversions are `%d`, `%i`, `%u`, `%x`, `%X`, `%c`, `%s` and `%%`,
+ * with `-` and `0` flags, field width and ignored `l` length modifier.
+ * Output is dropped in full when buffer does not have enough free memory
+ *
+ * \param[in]       rb: Buffer handle, caller is producer
+ * \param[in]       fmt: Format string
+ * \param[in]       ap: Argument list
+ * \return          Number of bytes written, `0` when dropped
+ */
+size_t
+ringbuff_vprintf(RINGBUFF_VOLATILE ringbuff_t* rb, const char* fmt, va_list ap) {
+    ringbuff_printf_ctx_t ctx;
+    char tmp[11], *str;
+    size_t len, width, free;
+    uint8_t left;
+    char pad;
+
+    if (!ringbuff_is_ready(rb) || fmt == NULL) {
+        return 0;
+    }
+
+    free = ringbuff_get_free(rb);
+    ctx.addr1 = ringbuff_get_linear_block_write_address(rb);
+    ctx.len1 = ringbuff_get_linear_block_write_length(rb);
+    ctx.addr2 = rb->buff;
+    ctx.len2 = free - ctx.len1;
+    ctx.pos = 0;
+
+    for (; *fmt != '\0'; ++fmt) {
+        if (*fmt != '%') {
+            prv_putc(&ctx, *fmt);
+            continue;
+        }
+
+        /* Flags and width */
+        left = 0;
+        pad = ' ';
+        for (++fmt; *fmt == '-' || *fmt == '0'; ++fmt) {
+            if (*fmt == '-') {
+                left = 1;
+            } else {
+                pad = '0';
+            }
+        }
+        for (width = 0; *fmt >= '0' && *fmt <= '9'; ++fmt) {
+            width = width * 10 + (size_t)(*fmt - '0');
+        }
+        if (*fmt == 'l') {
+            ++fmt;                              /* `long` has same size as `int` */
+        }
+        if (left) {
+            pad = ' ';
+        }
+
+        switch (*fmt) {
+            case 'd':
+            case 'i': {
+                int32_t num = va_arg(ap, int32_t);
+
+                str = prv_utoa(&tmp[sizeof(tmp)], num < 0 ? -(uint32_t)num : (uint32_t)num, 10, "0123456789");
+                if (num < 0) {
+                    *--str = '-';
+                }
+                prv_puts(&ctx, str, (size_t)(&tmp[sizeof(tmp)] - str), width, pad, left);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X': {
+                str = prv_utoa(&tmp[sizeof(tmp)], va_arg(ap, uint32_t), *fmt == 'u' ? 10 : 16,
+                                *fmt == 'X' ? "0123456789ABCDEF" : "0123456789abcdef");
+                prv_puts(&ctx, str, (size_t)(&tmp[sizeof(tmp)] - str), width, pad, left);
+                break;
+            }
+            case 'c': {
+                tmp[0] = (char)va_arg(ap, int);
+                prv_puts(&ctx, tmp, 1, width, ' ', left);
+                break;
+            }
+            case 's': {
+                str = va_arg(ap, char*);
+                if (str == NULL) {
+                    str = "(null)";
+                }
+                for (len = 0; str[len] != '\0'; ++len) {}
+                prv_puts(&ctx, str, len, width, ' ', left);
+                break;
+            }
+            case '%': {
+                prv_putc(&ctx, '%');
+                break;
+            }
+            default: {
+                if (*fmt == '\0') {
+                    --fmt;                      /* Incomplete conversion at the end */
+                }
+                break;
+            }
+        }
+    }
+
+    /* Publish complete output at once, or nothing */
+    if (ctx.pos > free) {
+        ++dropped;
+        return 0;
+    }
+    return ringbuff_advance(rb, ctx.pos);
+}
+
+/**
+ * \brief           Format string directly to buffer, see \ref ringbuff_vprintf
+ * \param[in]       rb: Buffer handle, caller is producer
+ * \param[in]       fmt: Format string
+ * \return          Number of bytes written, `0` when dropped
+ */
+size_t
+ringbuff_printf(RINGBUFF_VOLATILE ringbuff_t* rb, const char* fmt, ...) {
+    va_list ap;
+    size_t len;
+
+    va_start(ap, fmt);
+    len = ringbuff_vprintf(rb, fmt, ap);
+    va_end(ap);
+    return len;
+}
+
+/**
+ * \brief           Get number of outputs dropped due to full buffer
+ * \return          Number of dropped outputs since startup
+ */
+uint32_t
+ringbuff_printf_get_dropped(void) {
+    return dropped;
+}
@@ -0,0 +1,183 @@
+/**
+ * \file            ringbuff_rtos.c
+ * \brief           FreeRTOS port layer for ring buffers between cores
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ringbuff_rtos.h"
+#include "ipc_notify.h"
+
+#if IPC_RTOS
+
+/*
+ * Task that cannot complete its operation publishes its handle in `waiter`,
+ * checks buffer once more and blocks on its task notification.
+ * Doorbell arriving between the check and the block is not lost, it increments
+ * notification value and ulTaskNotifyTake returns immediately.
+ *
+ * Without peer doorbell, RINGBUFF_RTOS_NO_SEM, task re-checks buffer every tick
+ */
+
+/**
+ * \brief           Peer doorbell callback, called from HSEM interrupt
+ * \param[in]       sem_id: Semaphore ID
+ * \param[in]       arg: Endpoint
+ */
+static void
+prv_notify(uint32_t sem_id, void* arg) {
+    ringbuff_rtos_t* ep = arg;
+    TaskHandle_t task = ep->waiter;
+    BaseType_t woken = pdFALSE;
+
+    if (task != NULL) {
+        vTaskNotifyGiveFromISR(task, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * \brief           Block current task until peer doorbell or timeout
+ * \param[in]       ep: Endpoint, `waiter` is already set
+ * \param[in]       ticks: Maximum time to block
+ */
+static void
+prv_block(ringbuff_rtos_t* ep, TickType_t ticks) {
+    if (ep->wait_sem == RINGBUFF_RTOS_NO_SEM && ticks > 1) {
+        ticks = 1;
+    }
+    ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+/**
+ * \brief           Initialize blocking endpoint and listen for peer doorbell.
+ *                  One endpoint per doorbell, call from task context before scheduler uses it
+ * \param[in]       ep: Endpoint handle
+ * \param[in]       buff: Buffer handle, channel created or opened by this core
+ * \param[in]       wait_sem: Doorbell rung by peer. Data doorbell for consumer, memory freed doorbell for producer,
+ *                      \ref RINGBUFF_RTOS_NO_SEM when peer does not ring any
+ * \param[in]       ring_sem: Doorbell rung after own write or read, \ref RINGBUFF_RTOS_NO_SEM for none
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_rtos_init(ringbuff_rtos_t* ep, RINGBUFF_VOLATILE ringbuff_t* buff, uint32_t wait_sem, uint32_t ring_sem) {
+    if (ep == NULL || !ringbuff_is_ready(buff)) {
+        return 0;
+    }
+    ep->buff = buff;
+    ep->wait_sem = wait_sem;
+    ep->ring_sem = ring_sem;
+    ep->waiter = NULL;
+    return wait_sem == RINGBUFF_RTOS_NO_SEM || ipc_notify_listen(wait_sem, prv_notify, ep);
+}
+
+/**
+ * \brief           Write all data to buffer, block calling task while buffer is full
+ * \param[in]       ep: Producer endpoint
+ * \param[in]       data: Data to write
+ * \param[in]       btw: Number of bytes to write
+ * \param[in]       timeout: Timeout in units of ticks, `portMAX_DELAY` to wait forever
+ * \return          Number of bytes written, less than `btw` on timeout
+ */
+size_t
+ringbuff_rtos_send(ringbuff_rtos_t* ep, const void* data, size_t btw, TickType_t timeout) {
+    const uint8_t* d = data;
+    TimeOut_t to;
+    size_t written = 0, len;
+
+    if (ep == NULL || data == NULL) {
+        return 0;
+    }
+    vTaskSetTimeOutState(&to);
+    while (1) {
+        len = ringbuff_write(ep->buff, &d[written], btw - written);
+        if (len > 0) {
+            written += len;
+            if (ep->ring_sem != RINGBUFF_RTOS_NO_SEM) {
+                ipc_notify(ep->ring_sem);
+            }
+        }
+        if (written == btw) {
+            break;
+        }
+
+        /* Publish waiter before last check */
+        ep->waiter = xTaskGetCurrentTaskHandle();
+        __DMB();
+        if (ringbuff_get_free(ep->buff) == 0) {
+            if (xTaskCheckForTimeOut(&to, &timeout) != pdFALSE) {
+                ep->waiter = NULL;
+                break;
+            }
+            prv_block(ep, timeout);
+        }
+        ep->waiter = NULL;
+    }
+    return written;
+}
+
+/**
+ * \brief           Read available data from buffer, block calling task while buffer is empty
+ * \param[in]       ep: Consumer endpoint
+ * \param[out]      data: Memory to read data to
+ * \param[in]       size: Size of `data` in units of bytes
+ * \param[in]       timeout: Timeout in units of ticks, `portMAX_DELAY` to wait forever
+ * \return          Number of bytes read, `0` on timeout
+ */
+size_t
+ringbuff_rtos_recv(ringbuff_rtos_t* ep, void* data, size_t size, TickType_t timeout) {
+    TimeOut_t to;
+    size_t len;
+
+    if (ep == NULL || data == NULL || size == 0) {
+        return 0;
+    }
+    vTaskSetTimeOutState(&to);
+    while (1) {
+        if ((len = ringbuff_read(ep->buff, data, size)) > 0) {
+            if (ep->ring_sem != RINGBUFF_RTOS_NO_SEM) {
+                ipc_notify(ep->ring_sem);
+            }
+            return len;
+        }
+
+        /* Publish waiter before last check */
+        ep->waiter = xTaskGetCurrentTaskHandle();
+        __DMB();
+        if (ringbuff_get_full(ep->buff) == 0) {
+            if (xTaskCheckForTimeOut(&to, &timeout) != pdFALSE) {
+                ep->waiter = NULL;
+                return 0;
+            }
+            prv_block(ep, timeout);
+        }
+        ep->waiter = NULL;
+    }
+}
+
+#endif /* IPC_RTOS */
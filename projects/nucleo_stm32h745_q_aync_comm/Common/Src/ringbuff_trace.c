@@ -0,0 +1,75 @@
+/**
+ * \file            ringbuff_trace.c
+ * \brief           Ring buffer event trace over ITM
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "main.h"
+#include "common.h"
+#include "ringbuff_trace.h"
+
+#if RINGBUFF_USE_TRACE
+
+/* Trace bus ID of ITM of this core, unique per trace source in funnel */
+#if defined(CORE_CM7)
+#define RINGBUFF_TRACE_BUS_ID               1
+#else
+#define RINGBUFF_TRACE_BUS_ID               2
+#endif
+
+/* Stimulus ports of this core */
+#if RINGBUFF_TRACE_STAMP
+#define RINGBUFF_TRACE_PORTS                (3UL << RINGBUFF_TRACE_PORT)
+#else
+#define RINGBUFF_TRACE_PORTS                (1UL << RINGBUFF_TRACE_PORT)
+#endif /* RINGBUFF_TRACE_STAMP */
+
+volatile uint32_t ringbuff_trace_drops;
+
+/**
+ * \brief           Enable ITM of current core and its trace event ports.
+ *
+ * ITM is enabled with local timestamps in core cycles and synchronization packets.
+ * SWO pin, SWO prescaler and trace funnel are configured by trace tool
+ * (Orbuculum, SEGGER SystemView, STM32CubeIDE SWV), events are dropped by hardware until then
+ */
+void
+ringbuff_trace_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if defined(CORE_CM7)
+    ITM->LAR = 0xC5ACCE55;                      /* Unlock ITM registers on Cortex-M7 */
+#endif /* defined(CORE_CM7) */
+#if RINGBUFF_TRACE_STAMP
+    CYCCNT_INIT();
+#endif /* RINGBUFF_TRACE_STAMP */
+    ITM->TCR = (RINGBUFF_TRACE_BUS_ID << ITM_TCR_TraceBusID_Pos) | ITM_TCR_SYNCENA_Msk
+                | ITM_TCR_TSENA_Msk | ITM_TCR_ITMENA_Msk;
+    ITM->TER |= RINGBUFF_TRACE_PORTS;
+    ringbuff_trace_drops = 0;
+}
+
+#endif /* RINGBUFF_USE_TRACE */
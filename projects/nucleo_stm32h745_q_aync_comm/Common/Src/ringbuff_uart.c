@@ -0,0 +1,372 @@
+/**
+ * \file            ringbuff_uart.c
+ * \brief           Ring buffer UART transfers with DMA
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include "ringbuff_uart.h"
+
+#ifdef HAL_UART_MODULE_ENABLED
+
+/* Maximum DMA stream transfer length in units of bytes */
+#define RINGBUFF_UART_MAX_LEN               0x0000FFFF
+
+/**
+ * \brief           Initialize UART transmitter
+ * \param[in]       tx: UART transmitter handle
+ * \param[in]       huart: UART handle, initialized and with TX DMA linked
+ * \param[in]       rb: Buffer handle to send data from, already initialized or attached
+ * \param[in]       done_fn: Data sent callback. Can be set to `NULL`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_uart_tx_init(ringbuff_uart_tx_t* tx, UART_HandleTypeDef* huart, RINGBUFF_VOLATILE ringbuff_t* rb, ringbuff_uart_tx_done_fn done_fn) {
+    if (tx == NULL || huart == NULL || huart->hdmatx == NULL || !ringbuff_is_ready(rb)) {
+        return 0;
+    }
+    tx->huart = huart;
+    tx->rb = rb;
+    tx->done_fn = done_fn;
+    tx->len = 0;
+    tx->batch_len = 0;
+    tx->batch_pending = 0;
+    return 1;
+}
+
+/**
+ * \brief           Set batching of small writes into single transfer.
+ *
+ * Pending data shorter than `len` are held back until more data arrive,
+ * until `deadline_us` elapsed since batch opened or until no new data arrived for `idle_us`.
+ * Fewer, longer transfers need fewer DMA setups and interrupts, latency stays below deadline
+ * as long as \ref ringbuff_uart_tx_poll is called often enough.
+ *
+ * \note            Call before first transfer or while transmitter is idle
+ * \param[in]       tx: UART transmitter handle
+ * \param[in]       len: Pending length which starts transfer at once. Set to `0` to send every block
+ * \param[in]       deadline_us: Maximum time first held back byte waits, in units of microseconds
+ * \param[in]       idle_us: Time without new data which sends batch, in units of microseconds
+ */
+void
+ringbuff_uart_tx_set_batch(ringbuff_uart_tx_t* tx, size_t len, uint32_t deadline_us, uint32_t idle_us) {
+    tx->batch_len = len;
+    tx->batch_deadline_us = deadline_us;
+    tx->batch_idle_us = idle_us;
+    tx->batch_pending = 0;
+}
+
+/**
+ * \brief           Check if pending data shall wait for batch to fill
+ * \param[in]       tx: UART transmitter handle
+ * \param[in]       full: Number of bytes pending in buffer, greater than `0`
+ * \return          `1` to hold data back, `0` to send now
+ */
+static uint8_t
+prv_tx_batch_hold(ringbuff_uart_tx_t* tx, size_t full) {
+    if (full >= tx->batch_len) {
+        return 0;
+    }
+    if (tx->batch_pending == 0) {
+        /* First data of new batch */
+        ipc_wait_start(&tx->batch_deadline, tx->batch_deadline_us);
+        ipc_wait_start(&tx->batch_idle, tx->batch_idle_us);
+    } else if (full != tx->batch_pending) {
+        /* Producer is still writing, idle time starts again */
+        ipc_wait_start(&tx->batch_idle, tx->batch_idle_us);
+    } else if (ipc_wait_expired(&tx->batch_idle)) {
+        return 0;
+    }
+    tx->batch_pending = full;
+    return !ipc_wait_expired(&tx->batch_deadline);
+}
+
+/**
+ * \brief           Start sending linear block of data when transmitter is idle
+ *
+ * Call from thread when new data were written to buffer,
+ * for example from doorbell notification. Transfers chain automatically
+ * from \ref ringbuff_uart_tx_cplt until buffer is empty.
+ * With batching, see \ref ringbuff_uart_tx_set_batch, short data may be held back
+ * and are sent by later call or by \ref ringbuff_uart_tx_poll.
+ *
+ * \note            Must not be called from interrupt with higher priority than UART interrupt
+ * \param[in]       tx: UART transmitter handle
+ * \return          `1` if transfer is active after call, `0` if buffer is empty, data are held back
+ *                      or DMA failed to start
+ */
+uint8_t
+ringbuff_uart_tx_start(ringbuff_uart_tx_t* tx) {
+    size_t len;
+
+    if (tx->len > 0) {
+        return 1;
+    }
+    if (tx->batch_len > 0) {
+        len = ringbuff_get_full(tx->rb);
+        if (len == 0) {
+            tx->batch_pending = 0;
+            return 0;
+        }
+        if (prv_tx_batch_hold(tx, len)) {
+            return 0;
+        }
+        tx->batch_pending = 0;
+    }
+    len = ringbuff_get_linear_block_read_length(tx->rb);
+    if (len == 0) {
+        return 0;
+    }
+    if (len > RINGBUFF_UART_MAX_LEN) {
+        len = RINGBUFF_UART_MAX_LEN;
+    }
+
+    /* Length is set first, complete interrupt can fire before start function returns */
+    tx->len = len;
+    if (HAL_UART_Transmit_DMA(tx->huart, ringbuff_get_linear_block_read_address(tx->rb), (uint16_t)len) != HAL_OK) {
+        tx->len = 0;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Send batch held back by \ref ringbuff_uart_tx_start once it is due.
+ *                  Call from thread loop while batching is enabled
+ * \param[in]       tx: UART transmitter handle
+ * \return          `1` if transfer is active after call, `0` otherwise
+ */
+uint8_t
+ringbuff_uart_tx_poll(ringbuff_uart_tx_t* tx) {
+    if (tx->len > 0) {
+        return 1;
+    }
+    if (tx->batch_pending == 0) {
+        return 0;
+    }
+    return ringbuff_uart_tx_start(tx);
+}
+
+/**
+ * \brief           Release sent data and send next block.
+ *                  Call from `HAL_UART_TxCpltCallback` for transmitter UART
+ * \param[in]       tx: UART transmitter handle
+ */
+void
+ringbuff_uart_tx_cplt(ringbuff_uart_tx_t* tx) {
+    size_t len = tx->len;
+
+    if (len == 0) {
+        return;
+    }
+    ringbuff_skip(tx->rb, len);
+    tx->len = 0;
+    if (tx->done_fn != NULL) {
+        tx->done_fn(tx, len);
+    }
+    ringbuff_uart_tx_start(tx);
+}
+
+/**
+ * \brief           Restart transfer after error, data stay in buffer.
+ *                  Call from `HAL_UART_ErrorCallback` for transmitter UART
+ * \param[in]       tx: UART transmitter handle
+ */
+void
+ringbuff_uart_tx_error(ringbuff_uart_tx_t* tx) {
+    if (tx->huart->gState != HAL_UART_STATE_READY) {
+        return;                                 /* Error of receiver, transfer is still active */
+    }
+    tx->len = 0;
+    ringbuff_uart_tx_start(tx);
+}
+
+/**
+ * \brief           Check if transfer is active
+ * \param[in]       tx: UART transmitter handle
+ * \return          `1` if busy, `0` otherwise
+ */
+uint8_t
+ringbuff_uart_tx_is_busy(ringbuff_uart_tx_t* tx) {
+    return tx->len > 0;
+}
+
+/**
+ * \brief           Initialize UART receiver
+ * \param[in]       rx: UART receiver handle
+ * \param[in]       huart: UART handle, initialized and with RX DMA linked in normal mode
+ * \param[in]       rb: Buffer handle to receive data to, already initialized or attached
+ * \param[in]       done_fn: Data received callback. Can be set to `NULL`
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+ringbuff_uart_rx_init(ringbuff_uart_rx_t* rx, UART_HandleTypeDef* huart, RINGBUFF_VOLATILE ringbuff_t* rb, ringbuff_uart_rx_done_fn done_fn) {
+    if (rx == NULL || huart == NULL || huart->hdmarx == NULL || !ringbuff_is_ready(rb)) {
+        return 0;
+    }
+    rx->huart = huart;
+    rx->rb = rb;
+    rx->done_fn = done_fn;
+    rx->len = 0;
+    rx->pos = 0;
+    return 1;
+}
+
+/**
+ * \brief           Commit bytes DMA wrote since last commit and notify consumer
+ * \param[in]       rx: UART receiver handle
+ */
+static void
+prv_rx_commit(ringbuff_uart_rx_t* rx) {
+    size_t recv, len;
+
+    if (rx->len == 0) {
+        return;
+    }
+    recv = rx->len - __HAL_DMA_GET_COUNTER(rx->huart->hdmarx);
+    if (recv > rx->pos) {
+        len = recv - rx->pos;
+        rx->pos = recv;
+        ringbuff_advance(rx->rb, len);
+        if (rx->done_fn != NULL) {
+            rx->done_fn(rx, len);
+        }
+    }
+}
+
+/**
+ * \brief           Start receiving to linear block of free memory when receiver is idle
+ *
+ * DMA writes directly to buffer memory, received bytes are committed
+ * with \ref ringbuff_advance on DMA half-transfer, transfer complete and UART idle line events.
+ * Next block is started from transfer complete interrupt.
+ *
+ * Transfer never covers memory not yet released by consumer.
+ * When buffer is full at the end of block, reception pauses
+ * and must be resumed by calling this function after consumer read data.
+ *
+ * \note            Must not be called from interrupt with higher priority than UART interrupt
+ * \param[in]       rx: UART receiver handle
+ * \return          `1` if transfer is active after call, `0` if buffer is full or DMA failed to start
+ */
+uint8_t
+ringbuff_uart_rx_start(ringbuff_uart_rx_t* rx) {
+    uint8_t* addr;
+    size_t len;
+
+    if (rx->len > 0) {
+        return 1;
+    }
+    len = ringbuff_get_linear_block_write_length(rx->rb);
+    if (len == 0) {
+        return 0;
+    }
+    if (len > RINGBUFF_UART_MAX_LEN) {
+        len = RINGBUFF_UART_MAX_LEN;
+    }
+    addr = ringbuff_get_linear_block_write_address(rx->rb);
+#if RINGBUFF_USE_CACHE_MAINT
+    /* Drop cached copy of memory, DMA writes behind cache */
+    if (rx->rb->cache_maint) {
+        ringbuff_cache_invalidate(rx->rb, (size_t)(addr - (uint8_t *)rx->rb->buff), len);
+    }
+#endif /* RINGBUFF_USE_CACHE_MAINT */
+
+    /* Length is set first, half-transfer interrupt can fire before start function returns */
+    rx->pos = 0;
+    rx->len = len;
+    if (HAL_UART_Receive_DMA(rx->huart, addr, (uint16_t)len) != HAL_OK) {
+        rx->len = 0;
+        return 0;
+    }
+    __HAL_UART_CLEAR_IDLEFLAG(rx->huart);
+    __HAL_UART_ENABLE_IT(rx->huart, UART_IT_IDLE);
+    return 1;
+}
+
+/**
+ * \brief           Commit first half of block.
+ *                  Call from `HAL_UART_RxHalfCpltCallback` for receiver UART
+ * \param[in]       rx: UART receiver handle
+ */
+void
+ringbuff_uart_rx_half_cplt(ringbuff_uart_rx_t* rx) {
+    prv_rx_commit(rx);
+}
+
+/**
+ * \brief           Commit rest of block and receive to next one.
+ *                  Call from `HAL_UART_RxCpltCallback` for receiver UART
+ * \param[in]       rx: UART receiver handle
+ */
+void
+ringbuff_uart_rx_cplt(ringbuff_uart_rx_t* rx) {
+    prv_rx_commit(rx);
+    rx->len = 0;
+    ringbuff_uart_rx_start(rx);
+}
+
+/**
+ * \brief           Handle UART idle line event, commits bytes received so far.
+ *                  Call from UART interrupt handler, before `HAL_UART_IRQHandler`
+ * \param[in]       rx: UART receiver handle
+ */
+void
+ringbuff_uart_rx_irq(ringbuff_uart_rx_t* rx) {
+    if (__HAL_UART_GET_FLAG(rx->huart, UART_FLAG_IDLE)
+        && __HAL_UART_GET_IT_SOURCE(rx->huart, UART_IT_IDLE)) {
+        __HAL_UART_CLEAR_IDLEFLAG(rx->huart);
+        prv_rx_commit(rx);
+    }
+}
+
+/**
+ * \brief           Commit received bytes and restart reception after error.
+ *                  Call from `HAL_UART_ErrorCallback` for receiver UART
+ * \param[in]       rx: UART receiver handle
+ */
+void
+ringbuff_uart_rx_error(ringbuff_uart_rx_t* rx) {
+    if (rx->huart->RxState != HAL_UART_STATE_READY) {
+        return;                                 /* Error of transmitter, reception is still active */
+    }
+    __HAL_UART_DISABLE_IT(rx->huart, UART_IT_IDLE);
+    prv_rx_commit(rx);
+    rx->len = 0;
+    ringbuff_uart_rx_start(rx);
+}
+
+/**
+ * \brief           Check if reception is active
+ * \param[in]       rx: UART receiver handle
+ * \return          `1` if busy, `0` when paused on full buffer
+ */
+uint8_t
+ringbuff_uart_rx_is_busy(ringbuff_uart_rx_t* rx) {
+    return rx->len > 0;
+}
+
+#endif /* HAL_UART_MODULE_ENABLED */
@@ -0,0 +1,15 @@
+#
+# Encode binary INPUT as records of channel 5 with TOOL, decode channel 5 back and compare with INPUT
+#
+execute_process(COMMAND ${TOOL} -e 5 INPUT_FILE ${INPUT} OUTPUT_FILE ${WORK}/roundtrip.cobs RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Encoder failed")
+endif()
+execute_process(COMMAND ${TOOL} -c 5 INPUT_FILE ${WORK}/roundtrip.cobs OUTPUT_FILE ${WORK}/roundtrip.bin RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Decoder failed")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${INPUT} ${WORK}/roundtrip.bin RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Decoded data differ from input")
+endif()
@@ -0,0 +1,171 @@
+/**
+ * \file            ipc_cobs_tool.c
+ * \brief           Host demultiplexer of COBS framed UART stream
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ipc_cobs.h"
+
+/*
+ * Demultiplex USART3 capture of CPU1 forwarder with IPC_COBS enabled:
+ *
+ *   ipc_cobs_tool -d chan_ < capture.bin      Data of channel n to file chan_<n>.bin
+ *   ipc_cobs_tool -c 0 < capture.bin          Data of channel 0 to standard output
+ *
+ * Decoder reads standard input in large blocks and splits it on delimiters,
+ * it keeps up with any UART rate. Corrupted frames are counted and reported to stderr.
+ * Option -e n encodes standard input as records of channel n, for tests
+ */
+
+/* Number of channel IDs, one byte tag */
+#define CHAN_COUNT                          256
+
+static FILE* chan_out[CHAN_COUNT];
+static unsigned long chan_frames[CHAN_COUNT];
+
+/**
+ * \brief           Encode standard input as records of one channel
+ * \param[in]       id: Channel ID
+ * \return          `0` on success
+ */
+static int
+prv_encode(uint8_t id) {
+    static uint8_t in[IPC_COBS_DATA_MAX], out[IPC_COBS_FRAME_MAX];
+    ipc_cobs_enc_t enc;
+    size_t len;
+
+    while ((len = fread(in, 1, sizeof(in), stdin)) > 0) {
+        ipc_cobs_enc_begin(&enc, out);
+        ipc_cobs_enc_put(&enc, &id, 1);
+        ipc_cobs_enc_put(&enc, in, len);
+        fwrite(out, 1, ipc_cobs_enc_end(&enc), stdout);
+    }
+    return 0;
+}
+
+/**
+ * \brief           Write record to output of its channel
+ * \param[in]       rec: Decoded record, channel ID and data
+ * \param[in]       len: Record length in units of bytes
+ * \param[in]       prefix: File name prefix, `NULL` for standard output of single channel
+ * \param[in]       only: Channel written to standard output
+ */
+static void
+prv_record(const uint8_t* rec, size_t len, const char* prefix, int only) {
+    uint8_t id = rec[0];
+
+    ++chan_frames[id];
+    if (prefix == NULL) {
+        if (id == only) {
+            fwrite(&rec[1], 1, len - 1, stdout);
+        }
+        return;
+    }
+    if (chan_out[id] == NULL) {
+        char name[256];
+
+        snprintf(name, sizeof(name), "%s%u.bin", prefix, (unsigned)id);
+        if ((chan_out[id] = fopen(name, "wb")) == NULL) {
+            perror(name);
+            exit(1);
+        }
+    }
+    fwrite(&rec[1], 1, len - 1, chan_out[id]);
+}
+
+/**
+ * \brief           Split standard input on delimiters and decode frames
+ * \param[in]       prefix: File name prefix, `NULL` for standard output of single channel
+ * \param[in]       only: Channel written to standard output
+ * \return          `0` on success, `1` when corrupted frames were found
+ */
+static int
+prv_decode(const char* prefix, int only) {
+    static uint8_t buf[256 * 1024], frame[IPC_COBS_FRAME_MAX], rec[1 + IPC_COBS_DATA_MAX];
+    size_t len, flen = 0, bad = 0, total = 0;
+    uint8_t overrun = 0;
+    int32_t n;
+
+    while ((len = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+        for (size_t i = 0; i < len; ++i) {
+            if (buf[i] != IPC_COBS_DELIM) {
+                if (flen < sizeof(frame)) {
+                    frame[flen++] = buf[i];
+                } else {
+                    overrun = 1;
+                }
+                continue;
+            }
+            /* Delimiter, frame is complete. Empty frame is delimiter of resynchronizing sender */
+            if (flen > 0) {
+                n = overrun ? -1 : ipc_cobs_decode(frame, flen, rec, sizeof(rec));
+                if (n < 1) {
+                    ++bad;
+                } else {
+                    prv_record(rec, (size_t)n, prefix, only);
+                    ++total;
+                }
+            }
+            flen = 0;
+            overrun = 0;
+        }
+    }
+    if (flen > 0) {
+        ++bad;                                  /* Capture ended inside frame */
+    }
+
+    for (size_t i = 0; i < CHAN_COUNT; ++i) {
+        if (chan_frames[i] > 0) {
+            fprintf(stderr, "channel %u: %lu records\n", (unsigned)i, chan_frames[i]);
+        }
+        if (chan_out[i] != NULL) {
+            fclose(chan_out[i]);
+        }
+    }
+    if (bad > 0) {
+        fprintf(stderr, "%lu records, %lu corrupted frames\n", (unsigned long)total, (unsigned long)bad);
+    }
+    return bad > 0;
+}
+
+int
+main(int argc, char* argv[]) {
+    if (argc == 3 && strcmp(argv[1], "-e") == 0) {
+        return prv_encode((uint8_t)atoi(argv[2]));
+    }
+    if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+        return prv_decode(NULL, atoi(argv[2]));
+    }
+    if (argc == 3 && strcmp(argv[1], "-d") == 0) {
+        return prv_decode(argv[2], -1);
+    }
+    fprintf(stderr, "Usage: %s -d prefix | -c channel | -e channel < input\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,25 @@
+#
+# Write image of synthetic recorder with TOOL, decode it and check printed events
+#
+execute_process(COMMAND ${TOOL} -s ${WORK}/frec.bin RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Snapshot failed")
+endif()
+execute_process(COMMAND ${TOOL} ${WORK}/frec.bin OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Decode failed")
+endif()
+if(NOT out MATCHES "cpu1 boots 2 reset 0x0140 count 1500 mark 1400 events 1020\n" OR NOT out MATCHES "cpu2 no ring")
+    message(FATAL_ERROR "Headers not decoded:\n${out}")
+endif()
+if(NOT out MATCHES "\n   -920 +4800 write +id +0 len 224\n" OR NOT out MATCHES "\n +\\+0 +14000 boot +id +2 len 320\n"
+   OR NOT out MATCHES "\n +\\+99 +14990 read +id +3 len 219\ncpu2")
+    message(FATAL_ERROR "Wrapped ring not decoded:\n${out}")
+endif()
+execute_process(COMMAND ${TOOL} -n 2 ${WORK}/frec.bin OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Decode of last events failed")
+endif()
+if(NOT out MATCHES "events 1020\n +-2 +13980 doorbell +id +6 len 118\n +-1 +13990 read +id +7 len 119\ncpu2")
+    message(FATAL_ERROR "Last events before boot not decoded:\n${out}")
+endif()
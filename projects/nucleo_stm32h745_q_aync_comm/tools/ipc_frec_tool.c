@@ -0,0 +1,182 @@
+/**
+ * \file            ipc_frec_tool.c
+ * \brief           Host decoder of flight recorder memory image
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "ipc_frec.h"
+
+/*
+ * Decode flight recorder (IPC_FREC enabled) from memory image, after crash or warm reset:
+ *
+ *   ipc_frec_tool frec.bin                     All events of both rings, oldest first
+ *   ipc_frec_tool -n 32 frec.bin               Last 32 events before current boot of each core
+ *
+ * Image is IPC_FREC_LEN bytes from IPC_FREC_ADDR, read for example with OpenOCD
+ * `dump_image frec.bin 0x3800C000 0x4000`, without reset of target.
+ * Event index is relative to boot mark, events of previous boots are negative.
+ * Option -s file writes image of synthetic recorder, for tests
+ */
+
+/* Synthetic recorder: CPU1 ring wrapped, current boot started at event SNAP_MARK, CPU2 ring not valid */
+#define SNAP_COUNT                          1500
+#define SNAP_MARK                           1400
+#define SNAP_BOOTS                          2
+#define SNAP_RSR                            0x01400000
+
+/* Event names, indexed by event */
+static const char* const evt_names[16] = {
+    [IPC_FREC_EVT_READ] = "read",
+    [IPC_FREC_EVT_WRITE] = "write",
+    [IPC_FREC_EVT_RESET] = "reset",
+    [IPC_FREC_EVT_NOTIFY] = "notify",
+    [IPC_FREC_EVT_DOORBELL] = "doorbell",
+    [IPC_FREC_EVT_DROP] = "drop",
+    [IPC_FREC_EVT_BOOT] = "boot",
+};
+
+/**
+ * \brief           Print ring of one core
+ * \param[in]       core: Core index
+ * \param[in]       ring: Ring from image
+ * \param[in]       last: Number of events before boot mark to print, `0` for all events
+ */
+static void
+prv_print(uint32_t core, const ipc_frec_ring_t* ring, long last) {
+    uint32_t count = ring->hdr.count, mark = ring->hdr.mark, avail, first;
+    const ipc_frec_entry_t* e;
+    char evt[16];
+
+    if (ring->hdr.magic != IPC_FREC_MAGIC || ring->hdr.version != IPC_FREC_VERSION
+        || ring->hdr.entries != IPC_FREC_ENTRIES || count >= IPC_FREC_WRAP || mark >= IPC_FREC_WRAP) {
+        printf("cpu%u no ring\n", (unsigned)core + 1);
+        return;
+    }
+    avail = count < IPC_FREC_ENTRIES ? count : (uint32_t)IPC_FREC_ENTRIES;
+    printf("cpu%u boots %u reset 0x%04X count %u mark %u events %u\n", (unsigned)core + 1,
+           (unsigned)ring->hdr.boots, (unsigned)(ring->hdr.rsr >> 16), (unsigned)count, (unsigned)mark, (unsigned)avail);
+
+    /* Absolute indexes are not continuous over counter wrap, printed index is relative to mark */
+    first = count - avail;
+    if (last > 0) {
+        if (mark < first || mark > count) {
+            return;                             /* Events before mark were overwritten */
+        }
+        if ((uint32_t)last < mark - first) {
+            first = mark - (uint32_t)last;
+        }
+        count = mark;
+    }
+    for (uint32_t pos = first; pos != count; ++pos) {
+        e = &ring->entry[pos % IPC_FREC_ENTRIES];
+        if (evt_names[IPC_FREC_WORD_EVT(e->word)] != NULL) {
+            snprintf(evt, sizeof(evt), "%s", evt_names[IPC_FREC_WORD_EVT(e->word)]);
+        } else {
+            snprintf(evt, sizeof(evt), "evt%u", (unsigned)IPC_FREC_WORD_EVT(e->word));
+        }
+        printf("%+7ld %10u %-8s id %3u len %u\n", (long)pos - (long)mark, (unsigned)e->stamp, evt,
+               (unsigned)IPC_FREC_WORD_ID(e->word), (unsigned)IPC_FREC_WORD_LEN(e->word));
+    }
+}
+
+/**
+ * \brief           Write image of synthetic recorder
+ * \param[in]       name: File name
+ * \return          `0` on success
+ */
+static int
+prv_snapshot(const char* name) {
+    static uint8_t img[IPC_FREC_LEN];
+    static const uint32_t evts[] = { IPC_FREC_EVT_WRITE, IPC_FREC_EVT_NOTIFY, IPC_FREC_EVT_DOORBELL, IPC_FREC_EVT_READ };
+    ipc_frec_ring_t* ring = (ipc_frec_ring_t *)img;
+    FILE* f;
+
+    ring->hdr.magic = IPC_FREC_MAGIC;
+    ring->hdr.version = IPC_FREC_VERSION;
+    ring->hdr.entries = IPC_FREC_ENTRIES;
+    ring->hdr.count = SNAP_COUNT;
+    ring->hdr.mark = SNAP_MARK;
+    ring->hdr.boots = SNAP_BOOTS;
+    ring->hdr.rsr = SNAP_RSR;
+    for (uint32_t pos = 0; pos < SNAP_COUNT; ++pos) {
+        ring->entry[pos % IPC_FREC_ENTRIES].stamp = pos * 10;
+        if (pos == SNAP_MARK) {
+            ring->entry[pos % IPC_FREC_ENTRIES].word = IPC_FREC_WORD(SNAP_BOOTS, IPC_FREC_EVT_BOOT, SNAP_RSR >> 16);
+        } else {
+            ring->entry[pos % IPC_FREC_ENTRIES].word = IPC_FREC_WORD(pos & 0x07, evts[pos & 0x03], pos & 0xFF);
+        }
+    }
+
+    if ((f = fopen(name, "wb")) == NULL) {
+        perror(name);
+        return 1;
+    }
+    fwrite(img, 1, sizeof(img), f);
+    fclose(f);
+    return 0;
+}
+
+int
+main(int argc, char* argv[]) {
+    static uint8_t img[IPC_FREC_LEN];
+    long last = 0;
+    FILE* f;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': last = strtol(optarg, NULL, 0); break;
+            case 's': return prv_snapshot(optarg);
+            default:
+                fprintf(stderr, "Usage: %s [-n last] frec.bin | -s frec.bin\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Usage: %s [-n last] frec.bin | -s frec.bin\n", argv[0]);
+        return 2;
+    }
+    if ((f = fopen(argv[optind], "rb")) == NULL) {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (fread(img, 1, sizeof(img), f) != sizeof(img)) {
+        fprintf(stderr, "Image is shorter than recorder, %u bytes\n", (unsigned)IPC_FREC_LEN);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+    for (uint32_t core = IPC_FREC_CPU1; core <= IPC_FREC_CPU2; ++core) {
+        prv_print(core, (const ipc_frec_ring_t *)&img[core * sizeof(ipc_frec_ring_t)], last);
+    }
+    return 0;
+}
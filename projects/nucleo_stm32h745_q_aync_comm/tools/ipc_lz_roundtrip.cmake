@@ -0,0 +1,15 @@
+#
+# Encode INPUT with TOOL, decode it back and compare with INPUT
+#
+execute_process(COMMAND ${TOOL} -c INPUT_FILE ${INPUT} OUTPUT_FILE ${WORK}/roundtrip.lz RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Encoder failed")
+endif()
+execute_process(COMMAND ${TOOL} -d INPUT_FILE ${WORK}/roundtrip.lz OUTPUT_FILE ${WORK}/roundtrip.txt RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Decoder failed")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${INPUT} ${WORK}/roundtrip.txt RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Decoded data differ from input")
+endif()
@@ -0,0 +1,126 @@
+/**
+ * \file            ipc_lz_tool.c
+ * \brief           Host encoder and decoder of compressed UART stream
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <string.h>
+#include "ipc_lz.h"
+
+/*
+ * Decode USART3 capture of CPU1 forwarder with IPC_LZ enabled:
+ *
+ *   ipc_lz_tool -d < capture.bin > telemetry.txt
+ *
+ * Decoder skips bytes until valid frame header and waits for key frame,
+ * capture may start anywhere in stream. Corrupted frames are reported to stderr.
+ * Option -c encodes standard input with the same codec, for tests
+ */
+
+static ipc_lz_enc_t enc;
+static ipc_lz_dec_t dec;
+
+/**
+ * \brief           Encode standard input to frames
+ * \return          `0` on success
+ */
+static int
+prv_encode(void) {
+    uint8_t in[IPC_LZ_FRAME_MAX], out[IPC_LZ_OUT_MAX];
+    size_t len;
+
+    ipc_lz_enc_init(&enc);
+    while ((len = fread(in, 1, sizeof(in), stdin)) > 0) {
+        ipc_lz_enc_write(&enc, in, len);
+        len = ipc_lz_enc_flush(&enc, out);
+        fwrite(out, 1, len, stdout);
+    }
+    fprintf(stderr, "%lu bytes in, %lu bytes out\n", (unsigned long)enc.bytes_in, (unsigned long)enc.bytes_out);
+    return 0;
+}
+
+/**
+ * \brief           Decode frames of standard input
+ * \return          `0` on success, `1` when corrupted frames were found
+ */
+static int
+prv_decode(void) {
+    static uint8_t buf[64 * 1024];
+    uint8_t out[IPC_LZ_FRAME_MAX];
+    size_t len = 0, pos = 0, flen, skipped = 0, bad = 0;
+    int32_t n;
+
+    ipc_lz_dec_init(&dec);
+    for (;;) {
+        /* Keep unparsed tail and refill buffer */
+        memmove(buf, &buf[pos], len - pos);
+        len -= pos;
+        pos = 0;
+        flen = fread(&buf[len], 1, sizeof(buf) - len, stdin);
+        if (flen == 0) {
+            break;
+        }
+        len += flen;
+
+        while (len - pos >= IPC_LZ_HDR_LEN) {
+            flen = ipc_lz_frame_len(&buf[pos]);
+            if (flen == 0) {
+                ++pos;                          /* Not a header, resynchronize */
+                ++skipped;
+                continue;
+            }
+            if (len - pos < flen) {
+                break;                          /* Wait for rest of frame */
+            }
+            n = ipc_lz_dec_frame(&dec, &buf[pos], flen, out, sizeof(out));
+            if (n < 0) {
+                ++bad;
+                ++pos;
+                continue;
+            }
+            fwrite(out, 1, (size_t)n, stdout);
+            pos += flen;
+        }
+    }
+    if (skipped > 0 || bad > 0) {
+        fprintf(stderr, "%lu bytes skipped, %lu frames dropped\n", (unsigned long)skipped, (unsigned long)bad);
+    }
+    return bad > 0;
+}
+
+int
+main(int argc, char* argv[]) {
+    if (argc == 2 && strcmp(argv[1], "-c") == 0) {
+        return prv_encode();
+    }
+    if (argc == 2 && strcmp(argv[1], "-d") == 0) {
+        return prv_decode();
+    }
+    fprintf(stderr, "Usage: %s -c|-d < input > output\n", argv[0]);
+    return 2;
+}
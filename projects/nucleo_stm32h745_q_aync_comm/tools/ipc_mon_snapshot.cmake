@@ -0,0 +1,21 @@
+#
+# Write memory images of synthetic target with TOOL, read them back as target memory and check printed state
+#
+execute_process(COMMAND ${TOOL} -s ${WORK}/snap_ RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Snapshot failed")
+endif()
+execute_process(COMMAND ${TOOL} -m ${WORK}/snap_shm.bin@0x38000000 -m ${WORK}/snap_flash.bin@0x08000000 -n 1
+                OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Monitor failed")
+endif()
+if(NOT out MATCHES "cpu1 build 0x11111111 cpu2 build 0x22222222 layout 0x12345678")
+    message(FATAL_ERROR "Header not decoded:\n${out}")
+endif()
+if(NOT out MATCHES " 0 CM4_TO_CM7 +1024 +512 +50 +5000 +4488")
+    message(FATAL_ERROR "Wrapped channel not decoded:\n${out}")
+endif()
+if(NOT out MATCHES " 2 CTRL_CM7_TO_CM4 +256 +0 +0" OR out MATCHES "\n 1 ")
+    message(FATAL_ERROR "Empty or missing channel not decoded:\n${out}")
+endif()
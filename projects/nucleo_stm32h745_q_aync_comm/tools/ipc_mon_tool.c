@@ -0,0 +1,402 @@
+/**
+ * \file            ipc_mon_tool.c
+ * \brief           Host monitor of IPC state over SWD memory reads
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include "ipc_mon.h"
+
+/*
+ * Poll introspection block of running target (IPC_MON enabled) and print channel state:
+ *
+ *   ipc_mon_tool                               OpenOCD Tcl server at localhost:6666, poll every second
+ *   ipc_mon_tool -o host:port -i 200 -n 10     Other server, 10 polls every 200 ms
+ *   ipc_mon_tool -m shm.bin@0x38000000 ...     Memory images instead of target, offline
+ *
+ * OpenOCD reads memory with background access of ST-LINK, through AHB access port,
+ * cores are not halted and no target code runs. Start it without reset and halt,
+ * for example `openocd -f board/st_nucleo_h745zi.cfg -c init`.
+ * Option -s prefix writes memory images of synthetic target, for tests
+ */
+
+/* Maximum number of memory images */
+#define IMG_MAX                             8
+
+/* Synthetic target, images of shared RAM and flash */
+#define SNAP_SHM_ADDR                       0x38000000
+#define SNAP_SHM_LEN                        0x00000400
+#define SNAP_FLASH_ADDR                     0x08000000
+#define SNAP_DIR_OFF                        0x00000040
+#define SNAP_SHARED_OFF                     0x00000200
+#define SNAP_SHARED_LEN                     0x00000080
+
+/**
+ * \brief           Memory image loaded from file
+ */
+typedef struct {
+    uint32_t addr;                              /*!< Target address of first byte */
+    uint8_t* data;                              /*!< Image data */
+    size_t len;                                 /*!< Image length */
+} img_t;
+
+static img_t imgs[IMG_MAX];
+static size_t img_count;
+static int tcl_fd = -1;
+
+/**
+ * \brief           Load memory image
+ * \param[in]       arg: Argument `file@address`
+ * \return          `0` on success
+ */
+static int
+prv_img_load(const char* arg) {
+    const char* at = strrchr(arg, '@');
+    char name[256];
+    FILE* f;
+    long len;
+
+    if (at == NULL || img_count == IMG_MAX || (size_t)(at - arg) >= sizeof(name)) {
+        return -1;
+    }
+    memcpy(name, arg, at - arg);
+    name[at - arg] = '\0';
+    if ((f = fopen(name, "rb")) == NULL) {
+        perror(name);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    imgs[img_count].addr = (uint32_t)strtoul(at + 1, NULL, 0);
+    imgs[img_count].data = malloc(len > 0 ? (size_t)len : 1);
+    imgs[img_count].len = fread(imgs[img_count].data, 1, (size_t)len, f);
+    fclose(f);
+    ++img_count;
+    return 0;
+}
+
+/**
+ * \brief           Connect to OpenOCD Tcl server
+ * \param[in]       arg: Argument `host:port`
+ * \return          `0` on success
+ */
+static int
+prv_tcl_connect(const char* arg) {
+    struct addrinfo hints = { 0 }, *res;
+    char host[256];
+    const char* colon = strrchr(arg, ':');
+
+    if (colon == NULL || (size_t)(colon - arg) >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, arg, colon - arg);
+    host[colon - arg] = '\0';
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, colon + 1, &hints, &res) != 0) {
+        return -1;
+    }
+    tcl_fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (tcl_fd < 0 || connect(tcl_fd, res->ai_addr, res->ai_addrlen) != 0) {
+        freeaddrinfo(res);
+        return -1;
+    }
+    freeaddrinfo(res);
+    return 0;
+}
+
+/**
+ * \brief           Read words with OpenOCD `read_memory` command, answer is list of hex words ended with `0x1A`
+ * \param[in]       addr: Target address, word aligned
+ * \param[out]      buf: Output bytes, little endian
+ * \param[in]       words: Number of words
+ * \return          `0` on success
+ */
+static int
+prv_tcl_read(uint32_t addr, uint8_t* buf, size_t words) {
+    static char ans[64 * 1024];
+    char cmd[64], *p, *end;
+    size_t len = 0;
+    ssize_t n;
+    uint32_t v;
+    int cmd_len;
+
+    cmd_len = snprintf(cmd, sizeof(cmd), "read_memory 0x%08X 32 %u\x1a", (unsigned)addr, (unsigned)words);
+    if (send(tcl_fd, cmd, cmd_len, 0) != cmd_len) {
+        return -1;
+    }
+    do {
+        if (len == sizeof(ans) - 1 || (n = recv(tcl_fd, &ans[len], sizeof(ans) - 1 - len, 0)) <= 0) {
+            return -1;
+        }
+        len += (size_t)n;
+    } while (ans[len - 1] != '\x1a');
+    ans[len - 1] = '\0';
+
+    p = ans;
+    for (size_t i = 0; i < words; ++i) {
+        v = (uint32_t)strtoul(p, &end, 16);
+        if (end == p) {
+            return -1;                          /* Error message instead of data */
+        }
+        p = end;
+        for (size_t k = 0; k < 4; ++k) {
+            buf[4 * i + k] = (uint8_t)(v >> (8 * k));
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Read target memory from images or OpenOCD
+ * \param[in]       addr: Target address, word aligned
+ * \param[out]      buf: Output bytes
+ * \param[in]       len: Number of bytes, multiple of word
+ * \return          `0` on success
+ */
+static int
+prv_read(uint32_t addr, void* buf, size_t len) {
+    if (tcl_fd >= 0) {
+        return prv_tcl_read(addr, buf, len / 4);
+    }
+    for (size_t i = 0; i < img_count; ++i) {
+        if (addr >= imgs[i].addr && addr - imgs[i].addr + len <= imgs[i].len) {
+            memcpy(buf, &imgs[i].data[addr - imgs[i].addr], len);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * \brief           Get word at offset of memory read from target
+ * \param[in]       mem: Memory
+ * \param[in]       off: Byte offset, \ref IPC_MON_NONE for disabled field
+ * \return          Word value, `0` for disabled field
+ */
+static uint32_t
+prv_word(const uint8_t* mem, uint32_t off) {
+    if (off == IPC_MON_NONE) {
+        return 0;
+    }
+    return mem[off] | (uint32_t)mem[off + 1] << 8 | (uint32_t)mem[off + 2] << 16 | (uint32_t)mem[off + 3] << 24;
+}
+
+/**
+ * \brief           Read introspection block once and print state of all channels
+ * \return          `0` on success
+ */
+static int
+prv_poll(void) {
+    static uint8_t dir[4096], shared[1024];
+    ipc_mon_hdr_t hdr;
+    ipc_mon_desc_t desc;
+    uint32_t hb[9], addr, len, w, r, full, cap;
+    size_t dir_len;
+
+    if (prv_read(IPC_MON_ADDR, &hdr, sizeof(hdr)) != 0 || hdr.magic != IPC_MON_MAGIC) {
+        fprintf(stderr, "No introspection header at 0x%08X\n", (unsigned)IPC_MON_ADDR);
+        return -1;
+    }
+    if (hdr.version != IPC_MON_VERSION || prv_read(hdr.desc_addr, &desc, sizeof(desc)) != 0
+        || desc.magic != IPC_MON_MAGIC || desc.version != IPC_MON_VERSION || desc.len != sizeof(desc)
+        || desc.chan_count > IPC_MON_CHAN_MAX || desc.shared_len > sizeof(shared)) {
+        fprintf(stderr, "Introspection version %u, tool supports %u\n", (unsigned)hdr.version, (unsigned)IPC_MON_VERSION);
+        return -1;
+    }
+    dir_len = desc.dir_entries_off + desc.chan_count * desc.dir_entry_len;
+    if (dir_len > sizeof(dir) || prv_read(desc.dir_addr, dir, (dir_len + 3) & ~3) != 0) {
+        return -1;
+    }
+
+    printf("cpu1 build 0x%08X cpu2 build 0x%08X layout 0x%08X\n",
+        (unsigned)hdr.build_id[IPC_MON_CPU1], (unsigned)hdr.build_id[IPC_MON_CPU2], (unsigned)hdr.layout_hash);
+    if (desc.hb_addr != 0 && prv_read(desc.hb_addr, hb, sizeof(hb)) == 0) {
+        printf("peer alive %u sent %u acked %u lost %u uptime %u ms rtt %u/%u/%u ns\n",
+            (unsigned)hb[0], (unsigned)hb[1], (unsigned)hb[2], (unsigned)hb[3], (unsigned)hb[5],
+            (unsigned)hb[6], (unsigned)hb[7], (unsigned)hb[8]);
+    }
+    printf("%2s %-23s %8s %8s %4s %10s %10s %8s %8s %6s %8s\n",
+        "id", "name", "len", "full", "%", "bytes_in", "bytes_out", "writes", "reads", "short", "max_full");
+    for (uint32_t id = 0; id < desc.chan_count; ++id) {
+        addr = prv_word(dir, desc.dir_entries_off + id * desc.dir_entry_len);
+        len = prv_word(dir, desc.dir_entries_off + id * desc.dir_entry_len + 8);
+        if (addr == 0 || len == 0) {
+            continue;                           /* Channel not created */
+        }
+        if (prv_read(addr, shared, (desc.shared_len + 3) & ~3) != 0) {
+            return -1;
+        }
+        w = prv_word(shared, desc.off_w);
+        r = prv_word(shared, desc.off_r);
+        if (desc.pow2) {
+            full = w - r;
+            cap = len;
+        } else {
+            full = w >= r ? w - r : len - (r - w);
+            cap = len - 1;
+        }
+        desc.names[id][IPC_MON_NAME_LEN - 1] = '\0';
+        printf("%2u %-23s %8u %8u %4u %10u %10u %8u %8u %6u %8u\n", (unsigned)id, desc.names[id],
+            (unsigned)len, (unsigned)full, (unsigned)((uint64_t)full * 100 / cap),
+            (unsigned)prv_word(shared, desc.off_bytes_in), (unsigned)prv_word(shared, desc.off_bytes_out),
+            (unsigned)prv_word(shared, desc.off_writes), (unsigned)prv_word(shared, desc.off_reads),
+            (unsigned)prv_word(shared, desc.off_short_writes), (unsigned)prv_word(shared, desc.off_max_full));
+    }
+    fflush(stdout);
+    return 0;
+}
+
+/**
+ * \brief           Put word to memory image, little endian
+ * \param[out]      mem: Memory
+ * \param[in]       off: Byte offset
+ * \param[in]       v: Word value
+ */
+static void
+prv_put(uint8_t* mem, uint32_t off, uint32_t v) {
+    for (size_t k = 0; k < 4; ++k) {
+        mem[off + k] = (uint8_t)(v >> (8 * k));
+    }
+}
+
+/**
+ * \brief           Write memory images of synthetic target with 2 channels,
+ *                  `prefix_shm.bin` at `0x38000000` and `prefix_flash.bin` at `0x08000000`
+ * \param[in]       prefix: File name prefix
+ * \return          `0` on success
+ */
+static int
+prv_snapshot(const char* prefix) {
+    static uint8_t shm[SNAP_SHM_LEN];
+    ipc_mon_desc_t desc = { 0 };
+    ipc_mon_hdr_t hdr = { 0 };
+    char name[256];
+    uint32_t e;
+    FILE* f;
+
+    desc.magic = IPC_MON_MAGIC;
+    desc.version = IPC_MON_VERSION;
+    desc.len = sizeof(desc);
+    desc.pow2 = 1;
+    desc.dir_addr = SNAP_SHM_ADDR + SNAP_DIR_OFF;
+    desc.dir_entries_off = 8;
+    desc.dir_entry_len = 16;
+    desc.chan_count = 3;                        /* Channel 1 is not created */
+    desc.shared_len = SNAP_SHARED_LEN;
+    desc.off_w = 0x00;
+    desc.off_bytes_in = 0x04;
+    desc.off_writes = 0x08;
+    desc.off_short_writes = 0x0C;
+    desc.off_max_full = 0x10;
+    desc.off_r = 0x40;
+    desc.off_bytes_out = 0x44;
+    desc.off_reads = 0x48;
+    strcpy(desc.names[0], "CM4_TO_CM7");
+    strcpy(desc.names[2], "CTRL_CM7_TO_CM4");
+
+    hdr.magic = IPC_MON_MAGIC;
+    hdr.version = IPC_MON_VERSION;
+    hdr.desc_addr = SNAP_FLASH_ADDR;
+    hdr.build_id[IPC_MON_CPU1] = 0x11111111;
+    hdr.build_id[IPC_MON_CPU2] = 0x22222222;
+    hdr.layout_hash = 0x12345678;
+    memcpy(&shm[IPC_MON_ADDR - SNAP_SHM_ADDR], &hdr, sizeof(hdr));
+
+    /* Channel 0 wrapped free-running pointers, channel 2 empty */
+    e = SNAP_DIR_OFF + desc.dir_entries_off;
+    prv_put(shm, e, SNAP_SHM_ADDR + SNAP_SHARED_OFF);
+    prv_put(shm, e + 8, 0x400);
+    prv_put(shm, SNAP_SHARED_OFF + desc.off_w, 0x00000100);
+    prv_put(shm, SNAP_SHARED_OFF + desc.off_r, 0xFFFFFF00);
+    prv_put(shm, SNAP_SHARED_OFF + desc.off_bytes_in, 5000);
+    prv_put(shm, SNAP_SHARED_OFF + desc.off_bytes_out, 4488);
+    e += 2 * desc.dir_entry_len;
+    prv_put(shm, e, SNAP_SHM_ADDR + SNAP_SHARED_OFF + SNAP_SHARED_LEN);
+    prv_put(shm, e + 8, 0x100);
+
+    snprintf(name, sizeof(name), "%sshm.bin", prefix);
+    if ((f = fopen(name, "wb")) == NULL) {
+        perror(name);
+        return 1;
+    }
+    fwrite(shm, 1, sizeof(shm), f);
+    fclose(f);
+    snprintf(name, sizeof(name), "%sflash.bin", prefix);
+    if ((f = fopen(name, "wb")) == NULL) {
+        perror(name);
+        return 1;
+    }
+    fwrite(&desc, 1, sizeof(desc), f);
+    fclose(f);
+    return 0;
+}
+
+int
+main(int argc, char* argv[]) {
+    const char* server = "localhost:6666";
+    long interval_ms = 1000, count = -1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:m:i:n:s:")) != -1) {
+        switch (opt) {
+            case 'o': server = optarg; break;
+            case 'm':
+                if (prv_img_load(optarg) != 0) {
+                    return 2;
+                }
+                break;
+            case 'i': interval_ms = strtol(optarg, NULL, 0); break;
+            case 'n': count = strtol(optarg, NULL, 0); break;
+            case 's': return prv_snapshot(optarg);
+            default:
+                fprintf(stderr, "Usage: %s [-o host:port | -m file@addr ...] [-i ms] [-n count] | -s prefix\n", argv[0]);
+                return 2;
+        }
+    }
+    if (img_count == 0 && prv_tcl_connect(server) != 0) {
+        fprintf(stderr, "Cannot connect to OpenOCD Tcl server %s\n", server);
+        return 1;
+    }
+    for (long i = 0; count < 0 || i < count; ++i) {
+        if (i > 0) {
+            usleep((useconds_t)interval_ms * 1000);
+            printf("\n");
+        }
+        if (prv_poll() != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}